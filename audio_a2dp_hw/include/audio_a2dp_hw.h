@@ -135,6 +135,7 @@ typedef enum {
   A2DP_CTRL_GET_SINK_LATENCY,
   A2DP_CTRL_UPDATE_SINK_LATENCY,
   A2DP_CTRL_NOTIFY_HAL_RESTART,
+  A2DP_CTRL_CMD_OPEN_PCM_RING,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
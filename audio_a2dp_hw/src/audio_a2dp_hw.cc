@@ -44,9 +44,11 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <mutex>
 
 #include <hardware/audio.h>
@@ -56,6 +58,7 @@
 #include "osi/include/hash_map_utils.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/shm_ring.h"
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
@@ -89,6 +92,10 @@ static char a2dp_hal_imp[PROPERTY_VALUE_MAX] = "false";
 // sockets
 #define WRITE_POLL_MS 20
 
+/* Deliver PCM through a shared memory ring instead of the data socket when
+ * the stack offers one */
+#define A2DP_PCM_RING_PROPERTY "persist.vendor.btstack.a2dp.pcm_ring"
+
 // default sink latency
 #define A2DP_DEFAULT_SINK_LATENCY 200
 
@@ -146,6 +153,9 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  bool use_pcm_ring;     // output stream asks the stack for a PCM ring
+  shm_ring_t* pcm_ring;  // stays mapped until the next start or close
+  bool pcm_ring_open;    // the ring is the data path of the current stream
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -399,6 +409,30 @@ static int skt_write(int fd, const void* p, size_t len) {
   return (int)count;
 }
 
+// Same as |skt_write| for the shared memory PCM ring: waits for the stack to
+// drain the ring for at most SOCK_SEND_TIMEOUT_MS.
+static int pcm_ring_write(shm_ring_t* ring, const void* p, size_t len) {
+  int ms_timeout = SOCK_SEND_TIMEOUT_MS;
+  size_t count = 0;
+
+  ts_log("pcm_ring_write", len, NULL);
+
+  while (count < len) {
+    size_t sent = shm_ring_write(ring, (const uint8_t*)p + count, len - count);
+    if (sent == 0) {
+      if (ms_timeout >= WRITE_POLL_MS) {
+        usleep(WRITE_POLL_MS * 1000);
+        ms_timeout -= WRITE_POLL_MS;
+        continue;
+      }
+      WARN("write timeout exceeded, sent %zu bytes", count);
+      return -1;
+    }
+    count += sent;
+  }
+  return (int)count;
+}
+
 static int skt_disconnect(int fd) {
   INFO("fd %d", fd);
 
@@ -496,11 +530,81 @@ static int a2dp_ctrl_send(struct a2dp_stream_common* common, const void* buffer,
   return length;
 }
 
-static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
-  char ack;
+// Receives the answer of the stack to A2DP_CTRL_CMD_OPEN_PCM_RING: the PCM
+// ring followed by the ack, or only an ack if the ring is not available.
+// On success, returns the mapped ring, otherwise NULL.
+static shm_ring_t* a2dp_ctrl_receive_pcm_ring(
+    struct a2dp_stream_common* common) {
+  uint8_t buf[sizeof(uint32_t)];
+  struct iovec iov;
+  iov.iov_base = buf;
+  iov.iov_len = sizeof(buf);
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * 2)];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
 
-  INFO("A2DP COMMAND %s", audio_a2dp_hw_dump_ctrl_event(cmd));
+  ssize_t ret;
+  OSI_NO_INTR(ret = recvmsg(common->ctrl_fd, &msg, MSG_CMSG_CLOEXEC));
+  if (ret <= 0) {
+    ERROR("receive PCM ring failed: ret=%d, error(%s)", (int)ret,
+          strerror(errno));
+    skt_disconnect(common->ctrl_fd);
+    common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
+    return NULL;
+  }
+
+  int fds[2] = {-1, -1};
+  size_t num_fds = 0;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS) {
+    num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * std::min<size_t>(num_fds, 2));
+  }
+  if (ret == 1 && num_fds == 0) {
+    INFO("PCM ring not available, ack %d", buf[0]);
+    return NULL;
+  }
+  if (ret != sizeof(buf) || num_fds != 2 || (msg.msg_flags & MSG_CTRUNC)) {
+    // Whatever follows can not be told apart from the ack any more
+    ERROR("invalid PCM ring message (%d bytes, %zu fds)", (int)ret, num_fds);
+    for (size_t i = 0; i < std::min<size_t>(num_fds, 2); i++) close(fds[i]);
+    skt_disconnect(common->ctrl_fd);
+    common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
+    return NULL;
+  }
 
+  shm_ring_t* ring = shm_ring_attach(fds[0], fds[1]);
+  if (ring == NULL) {
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  char ack;
+  if (a2dp_ctrl_receive(common, &ack, 1) < 0 || ack != A2DP_CTRL_ACK_SUCCESS) {
+    ERROR("PCM ring not acked");
+    shm_ring_free(ring);
+    return NULL;
+  }
+  if (ring == NULL) return NULL;
+  INFO("PCM ring of %zu bytes mapped", shm_ring_capacity(ring));
+  return ring;
+}
+
+// Sends |cmd| on the control channel of |common|, opening it first if needed.
+// On success, returns 0, otherwise -1.
+static int a2dp_command_send(struct a2dp_stream_common* common,
+                             tA2DP_CTRL_CMD cmd) {
   if (common->ctrl_fd == AUDIO_SKT_DISCONNECTED) {
     INFO("starting up or recovering from previous error");
     a2dp_open_ctrl_path(common);
@@ -510,7 +614,6 @@ static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
     }
   }
 
-  /* send command */
   ssize_t sent;
   OSI_NO_INTR(sent = send(common->ctrl_fd, &cmd, 1, MSG_NOSIGNAL));
   if (sent == -1) {
@@ -519,6 +622,16 @@ static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
     common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
     return -1;
   }
+  return 0;
+}
+
+static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
+  char ack;
+
+  INFO("A2DP COMMAND %s", audio_a2dp_hw_dump_ctrl_event(cmd));
+
+  /* send command */
+  if (a2dp_command_send(common, cmd) < 0) return -1;
 
   /* wait for ack byte */
   if (a2dp_ctrl_receive(common, &ack, 1) < 0) {
@@ -913,6 +1026,9 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->use_pcm_ring = false;
+  common->pcm_ring = NULL;
+  common->pcm_ring_open = false;
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -925,6 +1041,39 @@ static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
 
   delete common->mutex;
   common->mutex = NULL;
+
+  shm_ring_free(common->pcm_ring);
+  common->pcm_ring = NULL;
+}
+
+// Asks the stack for a shared memory PCM ring to use as the data path.
+// On success, returns true, otherwise the data socket is to be used.
+static bool a2dp_open_pcm_ring(struct a2dp_stream_common* common) {
+  // Any writer of the previous stream is done by now
+  shm_ring_free(common->pcm_ring);
+  common->pcm_ring = NULL;
+
+  INFO("A2DP COMMAND %s",
+       audio_a2dp_hw_dump_ctrl_event(A2DP_CTRL_CMD_OPEN_PCM_RING));
+  if (a2dp_command_send(common, A2DP_CTRL_CMD_OPEN_PCM_RING) < 0) return false;
+  common->pcm_ring = a2dp_ctrl_receive_pcm_ring(common);
+  if (common->pcm_ring == NULL) {
+    INFO("PCM ring not available, using data socket");
+    return false;
+  }
+  common->pcm_ring_open = true;
+  return true;
+}
+
+static void a2dp_close_data_path(struct a2dp_stream_common* common) {
+  skt_disconnect(common->audio_fd);
+  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+
+  // The ring stays mapped as an unlocked |out_write| may still be using it
+  if (common->pcm_ring_open) {
+    shm_ring_close_writer(common->pcm_ring);
+    common->pcm_ring_open = false;
+  }
 }
 
 static int start_audio_datapath(struct a2dp_stream_common* common) {
@@ -966,8 +1115,12 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
             command is pending, fake as success");
   }
 
-  /* connect socket if not yet connected */
-  if (common->audio_fd == AUDIO_SKT_DISCONNECTED) {
+  /* prefer the PCM ring, else connect socket if not yet connected */
+  if (common->use_pcm_ring && !common->pcm_ring_open &&
+      common->audio_fd == AUDIO_SKT_DISCONNECTED) {
+    a2dp_open_pcm_ring(common);
+  }
+  if (!common->pcm_ring_open && common->audio_fd == AUDIO_SKT_DISCONNECTED) {
     ERROR("Try opening data socket");
     common->audio_fd = skt_connect(A2DP_DATA_PATH, common->buffer_sz);
     if (common->audio_fd < 0) {
@@ -1017,8 +1170,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STOPPED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_close_data_path(common);
 
   return 0;
 }
@@ -1044,9 +1196,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
     common->state = AUDIO_A2DP_STATE_SUSPENDED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_close_data_path(common);
   return 0;
 }
 
@@ -1064,6 +1214,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   char trace_buf[512];
   #endif
   size_t write_bytes = bytes;
+  shm_ring_t* pcm_ring = NULL;
 
   DEBUG("write %zu bytes (fd %d)", bytes, out->common.audio_fd);
 
@@ -1106,6 +1257,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  pcm_ring = out->common.pcm_ring_open ? out->common.pcm_ring : NULL;
   lock.unlock();
   #ifdef BT_AUDIO_SYSTRACE_LOG
   snprintf(trace_buf, 32, "out_write:");
@@ -1114,7 +1266,10 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ATRACE_BEGIN(trace_buf);
   }
   #endif
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (pcm_ring != NULL)
+    sent = pcm_ring_write(pcm_ring, buffer, write_bytes);
+  else
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
   #ifdef BT_AUDIO_SYSTRACE_LOG
   if (PERF_SYSTRACE)
   {
@@ -1130,8 +1285,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ERROR("ignore data write failure");
     }
 
-    skt_disconnect(out->common.audio_fd);
-    out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    a2dp_close_data_path(&out->common);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
             (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -1782,6 +1936,7 @@ static int adev_open_output_stream(struct audio_hw_device* dev,
 
   /* initialize a2dp specifics */
   a2dp_stream_common_init(&out->common);
+  out->common.use_pcm_ring = property_get_bool(A2DP_PCM_RING_PROPERTY, false);
 
   // Make sure we always have the feeding parameters configured
   btav_a2dp_codec_config_t codec_config;
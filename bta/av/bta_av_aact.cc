@@ -740,13 +740,18 @@ void bta_av_sink_data_cback(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
     osi_free(p_pkt);
     return;
   }
-  if (!is_split_enabled()) {
-    p_pkt->event = BTA_AV_SINK_MEDIA_DATA_EVT;
-    p_scb->seps[p_scb->sep_idx].p_app_sink_data_cback(BTA_AV_SINK_MEDIA_DATA_EVT,
-                                                      (tBTA_AV_MEDIA*)p_pkt, p_scb->peer_addr);
+  if (is_split_enabled()) {
+    osi_free(p_pkt);
+    return;
+  }
+  p_pkt->event = BTA_AV_SINK_MEDIA_DATA_EVT;
+  if (p_pkt->offset >= BTA_AV_SINK_MEDIA_TS_LEN) {
+    memcpy((uint8_t*)(p_pkt + 1) + p_pkt->offset - BTA_AV_SINK_MEDIA_TS_LEN,
+           &time_stamp, BTA_AV_SINK_MEDIA_TS_LEN);
   }
-  /* Free the buffer: a copy of the packet has been delivered */
-  osi_free(p_pkt);
+  /* The application takes ownership of the packet */
+  p_scb->seps[p_scb->sep_idx].p_app_sink_data_cback(BTA_AV_SINK_MEDIA_DATA_EVT,
+                                                    (tBTA_AV_MEDIA*)p_pkt, p_scb->peer_addr);
 }
 
 /*******************************************************************************
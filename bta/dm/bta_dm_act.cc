@@ -3929,6 +3929,7 @@ void bta_dm_acl_change(tBTA_DM_MSG* p_data) {
       break;
     }
     if (bta_dm_cb.device_list.count) bta_dm_cb.device_list.count--;
+    bta_dm_pm_link_down(p_data->acl_change.handle);
     if ((p_data->acl_change.transport == BT_TRANSPORT_LE) &&
         (bta_dm_cb.device_list.le_count))
       bta_dm_cb.device_list.le_count--;
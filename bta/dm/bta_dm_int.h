@@ -995,6 +995,7 @@ extern void bta_dm_ci_rmt_oob_act(tBTA_DM_MSG* p_data);
 
 extern void bta_dm_init_pm(void);
 extern void bta_dm_disable_pm(void);
+extern void bta_dm_pm_link_down(uint16_t handle);
 
 extern uint8_t bta_dm_get_av_count(void);
 extern void bta_dm_search_start(tBTA_DM_MSG* p_data);
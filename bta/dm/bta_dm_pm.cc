@@ -23,6 +23,7 @@
  *
  ******************************************************************************/
 
+#include <base/bind.h>
 #include <base/logging.h>
 #include <string.h>
 
@@ -32,11 +33,15 @@
 #include "bta_api.h"
 #include "bta_dm_api.h"
 #include "bta_dm_int.h"
+#include "bta_dm_pm_policy.h"
 #include "bta_ag_int.h"
 #include "bta_sys.h"
 #include "btm_api.h"
+#include "l2c_api.h"
 
 #include "device/include/interop.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
 
 extern fixed_queue_t* btu_bta_alarm_queue;
 
@@ -58,6 +63,10 @@ static void bta_dm_pm_set_sniff_policy(tBTA_DM_PEER_DEVICE* p_dev,
                                        bool bDisable);
 static void bta_dm_pm_stop_timer_by_index(tBTA_PM_TIMER* p_timer,
                                           uint8_t timer_idx);
+static void bta_dm_pm_traffic_cback(uint16_t handle, uint16_t len);
+static PmTrafficPolicy::Params bta_dm_pm_adjust(tBTA_DM_PEER_DEVICE* p_dev,
+                                                uint8_t index,
+                                                period_ms_t timeout_ms);
 
 #if (BTM_SSR_INCLUDED == TRUE)
 #if (BTA_HH_INCLUDED == TRUE)
@@ -73,6 +82,15 @@ tBTA_DM_CONNECTED_SRVCS bta_dm_conn_srvcs;
 static std::recursive_mutex pm_timer_schedule_mutex;
 static std::recursive_mutex pm_timer_state_mutex;
 
+/* Narrows the table sniff parameters to the traffic on each BR/EDR link.
+ * Fed by L2CAP, which runs on the same thread as BTA. */
+static PmTrafficPolicy pm_traffic_policy;
+static bool pm_adaptive_enabled = false;
+
+static uint64_t bta_dm_pm_now_ms(void) {
+  return time_get_os_boottime_us() / 1000;
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_init_pm
@@ -92,6 +110,14 @@ void bta_dm_init_pm(void) {
 
     BTM_PmRegister((BTM_PM_REG_SET | BTM_PM_REG_NOTIF), &bta_dm_cb.pm_id,
                    bta_dm_pm_btm_cback);
+
+    char adaptive_pm_prop[PROPERTY_VALUE_MAX] = "true";
+    osi_property_get("persist.vendor.btstack.enable.adaptive_pm",
+                     adaptive_pm_prop, "true");
+    pm_adaptive_enabled = !strcmp(adaptive_pm_prop, "true");
+    pm_traffic_policy.Clear();
+    if (pm_adaptive_enabled)
+      L2CA_RegisterLinkTrafficCb(bta_dm_pm_traffic_cback);
   }
 
   /* Need to initialize all PM timer service IDs */
@@ -120,6 +146,10 @@ void bta_dm_disable_pm(void) {
    */
   bta_sys_pm_register((tBTA_SYS_CONN_CBACK*)NULL);
 
+  L2CA_RegisterLinkTrafficCb(NULL);
+  pm_adaptive_enabled = false;
+  pm_traffic_policy.Clear();
+
   /* Need to stop all active timers. */
   for (int i = 0; i < BTA_DM_NUM_PM_TIMER; i++) {
     for (int j = 0; j < BTA_DM_PM_MODE_TIMER_MAX; j++) {
@@ -288,8 +318,11 @@ static void bta_dm_pm_start_timer(tBTA_PM_TIMER* p_timer, uint8_t timer_idx,
   p_timer->srvc_id[timer_idx] = srvc_id;
   state_lock.unlock();
 
+  /* The callback gets the position of the timer, not the alarm */
+  uintptr_t position =
+      (p_timer - bta_dm_cb.pm_timer) * BTA_DM_PM_MODE_TIMER_MAX + timer_idx;
   alarm_set_on_mloop(p_timer->timer[timer_idx], timeout_ms,
-                     bta_dm_pm_timer_cback, p_timer->timer[timer_idx]);
+                     bta_dm_pm_timer_cback, (void*)position);
 }
 
 /*******************************************************************************
@@ -660,6 +693,20 @@ static void bta_dm_pm_set_mode(const RawAddress& peer_addr,
       }
     }
   }
+  if (pm_adaptive_enabled && (pm_action & BTA_DM_PM_SNIFF) &&
+      (timeout_ms > 0)) {
+    /* go to sniff once the link was idle as long as its traffic asks for,
+     * which may be sooner than the table, but not while packets still flow */
+    timeout_ms =
+        bta_dm_pm_adjust(p_peer_device, pm_action & 0x0F, timeout_ms)
+            .idle_timeout_ms;
+    if (pm_req == BTA_DM_PM_EXECUTE) {
+      timeout_ms = pm_traffic_policy.IdleRemainingMs(
+          p_peer_device->conn_handle, bta_dm_pm_now_ms(), timeout_ms);
+      if (timeout_ms > 0) pm_req = BTA_DM_PM_RESTART;
+    }
+  }
+
   /* if need to start a timer */
   if ((pm_req != BTA_DM_PM_EXECUTE) && (timeout_ms > 0)) {
     for (i = 0; i < BTA_DM_NUM_PM_TIMER; i++) {
@@ -798,6 +845,11 @@ static bool bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE* p_peer_dev, uint8_t index) {
     /* if the current mode is not sniff, issue the sniff command.
      * If sniff, but SSR is not used in this link, still issue the command */
     memcpy(&pwr_md, &p_bta_dm_pm_md[index], sizeof(tBTM_PM_PWR_MD));
+    if (pm_adaptive_enabled) {
+      PmTrafficPolicy::Params params = bta_dm_pm_adjust(p_peer_dev, index, 0);
+      pwr_md.max = params.sniff_max;
+      pwr_md.min = params.sniff_min;
+    }
     if (p_peer_dev->info & BTA_DM_DI_INT_SNIFF) {
       pwr_md.mode |= BTM_PM_MD_FORCE;
     }
@@ -906,8 +958,22 @@ static void bta_dm_pm_ssr(const RawAddress& peer_addr) {
       }
     }
 
+    uint16_t max_lat = p_spec->max_lat;
+    tBTA_DM_PEER_DEVICE* p_dev = bta_dm_find_peer_device(peer_addr);
+#if (BTA_HH_INCLUDED == TRUE)
+    /* HH keeps its per device preference */
+    if (ssr == BTA_DM_PM_SSR_HH) p_dev = NULL;
+#endif
+    if (pm_adaptive_enabled && p_dev) {
+      PmTrafficPolicy::Params table = {0, 0, 0, max_lat};
+      max_lat = pm_traffic_policy
+                    .Adjust(p_dev->conn_handle, bta_dm_pm_now_ms(),
+                            table)
+                    .ssr_max_lat;
+    }
+
     /* set the SSR parameters. */
-    BTM_SetSsrParams(peer_addr, p_spec->max_lat, p_spec->min_rmt_to,
+    BTM_SetSsrParams(peer_addr, max_lat, p_spec->min_rmt_to,
                      p_spec->min_loc_to);
   }
 }
@@ -968,31 +1034,24 @@ static void bta_dm_pm_btm_cback(const RawAddress& bd_addr,
  *
  ******************************************************************************/
 static void bta_dm_pm_timer_cback(void* data) {
-  uint8_t i, j;
-  alarm_t* alarm = (alarm_t*)data;
+  uintptr_t position = (uintptr_t)data;
+  uint8_t i = position / BTA_DM_PM_MODE_TIMER_MAX;
+  uint8_t j = position % BTA_DM_PM_MODE_TIMER_MAX;
 
-  std::unique_lock<std::recursive_mutex> state_lock(pm_timer_state_mutex);
-  for (i = 0; i < BTA_DM_NUM_PM_TIMER; i++) {
-    APPL_TRACE_DEBUG("dm_pm_timer[%d] in use? %d", i,
-                     bta_dm_cb.pm_timer[i].in_use);
-    if (bta_dm_cb.pm_timer[i].in_use) {
-      for (j = 0; j < BTA_DM_PM_MODE_TIMER_MAX; j++) {
-        if (bta_dm_cb.pm_timer[i].timer[j] == alarm) {
-          bta_dm_cb.pm_timer[i].active--;
-          bta_dm_cb.pm_timer[i].srvc_id[j] = BTA_ID_MAX;
-          APPL_TRACE_DEBUG("dm_pm_timer[%d] expires, timer_idx=%d", i, j);
-          break;
-        }
-      }
-      if (bta_dm_cb.pm_timer[i].active == 0)
-        bta_dm_cb.pm_timer[i].in_use = false;
-      if (j < BTA_DM_PM_MODE_TIMER_MAX) break;
-    }
-  }
-  state_lock.unlock();
+  if (i >= BTA_DM_NUM_PM_TIMER) return;
 
+  std::unique_lock<std::recursive_mutex> state_lock(pm_timer_state_mutex);
+  APPL_TRACE_DEBUG("dm_pm_timer[%d] in use? %d", i,
+                   bta_dm_cb.pm_timer[i].in_use);
   /* no more timers */
-  if (i == BTA_DM_NUM_PM_TIMER) return;
+  if (!bta_dm_cb.pm_timer[i].in_use) return;
+
+  bta_dm_cb.pm_timer[i].active--;
+  bta_dm_cb.pm_timer[i].srvc_id[j] = BTA_ID_MAX;
+  APPL_TRACE_DEBUG("dm_pm_timer[%d] expires, timer_idx=%d", i, j);
+  if (bta_dm_cb.pm_timer[i].active == 0)
+    bta_dm_cb.pm_timer[i].in_use = false;
+  state_lock.unlock();
 
   tBTA_DM_PM_TIMER* p_buf =
       (tBTA_DM_PM_TIMER*)osi_malloc(sizeof(tBTA_DM_PM_TIMER));
@@ -1024,6 +1083,7 @@ void bta_dm_pm_btm_status(tBTA_DM_MSG* p_data) {
   /* check new mode */
   switch (p_data->pm_status.status) {
     case BTM_PM_STS_ACTIVE:
+      pm_traffic_policy.OnModeChange(p_dev->conn_handle, 0);
       /* if our sniff or park attempt failed
       we should not try it again*/
       if (p_data->pm_status.hci_status != 0) {
@@ -1075,6 +1135,8 @@ void bta_dm_pm_btm_status(tBTA_DM_MSG* p_data) {
 #endif
     case BTM_PM_STS_SNIFF:
       if (p_data->pm_status.hci_status == 0) {
+        pm_traffic_policy.OnModeChange(p_dev->conn_handle,
+                                       p_data->pm_status.value);
         /* Stop PM timer now if already active for
          * particular device since link is already
          * put in sniff mode by remote device, and
@@ -1288,6 +1350,92 @@ static void bta_dm_pm_set_sniff_policy(tBTA_DM_PEER_DEVICE* p_dev,
   BTM_SetLinkPolicy(p_dev->peer_bdaddr, &policy_setting);
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_adjust
+ *
+ * Description      Narrows the idle timeout and the sniff parameters of sniff
+ *                  table entry index to the traffic on the link
+ *
+ * Returns          the adjusted parameters
+ *
+ ******************************************************************************/
+static PmTrafficPolicy::Params bta_dm_pm_adjust(tBTA_DM_PEER_DEVICE* p_dev,
+                                                uint8_t index,
+                                                period_ms_t timeout_ms) {
+  PmTrafficPolicy::Params table = {(uint32_t)timeout_ms,
+                                   p_bta_dm_pm_md[index].max,
+                                   p_bta_dm_pm_md[index].min, 0};
+  PmTrafficPolicy::Params params = pm_traffic_policy.Adjust(
+      p_dev->conn_handle, bta_dm_pm_now_ms(), table);
+
+  if (params.sniff_max != table.sniff_max ||
+      params.idle_timeout_ms != table.idle_timeout_ms) {
+    APPL_TRACE_DEBUG("%s handle:0x%x idle:%d->%d ms, sniff max:%d->%d",
+                     __func__, p_dev->conn_handle, table.idle_timeout_ms,
+                     params.idle_timeout_ms, table.sniff_max,
+                     params.sniff_max);
+  }
+  return params;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_wake
+ *
+ * Description      Brings the link back to active mode for a burst of traffic
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_pm_wake(uint16_t handle) {
+  for (int i = 0; i < bta_dm_cb.device_list.count; i++) {
+    tBTA_DM_PEER_DEVICE* p_dev = &bta_dm_cb.device_list.peer_device[i];
+    if (p_dev->conn_handle != handle ||
+        p_dev->transport != BT_TRANSPORT_BR_EDR)
+      continue;
+
+    tBTM_PM_MODE mode = BTM_PM_STS_ACTIVE;
+    BTM_ReadPowerMode(p_dev->peer_bdaddr, &mode);
+    if (mode == BTM_PM_MD_SNIFF) {
+      APPL_TRACE_DEBUG("%s handle:0x%x", __func__, handle);
+      bta_dm_pm_active(p_dev->peer_bdaddr);
+    }
+    return;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_traffic_cback
+ *
+ * Description      L2CAP callback for the ACL packets sent and received on
+ *                  BR/EDR links
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_pm_traffic_cback(uint16_t handle, uint16_t len) {
+  if (!pm_traffic_policy.OnTraffic(handle, bta_dm_pm_now_ms(), len))
+    return;
+
+  /* not from inside L2CAP, which may be sending */
+  do_in_bta_thread(FROM_HERE, base::Bind(&bta_dm_pm_wake, handle));
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_link_down
+ *
+ * Description      Forgets the traffic of a link that went down
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_dm_pm_link_down(uint16_t handle) {
+  pm_traffic_policy.OnLinkDown(handle);
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_pm_obtain_controller_state
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "bta_dm_pm_policy.h"
+
+#include <algorithm>
+
+namespace {
+
+// Busy share above which a link streams, out of 256.
+constexpr uint32_t kStreamingBusy = 160;
+// Average packets per burst, times 256, from which a link is interactive.
+constexpr uint32_t kInteractiveBurstSize = 2 * 256;
+// Bursts longer than this count as this long.
+constexpr uint32_t kMaxBurstPackets = 64;
+// After this many empty windows the averages are as good as 0.
+constexpr uint64_t kMaxEmptyWindows = 32;
+
+// Moves |average| by 1/8 of the way to |sample|.
+void Ewma(uint32_t& average, uint32_t sample) {
+  average = (uint32_t)(((uint64_t)average * 7 + sample) / 8);
+}
+
+}  // namespace
+
+bool PmTrafficPolicy::OnTraffic(uint16_t handle, uint64_t now_ms,
+                                uint16_t bytes) {
+  Link& link = links_[handle];
+  if (!link.seen) {
+    link.seen = true;
+    link.window_start_ms = now_ms;
+    link.burst_packets = 1;
+  } else {
+    Advance(link, now_ms);
+    uint64_t gap = now_ms - std::min(now_ms, link.last_packet_ms);
+    if (gap > kBurstGapMs) {
+      if (link.burst_size == 0)
+        link.burst_size = link.burst_packets * 256;
+      else
+        Ewma(link.burst_size, link.burst_packets * 256);
+      link.burst_packets = 1;
+    } else {
+      link.burst_packets = std::min(link.burst_packets + 1, kMaxBurstPackets);
+      Ewma(link.gap_ms, (uint32_t)gap);
+    }
+  }
+  link.window_bytes += bytes;
+  link.last_packet_ms = now_ms;
+
+  if (link.sniff_interval <= kWakeMinInterval ||
+      link.traffic == Traffic::kIdle)
+    return false;
+  if (link.last_wake_ms != 0 && now_ms - link.last_wake_ms < kWakeHoldoffMs)
+    return false;
+  link.last_wake_ms = now_ms;
+  return true;
+}
+
+void PmTrafficPolicy::OnModeChange(uint16_t handle, uint16_t interval) {
+  links_[handle].sniff_interval = interval;
+}
+
+PmTrafficPolicy::Params PmTrafficPolicy::Adjust(uint16_t handle,
+                                                uint64_t now_ms,
+                                                const Params& table) {
+  auto it = links_.find(handle);
+  if (it == links_.end() || !it->second.seen) return table;
+  Link& link = it->second;
+  Advance(link, now_ms);
+
+  Params params = table;
+  switch (link.traffic) {
+    case Traffic::kIdle:
+      params.idle_timeout_ms = std::min(
+          table.idle_timeout_ms,
+          std::max(kMinIdleTimeoutMs, table.idle_timeout_ms / 4));
+      break;
+    case Traffic::kInteractive:
+      params.idle_timeout_ms =
+          std::min(table.idle_timeout_ms,
+                   std::max(kMinIdleTimeoutMs, 4 * link.gap_ms));
+      params.sniff_max = std::min(table.sniff_max, kInteractiveSniffMax);
+      params.sniff_min = std::min(table.sniff_min, params.sniff_max);
+      params.ssr_max_lat = std::min(table.ssr_max_lat, kInteractiveSsrMaxLat);
+      break;
+    case Traffic::kStreaming:
+      break;
+  }
+  return params;
+}
+
+uint32_t PmTrafficPolicy::IdleRemainingMs(uint16_t handle, uint64_t now_ms,
+                                          uint32_t idle_timeout_ms) const {
+  auto it = links_.find(handle);
+  if (it == links_.end() || !it->second.seen) return 0;
+  uint64_t idle = now_ms - std::min(now_ms, it->second.last_packet_ms);
+  if (idle >= idle_timeout_ms) return 0;
+  return idle_timeout_ms - (uint32_t)idle;
+}
+
+PmTrafficPolicy::Traffic PmTrafficPolicy::Class(uint16_t handle) const {
+  auto it = links_.find(handle);
+  return it == links_.end() ? Traffic::kIdle : it->second.traffic;
+}
+
+uint32_t PmTrafficPolicy::Throughput(uint16_t handle) const {
+  auto it = links_.find(handle);
+  return it == links_.end() ? 0 : it->second.rate;
+}
+
+void PmTrafficPolicy::Advance(Link& link, uint64_t now_ms) {
+  if (now_ms < link.window_start_ms + kWindowMs) return;
+  uint64_t windows = (now_ms - link.window_start_ms) / kWindowMs;
+
+  Ewma(link.rate, link.window_bytes * 1000 / kWindowMs);
+  Ewma(link.busy, link.window_bytes ? 256 : 0);
+  for (uint64_t i = 1; i < std::min(windows, kMaxEmptyWindows); i++) {
+    Ewma(link.rate, 0);
+    Ewma(link.busy, 0);
+  }
+  if (windows >= kMaxEmptyWindows) link.rate = link.busy = 0;
+
+  link.window_start_ms += windows * kWindowMs;
+  link.window_bytes = 0;
+  Classify(link, (uint32_t)std::min(windows, kMaxEmptyWindows));
+}
+
+void PmTrafficPolicy::Classify(Link& link, uint32_t windows) {
+  Traffic candidate = Traffic::kIdle;
+  if (link.busy >= kStreamingBusy)
+    candidate = Traffic::kStreaming;
+  else if (link.burst_size >= kInteractiveBurstSize)
+    candidate = Traffic::kInteractive;
+
+  if (candidate == link.traffic) {
+    link.candidate_windows = 0;
+    return;
+  }
+  if (candidate != link.candidate) {
+    link.candidate = candidate;
+    link.candidate_windows = 0;
+  }
+  link.candidate_windows += windows;
+  if (link.candidate_windows >= kHysteresisWindows) {
+    link.traffic = candidate;
+    link.candidate_windows = 0;
+  }
+}
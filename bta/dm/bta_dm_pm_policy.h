@@ -0,0 +1,105 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <unordered_map>
+
+// Traffic-aware tuning of the sniff and sniff subrating parameters that the
+// power manager takes from its tables.
+//
+// L2CAP reports every BR/EDR ACL packet with OnTraffic(). Per link this keeps
+// the throughput, the share of busy 250 ms windows, the gap between packets
+// of a burst and the number of packets per burst, and classifies the link as
+// idle (lone packets, e.g. keep-alives), interactive (short bursts, e.g. a
+// request and its response) or streaming (busy most of the time). A new
+// class is only taken after it was seen for kHysteresisWindows windows in a
+// row, so a link changes class at most once per 750 ms.
+//
+// Adjust() then narrows the table values: an idle link goes to sniff sooner,
+// an interactive one goes to sniff as soon as its burst is over but with a
+// short sniff interval and subrating latency, and OnTraffic() asks for the
+// link to be brought back to active when a burst starts while it sniffs. A
+// streaming link keeps the table values. The result never exceeds the
+// table's idle timeout, sniff interval or subrating latency.
+//
+// All operations are O(1) per link. Not thread safe.
+class PmTrafficPolicy {
+ public:
+  enum class Traffic { kIdle, kInteractive, kStreaming };
+
+  // Idle time before sniff, sniff interval bounds and maximum subrating
+  // latency, as in tBTA_DM_PM_ACTN, tBTM_PM_PWR_MD and tBTA_DM_SSR_SPEC.
+  struct Params {
+    uint32_t idle_timeout_ms;
+    uint16_t sniff_max;  // slots
+    uint16_t sniff_min;  // slots
+    uint16_t ssr_max_lat;  // slots
+  };
+
+  static constexpr uint32_t kWindowMs = 250;
+  static constexpr uint32_t kHysteresisWindows = 3;
+  // Packets further apart than this belong to different bursts.
+  static constexpr uint32_t kBurstGapMs = 200;
+  static constexpr uint32_t kMinIdleTimeoutMs = 500;
+  // Longest sniff interval and subrating latency of an interactive link.
+  static constexpr uint16_t kInteractiveSniffMax = 80;
+  static constexpr uint16_t kInteractiveSsrMaxLat = 160;
+  // Sniff intervals up to this are short enough to not wake the link.
+  static constexpr uint16_t kWakeMinInterval = 48;
+  static constexpr uint32_t kWakeHoldoffMs = 1000;
+
+  // Records a packet of |bytes| on the link |handle| at |now_ms|. Returns
+  // true if the link should be brought back to active mode.
+  bool OnTraffic(uint16_t handle, uint64_t now_ms, uint16_t bytes);
+
+  // The link entered sniff mode with |interval| slots, or active mode if 0.
+  void OnModeChange(uint16_t handle, uint16_t interval);
+
+  void OnLinkDown(uint16_t handle) { links_.erase(handle); }
+  void Clear() { links_.clear(); }
+
+  // Returns the |table| parameters narrowed for the traffic on |handle|.
+  Params Adjust(uint16_t handle, uint64_t now_ms, const Params& table);
+
+  // Returns how much longer |handle| has to stay quiet before it has been
+  // idle for |idle_timeout_ms|, 0 if it already has.
+  uint32_t IdleRemainingMs(uint16_t handle, uint64_t now_ms,
+                           uint32_t idle_timeout_ms) const;
+
+  Traffic Class(uint16_t handle) const;
+  // Average throughput in bytes per second, 0 for an unknown link.
+  uint32_t Throughput(uint16_t handle) const;
+
+ private:
+  struct Link {
+    uint64_t window_start_ms = 0;
+    uint32_t window_bytes = 0;
+    uint64_t last_packet_ms = 0;
+    uint64_t last_wake_ms = 0;
+    bool seen = false;
+    uint16_t sniff_interval = 0;
+    uint32_t burst_packets = 0;
+
+    // Averages, in 1/256 units for the fractions.
+    uint32_t rate = 0;        // bytes per second
+    uint32_t busy = 0;        // share of windows with traffic, out of 256
+    uint32_t gap_ms = 0;      // gap between packets of a burst
+    uint32_t burst_size = 0;  // packets per burst, times 256
+
+    Traffic traffic = Traffic::kIdle;
+    Traffic candidate = Traffic::kIdle;
+    uint32_t candidate_windows = 0;
+  };
+
+  // Closes the windows that ended before |now_ms|.
+  void Advance(Link& link, uint64_t now_ms);
+  void Classify(Link& link, uint32_t windows);
+
+  std::unordered_map<uint16_t, Link> links_;
+};
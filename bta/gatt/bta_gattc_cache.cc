@@ -132,16 +132,6 @@ void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb) {
   p_srvc_cb->pending_discovery.Clear();
 }
 
-const Service* bta_gattc_find_matching_service(
-    const std::vector<Service>& services, uint16_t handle) {
-  for (const Service& service : services) {
-    if (handle >= service.handle && handle <= service.end_handle)
-      return &service;
-  }
-
-  return nullptr;
-}
-
 /// Whether the peer device uses robust caching
 RobustCachingSupport GetRobustCachingSupport(const tBTA_GATTC_CLCB* p_clcb,
                                              const gatt::Database& db) {
@@ -243,7 +233,12 @@ static void bta_gattc_explore_next_service(uint16_t conn_id,
     return;
   }
 
-  if (p_srvc_cb->pending_discovery.StartNextServiceExploration()) {
+  // In batches, every service found so far is explored at once
+  DatabaseBuilder& builder = p_srvc_cb->pending_discovery;
+  bool started = bta_gattc_is_pipelined_discovery_enabled()
+                     ? builder.StartBatchExploration()
+                     : builder.StartNextServiceExploration();
+  if (started) {
     const auto& service =
         p_srvc_cb->pending_discovery.CurrentlyExploredService();
     VLOG(1) << "Start service discovery";
@@ -348,8 +343,15 @@ void bta_gattc_start_disc_char_dscp(uint16_t conn_id,
                                     tBTA_GATTC_SERV* p_srvc_cb) {
   VLOG(1) << "starting discover characteristics descriptor";
 
-  std::pair<uint16_t, uint16_t> range =
-      p_srvc_cb->pending_discovery.NextDescriptorRangeToExplore();
+  std::pair<uint16_t, uint16_t> range;
+  if (p_srvc_cb->pending_discovery.InBatchExploration()) {
+    /* merge ranges that one Find Information Response of 16-bit UUIDs holds */
+    uint16_t mtu = std::max(p_srvc_cb->mtu, (uint16_t)GATT_DEF_BLE_MTU_SIZE);
+    range = p_srvc_cb->pending_discovery.NextDescriptorRangeToExplore(
+        (mtu - 2) / 4);
+  } else {
+    range = p_srvc_cb->pending_discovery.NextDescriptorRangeToExplore();
+  }
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
   if (range == DatabaseBuilder::EXPLORE_END)
 #else
@@ -579,6 +581,22 @@ void bta_gattc_disc_cmpl_cback(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
       bta_gattc_explore_next_service(conn_id, p_srvc_cb);
       break;
     case GATT_DISC_INC_SRVC: {
+      if (p_srvc_cb->pending_discovery.InBatchExploration()) {
+        /* services revealed by included services join the batch */
+        std::pair<uint16_t, uint16_t> range =
+            p_srvc_cb->pending_discovery.NextIncludedServiceRangeToExplore();
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+        if (range != DatabaseBuilder::EXPLORE_END)
+#else
+        if (range != EXPLORE_END)
+#endif
+        {
+          GATTC_Discover(conn_id, GATT_DISC_INC_SRVC, range.first,
+                         range.second);
+          break;
+        }
+      }
+
       auto& service = p_srvc_cb->pending_discovery.CurrentlyExploredService();
       /* start discovering characteristic */
       GATTC_Discover(conn_id, GATT_DISC_CHAR, service.first, service.second);
@@ -640,31 +658,25 @@ const std::vector<Service>* bta_gattc_get_services(uint16_t conn_id) {
 
 const Service* bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV* p_srcb,
                                                      uint16_t handle) {
-  const std::vector<Service>* services = bta_gattc_get_services_srcb(p_srcb);
-  if (services == NULL) return NULL;
-  return bta_gattc_find_matching_service(*services, handle);
+  if (!p_srcb) return NULL;
+
+  return p_srcb->gatt_database.FindService(handle);
 }
 
 const Service* bta_gattc_get_service_for_handle(uint16_t conn_id,
                                                 uint16_t handle) {
-  const std::vector<Service>* services = bta_gattc_get_services(conn_id);
-  if (services == NULL) return NULL;
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
 
-  return bta_gattc_find_matching_service(*services, handle);
+  if (p_clcb == NULL) return NULL;
+
+  return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV* p_srcb,
                                                         uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
+  if (!p_srcb) return NULL;
 
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    if (handle == charac.value_handle) return &charac;
-  }
-
-  return NULL;
+  return p_srcb->gatt_database.FindCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
@@ -679,20 +691,9 @@ const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
 
 const Descriptor* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV* p_srcb,
                                                 uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) {
-    return NULL;
-  }
+  if (!p_srcb) return NULL;
 
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &desc;
-    }
-  }
-
-  return NULL;
+  return p_srcb->gatt_database.FindDescriptor(handle);
 }
 
 const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
@@ -706,18 +707,9 @@ const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
 
 const Characteristic* bta_gattc_get_owning_characteristic_srcb(
     tBTA_GATTC_SERV* p_srcb, uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &charac;
-    }
-  }
+  if (!p_srcb) return NULL;
 
-  return NULL;
+  return p_srcb->gatt_database.FindOwningCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_owning_characteristic(uint16_t conn_id,
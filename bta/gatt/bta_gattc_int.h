@@ -468,6 +468,7 @@ extern void bta_gattc_clear_notif_registration(tBTA_GATTC_SERV* p_srcb,
 extern void bta_gattc_clear_notif_reg_on_disc(tBTA_GATTC_RCB *p_clreg, RawAddress bda);
 extern tBTA_GATTC_SERV* bta_gattc_find_srvr_cache(const RawAddress& bda);
 extern bool bta_gattc_is_robust_caching_enabled();
+extern bool bta_gattc_is_pipelined_discovery_enabled();
 
 /* discovery functions */
 extern void bta_gattc_disc_res_cback(uint16_t conn_id,
@@ -890,3 +890,27 @@ bool bta_gattc_is_robust_caching_enabled() {
   VLOG(1) << __func__ << " is_gatt_robust_caching_enabled:" << +is_gatt_robust_caching_enabled;
   return is_gatt_robust_caching_enabled;
 }
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_is_pipelined_discovery_enabled
+ *
+ * Description      check if services are explored in batches, rather than
+ *                  one by one
+ *
+ * Returns          true if enabled; otherwise false
+ *
+ ******************************************************************************/
+bool bta_gattc_is_pipelined_discovery_enabled() {
+  char pipelined_discovery_prop[PROPERTY_VALUE_MAX] = "false";
+  bool is_pipelined_discovery_enabled = false;
+  if (property_get("persist.vendor.btstack.enable.gatt_pipelined_discovery",
+      pipelined_discovery_prop, "true")
+      && !strcmp(pipelined_discovery_prop, "true")) {
+    is_pipelined_discovery_enabled = true;
+  }
+
+  VLOG(1) << __func__ << " is_pipelined_discovery_enabled:"
+          << +is_pipelined_discovery_enabled;
+  return is_pipelined_discovery_enabled;
+}
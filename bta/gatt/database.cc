@@ -56,6 +56,159 @@ Service* FindService(std::vector<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+const Database::IndexEntry* Database::FindIndexEntry(uint16_t handle) const {
+  if (index_pages.empty()) return nullptr;
+
+  uint16_t page = index_pages[handle / kIndexPageSize];
+  if (page == kNoIndex) return nullptr;
+
+  return &index_entries[page * kIndexPageSize + handle % kIndexPageSize];
+}
+
+void Database::BuildIndex() {
+  std::vector<uint16_t>().swap(index_pages);
+  std::vector<IndexEntry>().swap(index_entries);
+
+  // Positions must fit an entry; a database that large is left to the walks
+  if (services.size() >= kNoIndex) return;
+
+  // Services are sorted and disjoint as the builder keeps them, unless
+  // restored from a damaged cache. Only then may the service an attribute is
+  // declared in differ from the one found by walking.
+  bool disjoint = true;
+  for (size_t i = 0; i < services.size(); i++) {
+    const Service& service = services[i];
+    if (service.handle > service.end_handle ||
+        (i > 0 && service.handle <= services[i - 1].end_handle))
+      disjoint = false;
+
+    if (service.characteristics.size() >= kNoIndex) return;
+    for (const Characteristic& charac : service.characteristics) {
+      if (charac.descriptors.size() >= kNoIndex) return;
+    }
+  }
+
+  auto walk = [this](uint16_t handle) -> uint16_t {
+    for (size_t i = 0; i < services.size(); i++) {
+      if (HandleInRange(services[i], handle)) return i;
+    }
+    return kNoIndex;
+  };
+
+  index_pages.assign(HANDLE_MAX / kIndexPageSize + 1, kNoIndex);
+  auto entry_for = [&](uint16_t handle, size_t service) -> IndexEntry& {
+    uint16_t& page = index_pages[handle / kIndexPageSize];
+    if (page == kNoIndex) {
+      page = index_entries.size() / kIndexPageSize;
+      index_entries.resize(index_entries.size() + kIndexPageSize);
+    }
+
+    IndexEntry& entry =
+        index_entries[page * kIndexPageSize + handle % kIndexPageSize];
+    if (entry.service == kNoIndex) {
+      entry.service =
+          (disjoint && HandleInRange(services[service], handle)) ? service
+                                                                 : walk(handle);
+    }
+    return entry;
+  };
+
+  // Visit attributes in the order the walks do, so the first match wins
+  for (size_t i = 0; i < services.size(); i++) {
+    const Service& service = services[i];
+    entry_for(service.handle, i);
+
+    for (const IncludedService& is : service.included_services) {
+      entry_for(is.handle, i);
+    }
+
+    for (size_t j = 0; j < service.characteristics.size(); j++) {
+      const Characteristic& charac = service.characteristics[j];
+      entry_for(charac.declaration_handle, i);
+
+      IndexEntry& value = entry_for(charac.value_handle, i);
+      if (value.service == i && value.characteristic == kNoIndex)
+        value.characteristic = j;
+
+      for (size_t k = 0; k < charac.descriptors.size(); k++) {
+        IndexEntry& desc = entry_for(charac.descriptors[k].handle, i);
+        if (desc.service == i && desc.descriptor == kNoIndex) {
+          desc.owner = j;
+          desc.descriptor = k;
+        }
+      }
+    }
+  }
+}
+
+const Service* Database::FindService(uint16_t handle) const {
+  const IndexEntry* entry = FindIndexEntry(handle);
+  if (entry && entry->service != kNoIndex) return &services[entry->service];
+
+  // Handles that are no attribute's, or the database is not indexed
+  for (const Service& service : services) {
+    if (HandleInRange(service, handle)) return &service;
+  }
+
+  return nullptr;
+}
+
+const Characteristic* Database::FindCharacteristic(uint16_t handle) const {
+  if (!index_pages.empty()) {
+    const IndexEntry* entry = FindIndexEntry(handle);
+    if (!entry || entry->characteristic == kNoIndex) return nullptr;
+    return &services[entry->service].characteristics[entry->characteristic];
+  }
+
+  const Service* service = FindService(handle);
+  if (!service) return nullptr;
+
+  for (const Characteristic& charac : service->characteristics) {
+    if (handle == charac.value_handle) return &charac;
+  }
+
+  return nullptr;
+}
+
+const Descriptor* Database::FindDescriptor(uint16_t handle) const {
+  if (!index_pages.empty()) {
+    const IndexEntry* entry = FindIndexEntry(handle);
+    if (!entry || entry->descriptor == kNoIndex) return nullptr;
+    return &services[entry->service]
+                .characteristics[entry->owner]
+                .descriptors[entry->descriptor];
+  }
+
+  const Characteristic* charac = FindOwningCharacteristic(handle);
+  if (!charac) return nullptr;
+
+  for (const Descriptor& desc : charac->descriptors) {
+    if (handle == desc.handle) return &desc;
+  }
+
+  return nullptr;
+}
+
+const Characteristic* Database::FindOwningCharacteristic(
+    uint16_t handle) const {
+  if (!index_pages.empty()) {
+    const IndexEntry* entry = FindIndexEntry(handle);
+    if (!entry || entry->descriptor == kNoIndex) return nullptr;
+    return &services[entry->service].characteristics[entry->owner];
+  }
+
+  const Service* service = FindService(handle);
+  if (!service) return nullptr;
+
+  for (const Characteristic& charac : service->characteristics) {
+    for (const Descriptor& desc : charac.descriptors) {
+      if (handle == desc.handle) return &charac;
+    }
+  }
+
+  return nullptr;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -168,8 +321,8 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
     }
 
     if (attr.type == INCLUDE) {
-      Service* included_service =
-          FindService(result.services, attr.value.included_service.handle);
+      Service* included_service = gatt::FindService(
+          result.services, attr.value.included_service.handle);
       if (!included_service) {
         LOG(ERROR) << __func__ << ": Non-existing included service!";
         *success = false;
@@ -202,6 +355,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
       }
     }
   }
+  result.BuildIndex();
   *success = true;
   return result;
 }
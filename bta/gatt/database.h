@@ -106,7 +106,11 @@ class Database {
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::vector<Service>().swap(services); }
+  void Clear() {
+    std::vector<Service>().swap(services);
+    std::vector<uint16_t>().swap(index_pages);
+    std::vector<IndexEntry>().swap(index_entries);
+  }
 
   /* Return list of services available in this database */
   const std::vector<Service>& Services() const { return services; }
@@ -121,10 +125,46 @@ class Database {
   /* Return 128 bit unique identifier of this GATT database */
   Octet16 Hash() const;
 
+  /* Return the service whose handle range contains |handle|, or nullptr */
+  const Service* FindService(uint16_t handle) const;
+
+  /* Return the characteristic whose value handle is |handle|, or nullptr */
+  const Characteristic* FindCharacteristic(uint16_t handle) const;
+
+  /* Return the descriptor with |handle|, or nullptr */
+  const Descriptor* FindDescriptor(uint16_t handle) const;
+
+  /* Return the characteristic owning descriptor with |handle|, or nullptr */
+  const Characteristic* FindOwningCharacteristic(uint16_t handle) const;
+
   friend class DatabaseBuilder;
 
  private:
+  static constexpr uint16_t kNoIndex = 0xffff;
+  static constexpr size_t kIndexPageSize = 256;
+
+  /* Position in |services| of what an attribute handle refers to. Each
+   * lookup walks the services in order and returns the first match; the
+   * entry caches that walk's result, kNoIndex where it finds nothing. */
+  struct IndexEntry {
+    uint16_t service = kNoIndex;
+    uint16_t characteristic = kNoIndex; /* value handle of */
+    uint16_t owner = kNoIndex;          /* characteristic of descriptor */
+    uint16_t descriptor = kNoIndex;
+  };
+
+  /* Index every attribute handle, once the database is complete. Lookups in
+   * a database that was not indexed walk the services instead. */
+  void BuildIndex();
+  const IndexEntry* FindIndexEntry(uint16_t handle) const;
+
   std::vector<Service> services;
+
+  /* Handle index in pages of kIndexPageSize handles, so that only the handle
+   * ranges in use take memory. |index_pages| maps the upper byte of a handle
+   * to a page in |index_entries|, or kNoIndex; it is empty until indexed. */
+  std::vector<uint16_t> index_pages;
+  std::vector<IndexEntry> index_entries;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
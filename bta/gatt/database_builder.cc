@@ -101,6 +101,16 @@ void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
    * before, it must be a Secondary Service */
   if (!FindService(database.services, start_handle)) {
     AddService(start_handle, end_handle, uuid, false /* not primary */);
+    // Adding the service may have moved the one it is included in
+    service = FindService(database.services, handle);
+  }
+
+  /* Included service discovery over services that joined a batch may span
+   * services explored already */
+  if (batch_exploration) {
+    for (const IncludedService& is : service->included_services) {
+      if (is.handle == handle) return;
+    }
   }
 
   service->included_services.push_back(IncludedService{
@@ -133,6 +143,17 @@ void DatabaseBuilder::AddCharacteristic(uint16_t handle, uint16_t value_handle,
 }
 
 void DatabaseBuilder::AddDescriptor(uint16_t handle, const Uuid& uuid) {
+  /* Characteristic declarations and values between merged descriptor ranges
+   * are reported too */
+  if (!merged_descriptor_ranges.empty() &&
+      std::none_of(merged_descriptor_ranges.begin(),
+                   merged_descriptor_ranges.end(),
+                   [handle](const std::pair<uint16_t, uint16_t>& range) {
+                     return range.first <= handle && handle <= range.second;
+                   })) {
+    return;
+  }
+
   Service* service = FindService(database.services, handle);
   if (!service) {
     LOG(ERROR) << "Illegal action to add to non-existing service!";
@@ -162,6 +183,7 @@ void DatabaseBuilder::AddDescriptor(uint16_t handle, const Uuid& uuid) {
 }
 
 bool DatabaseBuilder::StartNextServiceExploration() {
+  batch_exploration = false;
   while (!services_to_discover.empty()) {
     auto handle_range = services_to_discover.begin();
     pending_service = *handle_range;
@@ -214,6 +236,120 @@ std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
   return {HANDLE_MAX, HANDLE_MAX};
 }
 
+bool DatabaseBuilder::StartBatchExploration() {
+  batch_exploration = false;
+  batch_services.clear();
+  batch_descriptor_ranges.clear();
+  batch_descriptor_index = 0;
+  merged_descriptor_ranges.clear();
+
+  pending_service = EXPLORE_END;
+  if (NextIncludedServiceRangeToExplore() == EXPLORE_END) return false;
+
+  batch_exploration = true;
+  return true;
+}
+
+std::pair<uint16_t, uint16_t>
+DatabaseBuilder::NextIncludedServiceRangeToExplore() {
+  std::pair<uint16_t, uint16_t> range = EXPLORE_END;
+  for (const auto& service : services_to_discover) {
+    // Empty service declaration, nothing to explore
+    if (service.first == service.second) continue;
+
+    batch_services.insert(service);
+    if (range == EXPLORE_END) {
+      range = service;
+    } else {
+      range.first = std::min(range.first, service.first);
+      range.second = std::max(range.second, service.second);
+    }
+  }
+  services_to_discover.clear();
+
+  if (range == EXPLORE_END) return EXPLORE_END;
+
+  if (pending_service == EXPLORE_END) {
+    pending_service = range;
+  } else {
+    pending_service.first = std::min(pending_service.first, range.first);
+    pending_service.second = std::max(pending_service.second, range.second);
+  }
+  return range;
+}
+
+/* Find Information responses hold entries of one length only, so a merged
+ * descriptor range pays a response for every change between 16-bit and
+ * 128-bit attribute types. Returns true if all attributes known in
+ * [start, end] have 16-bit types. */
+static bool HasOnlyShortTypes(const std::vector<Service>& services,
+                              uint16_t start, uint16_t end) {
+  for (const Service& service : services) {
+    if (service.end_handle < start) continue;
+    if (service.handle > end) break;
+
+    for (const Characteristic& charac : service.characteristics) {
+      if (charac.value_handle >= start && charac.value_handle <= end &&
+          !charac.uuid.Is16Bit())
+        return false;
+
+      for (const Descriptor& desc : charac.descriptors) {
+        if (desc.handle >= start && desc.handle <= end && !desc.uuid.Is16Bit())
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore(
+    size_t max_handles) {
+  merged_descriptor_ranges.clear();
+
+  // Same ranges as exploring the services one by one
+  if (batch_descriptor_index == 0 && batch_descriptor_ranges.empty()) {
+    for (const auto& handle_range : batch_services) {
+      Service* service = FindService(database.services, handle_range.first);
+      if (!service) continue;
+
+      for (auto it = service->characteristics.cbegin();
+           it != service->characteristics.cend(); it++) {
+        auto next = std::next(it);
+        uint16_t start = it->declaration_handle + 2;
+        uint16_t end = (next != service->characteristics.end())
+                           ? next->declaration_handle - 1
+                           : service->end_handle;
+        if (start <= end) batch_descriptor_ranges.emplace_back(start, end);
+      }
+    }
+    std::sort(batch_descriptor_ranges.begin(), batch_descriptor_ranges.end());
+  }
+
+  if (batch_descriptor_index >= batch_descriptor_ranges.size()) {
+    return EXPLORE_END;
+  }
+
+  std::pair<uint16_t, uint16_t> range =
+      batch_descriptor_ranges[batch_descriptor_index++];
+  merged_descriptor_ranges.push_back(range);
+  while (batch_descriptor_index < batch_descriptor_ranges.size()) {
+    const auto& next = batch_descriptor_ranges[batch_descriptor_index];
+    if ((size_t)std::max(range.second, next.second) - range.first + 1 >
+        max_handles)
+      break;
+    if (next.first > range.second + 1 &&
+        !HasOnlyShortTypes(database.services, range.second + 1,
+                           next.first - 1))
+      break;
+
+    range.second = std::max(range.second, next.second);
+    merged_descriptor_ranges.push_back(next);
+    batch_descriptor_index++;
+  }
+
+  return range;
+}
+
 Descriptor* FindDescriptorByHandle(std::vector<Service>& services,
                                    uint16_t handle) {
   Service* service = FindService(services, handle);
@@ -275,11 +411,19 @@ bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
 
 Database DatabaseBuilder::Build() {
   Database tmp = database;
-  database.Clear();
+  Clear();
+  tmp.BuildIndex();
   return tmp;
 }
 
-void DatabaseBuilder::Clear() { database.Clear(); }
+void DatabaseBuilder::Clear() {
+  database.Clear();
+  batch_exploration = false;
+  batch_services.clear();
+  batch_descriptor_ranges.clear();
+  batch_descriptor_index = 0;
+  merged_descriptor_ranges.clear();
+}
 
 std::string DatabaseBuilder::ToString() const { return database.ToString(); }
 
@@ -51,6 +51,34 @@ class DatabaseBuilder {
    */
   std::pair<uint16_t, uint16_t> NextDescriptorRangeToExplore();
 
+  /* Batch exploration discovers every service not explored yet at once: one
+   * included service discovery and one characteristic discovery span all of
+   * them, and descriptor ranges are merged. It makes far fewer requests than
+   * exploring services one by one, and builds the same database. */
+
+  /* Returns true if exploration of a batch of services started, false if
+   * there are no more services to explore. CurrentlyExploredService() is the
+   * range spanning the batch, to discover included services over first. */
+  bool StartBatchExploration();
+
+  /* Returns true while a batch exploration is in progress. */
+  bool InBatchExploration() const { return batch_exploration; }
+
+  /* Return range spanning services that included services found so far
+   * revealed, to discover included services over next, or EXPLORE_END if
+   * there are none. Such services join the batch, and
+   * CurrentlyExploredService() grows to span them, ready for characteristic
+   * discovery once this returns EXPLORE_END. */
+  std::pair<uint16_t, uint16_t> NextIncludedServiceRangeToExplore();
+
+  /* Return range of descriptors to discover across the batch, or EXPLORE_END
+   * if no more descriptors left. Descriptor ranges of successive
+   * characteristics are merged while the merged range spans at most
+   * |max_handles| handles and the attributes between them have 16-bit
+   * types; handles between them are not taken as descriptors. */
+  std::pair<uint16_t, uint16_t> NextDescriptorRangeToExplore(
+      size_t max_handles);
+
   /* Return vector of "Characteristic Extended Properties" descriptors that must
    * be read as part of service discovery process */
   std::vector<uint16_t> DescriptorHandlesToRead() {
@@ -90,6 +118,15 @@ class DatabaseBuilder {
   /* Characteristic inside pending_service that is currently being explored */
   uint16_t pending_characteristic;
 
+  bool batch_exploration = false;
+  /* services of the batch being explored, sorted */
+  std::set<std::pair<uint16_t, uint16_t>> batch_services;
+  /* descriptor ranges of the batch left to discover, and those the range
+   * being discovered merges; empty outside of batch descriptor discovery */
+  std::vector<std::pair<uint16_t, uint16_t>> batch_descriptor_ranges;
+  size_t batch_descriptor_index = 0;
+  std::vector<std::pair<uint16_t, uint16_t>> merged_descriptor_ranges;
+
   /* sorted, unique set of start_handle, end_handle pair of all services that
    * have not yet been discovered */
   std::set<std::pair<uint16_t, uint16_t>> services_to_discover;
@@ -25,6 +25,7 @@
 #include "embdrv/g722/g722_enc_dec.h"
 #include "gap_api.h"
 #include "gatt_api.h"
+#include "hearing_aid_tx_shaper.h"
 #include "osi/include/properties.h"
 
 #include <base/bind.h>
@@ -95,6 +96,9 @@ constexpr uint8_t OTHER_SIDE_IS_STREAMING = 0x01;
 // connnection intervals.
 constexpr uint16_t ADD_RENDER_DELAY_INTERVALS = 4;
 
+// Time a frame may wait in the L2CAP queue before the shaper flushes it.
+constexpr uint16_t TX_LATENCY_BUDGET_MS = 60;
+
 namespace {
 
 // clang-format off
@@ -260,7 +264,8 @@ class HearingAidImpl : public HearingAid {
         seq_counter(0),
         current_volume(VOLUME_UNKNOWN),
         callbacks(callbacks),
-        codec_in_use(0) {
+        codec_in_use(0),
+        codec_step_down(false) {
     default_data_interval_ms = (uint16_t)osi_property_get_int32(
         "persist.bluetooth.hearingaid.interval", (int32_t)HA_INTERVAL_20_MS);
     if ((default_data_interval_ms != HA_INTERVAL_10_MS) &&
@@ -273,6 +278,16 @@ class HearingAidImpl : public HearingAid {
     VLOG(2) << __func__
             << ", default_data_interval_ms=" << default_data_interval_ms;
 
+    tx_shaper_enabled = osi_property_get_bool(
+        "persist.vendor.btstack.hearing_aid.tx_shaper", false);
+    tx_latency_budget_ms = (uint16_t)osi_property_get_int32(
+        "persist.vendor.btstack.hearing_aid.tx_budget_ms",
+        (int32_t)TX_LATENCY_BUDGET_MS);
+    if (tx_latency_budget_ms < default_data_interval_ms)
+      tx_latency_budget_ms = default_data_interval_ms;
+    VLOG(2) << __func__ << ", tx_shaper_enabled=" << tx_shaper_enabled
+            << ", tx_latency_budget_ms=" << tx_latency_budget_ms;
+
     overwrite_min_ce_len = (uint16_t)osi_property_get_int32(
         "persist.bluetooth.hearingaidmincelen", 0);
     if (overwrite_min_ce_len) {
@@ -866,7 +881,10 @@ class HearingAidImpl : public HearingAid {
       }
     }
 
-    if ((codecs & (1 << CODEC_G722_24KHZ)) &&
+    // A stream that stayed congested is followed by one on the cheaper codec.
+    bool step_down = codec_step_down;
+    codec_step_down = false;
+    if ((codecs & (1 << CODEC_G722_24KHZ)) && !step_down &&
         controller_get_interface()->supports_ble_2m_phy() &&
         default_data_interval_ms == HA_INTERVAL_10_MS) {
       codec_in_use = CODEC_G722_24KHZ;
@@ -1022,6 +1040,7 @@ class HearingAidImpl : public HearingAid {
     if (encoder_state_left == nullptr) {
       encoder_state_init();
       seq_counter = 0;
+      ResetTxShaper();
 
       // use the best codec avaliable for this pair of devices.
       uint16_t codecs = hearingDevice.codecs;
@@ -1091,6 +1110,7 @@ class HearingAidImpl : public HearingAid {
     encoder_state_release();
     encoder_state_init();
     seq_counter = 0;
+    ResetTxShaper();
 
     for (auto& device : hearingDevices.devices) {
       if (!device.accepting_audio) continue;
@@ -1191,6 +1211,8 @@ class HearingAidImpl : public HearingAid {
       audio_running = false;
       encoder_state_release();
       current_volume = VOLUME_UNKNOWN;
+      // The codec is chosen again when the next hearing aid connects.
+      codec_in_use = 0;
       return;
     }
 
@@ -1242,19 +1264,6 @@ class HearingAidImpl : public HearingAid {
         LOG(ERROR) << "Error: No chan_left data to encode";
       }
       encoded_data_left.resize(encoded_size);
-
-      uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
-      uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
-      if (packets_to_flush) {
-        VLOG(2) << left->address << " skipping " << packets_to_flush
-                << " packets";
-        left->audio_stats.packet_flush_count += packets_to_flush;
-        left->audio_stats.frame_flush_count++;
-        hearingDevices.StartRssiLog();
-      }
-      // flush all packets stuck in queue
-      L2CA_FlushChannel(cid, 0xffff);
-      check_and_do_rssi_read(left);
     }
 
     std::vector<uint8_t> encoded_data_right;
@@ -1270,19 +1279,6 @@ class HearingAidImpl : public HearingAid {
         LOG(ERROR) << "Error: No chan_right data to encode";
       }
       encoded_data_right.resize(encoded_size);
-
-      uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
-      uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
-      if (packets_to_flush) {
-        VLOG(2) << right->address << " skipping " << packets_to_flush
-                << " packets";
-        right->audio_stats.packet_flush_count += packets_to_flush;
-        right->audio_stats.frame_flush_count++;
-        hearingDevices.StartRssiLog();
-      }
-      // flush all packets stuck in queue
-      L2CA_FlushChannel(cid, 0xffff);
-      check_and_do_rssi_read(right);
     }
 
     size_t encoded_data_size =
@@ -1294,29 +1290,98 @@ class HearingAidImpl : public HearingAid {
     if (encoded_data_size != 0 && packet_size > encoded_data_size)
       packet_size = encoded_data_size;
     VLOG(2) << "packet_size : " << packet_size;
+    uint16_t frame_packets =
+        packet_size ? (uint16_t)((encoded_data_size + packet_size - 1) /
+                                 packet_size)
+                    : 0;
+    FlushQueuedAudio(left, right, frame_packets);
+
+    uint16_t sent_left = 0;
+    uint16_t sent_right = 0;
     for (size_t i = 0; i < encoded_data_size; i += packet_size) {
       if (left) {
         left->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_left.data() + i, packet_size, left);
+        if (SendAudio(encoded_data_left.data() + i, packet_size, left))
+          sent_left++;
       }
       if (right) {
         right->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_right.data() + i, packet_size, right);
+        if (SendAudio(encoded_data_right.data() + i, packet_size, right))
+          sent_right++;
       }
       seq_counter++;
     }
+    if (tx_shaper_enabled) {
+      tx_shaper.OnSent(HearingAidTxShaper::kLeft, sent_left);
+      tx_shaper.OnSent(HearingAidTxShaper::kRight, sent_right);
+    }
     if (left) left->audio_stats.frame_send_count++;
     if (right) right->audio_stats.frame_send_count++;
   }
 
-  void SendAudio(uint8_t* encoded_data, uint16_t packet_size,
+  void ResetTxShaper() {
+    HearingAidTxShaper::Config config;
+    config.interval_ms = default_data_interval_ms;
+    config.latency_budget_ms = tx_latency_budget_ms;
+    tx_shaper.Reset(config);
+  }
+
+  /* Flushes the audio of the previous frames still queued in L2CAP before a
+   * new frame of |frame_packets| packets is sent. Without the shaper all of it
+   * is flushed, with it only the oldest frames that would hold the new one
+   * past the latency budget, up to the same frame on both sides. */
+  void FlushQueuedAudio(HearingDevice* left, HearingDevice* right,
+                        uint16_t frame_packets) {
+    HearingDevice* devices[HearingAidTxShaper::kSides] = {left, right};
+    HearingAidTxShaper::Queue queues[HearingAidTxShaper::kSides] = {};
+    for (int i = 0; i < HearingAidTxShaper::kSides; i++) {
+      if (!devices[i]) continue;
+      uint16_t cid = GAP_ConnGetL2CAPCid(devices[i]->gap_handle);
+      queues[i].active = true;
+      queues[i].packets = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
+    }
+
+    HearingAidTxShaper::Decision decision = {};
+    if (tx_shaper_enabled) {
+      decision = tx_shaper.Shape(queues, frame_packets);
+      if (decision.step_down && codec_in_use == CODEC_G722_24KHZ) {
+        LOG(WARNING) << __func__ << ": audio link stays congested, use "
+                     << "G.722 16kHz for the next stream";
+        codec_step_down = true;
+      }
+    } else {
+      for (int i = 0; i < HearingAidTxShaper::kSides; i++) {
+        decision.flush_packets[i] = queues[i].packets;
+        decision.flush_frames[i] = queues[i].packets ? 1 : 0;
+      }
+    }
+
+    for (int i = 0; i < HearingAidTxShaper::kSides; i++) {
+      HearingDevice* device = devices[i];
+      if (!device) continue;
+      uint16_t packets_to_flush = decision.flush_packets[i];
+      if (packets_to_flush) {
+        VLOG(2) << device->address << " skipping " << packets_to_flush
+                << " of " << queues[i].packets << " packets";
+        device->audio_stats.packet_flush_count += packets_to_flush;
+        device->audio_stats.frame_flush_count += decision.flush_frames[i];
+        hearingDevices.StartRssiLog();
+        // flush the oldest packets stuck in queue
+        uint16_t cid = GAP_ConnGetL2CAPCid(device->gap_handle);
+        L2CA_FlushChannel(cid, tx_shaper_enabled ? packets_to_flush : 0xffff);
+      }
+      check_and_do_rssi_read(device);
+    }
+  }
+
+  bool SendAudio(uint8_t* encoded_data, uint16_t packet_size,
                  HearingDevice* hearingAid) {
     if (!hearingAid->playback_started || !hearingAid->command_acked) {
       VLOG(2) << __func__
               << ": Playback stalled, device=" << hearingAid->address
               << ", cmd send=" << hearingAid->playback_started
               << ", cmd acked=" << hearingAid->command_acked;
-      return;
+      return false;
     }
 
     BT_HDR* audio_packet = malloc_l2cap_buf(packet_size + 1);
@@ -1331,7 +1396,9 @@ class HearingAidImpl : public HearingAid {
 
     if (result != BT_PASS) {
       LOG(ERROR) << " Error sending data: " << loghex(result);
+      return false;
     }
+    return true;
   }
 
   void GapCallback(uint16_t gap_handle, uint16_t event, tGAP_CB_DATA* data) {
@@ -1416,6 +1483,11 @@ class HearingAidImpl : public HearingAid {
         DVLOG(2) << "GAP_EVT_LE_COC_CREDITS, for device: "
                  << hearingDevice->address << " added" << tmp.credits_received
                  << " credit_count: " << tmp.credit_count;
+        if (tx_shaper_enabled)
+          tx_shaper.OnCredits(hearingDevice->isLeft()
+                                  ? HearingAidTxShaper::kLeft
+                                  : HearingAidTxShaper::kRight,
+                              tmp.credits_received, tmp.credit_count);
         break;
       }
     }
@@ -1482,9 +1554,25 @@ class HearingAidImpl : public HearingAid {
           << "\n    Frame counts (enqueued/flushed)                         : "
           << device.audio_stats.frame_send_count << " / "
           << device.audio_stats.frame_flush_count << std::endl;
+      if (tx_shaper_enabled) {
+        HearingAidTxShaper::Side tx_side = device.isLeft()
+                                               ? HearingAidTxShaper::kLeft
+                                               : HearingAidTxShaper::kRight;
+        stream
+            << "    Tx shaper (packets per interval/credits/dropped frames): "
+            << tx_shaper.TxRate(tx_side) / 256.0 << " / "
+            << tx_shaper.Credits(tx_side) << " / "
+            << tx_shaper.DroppedFrames(tx_side) << std::endl;
+      }
 
       DumpRssi(fd, device);
     }
+    if (tx_shaper_enabled) {
+      stream << "  Tx latency budget: " << tx_latency_budget_ms << " ms ("
+             << tx_shaper.BudgetFrames() << " frames)"
+             << (codec_step_down ? ", codec steps down next stream" : "")
+             << std::endl;
+    }
     dprintf(fd, "%s", stream.str().c_str());
   }
 
@@ -1635,6 +1723,12 @@ class HearingAidImpl : public HearingAid {
 
   /* currently used codec */
   uint8_t codec_in_use;
+  /* the stream stayed congested, use a cheaper codec for the next one */
+  bool codec_step_down;
+
+  bool tx_shaper_enabled;
+  uint16_t tx_latency_budget_ms;
+  HearingAidTxShaper tx_shaper;
 
   uint16_t default_data_interval_ms;
 
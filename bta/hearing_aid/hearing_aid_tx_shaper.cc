@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "hearing_aid_tx_shaper.h"
+
+#include <algorithm>
+
+namespace {
+
+// Transmit rates above this many frames per interval count as this many.
+constexpr uint32_t kMaxRateFrames = 8;
+// Slack, in 1/256 packet, before a frame is found not to fit the budget.
+constexpr uint32_t kFitSlack = 32;
+
+// Moves |average| by 1/8 of the way to |sample|.
+void Ewma(uint32_t& average, uint32_t sample) {
+  average = (uint32_t)(((uint64_t)average * 7 + sample) / 8);
+}
+
+}  // namespace
+
+void HearingAidTxShaper::Reset(const Config& config) {
+  config_ = config;
+  budget_frames_ = 1;
+  if (config_.interval_ms != 0)
+    budget_frames_ =
+        std::max<uint32_t>(1, config_.latency_budget_ms / config_.interval_ms);
+  frames_in_window_ = 0;
+  stepped_down_ = false;
+  for (SideState& side : sides_) side = SideState();
+}
+
+void HearingAidTxShaper::OnCredits(Side side, uint16_t received,
+                                   uint16_t credit_count) {
+  SideState& state = sides_[side];
+  state.credits_known = true;
+  state.credits_fresh = true;
+  state.credits = credit_count;
+  state.credits_received += received;
+}
+
+HearingAidTxShaper::Decision HearingAidTxShaper::Shape(
+    const Queue (&queues)[kSides], uint16_t frame_packets) {
+  Decision decision = {};
+  uint32_t packets = std::max<uint32_t>(1, frame_packets);
+
+  uint32_t queued_frames[kSides] = {};
+  uint32_t keep = UINT32_MAX;
+  for (int i = 0; i < kSides; i++) {
+    SideState& side = sides_[i];
+    if (!queues[i].active) {
+      side.active = false;
+      continue;
+    }
+    if (!side.active) {
+      side.active = true;
+      side.expected = 0;
+      side.tx_rate = side.credit_rate = packets * 256;
+    }
+    uint32_t queued = queues[i].packets;
+    queued_frames[i] = (queued + packets - 1) / packets;
+    uint32_t frames = FramesToKeep(side, queued, packets);
+    if (queued_frames[i] > frames) keep = std::min(keep, frames);
+  }
+
+  // Every side keeps at most the frames kept by the most congested one, so
+  // both flush up to the same sequence number.
+  for (int i = 0; i < kSides; i++) {
+    SideState& side = sides_[i];
+    if (!side.active) continue;
+    uint32_t queued = queues[i].packets;
+    uint32_t flush = 0;
+    if (queued_frames[i] > keep) {
+      flush = queued - std::min(queued, keep * packets);
+      decision.flush_packets[i] = (uint16_t)flush;
+      decision.flush_frames[i] = (uint16_t)(queued_frames[i] - keep);
+      side.dropped_frames += decision.flush_frames[i];
+      side.window_drops++;
+    }
+    side.expected = queued - flush;
+  }
+
+  decision.step_down = CloseFrame();
+  return decision;
+}
+
+void HearingAidTxShaper::OnSent(Side side, uint16_t packets) {
+  sides_[side].expected += packets;
+}
+
+int32_t HearingAidTxShaper::Credits(Side side) const {
+  return sides_[side].credits_known ? (int32_t)sides_[side].credits : -1;
+}
+
+uint32_t HearingAidTxShaper::FramesToKeep(SideState& side, uint32_t queued,
+                                          uint32_t frame_packets) {
+  uint32_t sent = side.expected - std::min(side.expected, queued);
+  // A side that emptied its queue kept up with the stream.
+  uint32_t sample = queued == 0 ? std::max(sent, frame_packets) : sent;
+  sample = std::min(sample, kMaxRateFrames * frame_packets);
+  Ewma(side.tx_rate, sample * 256);
+
+  // Transmitted packets use up credits; a credit event since the last frame
+  // already counted them.
+  if (side.credits_known) {
+    if (!side.credits_fresh) side.credits -= std::min(side.credits, sent);
+    Ewma(side.credit_rate,
+         std::min(side.credits_received, kMaxRateFrames * frame_packets) *
+             256);
+  }
+  side.credits_fresh = false;
+  side.credits_received = 0;
+
+  uint64_t capacity = (uint64_t)side.tx_rate * budget_frames_;
+  if (side.credits_known)
+    capacity = std::min<uint64_t>(
+        capacity,
+        (uint64_t)side.credits * 256 +
+            (uint64_t)side.credit_rate * budget_frames_);
+
+  // The new frame goes out behind the queued frames that are kept.
+  uint64_t fit = (capacity + kFitSlack) / (256 * frame_packets);
+  if (fit == 0) return 0;
+  return (uint32_t)std::min<uint64_t>(fit - 1, budget_frames_ - 1);
+}
+
+bool HearingAidTxShaper::CloseFrame() {
+  if (++frames_in_window_ < kWindowFrames) return false;
+  frames_in_window_ = 0;
+
+  bool step_down = false;
+  for (SideState& side : sides_) {
+    if (side.active && side.window_drops >= kCongestedDrops)
+      side.congested_windows++;
+    else
+      side.congested_windows = 0;
+    side.window_drops = 0;
+    if (side.congested_windows >= kStepDownWindows) step_down = true;
+  }
+  if (!step_down || stepped_down_) return false;
+  stepped_down_ = true;
+  return true;
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+// Credit-aware shaping of the hearing aid audio queued in L2CAP.
+//
+// A new audio frame is encoded every connection interval. Before it is sent,
+// Shape() looks at the packets of the previous frames that each side still
+// has queued and tells how many of the oldest ones to flush, so that the new
+// frame goes out within the latency budget. Per side it keeps:
+//   - the packets the link transmitted per connection interval, measured
+//     from the queue depth between two frames,
+//   - the LE CoC credits left and the credits the hearing aid returns per
+//     connection interval, from the LE CoC credit events. An audio packet
+//     fits in one LE frame, so it takes one credit.
+// Over the budget the side is expected to transmit min(link rate, credits
+// left + credit return rate) packets; the queued frames that do not fit in
+// front of the new frame are flushed, oldest first. When both sides flush,
+// they flush up to the same frame, so the hearing aids drop the same
+// sequence numbers.
+//
+// A side that flushes frames in kCongestedDrops of the kWindowFrames frames
+// of a window, for kStepDownWindows windows in a row, asks once for the
+// encoder to step down to a cheaper mode.
+//
+// All operations are O(1). Not thread safe.
+class HearingAidTxShaper {
+ public:
+  enum Side { kLeft = 0, kRight = 1, kSides = 2 };
+
+  struct Config {
+    uint16_t interval_ms = 20;
+    uint16_t latency_budget_ms = 60;
+  };
+
+  // Input of Shape() per side.
+  struct Queue {
+    bool active;
+    // Packets still queued in L2CAP, as from L2CA_FlushChannel() with
+    // L2CAP_FLUSH_CHANS_GET.
+    uint16_t packets;
+  };
+
+  struct Decision {
+    // Oldest queued packets and frames to flush before sending.
+    uint16_t flush_packets[kSides];
+    uint16_t flush_frames[kSides];
+    // Set once when the link stays congested.
+    bool step_down;
+  };
+
+  static constexpr uint32_t kWindowFrames = 100;
+  static constexpr uint32_t kCongestedDrops = 10;
+  static constexpr uint32_t kStepDownWindows = 2;
+
+  // Starts a new stream; everything measured so far is forgotten.
+  void Reset(const Config& config);
+
+  // The hearing aid on |side| returned |received| credits and has now
+  // granted |credit_count| in total.
+  void OnCredits(Side side, uint16_t received, uint16_t credit_count);
+
+  // Called once per frame of |frame_packets| packets, before it is sent.
+  Decision Shape(const Queue (&queues)[kSides], uint16_t frame_packets);
+
+  // |packets| packets of the new frame were queued on |side|.
+  void OnSent(Side side, uint16_t packets);
+
+  uint32_t BudgetFrames() const { return budget_frames_; }
+  // Packets transmitted per connection interval, times 256.
+  uint32_t TxRate(Side side) const { return sides_[side].tx_rate; }
+  // Credits left, or -1 while no credit event was seen.
+  int32_t Credits(Side side) const;
+  uint32_t DroppedFrames(Side side) const {
+    return sides_[side].dropped_frames;
+  }
+  bool SteppedDown() const { return stepped_down_; }
+
+ private:
+  struct SideState {
+    bool active = false;
+    // Packets left in the queue after the previous frame was sent.
+    uint32_t expected = 0;
+
+    bool credits_known = false;
+    // A credit event came since the last frame; its count is current.
+    bool credits_fresh = false;
+    uint32_t credits = 0;
+    uint32_t credits_received = 0;
+
+    // Averages per connection interval, times 256.
+    uint32_t tx_rate = 0;
+    uint32_t credit_rate = 0;
+
+    uint32_t window_drops = 0;
+    uint32_t congested_windows = 0;
+    uint32_t dropped_frames = 0;
+  };
+
+  // Updates the averages of |side| with the packets transmitted since the
+  // last frame and returns how many queued frames it can keep.
+  uint32_t FramesToKeep(SideState& side, uint32_t queued,
+                        uint32_t frame_packets);
+  // Counts a frame in the congestion window, returns true on a step down.
+  bool CloseFrame();
+
+  Config config_;
+  uint32_t budget_frames_ = 3;
+  uint32_t frames_in_window_ = 0;
+  bool stepped_down_ = false;
+  SideState sides_[kSides];
+};
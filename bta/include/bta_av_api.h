@@ -575,6 +575,12 @@ typedef union {
   tBTA_AVK_CONFIG avk_config;
 } tBTA_AV_MEDIA;
 
+/* The RTP timestamp of a BTA_AV_SINK_MEDIA_DATA_EVT packet, in host byte
+ * order, is stored in the BTA_AV_SINK_MEDIA_TS_LEN bytes in front of the
+ * payload, where the RTP header was. The sink data callback owns the packet
+ * and frees it. */
+#define BTA_AV_SINK_MEDIA_TS_LEN 4
+
 #define BTA_GROUP_NAVI_MSG_OP_DATA_LEN 5
 
 /* AV callback */
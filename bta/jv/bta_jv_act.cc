@@ -1445,6 +1445,12 @@ static int bta_jv_port_data_co_cback(uint16_t port_handle, uint8_t* buf,
         return bta_co_rfc_data_outgoing_size(p_pcb->rfcomm_slot_id, (int*)buf);
       case DATA_CO_CALLBACK_TYPE_OUTGOING:
         return bta_co_rfc_data_outgoing(p_pcb->rfcomm_slot_id, buf, len);
+      case DATA_CO_CALLBACK_TYPE_OUTGOING_BUFS: {
+        tPORT_DATA_CO_BUFS* p_bufs = (tPORT_DATA_CO_BUFS*)buf;
+        return bta_co_rfc_data_outgoing_bufs(p_pcb->rfcomm_slot_id,
+                                             p_bufs->bufs, p_bufs->count,
+                                             p_bufs->max_len);
+      }
       default:
         APPL_TRACE_ERROR("unknown callout type:%d", type);
         break;
@@ -2510,6 +2516,7 @@ static void fcchan_data_cbk(uint16_t chan, const RawAddress& bd_addr,
 
   if (!t) {
     // no socket -> drop it
+    osi_free(p_buf);
     return;
   }
 
@@ -2519,6 +2526,9 @@ static void fcchan_data_cbk(uint16_t chan, const RawAddress& bd_addr,
   evt_data.le_data_ind.p_buf = p_buf;
 
   if (sock_cback) sock_cback(BTA_JV_L2CAP_DATA_IND_EVT, &evt_data, sock_id);
+
+  // the socket clears p_buf if it keeps the buffer
+  osi_free(evt_data.le_data_ind.p_buf);
 }
 
 /*******************************************************************************
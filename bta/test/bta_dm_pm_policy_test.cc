@@ -0,0 +1,383 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "dm/bta_dm_pm_policy.h"
+
+namespace {
+
+using Params = PmTrafficPolicy::Params;
+using Traffic = PmTrafficPolicy::Traffic;
+
+const uint16_t kHandle = 0x0001;
+
+// BTA_DM_PM_SNIFF_A2DP_IDX, which the RFCOMM and OBEX specs use, after the
+// 5 s idle timeout of the DG and PAN specs. No subrating.
+const Params kTable = {5000, 800, 400, 0};
+
+// Sends |count| packets of |bytes| |gap_ms| apart from |start_ms|.
+void Burst(PmTrafficPolicy& policy, uint64_t start_ms, int count,
+           uint32_t gap_ms, uint16_t bytes = 50) {
+  for (int i = 0; i < count; i++)
+    policy.OnTraffic(kHandle, start_ms + i * gap_ms, bytes);
+}
+
+}  // namespace
+
+TEST(PmTrafficPolicyTest, unknown_link_keeps_the_table) {
+  PmTrafficPolicy policy;
+  Params params = policy.Adjust(kHandle, 1000, kTable);
+  EXPECT_EQ(kTable.idle_timeout_ms, params.idle_timeout_ms);
+  EXPECT_EQ(kTable.sniff_max, params.sniff_max);
+  EXPECT_EQ(kTable.sniff_min, params.sniff_min);
+  EXPECT_EQ(Traffic::kIdle, policy.Class(kHandle));
+  EXPECT_EQ(0u, policy.IdleRemainingMs(kHandle, 1000, 5000));
+}
+
+TEST(PmTrafficPolicyTest, lone_packets_are_idle) {
+  PmTrafficPolicy policy;
+  for (uint64_t t = 0; t < 300000; t += 20000) Burst(policy, t, 1, 0);
+
+  Params params = policy.Adjust(kHandle, 300000, kTable);
+  EXPECT_EQ(Traffic::kIdle, policy.Class(kHandle));
+  EXPECT_EQ(1250u, params.idle_timeout_ms);
+  EXPECT_EQ(kTable.sniff_max, params.sniff_max);
+}
+
+TEST(PmTrafficPolicyTest, short_bursts_are_interactive) {
+  PmTrafficPolicy policy;
+  for (uint64_t t = 0; t < 60000; t += 6000) Burst(policy, t, 6, 20);
+
+  Params params = policy.Adjust(kHandle, 60000, kTable);
+  EXPECT_EQ(Traffic::kInteractive, policy.Class(kHandle));
+  EXPECT_EQ(PmTrafficPolicy::kMinIdleTimeoutMs, params.idle_timeout_ms);
+  EXPECT_EQ(PmTrafficPolicy::kInteractiveSniffMax, params.sniff_max);
+  EXPECT_LE(params.sniff_min, params.sniff_max);
+  // No subrating in the table, none added.
+  EXPECT_EQ(0, params.ssr_max_lat);
+
+  Params ssr_table = kTable;
+  ssr_table.ssr_max_lat = 1200;
+  EXPECT_EQ(PmTrafficPolicy::kInteractiveSsrMaxLat,
+            policy.Adjust(kHandle, 60000, ssr_table).ssr_max_lat);
+}
+
+TEST(PmTrafficPolicyTest, never_exceeds_the_table) {
+  PmTrafficPolicy policy;
+  // Bursts with long gaps inside would ask for a long idle timeout.
+  for (uint64_t t = 0; t < 60000; t += 6000) Burst(policy, t, 6, 190);
+  ASSERT_EQ(Traffic::kInteractive, policy.Class(kHandle));
+
+  Params table = {300, 30, 10, 0};
+  Params params = policy.Adjust(kHandle, 60000, table);
+  EXPECT_EQ(300u, params.idle_timeout_ms);
+  EXPECT_EQ(30, params.sniff_max);
+  EXPECT_EQ(10, params.sniff_min);
+
+  table.idle_timeout_ms = 0;
+  EXPECT_EQ(0u, policy.Adjust(kHandle, 60000, table).idle_timeout_ms);
+}
+
+TEST(PmTrafficPolicyTest, steady_traffic_is_streaming) {
+  PmTrafficPolicy policy;
+  Burst(policy, 0, 1000, 10, 600);
+
+  Params params = policy.Adjust(kHandle, 10000, kTable);
+  EXPECT_EQ(Traffic::kStreaming, policy.Class(kHandle));
+  EXPECT_EQ(kTable.idle_timeout_ms, params.idle_timeout_ms);
+  EXPECT_EQ(kTable.sniff_max, params.sniff_max);
+  // 600 bytes every 10 ms.
+  EXPECT_NEAR(60000, policy.Throughput(kHandle), 3000);
+}
+
+TEST(PmTrafficPolicyTest, class_changes_after_hysteresis) {
+  PmTrafficPolicy policy;
+  Burst(policy, 0, 1000, 10, 600);
+  ASSERT_EQ(Traffic::kStreaming, policy.Class(kHandle));
+
+  // A short pause does not end the stream.
+  Burst(policy, 10500, 1, 0, 600);
+  EXPECT_EQ(Traffic::kStreaming, policy.Class(kHandle));
+
+  // A few windows after the stream stops, the link is no longer streaming,
+  // and not before.
+  Burst(policy, 20000, 400, 10, 600);
+  ASSERT_EQ(Traffic::kStreaming, policy.Class(kHandle));
+  uint64_t stopped = 24000;
+  uint64_t changed = stopped;
+  while (policy.Class(kHandle) == Traffic::kStreaming && changed < 60000) {
+    changed += PmTrafficPolicy::kWindowMs;
+    policy.Adjust(kHandle, changed, kTable);
+  }
+  EXPECT_NE(Traffic::kStreaming, policy.Class(kHandle));
+  EXPECT_GE(changed - stopped,
+            PmTrafficPolicy::kHysteresisWindows * PmTrafficPolicy::kWindowMs);
+  EXPECT_LE(changed - stopped, 5000u);
+}
+
+TEST(PmTrafficPolicyTest, idle_remaining_counts_from_last_packet) {
+  PmTrafficPolicy policy;
+  Burst(policy, 1000, 1, 0);
+  EXPECT_EQ(4000u, policy.IdleRemainingMs(kHandle, 2000, 5000));
+  EXPECT_EQ(0u, policy.IdleRemainingMs(kHandle, 6000, 5000));
+  EXPECT_EQ(0u, policy.IdleRemainingMs(kHandle, 9000, 5000));
+}
+
+TEST(PmTrafficPolicyTest, wakes_interactive_link_from_long_sniff) {
+  PmTrafficPolicy policy;
+  for (uint64_t t = 0; t < 60000; t += 6000) Burst(policy, t, 6, 20);
+  ASSERT_EQ(Traffic::kInteractive, policy.Class(kHandle));
+
+  // Active, or a sniff interval short enough: nothing to do.
+  EXPECT_FALSE(policy.OnTraffic(kHandle, 62000, 50));
+  policy.OnModeChange(kHandle, PmTrafficPolicy::kWakeMinInterval);
+  EXPECT_FALSE(policy.OnTraffic(kHandle, 64000, 50));
+
+  policy.OnModeChange(kHandle, 800);
+  EXPECT_TRUE(policy.OnTraffic(kHandle, 66000, 50));
+  // Not again before the holdoff.
+  EXPECT_FALSE(policy.OnTraffic(kHandle, 66020, 50));
+  EXPECT_TRUE(policy.OnTraffic(kHandle, 67100, 50));
+
+  policy.OnLinkDown(kHandle);
+  EXPECT_EQ(Traffic::kIdle, policy.Class(kHandle));
+}
+
+TEST(PmTrafficPolicyTest, does_not_wake_idle_link) {
+  PmTrafficPolicy policy;
+  for (uint64_t t = 0; t < 300000; t += 20000) Burst(policy, t, 1, 0);
+  policy.OnModeChange(kHandle, 800);
+  EXPECT_FALSE(policy.OnTraffic(kHandle, 320000, 50));
+}
+
+namespace {
+
+// Replays a packet trace against a model of the link and the power manager:
+// the link goes to sniff once it was idle for the idle timeout, packets that
+// arrive in sniff wait for the next anchor point, and a packet sent by the
+// host or a wake from the policy brings the link back to active at the next
+// anchor point, after which the idle timer restarts. Without a policy the
+// table values are used as they are.
+
+struct Packet {
+  uint64_t at_us;
+  uint16_t bytes;
+  bool tx;
+};
+
+struct SimResult {
+  double mean_latency_ms;
+  double p95_latency_ms;
+  double active_share;
+  size_t sniff_entries;
+};
+
+const uint64_t kNever = UINT64_MAX;
+const uint64_t kSlotUs = 625;
+
+class LinkModel {
+ public:
+  LinkModel(const Params& table, PmTrafficPolicy* policy)
+      : table_(table), policy_(policy) {}
+
+  SimResult Run(const std::vector<Packet>& trace, uint64_t end_us) {
+    std::vector<double> latencies;
+    for (const Packet& packet : trace) {
+      RunUntil(packet.at_us);
+      latencies.push_back(Deliver(packet) / 1000.0);
+    }
+    RunUntil(end_us);
+    if (!sniff_) active_us_ += end_us - active_since_us_;
+
+    SimResult result = {0, 0, (double)active_us_ / end_us, sniff_entries_};
+    for (double latency : latencies) result.mean_latency_ms += latency;
+    result.mean_latency_ms /= latencies.size();
+    std::sort(latencies.begin(), latencies.end());
+    result.p95_latency_ms = latencies[latencies.size() * 95 / 100];
+    return result;
+  }
+
+ private:
+  Params Current(uint64_t now_us) {
+    return policy_ ? policy_->Adjust(kHandle, now_us / 1000, table_) : table_;
+  }
+
+  void ArmIdleTimer(uint64_t now_us) {
+    uint32_t timeout_ms = Current(now_us).idle_timeout_ms;
+    idle_deadline_us_ = timeout_ms ? now_us + timeout_ms * 1000ull : kNever;
+  }
+
+  // Handles the mode changes and timer expiries up to |now_us|.
+  void RunUntil(uint64_t now_us) {
+    while (true) {
+      if (sniff_ && exit_at_us_ <= now_us) {
+        sniff_ = false;
+        active_since_us_ = exit_at_us_;
+        exit_at_us_ = kNever;
+        if (policy_) policy_->OnModeChange(kHandle, 0);
+        ArmIdleTimer(active_since_us_);
+      } else if (!sniff_ && idle_deadline_us_ <= now_us) {
+        uint64_t fired_us = idle_deadline_us_;
+        Params params = Current(fired_us);
+        uint32_t remaining_ms =
+            policy_ ? policy_->IdleRemainingMs(kHandle, fired_us / 1000,
+                                               params.idle_timeout_ms)
+                    : 0;
+        if (remaining_ms) {
+          idle_deadline_us_ = fired_us + remaining_ms * 1000ull;
+          continue;
+        }
+        sniff_ = true;
+        sniff_entries_++;
+        active_us_ += fired_us - active_since_us_;
+        anchor_us_ = fired_us;
+        interval_us_ = params.sniff_max * kSlotUs;
+        idle_deadline_us_ = kNever;
+        if (policy_) policy_->OnModeChange(kHandle, params.sniff_max);
+      } else {
+        return;
+      }
+    }
+  }
+
+  // Returns how long |packet| waits for the link, in microseconds.
+  uint64_t Deliver(const Packet& packet) {
+    bool wake = policy_ &&
+                policy_->OnTraffic(kHandle, packet.at_us / 1000, packet.bytes);
+    if (!sniff_) {
+      ArmIdleTimer(packet.at_us);
+      return 0;
+    }
+    uint64_t since = packet.at_us - anchor_us_;
+    uint64_t next_anchor_us =
+        anchor_us_ + (since + interval_us_ - 1) / interval_us_ * interval_us_;
+    if ((wake || packet.tx) && exit_at_us_ == kNever)
+      exit_at_us_ = next_anchor_us;
+    return next_anchor_us - packet.at_us;
+  }
+
+  const Params table_;
+  PmTrafficPolicy* policy_;
+
+  bool sniff_ = false;
+  uint64_t active_since_us_ = 0;
+  uint64_t active_us_ = 0;
+  uint64_t idle_deadline_us_ = kNever;
+  uint64_t anchor_us_ = 0;
+  uint64_t interval_us_ = 0;
+  uint64_t exit_at_us_ = kNever;
+  size_t sniff_entries_ = 0;
+};
+
+const uint64_t kTraceUs = 30ull * 60 * 1000 * 1000;
+
+uint64_t Ms(uint64_t ms) { return ms * 1000; }
+
+// A companion device notifying the phone: a few packets 5-25 ms apart,
+// answered once by the host, every 3 to 20 s.
+std::vector<Packet> NotificationTrace() {
+  std::mt19937 rng(45);
+  std::vector<Packet> trace;
+  for (uint64_t t = Ms(1000); t < kTraceUs;) {
+    uint64_t at = t;
+    int rx_packets = 2 + rng() % 6;
+    for (int i = 0; i < rx_packets; i++) {
+      trace.push_back({at, (uint16_t)(20 + rng() % 200), false});
+      at += Ms(5 + rng() % 21);
+      if (i == 0) {
+        trace.push_back({at, 30, true});
+        at += Ms(5 + rng() % 21);
+      }
+    }
+    t = at + Ms(3000 + rng() % 17000);
+  }
+  return trace;
+}
+
+// Lone keep-alives from the host every 15 to 45 s.
+std::vector<Packet> KeepAliveTrace() {
+  std::mt19937 rng(46);
+  std::vector<Packet> trace;
+  for (uint64_t t = Ms(1000); t < kTraceUs; t += Ms(15000 + rng() % 30000))
+    trace.push_back({t, 12, true});
+  return trace;
+}
+
+// A file transfer for 3 to 10 s every 10 to 30 s, one packet every 10 ms
+// and one acknowledgement from the host for every 8.
+std::vector<Packet> TransferTrace() {
+  std::mt19937 rng(47);
+  std::vector<Packet> trace;
+  for (uint64_t t = Ms(1000); t < kTraceUs;) {
+    uint64_t end = t + Ms(3000 + rng() % 7000);
+    for (int i = 0; t < end && t < kTraceUs; t += Ms(10), i++)
+      trace.push_back({t, 1000, i % 8 == 7});
+    t += Ms(10000 + rng() % 20000);
+  }
+  return trace;
+}
+
+void Report(const char* name, const SimResult& table,
+            const SimResult& adaptive) {
+  printf("%s\n", name);
+  printf(
+      "  table:    mean %6.1f ms, p95 %6.1f ms, active %5.1f%%, %4zu sniffs\n",
+      table.mean_latency_ms, table.p95_latency_ms, table.active_share * 100,
+      table.sniff_entries);
+  printf(
+      "  adaptive: mean %6.1f ms, p95 %6.1f ms, active %5.1f%%, %4zu sniffs\n",
+      adaptive.mean_latency_ms, adaptive.p95_latency_ms,
+      adaptive.active_share * 100, adaptive.sniff_entries);
+}
+
+SimResult Replay(const std::vector<Packet>& trace, bool adaptive) {
+  PmTrafficPolicy policy;
+  LinkModel link(kTable, adaptive ? &policy : nullptr);
+  return link.Run(trace, kTraceUs);
+}
+
+}  // namespace
+
+TEST(PmTrafficPolicyTest, notifications_sniff_sooner_and_wait_less) {
+  std::vector<Packet> trace = NotificationTrace();
+  SimResult table = Replay(trace, false);
+  SimResult adaptive = Replay(trace, true);
+  Report("notifications", table, adaptive);
+
+  EXPECT_LT(adaptive.active_share * 3, table.active_share);
+  EXPECT_LT(adaptive.mean_latency_ms, table.mean_latency_ms);
+  EXPECT_LT(adaptive.p95_latency_ms, table.p95_latency_ms);
+}
+
+TEST(PmTrafficPolicyTest, keep_alives_sniff_sooner) {
+  std::vector<Packet> trace = KeepAliveTrace();
+  SimResult table = Replay(trace, false);
+  SimResult adaptive = Replay(trace, true);
+  Report("keep-alives", table, adaptive);
+
+  EXPECT_LT(adaptive.active_share * 3, table.active_share);
+  EXPECT_LE(adaptive.mean_latency_ms, table.mean_latency_ms * 1.1);
+}
+
+TEST(PmTrafficPolicyTest, transfers_stay_close_to_the_table) {
+  std::vector<Packet> trace = TransferTrace();
+  SimResult table = Replay(trace, false);
+  SimResult adaptive = Replay(trace, true);
+  Report("transfers", table, adaptive);
+
+  // Waking the link when a transfer starts costs a little active time.
+  EXPECT_LE(adaptive.active_share, table.active_share * 1.05);
+  EXPECT_LE(adaptive.mean_latency_ms, table.mean_latency_ms);
+  EXPECT_LE(adaptive.p95_latency_ms, table.p95_latency_ms);
+}
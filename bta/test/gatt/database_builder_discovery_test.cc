@@ -0,0 +1,507 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "gatt/database_builder.h"
+
+using bluetooth::Uuid;
+
+namespace gatt {
+
+namespace {
+constexpr std::pair<uint16_t, uint16_t> EXPLORE_END =
+    DatabaseBuilder::EXPLORE_END;
+
+/* Full strings, not Uuid::From16Bit(), which needs Uuid::kBase initialized */
+Uuid PRIMARY_SERVICE = Uuid::FromString("00002800-0000-1000-8000-00805f9b34fb");
+Uuid SECONDARY_SERVICE =
+    Uuid::FromString("00002801-0000-1000-8000-00805f9b34fb");
+Uuid INCLUDE = Uuid::FromString("00002802-0000-1000-8000-00805f9b34fb");
+Uuid CHARACTERISTIC = Uuid::FromString("00002803-0000-1000-8000-00805f9b34fb");
+Uuid CCCD = Uuid::FromString("00002902-0000-1000-8000-00805f9b34fb");
+Uuid CHARACTERISTIC_EXTENDED_PROPERTIES =
+    Uuid::FromString("00002900-0000-1000-8000-00805f9b34fb");
+
+/* Round trip of a request and its response, at a 15 ms connection interval */
+const double kRoundTripMs = 30;
+
+inline std::pair<uint16_t, uint16_t> make_pair_u16(uint16_t first,
+                                                   uint16_t second) {
+  return std::make_pair(first, second);
+}
+
+size_t UuidLength(const Uuid& uuid) {
+  return uuid.GetShortestRepresentationSize() == Uuid::kNumBytes16
+             ? Uuid::kNumBytes16
+             : Uuid::kNumBytes128;
+}
+
+/* An attribute of the peer's database */
+struct Attribute {
+  uint16_t handle;
+  Uuid type;
+  Uuid uuid;           /* of a service, included service or characteristic */
+  uint16_t start = 0;  /* of an included service */
+  uint16_t end = 0;    /* of a service or included service */
+  uint16_t value_handle = 0;
+  uint8_t properties = 0;
+  uint16_t value = 0; /* of «Characteristic Extended Properties» */
+};
+
+/* ATT server answering discovery requests from |database| the way the
+ * specification has it: responses hold as many entries of the same length
+ * as fit the MTU, and Attribute Not Found ends a search. */
+class SimulatedPeer {
+ public:
+  SimulatedPeer(const Database& database, uint16_t mtu) : mtu_(mtu) {
+    for (const Service& service : database.Services()) {
+      attributes_.push_back(
+          {.handle = service.handle,
+           .type = service.is_primary ? PRIMARY_SERVICE : SECONDARY_SERVICE,
+           .uuid = service.uuid,
+           .end = service.end_handle});
+      for (const IncludedService& is : service.included_services) {
+        attributes_.push_back({.handle = is.handle,
+                               .type = INCLUDE,
+                               .uuid = is.uuid,
+                               .start = is.start_handle,
+                               .end = is.end_handle});
+      }
+      for (const Characteristic& charac : service.characteristics) {
+        attributes_.push_back({.handle = charac.declaration_handle,
+                               .type = CHARACTERISTIC,
+                               .uuid = charac.uuid,
+                               .value_handle = charac.value_handle,
+                               .properties = charac.properties});
+        attributes_.push_back(
+            {.handle = charac.value_handle, .type = charac.uuid});
+        for (const Descriptor& desc : charac.descriptors) {
+          attributes_.push_back(
+              {.handle = desc.handle,
+               .type = desc.uuid,
+               .value = desc.characteristic_extended_properties});
+        }
+      }
+    }
+    std::sort(attributes_.begin(), attributes_.end(),
+              [](const Attribute& a, const Attribute& b) {
+                return a.handle < b.handle;
+              });
+  }
+
+  /* Read By Group Type Request for primary services */
+  std::vector<const Attribute*> ReadByGroupType(uint16_t start, uint16_t end) {
+    return Respond(start, end, [](const Attribute& attr) -> size_t {
+      return attr.type == PRIMARY_SERVICE ? 4 + UuidLength(attr.uuid) : 0;
+    });
+  }
+
+  /* Read By Type Request for included services or characteristics */
+  std::vector<const Attribute*> ReadByType(uint16_t start, uint16_t end,
+                                           const Uuid& type) {
+    std::vector<const Attribute*> found =
+        Respond(start, end, [&type](const Attribute& attr) -> size_t {
+          if (attr.type != type) return 0;
+          if (type == CHARACTERISTIC) return 2 + 3 + UuidLength(attr.uuid);
+          /* 128-bit UUIDs of included services are left out */
+          return 2 + 4 + (UuidLength(attr.uuid) == 2 ? 2 : 0);
+        });
+
+    /* and the client reads each of them */
+    for (const Attribute* attr : found) {
+      if (attr->type == INCLUDE && UuidLength(attr->uuid) != 2) round_trips++;
+    }
+    return found;
+  }
+
+  /* Find Information Request */
+  std::vector<const Attribute*> FindInformation(uint16_t start,
+                                                uint16_t end) {
+    return Respond(start, end, [](const Attribute& attr) -> size_t {
+      return 2 + UuidLength(attr.type);
+    });
+  }
+
+  const Attribute* Find(uint16_t handle) const {
+    for (const Attribute& attr : attributes_) {
+      if (attr.handle == handle) return &attr;
+    }
+    return nullptr;
+  }
+
+  size_t round_trips = 0;
+
+ private:
+  /* Matching attributes in [start, end], all with the entry length of the
+   * first, while they fit; |entry_length| is 0 for attributes not matching */
+  template <typename EntryLength>
+  std::vector<const Attribute*> Respond(uint16_t start, uint16_t end,
+                                        EntryLength entry_length) {
+    round_trips++;
+    std::vector<const Attribute*> found;
+    size_t length = 0;
+    size_t used = 2;
+    for (const Attribute& attr : attributes_) {
+      if (attr.handle < start || attr.handle > end) continue;
+      size_t this_length = entry_length(attr);
+      if (this_length == 0) continue;
+      if (length == 0) length = this_length;
+      if (this_length != length || used + length > mtu_) break;
+      found.push_back(&attr);
+      used += length;
+    }
+    return found;
+  }
+
+  uint16_t mtu_;
+  std::vector<Attribute> attributes_;
+};
+
+/* Discovery procedures of the client stack */
+enum class Procedure {
+  kPrimaryServices,
+  kIncludedServices,
+  kCharacteristics,
+  kDescriptors
+};
+
+struct DiscoveryResult {
+  Database database;
+  size_t requests = 0;
+  size_t round_trips = 0;
+  double cpu_us = 0;
+};
+
+/* Discovers |peer| as bta_gattc_cache.cc does: primary services, then
+ * included services, characteristics and descriptors of each service, or of
+ * each batch. The client stack turns every discovery into requests that
+ * continue past the last handle found, until the end of the range or
+ * Attribute Not Found. */
+class Discovery {
+ public:
+  Discovery(SimulatedPeer& peer, uint16_t mtu, bool pipelined)
+      : peer_(peer), mtu_(mtu), pipelined_(pipelined) {}
+
+  DiscoveryResult Run() {
+    auto start = std::chrono::steady_clock::now();
+    Discover(Procedure::kPrimaryServices, HANDLE_MIN, HANDLE_MAX);
+
+    while (pipelined_ ? builder_.StartBatchExploration()
+                      : builder_.StartNextServiceExploration()) {
+      auto service = builder_.CurrentlyExploredService();
+      Discover(Procedure::kIncludedServices, service.first, service.second);
+      if (pipelined_) {
+        for (auto range = builder_.NextIncludedServiceRangeToExplore();
+             range != EXPLORE_END;
+             range = builder_.NextIncludedServiceRangeToExplore()) {
+          Discover(Procedure::kIncludedServices, range.first, range.second);
+        }
+        service = builder_.CurrentlyExploredService();
+      }
+
+      Discover(Procedure::kCharacteristics, service.first, service.second);
+
+      for (auto range = NextDescriptorRange(); range != EXPLORE_END;
+           range = NextDescriptorRange()) {
+        Discover(Procedure::kDescriptors, range.first, range.second);
+      }
+    }
+
+    // Values of «Characteristic Extended Properties», read alike either way
+    std::vector<uint16_t> values;
+    for (uint16_t handle : builder_.DescriptorHandlesToRead())
+      values.push_back(peer_.Find(handle)->value);
+    EXPECT_TRUE(builder_.SetValueOfDescriptors(values));
+
+    DiscoveryResult result;
+    result.database = builder_.Build();
+    result.requests = requests_;
+    result.round_trips = peer_.round_trips;
+    result.cpu_us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    return result;
+  }
+
+ private:
+  std::pair<uint16_t, uint16_t> NextDescriptorRange() {
+    if (!pipelined_) return builder_.NextDescriptorRangeToExplore();
+    return builder_.NextDescriptorRangeToExplore((mtu_ - 2) / 4);
+  }
+
+  void Discover(Procedure procedure, uint16_t start, uint16_t end) {
+    requests_++;
+    while (start != 0 && start <= end) {
+      std::vector<const Attribute*> found;
+      if (procedure == Procedure::kPrimaryServices) {
+        found = peer_.ReadByGroupType(start, end);
+      } else if (procedure == Procedure::kIncludedServices) {
+        found = peer_.ReadByType(start, end, INCLUDE);
+      } else if (procedure == Procedure::kCharacteristics) {
+        found = peer_.ReadByType(start, end, CHARACTERISTIC);
+      } else {
+        found = peer_.FindInformation(start, end);
+      }
+      if (found.empty()) return;
+
+      for (const Attribute* attr : found) {
+        if (procedure == Procedure::kPrimaryServices) {
+          builder_.AddService(attr->handle, attr->end, attr->uuid, true);
+        } else if (procedure == Procedure::kIncludedServices) {
+          builder_.AddIncludedService(attr->handle, attr->uuid, attr->start,
+                                      attr->end);
+        } else if (procedure == Procedure::kCharacteristics) {
+          builder_.AddCharacteristic(attr->handle, attr->value_handle,
+                                     attr->uuid, attr->properties);
+        } else {
+          builder_.AddDescriptor(attr->handle, attr->type);
+        }
+      }
+      start = found.back()->handle + 1;
+    }
+  }
+
+  SimulatedPeer& peer_;
+  uint16_t mtu_;
+  bool pipelined_;
+  DatabaseBuilder builder_;
+  size_t requests_ = 0;
+};
+
+DiscoveryResult Discover(const Database& peer_database, uint16_t mtu,
+                         bool pipelined) {
+  SimulatedPeer peer(peer_database, mtu);
+  return Discovery(peer, mtu, pipelined).Run();
+}
+
+/* Database contents, «Characteristic Extended Properties» values included */
+std::string Dump(const Database& database) {
+  std::stringstream dump;
+  dump << database.ToString();
+  for (const Service& service : database.Services()) {
+    dump << service.handle << (service.is_primary ? " primary\n" : "\n");
+    for (const Characteristic& charac : service.characteristics) {
+      for (const Descriptor& desc : charac.descriptors) {
+        if (desc.uuid == CHARACTERISTIC_EXTENDED_PROPERTIES)
+          dump << desc.handle << "=" << desc.characteristic_extended_properties
+               << "\n";
+      }
+    }
+  }
+  return dump.str();
+}
+
+Uuid RandomUuid(std::mt19937& rng) {
+  if (rng() % 3) return Uuid::From16Bit(0x2a00 + rng() % 0x100);
+  Uuid::UUID128Bit bytes;
+  for (uint8_t& byte : bytes) byte = rng();
+  return Uuid::From128BitBE(bytes);
+}
+
+/* A peer database of primary and secondary services in random handle order,
+ * every secondary service included from a primary service or from a
+ * secondary service included before it. Characteristics have up to three
+ * descriptors, and services may leave handles unused. */
+Database RandomDatabase(std::mt19937& rng, size_t num_services,
+                        size_t max_characteristics) {
+  struct Plan {
+    bool is_primary;
+    Uuid uuid;
+    std::vector<size_t> includes;
+    uint16_t handle;
+    uint16_t end_handle;
+  };
+  std::vector<Plan> plans(num_services);
+  for (size_t i = 0; i < num_services; i++) {
+    plans[i].is_primary = (i == 0) || rng() % 4;
+    plans[i].uuid = RandomUuid(rng);
+  }
+  std::vector<size_t> reached;
+  for (size_t i = 0; i < num_services; i++) {
+    if (plans[i].is_primary) reached.push_back(i);
+  }
+  for (size_t i = 0; i < num_services; i++) {
+    if (plans[i].is_primary) continue;
+    plans[reached[rng() % reached.size()]].includes.push_back(i);
+    reached.push_back(i);
+  }
+
+  // Lay services out in random order, with their contents
+  std::vector<size_t> order(num_services);
+  for (size_t i = 0; i < num_services; i++) order[i] = i;
+  std::shuffle(order.begin(), order.end(), rng);
+
+  struct Content {
+    uint16_t handle;
+    int kind; /* 0 characteristic, 1 descriptor */
+    Uuid uuid;
+    uint16_t value;
+  };
+  std::vector<std::vector<Content>> contents(num_services);
+  uint16_t handle = HANDLE_MIN + rng() % 3;
+  for (size_t i : order) {
+    Plan& plan = plans[i];
+    plan.handle = handle++;
+    handle += plan.includes.size();
+    size_t characteristics = rng() % (max_characteristics + 1);
+    for (size_t c = 0; c < characteristics; c++) {
+      contents[i].push_back({handle, 0, RandomUuid(rng), 0});
+      handle += 2;
+      size_t descriptors = rng() % 4;
+      for (size_t d = 0; d < descriptors; d++) {
+        Uuid uuid = (d == 0) ? CCCD
+                             : (rng() % 2 ? CHARACTERISTIC_EXTENDED_PROPERTIES
+                                          : RandomUuid(rng));
+        contents[i].push_back({handle++, 1, uuid, (uint16_t)(rng() % 4)});
+      }
+    }
+    plan.end_handle = handle - 1 + rng() % 3;
+    handle = plan.end_handle + 1 + rng() % 3;
+  }
+
+  DatabaseBuilder builder;
+  for (const Plan& plan : plans) {
+    builder.AddService(plan.handle, plan.end_handle, plan.uuid,
+                       plan.is_primary);
+  }
+  std::map<uint16_t, uint16_t> values;
+  for (size_t i = 0; i < num_services; i++) {
+    uint16_t include_handle = plans[i].handle + 1;
+    for (size_t included : plans[i].includes) {
+      builder.AddIncludedService(include_handle++, plans[included].uuid,
+                                 plans[included].handle,
+                                 plans[included].end_handle);
+    }
+    for (const Content& content : contents[i]) {
+      if (content.kind == 0) {
+        builder.AddCharacteristic(content.handle, content.handle + 1,
+                                  content.uuid, rng() % 0x100);
+      } else {
+        builder.AddDescriptor(content.handle, content.uuid);
+        if (content.uuid == CHARACTERISTIC_EXTENDED_PROPERTIES)
+          values[content.handle] = content.value;
+      }
+    }
+  }
+  std::vector<uint16_t> ordered_values;
+  for (uint16_t handle : builder.DescriptorHandlesToRead())
+    ordered_values.push_back(values[handle]);
+  EXPECT_TRUE(builder.SetValueOfDescriptors(ordered_values));
+  return builder.Build();
+}
+}  // namespace
+
+/* This test makes sure batch exploration spans all services, lets services
+ * revealed by included services join, and merges descriptor ranges. */
+TEST(DatabaseBuilderDiscoveryTest, BatchExplorationTest) {
+  DatabaseBuilder builder;
+  EXPECT_FALSE(builder.StartBatchExploration());
+
+  builder.AddService(0x0001, 0x0001, PRIMARY_SERVICE, true);
+  builder.AddService(0x0010, 0x001f, PRIMARY_SERVICE, true);
+  builder.AddService(0x0030, 0x003f, PRIMARY_SERVICE, true);
+
+  // Empty first service left out of the span
+  EXPECT_TRUE(builder.StartBatchExploration());
+  EXPECT_TRUE(builder.InBatchExploration());
+  EXPECT_EQ(builder.CurrentlyExploredService(), make_pair_u16(0x0010, 0x003f));
+
+  builder.AddIncludedService(0x0031, CCCD, 0x0040, 0x004f);
+  builder.AddIncludedService(0x0011, CCCD, 0x0020, 0x0022);
+  EXPECT_EQ(builder.NextIncludedServiceRangeToExplore(),
+            make_pair_u16(0x0020, 0x004f));
+  EXPECT_EQ(builder.CurrentlyExploredService(), make_pair_u16(0x0010, 0x004f));
+
+  // Found again by the wider search, kept once
+  builder.AddIncludedService(0x0031, CCCD, 0x0040, 0x004f);
+  EXPECT_EQ(builder.NextIncludedServiceRangeToExplore(), EXPLORE_END);
+
+  builder.AddCharacteristic(0x0012, 0x0013, CCCD, 0x10);
+  builder.AddCharacteristic(0x0016, 0x0017, CCCD, 0x10);
+  builder.AddCharacteristic(0x0018, 0x0019, CCCD, 0x10);
+  builder.AddCharacteristic(0x0021, 0x0022, CCCD, 0x10);
+  builder.AddCharacteristic(0x0032, 0x0033, CCCD, 0x10);
+
+  // 0x0014-0x0015 and 0x001a-0x001f merged, 0x0034-0x003f too far
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(12),
+            make_pair_u16(0x0014, 0x001f));
+  // Declaration and value of the characteristic in between are no descriptors
+  builder.AddDescriptor(0x0014, CCCD);
+  builder.AddDescriptor(0x0015, CCCD);
+  builder.AddDescriptor(0x0016, CHARACTERISTIC);
+  builder.AddDescriptor(0x0017, CCCD);
+  builder.AddDescriptor(0x001a, CCCD);
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(12),
+            make_pair_u16(0x0034, 0x003f));
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(12), EXPLORE_END);
+
+  EXPECT_FALSE(builder.StartBatchExploration());
+  EXPECT_FALSE(builder.InBatchExploration());
+
+  Database result = builder.Build();
+  const Service& service = result.Services()[1];
+  ASSERT_EQ(service.characteristics.size(), 3u);
+  EXPECT_EQ(service.characteristics[0].descriptors.size(), 2u);
+  EXPECT_EQ(service.characteristics[1].descriptors.size(), 0u);
+  EXPECT_EQ(service.characteristics[2].descriptors.size(), 1u);
+  EXPECT_EQ(result.Services()[3].included_services.size(), 1u);
+}
+
+/* This test makes sure batch exploration of random peers builds the same
+ * database as exploring their services one by one, at any MTU, and never
+ * takes more round trips. */
+TEST(DatabaseBuilderDiscoveryTest, SameDatabaseAsServiceByServiceTest) {
+  std::mt19937 rng(42);
+  for (int i = 0; i < 300; i++) {
+    Database peer = RandomDatabase(rng, 1 + rng() % 12, 8);
+    for (uint16_t mtu : {23, 64, 517}) {
+      DiscoveryResult legacy = Discover(peer, mtu, false);
+      DiscoveryResult pipelined = Discover(peer, mtu, true);
+
+      ASSERT_EQ(Dump(peer), Dump(legacy.database)) << i << " mtu " << mtu;
+      ASSERT_EQ(Dump(legacy.database), Dump(pipelined.database))
+          << i << " mtu " << mtu;
+      ASSERT_LE(pipelined.round_trips, legacy.round_trips)
+          << i << " mtu " << mtu;
+    }
+  }
+}
+
+/* Round trips and discovery time of a device with many services, explored
+ * service by service and in batches. */
+TEST(DatabaseBuilderDiscoveryTest, DiscoveryTimeBenchmark) {
+  std::mt19937 rng(42);
+  Database peer = RandomDatabase(rng, 40, 12);
+  size_t attributes = peer.Serialize().size();
+
+  for (uint16_t mtu : {23, 247, 517}) {
+    DiscoveryResult legacy = Discover(peer, mtu, false);
+    DiscoveryResult pipelined = Discover(peer, mtu, true);
+    EXPECT_EQ(Dump(legacy.database), Dump(pipelined.database));
+    EXPECT_LT(pipelined.round_trips, legacy.round_trips);
+
+    printf(
+        "%zu services, %zu attributes, MTU %3u: service by service %zu "
+        "round trips (%.2f s), batch %zu (%.2f s); cpu %.0f us vs %.0f us\n",
+        peer.Services().size(), attributes, mtu, legacy.round_trips,
+        legacy.round_trips * kRoundTripMs / 1000, pipelined.round_trips,
+        pipelined.round_trips * kRoundTripMs / 1000, legacy.cpu_us,
+        pipelined.cpu_us);
+  }
+}
+
+}  // namespace gatt
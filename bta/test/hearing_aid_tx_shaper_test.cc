@@ -0,0 +1,338 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <deque>
+#include <random>
+#include <set>
+
+#include "hearing_aid/hearing_aid_tx_shaper.h"
+
+namespace {
+
+using Decision = HearingAidTxShaper::Decision;
+using Queue = HearingAidTxShaper::Queue;
+
+const HearingAidTxShaper::Config kConfig = {20, 60};
+
+Decision ShapeLeft(HearingAidTxShaper& shaper, uint16_t queued) {
+  Queue queues[2] = {{true, queued}, {false, 0}};
+  return shaper.Shape(queues, 1);
+}
+
+}  // namespace
+
+TEST(HearingAidTxShaperTest, budget_in_frames) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  EXPECT_EQ(3u, shaper.BudgetFrames());
+  shaper.Reset({10, 60});
+  EXPECT_EQ(6u, shaper.BudgetFrames());
+  shaper.Reset({20, 10});
+  EXPECT_EQ(1u, shaper.BudgetFrames());
+}
+
+TEST(HearingAidTxShaperTest, link_that_keeps_up_flushes_nothing) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  for (int i = 0; i < 1000; i++) {
+    Decision decision = ShapeLeft(shaper, 0);
+    EXPECT_EQ(0, decision.flush_packets[0]);
+    EXPECT_FALSE(decision.step_down);
+    shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+  }
+  EXPECT_EQ(256u, shaper.TxRate(HearingAidTxShaper::kLeft));
+  EXPECT_EQ(0u, shaper.DroppedFrames(HearingAidTxShaper::kLeft));
+}
+
+TEST(HearingAidTxShaperTest, keeps_what_fits_the_budget) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  ShapeLeft(shaper, 0);
+  shaper.OnSent(HearingAidTxShaper::kLeft, 5);
+
+  // One packet went out: the link still sends about a frame per interval, so
+  // two queued frames go out in time in front of the new one.
+  Decision decision = ShapeLeft(shaper, 4);
+  EXPECT_EQ(2, decision.flush_packets[0]);
+  EXPECT_EQ(2, decision.flush_frames[0]);
+  EXPECT_EQ(0, decision.flush_packets[1]);
+  EXPECT_EQ(2u, shaper.DroppedFrames(HearingAidTxShaper::kLeft));
+}
+
+TEST(HearingAidTxShaperTest, exhausted_credits_flush_everything) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  ShapeLeft(shaper, 0);
+  shaper.OnCredits(HearingAidTxShaper::kLeft, 0, 0);
+  shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+
+  // No credits and none coming back: the queued frames cannot go out.
+  uint16_t flushed = 0;
+  for (int i = 0; i < 20; i++) {
+    Decision decision = ShapeLeft(shaper, 1);
+    flushed += decision.flush_packets[0];
+    shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+  }
+  EXPECT_EQ(0, shaper.Credits(HearingAidTxShaper::kLeft));
+  EXPECT_GE(flushed, 15);
+  EXPECT_EQ(1, ShapeLeft(shaper, 1).flush_packets[0]);
+}
+
+TEST(HearingAidTxShaperTest, returned_credits_restore_the_budget) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  ShapeLeft(shaper, 0);
+  shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+  shaper.OnCredits(HearingAidTxShaper::kLeft, 8, 8);
+
+  // The link keeps up and the credits come back as they are used.
+  for (int i = 0; i < 20; i++) {
+    shaper.OnCredits(HearingAidTxShaper::kLeft, 1, 8);
+    EXPECT_EQ(0, ShapeLeft(shaper, 0).flush_packets[0]);
+    shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+  }
+  EXPECT_EQ(8, shaper.Credits(HearingAidTxShaper::kLeft));
+
+  // A burst of three frames, one of which went out, fits the budget.
+  shaper.OnSent(HearingAidTxShaper::kLeft, 2);
+  shaper.OnCredits(HearingAidTxShaper::kLeft, 1, 8);
+  Decision decision = ShapeLeft(shaper, 2);
+  EXPECT_EQ(0, decision.flush_packets[0]);
+}
+
+TEST(HearingAidTxShaperTest, sides_flush_to_the_same_frame) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  Queue start[2] = {{true, 0}, {true, 0}};
+  shaper.Shape(start, 1);
+  shaper.OnSent(HearingAidTxShaper::kLeft, 3);
+  shaper.OnSent(HearingAidTxShaper::kRight, 4);
+  shaper.OnCredits(HearingAidTxShaper::kRight, 0, 0);
+
+  // The left side could keep its two frames; the right one sent nothing and
+  // is out of credits, it keeps one, so the left one keeps the same one.
+  Queue queues[2] = {{true, 2}, {true, 4}};
+  Decision decision = shaper.Shape(queues, 1);
+  EXPECT_EQ(1, decision.flush_packets[0]);
+  EXPECT_EQ(3, decision.flush_packets[1]);
+
+  // A side with less queued than the other keeps is left alone.
+  shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+  shaper.OnSent(HearingAidTxShaper::kRight, 1);
+  shaper.OnCredits(HearingAidTxShaper::kRight, 8, 8);
+  Queue next[2] = {{true, 0}, {true, 1}};
+  decision = shaper.Shape(next, 1);
+  EXPECT_EQ(0, decision.flush_packets[0]);
+  EXPECT_EQ(0, decision.flush_packets[1]);
+}
+
+TEST(HearingAidTxShaperTest, sustained_congestion_steps_down_once) {
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  ShapeLeft(shaper, 0);
+  shaper.OnCredits(HearingAidTxShaper::kLeft, 0, 0);
+  shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+
+  int step_downs = 0;
+  int frame = 0;
+  for (; frame < 5 * (int)HearingAidTxShaper::kWindowFrames; frame++) {
+    if (ShapeLeft(shaper, 1).step_down) {
+      step_downs++;
+      EXPECT_EQ(HearingAidTxShaper::kStepDownWindows *
+                        HearingAidTxShaper::kWindowFrames -
+                    2,
+                (uint32_t)frame);
+    }
+    shaper.OnSent(HearingAidTxShaper::kLeft, 1);
+  }
+  EXPECT_EQ(1, step_downs);
+  EXPECT_TRUE(shaper.SteppedDown());
+
+  shaper.Reset(kConfig);
+  EXPECT_FALSE(shaper.SteppedDown());
+}
+
+namespace {
+
+// One hearing aid: the audio queued in L2CAP, the LE CoC credits and a link
+// that sends up to |per_event| packets per connection event.
+struct Ear {
+  struct Frame {
+    int seq;
+    int queued_at;
+  };
+  std::deque<Frame> queue;
+  uint32_t credits = 8;
+  uint32_t used = 0;
+  uint32_t hold_until = 0;
+  std::set<int> dropped;
+  int delivered = 0;
+  int late = 0;
+  int max_latency = 0;
+};
+
+struct EarProfile {
+  uint32_t per_event;
+  // Chance of a connection event lost to interference, out of 100.
+  uint32_t lost_event;
+  // The hearing aid returns the used credits every |return_every| events,
+  // and with a chance out of 1000 per event holds them for a while.
+  uint32_t return_every;
+  uint32_t hold_chance;
+  uint32_t hold_min;
+  uint32_t hold_max;
+};
+
+struct SimResult {
+  int dropped[2];
+  int delivered[2];
+  int late[2];
+  int max_latency[2];
+  bool aligned;
+};
+
+const int kSimFrames = 50 * 60 * 5;
+
+// Streams kSimFrames frames of one packet to both ears, one per connection
+// interval, flushing the queues as the legacy code does or with the shaper.
+SimResult Simulate(const EarProfile (&profiles)[2], bool shaped,
+                   uint32_t seed) {
+  std::mt19937 rng(seed);
+  HearingAidTxShaper shaper;
+  shaper.Reset(kConfig);
+  Ear ears[2];
+  bool aligned = true;
+
+  for (int t = 0; t < kSimFrames; t++) {
+    Queue queues[2];
+    for (int i = 0; i < 2; i++)
+      queues[i] = {true, (uint16_t)ears[i].queue.size()};
+    Decision decision = {};
+    if (shaped) {
+      decision = shaper.Shape(queues, 1);
+    } else {
+      for (int i = 0; i < 2; i++) decision.flush_packets[i] = queues[i].packets;
+    }
+    // When both ears flush, they keep the same frames.
+    if (decision.flush_packets[0] && decision.flush_packets[1] &&
+        queues[0].packets - decision.flush_packets[0] !=
+            queues[1].packets - decision.flush_packets[1])
+      aligned = false;
+    for (int i = 0; i < 2; i++) {
+      Ear& ear = ears[i];
+      for (int n = 0; n < decision.flush_packets[i]; n++) {
+        ear.dropped.insert(ear.queue.front().seq);
+        ear.queue.pop_front();
+      }
+      ear.queue.push_back({t, t});
+      if (shaped) shaper.OnSent((HearingAidTxShaper::Side)i, 1);
+    }
+
+    for (int i = 0; i < 2; i++) {
+      Ear& ear = ears[i];
+      const EarProfile& profile = profiles[i];
+      uint32_t budget = rng() % 100 < profile.lost_event ? 0 : profile.per_event;
+      while (budget > 0 && ear.credits > 0 && !ear.queue.empty()) {
+        int latency = t - ear.queue.front().queued_at + 1;
+        ear.max_latency = std::max(ear.max_latency, latency);
+        if (latency > (int)shaper.BudgetFrames()) ear.late++;
+        ear.delivered++;
+        ear.queue.pop_front();
+        ear.credits--;
+        ear.used++;
+        budget--;
+      }
+
+      if ((uint32_t)t >= ear.hold_until && rng() % 1000 < profile.hold_chance)
+        ear.hold_until =
+            t + profile.hold_min +
+            rng() % (profile.hold_max - profile.hold_min + 1);
+      if ((uint32_t)t >= ear.hold_until && t % profile.return_every == 0 &&
+          ear.used > 0) {
+        ear.credits += ear.used;
+        if (shaped)
+          shaper.OnCredits((HearingAidTxShaper::Side)i, ear.used,
+                           ear.credits);
+        ear.used = 0;
+      }
+    }
+  }
+
+  SimResult result;
+  for (int i = 0; i < 2; i++) {
+    result.dropped[i] = ears[i].dropped.size();
+    result.delivered[i] = ears[i].delivered;
+    result.late[i] = ears[i].late;
+    result.max_latency[i] = ears[i].max_latency;
+  }
+  result.aligned = aligned;
+  return result;
+}
+
+void Report(const char* name, const SimResult& legacy,
+            const SimResult& shaped) {
+  printf("%s (%d frames per ear)\n", name, kSimFrames);
+  const char* labels[2] = {"legacy:", "shaped:"};
+  const SimResult* results[2] = {&legacy, &shaped};
+  for (int r = 0; r < 2; r++) {
+    const SimResult& result = *results[r];
+    printf(
+        "  %-8s left %5d dropped %5d late, right %5d dropped %5d late, "
+        "max latency %d/%d intervals\n",
+        labels[r], result.dropped[0], result.late[0], result.dropped[1],
+        result.late[1], result.max_latency[0], result.max_latency[1]);
+  }
+}
+
+}  // namespace
+
+TEST(HearingAidTxShaperTest, credit_starvation_drops_fewer_frames) {
+  // Both ears return their credits every other event and now and then hold
+  // them for 2 to 8 events; the right one holds them more often.
+  const EarProfile profiles[2] = {{2, 2, 2, 10, 2, 8}, {2, 2, 2, 40, 2, 8}};
+  SimResult legacy = Simulate(profiles, false, 47);
+  SimResult shaped = Simulate(profiles, true, 47);
+  Report("credit starvation", legacy, shaped);
+
+  for (int i = 0; i < 2; i++) {
+    EXPECT_LT(shaped.dropped[i] * 2, legacy.dropped[i]);
+    EXPECT_LT(shaped.late[i] * 100, kSimFrames);
+  }
+  EXPECT_TRUE(shaped.aligned);
+}
+
+TEST(HearingAidTxShaperTest, interference_drops_fewer_frames) {
+  // Credits come back every event, but connection events are lost to
+  // interference.
+  const EarProfile profiles[2] = {{2, 10, 1, 0, 1, 1}, {2, 25, 1, 0, 1, 1}};
+  SimResult legacy = Simulate(profiles, false, 48);
+  SimResult shaped = Simulate(profiles, true, 48);
+  Report("interference", legacy, shaped);
+
+  for (int i = 0; i < 2; i++) {
+    EXPECT_LT(shaped.dropped[i] * 2, legacy.dropped[i]);
+    EXPECT_LT(shaped.late[i] * 100, kSimFrames);
+  }
+  EXPECT_TRUE(shaped.aligned);
+}
+
+TEST(HearingAidTxShaperTest, dead_ear_flushes_like_legacy) {
+  // The right ear never returns its credits.
+  const EarProfile profiles[2] = {{2, 0, 1, 0, 1, 1}, {2, 0, 1, 1000, 5000,
+                                                       5000}};
+  SimResult legacy = Simulate(profiles, false, 49);
+  SimResult shaped = Simulate(profiles, true, 49);
+  Report("dead right ear", legacy, shaped);
+
+  EXPECT_EQ(0, shaped.late[1]);
+  EXPECT_EQ(0, shaped.late[0]);
+  EXPECT_LE(shaped.dropped[1], legacy.dropped[1]);
+}
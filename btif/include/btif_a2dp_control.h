@@ -57,4 +57,20 @@ void btif_a2dp_control_reset_audio_delay(int index);
 uint16_t btif_a2dp_control_get_audio_delay(int index);
 
 void btif_a2dp_pending_cmds_reset(void);
+
+// Returns true if the audio HAL delivers PCM through the shared memory ring
+// rather than the data socket.
+bool btif_a2dp_control_pcm_ring_is_active(void);
+
+// Reads up to |len| bytes of PCM from the shared memory ring into |p_buf|,
+// waiting a short while for more data if the ring runs empty. Once the audio
+// HAL closed the ring and it has been drained, this reports the data channel
+// as closed. Returns the number of bytes read.
+uint32_t btif_a2dp_control_pcm_ring_read(uint8_t* p_buf, uint32_t len);
+
+// Discards the PCM pending in the shared memory ring.
+void btif_a2dp_control_pcm_ring_flush(void);
+
+// Stops reading from the shared memory ring at the end of a stream.
+void btif_a2dp_control_pcm_ring_close(void);
 #endif /* BTIF_A2DP_CONTROL_H */
@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <mutex>
+
+/*******************************************************************************
+ *
+ * A2dpSinkJitterBuffer
+ *
+ * Adaptive playout control for the A2DP Sink media queue. Every received
+ * packet is timestamped on arrival and compared with its RTP timestamp, which
+ * gives the interarrival jitter (RFC 3550) and the spread of the transit time
+ * over the recent past. The playout delay follows that spread, between
+ * min_delay_us and max_delay_us:
+ *   - decoding starts once the queued media covers the playout delay,
+ *   - each media tick renders exactly the audio that elapsed since the last
+ *     tick and conceals what the queue cannot provide,
+ *   - media lost in the air (a gap in the RTP timestamps) is concealed and
+ *     packets arriving after their media was played are dropped,
+ *   - the queued media drifts towards the playout delay by dropping or
+ *     inserting one frame every few ticks.
+ * When the timestamps of a source do not count samples, loss and late
+ * detection are off and the sequence numbers pace the jitter estimate.
+ *
+ * Each tick starts with BeginTick() and then asks NextStep() what to do with
+ * the packet at the head of the queue until it returns kNone. OnPacket() is
+ * called from the stack thread, every other method from the A2DP Sink worker
+ * thread.
+ *
+ ******************************************************************************/
+class A2dpSinkJitterBuffer {
+ public:
+  struct Config {
+    uint32_t sample_rate = 44100;
+    uint32_t samples_per_frame = 128;
+    uint32_t tick_ms = 20;
+    uint64_t min_delay_us = 40000;
+    uint64_t max_delay_us = 300000;
+    /* Transit time spread assumed until the stream has been measured */
+    uint64_t initial_jitter_us = 60000;
+    /* Longest concealment before playback waits for the queue to refill */
+    uint64_t max_conceal_us = 200000;
+    /* Ticks between two frames dropped or inserted to move the delay */
+    uint32_t drift_ticks = 5;
+  };
+
+  enum class Action {
+    kNone,    /* the tick is done */
+    kDecode,  /* decode and render |frames| frames of the head packet */
+    kDiscard, /* decode |frames| frames of the head packet, do not render */
+    kConceal, /* render |frames| frames of concealment */
+  };
+
+  struct Step {
+    Action action;
+    uint32_t frames;
+  };
+
+  A2dpSinkJitterBuffer() = default;
+
+  void Reset(const Config& config);
+  /* The queue was flushed; the jitter estimate is kept */
+  void Flush();
+
+  /* Records a packet of |frames| frames that arrived at |now_us|. Returns
+   * false if its media was already played, the caller drops it then. */
+  bool OnPacket(uint64_t now_us, uint32_t rtp_timestamp, uint16_t seq,
+                uint32_t frames);
+  /* |frames| queued frames were dropped without going through NextStep() */
+  void OnDropped(uint32_t frames);
+
+  /* True once the queued media covers the playout delay */
+  bool IsReadyToStart();
+
+  void BeginTick(uint64_t now_us);
+  /* |head_timestamp| is the RTP timestamp of the first frame left in the
+   * head packet and |head_frames| the number of frames left in it, 0 if the
+   * queue is empty. The caller carries out the step, advances the head
+   * timestamp by the decoded or discarded frames and frees the packet when
+   * none are left. */
+  Step NextStep(uint32_t head_timestamp, uint32_t head_frames);
+
+  void DebugDump(int fd);
+
+  uint64_t GetPlayoutDelayUs();
+  uint64_t GetJitterUs();
+  uint64_t GetQueuedUs();
+  bool IsTimestampReliable();
+  uint32_t GetUnderruns();
+  uint32_t GetLateFrames();
+  uint32_t GetLostFrames();
+  uint32_t GetConcealedFrames();
+
+ private:
+  uint64_t FramesToUs(uint64_t frames) const;
+  uint64_t QueuedUsLocked() const;
+  void UpdateDelayLocked();
+  void ResetPlayoutLocked();
+
+  std::mutex mutex_;
+  Config config_;
+
+  /* Arrival statistics */
+  bool have_packet_ = false;
+  uint16_t last_seq_ = 0;
+  uint32_t last_timestamp_ = 0;
+  uint32_t last_frames_ = 0;
+  int32_t timestamp_score_ = 0;
+  uint64_t media_samples_ = 0;
+  int64_t last_transit_us_ = 0;
+  int64_t base_transit_us_ = 0;
+  uint64_t jitter_x16_us_ = 0;
+  uint64_t spread_us_ = 0;
+  uint32_t packets_since_spread_ = 0;
+  uint64_t delay_us_ = 0;
+
+  /* Playout */
+  uint32_t queued_frames_ = 0;
+  bool started_ = false;
+  bool play_valid_ = false;
+  uint32_t play_timestamp_ = 0;
+  uint64_t last_tick_us_ = 0;
+  uint64_t budget_acc_ = 0;
+  uint32_t budget_ = 0;
+  bool drop_pending_ = false;
+  bool insert_pending_ = false;
+  uint32_t ticks_since_drift_ = 0;
+  bool underrun_in_tick_ = false;
+  uint64_t conceal_run_us_ = 0;
+
+  /* Counters */
+  uint32_t total_packets_ = 0;
+  uint32_t underruns_ = 0;
+  uint32_t rebuffers_ = 0;
+  uint32_t late_frames_ = 0;
+  uint32_t lost_frames_ = 0;
+  uint32_t concealed_frames_ = 0;
+  uint32_t drift_dropped_ = 0;
+  uint32_t drift_inserted_ = 0;
+  uint64_t max_delay_seen_us_ = 0;
+};
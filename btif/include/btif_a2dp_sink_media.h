@@ -0,0 +1,44 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bt_types.h"
+
+/* A media packet queued for the A2DP Sink decoder. The payload follows at
+ * |offset| bytes after the header. */
+typedef struct {
+  uint16_t num_frames_to_be_processed;
+  uint16_t len;
+  uint16_t offset;
+  uint16_t layer_specific;
+  uint32_t rtp_timestamp; /* of the first frame left in the packet */
+  uint64_t enque_ns;
+} tBT_SBC_HDR;
+
+/* Headroom a received packet needs to be queued in its own buffer */
+#define BTIF_A2DP_SINK_MEDIA_MIN_OFFSET (sizeof(tBT_SBC_HDR) - sizeof(BT_HDR))
+
+typedef struct {
+  uint64_t packets_moved;  /* queued in the buffer they were received in */
+  uint64_t packets_copied; /* copied to a new buffer, one allocation each */
+  uint64_t bytes_copied;
+} btif_a2dp_sink_media_stats_t;
+
+// Turns the media packet |p_pkt| received from AVDTP, with its media headers
+// already stripped, into a decoder queue entry of |num_frames| frames that
+// starts at |rtp_timestamp|. Takes ownership of |p_pkt|: when its headroom
+// has room for the queue header, the header is written over it and the
+// payload stays in place; otherwise the payload is copied to a new buffer and
+// |p_pkt| is freed. Everything in the headroom is overwritten.
+// |enque_ns| of the returned entry is left for the caller.
+tBT_SBC_HDR* btif_a2dp_sink_media_take(BT_HDR* p_pkt, uint16_t num_frames,
+                                       uint32_t rtp_timestamp);
+
+const btif_a2dp_sink_media_stats_t* btif_a2dp_sink_media_get_stats(void);
+void btif_a2dp_sink_media_reset_stats(void);
@@ -136,6 +136,8 @@ typedef struct {
   alarm_t *remote_start_alarm;
   const tA2DP_ENCODER_INTERFACE* encoder_interface;
   period_ms_t encoder_interval_ms; /* Local copy of the encoder interval */
+  bool adaptive_tx; /* Media tick driven by the link drain rate */
+  period_ms_t media_alarm_interval_ms; /* Current media tick period */
   btif_media_stats_t stats;
   btif_media_stats_t accumulated_stats;
   int last_remote_started_index;
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/*******************************************************************************
+ *
+ * A2dpSourceTxController
+ *
+ * Closed loop controller for the A2DP Source media tick. It estimates how fast
+ * the controller actually drains the A2DP ACL link (from Number Of Completed
+ * Packets) and how much encoded media is backed up in front of it (btif TX
+ * queue plus packets handed to L2CAP and not completed yet). From these it
+ * derives the queueing delay and, when the delay exceeds the target:
+ *   - shortens the media tick so that smaller batches are encoded more often,
+ *   - reports the real backlog as the transmit queue length, which drives
+ *     bitrate adaptation in codecs that support it (LDAC ABR),
+ *   - drops the oldest queued packets a few at a time instead of flushing
+ *     the whole queue on overflow.
+ *
+ * Nothing is treated as congestion until the first completions gave a drain
+ * rate.
+ *
+ * OnPacketsCompleted() and OnPacketDequeued() are called from the stack
+ * thread; every other method runs on the A2DP Source worker thread.
+ *
+ ******************************************************************************/
+class A2dpSourceTxController {
+ public:
+  struct Config {
+    uint32_t base_interval_ms = 20;
+    uint32_t min_interval_ms = 10;
+    uint64_t target_delay_us = 100000;
+    /* Congestion ends once the delay stayed below this for recover_ticks */
+    uint64_t low_delay_us = 40000;
+    uint32_t recover_ticks = 10;
+    /* Upper bound of packets dropped per tick while congested */
+    size_t max_drop_per_tick = 2;
+  };
+
+  struct Decision {
+    uint32_t interval_ms;
+    size_t drop_n;
+    size_t effective_queue_length;
+  };
+
+  A2dpSourceTxController() = default;
+
+  void Reset(const Config& config, uint64_t now_us);
+
+  /* ACL packets of the A2DP link completed by the controller */
+  void OnPacketsCompleted(uint16_t num_packets);
+  /* A media packet left the btif TX queue towards AVDTP/L2CAP */
+  void OnPacketDequeued();
+
+  /* Runs the control loop once per media tick. |queue_length| is the number
+   * of packets in the btif TX queue. */
+  Decision OnTick(uint64_t now_us, size_t queue_length);
+
+  /* Number of oldest packets to drop before enqueueing |frames_n| more frames
+   * into a queue holding |queue_length| packets with capacity |max_length|.
+   * Unlike the legacy overflow handling, only the excess is dropped. */
+  size_t GetOverflowDropCount(size_t queue_length, size_t frames_n,
+                              size_t max_length);
+
+  void OnPacketsDropped(size_t num_packets) { total_dropped_ += num_packets; }
+
+  void DebugDump(int fd) const;
+
+  bool IsCongested() const { return congested_; }
+  uint32_t GetIntervalMs() const { return interval_ms_; }
+  uint64_t GetDelayUs() const { return delay_us_; }
+  double GetDrainRatePps() const { return drain_rate_pps_; }
+  size_t GetInFlight() const { return in_flight_; }
+
+ private:
+  Config config_;
+
+  std::atomic<uint32_t> completed_{0};
+  std::atomic<uint32_t> dequeued_{0};
+
+  uint64_t last_tick_us_ = 0;
+  uint32_t last_completed_ = 0;
+  uint32_t last_dequeued_ = 0;
+  size_t in_flight_ = 0;
+  double drain_rate_pps_ = 0;
+  bool drain_rate_measured_ = false;
+  uint64_t delay_us_ = 0;
+  uint64_t max_delay_us_ = 0;
+
+  bool congested_ = false;
+  uint32_t calm_ticks_ = 0;
+  uint32_t interval_ms_ = 0;
+
+  size_t congestion_episodes_ = 0;
+  size_t total_dropped_ = 0;
+  size_t total_ticks_ = 0;
+  size_t congested_ticks_ = 0;
+};
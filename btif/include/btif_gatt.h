@@ -34,4 +34,8 @@ extern const btgatt_server_interface_t btgattServerInterface;
 
 BleAdvertiserInterface* get_ble_advertiser_instance();
 BleScannerInterface* get_ble_scanner_instance();
+
+/* Drops scan metadata cached for |bd_addr| after its storage entry was
+ * removed */
+void btif_ble_scanner_forget_device(const RawAddress& bd_addr);
 #endif
@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+#include "avrc_defs.h"
+
+/*******************************************************************************
+ *
+ * BtifRcBrowseCache
+ *
+ * Holds the most recently fetched window of a GetFolderItems listing (file
+ * system or now playing scope) for one AVRCP target connection. Items are kept
+ * in a compact table whose strings live in a single arena, so overlapping page
+ * requests from the remote can be answered without a round trip to the Java
+ * layer. The window is tied to the UID counter reported with the listing and
+ * is dropped on UIDs changed, path changes and player changes.
+ *
+ * The cache is not thread safe; btif_rc accesses it under btif_rc_cb.lock.
+ *
+ ******************************************************************************/
+class BtifRcBrowseCache {
+ public:
+  /* Attribute selection of a GetFolderItems command. num_attr follows the
+   * AVRCP encoding: 0x00 all attributes, 0xFF none, otherwise the number of
+   * entries in attr_ids. */
+  struct AttrSelection {
+    uint8_t num_attr = 0xFF;
+    std::vector<uint32_t> attr_ids;
+
+    bool operator==(const AttrSelection& rhs) const {
+      return num_attr == rhs.num_attr && attr_ids == rhs.attr_ids;
+    }
+    bool operator!=(const AttrSelection& rhs) const { return !(*this == rhs); }
+  };
+
+  struct Range {
+    uint8_t scope = 0;
+    uint32_t start_item = 0;
+    uint32_t end_item = 0;
+    AttrSelection attrs;
+  };
+
+  /* A GetFolderItems forwarded to the media player. The player response
+   * carries no range, so it is matched against the tag of the one request
+   * outstanding at the player. */
+  struct Request {
+    Range range;
+    bool prefetch = false;
+    /* Time the remote command (or the prefetch) was issued, for latency */
+    uint64_t start_us = 0;
+  };
+
+  struct Latency {
+    uint32_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+
+    void Add(uint64_t latency_us);
+    uint64_t MeanUs() const { return count ? total_us / count : 0; }
+  };
+
+  struct Stats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t prefetches = 0;
+    uint32_t prefetch_fills = 0;
+    uint32_t invalidations = 0;
+    uint32_t dropped_responses = 0;
+    uint32_t timeouts = 0;
+    /* Command to response, for pages served from the window and for pages
+     * that had to wait for the media player */
+    Latency hit_latency;
+    Latency miss_latency;
+  };
+
+  explicit BtifRcBrowseCache(size_t capacity = kDefaultCapacity);
+
+  /* Returns true if items of |scope| can be held by this cache */
+  static bool IsCacheableScope(uint8_t scope);
+
+  /* Only one GetFolderItems is forwarded to the media player at a time;
+   * returns true while one (remote or prefetch) is outstanding. */
+  bool IsRequestPending() const { return outstanding_valid_; }
+  bool IsPrefetchPending() const {
+    return outstanding_valid_ && outstanding_.prefetch;
+  }
+
+  /* Tags the remote GetFolderItems command just forwarded to the player */
+  void SetPendingRequest(const Range& range, uint64_t start_us);
+  /* Tags the prefetch just forwarded to the player */
+  void SetPrefetchPending(const Range& range, uint64_t start_us);
+
+  /* Queues a remote command that arrived while the player was busy. Deferred
+   * commands are forwarded, or served from the window, in arrival order. */
+  void DeferRequest(const Range& range, uint64_t start_us);
+  bool PopDeferredRequest(Request* p_request);
+
+  /* Takes the tag of the outstanding request on arrival of a player response.
+   * Returns false if nothing is outstanding, in which case the response does
+   * not belong to any request and must be dropped. */
+  bool CompleteRequest(Request* p_request);
+
+  /* Files the response to |request| into the window. Returns false, leaving
+   * the window untouched, if the response cannot be an answer to the tagged
+   * scope and range. A short response marks the end of the folder. */
+  bool Store(const Request& request, uint16_t uid_counter,
+             const tAVRC_ITEM* p_items, uint16_t num_items);
+
+  /* |request| failed, e.g. range out of bounds or player error */
+  void StoreError(const Request& request, tAVRC_STS status);
+
+  /* Looks up |range| in the window. On a hit |p_items| is filled with items
+   * whose strings point into the cache; they stay valid until the next
+   * non-const call. */
+  bool Lookup(const Range& range, uint16_t* p_uid_counter,
+              std::vector<tAVRC_ITEM>* p_items);
+
+  /* Returns the next page worth fetching ahead of the remote, based on the
+   * last range served. Returns false when no prefetch is needed. */
+  bool GetPrefetchRange(Range* p_range) const;
+
+  /* Drops the window if it was fetched with a different UID counter */
+  void OnUidCounterChanged(uint16_t uid_counter);
+  void InvalidateScope(uint8_t scope);
+  void Invalidate();
+
+  void RecordLatency(bool hit, uint64_t latency_us);
+  /* The player never answered a request, whose tag has been completed */
+  void RecordTimeout() { stats_.timeouts++; }
+
+  const Stats& GetStats() const { return stats_; }
+  size_t Size() const { return entries_.size(); }
+
+  static constexpr size_t kDefaultCapacity = 2048;
+
+ private:
+  struct AttrEntry {
+    uint32_t attr_id;
+    uint32_t str_offset;
+    uint16_t charset_id;
+    uint16_t str_len;
+  };
+
+  struct Entry {
+    uint8_t item_type;
+    uint8_t type;
+    uint8_t playable;
+    uint8_t attr_count;
+    tAVRC_UID uid;
+    uint16_t charset_id;
+    uint16_t name_len;
+    uint32_t name_offset;
+    uint32_t attr_first;
+  };
+
+  static bool MatchesRequest(const Range& range, const tAVRC_ITEM* p_items,
+                             uint16_t num_items);
+  void Reset(const Range& range, uint16_t uid_counter);
+  void Append(const tAVRC_ITEM& item);
+  uint32_t AddString(const uint8_t* p_str, uint16_t len);
+  void Compact(uint32_t new_base);
+  uint32_t WindowEnd() const { return base_ + entries_.size(); }
+
+  size_t capacity_;
+
+  bool valid_ = false;
+  uint8_t scope_ = 0;
+  uint16_t uid_counter_ = 0;
+  AttrSelection attrs_;
+  uint32_t base_ = 0;
+  bool end_of_folder_ = false;
+
+  std::vector<Entry> entries_;
+  std::vector<AttrEntry> attr_entries_;
+  std::vector<uint8_t> arena_;
+  std::vector<tAVRC_ATTR_ENTRY> attr_scratch_;
+
+  bool outstanding_valid_ = false;
+  Request outstanding_;
+  std::deque<Request> deferred_;
+  bool last_served_valid_ = false;
+  Range last_served_;
+
+  Stats stats_;
+};
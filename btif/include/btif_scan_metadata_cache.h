@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <unordered_map>
+
+#include "raw_address.h"
+
+/*******************************************************************************
+ *
+ * BtifScanMetadataCache
+ *
+ * Write-through cache of the device type and address type learnt from LE
+ * scan results. Each device is read from storage once when it is first seen.
+ * A result that changes the entry is written to storage right away, so
+ * readers of storage never see a stale type; results that change nothing are
+ * dropped without touching storage.
+ *
+ * The cache also remembers whether the name of a device was already reported
+ * in the current scan, replacing the separate address set used for that.
+ *
+ * The number of devices is bounded; the least recently seen one is evicted.
+ * The cache is not thread safe; btif_ble_scanner accesses it under its
+ * scan_metadata_lock.
+ *
+ ******************************************************************************/
+class BtifScanMetadataCache {
+ public:
+  /* Persistent store behind the cache, btif_storage in production */
+  class Storage {
+   public:
+    virtual ~Storage() = default;
+    virtual bool GetDeviceType(const RawAddress& bd_addr,
+                               uint32_t* dev_type) = 0;
+    virtual void SetDeviceType(const RawAddress& bd_addr,
+                               uint32_t dev_type) = 0;
+    virtual bool GetAddrType(const RawAddress& bd_addr,
+                             uint8_t* addr_type) = 0;
+    virtual void SetAddrType(const RawAddress& bd_addr, uint8_t addr_type) = 0;
+  };
+
+  struct Stats {
+    uint32_t updates = 0;
+    uint32_t unchanged = 0;  // updates that left the entry as it was
+    uint32_t loads = 0;
+    uint32_t writes = 0;
+    uint32_t evictions = 0;
+  };
+
+  static const size_t kDefaultCapacity = 1024;
+
+  explicit BtifScanMetadataCache(Storage* storage,
+                                 size_t capacity = kDefaultCapacity);
+
+  /* Records a scan result of |bd_addr|. Returns true if it changed the
+   * entry, which was then written to storage. */
+  bool Update(const RawAddress& bd_addr, uint32_t device_type,
+              uint8_t addr_type);
+
+  /* Returns true if the name of |bd_addr| was not reported since the last
+   * ResetReported(), and marks it reported. */
+  bool MarkReported(const RawAddress& bd_addr);
+
+  /* Starts a new scan: names are reported again */
+  void ResetReported();
+
+  /* The storage entry of |bd_addr| was removed elsewhere, e.g. on unbond.
+   * The device is read again when seen. */
+  void Forget(const RawAddress& bd_addr);
+
+  size_t size() const { return index_.size(); }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  static const uint8_t kUnknownAddrType = 0xFF;
+
+  struct Entry {
+    RawAddress bd_addr;
+    uint32_t dev_type;  // as stored
+    uint8_t addr_type;
+    bool loaded;
+    bool reported;
+  };
+
+  struct AddressHash {
+    size_t operator()(const RawAddress& bd_addr) const;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  Entry* Lookup(const RawAddress& bd_addr);
+  void Load(Entry* entry);
+  void WriteDeviceType(Entry* entry, uint32_t dev_type);
+
+  Storage* storage_;
+  const size_t capacity_;
+  /* Most recently seen first */
+  EntryList entries_;
+  std::unordered_map<RawAddress, EntryList::iterator, AddressHash> index_;
+  Stats stats_;
+};
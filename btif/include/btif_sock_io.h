@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "bt_types.h"
+
+/*******************************************************************************
+ *
+ * Vectored socket I/O on BT_HDR buffers
+ *
+ * Moves data between an app socket and the payload areas of stack buffers
+ * with one recvmsg or sendmsg per batch of buffers, instead of one syscall
+ * and a bounce buffer per buffer. Both calls are non-blocking.
+ *
+ ******************************************************************************/
+
+/* Most buffers moved by one call */
+#define BTSOCK_IO_MAX_BUFS 16
+
+/*******************************************************************************
+ *
+ * Function         btsock_recv_bufs
+ *
+ * Description      Receives data pending on |fd| into up to |count| buffers,
+ *                  each taking up to |max_len| bytes at its current offset.
+ *                  Buffers are filled in order; the len of each is set to
+ *                  the bytes it received, 0 for buffers past the data.
+ *
+ * Returns          Bytes received, 0 if no data is pending or the peer has
+ *                  closed the socket, -1 on socket error
+ *
+ ******************************************************************************/
+ssize_t btsock_recv_bufs(int fd, BT_HDR** bufs, size_t count,
+                         uint16_t max_len);
+
+/*******************************************************************************
+ *
+ * Function         btsock_send_bufs
+ *
+ * Description      Sends the payloads of up to |count| buffers to |fd|, in
+ *                  order, as far as the socket takes them. The offset and len
+ *                  of a buffer sent in part are advanced past the bytes sent.
+ *
+ * Returns          Number of buffers sent in full, -1 on socket error
+ *
+ ******************************************************************************/
+int btsock_send_bufs(int fd, BT_HDR** bufs, size_t count);
+
+/*******************************************************************************
+ *
+ * Function         btsock_send_packets
+ *
+ * Description      Sends the payloads of up to |count| buffers to the
+ *                  SOCK_SEQPACKET socket |fd|, one message per buffer, with
+ *                  a single sendmmsg. The offset and len of each buffer sent
+ *                  are advanced past the bytes sent.
+ *
+ * Returns          Number of buffers sent in full, -1 on socket error
+ *
+ ******************************************************************************/
+int btsock_send_packets(int fd, BT_HDR** bufs, size_t count);
+
+/*******************************************************************************
+ *
+ * Packet ring
+ *
+ * FIFO of received BT_HDRs waiting to be delivered to the app, holding the
+ * buffers from the lower layers as they are. The ring grows by doubling and
+ * is not shrunk until cleared, so a socket in steady state queues packets
+ * without allocating.
+ *
+ ******************************************************************************/
+typedef struct {
+  BT_HDR** bufs;
+  uint32_t capacity;
+  uint32_t head;
+  uint32_t count;
+  uint32_t bytes;  // payload bytes of all queued buffers
+} btsock_pkt_ring_t;
+
+/* Queues |p_buf| at the tail of |ring|, which takes ownership of it */
+void btsock_pkt_ring_push(btsock_pkt_ring_t* ring, BT_HDR* p_buf);
+
+/* Frees all queued buffers and the ring storage */
+void btsock_pkt_ring_clear(btsock_pkt_ring_t* ring);
+
+/*******************************************************************************
+ *
+ * Function         btsock_pkt_ring_send
+ *
+ * Description      Sends queued buffers to the SOCK_SEQPACKET socket |fd|, in
+ *                  batches of up to BTSOCK_IO_MAX_BUFS messages, until the
+ *                  ring is empty or the socket takes no more. Buffers sent
+ *                  are freed.
+ *
+ * Returns          1 if buffers are left because the socket is full, 0 if the
+ *                  ring is empty, -1 on socket error
+ *
+ ******************************************************************************/
+int btsock_pkt_ring_send(int fd, btsock_pkt_ring_t* ring);
@@ -87,6 +87,7 @@
 #include "common/address_obfuscator.h"
 #include "common/os_utils.h"
 #include "device/include/interop.h"
+#include "hci_layer.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/log.h"
@@ -437,6 +438,7 @@ static void dump(int fd, const char** arguments) {
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
   alarm_debug_dump(fd);
+  hci_layer_debug_dump(fd);
   HearingAid::DebugDump(fd);
   le_audio::has::HasClient::DebugDump(fd);
   connection_manager::dump(fd);
@@ -27,6 +27,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <memory>
+#include <mutex>
+
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
 #endif
@@ -40,6 +43,8 @@
 #include "btif_av_co.h"
 #include "btif_hf.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/shm_ring.h"
 #include "uipc.h"
 #include "btif_a2dp_audio_interface.h"
 
@@ -51,6 +56,9 @@
 #endif
 
 #define A2DP_DATA_READ_POLL_MS 10
+/* Let the audio HAL deliver PCM through a shared memory ring instead of the
+ * data socket */
+#define A2DP_PCM_RING_PROPERTY "persist.vendor.btstack.a2dp.pcm_ring"
 #define A2DP_NUM_STRS 5
 
 struct {
@@ -70,16 +78,28 @@ static void btif_a2dp_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_snd_ctrl_cmd(tA2DP_CTRL_CMD cmd);
 
-/* We can have max one command pending */
+/* We can have max one command pending. The control and data channels run
+ * on their own UIPC threads and the media task acks too, so the command
+ * state and the acks on the control socket are serialized by this mutex.
+ * It is recursive as acking a command may send the queued one. */
+static std::recursive_mutex a2dp_cmd_mutex;
 static tA2DP_CTRL_CMD a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
 static tA2DP_CTRL_CMD a2dp_cmd_queued = A2DP_CTRL_CMD_NONE;
 static char a2dp_hal_imp[PROPERTY_VALUE_MAX] = "false";
 
+/* PCM ring shared with the audio HAL. It stays mapped across streams and is
+ * only active between A2DP_CTRL_CMD_OPEN_PCM_RING and the end of the stream.
+ * Read from the media thread, opened and closed from the UIPC thread. The
+ * mutex guards the pointer and the flag only; the media thread waits for PCM
+ * on its own reference, so a ring being read is never reset or freed. */
+static std::mutex pcm_ring_mutex;
+static std::shared_ptr<shm_ring_t> pcm_ring;
+static bool pcm_ring_active = false;
+
 bool is_block_hal_start = false;
 
 void btif_a2dp_control_init(void) {
-  a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
-  a2dp_cmd_queued = A2DP_CTRL_CMD_NONE;
+  btif_a2dp_pending_cmds_reset();
   UIPC_Init(NULL);
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
   if (btif_device_in_sink_role()){
@@ -94,6 +114,124 @@ void btif_a2dp_control_init(void) {
 void btif_a2dp_control_cleanup(void) {
   /* This calls blocks until UIPC is fully closed */
   UIPC_Close(UIPC_CH_ID_ALL);
+
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  pcm_ring_active = false;
+  pcm_ring.reset();
+}
+
+/* Sets up the PCM ring for a new stream; the result is the ack to send to
+ * the audio HAL. */
+static tA2DP_CTRL_ACK btif_a2dp_control_prepare_pcm_ring(void) {
+  if (!osi_property_get_bool(A2DP_PCM_RING_PROPERTY, false)) {
+    APPL_TRACE_WARNING("%s: PCM ring is disabled", __func__);
+    return A2DP_CTRL_ACK_UNSUPPORTED;
+  }
+
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  pcm_ring_active = false;
+  /* A ring the media thread may still be reading from is left to it */
+  if (pcm_ring && pcm_ring.use_count() > 1) pcm_ring.reset();
+  if (!pcm_ring) {
+    shm_ring_t* ring =
+        shm_ring_new("bt_a2dp_pcm", AUDIO_STREAM_OUTPUT_BUFFER_SZ);
+    if (ring == NULL) {
+      APPL_TRACE_ERROR("%s: unable to create PCM ring", __func__);
+      return A2DP_CTRL_ACK_FAILURE;
+    }
+    pcm_ring.reset(ring, shm_ring_free);
+  }
+  shm_ring_reset(pcm_ring.get());
+  return A2DP_CTRL_ACK_SUCCESS;
+}
+
+/* Hands the PCM ring to the audio HAL, ahead of the ack. */
+static tA2DP_CTRL_ACK btif_a2dp_control_send_pcm_ring(void) {
+  std::shared_ptr<shm_ring_t> ring;
+  {
+    std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+    ring = pcm_ring;
+  }
+  if (!ring) return A2DP_CTRL_ACK_FAILURE;
+
+  uint32_t capacity = shm_ring_capacity(ring.get());
+  int fds[2] = {shm_ring_get_mem_fd(ring.get()),
+                shm_ring_get_event_fd(ring.get())};
+  if (!UIPC_SendFds(UIPC_CH_ID_AV_CTRL, reinterpret_cast<uint8_t*>(&capacity),
+                    sizeof(capacity), fds, 2)) {
+    APPL_TRACE_ERROR("%s: unable to send PCM ring to audio HAL", __func__);
+    return A2DP_CTRL_ACK_FAILURE;
+  }
+  return A2DP_CTRL_ACK_SUCCESS;
+}
+
+/* Once the command has been acked the media task reads from the ring as it
+ * would from a freshly opened data channel. */
+static void btif_a2dp_control_start_pcm_ring(void) {
+  uint32_t capacity;
+  {
+    std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+    if (!pcm_ring) return;
+    capacity = shm_ring_capacity(pcm_ring.get());
+    pcm_ring_active = true;
+  }
+  APPL_TRACE_IMP("%s: PCM ring of %u bytes active", __func__, capacity);
+  if (btif_av_get_peer_sep() == AVDT_TSEP_SNK) {
+    /* Start the media task to encode the audio */
+    btif_a2dp_source_start_audio_req();
+  }
+}
+
+/* The audio HAL went away without closing the PCM ring: handle it like the
+ * data socket being closed. */
+static void btif_a2dp_control_detach_pcm_ring(void) {
+  {
+    std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+    if (!pcm_ring_active) return;
+    pcm_ring_active = false;
+  }
+  btif_a2dp_data_cb(UIPC_CH_ID_AV_AUDIO, UIPC_CLOSE_EVT);
+}
+
+bool btif_a2dp_control_pcm_ring_is_active(void) {
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  return pcm_ring_active;
+}
+
+uint32_t btif_a2dp_control_pcm_ring_read(uint8_t* p_buf, uint32_t len) {
+  std::shared_ptr<shm_ring_t> ring;
+  {
+    std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+    if (!pcm_ring_active) return 0;
+    ring = pcm_ring;
+  }
+
+  uint32_t bytes_read =
+      shm_ring_read_wait(ring.get(), p_buf, len, A2DP_DATA_READ_POLL_MS);
+
+  {
+    std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+    /* Closed or replaced while waiting: the PCM belongs to an old stream */
+    if (!pcm_ring_active || ring != pcm_ring) return 0;
+    if (bytes_read == len || !shm_ring_is_writer_closed(ring.get()) ||
+        shm_ring_size(ring.get()) > 0)
+      return bytes_read;
+    pcm_ring_active = false;
+  }
+
+  /* Writer closed and ring drained, same as a hangup on the data socket */
+  btif_a2dp_data_cb(UIPC_CH_ID_AV_AUDIO, UIPC_CLOSE_EVT);
+  return bytes_read;
+}
+
+void btif_a2dp_control_pcm_ring_flush(void) {
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  if (pcm_ring_active) shm_ring_flush(pcm_ring.get());
+}
+
+void btif_a2dp_control_pcm_ring_close(void) {
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  pcm_ring_active = false;
 }
 
 static void btif_a2dp_recv_ctrl_data(void) {
@@ -109,9 +247,12 @@ static void btif_a2dp_recv_ctrl_data(void) {
   if (n == 0) {
     APPL_TRACE_WARNING("%s: CTRL CH DETACHED", __func__);
     UIPC_Close(UIPC_CH_ID_AV_CTRL);
+    btif_a2dp_control_detach_pcm_ring();
     return;
   }
 
+  std::lock_guard<std::recursive_mutex> lock(a2dp_cmd_mutex);
+
   APPL_TRACE_DEBUG("btif_a2dp_recv_ctrl_data: %s", audio_a2dp_hw_dump_ctrl_event(cmd));
 
   if (property_get("persist.vendor.bt.a2dp.hal.implementation", a2dp_hal_imp, "false") &&
@@ -305,6 +446,17 @@ static void btif_a2dp_recv_ctrl_data(void) {
         break;
       }
 
+      case A2DP_CTRL_CMD_OPEN_PCM_RING:
+        local_ack = btif_a2dp_control_prepare_pcm_ring();
+        /* The HAL receives the descriptors before the ack so that a failure
+         * to send them is reported rather than left for it to wait on */
+        if (local_ack == A2DP_CTRL_ACK_SUCCESS)
+          local_ack = btif_a2dp_control_send_pcm_ring();
+        UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &local_ack, sizeof(local_ack));
+        if (local_ack == A2DP_CTRL_ACK_SUCCESS)
+          btif_a2dp_control_start_pcm_ring();
+        break;
+
       default:
         if (a2dp_cmd_pending != A2DP_CTRL_CMD_NONE)
         {
@@ -659,6 +811,15 @@ static void btif_a2dp_recv_ctrl_data(void) {
         break;
       }
 
+      case A2DP_CTRL_CMD_OPEN_PCM_RING: {
+        tA2DP_CTRL_ACK status = btif_a2dp_control_prepare_pcm_ring();
+        if (status == A2DP_CTRL_ACK_SUCCESS)
+          status = btif_a2dp_control_send_pcm_ring();
+        btif_a2dp_command_ack(status);
+        if (status == A2DP_CTRL_ACK_SUCCESS) btif_a2dp_control_start_pcm_ring();
+        break;
+      }
+
       default:
         APPL_TRACE_ERROR("%s: UNSUPPORTED CMD (%d)", __func__, cmd);
         btif_a2dp_command_ack(A2DP_CTRL_ACK_FAILURE);
@@ -900,8 +1061,9 @@ static void btif_a2dp_data_cb(UNUSED_ATTR tUIPC_CH_ID ch_id,
       break;
     }
 
-    case UIPC_CLOSE_EVT:
+    case UIPC_CLOSE_EVT: {
       APPL_TRACE_EVENT("%s: ## AUDIO PATH DETACHED ##", __func__);
+      std::lock_guard<std::recursive_mutex> lock(a2dp_cmd_mutex);
 
       if (property_get("persist.vendor.bt.a2dp.hal.implementation", a2dp_hal_imp, "false") &&
             !strcmp(a2dp_hal_imp, "true")) {
@@ -934,6 +1096,7 @@ static void btif_a2dp_data_cb(UNUSED_ATTR tUIPC_CH_ID ch_id,
         }
       }
       break;
+    }
 
     default:
       APPL_TRACE_ERROR("%s: ### A2DP-DATA EVENT %d NOT HANDLED ###", __func__,
@@ -944,6 +1107,7 @@ static void btif_a2dp_data_cb(UNUSED_ATTR tUIPC_CH_ID ch_id,
 
 void btif_a2dp_command_ack(tA2DP_CTRL_ACK status) {
   uint8_t ack = status;
+  std::lock_guard<std::recursive_mutex> lock(a2dp_cmd_mutex);
 
   // Don't log A2DP_CTRL_GET_PRESENTATION_POSITION by default, because it
   // could be very chatty when audio is streaming.
@@ -1009,6 +1173,7 @@ void btif_a2dp_command_ack(tA2DP_CTRL_ACK status) {
   }
 }
 tA2DP_CTRL_CMD btif_a2dp_control_get_pending_command() {
+  std::lock_guard<std::recursive_mutex> lock(a2dp_cmd_mutex);
   return a2dp_cmd_pending;
 }
 
@@ -1039,6 +1204,7 @@ uint16_t btif_a2dp_control_get_audio_delay(int index) {
 }
 
 void btif_a2dp_pending_cmds_reset() {
+  std::lock_guard<std::recursive_mutex> lock(a2dp_cmd_mutex);
   a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
   a2dp_cmd_queued = A2DP_CTRL_CMD_NONE;
 }
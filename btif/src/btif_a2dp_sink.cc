@@ -31,10 +31,16 @@
 
 #include <string.h>
 
+#include <algorithm>
+
+#include "a2dp_sbc.h"
 #include "bt_common.h"
+#include "bta_av_api.h"
 #include "btif_a2dp.h"
 #include "btif_ahim.h"
 #include "btif_a2dp_sink.h"
+#include "btif_a2dp_sink_jitter.h"
+#include "btif_a2dp_sink_media.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_avrcp_audio_track.h"
@@ -42,7 +48,9 @@
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/thread.h"
+#include "osi/include/time.h"
 
 #include "oi_codec_sbc.h"
 #include "oi_status.h"
@@ -92,13 +100,6 @@ typedef struct {
   btif_a2dp_sink_focus_state_t focus_state;
 } tBTIF_MEDIA_SINK_FOCUS_UPDATE;
 
-typedef struct {
-  uint16_t num_frames_to_be_processed;
-  uint16_t len;
-  uint16_t offset;
-  uint16_t layer_specific;
-  uint64_t enque_ns;
-} tBT_SBC_HDR;
 
 extern uint64_t btif_update_reported_delay(uint64_t inst_delay);
 extern bool btif_is_sink_delay_report_supported();
@@ -117,6 +118,9 @@ typedef struct {
   btif_a2dp_sink_focus_state_t rx_focus_state; /* audio focus state */
   void* audio_track;
   uint32_t latency; /* latency of rendering Audio samples at MMAudio */
+  bool adaptive_jitter; /* playout driven by btif_a2dp_sink_jitter */
+  uint16_t samples_per_frame;
+  uint32_t conceal_frame_bytes; /* PCM bytes of the last decoded frame */
 } tBTIF_A2DP_SINK_CB;
 
 static tBTIF_A2DP_SINK_CB btif_a2dp_sink_cb;
@@ -128,6 +132,12 @@ static uint32_t btif_a2dp_sink_context_data[CODEC_DATA_WORDS(
     2, SBC_CODEC_FAST_FILTER_BUFFERS)];
 static int16_t
     btif_a2dp_sink_pcm_data[15 * SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS];
+/* Last decoded frame, faded out to conceal missing media */
+static int16_t
+    btif_a2dp_sink_conceal_pcm[SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS];
+
+/* Adaptive playout delay, see btif_a2dp_sink_jitter.h */
+static A2dpSinkJitterBuffer btif_a2dp_sink_jitter;
 
 static void btif_a2dp_sink_startup_delayed(void* context);
 static void btif_a2dp_sink_shutdown_delayed(void* context);
@@ -138,7 +148,10 @@ static void btif_a2dp_sink_audio_handle_start_decoding(void);
 static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context);
 static void btif_a2dp_sink_audio_rx_flush_req(void);
 /* Handle incoming media packets A2DP SINK streaming */
-static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg);
+static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg, bool render);
+static void btif_a2dp_sink_jitter_handle_timer(void);
+static void btif_a2dp_sink_conceal_frames(uint32_t num_frames);
+static void btif_a2dp_sink_rx_queue_flush(void);
 static void btif_a2dp_sink_decoder_update_event(
     tBTIF_MEDIA_SINK_DECODER_UPDATE* p_buf);
 static void btif_a2dp_sink_clear_track_event(void);
@@ -410,10 +423,11 @@ static void btif_a2dp_sink_audio_handle_start_decoding(void) {
   APPL_TRACE_DEBUG("Track Started and decode_alarm is set");
 }
 
-static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
+static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg, bool render) {
   uint8_t* sbc_start_frame = ((uint8_t*)(p_msg + 1) + p_msg->offset + 1);
   int count;
   uint32_t pcmBytes, availPcmBytes;
+  uint32_t lastFrameBytes = 0;
   int16_t* pcmDataPointer =
       btif_a2dp_sink_pcm_data; /* Will be overwritten on next packet receipt */
   OI_STATUS status;
@@ -442,10 +456,18 @@ static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
     }
     availPcmBytes -= pcmBytes;
     pcmDataPointer += pcmBytes / 2;
+    lastFrameBytes = pcmBytes;
     p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
     p_msg->len = sbc_frame_len + 1;
   }
 
+  if (!render) return;
+  if (btif_a2dp_sink_cb.adaptive_jitter && lastFrameBytes > 0 &&
+      lastFrameBytes <= sizeof(btif_a2dp_sink_conceal_pcm)) {
+    memcpy(btif_a2dp_sink_conceal_pcm, pcmDataPointer - lastFrameBytes / 2,
+           lastFrameBytes);
+    btif_a2dp_sink_cb.conceal_frame_bytes = lastFrameBytes;
+  }
 #ifndef OS_GENERIC
   BtifAvrcpAudioTrackWriteData(
       btif_a2dp_sink_cb.audio_track, (void*)btif_a2dp_sink_pcm_data,
@@ -460,6 +482,11 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   uint64_t inst_delay = 0;       /* avg delay incurred per frame in 20 ms */
   uint64_t inst_delay_total = 0; /* sum of delay for all frames processed till now */
 
+  if (btif_a2dp_sink_cb.adaptive_jitter) {
+    btif_a2dp_sink_jitter_handle_timer();
+    return;
+  }
+
   if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
     APPL_TRACE_DEBUG("%s: empty queue", __func__);
     return;
@@ -473,7 +500,7 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   }
   /* Play only in BTIF_A2DP_SINK_FOCUS_GRANTED case */
   if (btif_a2dp_sink_cb.rx_flush) {
-    fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_rx_queue_flush();
     return;
   }
 
@@ -495,7 +522,7 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
     if (num_sbc_frames > num_frames_to_process) {
       /* Queue packet has more frames */
       p_msg->num_frames_to_be_processed = num_frames_to_process;
-      btif_a2dp_sink_handle_inc_media(p_msg);
+      btif_a2dp_sink_handle_inc_media(p_msg, true);
       if (btif_is_sink_delay_report_supported()) {
         struct timespec ts_now;
         uint64_t curr_time;
@@ -511,7 +538,7 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
       break;
     }
     /* Queue packet has less frames */
-    btif_a2dp_sink_handle_inc_media(p_msg);
+    btif_a2dp_sink_handle_inc_media(p_msg, true);
     p_msg =
         (tBT_SBC_HDR*)fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue);
     if (p_msg == NULL) {
@@ -531,6 +558,100 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   APPL_TRACE_DEBUG("Process Frames - ");
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_sink_jitter_handle_timer
+ *
+ * Description      Media tick of the adaptive jitter buffer: renders the
+ *                  audio that elapsed since the last tick from the head of
+ *                  the RX queue, concealing missing media and dropping late
+ *                  or surplus frames as btif_a2dp_sink_jitter decides.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btif_a2dp_sink_jitter_handle_timer(void) {
+  uint64_t inst_delay_total = 0;
+  uint32_t frames_decoded = 0;
+
+  if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_NOT_GRANTED)
+    return;
+  if (btif_a2dp_sink_cb.rx_flush) {
+    btif_a2dp_sink_rx_queue_flush();
+    return;
+  }
+
+  btif_a2dp_sink_jitter.BeginTick(time_get_os_boottime_us());
+  for (;;) {
+    tBT_SBC_HDR* p_msg = (tBT_SBC_HDR*)fixed_queue_try_peek_first(
+        btif_a2dp_sink_cb.rx_audio_queue);
+    A2dpSinkJitterBuffer::Step step = btif_a2dp_sink_jitter.NextStep(
+        p_msg ? p_msg->rtp_timestamp : 0,
+        p_msg ? p_msg->num_frames_to_be_processed : 0);
+    if (step.action == A2dpSinkJitterBuffer::Action::kNone) break;
+    if (step.action == A2dpSinkJitterBuffer::Action::kConceal) {
+      btif_a2dp_sink_conceal_frames(step.frames);
+      continue;
+    }
+
+    bool render = step.action == A2dpSinkJitterBuffer::Action::kDecode;
+    uint16_t frames_left = p_msg->num_frames_to_be_processed - step.frames;
+    p_msg->num_frames_to_be_processed = step.frames;
+    btif_a2dp_sink_handle_inc_media(p_msg, render);
+    if (render && btif_is_sink_delay_report_supported()) {
+      struct timespec ts_now;
+      clock_gettime(CLOCK_BOOTTIME, &ts_now);
+      uint64_t curr_time =
+          (uint64_t)ts_now.tv_sec * 1000000000 + ts_now.tv_nsec;
+      if (curr_time > p_msg->enque_ns)
+        inst_delay_total += step.frames * (curr_time - p_msg->enque_ns);
+      frames_decoded += step.frames;
+    }
+    p_msg->num_frames_to_be_processed = frames_left;
+    p_msg->rtp_timestamp += step.frames * btif_a2dp_sink_cb.samples_per_frame;
+    if (frames_left == 0)
+      osi_free(fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue));
+  }
+
+  if (frames_decoded > 0)
+    btif_update_reported_delay(inst_delay_total / frames_decoded);
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_sink_conceal_frames
+ *
+ * Description      Renders |num_frames| frames in place of missing media:
+ *                  the last decoded frame, halved in level on every repeat,
+ *                  which fades out to silence.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btif_a2dp_sink_conceal_frames(uint32_t num_frames) {
+  uint32_t frame_bytes = btif_a2dp_sink_cb.conceal_frame_bytes;
+  if (frame_bytes == 0) return; /* nothing decoded yet */
+  uint32_t frame_samples = frame_bytes / sizeof(int16_t);
+  uint32_t max_frames = sizeof(btif_a2dp_sink_pcm_data) / frame_bytes;
+
+  while (num_frames > 0) {
+    uint32_t chunk = std::min(num_frames, max_frames);
+    int16_t* pcm = btif_a2dp_sink_pcm_data;
+    for (uint32_t i = 0; i < chunk; i++) {
+      for (uint32_t j = 0; j < frame_samples; j++) {
+        btif_a2dp_sink_conceal_pcm[j] /= 2;
+        *pcm++ = btif_a2dp_sink_conceal_pcm[j];
+      }
+    }
+#ifndef OS_GENERIC
+    BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
+                                 (void*)btif_a2dp_sink_pcm_data,
+                                 chunk * frame_bytes);
+#endif
+    num_frames -= chunk;
+  }
+}
+
 /* when true media task discards any rx frames */
 void btif_a2dp_sink_set_rx_flush(bool enable) {
   APPL_TRACE_EVENT("## DROP RX %d ##", enable);
@@ -541,7 +662,12 @@ static void btif_a2dp_sink_audio_rx_flush_event(void) {
   /* Flush all received SBC buffers (encoded) */
   APPL_TRACE_DEBUG("%s", __func__);
 
+  btif_a2dp_sink_rx_queue_flush();
+}
+
+static void btif_a2dp_sink_rx_queue_flush(void) {
   fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+  btif_a2dp_sink_jitter.Flush();
 }
 
 static void btif_a2dp_sink_decoder_update_event(
@@ -619,6 +745,27 @@ static void btif_a2dp_sink_decoder_update_event(
     APPL_TRACE_ERROR("%s: Cannot compute the number of frames to process",
                      __func__);
   }
+
+  /* The adaptive jitter buffer needs the frame duration, only known for SBC */
+  btif_a2dp_sink_cb.adaptive_jitter = false;
+  btif_a2dp_sink_cb.conceal_frame_bytes = 0;
+  if (osi_property_get_bool("persist.vendor.btstack.a2dp.sink_adaptive_jitter",
+                            false) &&
+      A2DP_GetCodecType(p_buf->codec_info) == A2DP_MEDIA_CT_SBC) {
+    int num_blocks = A2DP_GetNumberOfBlocksSbc(p_buf->codec_info);
+    int num_subbands = A2DP_GetNumberOfSubbandsSbc(p_buf->codec_info);
+    if (num_blocks > 0 && num_subbands > 0) {
+      A2dpSinkJitterBuffer::Config config;
+      config.sample_rate = sample_rate;
+      config.samples_per_frame = num_blocks * num_subbands;
+      config.tick_ms = BTIF_SINK_MEDIA_TIME_TICK_MS;
+      btif_a2dp_sink_jitter.Reset(config);
+      btif_a2dp_sink_cb.samples_per_frame = config.samples_per_frame;
+      btif_a2dp_sink_cb.adaptive_jitter = true;
+    }
+  }
+  APPL_TRACE_DEBUG("%s: adaptive jitter buffer %d", __func__,
+                   btif_a2dp_sink_cb.adaptive_jitter);
 }
 
 uint32_t get_audiotrack_latency() {
@@ -628,27 +775,50 @@ uint32_t get_audiotrack_latency() {
 
 uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   BTIF_TRACE_VERBOSE("%s: rx_flush: %d", __func__, btif_a2dp_sink_cb.rx_flush);
-  if (btif_a2dp_sink_cb.rx_flush) /* Flush enabled, do not enqueue */
+  if (btif_a2dp_sink_cb.rx_flush) { /* Flush enabled, do not enqueue */
+    osi_free(p_pkt);
     return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
+  }
+
+  uint8_t num_frames = (*((uint8_t*)(p_pkt + 1) + p_pkt->offset)) & 0x0f;
+  uint32_t rtp_timestamp = 0;
+  if (btif_a2dp_sink_cb.adaptive_jitter) {
+    if (p_pkt->offset >= BTA_AV_SINK_MEDIA_TS_LEN) {
+      memcpy(&rtp_timestamp,
+             (uint8_t*)(p_pkt + 1) + p_pkt->offset - BTA_AV_SINK_MEDIA_TS_LEN,
+             BTA_AV_SINK_MEDIA_TS_LEN);
+    }
+    if (!btif_a2dp_sink_jitter.OnPacket(time_get_os_boottime_us(),
+                                        rtp_timestamp, p_pkt->layer_specific,
+                                        num_frames)) {
+      BTIF_TRACE_DEBUG("%s: packet %d dropped", __func__,
+                       p_pkt->layer_specific);
+      osi_free(p_pkt);
+      return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
+    }
+  }
 
   if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
       MAX_INPUT_A2DP_FRAME_QUEUE_SZ) {
     uint8_t ret = fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
-    osi_free(fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue));
-    return ret;
+    tBT_SBC_HDR* p_oldest =
+        (tBT_SBC_HDR*)fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue);
+    if (!btif_a2dp_sink_cb.adaptive_jitter) {
+      osi_free(p_oldest);
+      osi_free(p_pkt);
+      return ret;
+    }
+    /* The new packet is already accounted for, keep it */
+    if (p_oldest != NULL) {
+      btif_a2dp_sink_jitter.OnDropped(p_oldest->num_frames_to_be_processed);
+      osi_free(p_oldest);
+    }
   }
 
   BTIF_TRACE_VERBOSE("%s +", __func__);
-  /* Allocate and queue this buffer */
-  tBT_SBC_HDR* p_msg = reinterpret_cast<tBT_SBC_HDR*>(
-      osi_malloc(sizeof(tBT_SBC_HDR) + p_pkt->offset + p_pkt->len));
-  memcpy((uint8_t*)(p_msg + 1), (uint8_t*)(p_pkt + 1) + p_pkt->offset,
-         p_pkt->len);
-  p_msg->num_frames_to_be_processed =
-      (*((uint8_t*)(p_pkt + 1) + p_pkt->offset)) & 0x0f;
-  p_msg->len = p_pkt->len;
-  p_msg->offset = 0;
-  p_msg->layer_specific = p_pkt->layer_specific;
+  /* Queue this buffer, in place when its headroom allows */
+  tBT_SBC_HDR* p_msg =
+      btif_a2dp_sink_media_take(p_pkt, num_frames, rtp_timestamp);
 
   if (btif_is_sink_delay_report_supported()) {
     struct timespec ts_now;
@@ -659,8 +829,15 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   BTIF_TRACE_VERBOSE("%s: frames to process %d, len %d", __func__,
                      p_msg->num_frames_to_be_processed, p_msg->len);
   fixed_queue_enqueue(btif_a2dp_sink_cb.rx_audio_queue, p_msg);
-  if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
-      MAX_A2DP_DELAYED_START_FRAME_COUNT) {
+  if (btif_a2dp_sink_cb.adaptive_jitter) {
+    /* The jitter buffer holds playback until the playout delay is queued */
+    if (btif_a2dp_sink_cb.decode_alarm == NULL &&
+        btif_a2dp_sink_jitter.IsReadyToStart()) {
+      BTIF_TRACE_DEBUG("%s: Initiate decoding", __func__);
+      btif_a2dp_sink_audio_handle_start_decoding();
+    }
+  } else if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
+             MAX_A2DP_DELAYED_START_FRAME_COUNT) {
     BTIF_TRACE_DEBUG("%s: Initiate decoding", __func__);
     btif_a2dp_sink_audio_handle_start_decoding();
   }
@@ -680,8 +857,17 @@ void btif_a2dp_sink_audio_rx_flush_req(void) {
   fixed_queue_enqueue(btif_a2dp_sink_cb.cmd_msg_queue, p_buf);
 }
 
-void btif_a2dp_sink_debug_dump(UNUSED_ATTR int fd) {
-  // Nothing to do
+void btif_a2dp_sink_debug_dump(int fd) {
+  const btif_a2dp_sink_media_stats_t* stats = btif_a2dp_sink_media_get_stats();
+  dprintf(fd, "\nA2DP Sink State:\n");
+  dprintf(fd,
+          "  Media packets (queued in place/copied/bytes copied)     : %llu / "
+          "%llu / %llu\n",
+          (unsigned long long)stats->packets_moved,
+          (unsigned long long)stats->packets_copied,
+          (unsigned long long)stats->bytes_copied);
+  if (!btif_a2dp_sink_cb.adaptive_jitter) return;
+  btif_a2dp_sink_jitter.DebugDump(fd);
 }
 
 void btif_a2dp_sink_set_focus_state_req(btif_a2dp_sink_focus_state_t state) {
@@ -703,7 +889,7 @@ static void btif_a2dp_sink_set_focus_state_event(
   APPL_TRACE_DEBUG("%s: setting focus state to %d", __func__, state);
   btif_a2dp_sink_cb.rx_focus_state = state;
   if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_NOT_GRANTED) {
-    fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_rx_queue_flush();
     btif_a2dp_sink_cb.rx_flush = true;
   } else if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED) {
     btif_a2dp_sink_cb.rx_flush = false;
@@ -787,7 +973,7 @@ bool btif_a2dp_sink_start_session(const RawAddress& peer_address) {
     if (btif_ahim_get_session_type(A2DP_SINK) ==
        SessionType::A2DP_SOFTWARE_ENCODING_DATAPATH) {
       APPL_TRACE_EVENT("%s Freeing queue from previous session", __func__);
-      fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+      btif_a2dp_sink_rx_queue_flush();
     }
   }
   return true;
@@ -0,0 +1,380 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "bt_btif_a2dp_sink_jitter"
+
+#include "btif_a2dp_sink_jitter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+/* Timestamps count samples once this many packets in a row agree with their
+ * frame counts; a mismatch costs TIMESTAMP_SCORE_MISMATCH of them. */
+#define TIMESTAMP_SCORE_MAX 16
+#define TIMESTAMP_SCORE_MISMATCH 4
+/* Larger sequence number steps are a restart of the stream, not a loss */
+#define MAX_SEQ_GAP 64
+/* The transit spread is held while packets keep arriving at least half as
+ * late, and then forgets 1/SPREAD_DECAY of itself per packet. */
+#define SPREAD_HOLD_PACKETS 500
+#define SPREAD_DECAY 256
+/* Playout delay margin per unit of interarrival jitter */
+#define JITTER_DELAY_FACTOR 4
+/* Longest stretch of elapsed time rendered by one tick */
+#define MAX_TICKS_PER_TICK 4
+/* Queued media this many ticks above the delay is trimmed every tick */
+#define FAST_DRIFT_TICKS 4
+
+void A2dpSinkJitterBuffer::Reset(const Config& config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  config_ = config;
+  if (config_.sample_rate == 0) config_.sample_rate = 44100;
+  if (config_.samples_per_frame == 0) config_.samples_per_frame = 128;
+  if (config_.tick_ms == 0) config_.tick_ms = 20;
+  if (config_.max_delay_us < config_.min_delay_us)
+    config_.max_delay_us = config_.min_delay_us;
+  if (config_.drift_ticks == 0) config_.drift_ticks = 1;
+
+  have_packet_ = false;
+  timestamp_score_ = 0;
+  jitter_x16_us_ = 0;
+  spread_us_ = config_.initial_jitter_us;
+  packets_since_spread_ = 0;
+  UpdateDelayLocked();
+  ResetPlayoutLocked();
+
+  total_packets_ = 0;
+  underruns_ = 0;
+  rebuffers_ = 0;
+  late_frames_ = 0;
+  lost_frames_ = 0;
+  concealed_frames_ = 0;
+  drift_dropped_ = 0;
+  drift_inserted_ = 0;
+  max_delay_seen_us_ = 0;
+}
+
+void A2dpSinkJitterBuffer::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  /* Arrivals after a flush are not comparable with the ones before it */
+  have_packet_ = false;
+  ResetPlayoutLocked();
+}
+
+void A2dpSinkJitterBuffer::ResetPlayoutLocked() {
+  queued_frames_ = 0;
+  started_ = false;
+  play_valid_ = false;
+  budget_acc_ = 0;
+  budget_ = 0;
+  drop_pending_ = false;
+  insert_pending_ = false;
+  ticks_since_drift_ = 0;
+  underrun_in_tick_ = false;
+  conceal_run_us_ = 0;
+}
+
+uint64_t A2dpSinkJitterBuffer::FramesToUs(uint64_t frames) const {
+  return frames * config_.samples_per_frame * 1000000 / config_.sample_rate;
+}
+
+uint64_t A2dpSinkJitterBuffer::QueuedUsLocked() const {
+  return FramesToUs(queued_frames_);
+}
+
+void A2dpSinkJitterBuffer::UpdateDelayLocked() {
+  uint64_t need =
+      std::max(spread_us_, JITTER_DELAY_FACTOR * jitter_x16_us_ / 16) +
+      config_.tick_ms * 1000;
+  delay_us_ = std::min(std::max(need, config_.min_delay_us),
+                       config_.max_delay_us);
+}
+
+bool A2dpSinkJitterBuffer::OnPacket(uint64_t now_us, uint32_t rtp_timestamp,
+                                    uint16_t seq, uint32_t frames) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (frames == 0) return false;
+  total_packets_++;
+
+  uint32_t spf = config_.samples_per_frame;
+  bool reseed = !have_packet_;
+  if (have_packet_) {
+    uint16_t seq_step = seq - last_seq_;
+    int32_t ts_step = (int32_t)(rtp_timestamp - last_timestamp_);
+    if (seq_step == 1) {
+      if (ts_step == (int32_t)(last_frames_ * spf))
+        timestamp_score_ = std::min(timestamp_score_ + 1, TIMESTAMP_SCORE_MAX);
+      else
+        timestamp_score_ = std::max(timestamp_score_ - TIMESTAMP_SCORE_MISMATCH,
+                                    -TIMESTAMP_SCORE_MAX);
+    }
+
+    /* Advance the media clock by the timestamps when they count samples and
+     * by the sequence numbers otherwise. */
+    uint64_t max_step = config_.max_delay_us * config_.sample_rate / 1000000 +
+                        last_frames_ * spf;
+    if (seq_step == 0 || seq_step > MAX_SEQ_GAP) {
+      reseed = true;
+      media_samples_ += last_frames_ * spf;
+    } else if (timestamp_score_ > 0 && ts_step > 0 &&
+               (uint64_t)ts_step <= max_step) {
+      media_samples_ += ts_step;
+    } else {
+      media_samples_ += (uint64_t)seq_step * last_frames_ * spf;
+    }
+  } else {
+    media_samples_ = 0;
+  }
+  have_packet_ = true;
+  last_seq_ = seq;
+  last_timestamp_ = rtp_timestamp;
+  last_frames_ = frames;
+
+  int64_t transit =
+      (int64_t)now_us -
+      (int64_t)(media_samples_ * 1000000 / config_.sample_rate);
+  /* A jump the buffer could never absorb is a pause of the source */
+  if (!reseed && (uint64_t)std::abs(transit - last_transit_us_) >
+                     config_.max_delay_us)
+    reseed = true;
+  if (reseed) {
+    last_transit_us_ = transit;
+    base_transit_us_ = transit;
+  }
+
+  /* RFC 3550 interarrival jitter: J += (|D| - J) / 16 */
+  uint64_t d = (uint64_t)std::abs(transit - last_transit_us_);
+  jitter_x16_us_ += d;
+  jitter_x16_us_ -= jitter_x16_us_ / 16;
+  last_transit_us_ = transit;
+
+  /* The fastest transit creeps up slowly so that a source clock running
+   * slower than ours is not taken for a growing delay. */
+  int64_t creep = (int64_t)FramesToUs(frames) / 2000 + 1;
+  base_transit_us_ = std::min(transit, base_transit_us_ + creep);
+  uint64_t spread = (uint64_t)(transit - base_transit_us_);
+  if (spread >= spread_us_) {
+    spread_us_ = spread;
+    packets_since_spread_ = 0;
+  } else if (spread * 2 >= spread_us_) {
+    packets_since_spread_ = 0;
+  } else if (++packets_since_spread_ > SPREAD_HOLD_PACKETS) {
+    spread_us_ -= spread_us_ / SPREAD_DECAY;
+  }
+  UpdateDelayLocked();
+
+  if (started_ && play_valid_ && timestamp_score_ > 0) {
+    int32_t behind =
+        (int32_t)(play_timestamp_ - (rtp_timestamp + frames * spf));
+    uint64_t limit = config_.max_delay_us * config_.sample_rate / 1000000;
+    if (behind >= 0 && (uint64_t)behind <= limit) {
+      late_frames_ += frames;
+      return false;
+    }
+  }
+
+  queued_frames_ += frames;
+  return true;
+}
+
+void A2dpSinkJitterBuffer::OnDropped(uint32_t frames) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  queued_frames_ -= std::min(queued_frames_, frames);
+}
+
+bool A2dpSinkJitterBuffer::IsReadyToStart() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queued_frames_ > 0 && QueuedUsLocked() >= delay_us_;
+}
+
+void A2dpSinkJitterBuffer::BeginTick(uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t tick_us = config_.tick_ms * 1000;
+  budget_ = 0;
+  drop_pending_ = false;
+  insert_pending_ = false;
+  underrun_in_tick_ = false;
+
+  if (!started_) {
+    if (queued_frames_ == 0 || QueuedUsLocked() < delay_us_) return;
+    started_ = true;
+    conceal_run_us_ = 0;
+    budget_acc_ = 0;
+    ticks_since_drift_ = 0;
+    last_tick_us_ = now_us > tick_us ? now_us - tick_us : 0;
+  }
+
+  /* Render the audio that elapsed since the last tick, in whole frames */
+  uint64_t elapsed_us = now_us > last_tick_us_ ? now_us - last_tick_us_ : 0;
+  elapsed_us = std::min<uint64_t>(elapsed_us, MAX_TICKS_PER_TICK * tick_us);
+  last_tick_us_ = now_us;
+  uint64_t frame_units = (uint64_t)config_.samples_per_frame * 1000000;
+  budget_acc_ += elapsed_us * config_.sample_rate;
+  budget_ = (uint32_t)(budget_acc_ / frame_units);
+  budget_acc_ -= budget_ * frame_units;
+
+  uint64_t queued_us = QueuedUsLocked();
+  max_delay_seen_us_ = std::max(max_delay_seen_us_, queued_us);
+  ticks_since_drift_++;
+  if (queued_us > delay_us_ + tick_us && queued_frames_ > budget_ &&
+      (ticks_since_drift_ >= config_.drift_ticks ||
+       queued_us > delay_us_ + FAST_DRIFT_TICKS * tick_us)) {
+    drop_pending_ = true;
+    ticks_since_drift_ = 0;
+  } else if (queued_us + tick_us < delay_us_ && budget_ > 0 &&
+             ticks_since_drift_ >= config_.drift_ticks) {
+    insert_pending_ = true;
+    ticks_since_drift_ = 0;
+  }
+}
+
+A2dpSinkJitterBuffer::Step A2dpSinkJitterBuffer::NextStep(
+    uint32_t head_timestamp, uint32_t head_frames) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t spf = config_.samples_per_frame;
+  if (!started_) return {Action::kNone, 0};
+
+  if (head_frames == 0) {
+    if (budget_ == 0) return {Action::kNone, 0};
+    /* Underrun: stretch the audio, the missing media may still arrive */
+    if (!underrun_in_tick_) {
+      underrun_in_tick_ = true;
+      underruns_++;
+    }
+    uint32_t frames = budget_;
+    budget_ = 0;
+    conceal_run_us_ += FramesToUs(frames);
+    if (conceal_run_us_ > config_.max_conceal_us) {
+      /* The source stalled: wait for the queue to refill instead */
+      rebuffers_++;
+      started_ = false;
+      play_valid_ = false;
+      conceal_run_us_ = 0;
+      return {Action::kNone, 0};
+    }
+    concealed_frames_ += frames;
+    return {Action::kConceal, frames};
+  }
+
+  if (!play_valid_) {
+    play_timestamp_ = head_timestamp;
+    play_valid_ = true;
+  }
+  if (timestamp_score_ > 0) {
+    int32_t ahead = (int32_t)(head_timestamp - play_timestamp_);
+    uint64_t limit = config_.max_delay_us * config_.sample_rate / 1000000;
+    if ((uint64_t)std::abs((int64_t)ahead) > limit) {
+      /* The source restarted its timestamps */
+      play_timestamp_ = head_timestamp;
+      ahead = 0;
+    }
+    if (ahead >= (int32_t)spf) {
+      /* Media before the head packet was lost */
+      if (budget_ == 0) return {Action::kNone, 0};
+      uint32_t frames = std::min((uint32_t)ahead / spf, budget_);
+      budget_ -= frames;
+      play_timestamp_ += frames * spf;
+      lost_frames_ += frames;
+      concealed_frames_ += frames;
+      return {Action::kConceal, frames};
+    }
+    if (ahead <= -(int32_t)spf) {
+      /* The head packet starts with media that was already played */
+      uint32_t frames = std::min((uint32_t)(-ahead) / spf, head_frames);
+      queued_frames_ -= std::min(queued_frames_, frames);
+      late_frames_ += frames;
+      return {Action::kDiscard, frames};
+    }
+    play_timestamp_ = head_timestamp;
+  }
+
+  if (drop_pending_) {
+    drop_pending_ = false;
+    drift_dropped_++;
+    queued_frames_ -= std::min(queued_frames_, 1u);
+    play_timestamp_ += spf;
+    return {Action::kDiscard, 1};
+  }
+  if (budget_ == 0) return {Action::kNone, 0};
+  if (insert_pending_) {
+    insert_pending_ = false;
+    drift_inserted_++;
+    concealed_frames_++;
+    budget_--;
+    return {Action::kConceal, 1};
+  }
+
+  uint32_t frames = std::min(head_frames, budget_);
+  budget_ -= frames;
+  queued_frames_ -= std::min(queued_frames_, frames);
+  play_timestamp_ += frames * spf;
+  conceal_run_us_ = 0;
+  return {Action::kDecode, frames};
+}
+
+uint64_t A2dpSinkJitterBuffer::GetPlayoutDelayUs() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return delay_us_;
+}
+
+uint64_t A2dpSinkJitterBuffer::GetJitterUs() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jitter_x16_us_ / 16;
+}
+
+uint64_t A2dpSinkJitterBuffer::GetQueuedUs() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return QueuedUsLocked();
+}
+
+bool A2dpSinkJitterBuffer::IsTimestampReliable() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return timestamp_score_ > 0;
+}
+
+uint32_t A2dpSinkJitterBuffer::GetUnderruns() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return underruns_;
+}
+
+uint32_t A2dpSinkJitterBuffer::GetLateFrames() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return late_frames_;
+}
+
+uint32_t A2dpSinkJitterBuffer::GetLostFrames() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return lost_frames_;
+}
+
+uint32_t A2dpSinkJitterBuffer::GetConcealedFrames() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return concealed_frames_;
+}
+
+void A2dpSinkJitterBuffer::DebugDump(int fd) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  dprintf(fd, "  Adaptive jitter buffer:\n");
+  dprintf(fd,
+          "  Delay (playout ms/queued ms/max queued ms/jitter ms)    : %llu / "
+          "%llu / %llu / %llu\n",
+          (unsigned long long)delay_us_ / 1000,
+          (unsigned long long)QueuedUsLocked() / 1000,
+          (unsigned long long)max_delay_seen_us_ / 1000,
+          (unsigned long long)jitter_x16_us_ / 16000);
+  dprintf(fd,
+          "  Stream (packets/timestamps reliable/underruns/rebuffers) : %u / "
+          "%s / %u / %u\n",
+          total_packets_, timestamp_score_ > 0 ? "true" : "false", underruns_,
+          rebuffers_);
+  dprintf(fd,
+          "  Frames (late/lost/concealed/drift dropped/inserted)     : %u / "
+          "%u / %u / %u / %u\n",
+          late_frames_, lost_frames_, concealed_frames_, drift_dropped_,
+          drift_inserted_);
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btif_a2dp_sink_media.h"
+
+#include <string.h>
+
+#include "osi/include/allocator.h"
+
+static_assert(sizeof(tBT_SBC_HDR) >= sizeof(BT_HDR),
+              "the queue header must cover the buffer header");
+
+static btif_a2dp_sink_media_stats_t btif_a2dp_sink_media_stats;
+
+tBT_SBC_HDR* btif_a2dp_sink_media_take(BT_HDR* p_pkt, uint16_t num_frames,
+                                       uint32_t rtp_timestamp) {
+  uint16_t len = p_pkt->len;
+  uint16_t offset = p_pkt->offset;
+  uint16_t layer_specific = p_pkt->layer_specific;
+  tBT_SBC_HDR* p_msg;
+
+  if (offset >= BTIF_A2DP_SINK_MEDIA_MIN_OFFSET) {
+    /* The payload stays where it is, the queue header grows over the
+     * headroom in front of it. */
+    p_msg = reinterpret_cast<tBT_SBC_HDR*>(p_pkt);
+    p_msg->offset = offset - BTIF_A2DP_SINK_MEDIA_MIN_OFFSET;
+    btif_a2dp_sink_media_stats.packets_moved++;
+  } else {
+    p_msg = reinterpret_cast<tBT_SBC_HDR*>(
+        osi_malloc(sizeof(tBT_SBC_HDR) + len));
+    memcpy((uint8_t*)(p_msg + 1), (uint8_t*)(p_pkt + 1) + offset, len);
+    osi_free(p_pkt);
+    p_msg->offset = 0;
+    btif_a2dp_sink_media_stats.packets_copied++;
+    btif_a2dp_sink_media_stats.bytes_copied += len;
+  }
+  p_msg->num_frames_to_be_processed = num_frames;
+  p_msg->len = len;
+  p_msg->layer_specific = layer_specific;
+  p_msg->rtp_timestamp = rtp_timestamp;
+  p_msg->enque_ns = 0;
+  return p_msg;
+}
+
+const btif_a2dp_sink_media_stats_t* btif_a2dp_sink_media_get_stats(void) {
+  return &btif_a2dp_sink_media_stats;
+}
+
+void btif_a2dp_sink_media_reset_stats(void) {
+  memset(&btif_a2dp_sink_media_stats, 0, sizeof(btif_a2dp_sink_media_stats));
+}
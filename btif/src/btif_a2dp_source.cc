@@ -32,6 +32,7 @@
 
 #include "bt_target.h"
 
+#include <base/bind.h>
 #include <base/logging.h>
 #ifndef OS_GENERIC
 #include <cutils/trace.h>
@@ -56,14 +57,17 @@ using ::bluetooth::audio::a2dp::SessionType;
 #include "btif_a2dp.h"
 #include "btif_a2dp_control.h"
 #include "btif_a2dp_source.h"
+#include "btif_a2dp_source_tx_ctrl.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_util.h"
+#include "l2c_api.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/mutex.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/thread.h"
 #include "osi/include/time.h"
 #include "uipc.h"
@@ -138,6 +142,10 @@ static void btif_a2dp_source_shutdown_delayed(void* context);
 static uint8_t btif_a2dp_source_dynamic_audio_buffer_size =
     MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ;
 
+/* Closed loop TX scheduling, see btif_a2dp_source_tx_ctrl.h */
+static A2dpSourceTxController btif_a2dp_source_tx_ctrl;
+static RawAddress btif_a2dp_source_nocp_peer_addr;
+
 static void btif_a2dp_source_audio_tx_start_event(void);
 static void btif_a2dp_source_audio_tx_stop_event(void);
 static void btif_a2dp_source_audio_tx_flush_event(BT_HDR* p_msg);
@@ -150,6 +158,14 @@ static void btif_a2dp_source_encoder_init_req(
 static bool btif_a2dp_source_audio_tx_flush_req(void);
 static void btif_a2dp_source_alarm_cb(void* context);
 static void btif_a2dp_source_audio_handle_timer(void* context);
+static void btif_a2dp_source_adaptive_tx_start(void);
+static void btif_a2dp_source_adaptive_tx_stop(void);
+static size_t btif_a2dp_source_adaptive_tx_tick(uint64_t timestamp_us,
+                                                size_t transmit_queue_length);
+static void btif_a2dp_source_nocp_cb(const RawAddress& bd_addr,
+                                     uint16_t num_packets);
+static void btif_a2dp_source_nocp_register(const RawAddress& peer_addr,
+                                           bool enable);
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len);
 static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read);
@@ -979,8 +995,12 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
     return;
   }
 
+  btif_a2dp_source_cb.media_alarm_interval_ms =
+      btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms();
+  btif_a2dp_source_adaptive_tx_start();
+
   alarm_set(btif_a2dp_source_cb.media_alarm,
-            btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms(),
+            btif_a2dp_source_cb.media_alarm_interval_ms,
             btif_a2dp_source_alarm_cb, NULL);
 }
 
@@ -1002,6 +1022,9 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
 #else
         bluetooth::audio::a2dp::read(p_buf, sizeof(p_buf)));
 #endif
+  } else if (btif_a2dp_control_pcm_ring_is_active()) {
+    btif_a2dp_control_log_bytes_read(
+        btif_a2dp_control_pcm_ring_read(p_buf, sizeof(p_buf)));
   } else {
     btif_a2dp_control_log_bytes_read(
        UIPC_Read(UIPC_CH_ID_AV_AUDIO, &event, p_buf, sizeof(p_buf)));
@@ -1011,9 +1034,11 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
   /* Stop the timer first */
   alarm_free(btif_a2dp_source_cb.media_alarm);
   btif_a2dp_source_cb.media_alarm = NULL;
+  btif_a2dp_source_adaptive_tx_stop();
 
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     UIPC_Close(UIPC_CH_ID_AV_AUDIO);
+    btif_a2dp_control_pcm_ring_close();
   }
   /*
    * Try to send acknowldegment once the media stream is
@@ -1080,6 +1105,7 @@ static void btif_a2dp_source_alarm_cb(UNUSED_ATTR void* context) {
 static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
   uint64_t timestamp_us = time_get_os_boottime_us();
   int curr_idx = btif_av_get_latest_device_idx_to_start();
+  period_ms_t expected_interval_ms = btif_a2dp_source_cb.encoder_interval_ms;
   log_tstamps_us("A2DP Source tx timer", timestamp_us);
 
   if (alarm_is_scheduled(btif_a2dp_source_cb.media_alarm)) {
@@ -1089,6 +1115,11 @@ static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
 #ifndef OS_GENERIC
     ATRACE_INT("btif TX queue", transmit_queue_length);
 #endif
+    if (btif_a2dp_source_cb.adaptive_tx) {
+      expected_interval_ms = btif_a2dp_source_cb.media_alarm_interval_ms;
+      transmit_queue_length = btif_a2dp_source_adaptive_tx_tick(
+          timestamp_us, transmit_queue_length);
+    }
     if (btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length !=
         NULL) {
       btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length(
@@ -1101,13 +1132,109 @@ static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
       bta_av_ci_src_data_ready(BTA_AV_CHNL_AUDIO);
     }
     update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_enqueue_stats,
-                            timestamp_us,
-                            btif_a2dp_source_cb.encoder_interval_ms * 1000);
+                            timestamp_us, expected_interval_ms * 1000);
   } else {
     APPL_TRACE_ERROR("ERROR Media task Scheduled after Suspend");
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_source_adaptive_tx_start
+ *
+ * Description      Enables closed loop scheduling of the media tick when
+ *                  persist.vendor.btstack.a2dp.adaptive_tx is set, and
+ *                  subscribes to Number Of Completed Packets of the active
+ *                  peer link so that the drain rate can be measured.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btif_a2dp_source_adaptive_tx_start(void) {
+  btif_a2dp_source_cb.adaptive_tx = osi_property_get_bool(
+      "persist.vendor.btstack.a2dp.adaptive_tx", false);
+  if (!btif_a2dp_source_cb.adaptive_tx) return;
+
+  A2dpSourceTxController::Config config;
+  config.base_interval_ms = btif_a2dp_source_cb.media_alarm_interval_ms;
+  config.min_interval_ms = btif_a2dp_source_cb.media_alarm_interval_ms / 2;
+  btif_a2dp_source_tx_ctrl.Reset(config, time_get_os_boottime_us());
+
+  /* The link control blocks belong to the BTU thread. Until completions
+   * arrive the controller has no drain rate and leaves the tick alone, so a
+   * link that can not be subscribed to only loses the adaptation. */
+  btif_av_get_active_peer_addr(&btif_a2dp_source_nocp_peer_addr);
+  do_in_bta_thread(FROM_HERE,
+                   base::Bind(&btif_a2dp_source_nocp_register,
+                              btif_a2dp_source_nocp_peer_addr, true));
+}
+
+static void btif_a2dp_source_adaptive_tx_stop(void) {
+  if (!btif_a2dp_source_cb.adaptive_tx) return;
+  do_in_bta_thread(FROM_HERE,
+                   base::Bind(&btif_a2dp_source_nocp_register,
+                              btif_a2dp_source_nocp_peer_addr, false));
+  btif_a2dp_source_cb.adaptive_tx = false;
+}
+
+/* Runs on the BTU thread */
+static void btif_a2dp_source_nocp_register(const RawAddress& peer_addr,
+                                           bool enable) {
+  if (!L2CA_RegForNoCPEvt(enable ? btif_a2dp_source_nocp_cb : NULL,
+                          peer_addr) &&
+      enable) {
+    APPL_TRACE_WARNING("%s: no ACL link to %s, adaptive TX inactive",
+                       __func__, peer_addr.ToString().c_str());
+  }
+}
+
+/* Runs on the BTU thread */
+static void btif_a2dp_source_nocp_cb(UNUSED_ATTR const RawAddress& bd_addr,
+                                     uint16_t num_packets) {
+  btif_a2dp_source_tx_ctrl.OnPacketsCompleted(num_packets);
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_source_adaptive_tx_tick
+ *
+ * Description      Runs the TX controller for one media tick: drops the
+ *                  oldest encoded packets that can no longer make it in time
+ *                  and moves the media alarm to the requested period.
+ *
+ * Returns          Transmit queue length to report to the encoder, which
+ *                  includes packets still waiting for the controller.
+ *
+ ******************************************************************************/
+static size_t btif_a2dp_source_adaptive_tx_tick(uint64_t timestamp_us,
+                                                size_t transmit_queue_length) {
+  A2dpSourceTxController::Decision decision =
+      btif_a2dp_source_tx_ctrl.OnTick(timestamp_us, transmit_queue_length);
+
+  for (size_t i = 0; i < decision.drop_n; i++) {
+    BT_HDR* p_buf =
+        (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+    if (p_buf == NULL) break;
+    osi_free(p_buf);
+    btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
+    btif_a2dp_source_tx_ctrl.OnPacketsDropped(1);
+  }
+
+  if (decision.interval_ms != btif_a2dp_source_cb.media_alarm_interval_ms) {
+    APPL_TRACE_DEBUG("%s: media tick %u -> %u ms, delay %llu ms", __func__,
+                     (uint32_t)btif_a2dp_source_cb.media_alarm_interval_ms,
+                     decision.interval_ms,
+                     (unsigned long long)btif_a2dp_source_tx_ctrl.GetDelayUs() /
+                         1000);
+    btif_a2dp_source_cb.media_alarm_interval_ms = decision.interval_ms;
+    alarm_set(btif_a2dp_source_cb.media_alarm,
+              btif_a2dp_source_cb.media_alarm_interval_ms,
+              btif_a2dp_source_alarm_cb, NULL);
+  }
+
+  return decision.effective_queue_length;
+}
+
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
   uint16_t event;
   uint32_t bytes_read = 0;
@@ -1117,6 +1244,8 @@ static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
 #else
     bytes_read = bluetooth::audio::a2dp::read(p_buf, len);
 #endif
+  } else if (btif_a2dp_control_pcm_ring_is_active()) {
+    bytes_read = btif_a2dp_control_pcm_ring_read(p_buf, len);
   } else {
     bytes_read = UIPC_Read(UIPC_CH_ID_AV_AUDIO, &event, p_buf, len);
   }
@@ -1172,11 +1301,17 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     btif_a2dp_source_cb.stats.tx_queue_dropouts++;
     btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
 
-    // Flush all queued buffers
+    // Flush all queued buffers, or only the oldest excess ones when the
+    // media tick is adaptive
     size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+    if (btif_a2dp_source_cb.adaptive_tx) {
+      drop_n = btif_a2dp_source_tx_ctrl.GetOverflowDropCount(
+          drop_n, frames_n, btif_a2dp_source_dynamic_audio_buffer_size);
+      btif_a2dp_source_tx_ctrl.OnPacketsDropped(drop_n);
+    }
     btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages = std::max(
         drop_n, btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages);
-    while (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue)) {
+    for (size_t i = 0; i < drop_n; i++) {
       btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
       osi_free(fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue));
     }
@@ -1236,6 +1371,7 @@ static void btif_a2dp_source_audio_tx_flush_event(UNUSED_ATTR BT_HDR* p_msg) {
 
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
+    btif_a2dp_control_pcm_ring_flush();
   }
 }
 
@@ -1273,6 +1409,7 @@ BT_HDR* btif_a2dp_source_audio_readbuf(void) {
     update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_dequeue_stats,
                             now_us,
                             btif_a2dp_source_cb.encoder_interval_ms * 1000);
+    btif_a2dp_source_tx_ctrl.OnPacketDequeued();
   }
 
   return p_buf;
@@ -1492,6 +1629,8 @@ void btif_a2dp_source_debug_dump(int fd) {
           1000,
       (unsigned long long)ave_time_us / 1000);
 
+  if (btif_a2dp_source_cb.adaptive_tx) btif_a2dp_source_tx_ctrl.DebugDump(fd);
+
   //
   // Codec-specific stats
   //
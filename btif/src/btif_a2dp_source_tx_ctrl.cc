@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "bt_btif_a2dp_source_tx_ctrl"
+
+#include "btif_a2dp_source_tx_ctrl.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+/* Weight of the newest sample in the drain rate average */
+#define DRAIN_RATE_EWMA_ALPHA 0.25
+/* Drain rate below which the link is considered stalled */
+#define DRAIN_RATE_STALLED_PPS 1.0
+
+void A2dpSourceTxController::Reset(const Config& config, uint64_t now_us) {
+  config_ = config;
+  if (config_.min_interval_ms == 0 ||
+      config_.min_interval_ms > config_.base_interval_ms)
+    config_.min_interval_ms = config_.base_interval_ms;
+
+  last_tick_us_ = now_us;
+  last_completed_ = completed_.load();
+  last_dequeued_ = dequeued_.load();
+  in_flight_ = 0;
+  drain_rate_pps_ = 0;
+  drain_rate_measured_ = false;
+  delay_us_ = 0;
+  max_delay_us_ = 0;
+  congested_ = false;
+  calm_ticks_ = 0;
+  interval_ms_ = config_.base_interval_ms;
+  congestion_episodes_ = 0;
+  total_dropped_ = 0;
+  total_ticks_ = 0;
+  congested_ticks_ = 0;
+}
+
+void A2dpSourceTxController::OnPacketsCompleted(uint16_t num_packets) {
+  completed_.fetch_add(num_packets, std::memory_order_relaxed);
+}
+
+void A2dpSourceTxController::OnPacketDequeued() {
+  dequeued_.fetch_add(1, std::memory_order_relaxed);
+}
+
+A2dpSourceTxController::Decision A2dpSourceTxController::OnTick(
+    uint64_t now_us, size_t queue_length) {
+  uint32_t completed = completed_.load(std::memory_order_relaxed);
+  uint32_t dequeued = dequeued_.load(std::memory_order_relaxed);
+  uint32_t completed_delta = completed - last_completed_;
+  uint32_t dequeued_delta = dequeued - last_dequeued_;
+  last_completed_ = completed;
+  last_dequeued_ = dequeued;
+  total_ticks_++;
+
+  /* Completions also cover other traffic on the link and fragments of large
+   * media packets, so the in-flight estimate is clamped at zero rather than
+   * trusted to be exact. */
+  in_flight_ += dequeued_delta;
+  in_flight_ -= std::min<size_t>(in_flight_, completed_delta);
+
+  uint64_t elapsed_us = now_us > last_tick_us_ ? now_us - last_tick_us_ : 0;
+  last_tick_us_ = now_us;
+  if (elapsed_us > 0) {
+    double rate = completed_delta * 1000000.0 / elapsed_us;
+    if (drain_rate_measured_) {
+      drain_rate_pps_ = DRAIN_RATE_EWMA_ALPHA * rate +
+                        (1 - DRAIN_RATE_EWMA_ALPHA) * drain_rate_pps_;
+    } else if (completed_delta > 0) {
+      drain_rate_pps_ = rate;
+      drain_rate_measured_ = true;
+    }
+  }
+
+  size_t backlog = queue_length + in_flight_;
+  if (backlog == 0 || !drain_rate_measured_) {
+    /* Before the first completions a backlog says nothing about the link:
+     * the stream just started, or completions are not reported at all. */
+    delay_us_ = 0;
+  } else if (drain_rate_pps_ < DRAIN_RATE_STALLED_PPS) {
+    /* Nothing drained lately: the backlog is at least as old as the tick */
+    delay_us_ = std::max<uint64_t>(delay_us_ + elapsed_us,
+                                   config_.target_delay_us + 1);
+  } else {
+    delay_us_ = (uint64_t)(backlog * 1000000.0 / drain_rate_pps_);
+  }
+  max_delay_us_ = std::max(max_delay_us_, delay_us_);
+
+  if (delay_us_ > config_.target_delay_us) {
+    if (!congested_) congestion_episodes_++;
+    congested_ = true;
+    calm_ticks_ = 0;
+  } else if (congested_ && delay_us_ < config_.low_delay_us) {
+    if (++calm_ticks_ >= config_.recover_ticks) congested_ = false;
+  } else {
+    calm_ticks_ = 0;
+  }
+
+  Decision decision;
+  decision.drop_n = 0;
+  decision.effective_queue_length = backlog;
+  if (congested_) {
+    congested_ticks_++;
+    interval_ms_ = config_.min_interval_ms;
+    /* Trim the btif queue towards the backlog the link can clear within the
+     * target delay; older packets would be late anyway. */
+    size_t target_backlog =
+        (size_t)(drain_rate_pps_ * config_.target_delay_us / 1000000.0);
+    if (backlog > target_backlog) {
+      decision.drop_n = std::min(
+          {backlog - target_backlog, queue_length, config_.max_drop_per_tick});
+    }
+  } else {
+    interval_ms_ = config_.base_interval_ms;
+  }
+  decision.interval_ms = interval_ms_;
+  return decision;
+}
+
+size_t A2dpSourceTxController::GetOverflowDropCount(size_t queue_length,
+                                                    size_t frames_n,
+                                                    size_t max_length) {
+  if (queue_length + frames_n <= max_length) return 0;
+  return std::min(queue_length, queue_length + frames_n - max_length);
+}
+
+void A2dpSourceTxController::DebugDump(int fd) const {
+  dprintf(fd, "  Adaptive TX scheduling:\n");
+  dprintf(fd,
+          "  State (congested/interval ms/target delay ms)           : %s / "
+          "%u / %llu\n",
+          congested_ ? "true" : "false", interval_ms_,
+          (unsigned long long)config_.target_delay_us / 1000);
+  dprintf(fd,
+          "  Link (drain rate pkt/s/in flight/delay ms/max delay ms)  : %.1f / "
+          "%zu / %llu / %llu\n",
+          drain_rate_pps_, in_flight_, (unsigned long long)delay_us_ / 1000,
+          (unsigned long long)max_delay_us_ / 1000);
+  dprintf(fd,
+          "  Counts (ticks/congested ticks/episodes/dropped)         : %zu / "
+          "%zu / %zu / %zu\n",
+          total_ticks_, congested_ticks_, congestion_episodes_,
+          total_dropped_);
+}
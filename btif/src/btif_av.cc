@@ -4894,6 +4894,8 @@ static void bte_av_sink_media_callback(tBTA_AV_EVT event,
             ((index == cur_playing_index) && (cur_playing_index != btif_max_av_clients))) {
         uint8_t queue_len = btif_a2dp_sink_enqueue_buf((BT_HDR*)p_data);
         BTIF_TRACE_DEBUG("%s: index = %d, packets in sink queue %d", __func__, index, queue_len);
+      } else {
+        osi_free(p_data);
       }
       break;
     }
@@ -25,6 +25,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 #include "device/include/controller.h"
 
@@ -41,6 +43,7 @@
 #include "btif_dm.h"
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
+#include "btif_scan_metadata_cache.h"
 #include "btif_storage.h"
 #include "osi/include/log.h"
 #include "vendor_api.h"
@@ -66,40 +69,95 @@ extern const btgatt_callbacks_t* bt_gatt_callbacks;
 
 namespace {
 
-// all access to this variable should be done on the jni thread
-std::set<RawAddress> remote_bdaddr_cache;
-std::queue<RawAddress> remote_bdaddr_cache_ordered;
-const size_t remote_bdaddr_cache_max_size = 1024;
+class BtifScanMetadataStorage : public BtifScanMetadataCache::Storage {
+ public:
+  bool GetDeviceType(const RawAddress& bd_addr, uint32_t* dev_type) override {
+    bt_property_t property;
+    BTIF_STORAGE_FILL_PROPERTY(&property, BT_PROPERTY_TYPE_OF_DEVICE,
+                               sizeof(*dev_type), dev_type);
+    return btif_storage_get_remote_device_property(&bd_addr, &property) ==
+           BT_STATUS_SUCCESS;
+  }
 
-void btif_address_cache_add(const RawAddress& p_bda, uint8_t addr_type) {
-  // Remove the oldest entries
-  while (remote_bdaddr_cache.size() >= remote_bdaddr_cache_max_size) {
-    const RawAddress& raw_address = remote_bdaddr_cache_ordered.front();
-    remote_bdaddr_cache.erase(raw_address);
-    remote_bdaddr_cache_ordered.pop();
+  void SetDeviceType(const RawAddress& bd_addr, uint32_t dev_type) override {
+    bt_property_t property;
+    BTIF_STORAGE_FILL_PROPERTY(&property, BT_PROPERTY_TYPE_OF_DEVICE,
+                               sizeof(dev_type), &dev_type);
+    btif_storage_set_remote_device_property(&bd_addr, &property);
   }
-  remote_bdaddr_cache.insert(p_bda);
-  remote_bdaddr_cache_ordered.push(p_bda);
-}
 
-bool btif_address_cache_find(const RawAddress& p_bda) {
-  return (remote_bdaddr_cache.find(p_bda) != remote_bdaddr_cache.end());
-}
+  bool GetAddrType(const RawAddress& bd_addr, uint8_t* addr_type) override {
+    int type;
+    if (btif_storage_get_remote_addr_type(&bd_addr, &type) != BT_STATUS_SUCCESS)
+      return false;
+    *addr_type = (uint8_t)type;
+    return true;
+  }
 
-void btif_address_cache_init(void) {
-  remote_bdaddr_cache.clear();
-  remote_bdaddr_cache_ordered = {};
-}
+  void SetAddrType(const RawAddress& bd_addr, uint8_t addr_type) override {
+    btif_storage_set_remote_addr_type(&bd_addr, addr_type);
+  }
+};
+
+// scan results update the cache on the jni thread, while unbond reaches it
+// from other threads
+std::mutex scan_metadata_lock;
+BtifScanMetadataStorage scan_metadata_storage;
+BtifScanMetadataCache scan_metadata_cache(&scan_metadata_storage);
 
 void bta_batch_scan_threshold_cb(tBTM_BLE_REF_VALUE ref_value) {
   SCAN_CBACK_IN_JNI(batchscan_threshold_cb, ref_value);
 }
 
-void bta_batch_scan_reports_cb(int client_id, tBTA_STATUS status,
-                               uint8_t report_format, uint8_t num_records,
-                               std::vector<uint8_t> data) {
-  SCAN_CBACK_IN_JNI(batchscan_reports_cb, client_id, status, report_format,
-                    num_records, std::move(data));
+/* The reports of one read. The stack streams them in batches; they are
+ * kept on the JNI thread and joined once, when the read ends, so the buffer
+ * handed to the HAL is allocated once instead of growing with every batch */
+struct BatchScanReports {
+  int num_records = 0;
+  size_t bytes = 0;
+  std::vector<std::vector<uint8_t>> batches;
+};
+
+void btif_batch_scan_reports_in_jni(int client_id,
+                                    std::shared_ptr<BatchScanReports> reports,
+                                    tBTA_STATUS status, uint8_t report_format,
+                                    uint8_t num_records,
+                                    std::vector<uint8_t> data, bool last) {
+  reports->num_records += num_records;
+  reports->bytes += data.size();
+  if (!data.empty()) reports->batches.push_back(std::move(data));
+  /* Lets the stack read further reports once this batch is kept */
+  do_in_bta_thread(FROM_HERE, Bind(&BTM_BleScanReportsConsumed));
+  if (!last) return;
+
+  std::vector<uint8_t> all;
+  if (reports->batches.size() == 1) {
+    all = std::move(reports->batches.front());
+  } else {
+    all.reserve(reports->bytes);
+    for (const std::vector<uint8_t>& batch : reports->batches)
+      all.insert(all.end(), batch.begin(), batch.end());
+  }
+  reports->batches.clear();
+
+  if (bt_gatt_callbacks && bt_gatt_callbacks->scanner->batchscan_reports_cb) {
+    BTIF_TRACE_API("HAL bt_gatt_callbacks->client->batchscan_reports_cb");
+    bt_gatt_callbacks->scanner->batchscan_reports_cb(
+        client_id, status, report_format, reports->num_records,
+        std::move(all));
+  } else {
+    ASSERTC(0, "Callback is NULL", 0);
+  }
+}
+
+void bta_batch_scan_reports_cb(int client_id,
+                               std::shared_ptr<BatchScanReports> reports,
+                               tBTA_STATUS status, uint8_t report_format,
+                               uint8_t num_records, std::vector<uint8_t> data,
+                               bool last) {
+  do_in_jni_thread(Bind(&btif_batch_scan_reports_in_jni, client_id, reports,
+                        status, report_format, num_records, std::move(data),
+                        last));
 }
 
 void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
@@ -110,8 +168,6 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
                               uint16_t ble_periodic_adv_int,
                               vector<uint8_t> value, RawAddress original_bda) {
   uint8_t remote_name_len;
-  bt_device_type_t dev_type;
-  bt_property_t properties;
 
   const uint8_t* p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
       value, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
@@ -122,8 +178,12 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
   }
 
   if ((addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name)) {
-    if (!btif_address_cache_find(bd_addr)) {
-      btif_address_cache_add(bd_addr, addr_type);
+    bool report_name;
+    {
+      std::lock_guard<std::mutex> lock(scan_metadata_lock);
+      report_name = scan_metadata_cache.MarkReported(bd_addr);
+    }
+    if (report_name) {
 
       if (p_eir_remote_name) {
         if (remote_name_len > BD_NAME_LEN + 1 ||
@@ -147,23 +207,11 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
     }
   }
 
-  dev_type = (bt_device_type_t)device_type;
-
-  uint32_t remote_dev_type = 0;
-  BTIF_STORAGE_FILL_PROPERTY(&properties, BT_PROPERTY_TYPE_OF_DEVICE,
-    sizeof(remote_dev_type), &remote_dev_type);
-  dev_type = (btif_storage_get_remote_device_property(&bd_addr, &properties) == BT_STATUS_SUCCESS) ?
-    (bt_device_type_t)(remote_dev_type | device_type) : (bt_device_type_t)device_type;
-
-  if ((remote_dev_type != dev_type) && (dev_type != 0)) {
-    BTIF_TRACE_DEBUG("%s dev_type change 0x%x=>0x%x, update config",
-          __func__, remote_dev_type, dev_type);
-    BTIF_STORAGE_FILL_PROPERTY(&properties, BT_PROPERTY_TYPE_OF_DEVICE,
-                               sizeof(dev_type), &dev_type);
-    btif_storage_set_remote_device_property(&(bd_addr), &properties);
+  {
+    std::lock_guard<std::mutex> lock(scan_metadata_lock);
+    scan_metadata_cache.Update(bd_addr, device_type, addr_type);
   }
 
-  btif_storage_set_remote_addr_type(&bd_addr, addr_type);
   HAL_CBACK(bt_gatt_callbacks, scanner->scan_result_cb, ble_evt_type, addr_type,
             &bd_addr, ble_primary_phy, ble_secondary_phy, ble_advertising_sid,
             ble_tx_power, rssi, ble_periodic_adv_int, std::move(value),
@@ -251,7 +299,10 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
             return;
           }
 
-          btif_address_cache_init();
+          {
+            std::lock_guard<std::mutex> lock(scan_metadata_lock);
+            scan_metadata_cache.ResetReported();
+          }
           do_in_bta_thread(
               FROM_HERE, Bind(&BTA_DmBleObserve, true, 0, bta_scan_results_cb));
         },
@@ -374,7 +425,8 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
     if (!stack_manager_get_interface()->get_stack_is_running()) return;
     do_in_bta_thread(FROM_HERE,
                      base::Bind(&BTM_BleReadScanReports, (uint8_t)scan_mode,
-                                Bind(bta_batch_scan_reports_cb, client_if)));
+                                Bind(bta_batch_scan_reports_cb, client_if,
+                                     std::make_shared<BatchScanReports>())));
   }
 
   void StartSync(uint8_t sid, RawAddress address, uint16_t skip,
@@ -488,3 +540,8 @@ BleScannerInterface* get_ble_scanner_instance() {
 
   return btLeScannerInstance;
 }
+
+void btif_ble_scanner_forget_device(const RawAddress& bd_addr) {
+  std::lock_guard<std::mutex> lock(scan_metadata_lock);
+  scan_metadata_cache.Forget(bd_addr);
+}
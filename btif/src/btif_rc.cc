@@ -64,7 +64,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <mutex>
+#include <vector>
 
 #include <hardware/bluetooth.h>
 #include <hardware/bt_rc_ext.h>
@@ -78,6 +80,7 @@
 #include "btif_av.h"
 #include "btif_hf.h"
 #include "btif_common.h"
+#include "btif_rc_browse_cache.h"
 #include "btif_util.h"
 #include "btu.h"
 #include "device/include/interop.h"
@@ -85,6 +88,7 @@
 #include "osi/include/list.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "stack/sdp/sdpint.h"
 #include "btif_bat.h"
 #include "btif_tws_plus.h"
@@ -213,6 +217,7 @@ typedef struct {
 #define BTIF_TIMEOUT_RC_INTERIM_RSP_MS (2 * 1000)
 #define BTIF_TIMEOUT_RC_STATUS_CMD_MS (2 * 1000)
 #define BTIF_TIMEOUT_RC_CONTROL_CMD_MS (2 * 1000)
+#define BTIF_TIMEOUT_RC_BROWSE_RSP_MS (2 * 1000)
 
 typedef enum {
   eNOT_REGISTERED,
@@ -289,6 +294,8 @@ typedef struct {
   uint8_t tws_earbud_state;
 #endif
   bool rc_element_attr_app_req;  /* flag to track get_element_attr req */
+  BtifRcBrowseCache* rc_browse_cache; /* GetFolderItems paging cache */
+  alarm_t* rc_browse_timer; /* media player response to GetFolderItems */
 
 } btif_rc_device_cb_t;
 
@@ -445,6 +452,20 @@ static void btif_rc_upstreams_rsp_evt(uint16_t event,
                                       uint8_t label,
                                       btif_rc_device_cb_t* p_dev);
 
+static bool btif_rc_browse_get_folder_items(
+    btif_rc_device_cb_t* p_dev, uint8_t label, uint8_t ctype, uint8_t pdu,
+    const BtifRcBrowseCache::Range& range);
+static void btif_rc_browse_invalidate(btif_rc_device_cb_t* p_dev);
+static void btif_rc_browse_cache_invalidate_locked(
+    btrc_event_id_t event_id, btrc_notification_type_t type,
+    btrc_register_notification_t* p_param);
+static void btif_rc_free_browse_cache(btif_rc_device_cb_t* p_dev);
+static void btif_rc_free_all_browse_caches(void);
+static void btif_rc_browse_next(btif_rc_device_cb_t* p_dev);
+static tAVRC_STS btif_rc_send_queued_folder_items_rsp(
+    btif_rc_device_cb_t* p_dev, tAVRC_STS status, uint16_t uid_counter,
+    const std::vector<tAVRC_ITEM>& items);
+
 static void rc_start_play_status_timer(btif_rc_device_cb_t* p_dev);
 static bool absolute_volume_disabled(void);
 static bt_status_t set_volume(uint8_t volume, RawAddress*bd_addr);
@@ -978,6 +999,10 @@ void handle_rc_disconnect(tBTA_AV_RC_CLOSE* p_rc_close) {
  
   /* Clean up AVRCP procedure flags */
   memset(&p_dev->rc_app_settings, 0, sizeof(btif_rc_player_app_settings_t));
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+    btif_rc_free_browse_cache(p_dev);
+  }
   p_dev->rc_features_processed = false;
   p_dev->rc_procedure_complete = false;
   rc_stop_play_status_timer(p_dev);
@@ -1497,6 +1522,7 @@ void btif_rc_handler(tBTA_AV_EVT event, tBTA_AV* p_data) {
       }
 
       if (btif_rc_cb.rc_multi_cb != NULL) {
+        btif_rc_free_all_browse_caches();
         osi_free(btif_rc_cb.rc_multi_cb);
         btif_rc_cb.rc_multi_cb = NULL;
       }
@@ -2232,6 +2258,18 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
                sizeof(uint32_t) * num_attr);
       }
 
+      BtifRcBrowseCache::Range range;
+      range.scope = pavrc_cmd->get_items.scope;
+      range.start_item = pavrc_cmd->get_items.start_item;
+      range.end_item = pavrc_cmd->get_items.end_item;
+      range.attrs.num_attr = num_attr;
+      if ((num_attr != 0xFF) && (num_attr != 0x00)) {
+        range.attrs.attr_ids.assign(attr_ids, attr_ids + num_attr);
+      }
+      if (btif_rc_browse_get_folder_items(p_dev, label, ctype,
+                                          pavrc_cmd->pdu, range))
+        break;
+
       fill_pdu_queue(IDX_GET_FOLDER_ITEMS_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, get_folder_items_cb,
                 pavrc_cmd->get_items.scope, pavrc_cmd->get_items.start_item,
@@ -2245,6 +2283,7 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
     } break;
 
     case AVRC_PDU_SET_BROWSED_PLAYER: {
+      btif_rc_browse_invalidate(p_dev);
       fill_pdu_queue(IDX_SET_BROWSED_PLAYER_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, set_browsed_player_cb,
                 pavrc_cmd->br_player.player_id, &rc_addr);
@@ -2281,6 +2320,7 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
     } break;
 
     case AVRC_PDU_CHANGE_PATH: {
+      btif_rc_browse_invalidate(p_dev);
       fill_pdu_queue(IDX_CHG_PATH_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, change_path_cb, pavrc_cmd->chg_path.direction,
                 pavrc_cmd->chg_path.folder_uid, &rc_addr);
@@ -2526,6 +2566,7 @@ static bt_status_t init(btrc_callbacks_t* callbacks, int max_connections) {
   }
 
   if (btif_rc_cb.rc_multi_cb != NULL) {
+    btif_rc_free_all_browse_caches();
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
   }
@@ -2567,6 +2608,7 @@ static bt_status_t init_ctrl(btrc_ctrl_callbacks_t* callbacks) {
   if (btif_device_in_sink_role())
     btif_max_rc_clients = btif_get_max_allowable_sink_connections();
   if (btif_rc_cb.rc_multi_cb != NULL) {
+    btif_rc_free_all_browse_caches();
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
   }
@@ -2986,6 +3028,8 @@ static bt_status_t register_notification_rsp_sho_mcast(
                    dump_rc_notification_event_id(event_id));
   std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
 
+  btif_rc_browse_cache_invalidate_locked(event_id, type, p_param);
+
   btif_rc_device_cb_t* p_dev = btif_rc_get_device_by_bda(bd_addr);
   if (p_dev == NULL) {
     BTIF_TRACE_ERROR("%s: p_dev is NULL", __func__);
@@ -3126,6 +3170,8 @@ static bt_status_t register_notification_rsp(
     return BT_STATUS_PARM_INVALID;
   }
 
+  btif_rc_browse_cache_invalidate_locked(event_id, type, p_param);
+
   memset(&(avrc_rsp.reg_notif), 0, sizeof(tAVRC_REG_NOTIF_RSP));
 
   avrc_rsp.reg_notif.event_id = event_id;
@@ -3234,138 +3280,136 @@ static bt_status_t register_notification_rsp(
 
 /***************************************************************************
  *
- * Function         get_folder_items_list_rsp
+ * Function         btif_rc_convert_folder_items
  *
- * Description      Returns the list of media items in current folder along with
- *                  requested attributes. This is called in response to
- *                  GetFolderItems request.
+ * Description      Converts the folder items handed down by the media player
+ *                  into AVRC items. Strings and attribute values of the
+ *                  result point into |p_items| and |p_attr_vals|.
  *
- * Returns          bt_status_t
- *                      BT_STATUS_NOT_READY - when RC is not connected.
- *                      BT_STATUS_SUCCESS   - always if RC is connected
- *                      BT_STATUS_UNHANDLED - when rsp is not pending for
- *                                            get_folder_items_list PDU
+ * Returns          AVRC_STS_NO_ERROR, or AVRC_STS_INTERNAL_ERR on an unknown
+ *                  item type.
  *
  **************************************************************************/
-static bt_status_t get_folder_items_list_rsp(RawAddress* bd_addr,
-                                             btrc_status_t rsp_status,
-                                             uint16_t uid_counter,
-                                             uint16_t num_items,
-                                             btrc_folder_items_t* p_items) {
-  tAVRC_RESPONSE avrc_rsp;
-  tAVRC_ITEM item;
-  tBTA_AV_CODE code = 0, ctype = 0;
-  BT_HDR* p_msg = NULL;
-  int item_cnt;
-  tAVRC_STS status = AVRC_STS_NO_ERROR;
-  btif_rc_device_cb_t* p_dev = btif_rc_get_device_by_bda(bd_addr);
-  btrc_folder_items_t* cur_item = NULL;
-  int rsp_index = IDX_GET_FOLDER_ITEMS_RSP;
-  if (p_dev == NULL) {
-    BTIF_TRACE_ERROR("%s: p_dev is NULL", __func__);
-    return BT_STATUS_FAIL;
-  }
+static tAVRC_STS btif_rc_convert_folder_items(
+    uint16_t num_items, btrc_folder_items_t* p_items,
+    std::vector<tAVRC_ITEM>* p_avrc_items,
+    std::vector<tAVRC_ATTR_ENTRY>* p_attr_vals) {
+  size_t num_attrs = 0;
+  for (int item_cnt = 0; item_cnt < num_items; item_cnt++) {
+    if (p_items[item_cnt].item_type == AVRC_ITEM_MEDIA &&
+        p_items[item_cnt].media.num_attrs > 0)
+      num_attrs += std::min(p_items[item_cnt].media.num_attrs,
+                            BTRC_MAX_ELEM_ATTR_SIZE);
+  }
+  /* attribute lists are handed out by pointer, do not let them move */
+  p_attr_vals->reserve(num_attrs);
+  p_avrc_items->reserve(num_items);
+
+  for (int item_cnt = 0; item_cnt < num_items; item_cnt++) {
+    btrc_folder_items_t* cur_item = &p_items[item_cnt];
+    tAVRC_ITEM item;
+    memset(&item, 0, sizeof(tAVRC_ITEM));
+    item.item_type = cur_item->item_type;
+    /* build respective item based on item_type. All items should be of same
+     * type within a response */
+    BTIF_TRACE_DEBUG("cur_item->item_type:%d,p_items->item_type:%d",
+                     cur_item->item_type, p_items->item_type);
+    switch (cur_item->item_type) {
+      case AVRC_ITEM_PLAYER: {
+        item.u.player.name.charset_id = cur_item->player.charset_id;
+        memcpy(&(item.u.player.features), &(cur_item->player.features),
+               sizeof(cur_item->player.features));
+        item.u.player.major_type = cur_item->player.major_type;
+        item.u.player.sub_type = cur_item->player.sub_type;
+        item.u.player.play_status = cur_item->player.play_status;
+        item.u.player.player_id = cur_item->player.player_id;
+        item.u.player.name.p_str = cur_item->player.name;
+        item.u.player.name.str_len =
+            (uint16_t)strlen((char*)(cur_item->player.name));
+      } break;
 
-  int front_index = p_dev->rc_pdu_info[rsp_index].front;
-  BTIF_TRACE_DEBUG("%s: uid_counter %d num_items %d", __func__, uid_counter,
-                   num_items);
-  CHECK_RC_CONNECTED(p_dev);
+      case AVRC_ITEM_FOLDER: {
+        memcpy(item.u.folder.uid, cur_item->folder.uid, sizeof(tAVRC_UID));
+        item.u.folder.type = cur_item->folder.type;
+        item.u.folder.playable = cur_item->folder.playable;
+        item.u.folder.name.charset_id = AVRC_CHARSET_ID_UTF8;
+        item.u.folder.name.str_len = strlen((char*)cur_item->folder.name);
+        item.u.folder.name.p_str = cur_item->folder.name;
+      } break;
 
-  /* check if rsp to previous cmd was completed */
-  if (p_dev->rc_pdu_info[IDX_GET_FOLDER_ITEMS_RSP].is_rsp_pending == false) {
-    BTIF_TRACE_WARNING("%s: Not sending response as no PDU was registered",
-                       __func__);
-    return BT_STATUS_UNHANDLED;
+      case AVRC_ITEM_MEDIA: {
+        memcpy(item.u.media.uid, cur_item->media.uid, sizeof(tAVRC_UID));
+        item.u.media.type = cur_item->media.type;
+        item.u.media.name.charset_id = cur_item->media.charset_id;
+        item.u.media.name.str_len = strlen((char*)cur_item->media.name);
+        item.u.media.name.p_str = cur_item->media.name;
+
+        /* Handle attributes of given item */
+        if (cur_item->media.num_attrs <= 0) {
+          item.u.media.attr_count = 0;
+          item.u.media.p_attr_list = NULL;
+        } else {
+          item.u.media.attr_count =
+              std::min(cur_item->media.num_attrs, BTRC_MAX_ELEM_ATTR_SIZE);
+          tAVRC_ATTR_ENTRY attr_vals[BTRC_MAX_ELEM_ATTR_SIZE];
+          memset(&attr_vals, 0,
+                 sizeof(tAVRC_ATTR_ENTRY) * BTRC_MAX_ELEM_ATTR_SIZE);
+          fill_avrc_attr_entry(attr_vals, item.u.media.attr_count,
+                               cur_item->media.p_attrs);
+          item.u.media.p_attr_list = p_attr_vals->data() + p_attr_vals->size();
+          p_attr_vals->insert(p_attr_vals->end(), attr_vals,
+                              attr_vals + item.u.media.attr_count);
+        }
+      } break;
+
+      default: {
+        BTIF_TRACE_ERROR("%s: Unknown item_type: %d. Internal Error",
+                         __func__, p_items->item_type);
+        return AVRC_STS_INTERNAL_ERR;
+      }
+    }
+    p_avrc_items->push_back(item);
   }
+  return AVRC_STS_NO_ERROR;
+}
 
-  memset(&avrc_rsp, 0, sizeof(tAVRC_RESPONSE));
-  memset(&item, 0, sizeof(tAVRC_ITEM));
+/***************************************************************************
+ *
+ * Function         btif_rc_send_folder_items_rsp
+ *
+ * Description      Builds a GetFolderItems response from |items|, adding
+ *                  items until the browsing MTU is reached, and sends it to
+ *                  the remote. A reject is sent when |status| is an error.
+ *
+ * Returns          AVRC status of the response sent
+ *
+ **************************************************************************/
+static tAVRC_STS btif_rc_send_folder_items_rsp(
+    btif_rc_device_cb_t* p_dev, uint8_t label, tBTA_AV_CODE code,
+    tAVRC_STS status, uint16_t uid_counter,
+    const std::vector<tAVRC_ITEM>& items) {
+  tAVRC_RESPONSE avrc_rsp;
+  BT_HDR* p_msg = NULL;
 
+  memset(&avrc_rsp, 0, sizeof(tAVRC_RESPONSE));
   avrc_rsp.get_items.pdu = AVRC_PDU_GET_FOLDER_ITEMS;
   avrc_rsp.get_items.opcode = opcode_from_pdu(AVRC_PDU_GET_FOLDER_ITEMS);
-  avrc_rsp.get_items.status = status_code_map[rsp_status];
+  avrc_rsp.get_items.status = status;
 
-  if (avrc_rsp.get_items.status != AVRC_STS_NO_ERROR) {
+  if (status != AVRC_STS_NO_ERROR) {
     BTIF_TRACE_WARNING(
         "%s: Error in parsing the received getfolderitems cmd. status: 0x%02x",
-        __func__, avrc_rsp.get_items.status);
-    status = avrc_rsp.get_items.status;
+        __func__, status);
   } else {
     avrc_rsp.get_items.uid_counter = uid_counter;
     avrc_rsp.get_items.item_count = 1;
 
-    /* create single item and build response iteratively for all num_items */
-    for (item_cnt = 0; item_cnt < num_items; item_cnt++) {
-      cur_item = &p_items[item_cnt];
-      item.item_type = cur_item->item_type;
-      /* build respective item based on item_type. All items should be of same
-       * type within
-       * a response */
-      BTIF_TRACE_DEBUG("cur_item->item_type:%d,p_items->item_type:%d",cur_item->item_type,p_items->item_type);
-      switch (cur_item->item_type) {
-        case AVRC_ITEM_PLAYER: {
-          item.u.player.name.charset_id = cur_item->player.charset_id;
-          memcpy(&(item.u.player.features), &(cur_item->player.features),
-                 sizeof(cur_item->player.features));
-          item.u.player.major_type = cur_item->player.major_type;
-          item.u.player.sub_type = cur_item->player.sub_type;
-          item.u.player.play_status = cur_item->player.play_status;
-          item.u.player.player_id = cur_item->player.player_id;
-          item.u.player.name.p_str = cur_item->player.name;
-          item.u.player.name.str_len =
-              (uint16_t)strlen((char*)(cur_item->player.name));
-        } break;
-
-        case AVRC_ITEM_FOLDER: {
-          memcpy(item.u.folder.uid, cur_item->folder.uid, sizeof(tAVRC_UID));
-          item.u.folder.type = cur_item->folder.type;
-          item.u.folder.playable = cur_item->folder.playable;
-          item.u.folder.name.charset_id = AVRC_CHARSET_ID_UTF8;
-          item.u.folder.name.str_len = strlen((char*)cur_item->folder.name);
-          item.u.folder.name.p_str = cur_item->folder.name;
-        } break;
-
-        case AVRC_ITEM_MEDIA: {
-          tAVRC_ATTR_ENTRY attr_vals[BTRC_MAX_ELEM_ATTR_SIZE];
-
-          memcpy(item.u.media.uid, cur_item->media.uid, sizeof(tAVRC_UID));
-          item.u.media.type = cur_item->media.type;
-          item.u.media.name.charset_id = cur_item->media.charset_id;
-          item.u.media.name.str_len = strlen((char*)cur_item->media.name);
-          item.u.media.name.p_str = cur_item->media.name;
-          item.u.media.attr_count = cur_item->media.num_attrs;
-
-          /* Handle attributes of given item */
-          if (item.u.media.attr_count == 0) {
-            item.u.media.p_attr_list = NULL;
-          } else {
-            memset(&attr_vals, 0,
-                   sizeof(tAVRC_ATTR_ENTRY) * BTRC_MAX_ELEM_ATTR_SIZE);
-            fill_avrc_attr_entry(attr_vals, item.u.media.attr_count,
-                                 cur_item->media.p_attrs);
-            item.u.media.p_attr_list = attr_vals;
-          }
-        } break;
-
-        default: {
-          BTIF_TRACE_ERROR("%s: Unknown item_type: %d. Internal Error",
-                           __func__, p_items->item_type);
-          status = AVRC_STS_INTERNAL_ERR;
-        } break;
-      }
-
-      avrc_rsp.get_items.p_item_list = &item;
-
-      /* Add current item to buffer and build response if no error in item type
-       */
-      if (status != AVRC_STS_NO_ERROR) {
-        /* Reject response due to error occured for unknown item_type, break the
-         * loop */
-        break;
-      }
+    /* build response iteratively, a single item at a time */
+    for (size_t item_cnt = 0; item_cnt < items.size(); item_cnt++) {
+      avrc_rsp.get_items.p_item_list = (tAVRC_ITEM*)&items[item_cnt];
 
       int len_before = p_msg ? p_msg->len : 0;
-      BTIF_TRACE_DEBUG("%s: item_cnt: %d len: %d", __func__, item_cnt,
+      BTIF_TRACE_DEBUG("%s: item_cnt: %d len: %d", __func__, (int)item_cnt,
                        len_before);
       status = AVRC_BldResponse(p_dev->rc_handle, &avrc_rsp, &p_msg);
       BTIF_TRACE_DEBUG("%s: Build rsp status: %d len: %d", __func__, status,
@@ -3384,18 +3428,293 @@ static bt_status_t get_folder_items_list_rsp(RawAddress* bd_addr,
 
   /* if packet built successfully, send the built items to BTA layer */
   if (status == AVRC_STS_NO_ERROR) {
-    code = p_dev->rc_pdu_info[rsp_index].ctype[front_index];
-    ctype = get_rsp_type_code(avrc_rsp.get_items.status, code);
-    BTA_AvMetaRsp(p_dev->rc_handle, p_dev->rc_pdu_info[rsp_index].label[front_index],
-                  ctype, p_msg);
+    tBTA_AV_CODE ctype = get_rsp_type_code(avrc_rsp.get_items.status, code);
+    BTA_AvMetaRsp(p_dev->rc_handle, label, ctype, p_msg);
   } else /* Error occured, send reject response */
   {
     BTIF_TRACE_ERROR("%s: Error status: 0x%02X. Sending reject rsp", __func__,
                      avrc_rsp.rsp.status);
-    send_reject_response(p_dev->rc_handle, p_dev->rc_pdu_info[rsp_index].label[front_index],
-        avrc_rsp.pdu, avrc_rsp.get_items.status, avrc_rsp.get_items.opcode);
+    osi_free(p_msg);
+    send_reject_response(p_dev->rc_handle, label, avrc_rsp.pdu,
+                         avrc_rsp.get_items.status, avrc_rsp.get_items.opcode);
+  }
+  return status;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_cache_enabled
+ *
+ * Description      Whether GetFolderItems pages are cached natively. The
+ *                  cache is on unless disabled through
+ *                  persist.vendor.btstack.avrcp.browse_cache.
+ *
+ **************************************************************************/
+static bool btif_rc_browse_cache_enabled(void) {
+  static const bool enabled = osi_property_get_bool(
+      "persist.vendor.btstack.avrcp.browse_cache", true);
+  return enabled;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_free_browse_cache
+ *
+ * Description      Releases the browse cache of the given device.
+ *
+ **************************************************************************/
+static void btif_rc_free_browse_cache(btif_rc_device_cb_t* p_dev) {
+  if (p_dev->rc_browse_cache == NULL) return;
+
+  const BtifRcBrowseCache::Stats& stats = p_dev->rc_browse_cache->GetStats();
+  BTIF_TRACE_DEBUG(
+      "%s: hits: %u misses: %u prefetches: %u prefetch_fills: %u "
+      "invalidations: %u dropped_responses: %u timeouts: %u",
+      __func__, stats.hits, stats.misses, stats.prefetches,
+      stats.prefetch_fills, stats.invalidations, stats.dropped_responses,
+      stats.timeouts);
+  BTIF_TRACE_DEBUG(
+      "%s: latency us, cached: %u rsp mean %llu max %llu, "
+      "player: %u rsp mean %llu max %llu",
+      __func__, stats.hit_latency.count,
+      (unsigned long long)stats.hit_latency.MeanUs(),
+      (unsigned long long)stats.hit_latency.max_us, stats.miss_latency.count,
+      (unsigned long long)stats.miss_latency.MeanUs(),
+      (unsigned long long)stats.miss_latency.max_us);
+  delete p_dev->rc_browse_cache;
+  p_dev->rc_browse_cache = NULL;
+  alarm_free(p_dev->rc_browse_timer);
+  p_dev->rc_browse_timer = NULL;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_invalidate
+ *
+ * Description      Drops the cached listing of a device whose browsed folder
+ *                  or player is about to change.
+ *
+ **************************************************************************/
+static void btif_rc_browse_invalidate(btif_rc_device_cb_t* p_dev) {
+  std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+  if (p_dev->rc_browse_cache != NULL) p_dev->rc_browse_cache->Invalidate();
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_free_all_browse_caches
+ *
+ * Description      Releases the browse caches of all devices before the
+ *                  device control blocks are freed.
+ *
+ **************************************************************************/
+static void btif_rc_free_all_browse_caches(void) {
+  if (btif_rc_cb.rc_multi_cb == NULL) return;
+  for (int idx = 0; idx < btif_max_rc_clients; idx++) {
+    btif_rc_free_browse_cache(&btif_rc_cb.rc_multi_cb[idx]);
+  }
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_cache_invalidate_locked
+ *
+ * Description      Drops cached folder listings that are made stale by a
+ *                  notification sent by the media player. Must be called
+ *                  with btif_rc_cb.lock held.
+ *
+ **************************************************************************/
+static void btif_rc_browse_cache_invalidate_locked(
+    btrc_event_id_t event_id, btrc_notification_type_t type,
+    btrc_register_notification_t* p_param) {
+  if (btif_rc_cb.rc_multi_cb == NULL) return;
+  /* UID counters are compared, so interim responses are harmless there */
+  if (type != BTRC_NOTIFICATION_TYPE_CHANGED &&
+      event_id != BTRC_EVT_UIDS_CHANGED)
+    return;
+
+  for (int idx = 0; idx < btif_max_rc_clients; idx++) {
+    BtifRcBrowseCache* cache = btif_rc_cb.rc_multi_cb[idx].rc_browse_cache;
+    if (cache == NULL) continue;
+
+    switch (event_id) {
+      case BTRC_EVT_UIDS_CHANGED:
+        cache->OnUidCounterChanged(p_param->uids_changed.uid_counter);
+        break;
+      case BTRC_EVT_NOW_PLAYING_CONTENT_CHANGED:
+        cache->InvalidateScope(AVRC_SCOPE_NOW_PLAYING);
+        break;
+      case BTRC_EVT_ADDR_PLAYER_CHANGE:
+        cache->Invalidate();
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_timeout_handler
+ *
+ * Description      The media player did not answer the outstanding
+ *                  GetFolderItems in time (Runs in BTIF context). Clears
+ *                  its tag, fails the remote command it was forwarded for
+ *                  and moves on to the deferred commands.
+ *
+ **************************************************************************/
+static void btif_rc_browse_timeout_handler(UNUSED_ATTR uint16_t event,
+                                           char* p_data) {
+  btif_rc_handle_t* rc_handle = (btif_rc_handle_t*)p_data;
+  btif_rc_device_cb_t* p_dev = btif_rc_get_device_by_handle(rc_handle->handle);
+  if (p_dev == NULL) {
+    BTIF_TRACE_ERROR("%s timeout handler but no device found for handle %d",
+                     __func__, rc_handle->handle);
+    return;
   }
 
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+    BtifRcBrowseCache* cache = p_dev->rc_browse_cache;
+    /* A request forwarded since the timer fired has restarted it */
+    if (cache == NULL || alarm_is_scheduled(p_dev->rc_browse_timer)) return;
+
+    BtifRcBrowseCache::Request request;
+    if (!cache->CompleteRequest(&request)) return;
+    cache->RecordTimeout();
+    BTIF_TRACE_WARNING(
+        "%s: no player response, scope: %d start_item: %u end_item: %u "
+        "prefetch: %d",
+        __func__, request.range.scope, request.range.start_item,
+        request.range.end_item, request.prefetch);
+    if (!request.prefetch &&
+        p_dev->rc_pdu_info[IDX_GET_FOLDER_ITEMS_RSP].is_rsp_pending) {
+      btif_rc_send_queued_folder_items_rsp(p_dev, AVRC_STS_INTERNAL_ERR, 0,
+                                           std::vector<tAVRC_ITEM>());
+    }
+  }
+
+  btif_rc_browse_next(p_dev);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_timer_timeout
+ *
+ * Description      Browse response timeout callback.
+ *                  This is called from BTU context and switches to BTIF
+ *                  context to handle the timeout events
+ * Returns          None
+ *
+ **************************************************************************/
+static void btif_rc_browse_timer_timeout(void* data) {
+  btif_rc_handle_t rc_handle;
+  rc_handle.handle = PTR_TO_UINT(data);
+  btif_transfer_context(btif_rc_browse_timeout_handler, 0,
+                        (char*)(&rc_handle), sizeof(btif_rc_handle_t), NULL);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_next_handler
+ *
+ * Description      Continues with the deferred GetFolderItems commands of a
+ *                  device once the media player has answered (Runs in BTIF
+ *                  context, so that get_folder_items_cb reaches Java on
+ *                  the callback thread).
+ *
+ **************************************************************************/
+static void btif_rc_browse_next_handler(UNUSED_ATTR uint16_t event,
+                                        char* p_data) {
+  btif_rc_device_cb_t* p_dev = btif_rc_get_device_by_bda((RawAddress*)p_data);
+  if (p_dev == NULL) {
+    BTIF_TRACE_ERROR("%s: p_dev is NULL", __func__);
+    return;
+  }
+  btif_rc_browse_next(p_dev);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_forward
+ *
+ * Description      Asks the media player for the items of |range|. The
+ *                  request must already be tagged in the browse cache. Runs
+ *                  in BTIF context; the response is awaited for
+ *                  BTIF_TIMEOUT_RC_BROWSE_RSP_MS.
+ *
+ **************************************************************************/
+static void btif_rc_browse_forward(btif_rc_device_cb_t* p_dev,
+                                   const BtifRcBrowseCache::Range& range) {
+  uint32_t attr_ids[BTRC_MAX_ELEM_ATTR_SIZE];
+
+  memset(attr_ids, 0, sizeof(attr_ids));
+  for (size_t i = 0;
+       i < range.attrs.attr_ids.size() && i < BTRC_MAX_ELEM_ATTR_SIZE; i++)
+    attr_ids[i] = range.attrs.attr_ids[i];
+
+  BTIF_TRACE_DEBUG("%s: scope: %d start_item: %u end_item: %u", __func__,
+                   range.scope, range.start_item, range.end_item);
+  if (p_dev->rc_browse_timer == NULL)
+    p_dev->rc_browse_timer = alarm_new("btif_rc.browse_rsp_timer");
+  alarm_set_on_mloop(p_dev->rc_browse_timer, BTIF_TIMEOUT_RC_BROWSE_RSP_MS,
+                     btif_rc_browse_timer_timeout,
+                     UINT_TO_PTR(p_dev->rc_handle));
+  RawAddress rc_addr = p_dev->rc_addr;
+  HAL_CBACK(bt_rc_callbacks, get_folder_items_cb, range.scope,
+            range.start_item, range.end_item, range.attrs.num_attr, attr_ids,
+            &rc_addr);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_prefetch
+ *
+ * Description      Asks the media player for the page following the cached
+ *                  window when the remote is paging sequentially, so that
+ *                  its next GetFolderItems can be answered from the cache.
+ *                  Only issued while the player is idle, so that its
+ *                  response is matched against the prefetch tag.
+ *
+ **************************************************************************/
+static void btif_rc_browse_prefetch(btif_rc_device_cb_t* p_dev) {
+  BtifRcBrowseCache::Range range;
+
+  static const bool prefetch_enabled = osi_property_get_bool(
+      "persist.vendor.btstack.avrcp.browse_prefetch", true);
+  if (bt_rc_callbacks == NULL || !prefetch_enabled) return;
+
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+    BtifRcBrowseCache* cache = p_dev->rc_browse_cache;
+    if (cache == NULL || !cache->GetPrefetchRange(&range)) return;
+    cache->SetPrefetchPending(range, time_get_os_boottime_us());
+  }
+
+  btif_rc_browse_forward(p_dev, range);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_send_queued_folder_items_rsp
+ *
+ * Description      Answers the oldest GetFolderItems command whose
+ *                  transaction label is queued for a media player response.
+ *
+ * Returns          AVRC status of the response sent
+ *
+ **************************************************************************/
+static tAVRC_STS btif_rc_send_queued_folder_items_rsp(
+    btif_rc_device_cb_t* p_dev, tAVRC_STS status, uint16_t uid_counter,
+    const std::vector<tAVRC_ITEM>& items) {
+  int rsp_index = IDX_GET_FOLDER_ITEMS_RSP;
+  int front_index = p_dev->rc_pdu_info[rsp_index].front;
+
+  status = btif_rc_send_folder_items_rsp(
+      p_dev, p_dev->rc_pdu_info[rsp_index].label[front_index],
+      p_dev->rc_pdu_info[rsp_index].ctype[front_index], status, uid_counter,
+      items);
+
   TXN_LABEL_DEQUEUE(p_dev->rc_pdu_info[rsp_index].label, p_dev->rc_pdu_info[rsp_index].front,
     p_dev->rc_pdu_info[rsp_index].rear, p_dev->rc_pdu_info[rsp_index].size);
 
@@ -3404,6 +3723,204 @@ static bt_status_t get_folder_items_list_rsp(RawAddress* bd_addr,
   if (p_dev->rc_pdu_info[rsp_index].size == 0)
     p_dev->rc_pdu_info[rsp_index].is_rsp_pending = false;
 
+  return status;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_next
+ *
+ * Description      Called once the media player has answered. Serves the
+ *                  deferred GetFolderItems commands that the window now
+ *                  covers, forwards the first one it does not, or else
+ *                  prefetches the next page.
+ *
+ **************************************************************************/
+static void btif_rc_browse_next(btif_rc_device_cb_t* p_dev) {
+  BtifRcBrowseCache::Request request;
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter = 0;
+
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+    BtifRcBrowseCache* cache = p_dev->rc_browse_cache;
+    if (cache == NULL) return;
+
+    while (!cache->IsRequestPending() && cache->PopDeferredRequest(&request)) {
+      if (BtifRcBrowseCache::IsCacheableScope(request.range.scope) &&
+          cache->Lookup(request.range, &uid_counter, &items)) {
+        /* Deferred commands hold the oldest queued labels */
+        btif_rc_send_queued_folder_items_rsp(p_dev, AVRC_STS_NO_ERROR,
+                                             uid_counter, items);
+        cache->RecordLatency(true,
+                             time_get_os_boottime_us() - request.start_us);
+        continue;
+      }
+      cache->SetPendingRequest(request.range, request.start_us);
+      lock.unlock();
+      btif_rc_browse_forward(p_dev, request.range);
+      return;
+    }
+  }
+
+  btif_rc_browse_prefetch(p_dev);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_browse_get_folder_items
+ *
+ * Description      Handles a GetFolderItems command through the browse
+ *                  cache: answers it from the window, or forwards it to the
+ *                  media player, or defers it while the player is still
+ *                  busy with another request. The player response carries
+ *                  no range, so keeping a single request outstanding is
+ *                  what lets the response be matched to its request.
+ *
+ * Returns          false if the cache is disabled and the command is left
+ *                  to the caller
+ *
+ **************************************************************************/
+static bool btif_rc_browse_get_folder_items(
+    btif_rc_device_cb_t* p_dev, uint8_t label, uint8_t ctype, uint8_t pdu,
+    const BtifRcBrowseCache::Range& range) {
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter = 0;
+  uint64_t start_us = time_get_os_boottime_us();
+
+  if (!btif_rc_browse_cache_enabled()) return false;
+
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+    if (p_dev->rc_browse_cache == NULL)
+      p_dev->rc_browse_cache = new BtifRcBrowseCache();
+    BtifRcBrowseCache* cache = p_dev->rc_browse_cache;
+
+    if (BtifRcBrowseCache::IsCacheableScope(range.scope) &&
+        cache->Lookup(range, &uid_counter, &items)) {
+      BTIF_TRACE_DEBUG("%s: cache hit, start_item: %u end_item: %u items: %d",
+                       __func__, range.start_item, range.end_item,
+                       (int)items.size());
+      /* items point into the cache, build the response before unlocking */
+      btif_rc_send_folder_items_rsp(p_dev, label, ctype, AVRC_STS_NO_ERROR,
+                                    uid_counter, items);
+      cache->RecordLatency(true, time_get_os_boottime_us() - start_us);
+    } else {
+      fill_pdu_queue(IDX_GET_FOLDER_ITEMS_RSP, ctype, label, true, p_dev, pdu);
+      if (cache->IsRequestPending()) {
+        BTIF_TRACE_DEBUG("%s: player busy, deferring start_item: %u",
+                         __func__, range.start_item);
+        cache->DeferRequest(range, start_us);
+        return true;
+      }
+      cache->SetPendingRequest(range, start_us);
+      lock.unlock();
+      btif_rc_browse_forward(p_dev, range);
+      return true;
+    }
+  }
+
+  btif_rc_browse_prefetch(p_dev);
+  return true;
+}
+
+/***************************************************************************
+ *
+ * Function         get_folder_items_list_rsp
+ *
+ * Description      Returns the list of media items in current folder along with
+ *                  requested attributes. This is called in response to
+ *                  GetFolderItems request.
+ *
+ * Returns          bt_status_t
+ *                      BT_STATUS_NOT_READY - when RC is not connected.
+ *                      BT_STATUS_SUCCESS   - always if RC is connected
+ *                      BT_STATUS_UNHANDLED - when rsp is not pending for
+ *                                            get_folder_items_list PDU
+ *
+ **************************************************************************/
+static bt_status_t get_folder_items_list_rsp(RawAddress* bd_addr,
+                                             btrc_status_t rsp_status,
+                                             uint16_t uid_counter,
+                                             uint16_t num_items,
+                                             btrc_folder_items_t* p_items) {
+  std::vector<tAVRC_ITEM> items;
+  std::vector<tAVRC_ATTR_ENTRY> attr_vals;
+  tAVRC_STS status = AVRC_STS_NO_ERROR;
+  btif_rc_device_cb_t* p_dev = btif_rc_get_device_by_bda(bd_addr);
+  int rsp_index = IDX_GET_FOLDER_ITEMS_RSP;
+  if (p_dev == NULL) {
+    BTIF_TRACE_ERROR("%s: p_dev is NULL", __func__);
+    return BT_STATUS_FAIL;
+  }
+
+  BTIF_TRACE_DEBUG("%s: uid_counter %d num_items %d", __func__, uid_counter,
+                   num_items);
+  CHECK_RC_CONNECTED(p_dev);
+
+  status = status_code_map[rsp_status];
+  if (status == AVRC_STS_NO_ERROR) {
+    status = btif_rc_convert_folder_items(num_items, p_items, &items,
+                                          &attr_vals);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_cb.lock);
+    BtifRcBrowseCache* cache = p_dev->rc_browse_cache;
+    if (cache != NULL) {
+      BtifRcBrowseCache::Request request;
+      if (!cache->CompleteRequest(&request)) {
+        BTIF_TRACE_WARNING("%s: no GetFolderItems outstanding, dropped",
+                           __func__);
+        return BT_STATUS_UNHANDLED;
+      }
+      alarm_cancel(p_dev->rc_browse_timer);
+
+      bool matched = true;
+      if (status == AVRC_STS_NO_ERROR)
+        matched = cache->Store(request, uid_counter, items.data(),
+                               items.size());
+      else
+        cache->StoreError(request, status);
+      if (!matched) {
+        BTIF_TRACE_WARNING(
+            "%s: response does not match scope: %d start_item: %u "
+            "end_item: %u, dropped",
+            __func__, request.range.scope, request.range.start_item,
+            request.range.end_item);
+      }
+
+      /* The response to a prefetch is only filed into the cache */
+      if (!request.prefetch) {
+        if (!matched) {
+          status = AVRC_STS_INTERNAL_ERR;
+          items.clear();
+        }
+        status = btif_rc_send_queued_folder_items_rsp(p_dev, status,
+                                                      uid_counter, items);
+        cache->RecordLatency(false,
+                             time_get_os_boottime_us() - request.start_us);
+      }
+      lock.unlock();
+
+      /* This runs on the media player's thread; the next request to the
+       * player has to be made from the callback thread */
+      btif_transfer_context(btif_rc_browse_next_handler, 0,
+                            (char*)&p_dev->rc_addr, sizeof(RawAddress), NULL);
+      return status == AVRC_STS_NO_ERROR ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
+    }
+  }
+
+  /* check if rsp to previous cmd was completed */
+  if (p_dev->rc_pdu_info[rsp_index].is_rsp_pending == false) {
+    BTIF_TRACE_WARNING("%s: Not sending response as no PDU was registered",
+                       __func__);
+    return BT_STATUS_UNHANDLED;
+  }
+
+  status = btif_rc_send_queued_folder_items_rsp(p_dev, status, uid_counter,
+                                                items);
+
   return status == AVRC_STS_NO_ERROR ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
 
@@ -5905,6 +6422,7 @@ static void cleanup_ctrl() {
     for (int idx = 0; idx < btif_max_rc_clients; idx++) {
       alarm_free(btif_rc_cb.rc_multi_cb[idx].rc_play_status_timer);
     }
+    btif_rc_free_all_browse_caches();
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
   }
@@ -0,0 +1,342 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "bt_btif_rc_browse_cache"
+
+#include "btif_rc_browse_cache.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <base/logging.h>
+
+BtifRcBrowseCache::BtifRcBrowseCache(size_t capacity) : capacity_(capacity) {
+  CHECK(capacity_ > 0);
+}
+
+bool BtifRcBrowseCache::IsCacheableScope(uint8_t scope) {
+  return scope == AVRC_SCOPE_FILE_SYSTEM || scope == AVRC_SCOPE_NOW_PLAYING;
+}
+
+void BtifRcBrowseCache::Latency::Add(uint64_t latency_us) {
+  count++;
+  total_us += latency_us;
+  max_us = std::max(max_us, latency_us);
+}
+
+void BtifRcBrowseCache::SetPendingRequest(const Range& range,
+                                          uint64_t start_us) {
+  CHECK(!outstanding_valid_);
+  outstanding_.range = range;
+  outstanding_.prefetch = false;
+  outstanding_.start_us = start_us;
+  outstanding_valid_ = true;
+}
+
+void BtifRcBrowseCache::SetPrefetchPending(const Range& range,
+                                           uint64_t start_us) {
+  CHECK(!outstanding_valid_);
+  outstanding_.range = range;
+  outstanding_.prefetch = true;
+  outstanding_.start_us = start_us;
+  outstanding_valid_ = true;
+  stats_.prefetches++;
+}
+
+void BtifRcBrowseCache::DeferRequest(const Range& range, uint64_t start_us) {
+  Request request;
+  request.range = range;
+  request.start_us = start_us;
+  deferred_.push_back(request);
+}
+
+bool BtifRcBrowseCache::PopDeferredRequest(Request* p_request) {
+  if (deferred_.empty()) return false;
+  *p_request = deferred_.front();
+  deferred_.pop_front();
+  return true;
+}
+
+bool BtifRcBrowseCache::CompleteRequest(Request* p_request) {
+  if (!outstanding_valid_) {
+    stats_.dropped_responses++;
+    return false;
+  }
+  *p_request = outstanding_;
+  outstanding_valid_ = false;
+  return true;
+}
+
+bool BtifRcBrowseCache::MatchesRequest(const Range& range,
+                                       const tAVRC_ITEM* p_items,
+                                       uint16_t num_items) {
+  if (range.end_item < range.start_item ||
+      num_items > (uint64_t)range.end_item - range.start_item + 1)
+    return false;
+
+  for (uint16_t i = 0; i < num_items; i++) {
+    uint8_t item_type = p_items[i].item_type;
+    switch (range.scope) {
+      case AVRC_SCOPE_PLAYER_LIST:
+        if (item_type != AVRC_ITEM_PLAYER) return false;
+        break;
+      case AVRC_SCOPE_NOW_PLAYING:
+        if (item_type != AVRC_ITEM_MEDIA) return false;
+        break;
+      default:
+        if (item_type != AVRC_ITEM_FOLDER && item_type != AVRC_ITEM_MEDIA)
+          return false;
+        break;
+    }
+  }
+  return true;
+}
+
+bool BtifRcBrowseCache::Store(const Request& request, uint16_t uid_counter,
+                              const tAVRC_ITEM* p_items, uint16_t num_items) {
+  const Range& range = request.range;
+  if (!MatchesRequest(range, p_items, num_items)) {
+    stats_.dropped_responses++;
+    return false;
+  }
+  if (request.prefetch) stats_.prefetch_fills++;
+  if (!IsCacheableScope(range.scope)) return true;
+
+  uint32_t skip = 0;
+  if (valid_ && scope_ == range.scope && attrs_ == range.attrs &&
+      uid_counter_ == uid_counter && range.start_item >= base_ &&
+      range.start_item <= WindowEnd()) {
+    skip = WindowEnd() - range.start_item;
+  } else if (request.prefetch) {
+    /* The window moved on while the prefetch was in flight */
+    return true;
+  } else {
+    Reset(range, uid_counter);
+  }
+
+  for (uint32_t i = skip; i < num_items; i++) Append(p_items[i]);
+
+  uint64_t requested = (uint64_t)range.end_item - range.start_item + 1;
+  if (num_items < requested &&
+      (uint64_t)range.start_item + num_items >= WindowEnd())
+    end_of_folder_ = true;
+
+  if (entries_.size() > capacity_) {
+    /* Keep the most recent three quarters of the window so that a remote
+     * scrolling back by a page still hits. */
+    Compact(WindowEnd() - (capacity_ * 3) / 4);
+  }
+
+  if (!request.prefetch) {
+    last_served_ = range;
+    last_served_valid_ = true;
+  }
+  return true;
+}
+
+void BtifRcBrowseCache::StoreError(const Request& request, tAVRC_STS status) {
+  if (request.prefetch && status == AVRC_STS_BAD_RANGE && valid_ &&
+      request.range.scope == scope_ &&
+      request.range.start_item == WindowEnd())
+    end_of_folder_ = true;
+}
+
+bool BtifRcBrowseCache::Lookup(const Range& range, uint16_t* p_uid_counter,
+                               std::vector<tAVRC_ITEM>* p_items) {
+  if (!valid_ || scope_ != range.scope || attrs_ != range.attrs ||
+      range.end_item < range.start_item || range.start_item < base_ ||
+      range.start_item >= WindowEnd() ||
+      (range.end_item >= WindowEnd() && !end_of_folder_)) {
+    stats_.misses++;
+    return false;
+  }
+
+  uint32_t first = range.start_item - base_;
+  uint32_t last = std::min<uint32_t>(range.end_item, WindowEnd() - 1) - base_;
+
+  /* Size the attribute scratch up front so that p_attr_list pointers handed
+   * out below are not invalidated by reallocation. */
+  size_t num_attrs = 0;
+  for (uint32_t i = first; i <= last; i++) num_attrs += entries_[i].attr_count;
+  attr_scratch_.clear();
+  attr_scratch_.reserve(num_attrs);
+
+  p_items->clear();
+  p_items->reserve(last - first + 1);
+  for (uint32_t i = first; i <= last; i++) {
+    const Entry& entry = entries_[i];
+    tAVRC_ITEM item;
+    memset(&item, 0, sizeof(item));
+    item.item_type = entry.item_type;
+    if (entry.item_type == AVRC_ITEM_FOLDER) {
+      memcpy(item.u.folder.uid, entry.uid, sizeof(tAVRC_UID));
+      item.u.folder.type = entry.type;
+      item.u.folder.playable = entry.playable;
+      item.u.folder.name.charset_id = entry.charset_id;
+      item.u.folder.name.str_len = entry.name_len;
+      item.u.folder.name.p_str = &arena_[entry.name_offset];
+    } else {
+      memcpy(item.u.media.uid, entry.uid, sizeof(tAVRC_UID));
+      item.u.media.type = entry.type;
+      item.u.media.name.charset_id = entry.charset_id;
+      item.u.media.name.str_len = entry.name_len;
+      item.u.media.name.p_str = &arena_[entry.name_offset];
+      item.u.media.attr_count = entry.attr_count;
+      item.u.media.p_attr_list = NULL;
+      if (entry.attr_count > 0) {
+        item.u.media.p_attr_list = attr_scratch_.data() + attr_scratch_.size();
+        for (uint8_t a = 0; a < entry.attr_count; a++) {
+          const AttrEntry& attr = attr_entries_[entry.attr_first + a];
+          tAVRC_ATTR_ENTRY attr_val;
+          attr_val.attr_id = attr.attr_id;
+          attr_val.name.charset_id = attr.charset_id;
+          attr_val.name.str_len = attr.str_len;
+          attr_val.name.p_str = &arena_[attr.str_offset];
+          attr_scratch_.push_back(attr_val);
+        }
+      }
+    }
+    p_items->push_back(item);
+  }
+
+  *p_uid_counter = uid_counter_;
+  last_served_ = range;
+  last_served_valid_ = true;
+  stats_.hits++;
+  return true;
+}
+
+bool BtifRcBrowseCache::GetPrefetchRange(Range* p_range) const {
+  if (!valid_ || end_of_folder_ || outstanding_valid_ || !deferred_.empty() ||
+      !last_served_valid_)
+    return false;
+  if (last_served_.scope != scope_ || last_served_.attrs != attrs_ ||
+      last_served_.end_item < last_served_.start_item)
+    return false;
+
+  uint32_t page = last_served_.end_item - last_served_.start_item + 1;
+  /* Only fetch ahead when the remote is paging near the end of the window */
+  if ((uint64_t)last_served_.end_item + page < WindowEnd()) return false;
+  if (last_served_.start_item < base_) return false;
+
+  p_range->scope = scope_;
+  p_range->start_item = WindowEnd();
+  p_range->end_item = WindowEnd() + page - 1;
+  p_range->attrs = attrs_;
+  return true;
+}
+
+void BtifRcBrowseCache::RecordLatency(bool hit, uint64_t latency_us) {
+  if (hit)
+    stats_.hit_latency.Add(latency_us);
+  else
+    stats_.miss_latency.Add(latency_us);
+}
+
+void BtifRcBrowseCache::OnUidCounterChanged(uint16_t uid_counter) {
+  if (valid_ && uid_counter_ != uid_counter) Invalidate();
+}
+
+void BtifRcBrowseCache::InvalidateScope(uint8_t scope) {
+  if (valid_ && scope_ == scope) Invalidate();
+}
+
+void BtifRcBrowseCache::Invalidate() {
+  if (valid_) stats_.invalidations++;
+  valid_ = false;
+  end_of_folder_ = false;
+  last_served_valid_ = false;
+  base_ = 0;
+  entries_.clear();
+  attr_entries_.clear();
+  arena_.clear();
+  attr_scratch_.clear();
+}
+
+void BtifRcBrowseCache::Reset(const Range& range, uint16_t uid_counter) {
+  entries_.clear();
+  attr_entries_.clear();
+  arena_.clear();
+  attr_scratch_.clear();
+  end_of_folder_ = false;
+  last_served_valid_ = false;
+  valid_ = true;
+  scope_ = range.scope;
+  attrs_ = range.attrs;
+  uid_counter_ = uid_counter;
+  base_ = range.start_item;
+}
+
+uint32_t BtifRcBrowseCache::AddString(const uint8_t* p_str, uint16_t len) {
+  uint32_t offset = arena_.size();
+  if (p_str != NULL && len > 0) arena_.insert(arena_.end(), p_str, p_str + len);
+  /* Keep strings NUL terminated for logging on the response path */
+  arena_.push_back(0);
+  return offset;
+}
+
+void BtifRcBrowseCache::Append(const tAVRC_ITEM& item) {
+  Entry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.item_type = item.item_type;
+  entry.attr_first = attr_entries_.size();
+  if (item.item_type == AVRC_ITEM_FOLDER) {
+    memcpy(entry.uid, item.u.folder.uid, sizeof(tAVRC_UID));
+    entry.type = item.u.folder.type;
+    entry.playable = item.u.folder.playable;
+    entry.charset_id = item.u.folder.name.charset_id;
+    entry.name_len = item.u.folder.name.str_len;
+    entry.name_offset =
+        AddString(item.u.folder.name.p_str, item.u.folder.name.str_len);
+  } else {
+    memcpy(entry.uid, item.u.media.uid, sizeof(tAVRC_UID));
+    entry.type = item.u.media.type;
+    entry.charset_id = item.u.media.name.charset_id;
+    entry.name_len = item.u.media.name.str_len;
+    entry.name_offset =
+        AddString(item.u.media.name.p_str, item.u.media.name.str_len);
+    if (item.u.media.p_attr_list != NULL) {
+      entry.attr_count = item.u.media.attr_count;
+      for (uint8_t a = 0; a < item.u.media.attr_count; a++) {
+        const tAVRC_ATTR_ENTRY& src = item.u.media.p_attr_list[a];
+        AttrEntry attr;
+        attr.attr_id = src.attr_id;
+        attr.charset_id = src.name.charset_id;
+        attr.str_len = src.name.str_len;
+        attr.str_offset = AddString(src.name.p_str, src.name.str_len);
+        attr_entries_.push_back(attr);
+      }
+    }
+  }
+  entries_.push_back(entry);
+}
+
+void BtifRcBrowseCache::Compact(uint32_t new_base) {
+  if (new_base <= base_ || new_base >= WindowEnd()) return;
+
+  std::vector<Entry> old_entries;
+  std::vector<AttrEntry> old_attrs;
+  std::vector<uint8_t> old_arena;
+  old_entries.swap(entries_);
+  old_attrs.swap(attr_entries_);
+  old_arena.swap(arena_);
+
+  for (size_t i = new_base - base_; i < old_entries.size(); i++) {
+    Entry entry = old_entries[i];
+    entry.name_offset =
+        AddString(&old_arena[entry.name_offset], entry.name_len);
+    uint32_t attr_first = attr_entries_.size();
+    for (uint8_t a = 0; a < entry.attr_count; a++) {
+      AttrEntry attr = old_attrs[entry.attr_first + a];
+      attr.str_offset = AddString(&old_arena[attr.str_offset], attr.str_len);
+      attr_entries_.push_back(attr);
+    }
+    entry.attr_first = attr_first;
+    entries_.push_back(entry);
+  }
+  base_ = new_base;
+}
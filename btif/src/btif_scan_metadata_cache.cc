@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btif_scan_metadata_cache.h"
+
+#include <functional>
+#include <iterator>
+
+size_t BtifScanMetadataCache::AddressHash::operator()(
+    const RawAddress& bd_addr) const {
+  uint64_t key = 0;
+  for (size_t i = 0; i < RawAddress::kLength; i++)
+    key = (key << 8) | bd_addr.address[i];
+  return std::hash<uint64_t>()(key);
+}
+
+BtifScanMetadataCache::BtifScanMetadataCache(Storage* storage,
+                                             size_t capacity)
+    : storage_(storage), capacity_(capacity) {
+  index_.reserve(capacity);
+}
+
+BtifScanMetadataCache::Entry* BtifScanMetadataCache::Lookup(
+    const RawAddress& bd_addr) {
+  auto it = index_.find(bd_addr);
+  if (it != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &entries_.front();
+  }
+
+  if (index_.size() >= capacity_) {
+    /* Reuse the least recently seen entry; its data is in storage */
+    Entry& oldest = entries_.back();
+    index_.erase(oldest.bd_addr);
+    entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+    stats_.evictions++;
+  } else {
+    entries_.emplace_front();
+  }
+
+  Entry& entry = entries_.front();
+  entry.bd_addr = bd_addr;
+  entry.dev_type = 0;
+  entry.addr_type = kUnknownAddrType;
+  entry.loaded = false;
+  entry.reported = false;
+  index_.emplace(bd_addr, entries_.begin());
+  return &entry;
+}
+
+void BtifScanMetadataCache::Load(Entry* entry) {
+  uint32_t dev_type = 0;
+  uint8_t addr_type = kUnknownAddrType;
+  if (!storage_->GetDeviceType(entry->bd_addr, &dev_type)) dev_type = 0;
+  if (!storage_->GetAddrType(entry->bd_addr, &addr_type))
+    addr_type = kUnknownAddrType;
+  entry->dev_type = dev_type;
+  entry->addr_type = addr_type;
+  entry->loaded = true;
+  stats_.loads++;
+}
+
+void BtifScanMetadataCache::WriteDeviceType(Entry* entry, uint32_t dev_type) {
+  /* Keep bits stored by other paths since the entry was loaded, e.g. BR/EDR
+   * learnt from inquiry */
+  uint32_t stored = 0;
+  if (!storage_->GetDeviceType(entry->bd_addr, &stored)) stored = 0;
+  dev_type |= stored;
+  if (dev_type != stored) {
+    storage_->SetDeviceType(entry->bd_addr, dev_type);
+    stats_.writes++;
+  }
+  entry->dev_type = dev_type;
+}
+
+bool BtifScanMetadataCache::Update(const RawAddress& bd_addr,
+                                   uint32_t device_type, uint8_t addr_type) {
+  Entry* entry = Lookup(bd_addr);
+  if (!entry->loaded) Load(entry);
+  stats_.updates++;
+
+  bool changed = false;
+  uint32_t dev_type = entry->dev_type | device_type;
+  if (dev_type != entry->dev_type && dev_type != 0) {
+    WriteDeviceType(entry, dev_type);
+    changed = true;
+  }
+  if (addr_type != entry->addr_type) {
+    entry->addr_type = addr_type;
+    storage_->SetAddrType(bd_addr, addr_type);
+    stats_.writes++;
+    changed = true;
+  }
+
+  if (!changed) stats_.unchanged++;
+  return changed;
+}
+
+bool BtifScanMetadataCache::MarkReported(const RawAddress& bd_addr) {
+  Entry* entry = Lookup(bd_addr);
+  if (entry->reported) return false;
+  entry->reported = true;
+  return true;
+}
+
+void BtifScanMetadataCache::ResetReported() {
+  for (Entry& entry : entries_) entry.reported = false;
+}
+
+void BtifScanMetadataCache::Forget(const RawAddress& bd_addr) {
+  auto it = index_.find(bd_addr);
+  if (it == index_.end()) return;
+  entries_.erase(it->second);
+  index_.erase(it);
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "bt_btif_sock"
+
+#include "btif_sock_io.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+ssize_t btsock_recv_bufs(int fd, BT_HDR** bufs, size_t count,
+                         uint16_t max_len) {
+  struct iovec iov[BTSOCK_IO_MAX_BUFS];
+  if (count > BTSOCK_IO_MAX_BUFS) count = BTSOCK_IO_MAX_BUFS;
+
+  for (size_t i = 0; i < count; i++) {
+    bufs[i]->len = 0;
+    iov[i].iov_base = bufs[i]->data + bufs[i]->offset;
+    iov[i].iov_len = max_len;
+  }
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+
+  ssize_t received;
+  OSI_NO_INTR(received = recvmsg(fd, &msg, MSG_DONTWAIT));
+  if (received == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    LOG_ERROR(LOG_TAG, "%s error receiving data from app on fd %d: %s",
+              __func__, fd, strerror(errno));
+    return -1;
+  }
+
+  size_t left = received;
+  for (size_t i = 0; i < count && left > 0; i++) {
+    bufs[i]->len = (left < max_len) ? left : max_len;
+    left -= bufs[i]->len;
+  }
+  return received;
+}
+
+int btsock_send_bufs(int fd, BT_HDR** bufs, size_t count) {
+  struct iovec iov[BTSOCK_IO_MAX_BUFS];
+  if (count > BTSOCK_IO_MAX_BUFS) count = BTSOCK_IO_MAX_BUFS;
+
+  size_t iovcnt = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (bufs[i]->len == 0) continue;
+    iov[iovcnt].iov_base = bufs[i]->data + bufs[i]->offset;
+    iov[iovcnt].iov_len = bufs[i]->len;
+    iovcnt++;
+  }
+  if (iovcnt == 0) return count;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+
+  ssize_t sent;
+  OSI_NO_INTR(sent = sendmsg(fd, &msg, MSG_DONTWAIT));
+  if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    sent = 0;
+  } else if (sent <= 0) {
+    LOG_ERROR(LOG_TAG, "%s error writing data back to app on fd %d: %s",
+              __func__, fd, strerror(errno));
+    return -1;
+  }
+
+  size_t left = sent;
+  size_t done = 0;
+  for (; done < count; done++) {
+    BT_HDR* p_buf = bufs[done];
+    if (left < p_buf->len) {
+      p_buf->offset += left;
+      p_buf->len -= left;
+      break;
+    }
+    left -= p_buf->len;
+    p_buf->offset += p_buf->len;
+    p_buf->len = 0;
+  }
+  return done;
+}
+
+int btsock_send_packets(int fd, BT_HDR** bufs, size_t count) {
+  struct iovec iov[BTSOCK_IO_MAX_BUFS];
+  struct mmsghdr msgs[BTSOCK_IO_MAX_BUFS];
+  if (count > BTSOCK_IO_MAX_BUFS) count = BTSOCK_IO_MAX_BUFS;
+  if (count == 0) return 0;
+
+  memset(msgs, 0, count * sizeof(msgs[0]));
+  for (size_t i = 0; i < count; i++) {
+    iov[i].iov_base = bufs[i]->data + bufs[i]->offset;
+    iov[i].iov_len = bufs[i]->len;
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int sent;
+  OSI_NO_INTR(sent = sendmmsg(fd, msgs, count, MSG_DONTWAIT));
+  if (sent == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    LOG_ERROR(LOG_TAG, "%s error writing packets to app on fd %d: %s",
+              __func__, fd, strerror(errno));
+    return -1;
+  }
+
+  int done = 0;
+  for (; done < sent; done++) {
+    BT_HDR* p_buf = bufs[done];
+    uint16_t len = msgs[done].msg_len;
+    p_buf->offset += len;
+    p_buf->len -= len;
+    if (p_buf->len != 0) break;
+  }
+  return done;
+}
+
+void btsock_pkt_ring_push(btsock_pkt_ring_t* ring, BT_HDR* p_buf) {
+  if (ring->count == ring->capacity) {
+    uint32_t capacity = ring->capacity ? 2 * ring->capacity : 16;
+    BT_HDR** bufs = (BT_HDR**)osi_malloc(capacity * sizeof(BT_HDR*));
+    for (uint32_t i = 0; i < ring->count; i++)
+      bufs[i] = ring->bufs[(ring->head + i) % ring->capacity];
+    osi_free(ring->bufs);
+    ring->bufs = bufs;
+    ring->capacity = capacity;
+    ring->head = 0;
+  }
+
+  ring->bufs[(ring->head + ring->count) % ring->capacity] = p_buf;
+  ring->count++;
+  ring->bytes += p_buf->len;
+}
+
+void btsock_pkt_ring_clear(btsock_pkt_ring_t* ring) {
+  for (uint32_t i = 0; i < ring->count; i++)
+    osi_free(ring->bufs[(ring->head + i) % ring->capacity]);
+  osi_free(ring->bufs);
+  memset(ring, 0, sizeof(*ring));
+}
+
+int btsock_pkt_ring_send(int fd, btsock_pkt_ring_t* ring) {
+  BT_HDR* batch[BTSOCK_IO_MAX_BUFS];
+
+  while (ring->count > 0) {
+    size_t count = 0;
+    while (count < BTSOCK_IO_MAX_BUFS && count < ring->count) {
+      batch[count] = ring->bufs[(ring->head + count) % ring->capacity];
+      count++;
+    }
+
+    uint32_t before = 0;
+    for (size_t i = 0; i < count; i++) before += batch[i]->len;
+    int done = btsock_send_packets(fd, batch, count);
+    if (done < 0) return -1;
+
+    uint32_t after = 0;
+    for (size_t i = done; i < count; i++) after += batch[i]->len;
+    ring->bytes -= before - after;
+
+    for (int i = 0; i < done; i++) osi_free(batch[i]);
+    ring->head = (ring->head + done) % ring->capacity;
+    ring->count -= done;
+
+    if ((size_t)done < count) return 1;
+  }
+  return 0;
+}
@@ -27,6 +27,7 @@
 #include <unistd.h>
 
 #include <mutex>
+#include <unordered_map>
 
 #include <hardware/bt_sock.h>
 
@@ -39,6 +40,7 @@
 #include "bta_jv_api.h"
 #include "bta_jv_co.h"
 #include "btif_common.h"
+#include "btif_sock_io.h"
 #include "btif_sock_sdp.h"
 #include "btif_sock_thread.h"
 #include "btif_sock_util.h"
@@ -54,12 +56,6 @@
 #include "port_api.h"
 #include "sdp_api.h"
 
-struct packet {
-  struct packet *next, *prev;
-  uint32_t len;
-  uint8_t* data;
-};
-
 typedef struct l2cap_socket {
   struct l2cap_socket* prev;  // link to prev list item
   struct l2cap_socket* next;  // link to next list item
@@ -73,9 +69,7 @@ typedef struct l2cap_socket {
   int our_fd;                 // fd from our side
   int app_fd;                 // fd from app's side
 
-  unsigned bytes_buffered;
-  struct packet* first_packet;  // fist packet to be delivered to app
-  struct packet* last_packet;   // last packet to be delivered to app
+  btsock_pkt_ring_t rx_ring;  // received SDUs to be delivered to app
 
   unsigned fixed_chan : 1;        // fixed channel (or psm?)
   unsigned server : 1;            // is a server? (or connecting?)
@@ -91,6 +85,8 @@ static bt_status_t btSock_start_l2cap_server_l(l2cap_socket* sock);
 static std::mutex state_lock;
 
 l2cap_socket* socks = NULL;
+/* Sockets in |socks| by id, for the lookup on every stack callback */
+static std::unordered_map<uint32_t, l2cap_socket*> socks_by_id;
 static uint32_t last_sock_id = 0;
 static uid_set_t* uid_set = NULL;
 static int pth = -1;
@@ -98,106 +94,10 @@ static int pth = -1;
 static void btsock_l2cap_cbk(tBTA_JV_EVT event, tBTA_JV* p_data,
                              uint32_t l2cap_socket_id);
 
-/* TODO: Consider to remove this buffer, as we have a buffer in l2cap as well,
- * and we risk
- *       a buffer overflow with this implementation if the socket data is not
- * read from
- *       JAVA for a while. In such a case we should use flow control to tell the
- * sender to
- *       back off.
- *       BUT remember we need to avoid blocking the BTA task execution - hence
- * we cannot
- *       directly write to the socket.
- *       we should be able to change to store the data pointer here, and just
- * wait
- *       confirming the l2cap_ind until we have more space in the buffer. */
-
-/* returns false if none - caller must free "data" memory when done with it */
-static char packet_get_head_l(l2cap_socket* sock, uint8_t** data,
-                              uint32_t* len) {
-  struct packet* p = sock->first_packet;
-
-  if (!p) return false;
-
-  if (data) *data = sock->first_packet->data;
-  if (len) *len = sock->first_packet->len;
-  sock->first_packet = p->next;
-  if (sock->first_packet)
-    sock->first_packet->prev = NULL;
-  else
-    sock->last_packet = NULL;
-
-  if (len) sock->bytes_buffered -= *len;
-
-  osi_free(p);
-
-  return true;
-}
-
-static struct packet* packet_alloc(const uint8_t* data, uint32_t len) {
-  struct packet* p = (struct packet*)osi_calloc(sizeof(*p));
-  uint8_t* buf = (uint8_t*)osi_malloc(len);
-
-  p->data = buf;
-  p->len = len;
-  memcpy(p->data, data, len);
-  return p;
-}
-
-/* makes a copy of the data, returns true on success */
-static char packet_put_head_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
-
-  /*
-   * We do not check size limits here since this is used to undo "getting" a
-   * packet that the user read incompletely. That is to say the packet was
-   * already in the queue. We do check thos elimits in packet_put_tail_l() since
-   * that function is used to put new data into the queue.
-   */
-
-  if (!p) return false;
-
-  p->prev = NULL;
-  p->next = sock->first_packet;
-  sock->first_packet = p;
-  if (p->next)
-    p->next->prev = p;
-  else
-    sock->last_packet = p;
-
-  sock->bytes_buffered += len;
-
-  return true;
-}
-
-/* makes a copy of the data, returns true on success */
-static char packet_put_tail_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
-
-  if (sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER) {
-    LOG_ERROR(LOG_TAG, "packet_put_tail_l: buffer overflow");
-    return false;
-  }
-
-  if (!p) {
-    LOG_ERROR(LOG_TAG, "packet_put_tail_l: unable to allocate packet...");
-    return false;
-  }
-
-  p->next = NULL;
-  p->prev = sock->last_packet;
-  sock->last_packet = p;
-  if (p->prev)
-    p->prev->next = p;
-  else
-    sock->first_packet = p;
-
-  sock->bytes_buffered += len;
-
-  return true;
-}
+/* Received SDUs are queued in the socket's rx_ring until the app reads them.
+ * The ring is bounded by L2CAP_MAX_RX_BUFFER bytes; a connection whose app
+ * falls further behind is dropped rather than flow controlled, as the BTA
+ * task must not block on the app socket. */
 
 static char is_inited(void) {
   std::unique_lock<std::mutex> lock(state_lock);
@@ -206,15 +106,20 @@ static char is_inited(void) {
 
 /* only call with std::mutex taken */
 static l2cap_socket* btsock_l2cap_find_by_id_l(uint32_t id) {
-  l2cap_socket* sock = socks;
-
-  while (sock && sock->id != id) sock = sock->next;
+  auto it = socks_by_id.find(id);
+  return (it != socks_by_id.end()) ? it->second : NULL;
+}
 
-  return sock;
+/* only call with std::mutex taken */
+static void btsock_l2cap_swap_ids_l(l2cap_socket* a, l2cap_socket* b) {
+  uint32_t id = a->id;
+  a->id = b->id;
+  b->id = id;
+  socks_by_id[a->id] = a;
+  socks_by_id[b->id] = b;
 }
 
 static void btsock_l2cap_free_l(l2cap_socket* sock) {
-  uint8_t* buf;
   l2cap_socket* t = socks;
 
   while (t && t != sock) t = t->next;
@@ -222,6 +127,8 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
   if (!t) /* prever double-frees */
     return;
 
+  socks_by_id.erase(sock->id);
+
   if (sock->next) sock->next->prev = sock->prev;
 
   if (sock->prev)
@@ -237,7 +144,7 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
     APPL_TRACE_ERROR("SOCK_LIST: free(id = %d) - NO app_fd!", sock->id);
   }
 
-  while (packet_get_head_l(sock, &buf, NULL)) osi_free(buf);
+  btsock_pkt_ring_clear(&sock->rx_ring);
 
   APPL_TRACE_DEBUG("%s: fixed_chan=%d, channel=%d is_le_soc=%d handle=%d sock_id:%d is_server=%d",
                      __func__, sock->fixed_chan, sock->channel, sock->is_le_coc, sock->handle,
@@ -315,9 +222,6 @@ static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
   if (name) strncpy(sock->name, name, sizeof(sock->name) - 1);
   if (addr) sock->addr = *addr;
 
-  sock->first_packet = NULL;
-  sock->last_packet = NULL;
-
   sock->mps = L2CAP_LE_MIN_MPS;
 
   sock->next = socks;
@@ -328,17 +232,13 @@ static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
   /* paranoia cap on: verify no ID duplicates due to overflow and fix as needed
    */
   while (1) {
-    l2cap_socket* t;
-    t = socks->next;
-    while (t && t->id != sock->id) {
-      t = t->next;
-    }
-    if (!t && sock->id) /* non-zeor handle is unique -> we're done */
-      break;
+    if (sock->id && !socks_by_id.count(sock->id))
+      break; /* non-zeor handle is unique -> we're done */
     /* if we're here, we found a duplicate */
     if (!++sock->id) /* no zero IDs allowed */
       sock->id++;
   }
+  socks_by_id[sock->id] = sock;
   last_sock_id = sock->id;
   APPL_TRACE_DEBUG("SOCK_LIST: alloc(id = %d)", sock->id);
   return sock;
@@ -353,6 +253,7 @@ bt_status_t btsock_l2cap_init(int handle, uid_set_t* set) {
   std::unique_lock<std::mutex> lock(state_lock);
   pth = handle;
   socks = NULL;
+  socks_by_id.clear();
   uid_set = set;
   return BT_STATUS_SUCCESS;
 }
@@ -442,7 +343,6 @@ static void on_cl_l2cap_init(tBTA_JV_L2CAP_CL_INIT* p_init, uint32_t id) {
 static void on_srv_l2cap_psm_connect_l(tBTA_JV_L2CAP_OPEN* p_open,
                                        l2cap_socket* sock) {
   l2cap_socket* accept_rs;
-  uint32_t new_listen_id;
 
   // std::mutex locked by caller
   accept_rs = btsock_l2cap_alloc_l(sock->name, &p_open->rem_bda, false, 0);
@@ -461,9 +361,7 @@ static void on_srv_l2cap_psm_connect_l(tBTA_JV_L2CAP_OPEN* p_open,
     /* Swap IDs to hand over the GAP connection to the accepted socket, and start
        a new server on
        the newly create socket ID. */
-    new_listen_id = accept_rs->id;
-    accept_rs->id = sock->id;
-    sock->id = new_listen_id;
+    btsock_l2cap_swap_ids_l(accept_rs, sock);
   } else {
     APPL_TRACE_ERROR("Memory not allocated for accept_rs..");
   }
@@ -494,15 +392,12 @@ static void on_srv_l2cap_psm_connect_l(tBTA_JV_L2CAP_OPEN* p_open,
 static void on_srv_l2cap_le_connect_l(tBTA_JV_L2CAP_LE_OPEN* p_open,
                                       l2cap_socket* sock) {
   l2cap_socket* accept_rs;
-  uint32_t new_listen_id;
 
   // std::mutex locked by caller
   accept_rs = btsock_l2cap_alloc_l(sock->name, &p_open->rem_bda, false, 0);
   if (accept_rs) {
     // swap IDs
-    new_listen_id = accept_rs->id;
-    accept_rs->id = sock->id;
-    sock->id = new_listen_id;
+    btsock_l2cap_swap_ids_l(accept_rs, sock);
 
     accept_rs->handle = p_open->handle;
     accept_rs->connected = true;
@@ -724,10 +619,12 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
 
     tBTA_JV_LE_DATA_IND* p_le_data_ind = &evt->le_data_ind;
     BT_HDR* p_buf = p_le_data_ind->p_buf;
-    uint8_t* data = (uint8_t*)(p_buf + 1) + p_buf->offset;
 
-    if (packet_put_tail_l(sock, data, p_buf->len)) {
+    if (sock->rx_ring.bytes < L2CAP_MAX_RX_BUFFER) {
+      // the buffer is queued as it is, and now ours to free
+      p_le_data_ind->p_buf = NULL;
       bytes_read = p_buf->len;
+      btsock_pkt_ring_push(&sock->rx_ring, p_buf);
       btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
                            sock->id);
     } else {  // connection must be dropped
@@ -739,25 +636,27 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
     }
 
   } else {
-    uint8_t buffer[L2CAP_MAX_SDU_LENGTH];
-    uint32_t count;
-
-    if (BTA_JvL2capReady(sock->handle, &count) == BTA_JV_SUCCESS) {
-      if (BTA_JvL2capRead(sock->handle, sock->id, buffer, count) ==
-          BTA_JV_SUCCESS) {
-        if (packet_put_tail_l(sock, buffer, count)) {
-          bytes_read = count;
-          btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP,
-                               SOCK_THREAD_FD_WR, sock->id);
-        } else {  // connection must be dropped
-          APPL_TRACE_DEBUG(
-              "on_l2cap_data_ind() unable to push data to socket"
-              " - closing channel");
-          BTA_JvL2capClose(sock->handle);
-          btsock_l2cap_free_l(sock);
-        }
+    BT_HDR* p_buf;
+
+    while (BTA_JvL2capReadBuf(sock->handle, &p_buf) == BTA_JV_SUCCESS) {
+      if (sock->rx_ring.bytes >= L2CAP_MAX_RX_BUFFER) {
+        // connection must be dropped
+        APPL_TRACE_DEBUG(
+            "on_l2cap_data_ind() unable to push data to socket"
+            " - closing channel");
+        osi_free(p_buf);
+        BTA_JvL2capClose(sock->handle);
+        btsock_l2cap_free_l(sock);
+        sock = NULL;
+        break;
       }
+      bytes_read += p_buf->len;
+      btsock_pkt_ring_push(&sock->rx_ring, p_buf);
     }
+
+    if (sock && bytes_read)
+      btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
+                           sock->id);
   }
 
   uid_set_add_rx(uid_set, app_uid, bytes_read);
@@ -1016,29 +915,9 @@ bt_status_t btsock_l2cap_connect(const RawAddress* bd_addr, int channel,
  * (for example: unrecoverable error or no data)
  */
 static bool flush_incoming_que_on_wr_signal_l(l2cap_socket* sock) {
-  uint8_t* buf;
-  uint32_t len;
-
-  while (packet_get_head_l(sock, &buf, &len)) {
-    ssize_t sent;
-    OSI_NO_INTR(sent = send(sock->our_fd, buf, len, MSG_DONTWAIT));
-    int saved_errno = errno;
-
-    if (sent == (signed)len)
-      osi_free(buf);
-    else if (sent >= 0) {
-      packet_put_head_l(sock, buf + sent, len - sent);
-      osi_free(buf);
-      if (!sent) /* special case if other end not keeping up */
-        return true;
-    } else {
-      packet_put_head_l(sock, buf, len);
-      osi_free(buf);
-      return saved_errno == EWOULDBLOCK || saved_errno == EAGAIN;
-    }
-  }
-
-  return false;
+  /* Each queued SDU is one message on the SOCK_SEQPACKET socket; they are sent
+   * in batches with one sendmmsg each. */
+  return btsock_pkt_ring_send(sock->our_fd, &sock->rx_ring) == 1;
 }
 
 inline BT_HDR* malloc_l2cap_buf(uint16_t len) {
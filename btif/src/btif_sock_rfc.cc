@@ -39,6 +39,7 @@
 #include "bta_jv_api.h"
 #include "bta_jv_co.h"
 #include "btif_common.h"
+#include "btif_sock_io.h"
 #include "btif_sock_sdp.h"
 #include "btif_sock_thread.h"
 #include "btif_sock_util.h"
@@ -760,54 +761,31 @@ static void jv_dm_cback(tBTA_JV_EVT event, tBTA_JV* p_data, uint32_t id) {
   }
 }
 
-typedef enum {
-  SENT_FAILED,
-  SENT_NONE,
-  SENT_PARTIAL,
-  SENT_ALL,
-} sent_status_t;
-
-static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
-  if (p_buf->len == 0) return SENT_ALL;
-
-  ssize_t sent;
-  OSI_NO_INTR(
-      sent = send(fd, p_buf->data + p_buf->offset, p_buf->len, MSG_DONTWAIT));
-
-  if (sent == -1) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) return SENT_NONE;
-    LOG_ERROR(LOG_TAG, "%s error writing RFCOMM data back to app: %s", __func__,
-              strerror(errno));
-    return SENT_FAILED;
-  }
-
-  if (sent == 0) return SENT_FAILED;
-
-  if (sent == p_buf->len) return SENT_ALL;
-
-  p_buf->offset += sent;
-  p_buf->len -= sent;
-  return SENT_PARTIAL;
-}
-
 static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
+  BT_HDR* bufs[BTSOCK_IO_MAX_BUFS];
+
   while (!list_is_empty(slot->incoming_queue)) {
-    BT_HDR* p_buf = (BT_HDR*)list_front(slot->incoming_queue);
-    switch (send_data_to_app(slot->fd, p_buf)) {
-      case SENT_NONE:
-      case SENT_PARTIAL:
-        // monitor the fd to get callback when app is ready to receive data
-        btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR,
-                             slot->id);
-        return true;
+    // Hand the app as many queued buffers as one write takes
+    size_t count = 0;
+    for (const list_node_t* node = list_begin(slot->incoming_queue);
+         node != list_end(slot->incoming_queue) && count < BTSOCK_IO_MAX_BUFS;
+         node = list_next(node)) {
+      bufs[count++] = (BT_HDR*)list_node(node);
+    }
 
-      case SENT_ALL:
-        list_remove(slot->incoming_queue, p_buf);
-        break;
+    int sent = btsock_send_bufs(slot->fd, bufs, count);
+    if (sent < 0) {
+      list_remove(slot->incoming_queue, bufs[0]);
+      return false;
+    }
+
+    for (int i = 0; i < sent; i++) list_remove(slot->incoming_queue, bufs[i]);
 
-      case SENT_FAILED:
-        list_remove(slot->incoming_queue, p_buf);
-        return false;
+    if ((size_t)sent < count) {
+      // monitor the fd to get callback when app is ready to receive data
+      btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR,
+                           slot->id);
+      return true;
     }
   }
 
@@ -875,20 +853,19 @@ int bta_co_rfc_data_incoming(uint32_t id, BT_HDR* p_buf) {
   bytes_rx = p_buf->len;
 
   if (list_is_empty(slot->incoming_queue)) {
-    switch (send_data_to_app(slot->fd, p_buf)) {
-      case SENT_NONE:
-      case SENT_PARTIAL:
+    switch (btsock_send_bufs(slot->fd, &p_buf, 1)) {
+      case 0:
         list_append(slot->incoming_queue, p_buf);
         btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR,
                              slot->id);
         break;
 
-      case SENT_ALL:
+      case 1:
         osi_free(p_buf);
         ret = 1;  // Enable data flow.
         break;
 
-      case SENT_FAILED:
+      default:
         osi_free(p_buf);
         cleanup_rfc_slot(slot);
         break;
@@ -937,6 +914,21 @@ int bta_co_rfc_data_outgoing(uint32_t id, uint8_t* buf, uint16_t size) {
   return true;
 }
 
+int bta_co_rfc_data_outgoing_bufs(uint32_t id, BT_HDR** bufs, uint16_t count,
+                                  uint16_t max_len) {
+  std::unique_lock<std::recursive_mutex> lock(slot_lock);
+  rfc_slot_t* slot = find_rfc_slot_by_id(id);
+  if (!slot) return -1;
+
+  ssize_t received = btsock_recv_bufs(slot->fd, bufs, count, max_len);
+  if (received < 0) {
+    cleanup_rfc_slot(slot);
+    return -1;
+  }
+
+  return received;
+}
+
 static rfc_slot_t* find_rfc_slot_by_scn(int scn)
 {
     int i;
@@ -59,6 +59,7 @@
 #include "bta_hh_api.h"
 #include "btif_api.h"
 #include "btif_config.h"
+#include "btif_gatt.h"
 #include "btif_hd.h"
 #include "btif_hh.h"
 #include "btif_util.h"
@@ -1069,6 +1070,8 @@ bt_status_t btif_storage_remove_bonded_device(
   BTIF_TRACE_DEBUG("in bd addr:%s", bdstr);
 
   btif_storage_remove_ble_bonding_keys(remote_bd_addr);
+  /* DevType and AddrType go too, the scanner has to store them again */
+  btif_ble_scanner_forget_device(*remote_bd_addr);
 
   int ret = 1;
   if (btif_config_exist(bdstr, "LinkKeyType"))
@@ -22,11 +22,24 @@
  *                 socket usage per app UID.
  *
  ******************************************************************************/
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "bt_common.h"
 #include "btif_uid.h"
 
+/* Traffic is counted in shards of open addressed slots. Each thread adds to
+ * its own shard with relaxed atomic adds, so the socket data paths of
+ * different threads do not contend, and no lock is taken once a UID has a
+ * slot. uid_set_read_and_clear() swaps every counter to zero and merges the
+ * shards. A UID that finds its shard full is counted in a locked list. */
+#define UID_SET_SHARDS 4
+#define UID_SET_SHARD_BITS 6
+#define UID_SET_SHARD_SLOTS (1 << UID_SET_SHARD_BITS)
+#define UID_SET_FREE_SLOT (-1) /* app_uid -1 is never counted */
+
 std::mutex set_lock;
 
 typedef struct uid_set_node_t {
@@ -34,12 +47,31 @@ typedef struct uid_set_node_t {
   bt_uid_traffic_t data;
 } uid_set_node_t;
 
+typedef struct {
+  std::atomic<int32_t> app_uid;
+  std::atomic<uint64_t> rx_bytes;
+  std::atomic<uint64_t> tx_bytes;
+} uid_set_slot_t;
+
+typedef struct alignas(64) {
+  uid_set_slot_t slots[UID_SET_SHARD_SLOTS];
+} uid_set_shard_t;
+
 typedef struct uid_set_t {
-  uid_set_node_t* head;
+  uid_set_shard_t shards[UID_SET_SHARDS];
+  uid_set_node_t* head; /* UIDs that did not get a slot */
 } uid_set_t;
 
 uid_set_t* uid_set_create(void) {
-  uid_set_t* set = (uid_set_t*)osi_calloc(sizeof(uid_set_t));
+  uid_set_t* set = new uid_set_t;
+  for (uid_set_shard_t& shard : set->shards) {
+    for (uid_set_slot_t& slot : shard.slots) {
+      slot.app_uid = UID_SET_FREE_SLOT;
+      slot.rx_bytes = 0;
+      slot.tx_bytes = 0;
+    }
+  }
+  set->head = NULL;
   return set;
 }
 
@@ -52,7 +84,7 @@ void uid_set_destroy(uid_set_t* set) {
     osi_free(temp);
   }
   set->head = NULL;
-  osi_free(set);
+  delete set;
 }
 
 // Lock in uid_set_t must be held.
@@ -72,9 +104,46 @@ static uid_set_node_t* uid_set_find_or_create_node(uid_set_t* set,
   return node;
 }
 
+/* Shard of the calling thread, assigned round robin on first use */
+static uid_set_shard_t* uid_set_this_thread_shard(uid_set_t* set) {
+  static std::atomic<unsigned> next_shard(0);
+  thread_local unsigned shard = next_shard++ % UID_SET_SHARDS;
+  return &set->shards[shard];
+}
+
+/* Returns the slot of |app_uid| in the shard of the calling thread, claiming a
+ * free one if needed, or NULL if the shard is full */
+static uid_set_slot_t* uid_set_find_or_claim_slot(uid_set_t* set,
+                                                  int32_t app_uid) {
+  uid_set_shard_t* shard = uid_set_this_thread_shard(set);
+  uint32_t start =
+      ((uint32_t)app_uid * 2654435761u) >> (32 - UID_SET_SHARD_BITS);
+
+  for (uint32_t i = 0; i < UID_SET_SHARD_SLOTS; i++) {
+    uid_set_slot_t* slot =
+        &shard->slots[(start + i) & (UID_SET_SHARD_SLOTS - 1)];
+    int32_t slot_uid = slot->app_uid.load(std::memory_order_acquire);
+    if (slot_uid == app_uid) return slot;
+    if (slot_uid != UID_SET_FREE_SLOT) continue;
+
+    // Claim the free slot, unless another thread of this shard just did
+    if (slot->app_uid.compare_exchange_strong(slot_uid, app_uid,
+                                              std::memory_order_acq_rel) ||
+        slot_uid == app_uid)
+      return slot;
+  }
+  return NULL;
+}
+
 void uid_set_add_tx(uid_set_t* set, int32_t app_uid, uint64_t bytes) {
   if (app_uid == -1 || bytes == 0 || set == NULL) return;
 
+  uid_set_slot_t* slot = uid_set_find_or_claim_slot(set, app_uid);
+  if (slot) {
+    slot->tx_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return;
+  }
+
   std::unique_lock<std::mutex> guard(set_lock);
   uid_set_node_t* node = uid_set_find_or_create_node(set, app_uid);
   node->data.tx_bytes += bytes;
@@ -83,6 +152,12 @@ void uid_set_add_tx(uid_set_t* set, int32_t app_uid, uint64_t bytes) {
 void uid_set_add_rx(uid_set_t* set, int32_t app_uid, uint64_t bytes) {
   if (app_uid == -1 || bytes == 0 || set == NULL) return;
 
+  uid_set_slot_t* slot = uid_set_find_or_claim_slot(set, app_uid);
+  if (slot) {
+    slot->rx_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return;
+  }
+
   std::unique_lock<std::mutex> guard(set_lock);
   uid_set_node_t* node = uid_set_find_or_create_node(set, app_uid);
   node->data.rx_bytes += bytes;
@@ -91,25 +166,36 @@ void uid_set_add_rx(uid_set_t* set, int32_t app_uid, uint64_t bytes) {
 bt_uid_traffic_t* uid_set_read_and_clear(uid_set_t* set) {
   std::unique_lock<std::mutex> guard(set_lock);
 
-  // Find the length
-  size_t len = 0;
-  uid_set_node_t* node = set->head;
-  while (node) {
-    len++;
-    node = node->next;
+  // Merge the counters of each UID across the shards and the list, keeping
+  // the order in which the UIDs are found.
+  std::unordered_map<int32_t, size_t> index;
+  std::vector<bt_uid_traffic_t> merged;
+  auto entry = [&index, &merged](int32_t app_uid) -> bt_uid_traffic_t& {
+    auto it = index.find(app_uid);
+    if (it != index.end()) return merged[it->second];
+    index[app_uid] = merged.size();
+    bt_uid_traffic_t data = {};
+    data.app_uid = app_uid;
+    merged.push_back(data);
+    return merged.back();
+  };
+
+  for (uid_set_shard_t& shard : set->shards) {
+    for (uid_set_slot_t& slot : shard.slots) {
+      int32_t app_uid = slot.app_uid.load(std::memory_order_acquire);
+      if (app_uid == UID_SET_FREE_SLOT) continue;
+      // Clear the counters.
+      bt_uid_traffic_t& data = entry(app_uid);
+      data.rx_bytes += slot.rx_bytes.exchange(0, std::memory_order_relaxed);
+      data.tx_bytes += slot.tx_bytes.exchange(0, std::memory_order_relaxed);
+    }
   }
 
-  // Allocate an array of elements + 1, to signify the end with app_uid set to
-  // -1.
-  bt_uid_traffic_t* result =
-      (bt_uid_traffic_t*)osi_calloc(sizeof(bt_uid_traffic_t) * (len + 1));
-
-  bt_uid_traffic_t* data = result;
-  node = set->head;
+  uid_set_node_t* node = set->head;
   while (node) {
-    // Copy the data.
-    *data = node->data;
-    data++;
+    bt_uid_traffic_t& data = entry(node->data.app_uid);
+    data.rx_bytes += node->data.rx_bytes;
+    data.tx_bytes += node->data.tx_bytes;
 
     // Clear the counters.
     node->data.rx_bytes = 0;
@@ -117,8 +203,15 @@ bt_uid_traffic_t* uid_set_read_and_clear(uid_set_t* set) {
     node = node->next;
   }
 
+  // Allocate an array of elements + 1, to signify the end with app_uid set to
+  // -1.
+  size_t len = merged.size();
+  bt_uid_traffic_t* result =
+      (bt_uid_traffic_t*)osi_calloc(sizeof(bt_uid_traffic_t) * (len + 1));
+  for (size_t i = 0; i < len; i++) result[i] = merged[i];
+
   // Mark the last entry
-  data->app_uid = -1;
+  result[len].app_uid = -1;
 
   return result;
 }
@@ -0,0 +1,421 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "btif/include/btif_a2dp_sink_jitter.h"
+
+namespace {
+
+constexpr uint32_t kSampleRate = 44100;
+constexpr uint32_t kSamplesPerFrame = 128;
+constexpr uint32_t kFramesPerPacket = 7;
+constexpr uint32_t kPacketSamples = kSamplesPerFrame * kFramesPerPacket;
+constexpr uint64_t kTickUs = 20000;
+/* Legacy MAX_INPUT_A2DP_FRAME_QUEUE_SZ and
+ * MAX_A2DP_DELAYED_START_FRAME_COUNT */
+constexpr size_t kMaxQueueLength = 56;
+constexpr size_t kLegacyStartPackets = 5;
+constexpr uint64_t kTraceUs = 60000000;
+
+struct Arrival {
+  uint64_t arrival_us;
+  uint32_t timestamp;
+  uint16_t seq;
+  uint32_t frames;
+};
+
+class Random {
+ public:
+  explicit Random(uint32_t seed) : state_(seed) {}
+  /* Uniform in [lo, hi) */
+  uint64_t Uniform(uint64_t lo, uint64_t hi) {
+    state_ = state_ * 1103515245 + 12345;
+    return lo + (state_ >> 8) % (hi - lo);
+  }
+
+ private:
+  uint32_t state_;
+};
+
+uint64_t PacketSendUs(uint32_t i) {
+  return (uint64_t)i * kPacketSamples * 1000000 / kSampleRate;
+}
+
+/* Recorded-style arrival traces of a phone streaming SBC 44.1 kHz in 7 frame
+ * packets, generated from a fixed seed so that runs are reproducible.
+ * |stall_every_us| of 0 means no baseband stalls; a stall holds back every
+ * packet for |stall_min_us| to |stall_max_us| and then delivers the backlog
+ * back to back. Stalls stop at |stall_until_us|. |loss_per_mille| packets are
+ * flushed by the source and never arrive. A |burst| above 1 is a source that
+ * sends that many packets at once. */
+struct TraceShape {
+  const char* name;
+  uint64_t jitter_us;
+  uint64_t stall_every_us;
+  uint64_t stall_min_us;
+  uint64_t stall_max_us;
+  uint64_t stall_until_us;
+  uint32_t loss_per_mille;
+  uint32_t burst;
+};
+
+std::vector<Arrival> MakeTrace(const TraceShape& shape, uint32_t seed) {
+  Random random(seed);
+  std::vector<Arrival> trace;
+  uint64_t stall_start = shape.stall_every_us
+                             ? random.Uniform(shape.stall_every_us / 2,
+                                              shape.stall_every_us * 3 / 2)
+                             : UINT64_MAX;
+  uint64_t stall_end = stall_start;
+  uint64_t last_us = 0;
+  for (uint32_t i = 0; PacketSendUs(i) < kTraceUs; i++) {
+    uint32_t group_last = (i / shape.burst + 1) * shape.burst - 1;
+    uint64_t arrival = PacketSendUs(group_last) + 5000 +
+                       random.Uniform(0, shape.jitter_us + 1);
+    if (arrival >= stall_start && stall_start < shape.stall_until_us) {
+      if (stall_end == stall_start)
+        stall_end = stall_start +
+                    random.Uniform(shape.stall_min_us, shape.stall_max_us);
+      if (arrival < stall_end) {
+        arrival = stall_end;
+      } else {
+        stall_start = arrival + random.Uniform(shape.stall_every_us / 2,
+                                               shape.stall_every_us * 3 / 2);
+        stall_end = stall_start;
+      }
+    }
+    /* In order delivery, at most one packet per 1.25 ms slot pair */
+    arrival = std::max(arrival, last_us + 1250);
+    last_us = arrival;
+    if (random.Uniform(0, 1000) < shape.loss_per_mille) continue;
+    trace.push_back(Arrival{arrival, i * kPacketSamples, (uint16_t)i,
+                            kFramesPerPacket});
+  }
+  return trace;
+}
+
+struct QueuedPacket {
+  uint64_t arrival_us;
+  uint32_t timestamp;
+  uint32_t frames;
+};
+
+struct ReplayResult {
+  uint32_t underrun_ticks = 0;
+  uint64_t decoded_frames = 0;
+  uint64_t latency_sum_us = 0;
+  uint64_t overflow_drops = 0;
+  uint64_t MeanLatencyMs() const {
+    return decoded_frames ? latency_sum_us / decoded_frames / 1000 : 0;
+  }
+};
+
+/* Replays |trace| into the legacy sink queue: decoding starts at the fifth
+ * packet, a full queue drops its oldest packet along with the new one, and
+ * every tick plays the frames due whatever is queued. The legacy tick gets
+ * the exact frame budget here; the real one rounds it down to whole frames
+ * per 20 ms. */
+ReplayResult ReplayLegacy(const std::vector<Arrival>& trace, uint32_t seed) {
+  Random random(seed);
+  ReplayResult result;
+  std::deque<QueuedPacket> queue;
+  size_t next = 0;
+  bool started = false;
+  uint64_t budget_acc = 0;
+  uint64_t frame_units = (uint64_t)kSamplesPerFrame * 1000000;
+  uint64_t last_tick_us = 0;
+
+  for (uint64_t tick = kTickUs; tick < kTraceUs; tick += kTickUs) {
+    uint64_t now_us = tick + random.Uniform(0, 1000);
+    for (; next < trace.size() && trace[next].arrival_us <= now_us; next++) {
+      if (queue.size() == kMaxQueueLength) {
+        queue.pop_front();
+        result.overflow_drops += 2;
+        continue;
+      }
+      queue.push_back(QueuedPacket{trace[next].arrival_us,
+                                   trace[next].timestamp, trace[next].frames});
+      if (queue.size() == kLegacyStartPackets && !started) {
+        started = true;
+        last_tick_us = now_us;
+      }
+    }
+    if (!started) continue;
+
+    budget_acc += (now_us - last_tick_us) * kSampleRate;
+    last_tick_us = now_us;
+    uint32_t budget = budget_acc / frame_units;
+    budget_acc -= budget * frame_units;
+    while (budget > 0 && !queue.empty()) {
+      uint32_t frames = std::min(budget, queue.front().frames);
+      result.decoded_frames += frames;
+      result.latency_sum_us += frames * (now_us - queue.front().arrival_us);
+      budget -= frames;
+      if ((queue.front().frames -= frames) == 0) queue.pop_front();
+    }
+    if (budget > 0) result.underrun_ticks++;
+  }
+  return result;
+}
+
+/* Replays |trace| through A2dpSinkJitterBuffer the way the sink media tick
+ * drives it. A tick counts as an underrun when media was missing: the buffer
+ * concealed an empty queue, or it waits for the queue to refill. */
+ReplayResult ReplayAdaptive(const std::vector<Arrival>& trace, uint32_t seed,
+                            A2dpSinkJitterBuffer* p_jb) {
+  Random random(seed);
+  ReplayResult result;
+  A2dpSinkJitterBuffer::Config config;
+  config.sample_rate = kSampleRate;
+  config.samples_per_frame = kSamplesPerFrame;
+  p_jb->Reset(config);
+  std::deque<QueuedPacket> queue;
+  size_t next = 0;
+  bool ever_started = false;
+
+  for (uint64_t tick = kTickUs; tick < kTraceUs; tick += kTickUs) {
+    uint64_t now_us = tick + random.Uniform(0, 1000);
+    for (; next < trace.size() && trace[next].arrival_us <= now_us; next++) {
+      const Arrival& a = trace[next];
+      if (!p_jb->OnPacket(a.arrival_us, a.timestamp, a.seq, a.frames))
+        continue;
+      if (queue.size() == kMaxQueueLength) {
+        p_jb->OnDropped(queue.front().frames);
+        queue.pop_front();
+        result.overflow_drops++;
+      }
+      queue.push_back(QueuedPacket{a.arrival_us, a.timestamp, a.frames});
+    }
+
+    uint32_t underruns = p_jb->GetUnderruns();
+    bool rendered = false;
+    p_jb->BeginTick(now_us);
+    for (;;) {
+      QueuedPacket* head = queue.empty() ? nullptr : &queue.front();
+      A2dpSinkJitterBuffer::Step step =
+          p_jb->NextStep(head ? head->timestamp : 0, head ? head->frames : 0);
+      if (step.action == A2dpSinkJitterBuffer::Action::kNone) break;
+      rendered = true;
+      if (step.action == A2dpSinkJitterBuffer::Action::kConceal) continue;
+      if (step.action == A2dpSinkJitterBuffer::Action::kDecode) {
+        result.decoded_frames += step.frames;
+        result.latency_sum_us += step.frames * (now_us - head->arrival_us);
+      }
+      head->timestamp += step.frames * kSamplesPerFrame;
+      if ((head->frames -= step.frames) == 0) queue.pop_front();
+    }
+    ever_started |= rendered;
+    if (p_jb->GetUnderruns() != underruns || (ever_started && !rendered))
+      result.underrun_ticks++;
+  }
+  return result;
+}
+
+const TraceShape kClean = {"clean", 3000, 0, 0, 0, 0, 0, 1};
+const TraceShape kRfStalls = {"rf_stalls",  3000,     2000000, 60000,
+                              240000,       kTraceUs, 0,       1};
+const TraceShape kStallsThenClean = {"stalls_then_clean", 3000, 2000000, 60000,
+                                     240000, 20000000, 0, 1};
+const TraceShape kLossy = {"lossy", 6000,     3000000, 30000,
+                           80000,   kTraceUs, 20,      1};
+const TraceShape kBurstySource = {"bursty_source", 2000, 0, 0, 0, 0, 0, 3};
+
+void ReplayBoth(const TraceShape& shape, ReplayResult* p_legacy,
+                ReplayResult* p_adaptive, A2dpSinkJitterBuffer* p_jb) {
+  std::vector<Arrival> trace = MakeTrace(shape, 7);
+  *p_legacy = ReplayLegacy(trace, 11);
+  *p_adaptive = ReplayAdaptive(trace, 11, p_jb);
+  printf(
+      "%-18s legacy: %4u underrun ticks, mean latency %3llu ms | adaptive: "
+      "%4u underrun ticks, mean latency %3llu ms, playout delay %3llu ms, "
+      "lost %u late %u concealed %u frames\n",
+      shape.name, p_legacy->underrun_ticks,
+      (unsigned long long)p_legacy->MeanLatencyMs(),
+      p_adaptive->underrun_ticks,
+      (unsigned long long)p_adaptive->MeanLatencyMs(),
+      (unsigned long long)p_jb->GetPlayoutDelayUs() / 1000,
+      p_jb->GetLostFrames(), p_jb->GetLateFrames(),
+      p_jb->GetConcealedFrames());
+}
+
+/* Feeds |count| packets from |first| on, one per packet duration */
+void FeedPackets(A2dpSinkJitterBuffer* p_jb, uint32_t first, uint32_t count) {
+  for (uint32_t i = first; i < first + count; i++)
+    p_jb->OnPacket(PacketSendUs(i) + 5000, i * kPacketSamples, (uint16_t)i,
+                   kFramesPerPacket);
+}
+
+/* Runs one media tick over |p_queue|, returns the number of frames decoded */
+uint32_t RunTick(A2dpSinkJitterBuffer* p_jb, std::deque<QueuedPacket>* p_queue,
+                 uint64_t now_us) {
+  uint32_t decoded = 0;
+  p_jb->BeginTick(now_us);
+  for (;;) {
+    QueuedPacket* head = p_queue->empty() ? nullptr : &p_queue->front();
+    A2dpSinkJitterBuffer::Step step =
+        p_jb->NextStep(head ? head->timestamp : 0, head ? head->frames : 0);
+    if (step.action == A2dpSinkJitterBuffer::Action::kNone) break;
+    if (step.action == A2dpSinkJitterBuffer::Action::kConceal) continue;
+    if (step.action == A2dpSinkJitterBuffer::Action::kDecode)
+      decoded += step.frames;
+    head->timestamp += step.frames * kSamplesPerFrame;
+    if ((head->frames -= step.frames) == 0) p_queue->pop_front();
+  }
+  return decoded;
+}
+
+A2dpSinkJitterBuffer::Config TestConfig() {
+  A2dpSinkJitterBuffer::Config config;
+  config.sample_rate = kSampleRate;
+  config.samples_per_frame = kSamplesPerFrame;
+  return config;
+}
+
+}  // namespace
+
+TEST(A2dpSinkJitterBufferTest, test_starts_at_playout_delay) {
+  A2dpSinkJitterBuffer jb;
+  jb.Reset(TestConfig());
+  /* No measurement yet: initial spread plus one tick */
+  EXPECT_EQ(80000u, jb.GetPlayoutDelayUs());
+  FeedPackets(&jb, 0, 3);
+  EXPECT_FALSE(jb.IsReadyToStart());
+  FeedPackets(&jb, 3, 1);
+  EXPECT_TRUE(jb.IsReadyToStart());
+  EXPECT_TRUE(jb.IsTimestampReliable());
+}
+
+TEST(A2dpSinkJitterBufferTest, test_lost_media_is_concealed_and_late_dropped) {
+  A2dpSinkJitterBuffer::Config config = TestConfig();
+  config.drift_ticks = 1000;
+  A2dpSinkJitterBuffer jb;
+  jb.Reset(config);
+  std::deque<QueuedPacket> queue;
+  for (uint32_t i : {0, 1, 2, 3, 5, 6}) {
+    /* Packet 4 is late */
+    ASSERT_TRUE(jb.OnPacket(PacketSendUs(i) + 5000, i * kPacketSamples,
+                            (uint16_t)i, kFramesPerPacket));
+    queue.push_back(QueuedPacket{0, i * kPacketSamples, kFramesPerPacket});
+  }
+
+  /* The media of packet 4 is concealed between packets 3 and 5 */
+  uint32_t decoded = 0;
+  uint64_t now_us = 100000;
+  for (; decoded < 5 * kFramesPerPacket; now_us += kTickUs)
+    decoded += RunTick(&jb, &queue, now_us);
+  EXPECT_EQ(kFramesPerPacket, jb.GetLostFrames());
+  EXPECT_EQ(0u, jb.GetUnderruns());
+
+  /* Packet 4 shows up after its media was concealed */
+  EXPECT_FALSE(jb.OnPacket(now_us, 4 * kPacketSamples, 4, kFramesPerPacket));
+  EXPECT_EQ(kFramesPerPacket, jb.GetLateFrames());
+}
+
+TEST(A2dpSinkJitterBufferTest, test_underrun_stretches_then_rebuffers) {
+  A2dpSinkJitterBuffer jb;
+  jb.Reset(TestConfig());
+  FeedPackets(&jb, 0, 4);
+  jb.BeginTick(100000);
+  A2dpSinkJitterBuffer::Step step = jb.NextStep(0, 28);
+  EXPECT_EQ(A2dpSinkJitterBuffer::Action::kDecode, step.action);
+  jb.OnDropped(28 - step.frames);
+
+  /* The queue ran dry: the first ticks are concealed */
+  uint64_t now_us = 100000;
+  for (int i = 0; i < 3; i++) {
+    now_us += kTickUs;
+    jb.BeginTick(now_us);
+    step = jb.NextStep(0, 0);
+    EXPECT_EQ(A2dpSinkJitterBuffer::Action::kConceal, step.action);
+    EXPECT_EQ(A2dpSinkJitterBuffer::Action::kNone, jb.NextStep(0, 0).action);
+  }
+  EXPECT_EQ(3u, jb.GetUnderruns());
+
+  /* Past max_conceal_us playback waits for the queue to refill */
+  for (int i = 0; i < 10; i++) {
+    now_us += kTickUs;
+    jb.BeginTick(now_us);
+    jb.NextStep(0, 0);
+  }
+  jb.BeginTick(now_us + kTickUs);
+  EXPECT_EQ(A2dpSinkJitterBuffer::Action::kNone, jb.NextStep(0, 0).action);
+  EXPECT_FALSE(jb.IsReadyToStart());
+}
+
+TEST(A2dpSinkJitterBufferTest, test_sequence_numbers_pace_bad_timestamps) {
+  A2dpSinkJitterBuffer jb;
+  jb.Reset(TestConfig());
+  for (uint32_t i = 0; i < 50; i++)
+    jb.OnPacket(PacketSendUs(i) + 5000, 0, (uint16_t)i, kFramesPerPacket);
+  EXPECT_FALSE(jb.IsTimestampReliable());
+  /* Evenly spaced arrivals are still seen as such */
+  EXPECT_LT(jb.GetJitterUs(), 1000u);
+
+  /* Without timestamps nothing is taken for lost or late */
+  std::deque<QueuedPacket> queue;
+  for (uint32_t i = 0; i < 50; i++)
+    queue.push_back(QueuedPacket{0, 12345, kFramesPerPacket});
+  uint32_t decoded = 0;
+  for (uint64_t now_us = 2000000; now_us < 2100000; now_us += kTickUs)
+    decoded += RunTick(&jb, &queue, now_us);
+  EXPECT_GE(decoded, 30u);
+  EXPECT_EQ(0u, jb.GetLostFrames());
+  EXPECT_EQ(0u, jb.GetLateFrames());
+}
+
+TEST(A2dpSinkJitterBufferTest, test_replay_clean) {
+  A2dpSinkJitterBuffer jb;
+  ReplayResult legacy, adaptive;
+  ReplayBoth(kClean, &legacy, &adaptive, &jb);
+  EXPECT_EQ(0u, legacy.underrun_ticks);
+  EXPECT_EQ(0u, adaptive.underrun_ticks);
+  /* A clean link settles at the minimum delay */
+  EXPECT_EQ(40000u, jb.GetPlayoutDelayUs());
+  EXPECT_LT(adaptive.MeanLatencyMs(), legacy.MeanLatencyMs());
+}
+
+TEST(A2dpSinkJitterBufferTest, test_replay_rf_stalls) {
+  A2dpSinkJitterBuffer jb;
+  ReplayResult legacy, adaptive;
+  ReplayBoth(kRfStalls, &legacy, &adaptive, &jb);
+  /* Both end up buffering about the longest stall */
+  EXPECT_LE(adaptive.underrun_ticks, legacy.underrun_ticks);
+  EXPECT_LE(adaptive.MeanLatencyMs() * 1000, 300000u);
+}
+
+TEST(A2dpSinkJitterBufferTest, test_replay_stalls_then_clean) {
+  A2dpSinkJitterBuffer jb;
+  ReplayResult legacy, adaptive;
+  ReplayBoth(kStallsThenClean, &legacy, &adaptive, &jb);
+  EXPECT_LE(adaptive.underrun_ticks, legacy.underrun_ticks);
+  /* The delay comes back down once the interference is gone */
+  EXPECT_EQ(40000u, jb.GetPlayoutDelayUs());
+  EXPECT_LT(adaptive.MeanLatencyMs() * 3, legacy.MeanLatencyMs() * 2);
+}
+
+TEST(A2dpSinkJitterBufferTest, test_replay_lossy) {
+  A2dpSinkJitterBuffer jb;
+  ReplayResult legacy, adaptive;
+  ReplayBoth(kLossy, &legacy, &adaptive, &jb);
+  EXPECT_LT(adaptive.underrun_ticks, legacy.underrun_ticks);
+  EXPECT_GT(jb.GetLostFrames(), 0u);
+  EXPECT_LE(adaptive.MeanLatencyMs() * 1000, 300000u);
+}
+
+TEST(A2dpSinkJitterBufferTest, test_replay_bursty_source) {
+  A2dpSinkJitterBuffer jb;
+  ReplayResult legacy, adaptive;
+  ReplayBoth(kBurstySource, &legacy, &adaptive, &jb);
+  EXPECT_LE(adaptive.underrun_ticks, legacy.underrun_ticks);
+  EXPECT_LT(adaptive.MeanLatencyMs(), legacy.MeanLatencyMs());
+}
@@ -0,0 +1,168 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "btif/include/btif_a2dp_sink_media.h"
+#include "osi/include/allocator.h"
+
+namespace {
+
+/* A media packet as AVDTP hands it to the Sink: the HCI and L2CAP headers and
+ * the 12 byte RTP header in front of the payload were stripped by moving the
+ * offset. */
+const uint16_t kReceivedOffset = 8 + 12;
+const uint16_t kPayloadLen = 595; /* 5 SBC frames at bitpool 53, joint stereo */
+const uint16_t kBufferSize = 1024;
+
+BT_HDR* Receive(uint16_t offset, uint16_t len, uint8_t seed) {
+  BT_HDR* p_pkt = (BT_HDR*)osi_malloc(kBufferSize);
+  p_pkt->event = 0;
+  p_pkt->offset = offset;
+  p_pkt->len = len;
+  p_pkt->layer_specific = seed;
+  uint8_t* p = (uint8_t*)(p_pkt + 1) + offset;
+  for (uint16_t i = 0; i < len; i++) p[i] = (uint8_t)(seed + i);
+  return p_pkt;
+}
+
+bool PayloadIs(const tBT_SBC_HDR* p_msg, uint8_t seed) {
+  const uint8_t* p = (const uint8_t*)(p_msg + 1) + p_msg->offset;
+  for (uint16_t i = 0; i < p_msg->len; i++)
+    if (p[i] != (uint8_t)(seed + i)) return false;
+  return true;
+}
+
+/* The Sink queue entry as it was built before packets were queued in place */
+tBT_SBC_HDR* LegacyTake(BT_HDR* p_pkt, uint16_t num_frames,
+                        uint32_t rtp_timestamp, uint64_t* allocations,
+                        uint64_t* bytes_copied) {
+  tBT_SBC_HDR* p_msg = reinterpret_cast<tBT_SBC_HDR*>(
+      osi_malloc(sizeof(tBT_SBC_HDR) + p_pkt->offset + p_pkt->len));
+  memcpy((uint8_t*)(p_msg + 1), (uint8_t*)(p_pkt + 1) + p_pkt->offset,
+         p_pkt->len);
+  p_msg->num_frames_to_be_processed = num_frames;
+  p_msg->len = p_pkt->len;
+  p_msg->offset = 0;
+  p_msg->layer_specific = p_pkt->layer_specific;
+  p_msg->rtp_timestamp = rtp_timestamp;
+  osi_free(p_pkt);
+  (*allocations)++;
+  *bytes_copied += p_msg->len;
+  return p_msg;
+}
+
+}  // namespace
+
+TEST(BtifA2dpSinkMediaTest, packet_with_headroom_is_queued_in_place) {
+  btif_a2dp_sink_media_reset_stats();
+  BT_HDR* p_pkt = Receive(kReceivedOffset, kPayloadLen, 7);
+  uint8_t* payload = (uint8_t*)(p_pkt + 1) + p_pkt->offset;
+
+  tBT_SBC_HDR* p_msg = btif_a2dp_sink_media_take(p_pkt, 5, 0x12345678);
+  EXPECT_EQ((void*)p_pkt, (void*)p_msg);
+  EXPECT_EQ(payload, (uint8_t*)(p_msg + 1) + p_msg->offset);
+  EXPECT_EQ(kPayloadLen, p_msg->len);
+  EXPECT_EQ(5, p_msg->num_frames_to_be_processed);
+  EXPECT_EQ(7, p_msg->layer_specific);
+  EXPECT_EQ(0x12345678u, p_msg->rtp_timestamp);
+  EXPECT_EQ(0u, p_msg->enque_ns);
+  EXPECT_TRUE(PayloadIs(p_msg, 7));
+
+  const btif_a2dp_sink_media_stats_t* stats = btif_a2dp_sink_media_get_stats();
+  EXPECT_EQ(1u, stats->packets_moved);
+  EXPECT_EQ(0u, stats->packets_copied);
+  EXPECT_EQ(0u, stats->bytes_copied);
+  osi_free(p_msg);
+}
+
+TEST(BtifA2dpSinkMediaTest, smallest_headroom_is_queued_in_place) {
+  btif_a2dp_sink_media_reset_stats();
+  BT_HDR* p_pkt = Receive(BTIF_A2DP_SINK_MEDIA_MIN_OFFSET, 40, 3);
+  tBT_SBC_HDR* p_msg = btif_a2dp_sink_media_take(p_pkt, 1, 99);
+  EXPECT_EQ((void*)p_pkt, (void*)p_msg);
+  EXPECT_EQ(0, p_msg->offset);
+  EXPECT_TRUE(PayloadIs(p_msg, 3));
+  EXPECT_EQ(1u, btif_a2dp_sink_media_get_stats()->packets_moved);
+  osi_free(p_msg);
+}
+
+TEST(BtifA2dpSinkMediaTest, packet_without_headroom_is_copied) {
+  btif_a2dp_sink_media_reset_stats();
+  BT_HDR* p_pkt = Receive(BTIF_A2DP_SINK_MEDIA_MIN_OFFSET - 1, 40, 9);
+  tBT_SBC_HDR* p_msg = btif_a2dp_sink_media_take(p_pkt, 2, 1000);
+  EXPECT_EQ(0, p_msg->offset);
+  EXPECT_EQ(40, p_msg->len);
+  EXPECT_EQ(2, p_msg->num_frames_to_be_processed);
+  EXPECT_EQ(9, p_msg->layer_specific);
+  EXPECT_EQ(1000u, p_msg->rtp_timestamp);
+  EXPECT_TRUE(PayloadIs(p_msg, 9));
+
+  const btif_a2dp_sink_media_stats_t* stats = btif_a2dp_sink_media_get_stats();
+  EXPECT_EQ(0u, stats->packets_moved);
+  EXPECT_EQ(1u, stats->packets_copied);
+  EXPECT_EQ(40u, stats->bytes_copied);
+  osi_free(p_msg);
+}
+
+TEST(BtifA2dpSinkMediaTest, allocations_and_copies_per_packet) {
+  const int kPackets = 20000;
+  using Clock = std::chrono::steady_clock;
+
+  uint64_t legacy_allocations = 0;
+  uint64_t legacy_bytes = 0;
+  Clock::duration legacy_time{};
+  for (int i = 0; i < kPackets; i++) {
+    BT_HDR* p_pkt = Receive(kReceivedOffset, kPayloadLen, (uint8_t)i);
+    Clock::time_point start = Clock::now();
+    tBT_SBC_HDR* p_msg =
+        LegacyTake(p_pkt, 5, i, &legacy_allocations, &legacy_bytes);
+    legacy_time += Clock::now() - start;
+    ASSERT_TRUE(PayloadIs(p_msg, (uint8_t)i));
+    osi_free(p_msg);
+  }
+
+  btif_a2dp_sink_media_reset_stats();
+  Clock::duration in_place_time{};
+  for (int i = 0; i < kPackets; i++) {
+    BT_HDR* p_pkt = Receive(kReceivedOffset, kPayloadLen, (uint8_t)i);
+    Clock::time_point start = Clock::now();
+    tBT_SBC_HDR* p_msg = btif_a2dp_sink_media_take(p_pkt, 5, i);
+    in_place_time += Clock::now() - start;
+    ASSERT_TRUE(PayloadIs(p_msg, (uint8_t)i));
+    osi_free(p_msg);
+  }
+  const btif_a2dp_sink_media_stats_t* stats = btif_a2dp_sink_media_get_stats();
+
+  printf("%d packets of %d bytes, per packet:\n", kPackets, kPayloadLen);
+  printf("  legacy:   %.2f allocations, %6.1f bytes copied, %6.1f ns\n",
+         (double)legacy_allocations / kPackets,
+         (double)legacy_bytes / kPackets,
+         (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             legacy_time)
+                 .count() /
+             kPackets);
+  printf("  in place: %.2f allocations, %6.1f bytes copied, %6.1f ns\n",
+         (double)stats->packets_copied / kPackets,
+         (double)stats->bytes_copied / kPackets,
+         (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             in_place_time)
+                 .count() /
+             kPackets);
+
+  EXPECT_EQ((uint64_t)kPackets, legacy_allocations);
+  EXPECT_EQ((uint64_t)kPackets * kPayloadLen, legacy_bytes);
+  EXPECT_EQ((uint64_t)kPackets, stats->packets_moved);
+  EXPECT_EQ(0u, stats->packets_copied);
+  EXPECT_EQ(0u, stats->bytes_copied);
+}
@@ -0,0 +1,230 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <deque>
+
+#include "btif/include/btif_a2dp_source_tx_ctrl.h"
+
+namespace {
+
+constexpr uint32_t kBaseIntervalMs = 20;
+/* One encoded media packet every 10 ms */
+constexpr double kMediaRatePps = 100.0;
+/* Legacy MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ like bound of the btif TX queue */
+constexpr size_t kMaxQueueLength = 10;
+/* ACL buffers the controller grants to the A2DP link */
+constexpr size_t kControllerBuffers = 4;
+
+/* Link throughput over time: good, then a lossy stretch where most baseband
+ * retransmissions fail, then good again. */
+double LinkRatePps(uint64_t now_us) {
+  if (now_us >= 2000000 && now_us < 6000000) return 60.0;
+  return 150.0;
+}
+
+struct SimResult {
+  size_t generated = 0;
+  size_t delivered = 0;
+  size_t dropped = 0;
+  size_t max_drop_burst = 0;
+  uint64_t max_latency_us = 0;
+  /* Worst latency once the controller had a second to settle in the lossy
+   * stretch */
+  uint64_t max_settled_lossy_latency_us = 0;
+};
+
+/* Discrete time model of the A2DP Source pipeline: media tick encoding into
+ * the btif TX queue, BTU pulling packets as long as controller buffers are
+ * free, and the controller completing packets at the link rate. The legacy
+ * pipeline flushes the whole queue on overflow at a fixed tick. */
+SimResult Simulate(bool adaptive, uint64_t duration_us,
+                   A2dpSourceTxController* p_ctrl) {
+  SimResult result;
+  A2dpSourceTxController::Config config;
+  config.base_interval_ms = kBaseIntervalMs;
+  config.min_interval_ms = kBaseIntervalMs / 2;
+  p_ctrl->Reset(config, 0);
+
+  std::deque<uint64_t> queue;     /* generation time of queued packets */
+  std::deque<uint64_t> in_flight; /* packets owned by the controller */
+  uint32_t interval_ms = kBaseIntervalMs;
+  uint64_t next_tick_us = interval_ms * 1000;
+  uint64_t last_tick_us = 0;
+  double media_credit = 0;
+  double link_credit = 0;
+
+  auto drop_oldest = [&](size_t n) {
+    n = std::min(n, queue.size());
+    for (size_t i = 0; i < n; i++) queue.pop_front();
+    result.dropped += n;
+    result.max_drop_burst = std::max(result.max_drop_burst, n);
+  };
+
+  for (uint64_t now_us = 0; now_us < duration_us; now_us += 1000) {
+    if (now_us == next_tick_us) {
+      if (adaptive) {
+        A2dpSourceTxController::Decision decision =
+            p_ctrl->OnTick(now_us, queue.size());
+        drop_oldest(decision.drop_n);
+        p_ctrl->OnPacketsDropped(decision.drop_n);
+        interval_ms = decision.interval_ms;
+      }
+      /* Encoders size the batch by the time elapsed since the last tick */
+      media_credit += (now_us - last_tick_us) * kMediaRatePps / 1000000.0;
+      last_tick_us = now_us;
+      size_t frames_n = (size_t)media_credit;
+      media_credit -= frames_n;
+      for (size_t i = 0; i < frames_n; i++) {
+        result.generated++;
+        if (queue.size() + 1 > kMaxQueueLength) {
+          size_t drop_n = queue.size();
+          if (adaptive) {
+            drop_n = p_ctrl->GetOverflowDropCount(queue.size(), 1,
+                                                  kMaxQueueLength);
+            p_ctrl->OnPacketsDropped(drop_n);
+          }
+          drop_oldest(drop_n);
+        }
+        queue.push_back(now_us);
+      }
+      next_tick_us = now_us + interval_ms * 1000;
+    }
+
+    while (!queue.empty() && in_flight.size() < kControllerBuffers) {
+      in_flight.push_back(queue.front());
+      queue.pop_front();
+      p_ctrl->OnPacketDequeued();
+    }
+
+    link_credit = std::min(link_credit + LinkRatePps(now_us) / 1000.0,
+                           (double)kControllerBuffers);
+    uint16_t completed = 0;
+    while (!in_flight.empty() && link_credit >= 1.0) {
+      uint64_t latency_us = now_us - in_flight.front();
+      result.max_latency_us = std::max(result.max_latency_us, latency_us);
+      if (now_us >= 3000000 && now_us < 6000000)
+        result.max_settled_lossy_latency_us =
+            std::max(result.max_settled_lossy_latency_us, latency_us);
+      in_flight.pop_front();
+      link_credit -= 1.0;
+      completed++;
+      result.delivered++;
+    }
+    if (in_flight.empty()) link_credit = std::min(link_credit, 1.0);
+    if (completed > 0) p_ctrl->OnPacketsCompleted(completed);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(A2dpSourceTxControllerTest, test_overflow_drop_count) {
+  A2dpSourceTxController ctrl;
+  EXPECT_EQ(0u, ctrl.GetOverflowDropCount(5, 3, 10));
+  EXPECT_EQ(0u, ctrl.GetOverflowDropCount(7, 3, 10));
+  EXPECT_EQ(1u, ctrl.GetOverflowDropCount(8, 3, 10));
+  EXPECT_EQ(2u, ctrl.GetOverflowDropCount(2, 20, 10));
+}
+
+TEST(A2dpSourceTxControllerTest, test_good_link_keeps_base_interval) {
+  A2dpSourceTxController legacy_ctrl;
+  A2dpSourceTxController ctrl;
+  SimResult legacy = Simulate(false, 2000000, &legacy_ctrl);
+  SimResult adaptive = Simulate(true, 2000000, &ctrl);
+
+  EXPECT_EQ(0u, legacy.dropped);
+  EXPECT_EQ(0u, adaptive.dropped);
+  EXPECT_FALSE(ctrl.IsCongested());
+  EXPECT_EQ(kBaseIntervalMs, ctrl.GetIntervalMs());
+  EXPECT_NEAR(kMediaRatePps, ctrl.GetDrainRatePps(), kMediaRatePps / 5);
+}
+
+TEST(A2dpSourceTxControllerTest, test_stalled_link_is_congested) {
+  A2dpSourceTxController::Config config;
+  A2dpSourceTxController ctrl;
+  ctrl.Reset(config, 0);
+  uint64_t now_us = 0;
+  /* The link drains for a while, then stops */
+  for (int i = 0; i < 5; i++) {
+    now_us += config.base_interval_ms * 1000;
+    ctrl.OnPacketDequeued();
+    ctrl.OnPacketsCompleted(1);
+    ctrl.OnTick(now_us, 0);
+  }
+  EXPECT_FALSE(ctrl.IsCongested());
+  for (int i = 0; i < 10; i++) {
+    now_us += config.base_interval_ms * 1000;
+    ctrl.OnPacketDequeued();
+    ctrl.OnTick(now_us, 3);
+  }
+  EXPECT_TRUE(ctrl.IsCongested());
+  EXPECT_EQ(config.min_interval_ms, ctrl.GetIntervalMs());
+  EXPECT_GT(ctrl.GetDelayUs(), config.target_delay_us);
+}
+
+TEST(A2dpSourceTxControllerTest, test_no_drops_before_first_completion) {
+  A2dpSourceTxController::Config config;
+  A2dpSourceTxController ctrl;
+  ctrl.Reset(config, 0);
+  uint64_t now_us = 0;
+  /* Stream start: packets pile up before the first NoCP event */
+  for (int i = 0; i < 10; i++) {
+    now_us += config.base_interval_ms * 1000;
+    ctrl.OnPacketDequeued();
+    A2dpSourceTxController::Decision decision = ctrl.OnTick(now_us, 3);
+    EXPECT_EQ(0u, decision.drop_n);
+    EXPECT_EQ(config.base_interval_ms, decision.interval_ms);
+  }
+  EXPECT_FALSE(ctrl.IsCongested());
+  EXPECT_EQ(0u, ctrl.GetDelayUs());
+
+  now_us += config.base_interval_ms * 1000;
+  ctrl.OnPacketsCompleted(2);
+  ctrl.OnTick(now_us, 3);
+  EXPECT_GT(ctrl.GetDrainRatePps(), 0);
+}
+
+TEST(A2dpSourceTxControllerTest, test_lossy_link_vs_flush) {
+  A2dpSourceTxController legacy_ctrl;
+  A2dpSourceTxController ctrl;
+  SimResult legacy = Simulate(false, 10000000, &legacy_ctrl);
+  SimResult adaptive = Simulate(true, 10000000, &ctrl);
+
+  printf(
+      "legacy:   generated %zu delivered %zu dropped %zu max burst %zu max "
+      "latency %llu ms lossy latency %llu ms\n",
+      legacy.generated, legacy.delivered, legacy.dropped,
+      legacy.max_drop_burst, (unsigned long long)legacy.max_latency_us / 1000,
+      (unsigned long long)legacy.max_settled_lossy_latency_us / 1000);
+  printf(
+      "adaptive: generated %zu delivered %zu dropped %zu max burst %zu max "
+      "latency %llu ms lossy latency %llu ms\n",
+      adaptive.generated, adaptive.delivered, adaptive.dropped,
+      adaptive.max_drop_burst,
+      (unsigned long long)adaptive.max_latency_us / 1000,
+      (unsigned long long)adaptive.max_settled_lossy_latency_us / 1000);
+
+  /* The link can not carry everything in the lossy stretch either way */
+  EXPECT_GT(legacy.dropped, 0u);
+  EXPECT_GT(adaptive.dropped, 0u);
+  /* Drops are spread out instead of wiping the whole queue at once */
+  EXPECT_LT(adaptive.max_drop_burst, legacy.max_drop_burst);
+  /* Queueing delay is held near the target instead of the queue bound */
+  EXPECT_LT(adaptive.max_settled_lossy_latency_us,
+            legacy.max_settled_lossy_latency_us);
+  EXPECT_LE(adaptive.max_settled_lossy_latency_us, 100000u);
+  /* About as much audio gets through as with the legacy flush */
+  EXPECT_GE(adaptive.delivered + adaptive.delivered / 20, legacy.delivered);
+
+  /* Back to the base tick once the link recovered */
+  EXPECT_FALSE(ctrl.IsCongested());
+  EXPECT_EQ(kBaseIntervalMs, ctrl.GetIntervalMs());
+}
@@ -0,0 +1,366 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btif/include/btif_rc_browse_cache.h"
+
+namespace {
+
+constexpr uint32_t kFolderSize = 20000;
+constexpr uint32_t kPageSize = 20;
+constexpr uint16_t kUidCounter = 7;
+
+/* Simulated cost of a GetFolderItems round trip through the media player */
+constexpr double kPlayerRoundTripUs = 4000.0;
+
+/* Stands in for the Java media player: serves a synthetic folder of
+ * kFolderSize media items with a title and an artist attribute each. */
+class FakeMediaPlayer {
+ public:
+  uint16_t GetItems(uint32_t start_item, uint32_t end_item,
+                    std::vector<tAVRC_ITEM>* p_items) {
+    round_trips_++;
+    names_.clear();
+    attrs_.clear();
+    p_items->clear();
+    if (start_item >= kFolderSize) return 0;
+    uint32_t last = std::min(end_item, kFolderSize - 1);
+    names_.reserve(3 * (last - start_item + 1));
+    attrs_.reserve(2 * (last - start_item + 1));
+    for (uint32_t i = start_item; i <= last; i++) {
+      tAVRC_ITEM item;
+      memset(&item, 0, sizeof(item));
+      item.item_type = AVRC_ITEM_MEDIA;
+      for (int b = 0; b < AVRC_UID_SIZE; b++)
+        item.u.media.uid[b] = (uint8_t)(i >> (8 * (b % 4)));
+      item.u.media.type = AVRC_MEDIA_TYPE_AUDIO;
+      item.u.media.name = MakeName("Track " + std::to_string(i));
+      item.u.media.attr_count = 2;
+      item.u.media.p_attr_list = attrs_.data() + attrs_.size();
+      attrs_.push_back({AVRC_MEDIA_ATTR_ID_TITLE,
+                        MakeName("Title " + std::to_string(i))});
+      attrs_.push_back({AVRC_MEDIA_ATTR_ID_ARTIST,
+                        MakeName("Artist " + std::to_string(i % 97))});
+      p_items->push_back(item);
+    }
+    return p_items->size();
+  }
+
+  int round_trips() const { return round_trips_; }
+
+ private:
+  tAVRC_FULL_NAME MakeName(const std::string& str) {
+    names_.push_back(str);
+    tAVRC_FULL_NAME name;
+    name.charset_id = AVRC_CHARSET_ID_UTF8;
+    name.str_len = names_.back().size();
+    name.p_str = (uint8_t*)names_.back().data();
+    return name;
+  }
+
+  int round_trips_ = 0;
+  std::vector<std::string> names_;
+  std::vector<tAVRC_ATTR_ENTRY> attrs_;
+};
+
+BtifRcBrowseCache::Range MakeRange(uint32_t start_item, uint32_t end_item) {
+  BtifRcBrowseCache::Range range;
+  range.scope = AVRC_SCOPE_FILE_SYSTEM;
+  range.start_item = start_item;
+  range.end_item = end_item;
+  range.attrs.num_attr = 2;
+  range.attrs.attr_ids = {AVRC_MEDIA_ATTR_ID_TITLE, AVRC_MEDIA_ATTR_ID_ARTIST};
+  return range;
+}
+
+std::string ItemName(const tAVRC_ITEM& item) {
+  return std::string((const char*)item.u.media.name.p_str,
+                     item.u.media.name.str_len);
+}
+
+}  // namespace
+
+class BtifRcBrowseCacheTest : public ::testing::Test {
+ protected:
+  /* Mirrors btif_rc: answer from the cache, otherwise forward to the player
+   * and file the response, then prefetch the next page if asked to. The name
+   * of the first item is captured before the prefetch reuses the player
+   * buffers. Returns the simulated response latency in microseconds. */
+  double Request(const BtifRcBrowseCache::Range& range, size_t* p_num_items,
+                 std::string* p_first_name) {
+    std::vector<tAVRC_ITEM> rsp_items;
+    std::vector<tAVRC_ITEM>* p_items = &rsp_items;
+    uint16_t uid_counter;
+    auto start = std::chrono::steady_clock::now();
+    bool hit = cache_.Lookup(range, &uid_counter, p_items);
+    double latency_us = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+    if (!hit) {
+      Fetch(range, p_items);
+      latency_us += kPlayerRoundTripUs;
+    } else {
+      EXPECT_EQ(kUidCounter, uid_counter);
+    }
+    cache_.RecordLatency(hit, latency_us);
+    *p_num_items = p_items->size();
+    *p_first_name = p_items->empty() ? "" : ItemName((*p_items)[0]);
+
+    /* The prefetch completes before the remote sends its next command */
+    BtifRcBrowseCache::Range prefetch;
+    if (cache_.GetPrefetchRange(&prefetch)) {
+      std::vector<tAVRC_ITEM> items;
+      cache_.SetPrefetchPending(prefetch, 0);
+      player_.GetItems(prefetch.start_item, prefetch.end_item, &items);
+      Complete(items);
+    }
+    return latency_us;
+  }
+
+  /* Forwards |range| to the player and files its response */
+  void Fetch(const BtifRcBrowseCache::Range& range,
+             std::vector<tAVRC_ITEM>* p_items) {
+    cache_.SetPendingRequest(range, 0);
+    player_.GetItems(range.start_item, range.end_item, p_items);
+    Complete(*p_items);
+  }
+
+  /* Files a player response against the outstanding request's tag */
+  bool Complete(const std::vector<tAVRC_ITEM>& items) {
+    BtifRcBrowseCache::Request request;
+    if (!cache_.CompleteRequest(&request)) return false;
+    return cache_.Store(request, kUidCounter, items.data(), items.size());
+  }
+
+  void PrintLatency(const char* name, int requests) {
+    const BtifRcBrowseCache::Stats& stats = cache_.GetStats();
+    printf(
+        "%s: %d requests, %u hits (mean %.1f us), %u misses (mean %.1f us), "
+        "mean latency %.1f us\n",
+        name, requests, stats.hits, (double)stats.hit_latency.MeanUs(),
+        stats.misses, (double)stats.miss_latency.MeanUs(),
+        (double)(stats.hit_latency.total_us + stats.miss_latency.total_us) /
+            requests);
+  }
+
+  BtifRcBrowseCache cache_;
+  FakeMediaPlayer player_;
+};
+
+TEST_F(BtifRcBrowseCacheTest, test_overlapping_range_hits) {
+  std::vector<tAVRC_ITEM> items;
+  Fetch(MakeRange(0, 19), &items);
+
+  uint16_t uid_counter = 0;
+  ASSERT_TRUE(cache_.Lookup(MakeRange(5, 14), &uid_counter, &items));
+  EXPECT_EQ(kUidCounter, uid_counter);
+  ASSERT_EQ(10u, items.size());
+  EXPECT_EQ("Track 5", ItemName(items[0]));
+  EXPECT_EQ("Track 14", ItemName(items[9]));
+  ASSERT_EQ(2, items[0].u.media.attr_count);
+  EXPECT_EQ(AVRC_MEDIA_ATTR_ID_ARTIST, items[0].u.media.p_attr_list[1].attr_id);
+
+  /* Beyond the window and not at the end of the folder */
+  EXPECT_FALSE(cache_.Lookup(MakeRange(10, 29), &uid_counter, &items));
+  /* Different attribute selection */
+  BtifRcBrowseCache::Range range = MakeRange(0, 9);
+  range.attrs.num_attr = 0xFF;
+  range.attrs.attr_ids.clear();
+  EXPECT_FALSE(cache_.Lookup(range, &uid_counter, &items));
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_end_of_folder) {
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter;
+  BtifRcBrowseCache::Range range = MakeRange(kFolderSize - 10, kFolderSize + 9);
+  Fetch(range, &items);
+
+  ASSERT_TRUE(cache_.Lookup(MakeRange(kFolderSize - 5, kFolderSize + 100),
+                            &uid_counter, &items));
+  EXPECT_EQ(5u, items.size());
+  BtifRcBrowseCache::Range prefetch;
+  EXPECT_FALSE(cache_.GetPrefetchRange(&prefetch));
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_invalidation) {
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter;
+  Fetch(MakeRange(0, 19), &items);
+
+  cache_.OnUidCounterChanged(kUidCounter);
+  EXPECT_TRUE(cache_.Lookup(MakeRange(0, 9), &uid_counter, &items));
+  cache_.InvalidateScope(AVRC_SCOPE_NOW_PLAYING);
+  EXPECT_TRUE(cache_.Lookup(MakeRange(0, 9), &uid_counter, &items));
+  cache_.OnUidCounterChanged(kUidCounter + 1);
+  EXPECT_FALSE(cache_.Lookup(MakeRange(0, 9), &uid_counter, &items));
+  EXPECT_EQ(0u, cache_.Size());
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_stale_prefetch_is_dropped) {
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter;
+  Fetch(MakeRange(0, 19), &items);
+
+  BtifRcBrowseCache::Range prefetch;
+  ASSERT_TRUE(cache_.GetPrefetchRange(&prefetch));
+  EXPECT_EQ(20u, prefetch.start_item);
+  EXPECT_EQ(39u, prefetch.end_item);
+  cache_.SetPrefetchPending(prefetch, 0);
+
+  /* Remote jumps elsewhere; the folder changes under the prefetch */
+  cache_.OnUidCounterChanged(kUidCounter + 1);
+  player_.GetItems(prefetch.start_item, prefetch.end_item, &items);
+  EXPECT_TRUE(Complete(items));
+  EXPECT_FALSE(cache_.IsPrefetchPending());
+  EXPECT_FALSE(cache_.Lookup(MakeRange(20, 39), &uid_counter, &items));
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_sequential_paging_20k_items) {
+  size_t num_items;
+  std::string first_name;
+  double total_us = 0;
+  int pages = 0;
+  for (uint32_t start = 0; start < kFolderSize; start += kPageSize) {
+    total_us += Request(MakeRange(start, start + kPageSize - 1), &num_items,
+                        &first_name);
+    ASSERT_EQ(kPageSize, num_items);
+    EXPECT_EQ("Track " + std::to_string(start), first_name);
+    pages++;
+  }
+
+  PrintLatency("sequential", pages);
+  EXPECT_GT(total_us, 0);
+  const BtifRcBrowseCache::Stats& stats = cache_.GetStats();
+  /* Only the very first page has to wait for the media player */
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_LE(cache_.Size(), BtifRcBrowseCache::kDefaultCapacity);
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_random_paging_20k_items) {
+  size_t num_items;
+  std::string first_name;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> dist(0, kFolderSize - kPageSize);
+  double total_us = 0;
+  const int kRequests = 2000;
+  for (int i = 0; i < kRequests; i++) {
+    /* Head units jump, then scroll a little around the landing point */
+    uint32_t start = dist(rng);
+    for (int step = 0; step < 3; step++) {
+      uint32_t page_start = start + step * (kPageSize / 2);
+      total_us += Request(MakeRange(page_start, page_start + kPageSize - 1),
+                          &num_items, &first_name);
+      ASSERT_NE(0u, num_items);
+      EXPECT_EQ("Track " + std::to_string(page_start), first_name);
+    }
+  }
+
+  PrintLatency("random", kRequests * 3);
+  EXPECT_GT(total_us, 0);
+  const BtifRcBrowseCache::Stats& stats = cache_.GetStats();
+  /* Only the jump itself misses; the overlapping scroll is local */
+  EXPECT_LE(stats.misses, (uint32_t)kRequests);
+  EXPECT_GE(stats.hits, 2u * kRequests);
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_untagged_response_is_dropped) {
+  std::vector<tAVRC_ITEM> items;
+  player_.GetItems(0, 19, &items);
+  BtifRcBrowseCache::Request request;
+  EXPECT_FALSE(cache_.CompleteRequest(&request));
+  EXPECT_EQ(1u, cache_.GetStats().dropped_responses);
+  EXPECT_EQ(0u, cache_.Size());
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_mismatched_response_is_dropped) {
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter;
+
+  /* More items than the tagged range can hold */
+  cache_.SetPendingRequest(MakeRange(0, 9), 0);
+  player_.GetItems(0, 19, &items);
+  EXPECT_FALSE(Complete(items));
+  EXPECT_FALSE(cache_.IsRequestPending());
+  EXPECT_FALSE(cache_.Lookup(MakeRange(0, 9), &uid_counter, &items));
+
+  /* A media listing filed against a player list request */
+  BtifRcBrowseCache::Range players = MakeRange(0, 19);
+  players.scope = AVRC_SCOPE_PLAYER_LIST;
+  cache_.SetPendingRequest(players, 0);
+  player_.GetItems(0, 19, &items);
+  EXPECT_FALSE(Complete(items));
+
+  /* Folders cannot be in the now playing list */
+  BtifRcBrowseCache::Range now_playing = MakeRange(0, 0);
+  now_playing.scope = AVRC_SCOPE_NOW_PLAYING;
+  items.resize(1);
+  items[0].item_type = AVRC_ITEM_FOLDER;
+  cache_.SetPendingRequest(now_playing, 0);
+  EXPECT_FALSE(Complete(items));
+
+  EXPECT_EQ(3u, cache_.GetStats().dropped_responses);
+  EXPECT_EQ(0u, cache_.Size());
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_timed_out_request_lets_deferred_go) {
+  std::vector<tAVRC_ITEM> items;
+  cache_.SetPendingRequest(MakeRange(0, 19), 0);
+  cache_.DeferRequest(MakeRange(20, 39), 0);
+
+  /* The player never answers; the timeout completes the tag */
+  BtifRcBrowseCache::Request request;
+  ASSERT_TRUE(cache_.CompleteRequest(&request));
+  cache_.RecordTimeout();
+  EXPECT_FALSE(cache_.IsRequestPending());
+  EXPECT_EQ(1u, cache_.GetStats().timeouts);
+
+  ASSERT_TRUE(cache_.PopDeferredRequest(&request));
+  EXPECT_EQ(20u, request.range.start_item);
+  Fetch(request.range, &items);
+  EXPECT_EQ(20u, items.size());
+
+  /* The late answer to the first request no longer has a tag */
+  player_.GetItems(0, 19, &items);
+  EXPECT_FALSE(Complete(items));
+  EXPECT_EQ(1u, cache_.GetStats().dropped_responses);
+}
+
+TEST_F(BtifRcBrowseCacheTest, test_deferred_request_served_by_prefetch) {
+  std::vector<tAVRC_ITEM> items;
+  uint16_t uid_counter;
+  Fetch(MakeRange(0, 19), &items);
+  ASSERT_TRUE(cache_.Lookup(MakeRange(0, 19), &uid_counter, &items));
+
+  BtifRcBrowseCache::Range prefetch;
+  ASSERT_TRUE(cache_.GetPrefetchRange(&prefetch));
+  cache_.SetPrefetchPending(prefetch, 0);
+
+  /* The remote asks for the next page while the prefetch is in flight */
+  cache_.DeferRequest(MakeRange(20, 39), 0);
+  EXPECT_FALSE(cache_.GetPrefetchRange(&prefetch));
+
+  player_.GetItems(prefetch.start_item, prefetch.end_item, &items);
+  BtifRcBrowseCache::Request request;
+  ASSERT_TRUE(cache_.CompleteRequest(&request));
+  EXPECT_TRUE(request.prefetch);
+  EXPECT_EQ(20u, request.range.start_item);
+  EXPECT_TRUE(cache_.Store(request, kUidCounter, items.data(), items.size()));
+
+  ASSERT_TRUE(cache_.PopDeferredRequest(&request));
+  EXPECT_FALSE(request.prefetch);
+  ASSERT_TRUE(cache_.Lookup(request.range, &uid_counter, &items));
+  EXPECT_EQ("Track 20", ItemName(items[0]));
+  EXPECT_FALSE(cache_.PopDeferredRequest(&request));
+}
@@ -0,0 +1,208 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <map>
+#include <random>
+
+#include "btif/include/btif_scan_metadata_cache.h"
+
+namespace {
+
+const uint32_t kDevTypeBredr = 0x1;
+const uint32_t kDevTypeBle = 0x2;
+const uint32_t kDevTypeDumo = 0x3;
+const uint8_t kAddrPublic = 0x00;
+const uint8_t kAddrRandom = 0x01;
+
+RawAddress Address(uint32_t n) {
+  RawAddress bd_addr;
+  uint8_t bytes[RawAddress::kLength] = {0x00, 0x1B, (uint8_t)(n >> 24),
+                                        (uint8_t)(n >> 16), (uint8_t)(n >> 8),
+                                        (uint8_t)n};
+  memcpy(bd_addr.address, bytes, sizeof(bytes));
+  return bd_addr;
+}
+
+// In-memory storage that counts the calls reaching it.
+class FakeStorage : public BtifScanMetadataCache::Storage {
+ public:
+  bool GetDeviceType(const RawAddress& bd_addr, uint32_t* dev_type) override {
+    gets++;
+    auto it = dev_types.find(bd_addr);
+    if (it == dev_types.end()) return false;
+    *dev_type = it->second;
+    return true;
+  }
+
+  void SetDeviceType(const RawAddress& bd_addr, uint32_t dev_type) override {
+    sets++;
+    dev_types[bd_addr] = dev_type;
+  }
+
+  bool GetAddrType(const RawAddress& bd_addr, uint8_t* addr_type) override {
+    gets++;
+    auto it = addr_types.find(bd_addr);
+    if (it == addr_types.end()) return false;
+    *addr_type = it->second;
+    return true;
+  }
+
+  void SetAddrType(const RawAddress& bd_addr, uint8_t addr_type) override {
+    sets++;
+    addr_types[bd_addr] = addr_type;
+  }
+
+  void Remove(const RawAddress& bd_addr) {
+    dev_types.erase(bd_addr);
+    addr_types.erase(bd_addr);
+  }
+
+  std::map<RawAddress, uint32_t> dev_types;
+  std::map<RawAddress, uint8_t> addr_types;
+  int gets = 0;
+  int sets = 0;
+};
+
+}  // namespace
+
+TEST(BtifScanMetadataCacheTest, repeated_results_do_not_reach_storage) {
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage);
+
+  EXPECT_TRUE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(kDevTypeBle, storage.dev_types[Address(1)]);
+  EXPECT_EQ(kAddrPublic, storage.addr_types[Address(1)]);
+  int gets = storage.gets;
+  int sets = storage.sets;
+
+  for (int i = 0; i < 100; i++)
+    EXPECT_FALSE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(gets, storage.gets);
+  EXPECT_EQ(sets, storage.sets);
+
+  EXPECT_EQ(100u, cache.stats().unchanged);
+  EXPECT_EQ(1u, cache.stats().loads);
+}
+
+TEST(BtifScanMetadataCacheTest, known_device_is_not_rewritten) {
+  FakeStorage storage;
+  storage.dev_types[Address(1)] = kDevTypeDumo;
+  storage.addr_types[Address(1)] = kAddrPublic;
+  BtifScanMetadataCache cache(&storage);
+
+  EXPECT_FALSE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(0, storage.sets);
+}
+
+// A connect or bond right after a scan result reads storage directly
+TEST(BtifScanMetadataCacheTest, changes_are_written_through) {
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage);
+
+  EXPECT_TRUE(cache.Update(Address(1), kDevTypeBle, kAddrRandom));
+  EXPECT_EQ(kDevTypeBle, storage.dev_types[Address(1)]);
+  EXPECT_EQ(kAddrRandom, storage.addr_types[Address(1)]);
+
+  EXPECT_TRUE(cache.Update(Address(1), kDevTypeBredr, kAddrPublic));
+  EXPECT_EQ(kDevTypeDumo, storage.dev_types[Address(1)]);
+  EXPECT_EQ(kAddrPublic, storage.addr_types[Address(1)]);
+
+  EXPECT_FALSE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(4, storage.sets);
+}
+
+TEST(BtifScanMetadataCacheTest, write_keeps_bits_stored_elsewhere) {
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage);
+
+  // Loaded before anything is known about the device type
+  cache.Update(Address(1), 0, kAddrPublic);
+  // Inquiry stored the device meanwhile
+  storage.dev_types[Address(1)] = kDevTypeBredr;
+  EXPECT_TRUE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(kDevTypeDumo, storage.dev_types[Address(1)]);
+}
+
+TEST(BtifScanMetadataCacheTest, eviction_keeps_devices_in_storage) {
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage, 4);
+
+  for (uint32_t i = 0; i < 4; i++)
+    cache.Update(Address(i), kDevTypeBle, kAddrPublic);
+  // Seeing device 0 again makes device 1 the oldest
+  cache.Update(Address(0), kDevTypeBle, kAddrPublic);
+  cache.Update(Address(4), kDevTypeBle, kAddrPublic);
+
+  EXPECT_EQ(4u, cache.size());
+  EXPECT_EQ(1u, cache.stats().evictions);
+  EXPECT_EQ(5u, storage.dev_types.size());
+
+  // The evicted device is read again, not rewritten
+  int sets = storage.sets;
+  EXPECT_FALSE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(sets, storage.sets);
+}
+
+TEST(BtifScanMetadataCacheTest, names_are_reported_once_per_scan) {
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage);
+
+  EXPECT_TRUE(cache.MarkReported(Address(1)));
+  EXPECT_FALSE(cache.MarkReported(Address(1)));
+  // Marking does not read storage; the first update does
+  EXPECT_EQ(0, storage.gets);
+  cache.Update(Address(1), kDevTypeBle, kAddrPublic);
+  EXPECT_EQ(1u, cache.stats().loads);
+  EXPECT_FALSE(cache.MarkReported(Address(1)));
+
+  cache.ResetReported();
+  EXPECT_TRUE(cache.MarkReported(Address(1)));
+  EXPECT_FALSE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+}
+
+TEST(BtifScanMetadataCacheTest, forgotten_device_is_stored_again) {
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage);
+
+  cache.Update(Address(1), kDevTypeBle, kAddrPublic);
+
+  // Unbond removed the storage entry
+  storage.Remove(Address(1));
+  cache.Forget(Address(1));
+  EXPECT_EQ(0u, cache.size());
+
+  EXPECT_TRUE(cache.Update(Address(1), kDevTypeBle, kAddrPublic));
+  EXPECT_EQ(kDevTypeBle, storage.dev_types[Address(1)]);
+  EXPECT_EQ(kAddrPublic, storage.addr_types[Address(1)]);
+}
+
+// Dense scanning: a few hundred advertisers, each seen many times. Before
+// the cache every result did a read and one or two writes.
+TEST(BtifScanMetadataCacheTest, dense_scan_storage_calls) {
+  const int kResults = 200000;
+  const uint32_t kDevices = 300;
+  FakeStorage storage;
+  BtifScanMetadataCache cache(&storage);
+  std::mt19937 rng(32);
+
+  for (int i = 0; i < kResults; i++) {
+    uint32_t device = rng() % kDevices;
+    cache.Update(Address(device), kDevTypeBle,
+                 device % 3 ? kAddrPublic : kAddrRandom);
+  }
+
+  int legacy_calls = 2 * kResults;
+  int calls = storage.gets + storage.sets;
+  EXPECT_EQ(kDevices, storage.dev_types.size());
+  EXPECT_LT(calls * 100, legacy_calls);
+  printf("dense scan: %d results, %d storage calls (%d reads %d writes), "
+         "at least %d before\n",
+         kResults, calls, storage.gets, storage.sets, legacy_calls);
+}
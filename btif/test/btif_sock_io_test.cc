@@ -0,0 +1,489 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "btif/include/btif_sock_io.h"
+#include "osi/include/allocator.h"
+
+namespace {
+
+const uint16_t kMtu = 990;  // BTA_RFC_MTU_SIZE
+const uint16_t kOffset = 13;
+const size_t kBufSize = sizeof(BT_HDR) + kOffset + kMtu;
+
+BT_HDR* AllocBuf() {
+  BT_HDR* p_buf = (BT_HDR*)malloc(kBufSize);
+  p_buf->offset = kOffset;
+  p_buf->len = 0;
+  return p_buf;
+}
+
+uint8_t* Payload(BT_HDR* p_buf) { return p_buf->data + p_buf->offset; }
+
+class BtifSockIoTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_STREAM, 0, fds_));
+  }
+
+  void TearDown() override {
+    for (int fd : fds_)
+      if (fd != -1) close(fd);
+    for (BT_HDR* p_buf : bufs_) free(p_buf);
+  }
+
+  BT_HDR** Bufs(size_t count) {
+    while (bufs_.size() < count) bufs_.push_back(AllocBuf());
+    return bufs_.data();
+  }
+
+  int app_fd() { return fds_[0]; }
+  int stack_fd() { return fds_[1]; }
+
+  int fds_[2];
+  std::vector<BT_HDR*> bufs_;
+};
+
+}  // namespace
+
+TEST_F(BtifSockIoTest, recv_scatters_into_buffers) {
+  std::vector<uint8_t> data(2 * kMtu + 100);
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 7;
+  ASSERT_EQ((ssize_t)data.size(), write(app_fd(), data.data(), data.size()));
+
+  BT_HDR** bufs = Bufs(4);
+  ASSERT_EQ((ssize_t)data.size(), btsock_recv_bufs(stack_fd(), bufs, 4, kMtu));
+  EXPECT_EQ(kMtu, bufs[0]->len);
+  EXPECT_EQ(kMtu, bufs[1]->len);
+  EXPECT_EQ(100, bufs[2]->len);
+  EXPECT_EQ(0, bufs[3]->len);
+  EXPECT_EQ(kOffset, bufs[0]->offset);
+
+  std::vector<uint8_t> got;
+  for (int i = 0; i < 3; i++)
+    got.insert(got.end(), Payload(bufs[i]), Payload(bufs[i]) + bufs[i]->len);
+  EXPECT_EQ(data, got);
+}
+
+TEST_F(BtifSockIoTest, recv_takes_no_more_than_buffers_hold) {
+  std::vector<uint8_t> data(3 * kMtu);
+  ASSERT_EQ((ssize_t)data.size(), write(app_fd(), data.data(), data.size()));
+
+  BT_HDR** bufs = Bufs(2);
+  EXPECT_EQ(2 * kMtu, btsock_recv_bufs(stack_fd(), bufs, 2, kMtu));
+  int pending = 0;
+  ASSERT_EQ(0, ioctl(stack_fd(), FIONREAD, &pending));
+  EXPECT_EQ(kMtu, pending);
+}
+
+TEST_F(BtifSockIoTest, recv_without_data_or_after_close) {
+  BT_HDR** bufs = Bufs(2);
+  EXPECT_EQ(0, btsock_recv_bufs(stack_fd(), bufs, 2, kMtu));
+
+  close(fds_[0]);
+  fds_[0] = -1;
+  EXPECT_EQ(0, btsock_recv_bufs(stack_fd(), bufs, 2, kMtu));
+  EXPECT_EQ(0, bufs[0]->len);
+
+  EXPECT_EQ(-1, btsock_recv_bufs(-1, bufs, 2, kMtu));
+}
+
+TEST_F(BtifSockIoTest, send_gathers_buffers) {
+  BT_HDR** bufs = Bufs(3);
+  for (int i = 0; i < 3; i++) {
+    bufs[i]->len = 10 * (i + 1);
+    memset(Payload(bufs[i]), 'a' + i, bufs[i]->len);
+  }
+
+  EXPECT_EQ(3, btsock_send_bufs(stack_fd(), bufs, 3));
+  char got[64];
+  ASSERT_EQ(60, read(app_fd(), got, sizeof(got)));
+  EXPECT_EQ(std::string(10, 'a') + std::string(20, 'b') + std::string(30, 'c'),
+            std::string(got, 60));
+}
+
+TEST_F(BtifSockIoTest, send_advances_partly_sent_buffer) {
+  int sndbuf = 4096;
+  ASSERT_EQ(0, setsockopt(stack_fd(), SOL_SOCKET, SO_SNDBUF, &sndbuf,
+                          sizeof(sndbuf)));
+
+  const size_t kCount = BTSOCK_IO_MAX_BUFS;
+  BT_HDR** bufs = Bufs(kCount);
+  for (size_t i = 0; i < kCount; i++) bufs[i]->len = kMtu;
+
+  // Fill the socket until it takes no more
+  size_t total = 0;
+  int sent;
+  do {
+    for (size_t i = 0; i < kCount; i++) {
+      bufs[i]->offset = kOffset;
+      bufs[i]->len = kMtu;
+    }
+    sent = btsock_send_bufs(stack_fd(), bufs, kCount);
+    ASSERT_GE(sent, 0);
+    for (int i = 0; i < sent; i++) EXPECT_EQ(0, bufs[i]->len);
+    total += sent * kMtu;
+    if (sent < (int)kCount) total += kMtu - bufs[sent]->len;
+  } while (sent == (int)kCount);
+
+  // The first buffer not sent in full is advanced past what was sent
+  EXPECT_EQ(kOffset + kMtu - bufs[sent]->len, bufs[sent]->offset);
+  for (size_t i = sent + 1; i < kCount; i++) {
+    EXPECT_EQ(kMtu, bufs[i]->len);
+    EXPECT_EQ(kOffset, bufs[i]->offset);
+  }
+
+  int pending = 0;
+  ASSERT_EQ(0, ioctl(app_fd(), FIONREAD, &pending));
+  EXPECT_EQ(total, (size_t)pending);
+
+  EXPECT_EQ(-1, btsock_send_bufs(-1, bufs, kCount));
+}
+
+namespace {
+
+// An SDU of |len| bytes numbered |seq|, as received from L2CAP
+BT_HDR* AllocSdu(uint32_t seq, uint16_t len) {
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + kOffset + len);
+  p_buf->offset = kOffset;
+  p_buf->len = len;
+  memset(Payload(p_buf), 0, len);
+  memcpy(Payload(p_buf), &seq, std::min<size_t>(len, sizeof(seq)));
+  return p_buf;
+}
+
+// L2CAP sockets hand SDUs to the app over a SOCK_SEQPACKET socket
+class BtifSockPktRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_SEQPACKET, 0, fds_));
+    memset(&ring_, 0, sizeof(ring_));
+  }
+
+  void TearDown() override {
+    btsock_pkt_ring_clear(&ring_);
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  // Reads the next message from the app side, expecting SDU |seq|
+  void ExpectSdu(uint32_t seq, uint16_t len) {
+    uint8_t msg[2048];
+    ASSERT_EQ(len, recv(app_fd(), msg, sizeof(msg), MSG_DONTWAIT));
+    uint32_t got;
+    memcpy(&got, msg, sizeof(got));
+    EXPECT_EQ(seq, got);
+  }
+
+  int app_fd() { return fds_[0]; }
+  int stack_fd() { return fds_[1]; }
+
+  int fds_[2];
+  btsock_pkt_ring_t ring_;
+};
+
+}  // namespace
+
+TEST_F(BtifSockPktRingTest, send_packets_keeps_message_boundaries) {
+  BT_HDR* bufs[3] = {AllocSdu(1, 10), AllocSdu(2, 300), AllocSdu(3, 4)};
+  EXPECT_EQ(-1, btsock_send_packets(-1, bufs, 3));
+  EXPECT_EQ(3, btsock_send_packets(stack_fd(), bufs, 3));
+  for (BT_HDR* p_buf : bufs) {
+    EXPECT_EQ(0, p_buf->len);
+    osi_free(p_buf);
+  }
+
+  ExpectSdu(1, 10);
+  ExpectSdu(2, 300);
+  ExpectSdu(3, 4);
+}
+
+TEST_F(BtifSockPktRingTest, ring_keeps_order_across_growth_and_wrap) {
+  uint32_t seq = 0;
+  for (int i = 0; i < 12; i++) btsock_pkt_ring_push(&ring_, AllocSdu(seq++, 8));
+  EXPECT_EQ(12u, ring_.count);
+  EXPECT_EQ(96u, ring_.bytes);
+  EXPECT_EQ(0, btsock_pkt_ring_send(stack_fd(), &ring_));
+  EXPECT_EQ(0u, ring_.count);
+  EXPECT_EQ(0u, ring_.bytes);
+
+  // The head is now mid-ring, so these wrap around before the ring grows
+  for (int i = 0; i < 40; i++) btsock_pkt_ring_push(&ring_, AllocSdu(seq++, 8));
+  EXPECT_EQ(40u, ring_.count);
+  EXPECT_EQ(0, btsock_pkt_ring_send(stack_fd(), &ring_));
+
+  for (uint32_t i = 0; i < seq; i++) ExpectSdu(i, 8);
+}
+
+TEST_F(BtifSockPktRingTest, ring_send_resumes_when_app_reads) {
+  int sndbuf = 8192;
+  ASSERT_EQ(0, setsockopt(stack_fd(), SOL_SOCKET, SO_SNDBUF, &sndbuf,
+                          sizeof(sndbuf)));
+
+  const uint32_t kSdus = 200;
+  for (uint32_t i = 0; i < kSdus; i++)
+    btsock_pkt_ring_push(&ring_, AllocSdu(i, kMtu));
+
+  uint32_t next = 0;
+  int ret;
+  while ((ret = btsock_pkt_ring_send(stack_fd(), &ring_)) == 1) {
+    ASSERT_GT(ring_.count, 0u);
+    EXPECT_EQ(ring_.count * kMtu, ring_.bytes);
+    // The app drains what fitted
+    uint8_t msg[2048];
+    while (recv(app_fd(), msg, sizeof(msg), MSG_DONTWAIT) == kMtu) {
+      uint32_t got;
+      memcpy(&got, msg, sizeof(got));
+      ASSERT_EQ(next, got);
+      next++;
+    }
+  }
+  ASSERT_EQ(0, ret);
+  while (next < kSdus) ExpectSdu(next++, kMtu);
+  EXPECT_EQ(0u, ring_.count);
+}
+
+TEST_F(BtifSockPktRingTest, ring_send_error_keeps_packets) {
+  btsock_pkt_ring_push(&ring_, AllocSdu(1, 8));
+  EXPECT_EQ(-1, btsock_pkt_ring_send(-1, &ring_));
+  EXPECT_EQ(1u, ring_.count);
+  EXPECT_EQ(8u, ring_.bytes);
+}
+
+namespace {
+
+const size_t kBenchBytes = 64 * 1024 * 1024;
+
+// The app writing to its end of the socket in 4 kB chunks
+void AppWriter(int fd) {
+  std::vector<uint8_t> chunk(4096, 0x5A);
+  for (size_t left = kBenchBytes; left > 0;) {
+    size_t len = std::min(left, chunk.size());
+    ssize_t ret = write(fd, chunk.data(), len);
+    if (ret <= 0) return;
+    left -= ret;
+  }
+}
+
+// The app reading from its end of the socket
+void AppReader(int fd) {
+  std::vector<uint8_t> chunk(64 * 1024);
+  for (size_t left = kBenchBytes; left > 0;) {
+    ssize_t ret = read(fd, chunk.data(), std::min(left, chunk.size()));
+    if (ret <= 0) return;
+    left -= ret;
+  }
+}
+
+void WaitFor(int fd, short events) {
+  struct pollfd pfd = {fd, events, 0};
+  poll(&pfd, 1, -1);
+}
+
+double MegabytesPerSecond(std::chrono::steady_clock::time_point start) {
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return kBenchBytes / seconds / (1024 * 1024);
+}
+
+// Per wakeup, the batch the RFCOMM tx queue takes
+const size_t kTxBatch = 11;
+
+}  // namespace
+
+// App to stack: one FIONREAD then one recv per buffer, as the previous
+// PORT_WriteDataCO callouts did, against one recvmsg per batch of buffers.
+TEST_F(BtifSockIoTest, app_to_stack_throughput_benchmark) {
+  auto start = std::chrono::steady_clock::now();
+  std::thread writer(AppWriter, app_fd());
+  for (size_t got = 0; got < kBenchBytes;) {
+    WaitFor(stack_fd(), POLLIN);
+    int available = 0;
+    ioctl(stack_fd(), FIONREAD, &available);
+    for (size_t n = 0; available > 0 && n < kTxBatch; n++) {
+      BT_HDR* p_buf = AllocBuf();
+      uint16_t len = std::min<int>(available, kMtu);
+      ssize_t ret = recv(stack_fd(), Payload(p_buf), len, 0);
+      free(p_buf);
+      if (ret <= 0) break;
+      available -= ret;
+      got += ret;
+    }
+  }
+  writer.join();
+  double legacy = MegabytesPerSecond(start);
+
+  start = std::chrono::steady_clock::now();
+  writer = std::thread(AppWriter, app_fd());
+  BT_HDR* bufs[kTxBatch];
+  for (size_t got = 0; got < kBenchBytes;) {
+    WaitFor(stack_fd(), POLLIN);
+    for (size_t n = 0; n < kTxBatch; n++) bufs[n] = AllocBuf();
+    ssize_t ret = btsock_recv_bufs(stack_fd(), bufs, kTxBatch, kMtu);
+    for (size_t n = 0; n < kTxBatch; n++) free(bufs[n]);
+    ASSERT_GE(ret, 0);
+    got += ret;
+  }
+  writer.join();
+  double vectored = MegabytesPerSecond(start);
+
+  printf("app to stack: vectored %.0f MB/s, per buffer %.0f MB/s\n", vectored,
+         legacy);
+}
+
+// Stack to app: one send per queued buffer against one sendmsg per batch of
+// queued buffers.
+TEST_F(BtifSockIoTest, stack_to_app_throughput_benchmark) {
+  const size_t kQueued = BTSOCK_IO_MAX_BUFS;
+  std::vector<BT_HDR*> queue;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread reader(AppReader, app_fd());
+  for (size_t sent = 0; sent < kBenchBytes;) {
+    while (queue.size() < kQueued) {
+      queue.push_back(AllocBuf());
+      queue.back()->len = kMtu;
+    }
+    BT_HDR* p_buf = queue.front();
+    ssize_t ret =
+        send(stack_fd(), Payload(p_buf), p_buf->len, MSG_DONTWAIT);
+    if (ret < 0) {
+      WaitFor(stack_fd(), POLLOUT);
+      continue;
+    }
+    sent += ret;
+    p_buf->offset += ret;
+    p_buf->len -= ret;
+    if (p_buf->len == 0) {
+      free(p_buf);
+      queue.erase(queue.begin());
+    }
+  }
+  reader.join();
+  double legacy = MegabytesPerSecond(start);
+  for (BT_HDR* p_buf : queue) free(p_buf);
+  queue.clear();
+
+  start = std::chrono::steady_clock::now();
+  reader = std::thread(AppReader, app_fd());
+  for (size_t sent = 0; sent < kBenchBytes;) {
+    while (queue.size() < kQueued) {
+      queue.push_back(AllocBuf());
+      queue.back()->len = kMtu;
+    }
+    size_t before = 0;
+    for (BT_HDR* p_buf : queue) before += p_buf->len;
+    int done = btsock_send_bufs(stack_fd(), queue.data(), queue.size());
+    ASSERT_GE(done, 0);
+    size_t after = 0;
+    for (BT_HDR* p_buf : queue) after += p_buf->len;
+    sent += before - after;
+    for (int i = 0; i < done; i++) free(queue[i]);
+    queue.erase(queue.begin(), queue.begin() + done);
+    if (before == after) WaitFor(stack_fd(), POLLOUT);
+  }
+  reader.join();
+  double vectored = MegabytesPerSecond(start);
+  for (BT_HDR* p_buf : queue) free(p_buf);
+
+  printf("stack to app: vectored %.0f MB/s, per buffer %.0f MB/s\n", vectored,
+         legacy);
+}
+
+namespace {
+
+// The app reading |count| messages from its end of a SOCK_SEQPACKET socket
+void AppPacketReader(int fd, uint32_t count) {
+  uint8_t msg[2048];
+  for (uint32_t i = 0; i < count; i++)
+    if (recv(fd, msg, sizeof(msg), 0) <= 0) return;
+}
+
+// The previous L2CAP socket queue: a list node and a copy per SDU
+struct packet {
+  struct packet* next;
+  uint32_t len;
+  uint8_t* data;
+};
+
+}  // namespace
+
+// LE CoC receive path: copying each SDU into a list and sending it with one
+// send() per SDU, against queueing the SDU itself in the ring and sending
+// batches with sendmmsg.
+TEST_F(BtifSockPktRingTest, l2cap_rx_throughput_benchmark) {
+  for (uint16_t sdu_len : {(uint16_t)23, (uint16_t)247, kMtu}) {
+    const uint32_t kSdus = 200000;
+    const uint32_t kBurst = 32;  // SDUs per data indication
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread reader(AppPacketReader, app_fd(), kSdus);
+    struct packet* first = NULL;
+    struct packet* last = NULL;
+    for (uint32_t seq = 0; seq < kSdus || first;) {
+      for (uint32_t n = 0; n < kBurst && seq < kSdus; n++, seq++) {
+        BT_HDR* p_buf = AllocSdu(seq, sdu_len);
+        struct packet* p = (struct packet*)osi_calloc(sizeof(*p));
+        p->data = (uint8_t*)osi_malloc(p_buf->len);
+        p->len = p_buf->len;
+        memcpy(p->data, Payload(p_buf), p_buf->len);
+        osi_free(p_buf);
+        if (last)
+          last->next = p;
+        else
+          first = p;
+        last = p;
+      }
+      while (first) {
+        ssize_t ret = send(stack_fd(), first->data, first->len, MSG_DONTWAIT);
+        if (ret < 0) {
+          WaitFor(stack_fd(), POLLOUT);
+          continue;
+        }
+        struct packet* p = first;
+        first = p->next;
+        if (!first) last = NULL;
+        osi_free(p->data);
+        osi_free(p);
+      }
+    }
+    reader.join();
+    double legacy = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    start = std::chrono::steady_clock::now();
+    reader = std::thread(AppPacketReader, app_fd(), kSdus);
+    for (uint32_t seq = 0; seq < kSdus || ring_.count;) {
+      for (uint32_t n = 0; n < kBurst && seq < kSdus; n++, seq++)
+        btsock_pkt_ring_push(&ring_, AllocSdu(seq, sdu_len));
+      while (btsock_pkt_ring_send(stack_fd(), &ring_) == 1)
+        WaitFor(stack_fd(), POLLOUT);
+    }
+    reader.join();
+    double ring = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    printf("%4u byte SDUs: ring %.2f M SDU/s, list %.2f M SDU/s\n", sdu_len,
+           kSdus / ring / 1e6, kSdus / legacy / 1e6);
+  }
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "btif/include/btif_uid.h"
+
+namespace {
+
+struct Traffic {
+  uint64_t rx_bytes;
+  uint64_t tx_bytes;
+};
+
+// Reads and clears |set|, by UID
+std::map<int32_t, Traffic> ReadAndClear(uid_set_t* set) {
+  std::map<int32_t, Traffic> traffic;
+  bt_uid_traffic_t* data = uid_set_read_and_clear(set);
+  for (bt_uid_traffic_t* p = data; p->app_uid != -1; p++) {
+    EXPECT_EQ(0u, traffic.count(p->app_uid)) << "uid " << p->app_uid;
+    traffic[p->app_uid] = {p->rx_bytes, p->tx_bytes};
+  }
+  osi_free(data);
+  return traffic;
+}
+
+}  // namespace
+
+TEST(BtifUidTest, counts_tx_and_rx_per_uid) {
+  uid_set_t* set = uid_set_create();
+  uid_set_add_tx(set, 1000, 10);
+  uid_set_add_tx(set, 1000, 5);
+  uid_set_add_rx(set, 1000, 7);
+  uid_set_add_rx(set, 2000, 3);
+
+  auto traffic = ReadAndClear(set);
+  ASSERT_EQ(2u, traffic.size());
+  EXPECT_EQ(7u, traffic[1000].rx_bytes);
+  EXPECT_EQ(15u, traffic[1000].tx_bytes);
+  EXPECT_EQ(3u, traffic[2000].rx_bytes);
+  EXPECT_EQ(0u, traffic[2000].tx_bytes);
+  uid_set_destroy(set);
+}
+
+TEST(BtifUidTest, ignores_unknown_uid_and_empty_writes) {
+  uid_set_t* set = uid_set_create();
+  uid_set_add_tx(set, -1, 10);
+  uid_set_add_rx(set, 1000, 0);
+  uid_set_add_tx(NULL, 1000, 10);
+  EXPECT_TRUE(ReadAndClear(set).empty());
+  uid_set_destroy(set);
+}
+
+TEST(BtifUidTest, read_clears_counters_but_keeps_uids) {
+  uid_set_t* set = uid_set_create();
+  uid_set_add_tx(set, 1000, 10);
+  ReadAndClear(set);
+
+  auto traffic = ReadAndClear(set);
+  ASSERT_EQ(1u, traffic.size());
+  EXPECT_EQ(0u, traffic[1000].tx_bytes);
+
+  uid_set_add_rx(set, 1000, 4);
+  EXPECT_EQ(4u, ReadAndClear(set)[1000].rx_bytes);
+  uid_set_destroy(set);
+}
+
+// More UIDs than a shard has slots
+TEST(BtifUidTest, many_uids) {
+  uid_set_t* set = uid_set_create();
+  const int32_t kUids = 1000;
+  for (int32_t uid = 0; uid < kUids; uid++) {
+    uid_set_add_tx(set, 10000 + uid, uid + 1);
+    uid_set_add_rx(set, 10000 + uid, 2 * (uid + 1));
+  }
+
+  auto traffic = ReadAndClear(set);
+  ASSERT_EQ((size_t)kUids, traffic.size());
+  for (int32_t uid = 0; uid < kUids; uid++) {
+    EXPECT_EQ((uint64_t)uid + 1, traffic[10000 + uid].tx_bytes);
+    EXPECT_EQ(2 * ((uint64_t)uid + 1), traffic[10000 + uid].rx_bytes);
+  }
+  uid_set_destroy(set);
+}
+
+// Adds from many threads, read concurrently; no byte is lost or counted twice
+TEST(BtifUidTest, concurrent_adds_and_reads_are_exact) {
+  uid_set_t* set = uid_set_create();
+  const int kThreads = 8;
+  const int kAdds = 100000;
+  const int32_t kUids = 40;
+
+  std::atomic<bool> done(false);
+  std::map<int32_t, Traffic> total;
+  std::thread reader([&]() {
+    while (!done) {
+      for (auto& it : ReadAndClear(set)) {
+        total[it.first].rx_bytes += it.second.rx_bytes;
+        total[it.first].tx_bytes += it.second.tx_bytes;
+      }
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; t++) {
+    writers.emplace_back([set, t]() {
+      for (int i = 0; i < kAdds; i++) {
+        int32_t uid = 10000 + (i + t) % kUids;
+        uid_set_add_tx(set, uid, 1);
+        uid_set_add_rx(set, uid, 2);
+      }
+    });
+  }
+  for (auto& writer : writers) writer.join();
+  done = true;
+  reader.join();
+  for (auto& it : ReadAndClear(set)) {
+    total[it.first].rx_bytes += it.second.rx_bytes;
+    total[it.first].tx_bytes += it.second.tx_bytes;
+  }
+
+  ASSERT_EQ((size_t)kUids, total.size());
+  for (auto& it : total) {
+    EXPECT_EQ((uint64_t)kThreads * kAdds / kUids, it.second.tx_bytes);
+    EXPECT_EQ(2 * (uint64_t)kThreads * kAdds / kUids, it.second.rx_bytes);
+  }
+  uid_set_destroy(set);
+}
+
+namespace {
+
+// The previous accounting: one lock and a list walk per packet
+class LockedUidList {
+ public:
+  void AddTx(int32_t app_uid, uint64_t bytes) {
+    std::unique_lock<std::mutex> guard(lock_);
+    for (auto& node : nodes_) {
+      if (node.app_uid == app_uid) {
+        node.tx_bytes += bytes;
+        return;
+      }
+    }
+    bt_uid_traffic_t node = {};
+    node.app_uid = app_uid;
+    node.tx_bytes = bytes;
+    nodes_.push_back(node);
+  }
+
+ private:
+  std::mutex lock_;
+  std::vector<bt_uid_traffic_t> nodes_;
+};
+
+template <typename AddFn>
+double NanosPerAdd(int threads, int adds, AddFn add) {
+  const int32_t kSockets = 32;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([t, adds, &add]() {
+      for (int i = 0; i < adds; i++) add(10000 + (i * 7 + t) % kSockets, 990);
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  return (double)ns / ((double)threads * adds);
+}
+
+}  // namespace
+
+// Per-packet cost of the accounting with sockets of 32 apps spread over 1 to
+// 8 threads: the wall time of all threads over the number of adds.
+TEST(BtifUidTest, contention_benchmark) {
+  const int kAdds = 1000000;
+  for (int threads : {1, 2, 4, 8}) {
+    uid_set_t* set = uid_set_create();
+    double sharded =
+        NanosPerAdd(threads, kAdds, [set](int32_t uid, uint64_t n) {
+          uid_set_add_tx(set, uid, n);
+        });
+    uint64_t counted = 0;
+    for (auto& it : ReadAndClear(set)) counted += it.second.tx_bytes;
+    EXPECT_EQ((uint64_t)threads * kAdds * 990, counted);
+    uid_set_destroy(set);
+
+    LockedUidList list;
+    double locked =
+        NanosPerAdd(threads, kAdds, [&list](int32_t uid, uint64_t n) {
+          list.AddTx(uid, n);
+        });
+
+    printf("%d threads: sharded %6.1f ns/add, locked list %6.1f ns/add\n",
+           threads, sharded, locked);
+  }
+}
@@ -65,6 +65,11 @@ typedef struct btsnoop_t {
                                uint16_t remote_cid, uint16_t psm, bool flow);
   // L2CAP channel is closed.
   void (*set_l2cap_channel_close)(uint16_t handle, uint16_t local_cid, uint16_t remote_cid);
+
+  // Mark an L2CAP channel as carrying A2DP media, or clear the mark. Media
+  // packets are left out of the lite snoop logs.
+  void (*set_media_channel)(uint16_t conn_handle, uint16_t local_cid,
+                            uint16_t remote_cid, bool media);
 } btsnoop_t;
 
 const btsnoop_t* btsnoop_get_interface(void);
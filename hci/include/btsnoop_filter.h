@@ -0,0 +1,150 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Classification of the L2CAP channels seen in the snoop log, keyed by ACL
+// handle and CID. It is updated when channels open and close so that the
+// filter decision for an ACL packet takes a single table lookup instead of
+// walking per-connection sets.
+//
+// Received packets carry the local CID and sent packets the remote CID, so
+// every channel is tracked once per direction. Not thread safe.
+class BtsnoopFilterTable {
+ public:
+  // Packet classes of a channel.
+  enum : uint8_t {
+    kWhitelisted = 1 << 0,   // filtered mode: logged in full
+    kRfcomm = 1 << 1,        // carries RFCOMM, filtered by DLCI
+    kMedia = 1 << 2,         // A2DP media
+    kProfileL2cap = 1 << 3,  // profile filter: L2CAP based profile channel
+    kFlowExt = 1 << 4,       // profile filter: I-frames with a control field
+  };
+
+  // How the profile filter sees an ACL packet.
+  struct ProfileMatch {
+    int8_t profile;  // matched profile, -1 if the packet is logged in full
+    bool rfcomm;     // profile data carried in an RFCOMM UIH frame
+    bool fragment;   // continuation of an L2CAP SDU of |profile|
+    uint32_t payload_offset;  // offset of the profile payload in the packet
+  };
+
+  BtsnoopFilterTable();
+
+  // Filtered mode: logs |local_cid|/|remote_cid| of |handle| in full.
+  void WhitelistChannel(uint16_t handle, uint16_t local_cid,
+                        uint16_t remote_cid);
+
+  // Filtered mode: logs the RFCOMM |dlci| of |handle| in full.
+  void WhitelistDlci(uint16_t handle, uint8_t dlci);
+
+  // The channel carries RFCOMM. A link has one RFCOMM channel; setting a new
+  // one drops the DLCIs and RFCOMM profiles of the previous one.
+  void SetRfcommChannel(uint16_t handle, uint16_t local_cid,
+                        uint16_t remote_cid);
+
+  // Marks the channel as A2DP media, or not.
+  void SetMediaChannel(uint16_t handle, uint16_t local_cid,
+                       uint16_t remote_cid, bool media);
+
+  // Profile filter: the channel carries |profile| directly over L2CAP.
+  // |flow_ext| is set for channels using ERTM or streaming mode.
+  void SetL2capProfile(uint16_t handle, uint16_t local_cid,
+                       uint16_t remote_cid, int8_t profile, bool flow_ext);
+
+  // Profile filter: RFCOMM server channel |scn| of |handle| carries
+  // |profile|. |flow_ext| is set for credit based flow control.
+  void SetRfcommProfile(uint16_t handle, int8_t profile, uint8_t scn,
+                        bool flow_ext);
+
+  // Profile filter: RFCOMM server channel |scn| of |handle| was closed.
+  void ClearRfcommProfile(uint16_t handle, uint8_t scn);
+
+  // Forgets everything about the channel.
+  void RemoveChannel(uint16_t handle, uint16_t local_cid, uint16_t remote_cid);
+
+  // Returns the packet classes of |cid| on |handle|.
+  uint8_t GetFlags(uint16_t handle, bool local, uint16_t cid) const;
+
+  // Filtered mode: returns true if only the headers of the ACL |packet| may be
+  // logged.
+  bool ShouldTruncate(const uint8_t* packet, bool is_received) const;
+
+  // Returns true if the ACL |packet| is A2DP media.
+  bool IsMediaPacket(const uint8_t* packet, bool is_received) const;
+
+  // Profile filter: classifies the ACL |packet| of |length| bytes, ACL header
+  // included. Continuation fragments are attributed to the channel of the
+  // last start fragment seen on the same link.
+  ProfileMatch MatchProfile(const uint8_t* packet, uint32_t length,
+                            bool is_received);
+
+  void Clear();
+
+  size_t channel_count() const { return channels_.size(); }
+
+ private:
+  struct Channel {
+    uint8_t flags;
+    int8_t profile;
+  };
+
+  struct Link {
+    uint16_t rfcomm_lcid;
+    uint16_t rfcomm_rcid;
+    uint16_t last_cid;        // channel of the last start fragment
+    uint64_t dlci_mask;       // filtered mode: whitelisted DLCIs
+    uint32_t scn_flow_mask;   // server channels using credit flow control
+    int8_t scn_profile[32];   // profile per RFCOMM server channel, or -1
+  };
+
+  // Open addressing hash table with linear probing; small, flat and
+  // allocation free once sized.
+  template <typename T>
+  class FlatTable {
+   public:
+    explicit FlatTable(size_t capacity);
+    T* Find(uint32_t key);
+    const T* Find(uint32_t key) const;
+    T* FindOrInsert(uint32_t key, const T& initial);
+    void Erase(uint32_t key);
+    void Clear();
+    size_t size() const { return size_; }
+
+   private:
+    static const uint32_t kEmptyKey = 0xFFFFFFFF;
+    struct Slot {
+      uint32_t key;
+      T value;
+    };
+    size_t Index(uint32_t key) const;
+    void Grow();
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    int shift_;
+    size_t size_;
+  };
+
+  static uint32_t ChannelKey(uint16_t handle, bool local, uint16_t cid) {
+    return ((uint32_t)(handle & 0x0FFF) << 17) | ((uint32_t)local << 16) | cid;
+  }
+
+  Channel* GetChannel(uint16_t handle, bool local, uint16_t cid);
+  Link* GetLink(uint16_t handle);
+  void ResetRfcomm(Link* link);
+  void SetFlags(uint16_t handle, uint16_t local_cid, uint16_t remote_cid,
+                uint8_t flags, bool set);
+  void ReleaseChannel(uint16_t handle, bool local, uint16_t cid);
+
+  FlatTable<Channel> channels_;
+  FlatTable<Link> links_;
+};
@@ -0,0 +1,138 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Commands waiting for a command credit, sorted into lanes by opcode.
+//
+// Connection setup, disconnection and security replies go to the urgent lane,
+// scan, accept list and resolving list churn to the bulk lane, everything
+// else to the normal lane. The next command sent is the head of the highest
+// lane, unless a command queued before it must be sent first: commands that
+// change controller state other commands depend on (the random address, the
+// accept list, whether scanning, initiating or advertising is enabled) are
+// never reordered with them, and HCI_Reset and unknown vendor specific
+// commands are never reordered at all. A lane head passed over too often is
+// sent next.
+//
+// Commands opted in to coalescing replace an unsent command with the same
+// opcode in their lane, if nothing queued after it depends on it. Their
+// caller is answered with the response to the command replacing it.
+//
+// Entries are opaque to the scheduler. Not thread safe.
+class HciCommandScheduler {
+ public:
+  enum Lane : uint8_t { kUrgent = 0, kNormal, kBulk, kNumLanes };
+
+  struct LaneStats {
+    size_t sent;             // commands dequeued
+    size_t coalesced;        // commands replaced before they were sent
+    size_t overtaken;        // times a later command was sent before the head
+    uint64_t total_wait_us;  // queueing latency of the commands sent
+    uint64_t max_wait_us;
+  };
+
+  // FIFO order across lanes unless |prioritize|; no coalescing unless
+  // |coalesce|.
+  HciCommandScheduler(bool prioritize, bool coalesce);
+
+  static Lane GetLane(uint16_t opcode);
+  static const char* LaneName(Lane lane);
+
+  // Returns true if sending |later| before |earlier|, queued before it, may
+  // change the outcome of either.
+  static bool MustKeepOrder(uint16_t earlier, uint16_t later);
+
+  // Opts |opcode| in to coalescing: the last command sent with it wins.
+  void SetCoalescable(uint16_t opcode);
+
+  // Queues |entry|, a command with |opcode|, at |now_us|. Returns the entry
+  // of the unsent command it replaces, or nullptr.
+  void* Enqueue(uint16_t opcode, void* entry, uint64_t now_us);
+
+  // Returns the entry of the next command to send, or nullptr.
+  void* Dequeue(uint64_t now_us);
+
+  bool Empty() const { return size_ == 0; }
+  size_t Size() const { return size_; }
+  size_t Size(Lane lane) const { return lanes_[lane].size(); }
+
+  const LaneStats& GetStats(Lane lane) const { return stats_[lane]; }
+
+ private:
+  // Sent next once passed over this many times.
+  static const size_t kMaxOvertaken = 8;
+
+  struct Queued {
+    uint64_t seq;
+    uint64_t enqueued_us;
+    uint16_t opcode;
+    void* entry;
+  };
+
+  // Returns the oldest command queued before |queued| that must be sent
+  // before it, or nullptr.
+  const Queued* FindBlocker(const Queued& queued) const;
+
+  // Returns |queued| if it can be sent now, else the command it waits for
+  // that can.
+  const Queued* FindSendable(const Queued& queued) const;
+
+  bool prioritize_;
+  bool coalesce_;
+  std::deque<Queued> lanes_[kNumLanes];
+  size_t overtaken_[kNumLanes];
+  size_t size_;
+  uint64_t next_seq_;
+  std::unordered_set<uint16_t> coalescable_;
+  LaneStats stats_[kNumLanes];
+};
+
+// Commands sent and waiting for Command Complete or Command Status, indexed
+// by opcode. Entries are opaque. Not thread safe.
+class HciPendingCommands {
+ public:
+  HciPendingCommands() : next_seq_(0) {}
+
+  void Add(uint16_t opcode, void* entry);
+
+  // Removes and returns the oldest entry sent with |opcode|. Controllers may
+  // answer a vendor specific command with another vendor specific opcode or
+  // none at all, so such responses fall back to the oldest vendor specific
+  // command. Returns nullptr if nothing matches.
+  void* Take(uint16_t opcode);
+
+  // Returns the oldest entry, or nullptr.
+  void* Front() const;
+
+  // Returns all entries, oldest first.
+  std::vector<void*> Entries() const;
+
+  size_t Size() const { return sent_.size(); }
+  bool Empty() const { return sent_.empty(); }
+  void Clear();
+
+ private:
+  struct Sent {
+    uint16_t opcode;
+    void* entry;
+  };
+
+  void* Remove(uint64_t seq);
+
+  uint64_t next_seq_;
+  std::map<uint64_t, Sent> sent_;
+  std::unordered_map<uint16_t, std::deque<uint64_t>> by_opcode_;
+};
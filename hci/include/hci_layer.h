@@ -103,3 +103,6 @@ void post_to_hci_message_loop(const base::Location& from_here,
                               BT_HDR* p_msg);
 
 void hci_layer_cleanup_interface();
+
+// Dumps queueing statistics of HCI commands per priority lane
+void hci_layer_debug_dump(int fd);
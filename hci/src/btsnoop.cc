@@ -36,11 +36,10 @@
 #include <sys/uio.h>
 #include <unistd.h>
 #include <mutex>
-#include <unordered_map>
-#include <unordered_set>
 
 #include "bt_types.h"
 #include "hci/include/btsnoop.h"
+#include "hci/include/btsnoop_filter.h"
 #include "hci/include/btsnoop_mem.h"
 #include "hci_layer.h"
 #include "internal_include/bt_trace.h"
@@ -140,64 +139,10 @@ static const char *cpbr_pattern = "\x0d\x0a+CPBR:";
 
 static uint8_t packet[DEFAULT_PACKET_SIZE];
 
-// Channel tracking variables for filtering.
-
-// Keeps track of L2CAP channels that need to be filtered out of the snoop
-// logs.
-class FilterTracker {
- public:
-  // NOTE: 1 is used as a static CID for L2CAP signaling
-  std::unordered_set<uint16_t> l2c_local_cid = {1};
-  std::unordered_set<uint16_t> l2c_remote_cid = {1};
-  uint16_t rfc_local_cid = 0;
-  uint16_t rfc_remote_cid = 0;
-  std::unordered_set<uint16_t> rfc_channels = {0};
-
-  // Adds L2C channel to whitelist.
-  void addL2cCid(uint16_t local_cid, uint16_t remote_cid) {
-    l2c_local_cid.insert(local_cid);
-    l2c_remote_cid.insert(remote_cid);
-  }
-
-  // Sets L2CAP channel that RFCOMM uses.
-  void setRfcCid(uint16_t local_cid, uint16_t remote_cid) {
-    rfc_local_cid = local_cid;
-    rfc_remote_cid = remote_cid;
-  }
-
-  // Remove L2C channel from whitelist.
-  void removeL2cCid(uint16_t local_cid, uint16_t remote_cid) {
-    if (rfc_local_cid == local_cid) {
-      rfc_channels.clear();
-      rfc_channels.insert(0);
-      rfc_local_cid = 0;
-      rfc_remote_cid = 0;
-    }
-
-    l2c_local_cid.erase(local_cid);
-    l2c_remote_cid.erase(remote_cid);
-  }
-
-  void addRfcDlci(uint8_t channel) { rfc_channels.insert(channel); }
-
-  bool isWhitelistedL2c(bool local, uint16_t cid) {
-    const auto& set = local ? l2c_local_cid : l2c_remote_cid;
-    return (set.find(cid) != set.end());
-  }
-
-  bool isRfcChannel(bool local, uint16_t cid) {
-    const auto& channel = local ? rfc_local_cid : rfc_remote_cid;
-    return cid == channel;
-  }
-
-  bool isWhitelistedDlci(uint8_t dlci) {
-    return rfc_channels.find(dlci) != rfc_channels.end();
-  }
-};
-
-std::mutex filter_list_mutex;
-std::unordered_map<uint16_t, FilterTracker> filter_list;
-std::unordered_map<uint16_t, uint16_t> local_cid_to_acl;
+// Channel tracking for filtering, shared by the filtered and profile filter
+// modes and updated as channels open and close.
+static std::mutex filter_table_mutex;
+static BtsnoopFilterTable filter_table;
 
 typedef enum {
   FILTER_PROFILE_NONE = -1,
@@ -220,140 +165,6 @@ typedef enum {
 #define PROFILE_UUID_HFP_HS 0x1112
 #define PROFILE_UUID_HFP_HF 0x111f
 
-class ProfilesFilter {
-  public:
-    ProfilesFilter() {
-      for (int i = 0; i < FILTER_PROFILE_MAX; i++) {
-        profiles[i].type = (profile_type_t)i;
-        profiles[i].enabled = false;
-        profiles[i].rfcomm_opened = false;
-        profiles[i].l2cap_opened = false;
-      }
-      if (pbap_filtered) {
-        profiles[FILTER_PROFILE_PBAP].enabled =
-        profiles[FILTER_PROFILE_HFP_HS].enabled =
-        profiles[FILTER_PROFILE_HFP_HF].enabled = true;
-      }
-      if (map_filtered) {
-        profiles[FILTER_PROFILE_MAP].enabled = true;
-      }
-      ch_rfc_l = ch_rfc_r = ch_last = 0;
-    }
-
-    bool isHfpProfile(bool local, uint16_t cid, uint8_t dlci) {
-      profile_type_t profile = dlci2profile(local, cid, dlci);
-
-      return profile == FILTER_PROFILE_HFP_HS ||
-              profile == FILTER_PROFILE_HFP_HF;
-    }
-
-    bool isL2capMatch(bool local, uint16_t cid) {
-      return cid2profile(local, cid) != FILTER_PROFILE_NONE;
-    }
-
-    bool isL2capFlowExt(bool local, uint16_t cid) {
-      profile_type_t profile = cid2profile(local, cid);
-      if (profile >= 0)
-        return profiles[profile].flow_ext_l2cap;
-      return false;
-    }
-
-    bool isRfcommMatch(bool local, uint16_t cid, uint8_t dlci) {
-      return dlci2profile(local, cid, dlci) != FILTER_PROFILE_NONE;
-    }
-
-    bool isRfcommFlowExt(bool local, uint16_t cid, uint8_t dlci) {
-      profile_type_t profile = dlci2profile(local, cid, dlci);
-      if (profile >= 0)
-        return profiles[profile].flow_ext_rfcomm;
-      return false;
-    }
-
-    profile_type_t cid2profile(bool local, uint16_t cid) {
-      uint16_t ch;
-
-      for (int i = 0; i < FILTER_PROFILE_MAX; i++) {
-        if(profiles[i].enabled && profiles[i].l2cap_opened) {
-          ch = local ? profiles[i].lcid : profiles[i].rcid;
-          if (ch == cid)
-            return (profile_type_t)i;
-        }
-      }
-      return FILTER_PROFILE_NONE;
-    }
-
-    profile_type_t dlci2profile(bool local, uint16_t cid, uint8_t dlci) {
-      if (!isRfcChannel(local, cid))
-        return FILTER_PROFILE_NONE;
-
-      for (int i = 0; i < FILTER_PROFILE_MAX; i++) {
-        if(profiles[i].enabled && profiles[i].l2cap_opened &&
-               profiles[i].rfcomm_opened &&
-               profiles[i].scn == (dlci>>1))
-          return (profile_type_t)i;
-      }
-      return FILTER_PROFILE_NONE;
-    }
-
-    void profile_l2cap_open(profile_type_t profile, uint16_t lcid,
-                          uint16_t rcid, uint16_t psm, bool flow_ext) {
-      if (profiles[profile].l2cap_opened == true) {
-        LOG_INFO(LOG_TAG, "%s: l2cap for %d was already opened. Override it",
-                        __func__, profile);
-      }
-      profiles[profile].lcid = lcid;
-      profiles[profile].rcid = rcid;
-      profiles[profile].psm  = psm;
-      profiles[profile].flow_ext_l2cap = flow_ext;
-      profiles[profile].l2cap_opened = true;
-    }
-
-    void profile_l2cap_close(profile_type_t profile) {
-      if (profile < 0 || profile >= FILTER_PROFILE_MAX)
-        return;
-      profiles[profile].l2cap_opened = false;
-    }
-
-    void profile_rfcomm_open(profile_type_t profile, uint16_t lcid, uint8_t dlci,
-                         uint16_t uuid, bool flow_ext) {
-      if (profiles[profile].rfcomm_opened == true) {
-        LOG_INFO(LOG_TAG, "%s: rfcomm for %d was already opened. Override it",
-                       __func__, profile);
-      }
-      profiles[profile].rfcomm_uuid = uuid;
-      profiles[profile].scn = (dlci>>1);
-      profiles[profile].flow_ext_rfcomm = flow_ext;
-      profiles[profile].l2cap_opened = true;
-      profiles[profile].rfcomm_opened = true;
-    }
-
-    void profile_rfcomm_close(profile_type_t profile) {
-      if (profile < 0 || profile >= FILTER_PROFILE_MAX)
-        return;
-      profiles[profile].rfcomm_opened = false;
-    }
-
-    bool isRfcChannel(bool local, uint16_t cid) {
-      uint16_t channel = local ? ch_rfc_l : ch_rfc_r;
-      return cid == channel;
-    }
-
-    uint16_t ch_rfc_l, ch_rfc_r;  // local & remote L2CAP channel for RFCOMM
-    uint16_t ch_last;             // last channel seen for fragment packet
-
-private:
-    struct {
-      profile_type_t type;
-      bool enabled, l2cap_opened, rfcomm_opened;
-      bool flow_ext_l2cap, flow_ext_rfcomm;
-      uint16_t lcid, rcid, rfcomm_uuid, psm;
-      uint8_t scn;
-    } profiles[FILTER_PROFILE_MAX];
-};
-
-std::mutex profiles_filter_mutex;
-std::unordered_map<int16_t, ProfilesFilter> profiles_filter_table;
-
 // Cached value for whether full snoop logs are enabled. So the property isn't
 // checked for every packet.
 static bool is_btsnoop_enabled;
@@ -364,7 +175,6 @@ bool is_vndbtsnoop_enabled = false;
 void btsnoop_net_open();
 void btsnoop_net_close();
 void btsnoop_net_write(const void* data, size_t length);
-static bool is_avdt_media_packet(const uint8_t *p, bool is_local_cid);
 
 static void delete_btsnoop_files(bool filtered);
 static std::string get_btsnoop_log_path(bool filtered);
@@ -608,14 +418,12 @@ static void whitelist_l2c_channel(uint16_t conn_handle, uint16_t local_cid,
             << ": Whitelisting l2cap channel. conn_handle=" << conn_handle
             << " cid=" << local_cid << ":" << remote_cid;
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(filter_list_mutex);
+  std::lock_guard lock(filter_table_mutex);
 #else
-  std::lock_guard<std::mutex> lock(filter_list_mutex);
-#endif  //OFF_TARGET_TEST_ENABLED
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
 
-  // This will create the entry if there is no associated filter with the
-  // connection.
-  filter_list[conn_handle].addL2cCid(local_cid, remote_cid);
+  filter_table.WhitelistChannel(conn_handle, local_cid, remote_cid);
 }
 
 static void whitelist_rfc_dlci(uint16_t local_cid, uint8_t dlci) {
@@ -623,14 +431,14 @@ static void whitelist_rfc_dlci(uint16_t local_cid, uint8_t dlci) {
             << ": Whitelisting rfcomm channel. L2CAP CID=" << local_cid
             << " DLCI=" << dlci;
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(filter_list_mutex);
+  std::lock_guard lock(filter_table_mutex);
 #else
-  std::lock_guard<std::mutex> lock(filter_list_mutex);
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
 #endif
 
   tL2C_CCB* p_ccb = l2cu_find_ccb_by_cid(nullptr, local_cid);
   if(p_ccb) {
-    filter_list[p_ccb->p_lcb->handle].addRfcDlci(dlci);
+    filter_table.WhitelistDlci(p_ccb->p_lcb->handle, dlci);
   }
 }
 
@@ -641,13 +449,12 @@ static void add_rfc_l2c_channel(uint16_t conn_handle, uint16_t local_cid,
             << conn_handle << " cid=" << local_cid << ":"
             << remote_cid;
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(filter_list_mutex);
+  std::lock_guard lock(filter_table_mutex);
 #else
-  std::lock_guard<std::mutex> lock(filter_list_mutex);
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
 #endif
 
-  filter_list[conn_handle].setRfcCid(local_cid, remote_cid);
-  local_cid_to_acl.insert({local_cid, conn_handle});
+  filter_table.SetRfcommChannel(conn_handle, local_cid, remote_cid);
 }
 
 static void clear_l2cap_whitelist(uint16_t conn_handle, uint16_t local_cid,
@@ -657,11 +464,25 @@ static void clear_l2cap_whitelist(uint16_t conn_handle, uint16_t local_cid,
             << conn_handle << " cid=" << local_cid << ":" << remote_cid;
 
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(filter_list_mutex);
+  std::lock_guard lock(filter_table_mutex);
+#else
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
+  filter_table.RemoveChannel(conn_handle, local_cid, remote_cid);
+}
+
+static void set_media_channel(uint16_t conn_handle, uint16_t local_cid,
+                              uint16_t remote_cid, bool media) {
+  LOG(INFO) << __func__ << ": conn_handle=" << conn_handle
+            << " cid=" << local_cid << ":" << remote_cid
+            << " media=" << media;
+
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+  std::lock_guard lock(filter_table_mutex);
 #else
-  std::lock_guard<std::mutex> lock(filter_list_mutex);
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
 #endif
-  filter_list[conn_handle].removeL2cCid(local_cid, remote_cid);
+  filter_table.SetMediaChannel(conn_handle, local_cid, remote_cid, media);
 }
 
 static uint32_t payload_strip(uint8_t  *packet, uint32_t hdr_len, uint32_t pl_len) {
@@ -689,96 +510,62 @@ static uint32_t payload_strip(uint8_t  *packet, uint32_t hdr_len, uint32_t pl_le
 }
 
 static uint32_t profiles_filter(bool is_received, uint8_t *packet) {
-  uint8_t *stream = packet;
-  bool frag;
-  uint16_t handle, l2c_chan, l2c_ctl;
+  uint8_t *stream = packet + ACL_LENGTH_OFFSET;
   uint32_t length, totlen, offset;
 
-#if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(profiles_filter_mutex);
-#else
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-#endif
-
-  STREAM_TO_UINT16(handle, stream);
-  frag = (GET_BOUNDARY_FLAG(handle) == CONTINUATION_PACKET_BOUNDARY);
-  handle = handle & HANDLE_MASK;
   STREAM_TO_UINT16(length, stream);
   totlen = length + HCI_HEADER_LENGTH;
   length += PACKET_TYPE_LENGTH + HCI_HEADER_LENGTH; // Additional byte is added for packet type
 
-  STREAM_SKIP_UINT16(stream);
-  STREAM_TO_UINT16(l2c_chan, stream);
-
-  auto &filters = profiles_filter_table[handle];
-  if (frag) {
-    l2c_chan = filters.ch_last;
-  } else {
-    filters.ch_last = l2c_chan;
+  BtsnoopFilterTable::ProfileMatch match;
+  {
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+    std::lock_guard lock(filter_table_mutex);
+#else
+    std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
+    match = filter_table.MatchProfile(packet, totlen, is_received);
   }
-  if (l2c_chan != 0x1 && handle != 0x0edc) {
-    if (filters.isL2capFlowExt(is_received, l2c_chan)) {
-      STREAM_TO_UINT16(l2c_ctl, stream);
-      if (!(l2c_ctl & 1)) { // I-Frame
-        if (((l2c_ctl >> 14) & 0x3) == 0x01) { // Start of L2CAP SDU
-          STREAM_SKIP_UINT16(stream); // skip L2CAP SDU length
-        }
-      }
-    }
-    offset = stream - packet;
-    if (filters.isL2capMatch(is_received, l2c_chan)) {
-      if (frag) {
-        return PACKET_TYPE_LENGTH + HCI_HEADER_LENGTH;
-      }
-      length = payload_strip(packet, offset, totlen - offset);
-    } else {
-      if (filters.isRfcChannel(is_received, l2c_chan)) {
-        uint8_t addr, ctrl, pf;
-
-        STREAM_TO_UINT8(addr, stream);
-        STREAM_TO_UINT8(ctrl, stream);
-        pf = ctrl & 0x10;
-        ctrl = ctrl & 0xef;
-        addr >>= 2;
-        if(ctrl != RFCOMM_UIH) {
-          return length;
-        }
-        if(filters.isRfcommMatch(is_received, l2c_chan, addr)) {
-          uint16_t len;
-          uint8_t ea;
-
-          len = *stream++;
-          ea = len & 1;
-          len = len >> 1;
-          if (!ea) {
-            len += *stream++ << 7;
-          }
-          if (filters.isRfcommFlowExt(is_received, l2c_chan, addr) && pf) {
-            stream ++; // credit byte
-          }
-          offset = stream - packet;
-          if (filters.isHfpProfile(is_received, l2c_chan, addr)) {
-            uint32_t pat_len = strlen(cpbr_pattern);
-
-            if ((totlen - offset) > pat_len) {
-              if (memcmp(&packet[offset], cpbr_pattern, pat_len) == 0) {
-                length = offset + pat_len + 1;
-                packet[ACL_LENGTH_OFFSET] = offset + pat_len - L2C_HEADER_LENGTH;
-                packet[L2C_LENGTH_OFFSET] = offset + pat_len -
-                                              (HCI_HEADER_LENGTH + L2C_HEADER_LENGTH);
-              }
-            }
-          } else {
-            length = payload_strip(packet, offset, totlen - offset);
-          }
-        }
+  if (match.profile == FILTER_PROFILE_NONE) {
+    return length;
+  }
+  if (match.fragment) {
+    return PACKET_TYPE_LENGTH + HCI_HEADER_LENGTH;
+  }
+
+  offset = match.payload_offset;
+  if (match.rfcomm && (match.profile == FILTER_PROFILE_HFP_HS ||
+                       match.profile == FILTER_PROFILE_HFP_HF)) {
+    uint32_t pat_len = strlen(cpbr_pattern);
+
+    if ((totlen - offset) > pat_len) {
+      if (memcmp(&packet[offset], cpbr_pattern, pat_len) == 0) {
+        length = offset + pat_len + 1;
+        packet[ACL_LENGTH_OFFSET] = offset + pat_len - L2C_HEADER_LENGTH;
+        packet[L2C_LENGTH_OFFSET] = offset + pat_len -
+                                      (HCI_HEADER_LENGTH + L2C_HEADER_LENGTH);
       }
     }
+  } else {
+    length = payload_strip(packet, offset, totlen - offset);
   }
 
   return length;
 }
 
+static bool is_profile_filtered(profile_type_t profile) {
+  switch (profile) {
+    case FILTER_PROFILE_PBAP:
+    case FILTER_PROFILE_HFP_HS:
+    case FILTER_PROFILE_HFP_HF:
+      return pbap_filtered;
+    case FILTER_PROFILE_MAP:
+      return map_filtered;
+    default:
+      return false;
+  }
+}
+
 static void set_rfc_port_open(uint16_t handle, uint16_t local_cid,
                           uint8_t dlci, uint16_t uuid, bool flow) {
 
@@ -786,12 +573,6 @@ static void set_rfc_port_open(uint16_t handle, uint16_t local_cid,
     return;
 
   profile_type_t profile = FILTER_PROFILE_NONE;
-#if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(profiles_filter_mutex);
-#else
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-#endif
-  auto &filters = profiles_filter_table[handle];
 
   LOG_INFO(LOG_TAG, "RFCOMM port is opened: handle=%d(0x%x),"
                     " lcid=%d(0x%x), dlci=%d(0x%x), uuid=%d(0x%x)%s",
@@ -808,8 +589,13 @@ static void set_rfc_port_open(uint16_t handle, uint16_t local_cid,
     profile = FILTER_PROFILE_HFP_HF;
   }
 
-  if (profile >= 0) {
-    filters.profile_rfcomm_open(profile, local_cid, dlci, uuid, flow);
+  if (is_profile_filtered(profile)) {
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+    std::lock_guard lock(filter_table_mutex);
+#else
+    std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
+    filter_table.SetRfcommProfile(handle, profile, dlci >> 1, flow);
   }
 }
 
@@ -819,17 +605,16 @@ static void set_rfc_port_close(uint16_t handle, uint16_t local_cid,
   if (!(vendor_logging_level & HCI_SNOOP_LOG_PROFILEFILTER))
     return;
 
-#if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(profiles_filter_mutex);
-#else
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-#endif
-  auto &filters = profiles_filter_table[handle];
   LOG_INFO(LOG_TAG, "RFCOMM port is closed: handle=%d(0x%x),"
                     " lcid=%d(0x%x), dlci=%d(0x%x), uuid=%d(0x%x)", handle,
                     handle, local_cid, local_cid, dlci, dlci, uuid, uuid);
 
-  filters.profile_rfcomm_close(filters.dlci2profile(true, local_cid, dlci));
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+  std::lock_guard lock(filter_table_mutex);
+#else
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
+  filter_table.ClearRfcommProfile(handle, dlci >> 1);
 }
 
 static void set_l2cap_channel_open(uint16_t handle, uint16_t local_cid,
@@ -839,49 +624,42 @@ static void set_l2cap_channel_open(uint16_t handle, uint16_t local_cid,
     return;
 
   profile_type_t profile = FILTER_PROFILE_NONE;
-#if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(profiles_filter_mutex);
-#else
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-#endif
-  auto &filters = profiles_filter_table[handle];
 
   LOG_INFO(LOG_TAG, "L2CAP channel is opened: handle=%d(0x%x), lcid=%d(0x%x),"
                     " rcid=%d(0x%x), psm=0x%x%s", handle, handle, local_cid,
                     local_cid, remote_cid, remote_cid, psm,
                         flow ? " Standard or Enhanced Control enabled" : "");
 
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+  std::lock_guard lock(filter_table_mutex);
+#else
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
   if (psm == PROFILE_PSM_RFCOMM) {
-    filters.ch_rfc_l = local_cid;
-    filters.ch_rfc_r = remote_cid;
+    filter_table.SetRfcommChannel(handle, local_cid, remote_cid);
   } else if (psm == PROFILE_PSM_PBAP) {
     profile = FILTER_PROFILE_PBAP;
   } else if (psm == PROFILE_PSM_MAP) {
     profile = FILTER_PROFILE_MAP;
   }
 
-  if (profile >= 0) {
-    filters.profile_l2cap_open(profile, local_cid, remote_cid, psm, flow);
+  if (is_profile_filtered(profile)) {
+    filter_table.SetL2capProfile(handle, local_cid, remote_cid, profile, flow);
   }
 }
 
 static void set_l2cap_channel_close(uint16_t handle, uint16_t local_cid, uint16_t remote_cid) {
 
-  if (!(vendor_logging_level & HCI_SNOOP_LOG_PROFILEFILTER))
-    return;
-
-#if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(profiles_filter_mutex);
-#else
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-#endif
-  auto &filters = profiles_filter_table[handle];
-
   LOG_INFO(LOG_TAG, "L2CAP channel is closed: handle=%d(0x%x), lcid=%d(0x%x),"
                     " rcid=%d(0x%x)", handle, handle, local_cid, local_cid,
                     remote_cid, remote_cid);
 
-  filters.profile_l2cap_close(filters.cid2profile(true, local_cid));
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+  std::lock_guard lock(filter_table_mutex);
+#else
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
+  filter_table.RemoveChannel(handle, local_cid, remote_cid);
 }
 
 static const btsnoop_t interface = {capture, whitelist_l2c_channel,
@@ -891,6 +669,7 @@ static const btsnoop_t interface = {capture, whitelist_l2c_channel,
                                     ,set_rfc_port_close
                                     ,set_l2cap_channel_open
                                     ,set_l2cap_channel_close
+                                    ,set_media_channel
                                     };
 
 const btsnoop_t* btsnoop_get_interface() { return &interface; }
@@ -1000,40 +779,28 @@ static void calculate_acl_packet_length(uint32_t *length, uint8_t* packet, bool
       }
     }
   } else if (vendor_logging_level & HCI_SNOOP_LOG_LITE) {
-     if(!is_avdt_media_packet(packet, is_received))
+     bool media;
+     {
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+       std::lock_guard lock(filter_table_mutex);
+#else
+       std::lock_guard<std::mutex> lock(filter_table_mutex);
+#endif
+       media = filter_table.IsMediaPacket(packet, is_received);
+     }
+     if (!media)
        *length = def_len;
   } else if (vendor_logging_level & HCI_SNOOP_LOG_PROFILEFILTER) {
      *length = profiles_filter(is_received, packet);
   }
 }
 static bool should_filter_log(bool is_received, uint8_t* packet) {
-  uint16_t acl_handle =
-      HCID_GET_HANDLE((((uint16_t)packet[ACL_CHANNEL_OFFSET + 1]) << 8) +
-                      packet[ACL_CHANNEL_OFFSET]);
-
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
-  std::lock_guard lock(filter_list_mutex);
+  std::lock_guard lock(filter_table_mutex);
 #else
-  std::lock_guard<std::mutex> lock(filter_list_mutex);
+  std::lock_guard<std::mutex> lock(filter_table_mutex);
 #endif
-  auto& filters = filter_list[acl_handle];
-  uint16_t l2c_channel =
-      (packet[L2C_CHANNEL_OFFSET + 1] << 8) + packet[L2C_CHANNEL_OFFSET];
-  if (filters.isRfcChannel(is_received, l2c_channel)) {
-    uint8_t rfc_event = packet[RFC_EVENT_OFFSET] & 0b11101111;
-    if (rfc_event == RFCOMM_SABME || rfc_event == RFCOMM_UA) {
-      return false;
-    }
-
-    uint8_t rfc_dlci = packet[RFC_CHANNEL_OFFSET] >> 2;
-    if (!filters.isWhitelistedDlci(rfc_dlci)) {
-      return true;
-    }
-  } else if (!filters.isWhitelistedL2c(is_received, l2c_channel)) {
-    return true;
-  }
-
-  return false;
+  return filter_table.ShouldTruncate(packet, is_received);
 }
 
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
@@ -1113,15 +880,3 @@ void update_snoop_fd(int snoop_fd) {
   sock_snoop_active = true;
   logfile_fd = snoop_fd;
 }
-
-static bool is_avdt_media_packet(const uint8_t *p, bool is_received) {
-  uint16_t cid, handle;
-  bool is_local_cid = is_received;
-  /*is_received signifies Rx packet so packet will have local_cid at offset 6
-   * Tx packet with is_received as false and have remote_cid at the offset*/
-
-  handle = (uint16_t)((p[0] + (p[1] << 8)) & 0x0FFF);
-  cid =  (uint16_t)(p[6] + (p[7] << 8));
-
-  return L2CA_isMediaChannel(handle, cid, is_local_cid);
-}
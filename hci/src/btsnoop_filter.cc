@@ -0,0 +1,350 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "hci/include/btsnoop_filter.h"
+
+#include <string.h>
+
+#include "stack/include/l2cdefs.h"
+#include "stack/include/rfcdefs.h"
+
+#define HANDLE_MASK 0x0FFF
+#define CONTINUATION_PACKET_BOUNDARY 1
+#define GET_BOUNDARY_FLAG(handle) (((handle) >> 12) & 0x0003)
+
+// Offsets into an ACL packet, ACL header included.
+static const uint32_t L2C_CHANNEL_OFFSET = 6;
+static const uint32_t L2C_PAYLOAD_OFFSET = 8;
+static const uint32_t RFC_CHANNEL_OFFSET = 8;
+static const uint32_t RFC_EVENT_OFFSET = 9;
+
+// ACL handle reserved for vendor specific debug data, never filtered.
+static const uint16_t VENDOR_DEBUG_HANDLE = 0x0edc;
+
+static const uint64_t DEFAULT_DLCI_MASK = 1;  // the RFCOMM multiplexer control
+static const size_t INITIAL_CHANNELS = 32;
+static const size_t INITIAL_LINKS = 8;
+
+template <typename T>
+BtsnoopFilterTable::FlatTable<T>::FlatTable(size_t capacity)
+    : slots_(capacity), mask_(capacity - 1), shift_(32), size_(0) {
+  for (size_t bits = capacity; bits > 1; bits >>= 1) shift_--;
+  for (auto& slot : slots_) slot.key = kEmptyKey;
+}
+
+template <typename T>
+size_t BtsnoopFilterTable::FlatTable<T>::Index(uint32_t key) const {
+  // Fibonacci hashing; neighbouring CIDs of a link spread over the table
+  return (size_t)((key * 0x9E3779B9u) >> shift_) & mask_;
+}
+
+template <typename T>
+T* BtsnoopFilterTable::FlatTable<T>::Find(uint32_t key) {
+  for (size_t i = Index(key);; i = (i + 1) & mask_) {
+    if (slots_[i].key == key) return &slots_[i].value;
+    if (slots_[i].key == kEmptyKey) return nullptr;
+  }
+}
+
+template <typename T>
+const T* BtsnoopFilterTable::FlatTable<T>::Find(uint32_t key) const {
+  return const_cast<FlatTable<T>*>(this)->Find(key);
+}
+
+template <typename T>
+T* BtsnoopFilterTable::FlatTable<T>::FindOrInsert(uint32_t key,
+                                                  const T& initial) {
+  T* value = Find(key);
+  if (value != nullptr) return value;
+
+  // Keep the load factor at or below one half so probe runs stay short
+  if ((size_ + 1) * 2 > slots_.size()) Grow();
+
+  size_t i = Index(key);
+  while (slots_[i].key != kEmptyKey) i = (i + 1) & mask_;
+  slots_[i].key = key;
+  slots_[i].value = initial;
+  size_++;
+  return &slots_[i].value;
+}
+
+template <typename T>
+void BtsnoopFilterTable::FlatTable<T>::Erase(uint32_t key) {
+  size_t i = Index(key);
+  while (slots_[i].key != key) {
+    if (slots_[i].key == kEmptyKey) return;
+    i = (i + 1) & mask_;
+  }
+
+  // Shift the rest of the probe run back so lookups need no tombstones
+  for (size_t j = (i + 1) & mask_; slots_[j].key != kEmptyKey;
+       j = (j + 1) & mask_) {
+    size_t home = Index(slots_[j].key);
+    bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+    if (movable) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i].key = kEmptyKey;
+  size_--;
+}
+
+template <typename T>
+void BtsnoopFilterTable::FlatTable<T>::Clear() {
+  for (auto& slot : slots_) slot.key = kEmptyKey;
+  size_ = 0;
+}
+
+template <typename T>
+void BtsnoopFilterTable::FlatTable<T>::Grow() {
+  std::vector<Slot> old_slots;
+  old_slots.swap(slots_);
+  slots_.resize(old_slots.size() * 2);
+  for (auto& slot : slots_) slot.key = kEmptyKey;
+  mask_ = slots_.size() - 1;
+  shift_--;
+  size_ = 0;
+  for (const auto& slot : old_slots)
+    if (slot.key != kEmptyKey) FindOrInsert(slot.key, slot.value);
+}
+
+BtsnoopFilterTable::BtsnoopFilterTable()
+    : channels_(INITIAL_CHANNELS), links_(INITIAL_LINKS) {}
+
+BtsnoopFilterTable::Channel* BtsnoopFilterTable::GetChannel(uint16_t handle,
+                                                            bool local,
+                                                            uint16_t cid) {
+  static const Channel initial = {0, -1};
+  return channels_.FindOrInsert(ChannelKey(handle, local, cid), initial);
+}
+
+BtsnoopFilterTable::Link* BtsnoopFilterTable::GetLink(uint16_t handle) {
+  Link* link = links_.Find(handle & HANDLE_MASK);
+  if (link != nullptr) return link;
+
+  Link initial;
+  initial.rfcomm_lcid = 0;
+  initial.rfcomm_rcid = 0;
+  initial.last_cid = 0;
+  ResetRfcomm(&initial);
+  return links_.FindOrInsert(handle & HANDLE_MASK, initial);
+}
+
+void BtsnoopFilterTable::ResetRfcomm(Link* link) {
+  link->dlci_mask = DEFAULT_DLCI_MASK;
+  link->scn_flow_mask = 0;
+  memset(link->scn_profile, -1, sizeof(link->scn_profile));
+}
+
+void BtsnoopFilterTable::ReleaseChannel(uint16_t handle, bool local,
+                                        uint16_t cid) {
+  uint32_t key = ChannelKey(handle, local, cid);
+  const Channel* channel = channels_.Find(key);
+  if (channel != nullptr && channel->flags == 0 && channel->profile < 0)
+    channels_.Erase(key);
+}
+
+void BtsnoopFilterTable::SetFlags(uint16_t handle, uint16_t local_cid,
+                                  uint16_t remote_cid, uint8_t flags,
+                                  bool set) {
+  if (set) {
+    GetChannel(handle, true, local_cid)->flags |= flags;
+    GetChannel(handle, false, remote_cid)->flags |= flags;
+    return;
+  }
+
+  Channel* channel = channels_.Find(ChannelKey(handle, true, local_cid));
+  if (channel != nullptr) channel->flags &= ~flags;
+  channel = channels_.Find(ChannelKey(handle, false, remote_cid));
+  if (channel != nullptr) channel->flags &= ~flags;
+  ReleaseChannel(handle, true, local_cid);
+  ReleaseChannel(handle, false, remote_cid);
+}
+
+void BtsnoopFilterTable::WhitelistChannel(uint16_t handle, uint16_t local_cid,
+                                          uint16_t remote_cid) {
+  SetFlags(handle, local_cid, remote_cid, kWhitelisted, true);
+}
+
+void BtsnoopFilterTable::WhitelistDlci(uint16_t handle, uint8_t dlci) {
+  GetLink(handle)->dlci_mask |= (uint64_t)1 << (dlci & 0x3F);
+}
+
+void BtsnoopFilterTable::SetRfcommChannel(uint16_t handle, uint16_t local_cid,
+                                          uint16_t remote_cid) {
+  Link* link = GetLink(handle);
+  if (link->rfcomm_lcid == local_cid && link->rfcomm_rcid == remote_cid)
+    return;
+
+  if (link->rfcomm_lcid != 0 || link->rfcomm_rcid != 0) {
+    SetFlags(handle, link->rfcomm_lcid, link->rfcomm_rcid, kRfcomm, false);
+    ResetRfcomm(link);
+  }
+  link->rfcomm_lcid = local_cid;
+  link->rfcomm_rcid = remote_cid;
+  SetFlags(handle, local_cid, remote_cid, kRfcomm, true);
+}
+
+void BtsnoopFilterTable::SetMediaChannel(uint16_t handle, uint16_t local_cid,
+                                         uint16_t remote_cid, bool media) {
+  SetFlags(handle, local_cid, remote_cid, kMedia, media);
+}
+
+void BtsnoopFilterTable::SetL2capProfile(uint16_t handle, uint16_t local_cid,
+                                         uint16_t remote_cid, int8_t profile,
+                                         bool flow_ext) {
+  GetLink(handle);
+  uint8_t flags = kProfileL2cap | (flow_ext ? kFlowExt : 0);
+  Channel* channel = GetChannel(handle, true, local_cid);
+  channel->flags = (channel->flags & ~kFlowExt) | flags;
+  channel->profile = profile;
+  channel = GetChannel(handle, false, remote_cid);
+  channel->flags = (channel->flags & ~kFlowExt) | flags;
+  channel->profile = profile;
+}
+
+void BtsnoopFilterTable::SetRfcommProfile(uint16_t handle, int8_t profile,
+                                          uint8_t scn, bool flow_ext) {
+  if (scn == 0 || scn >= 32) return;
+
+  // A profile has one server channel at a time
+  Link* link = GetLink(handle);
+  for (int i = 0; i < 32; i++) {
+    if (link->scn_profile[i] == profile) link->scn_profile[i] = -1;
+  }
+  link->scn_profile[scn] = profile;
+  if (flow_ext)
+    link->scn_flow_mask |= (uint32_t)1 << scn;
+  else
+    link->scn_flow_mask &= ~((uint32_t)1 << scn);
+}
+
+void BtsnoopFilterTable::ClearRfcommProfile(uint16_t handle, uint8_t scn) {
+  if (scn == 0 || scn >= 32) return;
+
+  Link* link = links_.Find(handle & HANDLE_MASK);
+  if (link == nullptr) return;
+  link->scn_profile[scn] = -1;
+  link->scn_flow_mask &= ~((uint32_t)1 << scn);
+}
+
+void BtsnoopFilterTable::RemoveChannel(uint16_t handle, uint16_t local_cid,
+                                       uint16_t remote_cid) {
+  Link* link = links_.Find(handle & HANDLE_MASK);
+  if (link != nullptr && link->rfcomm_lcid == local_cid) {
+    SetFlags(handle, link->rfcomm_lcid, link->rfcomm_rcid, kRfcomm, false);
+    link->rfcomm_lcid = 0;
+    link->rfcomm_rcid = 0;
+    ResetRfcomm(link);
+  }
+
+  channels_.Erase(ChannelKey(handle, true, local_cid));
+  channels_.Erase(ChannelKey(handle, false, remote_cid));
+}
+
+uint8_t BtsnoopFilterTable::GetFlags(uint16_t handle, bool local,
+                                     uint16_t cid) const {
+  const Channel* channel = channels_.Find(ChannelKey(handle, local, cid));
+  return channel != nullptr ? channel->flags : 0;
+}
+
+bool BtsnoopFilterTable::ShouldTruncate(const uint8_t* packet,
+                                        bool is_received) const {
+  uint16_t handle = (packet[0] | (packet[1] << 8)) & HANDLE_MASK;
+  uint16_t cid =
+      packet[L2C_CHANNEL_OFFSET] | (packet[L2C_CHANNEL_OFFSET + 1] << 8);
+  if (cid == L2CAP_SIGNALLING_CID) return false;
+
+  uint8_t flags = GetFlags(handle, is_received, cid);
+  if (flags & kRfcomm) {
+    uint8_t rfc_event = packet[RFC_EVENT_OFFSET] & 0xEF;
+    if (rfc_event == RFCOMM_SABME || rfc_event == RFCOMM_UA) return false;
+
+    const Link* link = links_.Find(handle);
+    uint64_t dlci_mask = link != nullptr ? link->dlci_mask : DEFAULT_DLCI_MASK;
+    return !((dlci_mask >> (packet[RFC_CHANNEL_OFFSET] >> 2)) & 1);
+  }
+  return !(flags & kWhitelisted);
+}
+
+bool BtsnoopFilterTable::IsMediaPacket(const uint8_t* packet,
+                                       bool is_received) const {
+  uint16_t handle = (packet[0] | (packet[1] << 8)) & HANDLE_MASK;
+  uint16_t cid =
+      packet[L2C_CHANNEL_OFFSET] | (packet[L2C_CHANNEL_OFFSET + 1] << 8);
+  return (GetFlags(handle, is_received, cid) & kMedia) != 0;
+}
+
+BtsnoopFilterTable::ProfileMatch BtsnoopFilterTable::MatchProfile(
+    const uint8_t* packet, uint32_t length, bool is_received) {
+  ProfileMatch match = {-1, false, false, 0};
+  if (length < L2C_PAYLOAD_OFFSET) return match;
+
+  uint16_t handle = packet[0] | (packet[1] << 8);
+  bool fragment = GET_BOUNDARY_FLAG(handle) == CONTINUATION_PACKET_BOUNDARY;
+  handle &= HANDLE_MASK;
+
+  // Only links with a profile channel are tracked
+  Link* link = links_.Find(handle);
+  if (link == nullptr || handle == VENDOR_DEBUG_HANDLE) return match;
+
+  uint16_t cid;
+  if (fragment) {
+    cid = link->last_cid;
+  } else {
+    cid = packet[L2C_CHANNEL_OFFSET] | (packet[L2C_CHANNEL_OFFSET + 1] << 8);
+    link->last_cid = cid;
+  }
+  if (cid == L2CAP_SIGNALLING_CID) return match;
+
+  const Channel* channel = channels_.Find(ChannelKey(handle, is_received, cid));
+  if (channel == nullptr) return match;
+
+  if (channel->flags & kProfileL2cap) {
+    uint32_t offset = L2C_PAYLOAD_OFFSET;
+    if (!fragment && (channel->flags & kFlowExt)) {
+      if (length < offset + 2) return match;
+      uint16_t control = packet[offset] | (packet[offset + 1] << 8);
+      offset += 2;
+      // The SDU length follows the control field of a start I-frame
+      if (!(control & 1) && ((control >> 14) & 0x3) == 0x01) offset += 2;
+    }
+    match.profile = channel->profile;
+    match.fragment = fragment;
+    match.payload_offset = offset;
+    return match;
+  }
+
+  if (fragment || !(channel->flags & kRfcomm)) return match;
+
+  uint32_t offset = L2C_PAYLOAD_OFFSET;
+  if (length < offset + 3) return match;
+  uint8_t dlci = packet[offset] >> 2;
+  uint8_t control = packet[offset + 1];
+  if ((control & 0xEF) != RFCOMM_UIH) return match;
+
+  uint8_t scn = dlci >> 1;
+  int8_t profile = link->scn_profile[scn];
+  if (profile < 0) return match;
+
+  // Length indicator, one byte or two if the EA bit is clear
+  offset += 2;
+  if (!(packet[offset++] & 1)) offset++;
+  // A credit byte follows when the P/F bit is set with credit flow control
+  if ((control & 0x10) && ((link->scn_flow_mask >> scn) & 1)) offset++;
+  if (offset > length) return match;
+
+  match.profile = profile;
+  match.rfcomm = true;
+  match.payload_offset = offset;
+  return match;
+}
+
+void BtsnoopFilterTable::Clear() {
+  channels_.Clear();
+  links_.Clear();
+}
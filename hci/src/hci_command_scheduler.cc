@@ -0,0 +1,327 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "hci/include/hci_command_scheduler.h"
+
+#include <string.h>
+
+#include "stack/include/hcidefs.h"
+
+// Controller state commands change or depend on.
+enum : uint8_t {
+  LE_ADDRESS = 1 << 0,  // random address
+  LE_RESOLVING_LIST = 1 << 1,
+  LE_ACCEPT_LIST = 1 << 2,
+  LE_SCAN_PARAMS = 1 << 3,  // scan parameters and vendor scan filters
+  LE_SCANNING = 1 << 4,
+  LE_INITIATING = 1 << 5,
+  LE_ADVERTISING = 1 << 6,
+};
+
+struct command_ordering_t {
+  uint8_t changes;
+  uint8_t uses;  // state the command must not see change under it
+  bool barrier;  // never reordered with any command
+};
+
+static bool is_vendor_specific(uint16_t opcode) {
+  return (opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC;
+}
+
+static command_ordering_t get_ordering(uint16_t opcode) {
+  switch (opcode) {
+    case HCI_RESET:
+      return {0, 0, true};
+
+    case HCI_BLE_WRITE_RANDOM_ADDR:
+      return {LE_ADDRESS, LE_SCANNING | LE_INITIATING | LE_ADVERTISING,
+              false};
+
+    case HCI_BLE_ADD_DEV_RESOLVING_LIST:
+    case HCI_BLE_RM_DEV_RESOLVING_LIST:
+    case HCI_BLE_CLEAR_RESOLVING_LIST:
+    case HCI_BLE_SET_ADDR_RESOLUTION_ENABLE:
+    case HCI_BLE_SET_RAND_PRIV_ADDR_TIMOUT:
+    case HCI_BLE_SET_PRIVACY_MODE:
+      return {LE_RESOLVING_LIST,
+              LE_SCANNING | LE_INITIATING | LE_ADVERTISING, false};
+
+    case HCI_BLE_CLEAR_WHITE_LIST:
+    case HCI_BLE_ADD_WHITE_LIST:
+    case HCI_BLE_REMOVE_WHITE_LIST:
+      return {LE_ACCEPT_LIST, LE_INITIATING, false};
+
+    case HCI_BLE_WRITE_SCAN_PARAMS:
+    case HCI_LE_SET_EXTENDED_SCAN_PARAMETERS:
+    case HCI_BLE_EXTENDED_SCAN_PARAMS_OCF:
+    case HCI_BLE_ADV_FILTER_OCF:
+    case HCI_BLE_BATCH_SCAN_OCF:
+    case HCI_BLE_TRACK_ADV_OCF:
+      return {LE_SCAN_PARAMS, LE_SCANNING, false};
+
+    case HCI_BLE_WRITE_SCAN_ENABLE:
+    case HCI_LE_SET_EXTENDED_SCAN_ENABLE:
+      return {LE_SCANNING, LE_ADDRESS | LE_RESOLVING_LIST | LE_SCAN_PARAMS,
+              false};
+
+    case HCI_BLE_CREATE_LL_CONN:
+    case HCI_LE_EXTENDED_CREATE_CONNECTION:
+      return {LE_INITIATING, LE_ADDRESS | LE_RESOLVING_LIST | LE_ACCEPT_LIST,
+              false};
+
+    case HCI_BLE_CREATE_CONN_CANCEL:
+      return {LE_INITIATING, 0, false};
+
+    case HCI_BLE_WRITE_ADV_ENABLE:
+    case HCI_LE_SET_EXT_ADVERTISING_ENABLE:
+      return {LE_ADVERTISING, LE_ADDRESS | LE_RESOLVING_LIST, false};
+
+    case HCI_BLE_ENERGY_INFO_OCF:
+      return {0, 0, false};
+  }
+
+  // Nothing is known about what other vendor specific commands do
+  if (is_vendor_specific(opcode)) return {0, 0, true};
+
+  return {0, 0, false};
+}
+
+HciCommandScheduler::HciCommandScheduler(bool prioritize, bool coalesce)
+    : prioritize_(prioritize), coalesce_(coalesce), size_(0), next_seq_(0) {
+  memset(overtaken_, 0, sizeof(overtaken_));
+  memset(stats_, 0, sizeof(stats_));
+}
+
+HciCommandScheduler::Lane HciCommandScheduler::GetLane(uint16_t opcode) {
+  switch (opcode) {
+    case HCI_CREATE_CONNECTION:
+    case HCI_DISCONNECT:
+    case HCI_CREATE_CONNECTION_CANCEL:
+    case HCI_ACCEPT_CONNECTION_REQUEST:
+    case HCI_REJECT_CONNECTION_REQUEST:
+    case HCI_LINK_KEY_REQUEST_REPLY:
+    case HCI_LINK_KEY_REQUEST_NEG_REPLY:
+    case HCI_PIN_CODE_REQUEST_REPLY:
+    case HCI_AUTHENTICATION_REQUESTED:
+    case HCI_SET_CONN_ENCRYPTION:
+    case HCI_SETUP_ESCO_CONNECTION:
+    case HCI_ACCEPT_ESCO_CONNECTION:
+    case HCI_IO_CAPABILITY_REQUEST_REPLY:
+    case HCI_USER_CONF_REQUEST_REPLY:
+    case HCI_USER_CONF_VALUE_NEG_REPLY:
+    case HCI_ENH_SETUP_ESCO_CONNECTION:
+    case HCI_ENH_ACCEPT_ESCO_CONNECTION:
+    case HCI_BLE_CREATE_LL_CONN:
+    case HCI_BLE_CREATE_CONN_CANCEL:
+    case HCI_BLE_START_ENC:
+    case HCI_BLE_LTK_REQ_REPLY:
+    case HCI_BLE_LTK_REQ_NEG_REPLY:
+    case HCI_LE_EXTENDED_CREATE_CONNECTION:
+      return kUrgent;
+
+    case HCI_WRITE_SCAN_ENABLE:
+    case HCI_BLE_WRITE_SCAN_PARAMS:
+    case HCI_BLE_WRITE_SCAN_ENABLE:
+    case HCI_BLE_CLEAR_WHITE_LIST:
+    case HCI_BLE_ADD_WHITE_LIST:
+    case HCI_BLE_REMOVE_WHITE_LIST:
+    case HCI_BLE_ADD_DEV_RESOLVING_LIST:
+    case HCI_BLE_RM_DEV_RESOLVING_LIST:
+    case HCI_BLE_CLEAR_RESOLVING_LIST:
+    case HCI_LE_SET_EXTENDED_SCAN_PARAMETERS:
+    case HCI_LE_SET_EXTENDED_SCAN_ENABLE:
+    case HCI_BLE_BATCH_SCAN_OCF:
+    case HCI_BLE_ADV_FILTER_OCF:
+    case HCI_BLE_TRACK_ADV_OCF:
+    case HCI_BLE_ENERGY_INFO_OCF:
+    case HCI_BLE_EXTENDED_SCAN_PARAMS_OCF:
+      return kBulk;
+  }
+  return kNormal;
+}
+
+const char* HciCommandScheduler::LaneName(Lane lane) {
+  switch (lane) {
+    case kUrgent:
+      return "urgent";
+    case kNormal:
+      return "normal";
+    case kBulk:
+      return "bulk";
+    default:
+      return "unknown";
+  }
+}
+
+bool HciCommandScheduler::MustKeepOrder(uint16_t earlier, uint16_t later) {
+  command_ordering_t first = get_ordering(earlier);
+  command_ordering_t second = get_ordering(later);
+  if (first.barrier || second.barrier) return true;
+  return (first.changes & (second.changes | second.uses)) ||
+         (second.changes & first.uses);
+}
+
+void HciCommandScheduler::SetCoalescable(uint16_t opcode) {
+  coalescable_.insert(opcode);
+}
+
+void* HciCommandScheduler::Enqueue(uint16_t opcode, void* entry,
+                                   uint64_t now_us) {
+  Lane lane = GetLane(opcode);
+  std::deque<Queued>& queue = lanes_[lane];
+
+  if (coalesce_ && coalescable_.count(opcode)) {
+    auto last = queue.rbegin();
+    while (last != queue.rend() && last->opcode != opcode) last++;
+
+    // Only if what was queued after it does not depend on it
+    bool replace = last != queue.rend();
+    for (int i = 0; replace && i < kNumLanes; i++) {
+      for (const Queued& queued : lanes_[i]) {
+        if (queued.seq > last->seq && MustKeepOrder(opcode, queued.opcode)) {
+          replace = false;
+          break;
+        }
+      }
+    }
+
+    if (replace) {
+      // It keeps its place, and the time its caller has been waiting
+      void* replaced = last->entry;
+      last->entry = entry;
+      stats_[lane].coalesced++;
+      return replaced;
+    }
+  }
+
+  queue.push_back(Queued{next_seq_++, now_us, opcode, entry});
+  size_++;
+  return nullptr;
+}
+
+const HciCommandScheduler::Queued* HciCommandScheduler::FindBlocker(
+    const Queued& queued) const {
+  const Queued* blocker = nullptr;
+  for (int i = 0; i < kNumLanes; i++) {
+    for (const Queued& earlier : lanes_[i]) {
+      if (earlier.seq >= queued.seq) break;
+      if (blocker && earlier.seq > blocker->seq) break;
+      if (MustKeepOrder(earlier.opcode, queued.opcode)) {
+        blocker = &earlier;
+        break;
+      }
+    }
+  }
+  return blocker;
+}
+
+const HciCommandScheduler::Queued* HciCommandScheduler::FindSendable(
+    const Queued& queued) const {
+  // The oldest command always can be sent, so this ends
+  const Queued* sendable = &queued;
+  for (const Queued* blocker = FindBlocker(*sendable); blocker;
+       blocker = FindBlocker(*sendable))
+    sendable = blocker;
+  return sendable;
+}
+
+void* HciCommandScheduler::Dequeue(uint64_t now_us) {
+  const Queued* next = nullptr;
+  if (!prioritize_) {
+    for (int i = 0; i < kNumLanes; i++) {
+      if (lanes_[i].empty()) continue;
+      if (!next || lanes_[i].front().seq < next->seq) next = &lanes_[i].front();
+    }
+  } else {
+    for (int i = 0; !next && i < kNumLanes; i++) {
+      if (!lanes_[i].empty() && overtaken_[i] >= kMaxOvertaken)
+        next = FindSendable(lanes_[i].front());
+    }
+    // A head that must wait for commands queued before it has them sent
+    // first, whatever their lane
+    for (int i = 0; !next && i < kNumLanes; i++) {
+      if (!lanes_[i].empty()) next = FindSendable(lanes_[i].front());
+    }
+  }
+  if (!next) return nullptr;
+
+  Queued sent = *next;
+  Lane lane = GetLane(sent.opcode);
+  std::deque<Queued>& queue = lanes_[lane];
+  for (auto it = queue.begin(); it != queue.end(); it++) {
+    if (it->seq == sent.seq) {
+      if (it == queue.begin()) overtaken_[lane] = 0;
+      queue.erase(it);
+      break;
+    }
+  }
+  size_--;
+
+  for (int i = 0; i < kNumLanes; i++) {
+    if (lanes_[i].empty() || lanes_[i].front().seq > sent.seq) continue;
+    overtaken_[i]++;
+    stats_[i].overtaken++;
+  }
+
+  LaneStats& stats = stats_[lane];
+  uint64_t wait_us = now_us > sent.enqueued_us ? now_us - sent.enqueued_us : 0;
+  stats.sent++;
+  stats.total_wait_us += wait_us;
+  if (wait_us > stats.max_wait_us) stats.max_wait_us = wait_us;
+
+  return sent.entry;
+}
+
+void HciPendingCommands::Add(uint16_t opcode, void* entry) {
+  uint64_t seq = next_seq_++;
+  sent_[seq] = Sent{opcode, entry};
+  by_opcode_[opcode].push_back(seq);
+}
+
+void* HciPendingCommands::Take(uint16_t opcode) {
+  auto same_opcode = by_opcode_.find(opcode);
+  if (same_opcode != by_opcode_.end())
+    return Remove(same_opcode->second.front());
+
+  if (!is_vendor_specific(opcode) && opcode != 0) return nullptr;
+  for (const auto& sent : sent_) {
+    if (is_vendor_specific(sent.second.opcode)) return Remove(sent.first);
+  }
+  return nullptr;
+}
+
+void* HciPendingCommands::Remove(uint64_t seq) {
+  auto sent = sent_.find(seq);
+  void* entry = sent->second.entry;
+
+  auto same_opcode = by_opcode_.find(sent->second.opcode);
+  std::deque<uint64_t>& seqs = same_opcode->second;
+  for (auto it = seqs.begin(); it != seqs.end(); it++) {
+    if (*it == seq) {
+      seqs.erase(it);
+      break;
+    }
+  }
+  if (seqs.empty()) by_opcode_.erase(same_opcode);
+
+  sent_.erase(sent);
+  return entry;
+}
+
+void* HciPendingCommands::Front() const {
+  return sent_.empty() ? nullptr : sent_.begin()->second.entry;
+}
+
+std::vector<void*> HciPendingCommands::Entries() const {
+  std::vector<void*> entries;
+  for (const auto& sent : sent_) entries.push_back(sent.second.entry);
+  return entries;
+}
+
+void HciPendingCommands::Clear() {
+  sent_.clear();
+  by_opcode_.clear();
+}
@@ -27,23 +27,26 @@
 #include <base/threading/thread.h>
 
 #include <signal.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <chrono>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include "btcore/include/module.h"
 #include "btsnoop.h"
 #include "buffer_allocator.h"
+#include "hci_command_scheduler.h"
 #include "hci_inject.h"
 #include "hci_internals.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "bt_utils.h"
 #include "osi/include/alarm.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/properties.h"
 #include "osi/include/reactor.h"
@@ -61,7 +64,7 @@ extern void hci_log_firmware_debug_packet(int fd, BT_HDR* packet);
 
 static int hci_firmware_log_fd = INVALID_FD;
 
-typedef struct {
+typedef struct waiting_command_t {
   uint16_t opcode;
   future_t* complete_future;
   command_complete_cb complete_callback;
@@ -69,6 +72,9 @@ typedef struct {
   void* context;
   BT_HDR* command;
   std::chrono::time_point<std::chrono::steady_clock> timestamp;
+  // Unsent command with the same opcode this one replaced, answered with the
+  // response to this one
+  struct waiting_command_t* superseded;
 } waiting_command_t;
 
 // Using a define here, because it can be stringified for the property lookup
@@ -117,11 +123,18 @@ static alarm_t *hci_timeout_abort_timer;
 // Outbound-related
 static int command_credits = 1;
 static std::mutex command_credits_mutex;
-static std::queue<base::Closure> command_queue;
+static std::unique_ptr<HciCommandScheduler> command_queue;
+
+// Idempotent commands where only the last one queued matters
+static const uint16_t coalescable_commands[] = {
+    HCI_WRITE_SCAN_ENABLE,           HCI_BLE_WRITE_SCAN_PARAMS,
+    HCI_BLE_WRITE_SCAN_ENABLE,       HCI_LE_SET_EXTENDED_SCAN_PARAMETERS,
+    HCI_LE_SET_EXTENDED_SCAN_ENABLE,
+};
 
 // Inbound-related
 static alarm_t* command_response_timer;
-static list_t* commands_pending_response;
+static HciPendingCommands commands_pending_response;
 static std::recursive_mutex commands_pending_response_mutex;
 
 static std::mutex monitor_cmd_stats;
@@ -147,7 +160,10 @@ static void event_finish_startup(void* context);
 static void startup_timer_expired(void* context);
 
 static void enqueue_command(waiting_command_t* wait_entry);
+static void send_queued_commands();
 static void event_command_ready(waiting_command_t* wait_entry);
+static void complete_superseded_commands(waiting_command_t* wait_entry,
+                                         BT_HDR* packet, uint8_t status);
 static void enqueue_packet(void* packet);
 static void event_packet_ready(void* packet);
 static void command_timed_out(void* context);
@@ -271,6 +287,21 @@ static future_t* hci_module_start_up(void) {
     startup_timeout_ms = DEFAULT_STARTUP_TIMEOUT_MS;
   }
 
+  {
+    char prioritize[PROPERTY_VALUE_MAX] = "true";
+    char coalesce[PROPERTY_VALUE_MAX] = "true";
+    osi_property_get("persist.vendor.btstack.enable.hci_cmd_priority",
+                     prioritize, "true");
+    osi_property_get("persist.vendor.btstack.enable.hci_cmd_coalescing",
+                     coalesce, "true");
+
+    std::lock_guard<std::mutex> lock(command_credits_mutex);
+    command_queue.reset(new HciCommandScheduler(!strcmp(prioritize, "true"),
+                                                !strcmp(coalesce, "true")));
+    for (uint16_t opcode : coalescable_commands)
+      command_queue->SetCoalescable(opcode);
+  }
+
   startup_timer = alarm_new("hci.startup_timer");
   if (!startup_timer) {
     LOG_ERROR(LOG_TAG, "%s unable to create startup timer.", __func__);
@@ -292,14 +323,6 @@ static future_t* hci_module_start_up(void) {
     LOG_ERROR(LOG_TAG, "%s unable to make thread RT.", __func__);
   }
 
-  commands_pending_response = list_new(NULL);
-  if (!commands_pending_response) {
-    LOG_ERROR(LOG_TAG,
-              "%s unable to create list for commands pending response.",
-              __func__);
-    goto error;
-  }
-
   // Make sure we run in a bounded amount of time
   future_t* local_startup_future;
   local_startup_future = future_new();
@@ -347,8 +370,7 @@ static future_t* hci_module_shut_down() {
 
   {
     std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-    list_free(commands_pending_response);
-    commands_pending_response = NULL;
+    commands_pending_response.Clear();
   }
 
   packet_fragmenter->cleanup();
@@ -468,22 +490,42 @@ static void startup_timer_expired(UNUSED_ATTR void* context) {
 }
 
 // Command/packet transmitting functions
-static void enqueue_command(waiting_command_t* wait_entry) {
-  base::Closure callback = base::Bind(&event_command_ready, wait_entry);
+static uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
+static void enqueue_command(waiting_command_t* wait_entry) {
   std::lock_guard<std::mutex> command_credits_lock(command_credits_mutex);
-  if (command_credits > 0) {
-    std::lock_guard<std::mutex> message_loop_lock(message_loop_mutex);
-    if (message_loop_ == nullptr) {
-      // HCI Layer was shut down
-      buffer_allocator->free(wait_entry->command);
-      osi_free(wait_entry);
-      return;
-    }
-    message_loop_->task_runner()->PostTask(FROM_HERE, std::move(callback));
+  std::lock_guard<std::mutex> message_loop_lock(message_loop_mutex);
+  if (message_loop_ == nullptr || !command_queue) {
+    // HCI Layer was shut down
+    buffer_allocator->free(wait_entry->command);
+    osi_free(wait_entry);
+    return;
+  }
+
+  wait_entry->superseded = reinterpret_cast<waiting_command_t*>(
+      command_queue->Enqueue(wait_entry->opcode, wait_entry, now_us()));
+  if (wait_entry->superseded) {
+    LOG_DEBUG(LOG_TAG, "%s opcode 0x%04x replaces the one queued", __func__,
+              wait_entry->opcode);
+  }
+
+  send_queued_commands();
+}
+
+// Sends queued commands while there are credits for them. Must be called with
+// command_credits_mutex and message_loop_mutex held.
+static void send_queued_commands() {
+  uint64_t now = now_us();
+  while (command_credits > 0 && !command_queue->Empty()) {
+    waiting_command_t* wait_entry =
+        reinterpret_cast<waiting_command_t*>(command_queue->Dequeue(now));
+    message_loop_->task_runner()->PostTask(
+        FROM_HERE, base::Bind(&event_command_ready, wait_entry));
     command_credits--;
-  } else {
-    command_queue.push(std::move(callback));
   }
 }
 
@@ -492,7 +534,7 @@ static void event_command_ready(waiting_command_t* wait_entry) {
     /// Move it to the list of commands awaiting response
     std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
     wait_entry->timestamp = std::chrono::steady_clock::now();
-    list_append(commands_pending_response, wait_entry);
+    commands_pending_response.Add(wait_entry->opcode, wait_entry);
   }
   // Send it off
   packet_fragmenter->fragment_and_dispatch(wait_entry->command);
@@ -589,7 +631,7 @@ static void command_timed_out(void* original_wait_entry) {
               (unsigned long long)new_timeout);
       cmd_stats.lapsed_timeout += new_timeout;
       alarm_set(command_response_timer, new_timeout, command_timed_out,
-                list_front(commands_pending_response));
+                commands_pending_response.Front());
       return;
     } else {
       if (cmd_stats.lapsed_timeout >= MAX_CMD_TIMEOUT)
@@ -600,10 +642,8 @@ static void command_timed_out(void* original_wait_entry) {
   LOG_ERROR(LOG_TAG, "%s: %d commands pending response", __func__,
             get_num_waiting_commands());
 
-  for (const list_node_t* node = list_begin(commands_pending_response);
-       node != list_end(commands_pending_response); node = list_next(node)) {
-    waiting_command_t* wait_entry =
-        reinterpret_cast<waiting_command_t*>(list_node(node));
+  for (void* entry : commands_pending_response.Entries()) {
+    waiting_command_t* wait_entry = reinterpret_cast<waiting_command_t*>(entry);
 
     int wait_time_ms =
         std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -682,12 +722,7 @@ void process_command_credits(int credits) {
   // Subtract commands in flight.
   command_credits = credits - get_num_waiting_commands();
 
-  while (command_credits > 0 && command_queue.size() > 0) {
-    message_loop_->task_runner()->PostTask(FROM_HERE,
-                                           std::move(command_queue.front()));
-    command_queue.pop();
-    command_credits--;
-  }
+  if (command_queue) send_queued_commands();
 }
 
 // Returns true if the event was intercepted and should not proceed to
@@ -719,6 +754,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
       }
     } else {
       update_command_response_timer();
+      complete_superseded_commands(wait_entry, packet, 0);
       if (wait_entry->complete_callback) {
         wait_entry->complete_callback(packet, wait_entry->context);
       } else if (wait_entry->complete_future) {
@@ -751,6 +787,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
           __func__, opcode);
     } else {
       update_command_response_timer();
+      complete_superseded_commands(wait_entry, packet, status);
       if (wait_entry->status_callback)
         wait_entry->status_callback(status, wait_entry->command,
                                     wait_entry->context);
@@ -800,56 +837,57 @@ static void dispatch_reassembled(BT_HDR* packet) {
   send_data_upwards.Run(FROM_HERE, packet);
 }
 
-// Misc internal functions
-
-static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
-  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-
-  for (const list_node_t* node = list_begin(commands_pending_response);
-       node != list_end(commands_pending_response); node = list_next(node)) {
-    waiting_command_t* wait_entry =
-        reinterpret_cast<waiting_command_t*>(list_node(node));
-
-    if (!wait_entry || wait_entry->opcode != opcode) continue;
-
-    list_remove(commands_pending_response, wait_entry);
-
-    return wait_entry;
-  }
-  // look for any command complete with improper VS Opcode
-  for (const list_node_t *node = list_begin(commands_pending_response);
-      node != list_end(commands_pending_response);
-      node = list_next(node)) {
-    waiting_command_t *wait_entry =
-        reinterpret_cast<waiting_command_t*> (list_node(node));
+// Answers the commands |wait_entry| replaced in the queue, oldest first, with
+// a copy of the Command Complete |packet|, or with the Command Status |status|.
+static void complete_superseded_commands(waiting_command_t* wait_entry,
+                                         BT_HDR* packet, uint8_t status) {
+  std::vector<waiting_command_t*> superseded;
+  for (waiting_command_t* entry = wait_entry->superseded; entry;
+       entry = entry->superseded)
+    superseded.insert(superseded.begin(), entry);
+  wait_entry->superseded = NULL;
+
+  bool is_complete = packet->data[0] == HCI_COMMAND_COMPLETE_EVT;
+  size_t packet_size = BT_HDR_SIZE + packet->offset + packet->len;
+  for (waiting_command_t* entry : superseded) {
+    if (is_complete && (entry->complete_callback || entry->complete_future)) {
+      BT_HDR* copy = static_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
+      memcpy(copy, packet, packet_size);
+      if (entry->complete_callback) {
+        entry->complete_callback(copy, entry->context);
+      } else {
+        future_ready(entry->complete_future, copy);
+      }
+    }
 
-    if (wait_entry && (wait_entry->opcode != opcode) &&
-        (((wait_entry->opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) &&
-         (((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) ||
-            opcode == 0))) {
-      LOG_DEBUG(LOG_TAG,"%s Treat it as valid, wait_entry opcode 0x%x opcode 0x%x",
-                __func__, wait_entry->opcode, opcode);
+    // Same ownership of the command as for the command answered
+    if (!is_complete && entry->status_callback) {
+      entry->status_callback(status, entry->command, entry->context);
     } else {
-      continue;
+      buffer_allocator->free(entry->command);
     }
+    osi_free(entry);
+  }
+}
 
-    list_remove(commands_pending_response, wait_entry);
+// Misc internal functions
 
-    return wait_entry;
-  }
-  return NULL;
+static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
+  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
+  return reinterpret_cast<waiting_command_t*>(
+      commands_pending_response.Take(opcode));
 }
 
 static int get_num_waiting_commands() {
   std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-  return list_length(commands_pending_response);
+  return commands_pending_response.Size();
 }
 
 static void update_command_response_timer(void) {
   std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
 
   if (command_response_timer == NULL) return;
-  if (list_is_empty(commands_pending_response)) {
+  if (commands_pending_response.Empty()) {
     if (alarm_is_scheduled(command_response_timer)) {
       alarm_cancel(command_response_timer);
     } else {
@@ -863,7 +901,7 @@ static void update_command_response_timer(void) {
     }
   } else {
     alarm_set(command_response_timer, COMMAND_PENDING_TIMEOUT_MS,
-              command_timed_out, list_front(commands_pending_response));
+              command_timed_out, commands_pending_response.Front());
     /* This block of code executes when command is sent out.
      * Start monitoring incoming events.
      */
@@ -876,6 +914,30 @@ static void update_command_response_timer(void) {
   }
 }
 
+void hci_layer_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(command_credits_mutex);
+  dprintf(fd, "\nHCI Command Queue:\n");
+  if (!command_queue) {
+    dprintf(fd, "  None\n");
+    return;
+  }
+
+  dprintf(fd, "  Credits: %d, queued: %zu\n", command_credits,
+          command_queue->Size());
+  for (int i = 0; i < HciCommandScheduler::kNumLanes; i++) {
+    HciCommandScheduler::Lane lane = (HciCommandScheduler::Lane)i;
+    const HciCommandScheduler::LaneStats& stats = command_queue->GetStats(lane);
+    dprintf(fd,
+            "  %-6s: sent %zu, queued %zu, coalesced %zu, overtaken %zu, "
+            "wait avg/max %llu/%llu us\n",
+            HciCommandScheduler::LaneName(lane), stats.sent,
+            command_queue->Size(lane), stats.coalesced, stats.overtaken,
+            (unsigned long long)(stats.sent ? stats.total_wait_us / stats.sent
+                                            : 0),
+            (unsigned long long)stats.max_wait_us);
+  }
+}
+
 static void init_layer_interface() {
   if (!interface_created) {
     // It's probably ok for this to live forever. It's small and
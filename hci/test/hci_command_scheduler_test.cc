@@ -0,0 +1,410 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "hci/include/hci_command_scheduler.h"
+#include "stack/include/hcidefs.h"
+
+namespace {
+
+// A vendor specific command the scheduler knows nothing about.
+const uint16_t kUnknownVendorCommand = 0x0123 | HCI_GRP_VENDOR_SPECIFIC;
+
+struct Command {
+  uint16_t opcode;
+  uint32_t arg;  // scan enable, accept list or connection target
+  uint64_t enqueued_us;
+  HciCommandScheduler::Lane lane;
+};
+
+class HciCommandSchedulerTest : public ::testing::Test {
+ protected:
+  HciCommandSchedulerTest() : scheduler_(true, true) {
+    scheduler_.SetCoalescable(HCI_BLE_WRITE_SCAN_PARAMS);
+    scheduler_.SetCoalescable(HCI_BLE_WRITE_SCAN_ENABLE);
+  }
+
+  Command* Enqueue(uint16_t opcode, uint32_t arg = 0) {
+    commands_.push_back(
+        Command{opcode, arg, 0, HciCommandScheduler::GetLane(opcode)});
+    Command* command = &commands_.back();
+    replaced_ = static_cast<Command*>(scheduler_.Enqueue(opcode, command, 0));
+    return command;
+  }
+
+  // Opcodes in the order they are sent.
+  std::vector<uint16_t> DequeueAll() {
+    std::vector<uint16_t> opcodes;
+    while (!scheduler_.Empty()) {
+      Command* command = static_cast<Command*>(scheduler_.Dequeue(0));
+      opcodes.push_back(command->opcode);
+    }
+    return opcodes;
+  }
+
+  HciCommandScheduler scheduler_;
+  std::deque<Command> commands_;
+  Command* replaced_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(HciCommandSchedulerTest, lanes_by_priority) {
+  Enqueue(HCI_BLE_WRITE_SCAN_PARAMS);
+  Enqueue(HCI_READ_RSSI);
+  Enqueue(HCI_BLE_START_ENC);
+  Enqueue(HCI_BLE_ADD_WHITE_LIST);
+  Enqueue(HCI_DISCONNECT);
+  Enqueue(HCI_READ_TRANSMIT_POWER_LEVEL);
+
+  EXPECT_EQ(scheduler_.Size(), 6u);
+  EXPECT_EQ(scheduler_.Size(HciCommandScheduler::kUrgent), 2u);
+  EXPECT_EQ(DequeueAll(),
+            std::vector<uint16_t>({HCI_BLE_START_ENC, HCI_DISCONNECT,
+                                   HCI_READ_RSSI, HCI_READ_TRANSMIT_POWER_LEVEL,
+                                   HCI_BLE_WRITE_SCAN_PARAMS,
+                                   HCI_BLE_ADD_WHITE_LIST}));
+  EXPECT_EQ(scheduler_.Dequeue(0), nullptr);
+
+  EXPECT_EQ(scheduler_.GetStats(HciCommandScheduler::kBulk).sent, 2u);
+  EXPECT_EQ(scheduler_.GetStats(HciCommandScheduler::kBulk).overtaken, 4u);
+  EXPECT_EQ(scheduler_.GetStats(HciCommandScheduler::kUrgent).overtaken, 0u);
+}
+
+TEST_F(HciCommandSchedulerTest, fifo_unless_prioritized) {
+  HciCommandScheduler fifo(false, false);
+  Command scan{HCI_BLE_WRITE_SCAN_PARAMS, 0, 0, HciCommandScheduler::kBulk};
+  Command disconnect{HCI_DISCONNECT, 0, 0, HciCommandScheduler::kUrgent};
+  fifo.Enqueue(scan.opcode, &scan, 0);
+  fifo.Enqueue(disconnect.opcode, &disconnect, 100);
+
+  EXPECT_EQ(fifo.Dequeue(1000), &scan);
+  EXPECT_EQ(fifo.Dequeue(1500), &disconnect);
+  EXPECT_EQ(fifo.GetStats(HciCommandScheduler::kBulk).max_wait_us, 1000u);
+  EXPECT_EQ(fifo.GetStats(HciCommandScheduler::kUrgent).total_wait_us, 1400u);
+}
+
+TEST_F(HciCommandSchedulerTest, dependent_commands_keep_their_order) {
+  // The connection target must be in the accept list
+  Enqueue(HCI_BLE_ADD_WHITE_LIST);
+  Enqueue(HCI_BLE_WRITE_SCAN_PARAMS);
+  Enqueue(HCI_BLE_CREATE_LL_CONN);
+  EXPECT_EQ(DequeueAll(),
+            std::vector<uint16_t>({HCI_BLE_ADD_WHITE_LIST,
+                                   HCI_BLE_CREATE_LL_CONN,
+                                   HCI_BLE_WRITE_SCAN_PARAMS}));
+
+  // The random address is only set while scanning is disabled
+  Enqueue(HCI_BLE_WRITE_SCAN_ENABLE, 0);
+  Enqueue(HCI_BLE_WRITE_RANDOM_ADDR);
+  Enqueue(HCI_DISCONNECT);
+  EXPECT_EQ(DequeueAll(),
+            std::vector<uint16_t>({HCI_DISCONNECT, HCI_BLE_WRITE_SCAN_ENABLE,
+                                   HCI_BLE_WRITE_RANDOM_ADDR}));
+
+  // Nothing passes unknown vendor specific commands, nor HCI_Reset
+  Enqueue(HCI_BLE_WRITE_SCAN_PARAMS);
+  Enqueue(kUnknownVendorCommand);
+  Enqueue(HCI_DISCONNECT);
+  Enqueue(HCI_RESET);
+  Enqueue(HCI_BLE_START_ENC);
+  EXPECT_EQ(DequeueAll(),
+            std::vector<uint16_t>({HCI_BLE_WRITE_SCAN_PARAMS,
+                                   kUnknownVendorCommand, HCI_DISCONNECT,
+                                   HCI_RESET, HCI_BLE_START_ENC}));
+
+  EXPECT_TRUE(HciCommandScheduler::MustKeepOrder(HCI_BLE_WRITE_SCAN_ENABLE,
+                                                 HCI_BLE_WRITE_SCAN_PARAMS));
+  EXPECT_TRUE(HciCommandScheduler::MustKeepOrder(HCI_BLE_CLEAR_WHITE_LIST,
+                                                 HCI_BLE_CREATE_LL_CONN));
+  EXPECT_FALSE(HciCommandScheduler::MustKeepOrder(HCI_BLE_WRITE_SCAN_ENABLE,
+                                                  HCI_BLE_CREATE_LL_CONN));
+  EXPECT_FALSE(HciCommandScheduler::MustKeepOrder(HCI_BLE_ADD_WHITE_LIST,
+                                                  HCI_DISCONNECT));
+}
+
+TEST_F(HciCommandSchedulerTest, overtaken_head_goes_next) {
+  Enqueue(HCI_READ_RSSI);
+  for (int i = 0; i < 20; i++) Enqueue(HCI_DISCONNECT);
+
+  std::vector<uint16_t> sent = DequeueAll();
+  auto rssi = std::find(sent.begin(), sent.end(), HCI_READ_RSSI);
+  EXPECT_EQ(rssi - sent.begin(), 8);
+}
+
+TEST_F(HciCommandSchedulerTest, coalesce_unsent_commands) {
+  Command* enable = Enqueue(HCI_BLE_WRITE_SCAN_ENABLE, 1);
+  EXPECT_EQ(replaced_, nullptr);
+  Command* disable = Enqueue(HCI_BLE_WRITE_SCAN_ENABLE, 0);
+  EXPECT_EQ(replaced_, enable);
+  Command* enable_again = Enqueue(HCI_BLE_WRITE_SCAN_ENABLE, 1);
+  EXPECT_EQ(replaced_, disable);
+  EXPECT_EQ(scheduler_.Size(), 1u);
+  EXPECT_EQ(scheduler_.Dequeue(0), enable_again);
+
+  // Not over commands that depend on it
+  Command* params = Enqueue(HCI_BLE_WRITE_SCAN_PARAMS, 1);
+  Enqueue(HCI_BLE_WRITE_SCAN_ENABLE, 1);
+  Enqueue(HCI_BLE_WRITE_SCAN_ENABLE, 0);
+  EXPECT_NE(replaced_, nullptr);
+  Enqueue(HCI_BLE_WRITE_SCAN_PARAMS, 2);
+  EXPECT_EQ(replaced_, nullptr);
+  EXPECT_EQ(scheduler_.Size(), 3u);
+  EXPECT_EQ(scheduler_.Dequeue(0), params);
+
+  // Nor the one sent already, nor opcodes not opted in
+  DequeueAll();
+  Enqueue(HCI_BLE_WRITE_SCAN_PARAMS, 1);
+  scheduler_.Dequeue(0);
+  Enqueue(HCI_BLE_WRITE_SCAN_PARAMS, 2);
+  EXPECT_EQ(replaced_, nullptr);
+  Enqueue(HCI_BLE_ADD_WHITE_LIST, 1);
+  Enqueue(HCI_BLE_ADD_WHITE_LIST, 1);
+  EXPECT_EQ(replaced_, nullptr);
+
+  EXPECT_EQ(scheduler_.GetStats(HciCommandScheduler::kBulk).coalesced, 3u);
+
+  HciCommandScheduler no_coalescing(true, false);
+  no_coalescing.SetCoalescable(HCI_BLE_WRITE_SCAN_ENABLE);
+  Command first{HCI_BLE_WRITE_SCAN_ENABLE, 1, 0, HciCommandScheduler::kBulk};
+  Command second{HCI_BLE_WRITE_SCAN_ENABLE, 0, 0, HciCommandScheduler::kBulk};
+  no_coalescing.Enqueue(first.opcode, &first, 0);
+  EXPECT_EQ(no_coalescing.Enqueue(second.opcode, &second, 0), nullptr);
+}
+
+TEST(HciPendingCommandsTest, take_by_opcode) {
+  HciPendingCommands pending;
+  int entries[5];
+  pending.Add(HCI_READ_RSSI, &entries[0]);
+  pending.Add(HCI_BLE_ADV_FILTER_OCF, &entries[1]);
+  pending.Add(HCI_READ_RSSI, &entries[2]);
+  pending.Add(HCI_DISCONNECT, &entries[3]);
+  pending.Add(HCI_BLE_BATCH_SCAN_OCF, &entries[4]);
+
+  EXPECT_EQ(pending.Size(), 5u);
+  EXPECT_EQ(pending.Front(), &entries[0]);
+  EXPECT_EQ(pending.Entries(),
+            std::vector<void*>({&entries[0], &entries[1], &entries[2],
+                                &entries[3], &entries[4]}));
+
+  EXPECT_EQ(pending.Take(HCI_READ_RSSI), &entries[0]);
+  EXPECT_EQ(pending.Take(HCI_BLE_BATCH_SCAN_OCF), &entries[4]);
+  EXPECT_EQ(pending.Take(HCI_RESET), nullptr);
+  EXPECT_EQ(pending.Front(), &entries[1]);
+
+  // Vendor specific responses with the wrong opcode, or none
+  EXPECT_EQ(pending.Take(HCI_BLE_TRACK_ADV_OCF), &entries[1]);
+  EXPECT_EQ(pending.Take(0), nullptr);
+  pending.Add(HCI_BLE_ADV_FILTER_OCF, &entries[1]);
+  EXPECT_EQ(pending.Take(0), &entries[1]);
+
+  EXPECT_EQ(pending.Take(HCI_READ_RSSI), &entries[2]);
+  EXPECT_EQ(pending.Take(HCI_READ_RSSI), nullptr);
+  EXPECT_EQ(pending.Size(), 1u);
+  pending.Clear();
+  EXPECT_TRUE(pending.Empty());
+  EXPECT_EQ(pending.Front(), nullptr);
+}
+
+namespace {
+
+// Controller granting one command credit at a time. It rejects commands the
+// way a real controller would when they arrive in an order the host did not
+// mean, and answers each command after |kCommandUs|.
+class FakeController {
+ public:
+  static const uint64_t kCommandUs = 800;
+
+  // Returns false if the command is disallowed or fails.
+  bool Process(const Command& command) {
+    switch (command.opcode) {
+      case HCI_BLE_WRITE_SCAN_ENABLE:
+        scanning_ = command.arg;
+        return true;
+      case HCI_BLE_WRITE_SCAN_PARAMS:
+      case HCI_BLE_WRITE_RANDOM_ADDR:
+        return !scanning_;
+      case HCI_BLE_ADD_WHITE_LIST:
+        accept_list_.insert(command.arg);
+        return true;
+      case HCI_BLE_REMOVE_WHITE_LIST:
+        accept_list_.erase(command.arg);
+        return true;
+      case HCI_BLE_CREATE_LL_CONN:
+        // The target is advertising, the connection is made at once
+        return accept_list_.count(command.arg) > 0;
+    }
+    return true;
+  }
+
+ private:
+  bool scanning_ = false;
+  std::set<uint32_t> accept_list_;
+};
+
+struct Arrival {
+  uint64_t at_us;
+  uint16_t opcode;
+  uint32_t arg;
+};
+
+// Host traffic: every 25 ms a burst of scan restarts, vendor scan filter
+// updates and accept list changes, at times with a random address rotation;
+// connections, disconnections and encryption at random times in between.
+// Every sequence is valid when sent in the order queued.
+std::vector<Arrival> HostTraffic(std::mt19937& rng, uint64_t duration_us) {
+  std::vector<Arrival> arrivals;
+  for (uint64_t t = 0; t < duration_us; t += 25000) {
+    for (int i = 0; i < 2; i++) {
+      arrivals.push_back({t, HCI_BLE_WRITE_SCAN_ENABLE, 0});
+      if (rng() % 4 == 0) arrivals.push_back({t, HCI_BLE_WRITE_RANDOM_ADDR, 0});
+      arrivals.push_back({t, HCI_BLE_WRITE_SCAN_PARAMS, 0});
+      for (int f = 0; f < 3; f++)
+        arrivals.push_back({t, HCI_BLE_ADV_FILTER_OCF, 0});
+      arrivals.push_back({t, HCI_BLE_WRITE_SCAN_ENABLE, 1});
+    }
+    for (int i = 0; i < 4; i++) {
+      uint32_t device = 1000 + rng() % 100;
+      arrivals.push_back({t, HCI_BLE_ADD_WHITE_LIST, device});
+      arrivals.push_back({t, HCI_BLE_REMOVE_WHITE_LIST, device});
+    }
+    arrivals.push_back({t, HCI_READ_RSSI, 0});
+  }
+
+  uint32_t next_device = 1;
+  for (uint64_t t = 3000; t < duration_us; t += 5000 + rng() % 10000) {
+    switch (rng() % 3) {
+      case 0:
+        arrivals.push_back({t, HCI_BLE_ADD_WHITE_LIST, next_device});
+        arrivals.push_back({t, HCI_BLE_CREATE_LL_CONN, next_device++});
+        break;
+      case 1:
+        arrivals.push_back({t, HCI_DISCONNECT, 0});
+        break;
+      default:
+        arrivals.push_back({t, HCI_BLE_START_ENC, 0});
+        break;
+    }
+  }
+
+  std::stable_sort(arrivals.begin(), arrivals.end(),
+                   [](const Arrival& a, const Arrival& b) {
+                     return a.at_us < b.at_us;
+                   });
+  return arrivals;
+}
+
+struct LaneLatency {
+  size_t answered = 0;
+  uint64_t total_us = 0;
+  uint64_t max_us = 0;
+
+  uint64_t average_us() const { return answered ? total_us / answered : 0; }
+};
+
+struct RunResult {
+  LaneLatency latency[HciCommandScheduler::kNumLanes];
+  size_t sent = 0;
+  size_t failed = 0;
+};
+
+// Plays |arrivals| through a scheduler to the fake controller, one command
+// in flight at a time, and measures the time from queueing to response.
+RunResult RunTraffic(const std::vector<Arrival>& arrivals, bool prioritize) {
+  HciCommandScheduler scheduler(prioritize, prioritize);
+  scheduler.SetCoalescable(HCI_BLE_WRITE_SCAN_PARAMS);
+  scheduler.SetCoalescable(HCI_BLE_WRITE_SCAN_ENABLE);
+  FakeController controller;
+  RunResult result;
+
+  std::deque<Command> commands;
+  // Commands replaced in the queue, answered along with the one replacing them
+  std::map<const Command*, std::vector<const Command*>> replaced;
+  auto answer = [&result, &replaced](const Command* command, uint64_t now_us) {
+    std::vector<const Command*> answered = std::move(replaced[command]);
+    replaced.erase(command);
+    answered.push_back(command);
+    for (const Command* each : answered) {
+      LaneLatency& latency = result.latency[each->lane];
+      uint64_t waited_us = now_us - each->enqueued_us;
+      latency.answered++;
+      latency.total_us += waited_us;
+      latency.max_us = std::max(latency.max_us, waited_us);
+    }
+  };
+
+  size_t next = 0;
+  uint64_t now_us = 0;
+  while (next < arrivals.size() || !scheduler.Empty()) {
+    if (scheduler.Empty()) now_us = std::max(now_us, arrivals[next].at_us);
+    while (next < arrivals.size() && arrivals[next].at_us <= now_us) {
+      const Arrival& arrival = arrivals[next++];
+      commands.push_back(Command{arrival.opcode, arrival.arg, arrival.at_us,
+                                 HciCommandScheduler::GetLane(arrival.opcode)});
+      const Command* command = &commands.back();
+      const Command* old = static_cast<const Command*>(
+          scheduler.Enqueue(arrival.opcode, &commands.back(), arrival.at_us));
+      if (old) {
+        std::vector<const Command*>& along = replaced[command];
+        along = std::move(replaced[old]);
+        replaced.erase(old);
+        along.push_back(old);
+      }
+    }
+
+    Command* command = static_cast<Command*>(scheduler.Dequeue(now_us));
+    now_us += FakeController::kCommandUs;
+    result.sent++;
+    if (!controller.Process(*command)) result.failed++;
+    answer(command, now_us);
+  }
+  return result;
+}
+
+}  // namespace
+
+// Connection setup and teardown must not wait behind scan and accept list
+// churn, and reordering must not make the controller reject anything.
+TEST(HciCommandSchedulerFakeControllerTest, urgent_commands_jump_the_queue) {
+  std::mt19937 rng(7);
+  std::vector<Arrival> arrivals = HostTraffic(rng, 2000000);
+
+  RunResult fifo = RunTraffic(arrivals, false);
+  RunResult lanes = RunTraffic(arrivals, true);
+
+  EXPECT_EQ(fifo.failed, 0u);
+  EXPECT_EQ(lanes.failed, 0u);
+  EXPECT_LT(lanes.sent, fifo.sent);
+
+  const LaneLatency& fifo_urgent = fifo.latency[HciCommandScheduler::kUrgent];
+  const LaneLatency& lanes_urgent = lanes.latency[HciCommandScheduler::kUrgent];
+  EXPECT_EQ(fifo_urgent.answered, lanes_urgent.answered);
+  EXPECT_LT(lanes_urgent.average_us() * 2, fifo_urgent.average_us());
+  EXPECT_LT(lanes_urgent.max_us, fifo_urgent.max_us);
+
+  for (int i = 0; i < HciCommandScheduler::kNumLanes; i++) {
+    HciCommandScheduler::Lane lane = (HciCommandScheduler::Lane)i;
+    printf("%-6s: FIFO avg %5llu us max %6llu us, lanes avg %5llu us max "
+           "%6llu us\n",
+           HciCommandScheduler::LaneName(lane),
+           (unsigned long long)fifo.latency[i].average_us(),
+           (unsigned long long)fifo.latency[i].max_us,
+           (unsigned long long)lanes.latency[i].average_us(),
+           (unsigned long long)lanes.latency[i].max_us);
+  }
+  printf("commands sent: FIFO %zu, lanes %zu\n", fifo.sent, lanes.sent);
+}
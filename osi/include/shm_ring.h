@@ -0,0 +1,75 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Single producer, single consumer byte ring living in a memfd so that it can
+// be shared between processes. The reader is woken up through an eventfd, and
+// only when the ring goes from empty to non-empty; a reader that keeps up with
+// the writer never makes a system call.
+//
+// One process creates the ring with |shm_ring_new| and hands the descriptors
+// returned by |shm_ring_get_mem_fd| and |shm_ring_get_event_fd| to the other,
+// which maps it with |shm_ring_attach|. Exactly one side may write and one
+// side may read.
+typedef struct shm_ring_t shm_ring_t;
+
+// Creates a ring able to hold at least |capacity| bytes. The capacity is
+// rounded up to a power of two. |name| is only used to label the memfd.
+// Returns NULL on failure. The ring must be freed with |shm_ring_free|.
+shm_ring_t* shm_ring_new(const char* name, size_t capacity);
+
+// Maps a ring created by another process. On success the ring takes
+// ownership of |mem_fd| and |event_fd|; on failure NULL is returned and the
+// caller still owns both descriptors.
+shm_ring_t* shm_ring_attach(int mem_fd, int event_fd);
+
+// Unmaps the ring and closes its descriptors. Safe to call with NULL.
+void shm_ring_free(shm_ring_t* ring);
+
+int shm_ring_get_mem_fd(const shm_ring_t* ring);
+int shm_ring_get_event_fd(const shm_ring_t* ring);
+
+// Returns the capacity of the ring in bytes.
+size_t shm_ring_capacity(const shm_ring_t* ring);
+
+// Returns the number of bytes ready to be read.
+size_t shm_ring_size(const shm_ring_t* ring);
+
+// Returns the number of bytes that can be written without overwriting.
+size_t shm_ring_available(const shm_ring_t* ring);
+
+// Writer: copies up to |length| bytes from |p| into the ring and returns the
+// number of bytes written, which is less than |length| if the ring is full.
+// Signals the reader if the ring was empty.
+size_t shm_ring_write(shm_ring_t* ring, const uint8_t* p, size_t length);
+
+// Writer: marks the writer as gone and wakes up the reader.
+void shm_ring_close_writer(shm_ring_t* ring);
+
+// Reader: copies up to |length| bytes into |p| without blocking. Returns the
+// number of bytes read.
+size_t shm_ring_read(shm_ring_t* ring, uint8_t* p, size_t length);
+
+// Reader: like |shm_ring_read| but waits for more data while the ring is
+// empty, for at most |timeout_ms| each time. Returns early if the writer
+// closed the ring or a wait timed out.
+size_t shm_ring_read_wait(shm_ring_t* ring, uint8_t* p, size_t length,
+                          int timeout_ms);
+
+// Reader: discards everything in the ring.
+void shm_ring_flush(shm_ring_t* ring);
+
+// Returns true once the writer called |shm_ring_close_writer|.
+bool shm_ring_is_writer_closed(const shm_ring_t* ring);
+
+// Owner: empties the ring and clears the closed flag so that a new writer
+// can attach. Must not be called while a writer is using the ring.
+void shm_ring_reset(shm_ring_t* ring);
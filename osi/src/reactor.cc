@@ -46,6 +46,9 @@ struct reactor_t {
   list_t* invalidation_list;  // reactor objects that have been unregistered.
   pthread_t run_thread;       // the pthread on which reactor_run is executing.
   bool is_running;            // indicates whether |run_thread| is valid.
+  reactor_object_t* dispatching;  // object whose callbacks are running.
+  list_t* removed_list;  // objects unregistered by another object's callback;
+                         // freed once the current events are dispatched.
   bool object_removed;
 };
 
@@ -62,6 +65,7 @@ struct reactor_object_t {
 };
 
 static reactor_status_t run_reactor(reactor_t* reactor, int iterations);
+static void free_removed_objects(reactor_t* reactor);
 
 static const size_t MAX_EVENTS = 64;
 static const eventfd_t EVENT_REACTOR_STOP = 1;
@@ -94,6 +98,12 @@ reactor_t* reactor_new(void) {
     goto error;
   }
 
+  ret->removed_list = list_new(NULL);
+  if (!ret->removed_list) {
+    LOG_ERROR(LOG_TAG, "%s unable to allocate removed object list.", __func__);
+    goto error;
+  }
+
   struct epoll_event event;
   memset(&event, 0, sizeof(event));
   event.events = EPOLLIN;
@@ -115,6 +125,7 @@ void reactor_free(reactor_t* reactor) {
   if (!reactor) return;
 
   list_free(reactor->invalidation_list);
+  list_free(reactor->removed_list);
   close(reactor->event_fd);
   close(reactor->epoll_fd);
   osi_free(reactor);
@@ -205,7 +216,17 @@ void reactor_unregister(reactor_object_t* obj) {
 
   if (reactor->is_running &&
       pthread_equal(pthread_self(), reactor->run_thread)) {
-    reactor->object_removed = true;
+    if (obj == reactor->dispatching) {
+      reactor->object_removed = true;
+      return;
+    }
+
+    // Unregistered from the callback of another object: none of its own
+    // callbacks can be running, but it may still have an event pending in
+    // this iteration, so only silence it until the events are dispatched.
+    obj->read_ready = NULL;
+    obj->write_ready = NULL;
+    list_append(reactor->removed_list, obj);
     return;
   }
 
@@ -260,6 +281,7 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
       if (events[j].data.ptr == NULL) {
         eventfd_t value;
         eventfd_read(reactor->event_fd, &value);
+        free_removed_objects(reactor);
         reactor->is_running = false;
         return REACTOR_STATUS_STOP;
       }
@@ -276,6 +298,7 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
         std::lock_guard<std::mutex> obj_lock(*object->mutex);
         lock.unlock();
 
+        reactor->dispatching = object;
         reactor->object_removed = false;
         if (events[j].events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR) &&
             object->read_ready)
@@ -283,6 +306,7 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
         if (!reactor->object_removed && events[j].events & EPOLLOUT &&
             object->write_ready)
           object->write_ready(object->context);
+        reactor->dispatching = NULL;
       }
 
       if (reactor->object_removed) {
@@ -290,8 +314,19 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
         osi_free(object);
       }
     }
+    free_removed_objects(reactor);
   }
 
   reactor->is_running = false;
   return REACTOR_STATUS_DONE;
 }
+
+static void free_removed_objects(reactor_t* reactor) {
+  for (const list_node_t* node = list_begin(reactor->removed_list);
+       node != list_end(reactor->removed_list); node = list_next(node)) {
+    reactor_object_t* object = (reactor_object_t*)list_node(node);
+    delete object->mutex;
+    osi_free(object);
+  }
+  list_clear(reactor->removed_list);
+}
@@ -0,0 +1,317 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "bt_osi_shm_ring"
+
+#include "osi/include/shm_ring.h"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+#define SHM_RING_MAGIC 0x52505442 /* "BTPR" */
+#define SHM_RING_VERSION 1
+#define SHM_RING_MAX_CAPACITY (1U << 30)
+
+// Positions are free running 32 bit counters; the ring index is the position
+// modulo the capacity, which is a power of two. Reader and writer fields sit
+// on separate cache lines so that the two sides do not false share.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;
+  alignas(64) std::atomic<uint32_t> write_pos;
+  alignas(64) std::atomic<uint32_t> read_pos;
+  alignas(64) std::atomic<uint32_t> writer_closed;
+} shm_ring_header_t;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory atomics must be lock free");
+
+#define SHM_RING_DATA_OFFSET \
+  ((sizeof(shm_ring_header_t) + 63) & ~static_cast<size_t>(63))
+
+struct shm_ring_t {
+  int mem_fd;
+  int event_fd;
+  size_t map_size;
+  uint32_t mask;
+  shm_ring_header_t* header;
+  uint8_t* data;
+};
+
+static bool shm_ring_map(shm_ring_t* ring, int mem_fd, size_t map_size) {
+  void* addr =
+      mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+  if (addr == MAP_FAILED) {
+    LOG_ERROR(LOG_TAG, "%s unable to map ring: %s", __func__,
+              strerror(errno));
+    return false;
+  }
+  ring->mem_fd = mem_fd;
+  ring->map_size = map_size;
+  ring->header = static_cast<shm_ring_header_t*>(addr);
+  ring->data = static_cast<uint8_t*>(addr) + SHM_RING_DATA_OFFSET;
+  return true;
+}
+
+static void shm_ring_signal(shm_ring_t* ring) {
+  // EAGAIN only means the counter is saturated, i.e. already signaled
+  if (eventfd_write(ring->event_fd, 1) < 0 && errno != EAGAIN)
+    LOG_ERROR(LOG_TAG, "%s unable to signal reader: %s", __func__,
+              strerror(errno));
+}
+
+shm_ring_t* shm_ring_new(const char* name, size_t capacity) {
+  if (capacity == 0 || capacity > SHM_RING_MAX_CAPACITY) return NULL;
+
+  uint32_t ring_capacity = 1;
+  while (ring_capacity < capacity) ring_capacity <<= 1;
+
+  int mem_fd = syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (mem_fd < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to create memfd: %s", __func__,
+              strerror(errno));
+    return NULL;
+  }
+
+  size_t map_size = SHM_RING_DATA_OFFSET + ring_capacity;
+  if (ftruncate(mem_fd, map_size) < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to size memfd: %s", __func__,
+              strerror(errno));
+    close(mem_fd);
+    return NULL;
+  }
+  // The peer must not be able to resize the mapping under us
+  if (fcntl(mem_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) <
+      0)
+    LOG_WARN(LOG_TAG, "%s unable to seal memfd: %s", __func__,
+             strerror(errno));
+
+  int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (event_fd < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to create eventfd: %s", __func__,
+              strerror(errno));
+    close(mem_fd);
+    return NULL;
+  }
+
+  shm_ring_t* ring = static_cast<shm_ring_t*>(osi_calloc(sizeof(shm_ring_t)));
+  ring->event_fd = event_fd;
+  if (!shm_ring_map(ring, mem_fd, map_size)) {
+    close(event_fd);
+    close(mem_fd);
+    osi_free(ring);
+    return NULL;
+  }
+
+  shm_ring_header_t* header = ring->header;
+  header->magic = SHM_RING_MAGIC;
+  header->version = SHM_RING_VERSION;
+  header->capacity = ring_capacity;
+  header->write_pos.store(0);
+  header->read_pos.store(0);
+  header->writer_closed.store(0);
+  ring->mask = ring_capacity - 1;
+  return ring;
+}
+
+shm_ring_t* shm_ring_attach(int mem_fd, int event_fd) {
+  struct stat st;
+  if (mem_fd < 0 || event_fd < 0 || fstat(mem_fd, &st) < 0 ||
+      st.st_size < static_cast<off_t>(SHM_RING_DATA_OFFSET)) {
+    LOG_ERROR(LOG_TAG, "%s invalid ring descriptors", __func__);
+    return NULL;
+  }
+
+  shm_ring_t* ring = static_cast<shm_ring_t*>(osi_calloc(sizeof(shm_ring_t)));
+  ring->event_fd = event_fd;
+  if (!shm_ring_map(ring, mem_fd, st.st_size)) {
+    osi_free(ring);
+    return NULL;
+  }
+
+  // Everything read from the header is untrusted until validated
+  uint32_t capacity = ring->header->capacity;
+  if (ring->header->magic != SHM_RING_MAGIC ||
+      ring->header->version != SHM_RING_VERSION || capacity == 0 ||
+      (capacity & (capacity - 1)) != 0 ||
+      capacity > ring->map_size - SHM_RING_DATA_OFFSET) {
+    LOG_ERROR(LOG_TAG, "%s invalid ring header", __func__);
+    munmap(ring->header, ring->map_size);
+    osi_free(ring);
+    return NULL;
+  }
+  ring->mask = capacity - 1;
+  return ring;
+}
+
+void shm_ring_free(shm_ring_t* ring) {
+  if (ring == NULL) return;
+  munmap(ring->header, ring->map_size);
+  close(ring->mem_fd);
+  close(ring->event_fd);
+  osi_free(ring);
+}
+
+int shm_ring_get_mem_fd(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  return ring->mem_fd;
+}
+
+int shm_ring_get_event_fd(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  return ring->event_fd;
+}
+
+size_t shm_ring_capacity(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  return ring->mask + 1;
+}
+
+size_t shm_ring_size(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  uint32_t size = ring->header->write_pos.load(std::memory_order_acquire) -
+                  ring->header->read_pos.load(std::memory_order_acquire);
+  // A misbehaving peer must not make us read past the ring
+  return std::min<size_t>(size, ring->mask + 1);
+}
+
+size_t shm_ring_available(const shm_ring_t* ring) {
+  return shm_ring_capacity(ring) - shm_ring_size(ring);
+}
+
+size_t shm_ring_write(shm_ring_t* ring, const uint8_t* p, size_t length) {
+  CHECK(ring != NULL);
+  CHECK(p != NULL);
+
+  shm_ring_header_t* header = ring->header;
+  uint32_t write_pos = header->write_pos.load(std::memory_order_relaxed);
+  uint32_t used =
+      write_pos - header->read_pos.load(std::memory_order_acquire);
+  size_t capacity = ring->mask + 1;
+  if (used > capacity) return 0;
+  length = std::min(length, capacity - used);
+  if (length == 0) return 0;
+
+  size_t offset = write_pos & ring->mask;
+  size_t first = std::min(length, capacity - offset);
+  memcpy(ring->data + offset, p, first);
+  memcpy(ring->data, p + first, length - first);
+
+  // Publishing the write position and then checking the read position pairs
+  // with the reader storing its position and then checking ours, so at least
+  // one side sees the other and a wakeup cannot be lost.
+  header->write_pos.store(write_pos + length, std::memory_order_seq_cst);
+  if (header->read_pos.load(std::memory_order_seq_cst) == write_pos)
+    shm_ring_signal(ring);
+  return length;
+}
+
+void shm_ring_close_writer(shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  ring->header->writer_closed.store(1, std::memory_order_seq_cst);
+  shm_ring_signal(ring);
+}
+
+size_t shm_ring_read(shm_ring_t* ring, uint8_t* p, size_t length) {
+  CHECK(ring != NULL);
+  CHECK(p != NULL);
+
+  shm_ring_header_t* header = ring->header;
+  uint32_t read_pos = header->read_pos.load(std::memory_order_relaxed);
+  length = std::min(length, shm_ring_size(ring));
+  if (length == 0) return 0;
+
+  size_t capacity = ring->mask + 1;
+  size_t offset = read_pos & ring->mask;
+  size_t first = std::min(length, capacity - offset);
+  memcpy(p, ring->data + offset, first);
+  memcpy(p + first, ring->data, length - first);
+
+  header->read_pos.store(read_pos + length, std::memory_order_seq_cst);
+  return length;
+}
+
+size_t shm_ring_read_wait(shm_ring_t* ring, uint8_t* p, size_t length,
+                          int timeout_ms) {
+  CHECK(ring != NULL);
+
+  size_t n_read = 0;
+  while (n_read < length) {
+    n_read += shm_ring_read(ring, p + n_read, length - n_read);
+    if (n_read == length) break;
+    if (ring->header->writer_closed.load(std::memory_order_acquire)) break;
+
+    // Re-check after our read position has been published, see
+    // |shm_ring_write|.
+    if (ring->header->write_pos.load(std::memory_order_seq_cst) !=
+        ring->header->read_pos.load(std::memory_order_relaxed))
+      continue;
+
+    struct pollfd pfd;
+    pfd.fd = ring->event_fd;
+    pfd.events = POLLIN;
+    int ret;
+    OSI_NO_INTR(ret = poll(&pfd, 1, timeout_ms));
+    if (ret == 0) break;
+    if (ret < 0) {
+      LOG_ERROR(LOG_TAG, "%s poll failed: %s", __func__, strerror(errno));
+      break;
+    }
+    eventfd_t value;
+    eventfd_read(ring->event_fd, &value);
+  }
+  return n_read;
+}
+
+void shm_ring_flush(shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  ring->header->read_pos.store(
+      ring->header->write_pos.load(std::memory_order_acquire),
+      std::memory_order_seq_cst);
+}
+
+bool shm_ring_is_writer_closed(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  return ring->header->writer_closed.load(std::memory_order_acquire) != 0;
+}
+
+void shm_ring_reset(shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  ring->header->write_pos.store(0);
+  ring->header->read_pos.store(0);
+  ring->header->writer_closed.store(0);
+
+  eventfd_t value;
+  eventfd_read(ring->event_fd, &value);
+}
@@ -95,6 +95,53 @@ TEST_F(ReactorTest, reactor_unregister_from_callback) {
   reactor_free(reactor);
 }
 
+typedef struct {
+  reactor_t* reactor;
+  int fd;
+  reactor_object_t* other;
+  int calls;
+} unregister_other_arg_t;
+
+static void unregister_other_cb(void* context) {
+  unregister_other_arg_t* arg = (unregister_other_arg_t*)context;
+  eventfd_t value;
+  eventfd_read(arg->fd, &value);
+  arg->calls++;
+  if (arg->other != NULL) {
+    reactor_unregister(arg->other);
+    arg->other = NULL;
+  }
+  reactor_stop(arg->reactor);
+}
+
+TEST_F(ReactorTest, reactor_unregister_other_from_callback) {
+  reactor_t* reactor = reactor_new();
+
+  int fd_a = eventfd(0, 0);
+  int fd_b = eventfd(0, 0);
+  unregister_other_arg_t arg_a = {reactor, fd_a, NULL, 0};
+  unregister_other_arg_t arg_b = {reactor, fd_b, NULL, 0};
+  reactor_object_t* object_a =
+      reactor_register(reactor, fd_a, &arg_a, unregister_other_cb, NULL);
+  reactor_object_t* object_b =
+      reactor_register(reactor, fd_b, &arg_b, unregister_other_cb, NULL);
+  arg_a.other = object_b;
+  arg_b.other = object_a;
+
+  // Both are ready in the same iteration; whichever runs first unregisters
+  // the other one, which must then neither run nor free the first one.
+  eventfd_write(fd_a, 1);
+  eventfd_write(fd_b, 1);
+  spawn_reactor_thread(reactor);
+  join_reactor_thread();
+  EXPECT_EQ(1, arg_a.calls + arg_b.calls);
+
+  reactor_unregister(arg_a.calls ? object_a : object_b);
+  close(fd_a);
+  close(fd_b);
+  reactor_free(reactor);
+}
+
 TEST_F(ReactorTest, reactor_unregister_from_separate_thread) {
   reactor_t* reactor = reactor_new();
 
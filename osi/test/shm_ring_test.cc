@@ -0,0 +1,367 @@
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/osi.h"
+#include "osi/include/shm_ring.h"
+
+class ShmRingTest : public AllocationTestHarness {};
+
+static void fill_pattern(uint8_t* p, size_t length, uint32_t seed) {
+  for (size_t i = 0; i < length; i++) p[i] = (uint8_t)((seed + i) * 31);
+}
+
+TEST_F(ShmRingTest, test_new_simple) {
+  shm_ring_t* ring = shm_ring_new("shm_ring_test", 1000);
+  ASSERT_TRUE(ring != NULL);
+  EXPECT_EQ((size_t)1024, shm_ring_capacity(ring));
+  EXPECT_EQ((size_t)1024, shm_ring_available(ring));
+  EXPECT_EQ((size_t)0, shm_ring_size(ring));
+  EXPECT_FALSE(shm_ring_is_writer_closed(ring));
+  shm_ring_free(ring);
+  shm_ring_free(NULL);
+}
+
+TEST_F(ShmRingTest, test_write_read_wrap) {
+  shm_ring_t* ring = shm_ring_new("shm_ring_test", 64);
+  ASSERT_TRUE(ring != NULL);
+
+  uint8_t in[48];
+  uint8_t out[48];
+  for (uint32_t round = 0; round < 100; round++) {
+    fill_pattern(in, sizeof(in), round);
+    EXPECT_EQ(sizeof(in), shm_ring_write(ring, in, sizeof(in)));
+    EXPECT_EQ(sizeof(in), shm_ring_size(ring));
+    memset(out, 0, sizeof(out));
+    EXPECT_EQ(sizeof(out), shm_ring_read(ring, out, sizeof(out)));
+    ASSERT_EQ(0, memcmp(in, out, sizeof(in)));
+  }
+  EXPECT_EQ((size_t)0, shm_ring_read(ring, out, sizeof(out)));
+  shm_ring_free(ring);
+}
+
+TEST_F(ShmRingTest, test_write_full) {
+  shm_ring_t* ring = shm_ring_new("shm_ring_test", 16);
+  ASSERT_TRUE(ring != NULL);
+
+  uint8_t in[20];
+  fill_pattern(in, sizeof(in), 0);
+  EXPECT_EQ((size_t)16, shm_ring_write(ring, in, sizeof(in)));
+  EXPECT_EQ((size_t)0, shm_ring_available(ring));
+  EXPECT_EQ((size_t)0, shm_ring_write(ring, in, sizeof(in)));
+
+  shm_ring_flush(ring);
+  EXPECT_EQ((size_t)0, shm_ring_size(ring));
+  EXPECT_EQ((size_t)16, shm_ring_available(ring));
+  shm_ring_free(ring);
+}
+
+TEST_F(ShmRingTest, test_signal_on_empty_only) {
+  shm_ring_t* ring = shm_ring_new("shm_ring_test", 256);
+  ASSERT_TRUE(ring != NULL);
+  int event_fd = shm_ring_get_event_fd(ring);
+
+  uint8_t buf[16] = {0};
+  eventfd_t value = 0;
+  for (int i = 0; i < 5; i++) shm_ring_write(ring, buf, sizeof(buf));
+  ASSERT_EQ(0, eventfd_read(event_fd, &value));
+  EXPECT_EQ((eventfd_t)1, value);
+
+  // Partially drained: still non-empty, no new wakeup
+  shm_ring_read(ring, buf, sizeof(buf));
+  shm_ring_write(ring, buf, sizeof(buf));
+  EXPECT_EQ(-1, eventfd_read(event_fd, &value));
+
+  // Fully drained: the next write wakes the reader again
+  uint8_t drain[256];
+  shm_ring_read(ring, drain, sizeof(drain));
+  shm_ring_write(ring, buf, sizeof(buf));
+  ASSERT_EQ(0, eventfd_read(event_fd, &value));
+  EXPECT_EQ((eventfd_t)1, value);
+  shm_ring_free(ring);
+}
+
+TEST_F(ShmRingTest, test_attach_shares_data) {
+  shm_ring_t* ring = shm_ring_new("shm_ring_test", 4096);
+  ASSERT_TRUE(ring != NULL);
+  shm_ring_t* peer = shm_ring_attach(dup(shm_ring_get_mem_fd(ring)),
+                                     dup(shm_ring_get_event_fd(ring)));
+  ASSERT_TRUE(peer != NULL);
+  EXPECT_EQ((size_t)4096, shm_ring_capacity(peer));
+
+  uint8_t in[1000];
+  uint8_t out[1000];
+  fill_pattern(in, sizeof(in), 7);
+  EXPECT_EQ(sizeof(in), shm_ring_write(peer, in, sizeof(in)));
+  EXPECT_EQ(sizeof(out), shm_ring_read_wait(ring, out, sizeof(out), 100));
+  EXPECT_EQ(0, memcmp(in, out, sizeof(in)));
+
+  shm_ring_close_writer(peer);
+  EXPECT_TRUE(shm_ring_is_writer_closed(ring));
+  EXPECT_EQ((size_t)0, shm_ring_read_wait(ring, out, sizeof(out), 1000));
+
+  shm_ring_reset(ring);
+  EXPECT_FALSE(shm_ring_is_writer_closed(peer));
+  shm_ring_free(peer);
+  shm_ring_free(ring);
+}
+
+TEST_F(ShmRingTest, test_attach_rejects_bad_header) {
+  int mem_fd = syscall(__NR_memfd_create, "shm_ring_test", 0);
+  ASSERT_GE(mem_fd, 0);
+  ASSERT_EQ(0, ftruncate(mem_fd, 8192));
+  uint8_t garbage[256];
+  fill_pattern(garbage, sizeof(garbage), 3);
+  ASSERT_EQ((ssize_t)sizeof(garbage), write(mem_fd, garbage, sizeof(garbage)));
+  int event_fd = eventfd(0, EFD_NONBLOCK);
+
+  EXPECT_TRUE(shm_ring_attach(mem_fd, event_fd) == NULL);
+  EXPECT_TRUE(shm_ring_attach(-1, event_fd) == NULL);
+  close(mem_fd);
+  close(event_fd);
+}
+
+TEST_F(ShmRingTest, test_cross_process) {
+  const size_t kTotal = 1 << 20;
+  shm_ring_t* ring = shm_ring_new("shm_ring_test", 8192);
+  ASSERT_TRUE(ring != NULL);
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    shm_ring_t* writer = shm_ring_attach(dup(shm_ring_get_mem_fd(ring)),
+                                         dup(shm_ring_get_event_fd(ring)));
+    if (writer == NULL) _exit(1);
+    uint8_t chunk[1500];
+    size_t sent = 0;
+    while (sent < kTotal) {
+      size_t n = std::min(sizeof(chunk), kTotal - sent);
+      fill_pattern(chunk, n, sent);
+      size_t done = 0;
+      while (done < n) {
+        size_t w = shm_ring_write(writer, chunk + done, n - done);
+        if (w == 0) usleep(100);
+        done += w;
+      }
+      sent += n;
+    }
+    shm_ring_close_writer(writer);
+    _exit(0);
+  }
+
+  std::vector<uint8_t> expected(4096);
+  std::vector<uint8_t> got(4096);
+  size_t received = 0;
+  while (received < kTotal) {
+    size_t n = shm_ring_read_wait(ring, got.data(), got.size(), 1000);
+    ASSERT_GT(n, (size_t)0);
+    for (size_t i = 0; i < n; i++)
+      ASSERT_EQ((uint8_t)((received + i) * 31), got[i]);
+    received += n;
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_TRUE(shm_ring_is_writer_closed(ring));
+  shm_ring_free(ring);
+}
+
+// Host side comparison of the A2DP PCM data path transports: a UNIX stream
+// socket read the way UIPC_Read does, and the shared memory ring. The writer
+// plays the audio HAL delivering 48 kHz stereo 16 bit PCM, the reader the
+// A2DP source media task. Every chunk carries its write time so the reader
+// can measure end-to-end latency. Numbers are printed, not asserted, as they
+// depend on the host.
+namespace {
+
+constexpr size_t kBytesPerSec = 48000 * 2 * 2;
+constexpr size_t kSocketBufferSize = 28 * 1024;
+
+uint64_t now_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class PcmTransport {
+ public:
+  virtual ~PcmTransport() = default;
+  virtual size_t Write(const uint8_t* p, size_t length) = 0;
+  virtual size_t Read(uint8_t* p, size_t length) = 0;
+};
+
+class SocketTransport : public PcmTransport {
+ public:
+  SocketTransport() {
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds_);
+    int len = kSocketBufferSize;
+    setsockopt(fds_[0], SOL_SOCKET, SO_SNDBUF, &len, sizeof(len));
+    setsockopt(fds_[1], SOL_SOCKET, SO_RCVBUF, &len, sizeof(len));
+  }
+  ~SocketTransport() override {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+  size_t Write(const uint8_t* p, size_t length) override {
+    ssize_t sent;
+    OSI_NO_INTR(sent = send(fds_[0], p, length, MSG_NOSIGNAL | MSG_DONTWAIT));
+    return sent < 0 ? 0 : sent;
+  }
+  size_t Read(uint8_t* p, size_t length) override {
+    size_t n_read = 0;
+    while (n_read < length) {
+      struct pollfd pfd = {fds_[1], POLLIN, 0};
+      int ret;
+      OSI_NO_INTR(ret = poll(&pfd, 1, 100));
+      if (ret <= 0) break;
+      ssize_t n;
+      OSI_NO_INTR(n = recv(fds_[1], p + n_read, length - n_read, 0));
+      if (n <= 0) break;
+      n_read += n;
+    }
+    return n_read;
+  }
+
+ private:
+  int fds_[2];
+};
+
+class RingTransport : public PcmTransport {
+ public:
+  RingTransport() {
+    reader_ = shm_ring_new("shm_ring_stream", kSocketBufferSize);
+    writer_ = shm_ring_attach(dup(shm_ring_get_mem_fd(reader_)),
+                              dup(shm_ring_get_event_fd(reader_)));
+  }
+  ~RingTransport() override {
+    shm_ring_free(writer_);
+    shm_ring_free(reader_);
+  }
+  size_t Write(const uint8_t* p, size_t length) override {
+    return shm_ring_write(writer_, p, length);
+  }
+  size_t Read(uint8_t* p, size_t length) override {
+    return shm_ring_read_wait(reader_, p, length, 100);
+  }
+
+ private:
+  shm_ring_t* reader_;
+  shm_ring_t* writer_;
+};
+
+struct StreamResult {
+  size_t chunks = 0;
+  double latency_p50_us = 0;
+  double latency_p99_us = 0;
+  double writer_cpu_ms = 0;
+  double reader_cpu_ms = 0;
+  bool intact = true;
+};
+
+// Streams |audio_ms| of audio in |chunk_ms| chunks. When |paced| the writer
+// follows the audio clock, otherwise it writes as fast as the reader drains.
+StreamResult Stream(PcmTransport* transport, int audio_ms, int chunk_ms,
+                    bool paced) {
+  const size_t chunk_size = kBytesPerSec * chunk_ms / 1000;
+  const size_t num_chunks = audio_ms / chunk_ms;
+  StreamResult result;
+  std::vector<double> latencies;
+  latencies.reserve(num_chunks);
+
+  std::thread reader([&]() {
+    uint64_t cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    std::vector<uint8_t> chunk(chunk_size);
+    for (size_t i = 0; i < num_chunks; i++) {
+      if (transport->Read(chunk.data(), chunk_size) != chunk_size) {
+        result.intact = false;
+        break;
+      }
+      uint64_t sent_ns;
+      memcpy(&sent_ns, chunk.data(), sizeof(sent_ns));
+      latencies.push_back((now_ns(CLOCK_MONOTONIC) - sent_ns) / 1000.0);
+      if (chunk[chunk_size - 1] != (uint8_t)i) result.intact = false;
+    }
+    result.reader_cpu_ms =
+        (now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1000000.0;
+  });
+
+  uint64_t cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+  uint64_t start_ns = now_ns(CLOCK_MONOTONIC);
+  std::vector<uint8_t> chunk(chunk_size, 0);
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (paced) {
+      uint64_t due_ns = start_ns + i * chunk_ms * 1000000ULL;
+      uint64_t now = now_ns(CLOCK_MONOTONIC);
+      if (due_ns > now) usleep((due_ns - now) / 1000);
+    }
+    uint64_t sent_ns = now_ns(CLOCK_MONOTONIC);
+    memcpy(chunk.data(), &sent_ns, sizeof(sent_ns));
+    chunk[chunk_size - 1] = (uint8_t)i;
+    size_t done = 0;
+    while (done < chunk_size) {
+      size_t n = transport->Write(chunk.data() + done, chunk_size - done);
+      if (n == 0) usleep(1000);
+      done += n;
+    }
+  }
+  result.writer_cpu_ms =
+      (now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1000000.0;
+  reader.join();
+
+  result.chunks = latencies.size();
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    result.latency_p50_us = latencies[latencies.size() / 2];
+    result.latency_p99_us = latencies[latencies.size() * 99 / 100];
+  }
+  return result;
+}
+
+void PrintResult(const char* name, const StreamResult& result) {
+  printf(
+      "%-22s chunks %5zu latency p50 %8.1f us p99 %8.1f us cpu writer %7.2f "
+      "ms reader %7.2f ms\n",
+      name, result.chunks, result.latency_p50_us, result.latency_p99_us,
+      result.writer_cpu_ms, result.reader_cpu_ms);
+}
+
+}  // namespace
+
+TEST_F(ShmRingTest, test_stream_48k_stereo_paced) {
+  SocketTransport socket_transport;
+  RingTransport ring_transport;
+  StreamResult socket_result = Stream(&socket_transport, 1000, 5, true);
+  StreamResult ring_result = Stream(&ring_transport, 1000, 5, true);
+  PrintResult("socket (paced 1 s)", socket_result);
+  PrintResult("shm ring (paced 1 s)", ring_result);
+  EXPECT_TRUE(socket_result.intact);
+  EXPECT_TRUE(ring_result.intact);
+  EXPECT_EQ((size_t)200, ring_result.chunks);
+}
+
+TEST_F(ShmRingTest, test_stream_48k_stereo_bulk) {
+  SocketTransport socket_transport;
+  RingTransport ring_transport;
+  StreamResult socket_result = Stream(&socket_transport, 120000, 20, false);
+  StreamResult ring_result = Stream(&ring_transport, 120000, 20, false);
+  PrintResult("socket (2 min bulk)", socket_result);
+  PrintResult("shm ring (2 min bulk)", ring_result);
+  EXPECT_TRUE(socket_result.intact);
+  EXPECT_TRUE(ring_result.intact);
+  EXPECT_EQ((size_t)6000, ring_result.chunks);
+}
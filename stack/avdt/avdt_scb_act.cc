@@ -1321,6 +1321,7 @@ void avdt_scb_hdl_write_req(tAVDT_SCB* p_scb, tAVDT_SCB_EVT* p_data) {
     AVDT_TRACE_DEBUG("%s:add rtp header",__func__);
     if (p_data->apiwrite.p_buf->offset < AVDT_MEDIA_HDR_SIZE) {
       android_errorWriteWithInfoLog(0x534e4554, "242535997", -1, NULL, 0);
+      osi_free_and_reset((void**)&p_data->apiwrite.p_buf);
       return;
     }
     ssrc = avdt_scb_gen_ssrc(p_scb);
@@ -179,6 +179,7 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
   if (p_dev_rec == NULL) return false;
   if (p_dev_rec->ble.pseudo_addr.IsEmpty()) {
     p_dev_rec->ble.pseudo_addr = new_pseudo_addr;
+    btm_sec_dev_index_update(p_dev_rec);
     return true;
   }
 
@@ -286,21 +287,16 @@ tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
 tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr(const RawAddress& bd_addr,
                                                 uint8_t addr_type) {
 #if (BLE_PRIVACY_SPT == TRUE)
-  list_node_t* end = list_end(btm_cb.sec_dev_rec);
-  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
-       node = list_next(node)) {
-    tBTM_SEC_DEV_REC* p_dev_rec =
-        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
-    if (p_dev_rec != NULL && p_dev_rec->ble.identity_addr == bd_addr) {
-      if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
-          (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
-        BTM_TRACE_WARNING(
-            "%s find pseudo->random match with diff addr type: %d vs %d",
-            __func__, p_dev_rec->ble.identity_addr_type, addr_type);
-
-      /* found the match */
-      return p_dev_rec;
-    }
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev_by_identity(bd_addr);
+  if (p_dev_rec != NULL) {
+    if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
+        (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
+      BTM_TRACE_WARNING(
+          "%s find pseudo->random match with diff addr type: %d vs %d",
+          __func__, p_dev_rec->ble.identity_addr_type, addr_type);
+
+    /* found the match */
+    return p_dev_rec;
   }
 #endif
 
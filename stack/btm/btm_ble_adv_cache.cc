@@ -0,0 +1,177 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btm_ble_adv_cache.h"
+
+#include <string.h>
+
+const uint16_t AdvertisingCache::kNone;
+
+AdvertisingCache::AdvertisingCache(size_t capacity, size_t max_data_len)
+    : capacity_(capacity),
+      max_data_len_(max_data_len),
+      data_(capacity * max_data_len),
+      entries_(capacity),
+      head_(kNone),
+      tail_(kNone),
+      size_(0),
+      stats_() {
+  size_t buckets = 1;
+  bucket_shift_ = 64;
+  while (buckets < capacity * 2) {
+    buckets <<= 1;
+    bucket_shift_--;
+  }
+  buckets_.assign(buckets, kNone);
+  bucket_mask_ = buckets - 1;
+
+  free_.reserve(capacity);
+  for (size_t i = capacity; i > 0; i--) free_.push_back(i - 1);
+}
+
+uint64_t AdvertisingCache::Key(uint8_t addr_type, const RawAddress& addr,
+                               uint8_t sid) {
+  uint64_t key = 0;
+  for (size_t i = 0; i < RawAddress::kLength; i++)
+    key = (key << 8) | addr.address[i];
+  return (key << 16) | ((uint64_t)addr_type << 8) | sid;
+}
+
+size_t AdvertisingCache::Bucket(uint64_t key) const {
+  return (size_t)((key * 0x9E3779B97F4A7C15ull) >> bucket_shift_) &
+         bucket_mask_;
+}
+
+uint16_t AdvertisingCache::Find(uint64_t key) const {
+  for (size_t i = Bucket(key);; i = (i + 1) & bucket_mask_) {
+    uint16_t entry = buckets_[i];
+    if (entry == kNone || entries_[entry].key == key) return entry;
+  }
+}
+
+uint16_t AdvertisingCache::Insert(uint64_t key) {
+  if (free_.empty()) {
+    Release(tail_);
+    stats_.evicted++;
+  }
+
+  uint16_t entry = free_.back();
+  free_.pop_back();
+  entries_[entry].key = key;
+  entries_[entry].len = 0;
+  PushFront(entry);
+
+  size_t i = Bucket(key);
+  while (buckets_[i] != kNone) i = (i + 1) & bucket_mask_;
+  buckets_[i] = entry;
+  size_++;
+  return entry;
+}
+
+void AdvertisingCache::Release(uint16_t entry) {
+  size_t i = Bucket(entries_[entry].key);
+  while (buckets_[i] != entry) i = (i + 1) & bucket_mask_;
+
+  // Shift the rest of the probe run back so lookups need no tombstones
+  for (size_t j = (i + 1) & bucket_mask_; buckets_[j] != kNone;
+       j = (j + 1) & bucket_mask_) {
+    size_t home = Bucket(entries_[buckets_[j]].key);
+    bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+    if (movable) {
+      buckets_[i] = buckets_[j];
+      i = j;
+    }
+  }
+  buckets_[i] = kNone;
+
+  Unlink(entry);
+  free_.push_back(entry);
+  size_--;
+}
+
+void AdvertisingCache::Unlink(uint16_t entry) {
+  Entry& e = entries_[entry];
+  if (e.prev != kNone)
+    entries_[e.prev].next = e.next;
+  else
+    head_ = e.next;
+  if (e.next != kNone)
+    entries_[e.next].prev = e.prev;
+  else
+    tail_ = e.prev;
+}
+
+void AdvertisingCache::PushFront(uint16_t entry) {
+  Entry& e = entries_[entry];
+  e.prev = kNone;
+  e.next = head_;
+  if (head_ != kNone) entries_[head_].prev = entry;
+  head_ = entry;
+  if (tail_ == kNone) tail_ = entry;
+}
+
+AdvertisingCache::Result AdvertisingCache::Add(
+    uint8_t addr_type, const RawAddress& addr, uint8_t sid, bool start,
+    bool more, bool hold, const uint8_t* data, size_t len, Data* out) {
+  uint64_t key = Key(addr_type, addr, sid);
+  uint16_t entry = Find(key);
+  stats_.reports++;
+
+  if (start && entry != kNone) {
+    Release(entry);
+    entry = kNone;
+  }
+
+  if (entry == kNone) {
+    // The report carries all of the data; hand it out in place
+    if (!more && !hold) {
+      out->data = data;
+      out->len = len;
+      return kComplete;
+    }
+    if (len > max_data_len_) {
+      stats_.dropped++;
+      return kDropped;
+    }
+    entry = Insert(key);
+  } else {
+    if (entries_[entry].len + len > max_data_len_) {
+      Release(entry);
+      stats_.dropped++;
+      return kDropped;
+    }
+    Unlink(entry);
+    PushFront(entry);
+  }
+
+  Entry& e = entries_[entry];
+  if (len != 0) memcpy(Buffer(entry) + e.len, data, len);
+  e.len += len;
+  if (more || hold) return kPending;
+
+  // The buffer stays intact until the entry is reused by a later Add()
+  out->data = Buffer(entry);
+  out->len = e.len;
+  Release(entry);
+  stats_.reassembled++;
+  return kComplete;
+}
+
+void AdvertisingCache::Clear(uint8_t addr_type, const RawAddress& addr,
+                             uint8_t sid) {
+  uint16_t entry = Find(Key(addr_type, addr, sid));
+  if (entry != kNone) Release(entry);
+}
+
+void AdvertisingCache::ClearAll() {
+  while (head_ != kNone) Release(head_);
+}
+
+AdvertisingCache::Stats AdvertisingCache::TakeStats() {
+  Stats stats = stats_;
+  stats_ = Stats();
+  return stats;
+}
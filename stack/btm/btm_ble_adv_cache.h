@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "raw_address.h"
+
+// Reassembles advertising data that spans several reports: legacy advertising
+// followed by its scan response, and extended or periodic advertising chained
+// on the secondary channel. Devices are keyed by address and advertising SID.
+//
+// All storage is allocated at construction. When every entry is in use the
+// least recently updated one is evicted. Not thread safe.
+class AdvertisingCache {
+ public:
+  // Reassembled data. Valid until the cache is next modified.
+  struct Data {
+    const uint8_t* data;
+    size_t len;
+  };
+
+  enum Result {
+    kComplete,  // |out| holds the whole data of the device
+    kPending,   // waiting for more reports from the device
+    kDropped,   // the data exceeded |max_data_len| and was discarded
+  };
+
+  // Counters since the last call to TakeStats().
+  struct Stats {
+    uint32_t reports;
+    uint32_t reassembled;  // completed from more than one report
+    uint32_t evicted;
+    uint32_t dropped;
+  };
+
+  AdvertisingCache(size_t capacity, size_t max_data_len);
+
+  // Feeds the |len| bytes of advertising data of one report from |addr_type,
+  // addr, sid|.
+  // |start|: the report begins a new advertising event, so data already
+  //     cached for the device is discarded.
+  // |more|: more reports carrying data of this event follow.
+  // |hold|: the data is complete but must be kept until a later report, e.g.
+  //     the scan response, is appended to it.
+  // On kComplete |out| points at |data| itself when the report carried all of
+  // it, or into the cache otherwise; the device entry is released either way.
+  Result Add(uint8_t addr_type, const RawAddress& addr, uint8_t sid,
+             bool start, bool more, bool hold, const uint8_t* data,
+             size_t len, Data* out);
+
+  // Discards the data cached for |addr_type, addr, sid|.
+  void Clear(uint8_t addr_type, const RawAddress& addr, uint8_t sid);
+
+  void ClearAll();
+
+  size_t size() const { return size_; }
+
+  Stats TakeStats();
+
+ private:
+  static const uint16_t kNone = 0xFFFF;
+
+  struct Entry {
+    uint64_t key;
+    size_t len;
+    uint16_t prev;  // towards the most recently updated entry
+    uint16_t next;
+  };
+
+  static uint64_t Key(uint8_t addr_type, const RawAddress& addr, uint8_t sid);
+  size_t Bucket(uint64_t key) const;
+  uint16_t Find(uint64_t key) const;
+  uint16_t Insert(uint64_t key);
+  void Release(uint16_t entry);
+  void Unlink(uint16_t entry);
+  void PushFront(uint16_t entry);
+  uint8_t* Buffer(uint16_t entry) { return &data_[entry * max_data_len_]; }
+
+  const size_t capacity_;
+  const size_t max_data_len_;
+  std::vector<uint8_t> data_;
+  std::vector<Entry> entries_;
+  std::vector<uint16_t> free_;
+  // Open addressing index of entries by key, at most half full
+  std::vector<uint16_t> buckets_;
+  size_t bucket_mask_;
+  int bucket_shift_;
+  uint16_t head_;
+  uint16_t tail_;
+  size_t size_;
+  Stats stats_;
+};
@@ -25,6 +25,7 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_ble_api.h"
+#include "btm_ble_batchscan_reader.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
@@ -246,12 +247,19 @@ void btm_ble_read_batchscan_reports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
   btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_BATCH_SCAN_OCF, param, len, cb);
 }
 
-/* read reports. data is accumulated in |data_all|, number of records is
- * accumulated in |num_records_all| */
-void read_reports_cb(std::vector<uint8_t> data_all, uint8_t num_records_all,
-                     tBTM_BLE_SCAN_REP_CBACK cb, uint8_t* p, uint16_t len) {
+/* Response to a Read Results command: one chunk of the stored reports */
+void read_reports_cb(uint8_t* p, uint16_t len);
+
+void send_read_reports(uint8_t scan_mode) {
+  btm_ble_read_batchscan_reports(scan_mode, base::Bind(&read_reports_cb));
+}
+
+BatchScanReader batchscan_reader(send_read_reports);
+
+void read_reports_cb(uint8_t* p, uint16_t len) {
   if (len < 2) {
     BTM_TRACE_ERROR("%s: wrong length", __func__);
+    batchscan_reader.OnReadFailed(BTM_ERR_PROCESSING);
     return;
   }
 
@@ -263,11 +271,13 @@ void read_reports_cb(std::vector<uint8_t> data_all, uint8_t num_records_all,
   if (subcode != expected_opcode) {
     BTM_TRACE_ERROR("%s: bad subcode, expected: %d got: %d", __func__,
                     expected_opcode, subcode);
+    batchscan_reader.OnReadFailed(BTM_ERR_PROCESSING);
     return;
   }
 
   if (len < 4) {
     BTM_TRACE_ERROR("%s: wrong length", __func__);
+    batchscan_reader.OnReadFailed(status != 0 ? status : BTM_ERR_PROCESSING);
     return;
   }
 
@@ -278,20 +288,7 @@ void read_reports_cb(std::vector<uint8_t> data_all, uint8_t num_records_all,
   BTM_TRACE_DEBUG("%s: status=%d,len=%d,rec=%d", __func__, status, len - 4,
                   num_records);
 
-  if (num_records == 0) {
-    cb.Run(status, report_format, num_records_all, data_all);
-    return;
-  }
-
-  if (len > 4) {
-    data_all.insert(data_all.end(), p, p + len - 4);
-    num_records_all += num_records;
-
-    /* More records could be in the buffer and needs to be pulled out */
-    btm_ble_read_batchscan_reports(
-        report_format, base::Bind(&read_reports_cb, std::move(data_all),
-                                  num_records_all, std::move(cb)));
-  }
+  batchscan_reader.OnChunk(status, report_format, num_records, p, len - 4);
 }
 
 /**
@@ -493,7 +490,7 @@ void BTM_BleReadScanReports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
 
   if (!can_do_batch_scan()) {
     BTM_TRACE_ERROR("Controller does not support batch scan");
-    cb.Run(BTM_ERR_PROCESSING, 0, 0, {});
+    cb.Run(BTM_ERR_PROCESSING, 0, 0, {}, true);
     return;
   }
 
@@ -508,15 +505,35 @@ void BTM_BleReadScanReports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
                              scan_mode != BTM_BLE_BATCH_SCAN_MODE_ACTI)) {
     BTM_TRACE_ERROR("Illegal read scan params: %d, %d, %d", read_scan_mode,
                     scan_mode, ble_batchscan_cb.cur_state);
-    cb.Run(BTM_ILLEGAL_VALUE, 0, 0, {});
+    cb.Run(BTM_ILLEGAL_VALUE, 0, 0, {}, true);
     return;
   }
 
-  btm_ble_read_batchscan_reports(
-      scan_mode, base::Bind(&read_reports_cb, std::vector<uint8_t>(), 0, cb));
+  batchscan_reader.Read(scan_mode, [cb](uint8_t status, uint8_t report_format,
+                                        uint8_t num_records,
+                                        std::vector<uint8_t> data, bool last) {
+    cb.Run(status, report_format, num_records, std::move(data), last);
+  });
   return;
 }
 
+/* This function is called when the consumer is done with a batch of scan
+ * reports */
+void BTM_BleScanReportsConsumed(void) {
+  batchscan_reader.Consumed();
+  if (batchscan_reader.IsReading() || batchscan_reader.BatchesInFlight() > 0)
+    return;
+
+  const BatchScanReader::Stats& stats = batchscan_reader.stats();
+  BTM_TRACE_DEBUG(
+      "%s: chunks=%llu records=%llu batches=%llu malformed bytes=%llu "
+      "pauses=%llu peak ring bytes=%zu",
+      __func__, (unsigned long long)stats.chunks,
+      (unsigned long long)stats.records, (unsigned long long)stats.batches,
+      (unsigned long long)stats.malformed_bytes,
+      (unsigned long long)stats.pauses, stats.peak_ring_bytes);
+}
+
 /* This function is called to setup the callback for tracking */
 void BTM_BleTrackAdvertiser(tBTM_BLE_TRACK_ADV_CBACK* p_track_cback,
                             tBTM_BLE_REF_VALUE ref_value) {
@@ -544,6 +561,7 @@ void BTM_BleTrackAdvertiser(tBTM_BLE_TRACK_ADV_CBACK* p_track_cback,
  **/
 void btm_ble_batchscan_init(void) {
   BTM_TRACE_EVENT(" btm_ble_batchscan_init");
+  batchscan_reader.Reset();
   memset(&ble_batchscan_cb, 0, sizeof(tBTM_BLE_BATCH_SCAN_CB));
   memset(&ble_advtrack_cb, 0, sizeof(tBTM_BLE_ADV_TRACK_CB));
   BTM_RegisterForVSEvents(btm_ble_batchscan_filter_track_adv_vse_cback, true);
@@ -555,6 +573,7 @@ void btm_ble_batchscan_init(void) {
 void btm_ble_batchscan_cleanup(void) {
   BTM_TRACE_EVENT("%s", __func__);
 
+  batchscan_reader.Reset();
   memset(&ble_batchscan_cb, 0, sizeof(tBTM_BLE_BATCH_SCAN_CB));
   memset(&ble_advtrack_cb, 0, sizeof(tBTM_BLE_ADV_TRACK_CB));
 }
@@ -0,0 +1,198 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btm_ble_batchscan_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+void BatchScanReader::Read(uint8_t scan_mode, Deliver deliver) {
+  requests_.push_back(Request{scan_mode, std::move(deliver)});
+  Pump();
+}
+
+void BatchScanReader::OnChunk(uint8_t status, uint8_t report_format,
+                              uint8_t num_records, const uint8_t* p,
+                              uint16_t len) {
+  if (!active_ || !read_pending_) return;
+  read_pending_ = false;
+  stats_.chunks++;
+  status_ = status;
+  if (status != 0 || num_records == 0) {
+    done_ = true;
+    Pump();
+    return;
+  }
+
+  report_format_ = report_format;
+  if (len > kMaxChunkBytes) {
+    stats_.malformed_bytes += len - kMaxChunkBytes;
+    len = kMaxChunkBytes;
+  }
+
+  uint8_t parsed = 0;
+  if (report_format != kFormatTruncated && report_format != kFormatFull) {
+    // Records that cannot be told apart travel as one
+    if (len > 0) {
+      Push(p, len);
+      parsed = num_records;
+      len = 0;
+    }
+  } else {
+    while (parsed < num_records && len > 0) {
+      uint16_t record_len = RecordLen(report_format, p, len);
+      if (record_len == 0) break;
+      Push(p, record_len);
+      p += record_len;
+      len -= record_len;
+      parsed++;
+    }
+  }
+  stats_.records += parsed;
+  stats_.malformed_bytes += len;
+
+  // A controller that keeps announcing records it does not send has no more
+  if (parsed == 0) done_ = true;
+  Pump();
+}
+
+void BatchScanReader::OnReadFailed(uint8_t status) {
+  if (!active_ || !read_pending_) return;
+  read_pending_ = false;
+  status_ = status;
+  done_ = true;
+  Pump();
+}
+
+void BatchScanReader::Consumed() {
+  if (in_flight_ > 0) in_flight_--;
+  Pump();
+}
+
+void BatchScanReader::Reset() {
+  requests_.clear();
+  active_ = false;
+  read_pending_ = false;
+  done_ = false;
+  paused_ = false;
+  in_flight_ = 0;
+  ring_head_ = 0;
+  ring_bytes_ = 0;
+  lens_head_ = 0;
+  ring_records_ = 0;
+}
+
+uint16_t BatchScanReader::RecordLen(uint8_t report_format, const uint8_t* p,
+                                    uint16_t len) {
+  if (len < kTruncatedRecordLen) return 0;
+  if (report_format == kFormatTruncated) return kTruncatedRecordLen;
+
+  // The advertising data and the scan response follow, each after its length
+  uint32_t record_len = kTruncatedRecordLen;
+  for (int i = 0; i < 2; i++) {
+    if (record_len >= len) return 0;
+    record_len += 1 + p[record_len];
+  }
+  if (record_len > len) return 0;
+  return (uint16_t)record_len;
+}
+
+void BatchScanReader::Push(const uint8_t* p, uint16_t len) {
+  size_t tail = (ring_head_ + ring_bytes_) % kRingBytes;
+  size_t first = std::min<size_t>(len, kRingBytes - tail);
+  memcpy(&ring_[tail], p, first);
+  memcpy(&ring_[0], p + first, len - first);
+  ring_bytes_ += len;
+  lens_[(lens_head_ + ring_records_) % kRingRecords] = len;
+  ring_records_++;
+  stats_.peak_ring_bytes = std::max(stats_.peak_ring_bytes, ring_bytes_);
+}
+
+void BatchScanReader::DeliverBatch() {
+  size_t bytes = 0;
+  size_t records = 0;
+  while (records < ring_records_ && records < UINT8_MAX) {
+    uint16_t len = lens_[(lens_head_ + records) % kRingRecords];
+    if (records > 0 && bytes + len > kBatchBytes) break;
+    bytes += len;
+    records++;
+  }
+
+  bool last = done_ && records == ring_records_;
+  std::vector<uint8_t> data(bytes);
+  if (bytes > 0) {
+    size_t first = std::min(bytes, kRingBytes - ring_head_);
+    memcpy(data.data(), &ring_[ring_head_], first);
+    memcpy(data.data() + first, &ring_[0], bytes - first);
+  }
+  ring_head_ = (ring_head_ + bytes) % kRingBytes;
+  ring_bytes_ -= bytes;
+  lens_head_ = (lens_head_ + records) % kRingRecords;
+  ring_records_ -= records;
+
+  last_delivered_ = last;
+  in_flight_++;
+  stats_.batches++;
+  // The consumer may start another read or reset the reader
+  Deliver deliver = requests_.front().deliver;
+  deliver(status_, report_format_, (uint8_t)records, std::move(data), last);
+}
+
+void BatchScanReader::StartNext() {
+  active_ = true;
+  read_pending_ = false;
+  done_ = false;
+  paused_ = false;
+  status_ = 0;
+  report_format_ = requests_.front().scan_mode;
+  last_delivered_ = false;
+}
+
+void BatchScanReader::Pump() {
+  // Deliver and send_read_ may call back in; the loop below looks at the
+  // state again after each of them.
+  if (pumping_) return;
+  pumping_ = true;
+
+  for (;;) {
+    if (!active_) {
+      if (requests_.empty()) break;
+      StartNext();
+    }
+
+    if (in_flight_ < kMaxBatchesInFlight && ring_records_ > 0 &&
+        (done_ || ring_bytes_ >= kBatchBytes)) {
+      DeliverBatch();
+      continue;
+    }
+
+    if (done_) {
+      if (ring_records_ > 0) break;
+      // The ring drained before the read ended: an empty batch ends it
+      if (!last_delivered_) {
+        if (in_flight_ >= kMaxBatchesInFlight) break;
+        DeliverBatch();
+        continue;
+      }
+      requests_.pop_front();
+      active_ = false;
+      continue;
+    }
+
+    if (read_pending_) break;
+    if (!HasRoomForChunk()) {
+      if (!paused_) stats_.pauses++;
+      paused_ = true;
+      break;
+    }
+    paused_ = false;
+    read_pending_ = true;
+    send_read_(requests_.front().scan_mode);
+  }
+
+  pumping_ = false;
+}
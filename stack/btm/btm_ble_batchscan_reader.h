@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Streams the batch scan reports stored in the controller to the scanner.
+//
+// The controller hands its reports out a chunk at a time, one chunk per Read
+// Results command. Each chunk is split into records as it arrives and the
+// records wait in a fixed-size ring. They leave it in batches of at most
+// kBatchBytes, never splitting a record. Each batch is delivered until
+// kMaxBatchesInFlight wait for Consumed(); after that the records stay in
+// the ring. Once the ring has no room for another chunk, no more chunks are
+// read until Consumed() makes room. The batch that ends a read is marked as
+// the last one; if the read ended with the ring already drained it is empty,
+// so every read, including one that finds no records, ends with exactly one
+// last batch.
+//
+// Reads requested while one is in progress start when it is done. Not
+// thread safe.
+class BatchScanReader {
+ public:
+  // Report formats of the vendor Read Results command
+  static constexpr uint8_t kFormatTruncated = 1;
+  static constexpr uint8_t kFormatFull = 2;
+
+  // Address, address type, Tx power, RSSI and timestamp
+  static constexpr uint16_t kTruncatedRecordLen = 11;
+  // Records of one chunk, after the status, subcode, format and count
+  static constexpr uint16_t kMaxChunkBytes = 252;
+  static constexpr size_t kRingBytes = 4096;
+  static constexpr size_t kRingRecords = kRingBytes / kTruncatedRecordLen + 1;
+  static constexpr size_t kBatchBytes = 1024;
+  static constexpr int kMaxBatchesInFlight = 2;
+
+  using SendRead = std::function<void(uint8_t /* scan_mode */)>;
+  using Deliver = std::function<void(
+      uint8_t /* status */, uint8_t /* report_format */,
+      uint8_t /* num_records */, std::vector<uint8_t> /* data */,
+      bool /* last */)>;
+
+  struct Stats {
+    uint64_t chunks;
+    uint64_t records;
+    uint64_t batches;
+    uint64_t malformed_bytes;  // dropped with the records they belonged to
+    uint64_t pauses;           // times reading waited for the consumer
+    size_t peak_ring_bytes;
+  };
+
+  explicit BatchScanReader(SendRead send_read)
+      : send_read_(std::move(send_read)) {}
+
+  // Reads the reports of |scan_mode| and passes them to |deliver|.
+  void Read(uint8_t scan_mode, Deliver deliver);
+
+  // The response to the last Read Results command: |len| bytes at |p| hold
+  // |num_records| records in |report_format|. No records means the
+  // controller has no more. A |status| other than 0 ends the read.
+  void OnChunk(uint8_t status, uint8_t report_format, uint8_t num_records,
+               const uint8_t* p, uint16_t len);
+
+  // The last Read Results command failed or its response was malformed.
+  void OnReadFailed(uint8_t status);
+
+  // The consumer is done with one delivered batch.
+  void Consumed();
+
+  // Drops the reads and the records without delivering them.
+  void Reset();
+
+  bool IsReading() const { return active_; }
+  size_t RingBytes() const { return ring_bytes_; }
+  size_t RingRecords() const { return ring_records_; }
+  int BatchesInFlight() const { return in_flight_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Request {
+    uint8_t scan_mode;
+    Deliver deliver;
+  };
+
+  // Length of the record at the start of |p|, or 0 if it runs past |len|.
+  static uint16_t RecordLen(uint8_t report_format, const uint8_t* p,
+                            uint16_t len);
+
+  void Push(const uint8_t* p, uint16_t len);
+  void DeliverBatch();
+  void Pump();
+  void StartNext();
+
+  bool HasRoomForChunk() const {
+    return kRingBytes - ring_bytes_ >= kMaxChunkBytes &&
+           kRingRecords - ring_records_ >=
+               kMaxChunkBytes / kTruncatedRecordLen + 1;
+  }
+
+  SendRead send_read_;
+  std::deque<Request> requests_;
+
+  // The read in progress, requests_.front()
+  bool active_ = false;
+  bool read_pending_ = false;
+  bool done_ = false;
+  bool paused_ = false;
+  uint8_t status_ = 0;
+  uint8_t report_format_ = 0;
+  bool last_delivered_ = false;
+  int in_flight_ = 0;
+
+  std::array<uint8_t, kRingBytes> ring_;
+  size_t ring_head_ = 0;  // first byte of the oldest record
+  size_t ring_bytes_ = 0;
+  std::array<uint16_t, kRingRecords> lens_;
+  size_t lens_head_ = 0;
+  size_t ring_records_ = 0;
+
+  bool pumping_ = false;
+  bool repump_ = false;
+  Stats stats_ = {};
+};
@@ -27,14 +27,15 @@
  ******************************************************************************/
 
 #include <base/logging.h>
-#include <unordered_map>
 
 #include "bt_types.h"
+#include "btm_ble_wl_sync.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
+#include "osi/include/alarm.h"
 
 extern void btm_send_hci_create_connection(
     uint16_t scan_int, uint16_t scan_win, uint8_t init_filter_policy,
@@ -44,73 +45,36 @@ extern void btm_send_hci_create_connection(
     uint8_t phy);
 extern void btm_ble_create_conn_cancel();
 void wl_remove_complete(uint8_t* p_data, uint16_t /* evt_len */);
+void wl_clear_complete(uint8_t* p_data, uint16_t /* evt_len */);
+
+// Back-to-back white list changes made within this window are sent together
+#define BTM_BLE_WL_SYNC_DELAY_MS 20
 
 // Unfortunately (for now?) we have to maintain a copy of the device whitelist
 // on the host to determine if a device is pending to be connected or not. This
 // controls whether the host should keep trying to scan for whitelisted
 // peripherals or not.
 // TODO: Move all of this to controller/le/background_list or similar?
-struct BackgroundConnection {
-  RawAddress address;
-  uint8_t addr_type;
-  bool in_controller_wl;
-  uint8_t addr_type_in_wl;
-  bool pending_removal;
-};
-
-struct BgConnHash {
-  std::size_t operator()(const RawAddress& x) const {
-    const uint8_t* a = x.address;
-    return a[0] ^ (a[1] << 8) ^ (a[2] << 16) ^ (a[3] << 24) ^ a[4] ^
-           (a[5] << 8);
-  }
-};
-
-static std::unordered_map<RawAddress, BackgroundConnection, BgConnHash>
-    background_connections;
+static WhiteListSync white_list;
+static alarm_t* wl_sync_timer;
 
 static void background_connection_add(uint8_t addr_type,
                                       const RawAddress& address) {
-  auto map_iter = background_connections.find(address);
-  if (map_iter == background_connections.end()) {
-    background_connections[address] =
-        BackgroundConnection{address, addr_type, false, 0, false};
-  } else {
-    BackgroundConnection* connection = &map_iter->second;
-    if (addr_type != connection->addr_type) {
-      VLOG(1) << __func__ << " Addr type mismatch " << address;
-      btsnd_hcic_ble_remove_from_white_list(
-        connection->addr_type_in_wl, connection->address,
-        base::Bind(&wl_remove_complete));
-      connection->addr_type = addr_type;
-      connection->in_controller_wl = false;
-    }
-    connection->pending_removal = false;
-  }
+  white_list.Add(addr_type, address);
 }
 
 static void background_connection_remove(const RawAddress& address) {
   VLOG(1) << __func__ << " : " << address;
-  auto map_iter = background_connections.find(address);
-  if (map_iter != background_connections.end()) {
-    if (map_iter->second.in_controller_wl) {
-      map_iter->second.pending_removal = true;
-    } else {
-      background_connections.erase(map_iter);
-    }
-  }
+  white_list.Remove(address);
 }
 
-static void background_connections_clear() { background_connections.clear(); }
+static void background_connections_clear() { white_list.Clear(); }
 
 static RawAddress get_bg_conn_pending_bdaddr() {
-  for (auto& map_el : background_connections) {
-    BackgroundConnection* connection = &map_el.second;
-    if (connection->pending_removal) continue;
-    const bool connected =
-        BTM_IsAclConnectionUp(connection->address, BT_TRANSPORT_LE);
+  for (auto& map_el : white_list.Wanted()) {
+    const bool connected = BTM_IsAclConnectionUp(map_el.first, BT_TRANSPORT_LE);
     if (!connected) {
-      return connection->address;
+      return map_el.first;
     }
   }
   return RawAddress::kEmpty;
@@ -118,25 +82,10 @@ static RawAddress get_bg_conn_pending_bdaddr() {
 
 
 static bool background_connections_pending() {
-  for (auto& map_el : background_connections) {
-    BackgroundConnection* connection = &map_el.second;
-    if (connection->pending_removal) continue;
-    const bool connected =
-        BTM_IsAclConnectionUp(connection->address, BT_TRANSPORT_LE);
-    if (!connected) {
-      return true;
-    }
-  }
-  return false;
+  return !get_bg_conn_pending_bdaddr().IsEmpty();
 }
 
-static int background_connections_count() {
-  int count = 0;
-  for (auto& map_el : background_connections) {
-    if (!map_el.second.pending_removal) ++count;
-  }
-  return count;
-}
+static int background_connections_count() { return white_list.WantedCount(); }
 
 /*******************************************************************************
  *
@@ -193,13 +142,9 @@ void btm_update_scanner_filter_policy(tBTM_BLE_SFP scan_policy) {
 void btm_ble_bgconn_cancel_if_disconnected(const RawAddress& bd_addr) {
   if (btm_ble_get_conn_st() != BLE_CONNECTING) return;
 
-  auto map_it = background_connections.find(bd_addr);
-  if (map_it != background_connections.end()) {
-    BackgroundConnection* connection = &map_it->second;
-    if (!connection->in_controller_wl && !connection->pending_removal &&
-        !BTM_IsAclConnectionUp(bd_addr, BT_TRANSPORT_LE)) {
-      btm_ble_stop_auto_conn();
-    }
+  if (white_list.IsWanted(bd_addr) && !white_list.IsInController(bd_addr) &&
+      !BTM_IsAclConnectionUp(bd_addr, BT_TRANSPORT_LE)) {
+    btm_ble_stop_auto_conn();
   }
 }
 
@@ -309,52 +254,93 @@ void wl_remove_complete(uint8_t* p_data, uint16_t /* evt_len */) {
   VLOG(2) << __func__ << ": status=" << loghex(status);
 }
 
+/* Returns the commands that bring the controller white list in line with the
+ * host copy */
+static WhiteListSync::Plan wl_pending_changes() {
+  /* Bluetooth Core 4.2 as well as ESR08 disallows more than one
+     connection between two LE addresses. Not all controllers handle this
+     correctly, therefore we must make sure connected devices are not in
+     the white list when bg connection attempt is active. */
+  return white_list.Reconcile([](const RawAddress& address) {
+    return BTM_IsAclConnectionUp(address, BT_TRANSPORT_LE);
+  });
+}
+
 /*******************************************************************************
  *
  * Function         btm_execute_wl_dev_operation
  *
- * Description      execute the pending whitelist device operation (loading or
- *                                                                  removing)
+ * Description      send the white list changes made since the last call, as
+ *                  the fewest add, remove and clear commands
  ******************************************************************************/
 bool btm_execute_wl_dev_operation(void) {
+  alarm_cancel(wl_sync_timer);
+
+  WhiteListSync::Plan plan = wl_pending_changes();
+  if (plan.Empty()) return true;
+
+  VLOG(1) << __func__ << ": clear " << plan.clear << ", remove "
+          << plan.remove.size() << ", add " << plan.add.size();
+
+  if (plan.clear) {
+    btsnd_hcic_ble_clear_white_list(base::Bind(&wl_clear_complete));
+  }
   // handle removals first to avoid filling up controller's white list
-  for (auto map_it = background_connections.begin();
-       map_it != background_connections.end();) {
-    BackgroundConnection* connection = &map_it->second;
-    if (connection->pending_removal) {
-      VLOG(1) << __func__ << ": Remove "<<connection->address;
-      btsnd_hcic_ble_remove_from_white_list(
-          connection->addr_type_in_wl, connection->address,
-          base::Bind(&wl_remove_complete));
-      map_it = background_connections.erase(map_it);
-    } else
-      ++map_it;
+  for (const WhiteListSync::Entry& entry : plan.remove) {
+    VLOG(1) << __func__ << ": Remove " << entry.address;
+    btsnd_hcic_ble_remove_from_white_list(entry.addr_type, entry.address,
+                                          base::Bind(&wl_remove_complete));
   }
-  for (auto& map_el : background_connections) {
-    BackgroundConnection* connection = &map_el.second;
-    const bool connected =
-        BTM_IsAclConnectionUp(connection->address, BT_TRANSPORT_LE);
-    if (!connection->in_controller_wl && !connected) {
-      VLOG(1) << __func__ << ": Add "<<connection->address;
-      btsnd_hcic_ble_add_white_list(connection->addr_type, connection->address,
-                                    base::Bind(&wl_add_complete));
-      connection->in_controller_wl = true;
-      connection->addr_type_in_wl = connection->addr_type;
-    } else if (connection->in_controller_wl && connected) {
-      /* Bluetooth Core 4.2 as well as ESR08 disallows more than one
-         connection between two LE addresses. Not all controllers handle this
-         correctly, therefore we must make sure connected devices are not in
-         the white list when bg connection attempt is active. */
-      VLOG(1) << __func__ << " Remove connected device "<<connection->address;
-      btsnd_hcic_ble_remove_from_white_list(
-          connection->addr_type_in_wl, connection->address,
-          base::Bind(&wl_remove_complete));
-      connection->in_controller_wl = false;
-    }
+  for (const WhiteListSync::Entry& entry : plan.add) {
+    VLOG(1) << __func__ << ": Add " << entry.address;
+    btsnd_hcic_ble_add_white_list(entry.addr_type, entry.address,
+                                  base::Bind(&wl_add_complete));
   }
+  white_list.Apply(plan);
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_ble_wl_sync
+ *
+ * Description      send the pending white list changes in a single suspend
+ *                  window of the background connection procedure
+ ******************************************************************************/
+static void btm_ble_wl_sync(UNUSED_ATTR void* data) {
+  switch (btm_ble_get_conn_st()) {
+    case BLE_CONN_IDLE:
+      if (!btm_ble_resume_bg_conn()) btm_execute_wl_dev_operation();
+      break;
+
+    case BLE_CONNECTING:
+      /* The list can't change while initiating. Changes are sent when auto
+         connection restarts after the cancel completes; a direct connection
+         resumes it once done. */
+      if (!(btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT)) break;
+      if (wl_pending_changes().Empty() && background_connections_pending())
+        break;
+      btm_ble_stop_auto_conn();
+      break;
+
+    default:
+      /* auto connection restarts when the cancel completes */
+      break;
+  }
+}
+
+/* Sends the white list changes BTM_BLE_WL_SYNC_DELAY_MS after the first one
+ * not yet sent, so that back-to-back requests pause the background
+ * connection procedure once. */
+static void btm_ble_schedule_wl_sync() {
+  if (wl_sync_timer == NULL) {
+    btm_ble_wl_sync(NULL);
+  } else if (!alarm_is_scheduled(wl_sync_timer)) {
+    alarm_set_on_mloop(wl_sync_timer, BTM_BLE_WL_SYNC_DELAY_MS,
+                       btm_ble_wl_sync, NULL);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_white_list_init
@@ -364,6 +350,11 @@ bool btm_execute_wl_dev_operation(void) {
  ******************************************************************************/
 void btm_ble_white_list_init(uint8_t white_list_size) {
   BTM_TRACE_DEBUG("%s white_list_size = %d", __func__, white_list_size);
+
+  /* the controller was reset, so its list is empty */
+  white_list.ControllerCleared();
+  alarm_free(wl_sync_timer);
+  wl_sync_timer = alarm_new("btm_ble.wl_sync_timer");
 }
 
 uint8_t BTM_GetWhiteListSize() {
@@ -523,31 +514,16 @@ bool BTM_WhiteListAdd(const RawAddress& address) {
     return false;
   }
 
-  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
-    btm_ble_stop_auto_conn();
-  }
   btm_add_dev_to_controller(true, address);
-  const bool connected =
-    BTM_IsAclConnectionUp(address, BT_TRANSPORT_LE);
-  BTM_TRACE_DEBUG("%s ACLUP is %d ", __func__, connected);
-  if (!connected) {
-    VLOG(1) << __func__ << ": initiating connection " << address;
-    btm_ble_resume_bg_conn();
-  } else {
-    BTM_TRACE_DEBUG(" %s Executing Whitelist operation ", __func__);
-    btm_execute_wl_dev_operation();
-  }
+  btm_ble_schedule_wl_sync();
   return true;
 }
 
 /** Removes the device from white list */
 void BTM_WhiteListRemove(const RawAddress& address) {
   VLOG(1) << __func__ << ": " << address;
-  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
-    btm_ble_stop_auto_conn();
-  }
   btm_add_dev_to_controller(false, address);
-  btm_ble_resume_bg_conn();
+  btm_ble_schedule_wl_sync();
 }
 
 /** clear white list complete */
@@ -561,6 +537,7 @@ void wl_clear_complete(uint8_t* p_data, uint16_t /* evt_len */) {
 void BTM_WhiteListClear() {
   VLOG(1) << __func__;
   if (!controller_get_interface()->supports_ble()) return;
+  alarm_cancel(wl_sync_timer);
   btm_ble_stop_auto_conn();
   btsnd_hcic_ble_clear_white_list(base::Bind(&wl_clear_complete));
   background_connections_clear();
@@ -34,7 +34,6 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
-#include <list>
 #include <vector>
 #include <map>
 
@@ -57,6 +56,7 @@
 #include "../../boringssl/src/crypto/fipsmodule/cipher/internal.h"
 
 #include "advertise_data_parser.h"
+#include "btm_ble_adv_cache.h"
 #include "btm_ble_int.h"
 #include "gatt_int.h"
 #include "gattdefs.h"
@@ -82,82 +82,13 @@
 #define BTM_VSC_CHIP_CAPABILITY_RSP_LEN_S_RELEASE 25
 #define BTM_QBCE_READ_REMOTE_QLL_SUPPORTED_FEATURE_LEN 3
 
-namespace {
-
-class AdvertisingCache {
- public:
-  /* Set the data to |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
-                                  std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  /* Append |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
-                                     std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  /* Clear data for device |addr_type, addr| */
-  void Clear(uint8_t addr_type, const RawAddress& addr) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      items.erase(it);
-    }
-  }
-
- private:
-  struct Item {
-    uint8_t addr_type;
-    RawAddress addr;
-    std::vector<uint8_t> data;
-
-    Item(uint8_t addr_type, const RawAddress& addr, std::vector<uint8_t> data)
-        : addr_type(addr_type), addr(addr), data(data) {}
-  };
-
-  std::list<Item>::iterator Find(uint8_t addr_type, const RawAddress& addr) {
-    for (auto it = items.begin(); it != items.end(); it++) {
-      if (it->addr_type == addr_type && it->addr == addr) {
-        return it;
-      }
-    }
-    return items.end();
-  }
-
-  /* we keep maximum 7 devices in the cache */
-  const size_t cache_max = 7;
-  std::list<Item> items;
-};
-
-/* Devices in this cache are waiting for eiter scan response, or chained packets
- * on secondary channel */
-AdvertisingCache cache;
-AdvertisingCache periodicCache;
-
-}  // namespace
+/* Advertising data of an extended advertising event, Core 5.x Vol 6 Part B
+ * 2.3.4.9 */
+#define BTM_BLE_ADV_DATA_MAX_LEN 1650
+/* Devices waiting for a scan response or chained reports at a time */
+#define BTM_BLE_ADV_CACHE_SIZE 64
+/* Period of the advertising report summary in the log */
+#define BTM_BLE_ADV_STATS_LOG_PERIOD_MS (10 * 1000)
 
 #if (BLE_VND_INCLUDED == TRUE)
 static tBTM_BLE_CTRL_FEATURES_CBACK* p_ctrl_le_feature_rd_cmpl_cback = NULL;
@@ -236,6 +167,34 @@ static bool syncRcvdCbRegistered = false;
 static int btm_ble_get_psync_index(uint8_t adv_sid, RawAddress addr);
 static void btm_ble_start_sync_timeout(void *data);
 
+namespace {
+
+/* Devices in this cache are waiting for eiter scan response, or chained packets
+ * on secondary channel */
+AdvertisingCache cache(BTM_BLE_ADV_CACHE_SIZE, BTM_BLE_ADV_DATA_MAX_LEN);
+AdvertisingCache periodicCache(MAX_SYNC_TRANSACTION, BTM_BLE_ADV_DATA_MAX_LEN);
+
+uint64_t cache_log_time_ms;
+uint64_t periodic_cache_log_time_ms;
+
+/* Logs what the advertising report path did at most once per
+ * BTM_BLE_ADV_STATS_LOG_PERIOD_MS, instead of a line per report */
+void btm_ble_log_adv_stats(AdvertisingCache& adv_cache, const char* name,
+                           uint64_t* log_time_ms) {
+  uint64_t now_ms = time_get_os_boottime_ms();
+  if (now_ms - *log_time_ms < BTM_BLE_ADV_STATS_LOG_PERIOD_MS) return;
+  *log_time_ms = now_ms;
+
+  AdvertisingCache::Stats stats = adv_cache.TakeStats();
+  if (stats.reports == 0) return;
+  LOG(INFO) << name << ": " << stats.reports << " reports, "
+            << stats.reassembled << " reassembled, " << stats.evicted
+            << " evicted, " << stats.dropped << " dropped, "
+            << adv_cache.size() << " pending";
+}
+
+}  // namespace
+
 /*****************************/
 /*******************************************************************************
  *  Local functions
@@ -1472,26 +1431,25 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
   BTM_TRACE_DEBUG("[PSync]%s",__func__);
   uint8_t tx_power, rssi, cte_type, data_status, data_len;
   uint16_t sync_handle;
-  std::vector<uint8_t> data;
-  std::vector<uint8_t> tmp;
-  uint8_t periodic_data[255] = {0};
   uint8_t *p = param;
+  if (param_len < 7) {
+    BTM_TRACE_ERROR("[PSync]%s: malformed report, len %d", __func__, param_len);
+    return;
+  }
   STREAM_TO_UINT16(sync_handle, p);
   STREAM_TO_INT8(tx_power, p);
   STREAM_TO_INT8(rssi, p);
   STREAM_TO_UINT8(cte_type, p);
   STREAM_TO_UINT8(data_status, p);
   STREAM_TO_UINT8(data_len, p);
-  STREAM_TO_ARRAY(periodic_data, p, data_len);
   BTM_TRACE_DEBUG("[PSync]%s: sync_handle = %d, tx_power = %d, rssi = %d,"
                "cte_type = %d, data_status = %d, data_len = %d", __func__,
                 sync_handle, tx_power, rssi, cte_type, data_status, data_len);
-
-  for(int i = 0;i < data_len; i++) {
-    data.push_back(periodic_data[i]);
+  if (param_len < 7 + data_len) {
+    BTM_TRACE_ERROR("[PSync]%s: malformed report, len %d data_len %d",
+                    __func__, param_len, data_len);
+    return;
   }
-  if (data_len != 0) tmp.insert(tmp.begin(), data.begin(), data.end());
-
 
   int index = btm_ble_get_psync_index_from_handle(sync_handle);
   if (index == MAX_SYNC_TRANSACTION) {
@@ -1500,30 +1458,29 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
   }
   tBTM_BLE_PERIODIC_SYNC *ps = &btm_ble_pa_sync_cb.p_sync[index];
 
-  data = periodicCache.Append(ps->address_type, ps->remote_bda, std::move(tmp));
-  bool data_complete;
-  if (data_status == 0x01) {
-    LOG(INFO) << __func__ << " Data not complete yet, waiting for more " << ps->remote_bda;
-    data_complete = false;
-  } else if (data_status == 0x02) {
-    LOG(INFO) << __func__ << " Data not complete yet, No More Data Coming " << ps->remote_bda;
-    periodicCache.Clear(ps->address_type, ps->remote_bda);
-    data_complete = false;
-  } else {
-    LOG(INFO) << __func__ << " Data Complete: " << ps->remote_bda;
-    data_complete = true;
-  }
-  if(!data_complete) {
-    LOG(INFO) << "Data not complete yet, waiting for more " << ps->remote_bda
-              << " Data Status: " << loghex(data_status);
+  btm_ble_log_adv_stats(periodicCache, "periodic advertising",
+                        &periodic_cache_log_time_ms);
+  if (data_status == 0x02) {
+    VLOG(1) << __func__ << " Data not complete yet, No More Data Coming "
+            << ps->remote_bda;
+    periodicCache.Clear(ps->address_type, ps->remote_bda, ps->sid);
     return;
   }
 
+  AdvertisingCache::Data adv;
+  AdvertisingCache::Result result = periodicCache.Add(
+      ps->address_type, ps->remote_bda, ps->sid, false /* start */,
+      data_status == 0x01 /* more */, false /* hold */, p, data_len, &adv);
+  if (result != AdvertisingCache::kComplete) {
+    VLOG(1) << "Data not complete yet, waiting for more " << ps->remote_bda
+            << " Data Status: " << loghex(data_status);
+    return;
+  }
+  std::vector<uint8_t> data(adv.data, adv.data + adv.len);
 
   bool encrypted_data = false;
   bool is_decrypt_success = false;
   uint8_t len1;
-  std::vector<uint8_t> decrypted_data = data;
   std::map<int, int> enc_adv_data_map;
   if (btm_cb.enc_adv_data_log_enabled) {
     VLOG(1) << __func__ << " encrypted_data:" << encrypted_data;
@@ -1551,22 +1508,21 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
                   << base::HexEncode(data.data(), data.size());
       }
 
-      decrypted_data = btm_ble_process_encrypted_adv(ps->remote_bda, data, &is_decrypt_success,
-          enc_adv_data_map);
+      data = btm_ble_process_encrypted_adv(ps->remote_bda, std::move(data),
+          &is_decrypt_success, enc_adv_data_map);
       if (!is_decrypt_success) {
         VLOG(1) << __func__ << " Decryption NOT successful, return:";
       }
 
       if (btm_cb.enc_adv_data_log_enabled) {
         LOG(INFO) << " PA data after decryption: "
-                  << base::HexEncode(decrypted_data.data(), decrypted_data.size());
+                  << base::HexEncode(data.data(), data.size());
       }
     }
   }
 
   BTM_TRACE_DEBUG("[PSync]%s: invoking callback", __func__);
-  periodicCache.Clear(ps->address_type, ps->remote_bda);
-  ps->sync_report_cb.Run(sync_handle, tx_power, rssi, data_status, decrypted_data);
+  ps->sync_report_cb.Run(sync_handle, tx_power, rssi, data_status, std::move(data));
 }
 
 /*******************************************************************************
@@ -2726,8 +2682,8 @@ static void btm_ble_update_adv_flag(uint8_t flag) {
  * Check ADV flag to make sure device is discoverable and match the search
  * condition
  */
-uint8_t btm_ble_is_discoverable(const RawAddress& bda,
-                                std::vector<uint8_t> const& adv_data) {
+uint8_t btm_ble_is_discoverable(const RawAddress& bda, const uint8_t* adv_data,
+                                size_t adv_data_len) {
   uint8_t flag = 0, rt = 0;
   uint8_t data_len;
   tBTM_INQ_PARMS* p_cond = &btm_cb.btm_inq_vars.inqparms;
@@ -2743,9 +2699,9 @@ uint8_t btm_ble_is_discoverable(const RawAddress& bda,
     return rt;
   }
 
-  if (!adv_data.empty()) {
+  if (adv_data_len != 0) {
     const uint8_t* p_flag = AdvertiseDataParser::GetFieldByType(
-        adv_data, BTM_BLE_AD_TYPE_FLAG, &data_len);
+        adv_data, adv_data_len, BTM_BLE_AD_TYPE_FLAG, &data_len);
     if (p_flag != NULL && data_len != 0) {
       flag = *p_flag;
 
@@ -2943,7 +2899,7 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
                                uint8_t primary_phy, uint8_t secondary_phy,
                                uint8_t advertising_sid, int8_t tx_power,
                                int8_t rssi, uint16_t periodic_adv_int,
-                               std::vector<uint8_t> const& data) {
+                               const uint8_t* data, size_t data_len) {
   tBTM_INQ_RESULTS* p_cur = &p_i->inq_info.results;
   uint8_t len;
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
@@ -2976,13 +2932,13 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
 
   p_i->inq_count = p_inq->inq_counter; /* Mark entry for current inquiry */
 
-  if (!data.empty()) {
-    const uint8_t* p_flag =
-        AdvertiseDataParser::GetFieldByType(data, BTM_BLE_AD_TYPE_FLAG, &len);
+  if (data_len != 0) {
+    const uint8_t* p_flag = AdvertiseDataParser::GetFieldByType(
+        data, data_len, BTM_BLE_AD_TYPE_FLAG, &len);
     if (p_flag != NULL && len != 0) p_cur->flag = *p_flag;
   }
 
-  if (!data.empty()) {
+  if (data_len != 0) {
 
     VLOG(2) << __func__ << " parsing ADV data ";
     /* Check to see the BLE device has the Appearance UUID in the advertising
@@ -2993,13 +2949,13 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
      * service class.
      */
     const uint8_t* p_uuid16 = AdvertiseDataParser::GetFieldByType(
-        data, BTM_BLE_AD_TYPE_APPEARANCE, &len);
+        data, data_len, BTM_BLE_AD_TYPE_APPEARANCE, &len);
     if (p_uuid16 && len == 2) {
       btm_ble_appearance_to_cod((uint16_t)p_uuid16[0] | (p_uuid16[1] << 8),
                                 p_cur->dev_class);
     } else {
       p_uuid16 = AdvertiseDataParser::GetFieldByType(
-          data, BTM_BLE_AD_TYPE_16SRV_CMPL, &len);
+          data, data_len, BTM_BLE_AD_TYPE_16SRV_CMPL, &len);
       if (p_uuid16 != NULL) {
         uint8_t i;
         for (i = 0; i + 2 <= len; i = i + 2) {
@@ -3030,7 +2986,7 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
     }
 #ifdef ADV_AUDIO_FEATURE
     bool is_adv_audio_support = parse_adv_audio_uuids_from_adv_pkt
-      (data.data(),data.size(), 0x16);
+      (data, data_len, 0x16);
     if (controller_get_interface()->is_adv_audio_supported()) {
       /* if this BLE device support ADV AUDIO over LE, set ADV AUDIO Major
        * in class of device */
@@ -3070,16 +3026,16 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
  *
  ******************************************************************************/
 void btm_clear_all_pending_le_entry(void) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    /* mark all pending LE entry as unused if an LE only device has scan
-     * response outstanding */
-    if ((p_ent->in_use) &&
-        (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
+  tINQ_DB_ENT* p_ent = btm_inq_db_first();
+
+  while (p_ent) {
+    tINQ_DB_ENT* p_next = btm_inq_db_next(p_ent);
+    /* remove all pending LE entries if an LE only device has scan response
+     * outstanding */
+    if ((p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
         !p_ent->scan_rsp)
-      p_ent->in_use = false;
+      btm_inq_db_remove(p_ent);
+    p_ent = p_next;
   }
 }
 
@@ -3295,9 +3251,8 @@ static void btm_ble_process_adv_pkt_cont(
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
   VLOG(1) << __func__ << "bda:" << bda;
-  std::vector<uint8_t> tmp;
-  std::vector<uint8_t> adv_data_decrypted;
-  if (data_len != 0) tmp.insert(tmp.begin(), data, data + data_len);
+
+  btm_ble_log_adv_stats(cache, "advertising", &cache_log_time_ms);
 
   bool is_scannable = ble_evt_type_is_scannable(evt_type);
   bool is_scan_resp = ble_evt_type_is_scan_resp(evt_type);
@@ -3305,97 +3260,96 @@ static void btm_ble_process_adv_pkt_cont(
   bool is_start =
       ble_evt_type_is_legacy(evt_type) && is_scannable && !is_scan_resp;
 
+  size_t report_len = data_len;
   if (ble_evt_type_is_legacy(evt_type))
-    AdvertiseDataParser::RemoveTrailingZeros(tmp);
+    report_len = AdvertiseDataParser::RemoveTrailingZeros(data, report_len);
+
+  bool is_active_scan =
+      btm_cb.ble_ctr_cb.inq_var.scan_type == BTM_BLE_SCAN_MODE_ACTI;
+  // If we didn't receive scan response yet, keep the data for it and don't
+  // report the device.
+  bool wait_scan_rsp = is_active_scan && is_scannable && !is_scan_resp;
 
   // We might have send scan request to this device before, but didn't get the
   // response. In such case make sure data is put at start, not appended to
   // already existing data.
-  std::vector<uint8_t> adv_data =
-        is_start ? cache.Set(addr_type, bda, std::move(tmp))
-                 : cache.Append(addr_type, bda, std::move(tmp));
-  bool data_complete;
-  if (ble_evt_type_data_status(evt_type) == 0x01) {
-    LOG(INFO) << __func__ <<  " Data not complete yet, waiting for more " << bda;
-    data_complete = false;
-  } else if (ble_evt_type_data_status(evt_type) == 0x10) {
-    LOG(INFO) << __func__ << " Data not complete yet, No More Data Coming " << bda;
-    data_complete = false;
-    cache.Clear(addr_type, bda);
-  } else {
-    LOG(INFO) << __func__ << " Data Complete " << bda;
-    data_complete = true;
-  }
-  if (!data_complete) {
+  AdvertisingCache::Data adv;
+  AdvertisingCache::Result cache_result =
+      cache.Add(addr_type, bda, advertising_sid, is_start,
+                ble_evt_type_data_status(evt_type) == 0x01, wait_scan_rsp,
+                data, report_len, &adv);
+  if (cache_result == AdvertisingCache::kDropped) {
+    VLOG(1) << __func__ << " Advertising data too long, dropped " << bda;
     return;
   }
-
-  bool is_active_scan =
-      btm_cb.ble_ctr_cb.inq_var.scan_type == BTM_BLE_SCAN_MODE_ACTI;
-  if (is_active_scan && is_scannable && !is_scan_resp) {
-    // If we didn't receive scan response yet, don't report the device.
-    VLOG(1) << " Waiting for scan response " << bda;
+  if (cache_result == AdvertisingCache::kPending) {
+    VLOG(1) << __func__ << " Data not complete yet, waiting for more " << bda;
     return;
   }
+  VLOG(1) << __func__ << " Data Complete " << bda;
+
+  const uint8_t* adv_data = adv.data;
+  size_t adv_data_len = adv.len;
+  std::vector<uint8_t> decrypted_data;
 
   bool encrypted_data = false;
   bool is_decrypt_success = false;
   uint8_t len1;
-  int len_enc_data;
-  int enc_data_begin_index = 0;
   std::map<int, int> enc_adv_data_map;
-  std::map<int, std::vector<uint8_t>> decrypted_data_map;
   VLOG(1) << __func__ << "encrypted_data:" << encrypted_data;
-  if(AdvertiseDataParser::GetFieldByType(adv_data, BTM_BLE_AD_TYPE_ED, &len1)){
-    if(!AdvertiseDataParser::IsValid(adv_data)){
+  if (AdvertiseDataParser::GetFieldByType(adv_data, adv_data_len,
+                                          BTM_BLE_AD_TYPE_ED, &len1)) {
+    if (!AdvertiseDataParser::IsValid(adv_data, adv_data_len)) {
         VLOG(1) << __func__ << "Dropping bad advertisement packet: "
-                << base::HexEncode(adv_data.data(), adv_data.size());
+                << base::HexEncode(adv_data, adv_data_len);
       return;
     }
     encrypted_data = true;
     if (btm_cb.enc_adv_data_log_enabled) {
       VLOG(1) << __func__ << "FOUND ENCRYPTED DATA: "
-              << base::HexEncode(adv_data.data(), adv_data.size());
+              << base::HexEncode(adv_data, adv_data_len);
     }
 
     enc_adv_data_map =
-        AdvertiseDataParser::GetEncAdvFieldsInfo(adv_data.data(), adv_data.size());
+        AdvertiseDataParser::GetEncAdvFieldsInfo(adv_data, adv_data_len);
   }
   if (btm_cb.enc_adv_data_enabled) {
     if (encrypted_data) {
       if (btm_cb.enc_adv_data_log_enabled) {
         LOG(INFO) << " Adv data before decryption: "
-                  << base::HexEncode(adv_data.data(), adv_data.size());
+                  << base::HexEncode(adv_data, adv_data_len);
       }
 
-      std::vector<uint8_t> decrypted_data =
-          btm_ble_process_encrypted_adv(bda, adv_data, &is_decrypt_success, enc_adv_data_map);
+      decrypted_data = btm_ble_process_encrypted_adv(
+          bda, std::vector<uint8_t>(adv_data, adv_data + adv_data_len),
+          &is_decrypt_success, enc_adv_data_map);
       if (!is_decrypt_success) {
         VLOG(1) << __func__ << " Decryption NOT successful, return:";
       }
 
       if (!decrypted_data.empty()) {
         LOG(INFO) << " decrypted_data is not empty: ";
-        adv_data.clear();
-        adv_data.insert(adv_data.begin(), decrypted_data.begin(), decrypted_data.end());
+        adv_data = decrypted_data.data();
+        adv_data_len = decrypted_data.size();
       }
     }
   }
 
   if (btm_cb.enc_adv_data_log_enabled) {
     LOG(INFO) << " Adv data after decryption: "
-              << base::HexEncode(adv_data.data(), adv_data.size());
+              << base::HexEncode(adv_data, adv_data_len);
   }
 
-  if (!AdvertiseDataParser::IsValid(adv_data)) {
+  if (!AdvertiseDataParser::IsValid(adv_data, adv_data_len)) {
     VLOG(1) << __func__ << "Dropping bad advertisement packet: "
-            << base::HexEncode(adv_data.data(), adv_data.size());
+            << base::HexEncode(adv_data, adv_data_len);
     return;
   }
 
   bool include_rsi = false;
   uint8_t len;
-  if (AdvertiseDataParser::GetFieldByType(adv_data, BTM_BLE_AD_TYPE_RSI, &len)) {
+  if (AdvertiseDataParser::GetFieldByType(adv_data, adv_data_len,
+                                          BTM_BLE_AD_TYPE_RSI, &len)) {
     include_rsi = true;
   }
 
@@ -3444,11 +3398,12 @@ static void btm_ble_process_adv_pkt_cont(
   }
 
   p_i->time_of_resp = time_get_os_boottime_ms();
+  btm_inq_db_touch(p_i);
 
   /* update the LE device information in inquiry database */
   btm_ble_update_inq_result(p_i, addr_type, bda, evt_type, primary_phy,
                             secondary_phy, advertising_sid, tx_power, rssi,
-                            periodic_adv_int, adv_data);
+                            periodic_adv_int, adv_data, adv_data_len);
   if (include_rsi) {
     (&p_i->inq_info.results)->include_rsi = true;
   }
@@ -3456,7 +3411,8 @@ static void btm_ble_process_adv_pkt_cont(
   if (btm_cb.is_csip_opportunistic_scan_enabled && btm_cb.p_csip_scan_cb) {
       uint8_t data_len = 0;
       const uint8_t* g_data = NULL;
-      g_data = AdvertiseDataParser::GetFieldByType(adv_data, BTM_CSIP_RSI_TYPE,
+      g_data = AdvertiseDataParser::GetFieldByType(adv_data, adv_data_len,
+                                                   BTM_CSIP_RSI_TYPE,
                                                    &data_len);
       if (g_data && data_len == BTM_CSIP_RSI_LEN) {
          uint8_t gid_data[BTM_CSIP_RSI_LEN] = {};
@@ -3465,9 +3421,8 @@ static void btm_ble_process_adv_pkt_cont(
       }
   }
 
-  uint8_t result = btm_ble_is_discoverable(bda, adv_data);
+  uint8_t result = btm_ble_is_discoverable(bda, adv_data, adv_data_len);
   if (result == 0) {
-    cache.Clear(addr_type, bda);
     LOG_WARN(LOG_TAG,
              "%s device no longer discoverable, discarding advertising packet",
              __func__);
@@ -3502,7 +3457,7 @@ static void btm_ble_process_adv_pkt_cont(
   tBTM_INQ_RESULTS_CB* p_inq_results_cb = p_inq->p_inq_results_cb;
   if (p_inq_results_cb && (result & BTM_BLE_INQ_RESULT)) {
     (p_inq_results_cb)((tBTM_INQ_RESULTS*)&p_i->inq_info.results,
-                       const_cast<uint8_t*>(adv_data.data()), adv_data.size());
+                       const_cast<uint8_t*>(adv_data), adv_data_len);
   }
 
   // Pass address up to GattService#onScanResult
@@ -3511,10 +3466,8 @@ static void btm_ble_process_adv_pkt_cont(
   tBTM_INQ_RESULTS_CB* p_obs_results_cb = btm_cb.ble_ctr_cb.p_obs_results_cb;
   if (p_obs_results_cb && (result & BTM_BLE_OBS_RESULT)) {
     (p_obs_results_cb)((tBTM_INQ_RESULTS*)&p_i->inq_info.results,
-                       const_cast<uint8_t*>(adv_data.data()), adv_data.size());
+                       const_cast<uint8_t*>(adv_data), adv_data_len);
   }
-
-  cache.Clear(addr_type, bda);
 }
 
 void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* data) {
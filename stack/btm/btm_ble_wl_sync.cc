@@ -0,0 +1,56 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btm_ble_wl_sync.h"
+
+void WhiteListSync::Add(uint8_t addr_type, const RawAddress& address) {
+  wanted_[address] = addr_type;
+}
+
+void WhiteListSync::Remove(const RawAddress& address) {
+  wanted_.erase(address);
+}
+
+bool WhiteListSync::IsInController(const RawAddress& address) const {
+  auto wanted = wanted_.find(address);
+  auto held = in_controller_.find(address);
+  return wanted != wanted_.end() && held != in_controller_.end() &&
+         wanted->second == held->second;
+}
+
+WhiteListSync::Plan WhiteListSync::Reconcile(
+    const std::function<bool(const RawAddress&)>& skip) const {
+  std::unordered_map<RawAddress, uint8_t, AddressHash> target;
+  for (const auto& wanted : wanted_) {
+    if (!skip(wanted.first)) target.insert(wanted);
+  }
+
+  Plan diff = {false, {}, {}};
+  for (const auto& held : in_controller_) {
+    auto it = target.find(held.first);
+    if (it == target.end() || it->second != held.second)
+      diff.remove.push_back(Entry{held.second, held.first});
+  }
+  for (const auto& wanted : target) {
+    auto it = in_controller_.find(wanted.first);
+    if (it == in_controller_.end() || it->second != wanted.second)
+      diff.add.push_back(Entry{wanted.second, wanted.first});
+  }
+
+  if (diff.remove.size() + diff.add.size() <= 1 + target.size()) return diff;
+
+  Plan reload = {true, {}, {}};
+  for (const auto& wanted : target)
+    reload.add.push_back(Entry{wanted.second, wanted.first});
+  return reload;
+}
+
+void WhiteListSync::Apply(const Plan& plan) {
+  if (plan.clear) in_controller_.clear();
+  for (const Entry& entry : plan.remove) in_controller_.erase(entry.address);
+  for (const Entry& entry : plan.add)
+    in_controller_[entry.address] = entry.addr_type;
+}
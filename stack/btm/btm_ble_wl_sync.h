@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "raw_address.h"
+
+// Host copy of the LE white list: the devices the stack wants to connect to
+// in the background, and what the controller was last told to hold.
+//
+// Add() and Remove() only change the wanted set. Reconcile() computes the
+// commands that bring the controller in line with it, leaving out devices
+// that are already connected: the removals first, so that the list does not
+// overflow, then the additions, or a clear followed by additions when that
+// is fewer commands. Apply() records that they were sent. Not thread safe.
+class WhiteListSync {
+ public:
+  struct Entry {
+    uint8_t addr_type;
+    RawAddress address;
+  };
+
+  struct Plan {
+    bool clear;  // clear the list before the additions
+    std::vector<Entry> remove;
+    std::vector<Entry> add;
+
+    size_t Commands() const {
+      return (clear ? 1 : 0) + remove.size() + add.size();
+    }
+    bool Empty() const { return Commands() == 0; }
+  };
+
+  struct AddressHash {
+    size_t operator()(const RawAddress& x) const {
+      const uint8_t* a = x.address;
+      return a[0] ^ (a[1] << 8) ^ (a[2] << 16) ^ (a[3] << 24) ^ a[4] ^
+             (a[5] << 8);
+    }
+  };
+
+  // Wants |address| in the list with |addr_type|, replacing its type if it
+  // was wanted with another one.
+  void Add(uint8_t addr_type, const RawAddress& address);
+  void Remove(const RawAddress& address);
+
+  bool IsWanted(const RawAddress& address) const {
+    return wanted_.count(address) != 0;
+  }
+  // Returns true if the controller holds |address| with the wanted type.
+  bool IsInController(const RawAddress& address) const;
+
+  size_t WantedCount() const { return wanted_.size(); }
+  const std::unordered_map<RawAddress, uint8_t, AddressHash>& Wanted() const {
+    return wanted_;
+  }
+
+  // Returns the commands to send so that the controller holds the wanted
+  // devices for which |skip| returns false, and nothing else.
+  Plan Reconcile(const std::function<bool(const RawAddress&)>& skip) const;
+
+  // Records that the commands of |plan| were sent.
+  void Apply(const Plan& plan);
+
+  // The controller list was cleared, e.g. by HCI_Reset.
+  void ControllerCleared() { in_controller_.clear(); }
+
+  // Forgets the wanted devices and the controller list, after a clear.
+  void Clear() {
+    wanted_.clear();
+    in_controller_.clear();
+  }
+
+ private:
+  std::unordered_map<RawAddress, uint8_t, AddressHash> wanted_;
+  std::unordered_map<RawAddress, uint8_t, AddressHash> in_controller_;
+};
@@ -72,6 +72,7 @@
 #include "bt_types.h"
 #include "btm_api.h"
 #include "btm_int.h"
+#include "btm_sec_dev_index.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hcidefs.h"
@@ -80,6 +81,9 @@
 #include "btif_util.h"
 #include "btif_storage.h"
 
+/* Index of btm_cb.sec_dev_rec by address and connection handle */
+static SecDevIndex* sec_dev_index;
+
 /*******************************************************************************
  *
  * Function         BTM_SecAddDevice
@@ -117,6 +121,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
     p_dev_rec->bd_addr = bd_addr;
 
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+    btm_sec_dev_index_update(p_dev_rec);
 
     /* use default value for background connection params */
     /* update conn params, use default value for background connection params */
@@ -302,6 +307,48 @@ char* BTM_SecReadDevName(const RawAddress& bd_addr) {
   return (p_name);
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_init
+ *
+ * Description      Creates the index of the device database. Called along with
+ *                  the creation of btm_cb.sec_dev_rec.
+ *
+ ******************************************************************************/
+void btm_sec_dev_index_init(void) { sec_dev_index = new SecDevIndex(); }
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_free
+ *
+ * Description      Frees the index of the device database
+ *
+ ******************************************************************************/
+void btm_sec_dev_index_free(void) {
+  delete sec_dev_index;
+  sec_dev_index = NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_index_update
+ *
+ * Description      Updates the index entry of a device record. Must be called
+ *                  whenever bd_addr, ble.pseudo_addr, ble.identity_addr,
+ *                  hci_handle or ble_hci_handle of a record in the device
+ *                  database change, before it is looked up again.
+ *
+ ******************************************************************************/
+void btm_sec_dev_index_update(tBTM_SEC_DEV_REC* p_dev_rec) {
+  SecDevIndex::Keys keys;
+  keys.bd_addr = p_dev_rec->bd_addr;
+  keys.pseudo_addr = p_dev_rec->ble.pseudo_addr;
+  keys.identity_addr = p_dev_rec->ble.identity_addr;
+  keys.hci_handle = p_dev_rec->hci_handle;
+  keys.ble_hci_handle = p_dev_rec->ble_hci_handle;
+  sec_dev_index->Update(p_dev_rec, keys);
+}
+
 /*******************************************************************************
  *
  * Function         btm_sec_alloc_dev
@@ -345,6 +392,7 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
 
   p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_sec_dev_index_update(p_dev_rec);
 
   return (p_dev_rec);
 }
@@ -365,6 +413,7 @@ void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
 
   /* Clear out any saved BLE keys */
   btm_sec_clear_ble_keys(p_dev_rec);
+  sec_dev_index->Remove(p_dev_rec);
   list_remove(btm_cb.sec_dev_rec, p_dev_rec);
 }
 
@@ -439,25 +488,15 @@ bool is_handle_equal(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
   if (btm_cb.sec_dev_rec == NULL) return NULL;
 
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
-
-  return NULL;
-}
-
-bool is_address_equal(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  const RawAddress* bd_addr = ((RawAddress*)context);
-
-  if (*bd_addr == RawAddress::kEmpty) return true;
-  if (p_dev_rec) {
-    if (p_dev_rec->bd_addr == *bd_addr) return false;
-    // If a LE random address is looking for device record
-    if (p_dev_rec->ble.pseudo_addr == *bd_addr) return false;
+  /* Records without a connection are not indexed by handle */
+  if (handle == BTM_SEC_INVALID_HANDLE) {
+    list_node_t* n =
+        list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
+    if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    return NULL;
   }
 
-  if (btm_ble_addr_resolvable(*bd_addr, p_dev_rec)) return false;
-  return true;
+  return static_cast<tBTM_SEC_DEV_REC*>(sec_dev_index->FindByHandle(handle));
 }
 
 /*******************************************************************************
@@ -472,12 +511,54 @@ bool is_address_equal(void* data, void* context) {
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
   if (btm_cb.sec_dev_rec == NULL) return NULL;
+  if (bd_addr == RawAddress::kEmpty) return NULL;
+
+  tBTM_SEC_DEV_REC* p_match =
+      static_cast<tBTM_SEC_DEV_REC*>(sec_dev_index->FindByAddress(bd_addr));
+  if (!BTM_BLE_IS_RESOLVE_BDA(bd_addr)) return p_match;
+
+  /* A resolvable private address may also resolve with the IRK of a record
+   * ahead of the one it matches, which then takes precedence as in a walk of
+   * the whole list */
+  list_node_t* end = list_end(btm_cb.sec_dev_rec);
+  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+       node = list_next(node)) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+    if (p_dev_rec == p_match) break;
+    if (btm_ble_addr_resolvable(bd_addr, p_dev_rec)) return p_dev_rec;
+  }
+
+  return p_match;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_find_dev_by_identity
+ *
+ * Description      Look for the first record in the device database with the
+ *                  specified LE identity address
+ *
+ * Returns          Pointer to the record or NULL
+ *
+ ******************************************************************************/
+tBTM_SEC_DEV_REC* btm_find_dev_by_identity(const RawAddress& identity_addr) {
+  if (btm_cb.sec_dev_rec == NULL) return NULL;
 
-  list_node_t* n =
-      list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  /* Records without an identity address are not indexed by it */
+  if (identity_addr.IsEmpty()) {
+    list_node_t* end = list_end(btm_cb.sec_dev_rec);
+    for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+         node = list_next(node)) {
+      tBTM_SEC_DEV_REC* p_dev_rec =
+          static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+      if (p_dev_rec->ble.identity_addr == identity_addr) return p_dev_rec;
+    }
+    return NULL;
+  }
 
-  return NULL;
+  return static_cast<tBTM_SEC_DEV_REC*>(
+      sec_dev_index->FindByIdentityAddress(identity_addr));
 }
 
 /*******************************************************************************
@@ -520,6 +601,8 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
       p_target_rec->bond_type = temp_rec.bond_type;
 
       /* remove the combined record */
+      sec_dev_index->Remove(p_dev_rec);
+      btm_sec_dev_index_update(p_target_rec);
       list_remove(btm_cb.sec_dev_rec, p_dev_rec);
       //p_dev_rec gets freed in list_remove, we should not  access it further
       continue;
@@ -532,6 +615,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
         p_target_rec->device_type |= p_dev_rec->device_type;
 
         /* remove the combined record */
+        sec_dev_index->Remove(p_dev_rec);
         list_remove(btm_cb.sec_dev_rec, p_dev_rec);
       }
     }
@@ -623,6 +707,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
 
   if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
     p_dev_rec = btm_find_oldest_dev_rec();
+    sec_dev_index->Remove(p_dev_rec);
     list_remove(btm_cb.sec_dev_rec, p_dev_rec);
   }
 
@@ -637,6 +722,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
   p_dev_rec->rmt_io_caps = BTM_IO_CAP_UNKNOWN;
   p_dev_rec->security_required = BTM_SEC_NONE;
   p_dev_rec->is_le_enc_in_progress = false;
+  btm_sec_dev_index_update(p_dev_rec);
 
   return p_dev_rec;
 }
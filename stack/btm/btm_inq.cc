@@ -39,6 +39,7 @@
 #include "bt_common.h"
 #include "bt_types.h"
 #include "btm_api.h"
+#include "btm_inq_db.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "hcidefs.h"
@@ -58,6 +59,9 @@ using bluetooth::Uuid;
 /*               L O C A L    D A T A    D E F I N I T I O N S                */
 /******************************************************************************/
 static const LAP general_inq_lap = {0x9e, 0x8b, 0x33};
+
+/* Address index, recency and iteration order of btm_inq_vars.inq_db */
+static InquiryDbIndex* inq_db_index = NULL;
 static const LAP limited_inq_lap = {0x9e, 0x8b, 0x00};
 
 const uint16_t BTM_EIR_UUID_LKUP_TBL[BTM_EIR_MAX_SERVICES] = {
@@ -1051,55 +1055,43 @@ tBTM_INQ_INFO* BTM_InqDbRead(const RawAddress& p_bda) {
  *
  * Function         BTM_InqDbFirst
  *
- * Description      This function looks through the inquiry database for the
- *                  first used entry, and returns that. This is used in
- *                  conjunction with
- *                  BTM_InqDbNext by applications as a way to walk through the
- *                  inquiry database.
+ * Description      This function returns the first entry of the inquiry
+ *                  database, in the order devices were added (or sorted by
+ *                  RSSI at inquiry complete). This is used in conjunction
+ *                  with BTM_InqDbNext by applications as a way to walk
+ *                  through the inquiry database.
  *
  * Returns          pointer to first in-use entry, or NULL if DB is empty
  *
  ******************************************************************************/
 tBTM_INQ_INFO* BTM_InqDbFirst(void) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use) return (&p_ent->inq_info);
-  }
+  tINQ_DB_ENT* p_ent = btm_inq_db_first();
+  if (!p_ent) return ((tBTM_INQ_INFO*)NULL);
 
-  /* If here, no used entry found */
-  return ((tBTM_INQ_INFO*)NULL);
+  return (&p_ent->inq_info);
 }
 
 /*******************************************************************************
  *
  * Function         BTM_InqDbNext
  *
- * Description      This function looks through the inquiry database for the
- *                  next used entry, and returns that.  If the input parameter
- *                  is NULL, the first entry is returned.
+ * Description      This function returns the entry that follows p_cur in
+ *                  the inquiry database.  If the input parameter is NULL, the
+ *                  first entry is returned.  p_cur may have been removed
+ *                  from the database since it was returned.
  *
  * Returns          pointer to next in-use entry, or NULL if no more found.
  *
  ******************************************************************************/
 tBTM_INQ_INFO* BTM_InqDbNext(tBTM_INQ_INFO* p_cur) {
-  tINQ_DB_ENT* p_ent;
-  uint16_t inx;
+  if (!p_cur) return (BTM_InqDbFirst());
 
-  if (p_cur) {
-    p_ent = (tINQ_DB_ENT*)((uint8_t*)p_cur - offsetof(tINQ_DB_ENT, inq_info));
-    inx = (uint16_t)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
+  tINQ_DB_ENT* p_ent =
+      (tINQ_DB_ENT*)((uint8_t*)p_cur - offsetof(tINQ_DB_ENT, inq_info));
+  p_ent = btm_inq_db_next(p_ent);
+  if (!p_ent) return ((tBTM_INQ_INFO*)NULL);
 
-    for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE;
-         inx++, p_ent++) {
-      if (p_ent->in_use) return (&p_ent->inq_info);
-    }
-
-    /* If here, more entries found */
-    return ((tBTM_INQ_INFO*)NULL);
-  } else
-    return (BTM_InqDbFirst());
+  return (&p_ent->inq_info);
 }
 
 /*******************************************************************************
@@ -1250,10 +1242,19 @@ void btm_inq_db_init(void) {
   btm_cb.btm_inq_vars.remote_name_timer =
       alarm_new("btm_inq.remote_name_timer");
   btm_cb.btm_inq_vars.no_inc_ssp = BTM_NO_SSP_ON_INQUIRY;
+
+  delete inq_db_index;
+  inq_db_index = new InquiryDbIndex(BTM_INQ_DB_SIZE, BTM_INQ_DB_HID_KEEP_MAX);
+  osi_free(btm_cb.btm_inq_vars.inq_db);
+  btm_cb.btm_inq_vars.inq_db =
+      (tINQ_DB_ENT*)osi_calloc(BTM_INQ_DB_SIZE * sizeof(tINQ_DB_ENT));
 }
 
 void btm_inq_db_free(void) {
   alarm_free(btm_cb.btm_inq_vars.remote_name_timer);
+  delete inq_db_index;
+  inq_db_index = NULL;
+  osi_free_and_reset((void**)&btm_cb.btm_inq_vars.inq_db);
 }
 
 /*******************************************************************************
@@ -1318,21 +1319,16 @@ void btm_inq_clear_ssp(void) {
  *
  ******************************************************************************/
 void btm_clr_inq_db(const RawAddress* p_bda) {
-  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
-  tINQ_DB_ENT* p_ent = p_inq->inq_db;
-  uint16_t xx;
-
 #if (BTM_INQ_DEBUG == TRUE)
   BTM_TRACE_DEBUG("btm_clr_inq_db: inq_active:0x%x state:%d",
                   btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use) {
-      /* If this is the specified BD_ADDR or clearing all devices */
-      if (p_bda == NULL || (p_ent->inq_info.results.remote_bd_addr == *p_bda)) {
-        p_ent->in_use = false;
-      }
-    }
+  if (p_bda == NULL) {
+    tINQ_DB_ENT* p_ent;
+    while ((p_ent = btm_inq_db_first()) != NULL) btm_inq_db_remove(p_ent);
+  } else {
+    tINQ_DB_ENT* p_ent = btm_inq_db_find(*p_bda);
+    if (p_ent) btm_inq_db_remove(p_ent);
   }
 #if (BTM_INQ_DEBUG == TRUE)
   BTM_TRACE_DEBUG("inq_active:0x%x state:%d", btm_cb.btm_inq_vars.inq_active,
@@ -1398,84 +1394,114 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type) {
  *
  * Function         btm_inq_db_find
  *
- * Description      This function looks through the inquiry database for a match
- *                  based on Bluetooth Device Address
+ * Description      This function looks up the inquiry database entry of a
+ *                  Bluetooth Device Address
  *
  * Returns          pointer to entry, or NULL if not found
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
+  if (!inq_db_index) return (NULL);
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use && p_ent->inq_info.results.remote_bd_addr == p_bda)
-      return (p_ent);
-  }
+  uint16_t slot = inq_db_index->Find(p_bda);
+  if (slot == InquiryDbIndex::kNone) return (NULL);
 
-  /* If here, not found */
-  return (NULL);
+  return (&btm_cb.btm_inq_vars.inq_db[slot]);
 }
 
 /*******************************************************************************
  *
  * Function         btm_inq_db_new
  *
- * Description      This function looks through the inquiry database for an
- *                  unused entry. If no entry is free, it allocates the oldest
- *                  entry.
+ * Description      This function allocates an inquiry database entry for a
+ *                  device that is not in the database. If no entry is free,
+ *                  the least recently seen device that is not kept is
+ *                  evicted.
  *
- * Returns          pointer to entry
+ * Returns          pointer to entry, or NULL if the database is not set up
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda, bool keep) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_old = btm_cb.btm_inq_vars.inq_db;
-  uint32_t ot = 0xFFFFFFFF;
-  uint8_t keep_counter = 0;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (!p_ent->in_use) {
-      memset(p_ent, 0, sizeof(tINQ_DB_ENT));
-      p_ent->inq_info.results.remote_bd_addr = p_bda;
-      p_ent->in_use = true;
-      /* The keep flag is set as true only for the first 4 HID devices */
-      if (keep_counter < BTM_INQ_DB_HID_KEEP_MAX)
-        p_ent->keep = keep;
-      else
-        p_ent->keep = false;
+  if (!inq_db_index) return (NULL);
 
-      return (p_ent);
-    }
+  uint16_t slot = inq_db_index->Insert(p_bda, keep);
+  if (slot == InquiryDbIndex::kNone) return (NULL);
 
-    if (p_ent->keep) {
-      keep_counter++;
-    }
+  tINQ_DB_ENT* p_ent = &btm_cb.btm_inq_vars.inq_db[slot];
+  memset(p_ent, 0, sizeof(tINQ_DB_ENT));
+  p_ent->inq_info.results.remote_bd_addr = p_bda;
+  p_ent->in_use = true;
+  /* The keep flag is set as true only for the first 4 HID devices */
+  p_ent->keep = inq_db_index->IsKept(slot);
+  if (keep && p_ent->keep) LOG(INFO) << __func__ << ": keep " << p_bda;
 
-    if (p_ent->time_of_resp < ot) {
-      if (p_ent->keep) {
-        LOG(INFO) << __func__ << ": keep "
-                  << p_ent->inq_info.results.remote_bd_addr;
-      } else {
-        p_old = p_ent;
-        ot = p_ent->time_of_resp;
-      }
-    }
-  }
+  return (p_ent);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_touch
+ *
+ * Description      This function marks an entry as the most recently seen
+ *                  when a response from the device was processed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_touch(tINQ_DB_ENT* p_ent) {
+  inq_db_index->Touch(p_ent - btm_cb.btm_inq_vars.inq_db);
+}
 
-  /* If here, no free entry found. Return the oldest. */
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_remove
+ *
+ * Description      This function removes an entry from the inquiry database.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_remove(tINQ_DB_ENT* p_ent) {
+  p_ent->in_use = false;
+  inq_db_index->Remove(p_ent - btm_cb.btm_inq_vars.inq_db);
+}
 
-  memset(p_old, 0, sizeof(tINQ_DB_ENT));
-  p_old->inq_info.results.remote_bd_addr = p_bda;
-  p_old->in_use = true;
-  /* The keep flag is set as true only for the first 4 HID devices */
-  if (keep_counter < BTM_INQ_DB_HID_KEEP_MAX)
-    p_old->keep = keep;
-  else
-    p_old->keep = false;
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_first
+ *
+ * Description      This function returns the first entry of the inquiry
+ *                  database in iteration order.
+ *
+ * Returns          pointer to entry, or NULL if the database is empty
+ *
+ ******************************************************************************/
+tINQ_DB_ENT* btm_inq_db_first(void) {
+  if (!inq_db_index) return (NULL);
 
-  return (p_old);
+  uint16_t slot = inq_db_index->First();
+  if (slot == InquiryDbIndex::kNone) return (NULL);
+
+  return (&btm_cb.btm_inq_vars.inq_db[slot]);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_next
+ *
+ * Description      This function returns the entry following p_ent in
+ *                  iteration order. p_ent may have been removed meanwhile.
+ *
+ * Returns          pointer to entry, or NULL if no more entries
+ *
+ ******************************************************************************/
+tINQ_DB_ENT* btm_inq_db_next(tINQ_DB_ENT* p_ent) {
+  if (!inq_db_index) return (NULL);
+
+  uint16_t slot = inq_db_index->Next(p_ent - btm_cb.btm_inq_vars.inq_db);
+  if (slot == InquiryDbIndex::kNone) return (NULL);
+
+  return (&btm_cb.btm_inq_vars.inq_db[slot]);
 }
 
 /*******************************************************************************
@@ -1904,6 +1930,7 @@ void btm_process_inq_results(uint8_t* p, uint8_t hci_evt_len,
                   p_cur->dev_class[0], p_cur->dev_class[1], p_cur->dev_class[2]);
 
       p_i->time_of_resp = time_get_os_boottime_ms();
+      btm_inq_db_touch(p_i);
 
       if (p_i->inq_count != p_inq->inq_counter)
         p_inq->inq_cmpl_info.num_resp++; /* A new response was found */
@@ -1966,28 +1993,12 @@ void btm_process_inq_results(uint8_t* p, uint8_t hci_evt_len,
  *
  ******************************************************************************/
 void btm_sort_inq_result(void) {
-  uint8_t xx, yy, num_resp;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_next = btm_cb.btm_inq_vars.inq_db + 1;
-  int size;
-  tINQ_DB_ENT* p_tmp = (tINQ_DB_ENT*)osi_malloc(sizeof(tINQ_DB_ENT));
-
-  num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp < BTM_INQ_DB_SIZE)
-                 ? btm_cb.btm_inq_vars.inq_cmpl_info.num_resp
-                 : BTM_INQ_DB_SIZE;
-
-  size = sizeof(tINQ_DB_ENT);
-  for (xx = 0; xx < num_resp - 1; xx++, p_ent++) {
-    for (yy = xx + 1, p_next = p_ent + 1; yy < num_resp; yy++, p_next++) {
-      if (p_ent->inq_info.results.rssi < p_next->inq_info.results.rssi) {
-        memcpy(p_tmp, p_next, size);
-        memcpy(p_next, p_ent, size);
-        memcpy(p_ent, p_tmp, size);
-      }
-    }
-  }
+  if (!inq_db_index) return;
 
-  osi_free(p_tmp);
+  const tINQ_DB_ENT* inq_db = btm_cb.btm_inq_vars.inq_db;
+  inq_db_index->Sort([inq_db](uint16_t a, uint16_t b) {
+    return inq_db[a].inq_info.results.rssi > inq_db[b].inq_info.results.rssi;
+  });
 }
 
 /*******************************************************************************
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btm_inq_db.h"
+
+const uint16_t InquiryDbIndex::kNone;
+
+InquiryDbIndex::InquiryDbIndex(size_t capacity, size_t max_keep)
+    : max_keep_(max_keep),
+      lru_head_(kNone),
+      lru_tail_(kNone),
+      first_(kNone),
+      last_(kNone),
+      size_(0),
+      kept_(0) {
+  Resize(capacity);
+}
+
+void InquiryDbIndex::Resize(size_t capacity) {
+  if (capacity >= kNone) capacity = kNone - 1;
+
+  for (size_t slot = capacity; slot < slots_.size(); slot++)
+    if (slots_[slot].in_use) Remove(slot);
+
+  Slot unused = {};
+  unused.lru_prev = unused.lru_next = kNone;
+  unused.ord_prev = unused.ord_next = kNone;
+  slots_.resize(capacity, unused);
+
+  free_.clear();
+  for (size_t slot = capacity; slot > 0; slot--)
+    if (!slots_[slot - 1].in_use) free_.push_back(slot - 1);
+
+  Rehash();
+}
+
+size_t InquiryDbIndex::Bucket(const RawAddress& addr) const {
+  uint64_t key = 0;
+  for (size_t i = 0; i < RawAddress::kLength; i++)
+    key = (key << 8) | addr.address[i];
+  return (size_t)((key * 0x9E3779B97F4A7C15ull) >> bucket_shift_) &
+         bucket_mask_;
+}
+
+void InquiryDbIndex::Rehash() {
+  size_t buckets = 1;
+  bucket_shift_ = 64;
+  while (buckets < slots_.size() * 2) {
+    buckets <<= 1;
+    bucket_shift_--;
+  }
+  buckets_.assign(buckets, kNone);
+  bucket_mask_ = buckets - 1;
+
+  for (size_t slot = 0; slot < slots_.size(); slot++) {
+    if (!slots_[slot].in_use) continue;
+    size_t i = Bucket(slots_[slot].addr);
+    while (buckets_[i] != kNone) i = (i + 1) & bucket_mask_;
+    buckets_[i] = slot;
+  }
+}
+
+uint16_t InquiryDbIndex::Find(const RawAddress& addr) const {
+  for (size_t i = Bucket(addr);; i = (i + 1) & bucket_mask_) {
+    uint16_t slot = buckets_[i];
+    if (slot == kNone || slots_[slot].addr == addr) return slot;
+  }
+}
+
+uint16_t InquiryDbIndex::Insert(const RawAddress& addr, bool keep) {
+  if (slots_.empty()) return kNone;
+
+  if (free_.empty()) {
+    // Evict the least recently seen device, sparing the kept ones
+    uint16_t victim = lru_tail_;
+    while (victim != kNone && slots_[victim].keep)
+      victim = slots_[victim].lru_prev;
+    if (victim == kNone) victim = lru_tail_;
+    Remove(victim);
+  }
+
+  uint16_t slot = free_.back();
+  free_.pop_back();
+
+  Slot& s = slots_[slot];
+  s.addr = addr;
+  s.in_use = true;
+  s.keep = keep && kept_ < max_keep_;
+  if (s.keep) kept_++;
+  LruPushFront(slot);
+  OrdPushBack(slot);
+
+  size_t i = Bucket(addr);
+  while (buckets_[i] != kNone) i = (i + 1) & bucket_mask_;
+  buckets_[i] = slot;
+  size_++;
+  return slot;
+}
+
+void InquiryDbIndex::Touch(uint16_t slot) {
+  if (lru_head_ == slot) return;
+  LruUnlink(slot);
+  LruPushFront(slot);
+}
+
+void InquiryDbIndex::Unindex(uint16_t slot) {
+  size_t i = Bucket(slots_[slot].addr);
+  while (buckets_[i] != slot) i = (i + 1) & bucket_mask_;
+
+  // Shift the rest of the probe run back so lookups need no tombstones
+  for (size_t j = (i + 1) & bucket_mask_; buckets_[j] != kNone;
+       j = (j + 1) & bucket_mask_) {
+    size_t home = Bucket(slots_[buckets_[j]].addr);
+    bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+    if (movable) {
+      buckets_[i] = buckets_[j];
+      i = j;
+    }
+  }
+  buckets_[i] = kNone;
+}
+
+void InquiryDbIndex::Remove(uint16_t slot) {
+  Slot& s = slots_[slot];
+  Unindex(slot);
+  LruUnlink(slot);
+  OrdUnlink(slot);
+  if (s.keep) kept_--;
+  s.in_use = false;
+  s.keep = false;
+  free_.push_back(slot);
+  size_--;
+}
+
+void InquiryDbIndex::Clear() {
+  while (first_ != kNone) Remove(first_);
+}
+
+uint16_t InquiryDbIndex::Next(uint16_t slot) const {
+  if (slot >= slots_.size()) return kNone;
+
+  // A removed slot still links to the slot that followed it, which may have
+  // been removed in turn; the chain ends at a used slot or the end.
+  uint16_t next = slots_[slot].ord_next;
+  for (size_t steps = 0; next != kNone && !slots_[next].in_use; steps++) {
+    if (steps == slots_.size()) return kNone;
+    next = slots_[next].ord_next;
+  }
+  return next;
+}
+
+void InquiryDbIndex::LruUnlink(uint16_t slot) {
+  Slot& s = slots_[slot];
+  if (s.lru_prev != kNone)
+    slots_[s.lru_prev].lru_next = s.lru_next;
+  else
+    lru_head_ = s.lru_next;
+  if (s.lru_next != kNone)
+    slots_[s.lru_next].lru_prev = s.lru_prev;
+  else
+    lru_tail_ = s.lru_prev;
+  s.lru_prev = s.lru_next = kNone;
+}
+
+void InquiryDbIndex::LruPushFront(uint16_t slot) {
+  Slot& s = slots_[slot];
+  s.lru_prev = kNone;
+  s.lru_next = lru_head_;
+  if (lru_head_ != kNone) slots_[lru_head_].lru_prev = slot;
+  lru_head_ = slot;
+  if (lru_tail_ == kNone) lru_tail_ = slot;
+}
+
+void InquiryDbIndex::OrdUnlink(uint16_t slot) {
+  // ord_next is left in place for Next()
+  Slot& s = slots_[slot];
+  if (s.ord_prev != kNone)
+    slots_[s.ord_prev].ord_next = s.ord_next;
+  else
+    first_ = s.ord_next;
+  if (s.ord_next != kNone)
+    slots_[s.ord_next].ord_prev = s.ord_prev;
+  else
+    last_ = s.ord_prev;
+  s.ord_prev = kNone;
+}
+
+void InquiryDbIndex::OrdPushBack(uint16_t slot) {
+  Slot& s = slots_[slot];
+  s.ord_prev = last_;
+  s.ord_next = kNone;
+  if (last_ != kNone) slots_[last_].ord_next = slot;
+  last_ = slot;
+  if (first_ == kNone) first_ = slot;
+}
+
+void InquiryDbIndex::Relink(const std::vector<uint16_t>& order) {
+  first_ = last_ = kNone;
+  for (uint16_t slot : order) OrdPushBack(slot);
+}
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "raw_address.h"
+
+// Index of the inquiry database. Maps device addresses to slots of the entry
+// array owned by btm_inq, and keeps two orders over the used slots:
+// - iteration order, the order devices were added in (BTM_InqDbFirst/Next);
+// - recency, updated by Touch() on every response, used to pick the least
+//   recently seen device to evict when all slots are used.
+//
+// Up to |max_keep| slots can be marked keep; they are skipped by eviction so
+// that names of HID devices can still be requested. Not thread safe.
+class InquiryDbIndex {
+ public:
+  static const uint16_t kNone = 0xFFFF;
+
+  InquiryDbIndex(size_t capacity, size_t max_keep);
+
+  // Changes the number of slots. Devices in slots beyond the new capacity are
+  // removed; the others keep their slot.
+  void Resize(size_t capacity);
+
+  // Returns the slot of |addr|, or kNone.
+  uint16_t Find(const RawAddress& addr) const;
+
+  // Adds |addr|, which must not be present, evicting the least recently seen
+  // device that is not kept if all slots are used. |keep| is honoured while
+  // fewer than |max_keep| slots are kept. Returns the slot, or kNone if the
+  // index has no slots.
+  uint16_t Insert(const RawAddress& addr, bool keep);
+
+  // Marks |slot| as the most recently seen.
+  void Touch(uint16_t slot);
+
+  void Remove(uint16_t slot);
+  void Clear();
+
+  bool InUse(uint16_t slot) const {
+    return slot < slots_.size() && slots_[slot].in_use;
+  }
+  bool IsKept(uint16_t slot) const { return slots_[slot].keep; }
+
+  // Iteration in insertion order. Next() may be given a slot removed since it
+  // was returned and continues with the devices that followed it.
+  uint16_t First() const { return first_; }
+  uint16_t Next(uint16_t slot) const;
+
+  // Reorders iteration with a stable sort of the used slots by |less|.
+  template <typename Less>
+  void Sort(Less less) {
+    std::vector<uint16_t> order;
+    order.reserve(size_);
+    for (uint16_t slot = first_; slot != kNone; slot = slots_[slot].ord_next)
+      order.push_back(slot);
+    std::stable_sort(order.begin(), order.end(), less);
+    Relink(order);
+  }
+
+  size_t capacity() const { return slots_.size(); }
+  size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    RawAddress addr;
+    uint16_t lru_prev;  // towards the most recently seen slot
+    uint16_t lru_next;
+    uint16_t ord_prev;
+    uint16_t ord_next;
+    bool in_use;
+    bool keep;
+  };
+
+  size_t Bucket(const RawAddress& addr) const;
+  void Rehash();
+  void Unindex(uint16_t slot);
+  void LruUnlink(uint16_t slot);
+  void LruPushFront(uint16_t slot);
+  void OrdUnlink(uint16_t slot);
+  void OrdPushBack(uint16_t slot);
+  void Relink(const std::vector<uint16_t>& order);
+
+  const size_t max_keep_;
+  std::vector<Slot> slots_;
+  std::vector<uint16_t> free_;
+  // Open addressing index of used slots by address, at most half full
+  std::vector<uint16_t> buckets_;
+  size_t bucket_mask_;
+  int bucket_shift_;
+  uint16_t lru_head_;
+  uint16_t lru_tail_;
+  uint16_t first_;
+  uint16_t last_;
+  size_t size_;
+  size_t kept_;
+};
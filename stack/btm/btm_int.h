@@ -74,6 +74,10 @@ extern void btm_event_filter_complete(uint8_t* p);
 extern void btm_inq_stop_on_ssp(void);
 extern void btm_inq_clear_ssp(void);
 extern tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda);
+extern void btm_inq_db_touch(tINQ_DB_ENT* p_ent);
+extern void btm_inq_db_remove(tINQ_DB_ENT* p_ent);
+extern tINQ_DB_ENT* btm_inq_db_first(void);
+extern tINQ_DB_ENT* btm_inq_db_next(tINQ_DB_ENT* p_ent);
 extern bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type);
 
 /* Internal functions provided by btm_acl.cc
@@ -223,6 +227,11 @@ extern void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec);
 extern tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_or_alloc_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle);
+extern tBTM_SEC_DEV_REC* btm_find_dev_by_identity(
+    const RawAddress& identity_addr);
+extern void btm_sec_dev_index_init(void);
+extern void btm_sec_dev_index_free(void);
+extern void btm_sec_dev_index_update(tBTM_SEC_DEV_REC* p_dev_rec);
 extern tBTM_BOND_TYPE btm_get_bond_type_dev(const RawAddress& bd_addr);
 extern bool btm_set_bond_type_dev(const RawAddress& bd_addr,
                                   tBTM_BOND_TYPE bond_type);
@@ -85,6 +85,7 @@ void btm_init(void) {
 #endif
 
   btm_cb.sec_dev_rec = list_new(osi_free);
+  btm_sec_dev_index_init();
 
   btm_dev_init(); /* Device Manager Structures & HCI_Reset */
 }
@@ -103,6 +104,7 @@ void btm_free(void) {
 
   list_free(btm_cb.sec_dev_rec);
   btm_cb.sec_dev_rec = NULL;
+  btm_sec_dev_index_free();
 
   alarm_free(btm_cb.sec_collision_timer);
   btm_cb.sec_collision_timer = NULL;
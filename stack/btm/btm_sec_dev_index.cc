@@ -0,0 +1,110 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include "btm_sec_dev_index.h"
+
+#include <algorithm>
+
+const uint16_t SecDevIndex::kNoHandle;
+
+// Keys carry their kind above the 48 bit value, so that no key is 0
+uint64_t SecDevIndex::AddressKey(Kind kind, const RawAddress& addr) {
+  if (addr.IsEmpty()) return 0;
+  uint64_t key = (uint64_t)(kind + 1) << 48;
+  for (size_t i = 0; i < RawAddress::kLength; i++)
+    key |= (uint64_t)addr.address[i] << (8 * (RawAddress::kLength - 1 - i));
+  return key;
+}
+
+uint64_t SecDevIndex::HandleKey(Kind kind, uint16_t handle) {
+  if (handle == kNoHandle) return 0;
+  return ((uint64_t)(kind + 1) << 48) | handle;
+}
+
+void SecDevIndex::Link(uint64_t key, uint64_t order, void* rec) {
+  if (key == 0) return;
+  Bucket& bucket = buckets_[key];
+  auto it = std::lower_bound(bucket.begin(), bucket.end(),
+                             std::make_pair(order, (void*)nullptr));
+  bucket.insert(it, std::make_pair(order, rec));
+}
+
+void SecDevIndex::Unlink(uint64_t key, void* rec) {
+  if (key == 0) return;
+  auto it = buckets_.find(key);
+  if (it == buckets_.end()) return;
+  Bucket& bucket = it->second;
+  for (auto entry = bucket.begin(); entry != bucket.end(); entry++) {
+    if (entry->second == rec) {
+      bucket.erase(entry);
+      break;
+    }
+  }
+  if (bucket.empty()) buckets_.erase(it);
+}
+
+void SecDevIndex::Update(void* rec, const Keys& keys) {
+  uint64_t new_keys[kNumKinds] = {
+      AddressKey(kBdAddr, keys.bd_addr),
+      AddressKey(kPseudoAddr, keys.pseudo_addr),
+      AddressKey(kIdentityAddr, keys.identity_addr),
+      HandleKey(kHciHandle, keys.hci_handle),
+      HandleKey(kBleHciHandle, keys.ble_hci_handle),
+  };
+
+  auto it = records_.find(rec);
+  if (it == records_.end()) {
+    Record record = {};
+    record.order = next_order_++;
+    it = records_.emplace(rec, record).first;
+  }
+
+  Record& record = it->second;
+  for (int kind = 0; kind < kNumKinds; kind++) {
+    if (record.keys[kind] == new_keys[kind]) continue;
+    Unlink(record.keys[kind], rec);
+    Link(new_keys[kind], record.order, rec);
+    record.keys[kind] = new_keys[kind];
+  }
+}
+
+void SecDevIndex::Remove(void* rec) {
+  auto it = records_.find(rec);
+  if (it == records_.end()) return;
+  for (int kind = 0; kind < kNumKinds; kind++)
+    Unlink(it->second.keys[kind], rec);
+  records_.erase(it);
+}
+
+void SecDevIndex::Clear() {
+  records_.clear();
+  buckets_.clear();
+}
+
+void* SecDevIndex::First(uint64_t key_a, uint64_t key_b) const {
+  const std::pair<uint64_t, void*>* first = nullptr;
+  for (uint64_t key : {key_a, key_b}) {
+    if (key == 0) continue;
+    auto it = buckets_.find(key);
+    if (it == buckets_.end()) continue;
+    const auto& head = it->second.front();
+    if (first == nullptr || head.first < first->first) first = &head;
+  }
+  return first ? first->second : nullptr;
+}
+
+void* SecDevIndex::FindByAddress(const RawAddress& addr) const {
+  return First(AddressKey(kBdAddr, addr), AddressKey(kPseudoAddr, addr));
+}
+
+void* SecDevIndex::FindByIdentityAddress(const RawAddress& addr) const {
+  return First(AddressKey(kIdentityAddr, addr), 0);
+}
+
+void* SecDevIndex::FindByHandle(uint16_t handle) const {
+  return First(HandleKey(kHciHandle, handle),
+               HandleKey(kBleHciHandle, handle));
+}
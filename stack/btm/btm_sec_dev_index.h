@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "raw_address.h"
+
+// Secondary index of the security device records kept in btm_cb.sec_dev_rec.
+// Records are opaque to the index; it maps the BD address, pseudo address,
+// identity address and the BR/EDR and LE connection handles of each record
+// to the record, as last reported by Update().
+//
+// Several records may share a key. Lookups then return the one added first,
+// which is the one a walk of sec_dev_rec finds first, since records are only
+// ever appended to that list. Empty addresses and kNoHandle are not indexed.
+// Not thread safe.
+class SecDevIndex {
+ public:
+  static const uint16_t kNoHandle = 0xFFFF;
+
+  struct Keys {
+    RawAddress bd_addr;
+    RawAddress pseudo_addr;
+    RawAddress identity_addr;
+    uint16_t hci_handle;
+    uint16_t ble_hci_handle;
+  };
+
+  // Sets the keys of |rec|, adding it after all other records if it is new.
+  void Update(void* rec, const Keys& keys);
+  void Remove(void* rec);
+  void Clear();
+
+  // Returns the first record whose BD address or pseudo address is |addr|.
+  void* FindByAddress(const RawAddress& addr) const;
+  // Returns the first record whose identity address is |addr|.
+  void* FindByIdentityAddress(const RawAddress& addr) const;
+  // Returns the first record with |handle| as BR/EDR or LE handle.
+  void* FindByHandle(uint16_t handle) const;
+
+  size_t size() const { return records_.size(); }
+
+ private:
+  enum Kind {
+    kBdAddr,
+    kPseudoAddr,
+    kIdentityAddr,
+    kHciHandle,
+    kBleHciHandle,
+    kNumKinds,
+  };
+
+  struct Record {
+    uint64_t order;
+    uint64_t keys[kNumKinds];  // 0 if not indexed
+  };
+
+  // Records sharing a key, by increasing order
+  typedef std::vector<std::pair<uint64_t, void*>> Bucket;
+
+  static uint64_t AddressKey(Kind kind, const RawAddress& addr);
+  static uint64_t HandleKey(Kind kind, uint16_t handle);
+  void Link(uint64_t key, uint64_t order, void* rec);
+  void Unlink(uint64_t key, void* rec);
+  void* First(uint64_t key_a, uint64_t key_b) const;
+
+  std::unordered_map<void*, Record> records_;
+  std::unordered_map<uint64_t, Bucket> buckets_;
+  uint64_t next_order_ = 0;
+};
@@ -77,6 +77,7 @@
 #include "btm_api.h"
 #include "btm_int.h"
 #include "btu.h"
+#include "btu_hcif_dispatch.h"
 #include "device/include/controller.h"
 #include "hci_evt_length.h"
 #include "hci_layer.h"
@@ -195,6 +196,238 @@ static void do_in_hci_thread(const base::Location& from_here,
   hci_message_loop->task_runner()->PostTask(from_here, task);
 }
 
+/* Traces the LE events that are not registered as hot */
+static void btu_hcif_trace_ble_event(uint8_t sub_code) {
+  HCI_TRACE_EVENT("BLE HCI event = 0x%02x", sub_code);
+}
+
+/* Every event code indexes hci_event_parameters_minimum_length */
+static_assert(sizeof(hci_event_parameters_minimum_length) == 256,
+              "hci_event_parameters_minimum_length must cover every event");
+
+/* Builds the handler table of btu_hcif_process_event. LE handlers that take
+ * the length of the whole event rather than of the sub-event get len + 1. */
+HciEventDispatcher btu_hcif_build_dispatcher(void) {
+  HciEventDispatcher d;
+  auto reg = [&d](uint8_t code, HciEventDispatcher::Handler handler) {
+    d.Register(code, hci_event_parameters_minimum_length[code], handler);
+  };
+  auto reg_le = [&d](uint8_t sub_code, HciEventDispatcher::Handler handler,
+                     bool hot = false) {
+    /* A sub-event past the end of the table has no length to check against */
+    CHECK(sub_code < sizeof(hci_le_event_parameters_minimum_length));
+    d.RegisterLe(sub_code, hci_le_event_parameters_minimum_length[sub_code],
+                 handler, hot);
+  };
+
+  reg(HCI_INQUIRY_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_inquiry_comp_evt(p); });
+  reg(HCI_INQUIRY_RESULT_EVT, btu_hcif_inquiry_result_evt);
+  reg(HCI_INQUIRY_RSSI_RESULT_EVT, btu_hcif_inquiry_rssi_result_evt);
+  reg(HCI_EXTENDED_INQUIRY_RESULT_EVT, btu_hcif_extended_inquiry_result_evt);
+  reg(HCI_CONNECTION_COMP_EVT, btu_hcif_connection_comp_evt);
+  reg(HCI_CONNECTION_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_connection_request_evt(p); });
+  reg(HCI_DISCONNECTION_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_disconnection_comp_evt(p); });
+  reg(HCI_AUTHENTICATION_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_authentication_comp_evt(p); });
+  reg(HCI_RMT_NAME_REQUEST_COMP_EVT, [](uint8_t* p, uint8_t len) {
+    btu_hcif_rmt_name_request_comp_evt(p, len);
+  });
+  reg(HCI_ENCRYPTION_CHANGE_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_encryption_change_evt(p); });
+  reg(HCI_ENCRYPTION_KEY_REFRESH_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_encryption_key_refresh_cmpl_evt(p); });
+  reg(HCI_READ_RMT_FEATURES_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_read_rmt_features_comp_evt(p); });
+  reg(HCI_READ_RMT_EXT_FEATURES_COMP_EVT,
+      btu_hcif_read_rmt_ext_features_comp_evt);
+  reg(HCI_READ_RMT_VERSION_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_read_rmt_version_comp_evt(p); });
+  reg(HCI_QOS_SETUP_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_qos_setup_comp_evt(p); });
+  reg(HCI_FLOW_SPECIFICATION_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_flow_spec_comp_evt(p); });
+  reg(HCI_COMMAND_COMPLETE_EVT, [](uint8_t*, uint8_t) {
+    LOG_ERROR(LOG_TAG,
+              "btu_hcif_process_event should not have received a command "
+              "complete event. Someone didn't go through the hci "
+              "transmit_command function.");
+  });
+  reg(HCI_COMMAND_STATUS_EVT, [](uint8_t*, uint8_t) {
+    LOG_ERROR(LOG_TAG,
+              "btu_hcif_process_event should not have received a command "
+              "status event. Someone didn't go through the hci "
+              "transmit_command function.");
+  });
+  reg(HCI_HARDWARE_ERROR_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_hardware_error_evt(p); });
+  reg(HCI_FLUSH_OCCURED_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_flush_occured_evt(); });
+  reg(HCI_ROLE_CHANGE_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_role_change_evt(p); });
+  reg(HCI_NUM_COMPL_DATA_PKTS_EVT, btu_hcif_num_compl_data_pkts_evt);
+  reg(HCI_MODE_CHANGE_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_mode_change_evt(p); });
+  reg(HCI_PIN_CODE_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_pin_code_request_evt(p); });
+  reg(HCI_LINK_KEY_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_link_key_request_evt(p); });
+  reg(HCI_LINK_KEY_NOTIFICATION_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_link_key_notification_evt(p); });
+  reg(HCI_LOOPBACK_COMMAND_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_loopback_command_evt(); });
+  reg(HCI_DATA_BUF_OVERFLOW_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_data_buf_overflow_evt(); });
+  reg(HCI_MAX_SLOTS_CHANGED_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_max_slots_changed_evt(); });
+  reg(HCI_READ_CLOCK_OFF_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_read_clock_off_comp_evt(p); });
+  reg(HCI_CONN_PKT_TYPE_CHANGE_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_conn_pkt_type_change_evt(p); });
+  reg(HCI_QOS_VIOLATION_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_qos_violation_evt(p); });
+  reg(HCI_PAGE_SCAN_MODE_CHANGE_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_page_scan_mode_change_evt(); });
+  reg(HCI_PAGE_SCAN_REP_MODE_CHNG_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_page_scan_rep_mode_chng_evt(); });
+  reg(HCI_ESCO_CONNECTION_COMP_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_esco_connection_comp_evt(p); });
+  reg(HCI_ESCO_CONNECTION_CHANGED_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_esco_connection_chg_evt(p); });
+#if (BTM_SSR_INCLUDED == TRUE)
+  reg(HCI_SNIFF_SUB_RATE_EVT,
+      [](uint8_t* p, uint8_t len) { btu_hcif_ssr_evt(p, len); });
+#endif /* BTM_SSR_INCLUDED == TRUE */
+  reg(HCI_RMT_HOST_SUP_FEAT_NOTIFY_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_host_support_evt(p); });
+  reg(HCI_IO_CAPABILITY_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_io_cap_request_evt(p); });
+  reg(HCI_IO_CAPABILITY_RESPONSE_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_io_cap_response_evt(p); });
+  reg(HCI_USER_CONFIRMATION_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_user_conf_request_evt(p); });
+  reg(HCI_USER_PASSKEY_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_user_passkey_request_evt(p); });
+  reg(HCI_REMOTE_OOB_DATA_REQUEST_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_rem_oob_request_evt(p); });
+  reg(HCI_SIMPLE_PAIRING_COMPLETE_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_simple_pair_complete_evt(p); });
+  reg(HCI_USER_PASSKEY_NOTIFY_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_user_passkey_notif_evt(p); });
+  reg(HCI_KEYPRESS_NOTIFY_EVT,
+      [](uint8_t* p, uint8_t) { btu_hcif_keypress_notif_evt(p); });
+#if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
+  reg(HCI_ENHANCED_FLUSH_COMPLETE_EVT,
+      [](uint8_t*, uint8_t) { btu_hcif_enhanced_flush_complete_evt(); });
+#endif
+  reg(HCI_VENDOR_SPECIFIC_EVT,
+      [](uint8_t* p, uint8_t len) { btm_vendor_specific_evt(p, len); });
+  reg(HCI_CSB_TIMEOUT_EVT,
+      [](uint8_t* p, uint8_t) { btm_hci_csb_timeout_evt(p); });
+
+  /* The advertising reports arrive by the thousand while scanning */
+  reg_le(HCI_BLE_ADV_PKT_RPT_EVT,
+         [](uint8_t* p, uint8_t len) { btm_ble_process_adv_pkt(len, p); },
+         true);
+  reg_le(HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT,
+         [](uint8_t* p, uint8_t len) {
+           btm_ble_process_ext_adv_pkt(len + 1, p);
+         },
+         true);
+
+  reg_le(HCI_BLE_CONN_COMPLETE_EVT, [](uint8_t* p, uint8_t len) {
+    btu_ble_ll_conn_complete_evt(p, len + 1);
+  });
+  reg_le(HCI_BLE_LL_CONN_PARAM_UPD_EVT, [](uint8_t* p, uint8_t len) {
+    btu_ble_ll_conn_param_upd_evt(p, len);
+  });
+  reg_le(HCI_BLE_READ_REMOTE_FEAT_CMPL_EVT, btu_ble_read_remote_feat_evt);
+  /* received only at slave device */
+  reg_le(HCI_BLE_LTK_REQ_EVT,
+         [](uint8_t* p, uint8_t) { btu_ble_proc_ltk_req(p); });
+#if (BLE_PRIVACY_SPT == TRUE)
+  reg_le(HCI_BLE_ENHANCED_CONN_COMPLETE_EVT, [](uint8_t* p, uint8_t len) {
+    btu_ble_proc_enhanced_conn_cmpl(p, len + 1);
+  });
+#endif
+#if (BLE_LLT_INCLUDED == TRUE)
+  reg_le(HCI_BLE_RC_PARAM_REQ_EVT, btu_ble_rc_param_req_evt);
+#endif
+  reg_le(HCI_BLE_DATA_LENGTH_CHANGE_EVT, [](uint8_t* p, uint8_t len) {
+    btu_ble_data_length_change_evt(p, len + 1);
+  });
+  reg_le(HCI_BLE_PHY_UPDATE_COMPLETE_EVT, [](uint8_t* p, uint8_t len) {
+    btm_ble_process_phy_update_pkt(len, p);
+  });
+  reg_le(HCI_LE_PERIODIC_ADV_SYNC_ESTABLISHED_EVT, [](uint8_t* p, uint8_t len) {
+    btm_ble_periodic_adv_sync_established(p, len + 1);
+  });
+  reg_le(HCI_LE_PERIODIC_ADVERTISING_REPORT_EVT, [](uint8_t* p, uint8_t len) {
+    btm_ble_periodic_adv_report(p, len + 1);
+  });
+  reg_le(HCI_LE_PERIODIC_ADV_SYNC_LOST_EVT, [](uint8_t* p, uint8_t len) {
+    btm_ble_periodic_adv_sync_lost(p, len + 1);
+  });
+  reg_le(HCI_LE_ADVERTISING_SET_TERMINATED_EVT, [](uint8_t* p, uint8_t len) {
+    btm_le_on_advertising_set_terminated(p, len + 1);
+  });
+  reg_le(HCI_LE_CIS_ESTABLISHED, [](uint8_t* p, uint8_t len) {
+    btm_ble_cis_established_evt(p, len + 1);
+  });
+  reg_le(HCI_LE_CIS_REQUEST, [](uint8_t* p, uint8_t len) {
+    btm_ble_cis_request_evt(p, len + 1);
+  });
+  reg_le(HCI_LE_REQUEST_PEER_SCA_COMPLETE, [](uint8_t* p, uint8_t len) {
+    btm_ble_peer_sca_cmpl_evt(p, len + 1);
+  });
+  reg_le(HCI_LE_PATH_LOSS_THRESHOLD, [](uint8_t* p, uint8_t len) {
+    btm_ble_path_loss_threshold_evt(p, len + 1);
+  });
+  reg_le(HCI_LE_TRANSMIT_POWER_REPORTING, [](uint8_t* p, uint8_t len) {
+    btm_ble_transmit_power_reporting_event(p, len + 1);
+  });
+  reg_le(HCI_LE_PERIODIC_ADV_SYNC_TRANSFERE_RECEIVED_EVT,
+         [](uint8_t* p, uint8_t len) {
+           btm_ble_periodic_adv_sync_tx_rcvd(p, len + 1);
+         });
+  reg_le(HCI_LE_BIGINFO_ADVERTISING_REPORT_EVT, [](uint8_t* p, uint8_t len) {
+    btm_ble_biginfo_adv_report_rcvd(p, len + 1);
+  });
+  reg_le(HCI_LE_CREATE_BIG_COMPLETE_EVT, [](uint8_t* p, uint8_t len) {
+    if (!controller_get_interface()->supports_ble_iso_broadcaster()) {
+      LOG_ERROR(LOG_TAG, "btu_hcif_process_event: request not supported.");
+      return;
+    }
+    btm_le_create_big_complete(p, len + 1);
+  });
+  reg_le(HCI_LE_TERMINATE_BIG_COMPLETE_EVT, [](uint8_t* p, uint8_t len) {
+    if (!controller_get_interface()->supports_ble_iso_broadcaster()) {
+      LOG_ERROR(LOG_TAG, "btu_hcif_process_event: request not supported.");
+      return;
+    }
+    btm_le_terminate_big_complete(p, len + 1);
+  });
+  reg_le(HCI_LE_SUBRATE_CHANGE_EVT, [](uint8_t* p, uint8_t len) {
+    btu_ble_subrate_change_evt(p, len + 1);
+  });
+#ifdef DIR_FINDING_FEATURE
+  reg_le(HCI_LE_CONN_IQ_REPORT_EVT, [](uint8_t* p, uint8_t len) {
+    btm_le_conn_iq_report_evt(p, len + 1);
+  });
+  reg_le(HCI_LE_CTE_REQ_FAILED_EVT, [](uint8_t* p, uint8_t len) {
+    btm_le_cte_req_failed_evt(p, len + 1);
+  });
+#endif  // DIR_FINDING_FEATURE
+
+  d.SetLeTracer(btu_hcif_trace_ble_event);
+  return d;
+}
+
+static const HciEventDispatcher hci_event_dispatcher =
+    btu_hcif_build_dispatcher();
+
 /*******************************************************************************
  *
  * Function         btu_hcif_process_event
@@ -208,307 +441,24 @@ static void do_in_hci_thread(const base::Location& from_here,
 void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
   uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
   uint8_t hci_evt_code, hci_evt_len;
-  uint8_t ble_sub_code;
   STREAM_TO_UINT8(hci_evt_code, p);
   STREAM_TO_UINT8(hci_evt_len, p);
 
-  // validate event size
-  if (hci_evt_len < hci_event_parameters_minimum_length[hci_evt_code]) {
-    HCI_TRACE_WARNING("%s: evt:0x%2X, malformed event of size %hhd", __func__,
-                      hci_evt_code, hci_evt_len);
-    return;
-  }
-
-  switch (hci_evt_code) {
-    case HCI_INQUIRY_COMP_EVT:
-      btu_hcif_inquiry_comp_evt(p);
-      break;
-    case HCI_INQUIRY_RESULT_EVT:
-      btu_hcif_inquiry_result_evt(p, hci_evt_len);
-      break;
-    case HCI_INQUIRY_RSSI_RESULT_EVT:
-      btu_hcif_inquiry_rssi_result_evt(p, hci_evt_len);
-      break;
-    case HCI_EXTENDED_INQUIRY_RESULT_EVT:
-      btu_hcif_extended_inquiry_result_evt(p, hci_evt_len);
-      break;
-    case HCI_CONNECTION_COMP_EVT:
-      btu_hcif_connection_comp_evt(p, hci_evt_len);
-      break;
-    case HCI_CONNECTION_REQUEST_EVT:
-      btu_hcif_connection_request_evt(p);
-      break;
-    case HCI_DISCONNECTION_COMP_EVT:
-      btu_hcif_disconnection_comp_evt(p);
-      break;
-    case HCI_AUTHENTICATION_COMP_EVT:
-      btu_hcif_authentication_comp_evt(p);
-      break;
-    case HCI_RMT_NAME_REQUEST_COMP_EVT:
-      btu_hcif_rmt_name_request_comp_evt(p, hci_evt_len);
-      break;
-    case HCI_ENCRYPTION_CHANGE_EVT:
-      btu_hcif_encryption_change_evt(p);
-      break;
-    case HCI_ENCRYPTION_KEY_REFRESH_COMP_EVT:
-      btu_hcif_encryption_key_refresh_cmpl_evt(p);
-      break;
-    case HCI_READ_RMT_FEATURES_COMP_EVT:
-      btu_hcif_read_rmt_features_comp_evt(p);
-      break;
-    case HCI_READ_RMT_EXT_FEATURES_COMP_EVT:
-      btu_hcif_read_rmt_ext_features_comp_evt(p, hci_evt_len);
-      break;
-    case HCI_READ_RMT_VERSION_COMP_EVT:
-      btu_hcif_read_rmt_version_comp_evt(p);
-      break;
-    case HCI_QOS_SETUP_COMP_EVT:
-      btu_hcif_qos_setup_comp_evt(p);
-      break;
-    case HCI_FLOW_SPECIFICATION_COMP_EVT:
-      btu_hcif_flow_spec_comp_evt(p);
-      break;
-    case HCI_COMMAND_COMPLETE_EVT:
-      LOG_ERROR(LOG_TAG,
-                "%s should not have received a command complete event. "
-                "Someone didn't go through the hci transmit_command function.",
-                __func__);
-      break;
-    case HCI_COMMAND_STATUS_EVT:
-      LOG_ERROR(LOG_TAG,
-                "%s should not have received a command status event. "
-                "Someone didn't go through the hci transmit_command function.",
-                __func__);
-      break;
-    case HCI_HARDWARE_ERROR_EVT:
-      btu_hcif_hardware_error_evt(p);
-      break;
-    case HCI_FLUSH_OCCURED_EVT:
-      btu_hcif_flush_occured_evt();
-      break;
-    case HCI_ROLE_CHANGE_EVT:
-      btu_hcif_role_change_evt(p);
-      break;
-    case HCI_NUM_COMPL_DATA_PKTS_EVT:
-      btu_hcif_num_compl_data_pkts_evt(p, hci_evt_len);
-      break;
-    case HCI_MODE_CHANGE_EVT:
-      btu_hcif_mode_change_evt(p);
-      break;
-    case HCI_PIN_CODE_REQUEST_EVT:
-      btu_hcif_pin_code_request_evt(p);
-      break;
-    case HCI_LINK_KEY_REQUEST_EVT:
-      btu_hcif_link_key_request_evt(p);
-      break;
-    case HCI_LINK_KEY_NOTIFICATION_EVT:
-      btu_hcif_link_key_notification_evt(p);
+  switch (hci_event_dispatcher.Dispatch(hci_evt_code, p, hci_evt_len)) {
+    case HciEventDispatcher::kHandled:
       break;
-    case HCI_LOOPBACK_COMMAND_EVT:
-      btu_hcif_loopback_command_evt();
-      break;
-    case HCI_DATA_BUF_OVERFLOW_EVT:
-      btu_hcif_data_buf_overflow_evt();
-      break;
-    case HCI_MAX_SLOTS_CHANGED_EVT:
-      btu_hcif_max_slots_changed_evt();
-      break;
-    case HCI_READ_CLOCK_OFF_COMP_EVT:
-      btu_hcif_read_clock_off_comp_evt(p);
-      break;
-    case HCI_CONN_PKT_TYPE_CHANGE_EVT:
-      btu_hcif_conn_pkt_type_change_evt(p);
-      break;
-    case HCI_QOS_VIOLATION_EVT:
-      btu_hcif_qos_violation_evt(p);
-      break;
-    case HCI_PAGE_SCAN_MODE_CHANGE_EVT:
-      btu_hcif_page_scan_mode_change_evt();
-      break;
-    case HCI_PAGE_SCAN_REP_MODE_CHNG_EVT:
-      btu_hcif_page_scan_rep_mode_chng_evt();
-      break;
-    case HCI_ESCO_CONNECTION_COMP_EVT:
-      btu_hcif_esco_connection_comp_evt(p);
-      break;
-    case HCI_ESCO_CONNECTION_CHANGED_EVT:
-      btu_hcif_esco_connection_chg_evt(p);
-      break;
-#if (BTM_SSR_INCLUDED == TRUE)
-    case HCI_SNIFF_SUB_RATE_EVT:
-      btu_hcif_ssr_evt(p, hci_evt_len);
-      break;
-#endif /* BTM_SSR_INCLUDED == TRUE */
-    case HCI_RMT_HOST_SUP_FEAT_NOTIFY_EVT:
-      btu_hcif_host_support_evt(p);
-      break;
-    case HCI_IO_CAPABILITY_REQUEST_EVT:
-      btu_hcif_io_cap_request_evt(p);
-      break;
-    case HCI_IO_CAPABILITY_RESPONSE_EVT:
-      btu_hcif_io_cap_response_evt(p);
-      break;
-    case HCI_USER_CONFIRMATION_REQUEST_EVT:
-      btu_hcif_user_conf_request_evt(p);
-      break;
-    case HCI_USER_PASSKEY_REQUEST_EVT:
-      btu_hcif_user_passkey_request_evt(p);
-      break;
-    case HCI_REMOTE_OOB_DATA_REQUEST_EVT:
-      btu_hcif_rem_oob_request_evt(p);
-      break;
-    case HCI_SIMPLE_PAIRING_COMPLETE_EVT:
-      btu_hcif_simple_pair_complete_evt(p);
-      break;
-    case HCI_USER_PASSKEY_NOTIFY_EVT:
-      btu_hcif_user_passkey_notif_evt(p);
-      break;
-    case HCI_KEYPRESS_NOTIFY_EVT:
-      btu_hcif_keypress_notif_evt(p);
-      break;
-#if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
-    case HCI_ENHANCED_FLUSH_COMPLETE_EVT:
-      btu_hcif_enhanced_flush_complete_evt();
-      break;
-#endif
-
-    case HCI_BLE_EVENT: {
-      STREAM_TO_UINT8(ble_sub_code, p);
-
-      HCI_TRACE_EVENT("BLE HCI(id=%d) event = 0x%02x)", hci_evt_code,
-                      ble_sub_code);
-
-      uint8_t ble_evt_len = hci_evt_len - 1;
-      switch (ble_sub_code) {
-        case HCI_BLE_ADV_PKT_RPT_EVT: /* result of inquiry */
-          HCI_TRACE_EVENT("HCI_BLE_ADV_PKT_RPT_EVT");
-          btm_ble_process_adv_pkt(ble_evt_len, p);
-          break;
-        case HCI_BLE_CONN_COMPLETE_EVT:
-          btu_ble_ll_conn_complete_evt(p, hci_evt_len);
-          break;
-        case HCI_BLE_LL_CONN_PARAM_UPD_EVT:
-          btu_ble_ll_conn_param_upd_evt(p, ble_evt_len);
-          break;
-        case HCI_BLE_READ_REMOTE_FEAT_CMPL_EVT:
-          btu_ble_read_remote_feat_evt(p, ble_evt_len);
-          break;
-        case HCI_BLE_LTK_REQ_EVT: /* received only at slave device */
-          btu_ble_proc_ltk_req(p);
-          break;
-#if (BLE_PRIVACY_SPT == TRUE)
-        case HCI_BLE_ENHANCED_CONN_COMPLETE_EVT:
-          btu_ble_proc_enhanced_conn_cmpl(p, hci_evt_len);
-          break;
-#endif
-#if (BLE_LLT_INCLUDED == TRUE)
-        case HCI_BLE_RC_PARAM_REQ_EVT:
-          btu_ble_rc_param_req_evt(p, ble_evt_len);
-          break;
-#endif
-        case HCI_BLE_DATA_LENGTH_CHANGE_EVT:
-          btu_ble_data_length_change_evt(p, hci_evt_len);
-          break;
-
-        case HCI_BLE_PHY_UPDATE_COMPLETE_EVT:
-          btm_ble_process_phy_update_pkt(ble_evt_len, p);
-          break;
-
-        case HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT:
-          btm_ble_process_ext_adv_pkt(hci_evt_len, p);
-          break;
-
-        case HCI_LE_PERIODIC_ADV_SYNC_ESTABLISHED_EVT:
-          btm_ble_periodic_adv_sync_established(p, hci_evt_len);
-          break;
-
-        case HCI_LE_PERIODIC_ADVERTISING_REPORT_EVT:
-          btm_ble_periodic_adv_report(p, hci_evt_len);
-          break;
-
-        case HCI_LE_PERIODIC_ADV_SYNC_LOST_EVT:
-          btm_ble_periodic_adv_sync_lost(p, hci_evt_len);
-          break;
-
-        case HCI_LE_ADVERTISING_SET_TERMINATED_EVT:
-          btm_le_on_advertising_set_terminated(p, hci_evt_len);
-          break;
-
-        case HCI_LE_CIS_ESTABLISHED:
-          btm_ble_cis_established_evt(p, hci_evt_len);
-          break;
-
-        case HCI_LE_CIS_REQUEST:
-          btm_ble_cis_request_evt(p, hci_evt_len);
-          break;
-
-        case HCI_LE_REQUEST_PEER_SCA_COMPLETE:
-          btm_ble_peer_sca_cmpl_evt(p, hci_evt_len);
-          break;
-
-        case HCI_LE_PATH_LOSS_THRESHOLD:
-          btm_ble_path_loss_threshold_evt(p, hci_evt_len);
-          break;
-
-        case HCI_LE_TRANSMIT_POWER_REPORTING:
-          btm_ble_transmit_power_reporting_event(p, hci_evt_len);
-          break;
-
-        case HCI_LE_PERIODIC_ADV_SYNC_TRANSFERE_RECEIVED_EVT:
-          btm_ble_periodic_adv_sync_tx_rcvd(p, hci_evt_len);
-          break;
-
-        case HCI_LE_BIGINFO_ADVERTISING_REPORT_EVT:
-          btm_ble_biginfo_adv_report_rcvd(p, hci_evt_len);
-          break;
-
-        case HCI_LE_CREATE_BIG_COMPLETE_EVT:
-          if(!controller_get_interface()->supports_ble_iso_broadcaster()) {
-            LOG_ERROR(LOG_TAG, "%s request not supported.", __func__);
-            return;
-          }
-          btm_le_create_big_complete(p, hci_evt_len);
-          break;
-
-        case HCI_LE_TERMINATE_BIG_COMPLETE_EVT:
-          if(!controller_get_interface()->supports_ble_iso_broadcaster()) {
-            LOG_ERROR(LOG_TAG, "%s request not supported.", __func__);
-            return;
-          }
-          btm_le_terminate_big_complete(p, hci_evt_len);
-          break;
-
-        case HCI_LE_SUBRATE_CHANGE_EVT:
-          btu_ble_subrate_change_evt(p, hci_evt_len);
-          break;
-
-#ifdef DIR_FINDING_FEATURE
-        case HCI_LE_CONN_IQ_REPORT_EVT:
-          btm_le_conn_iq_report_evt(p, hci_evt_len);
-          break;
-
-        case HCI_LE_CTE_REQ_FAILED_EVT:
-          btm_le_cte_req_failed_evt(p, hci_evt_len);
-          break;
-#endif //DIR_FINDING_FEATURE
-
+    case HciEventDispatcher::kTooShort:
+      HCI_TRACE_WARNING("%s: evt:0x%2X, malformed event of size %hhd",
+                        __func__, hci_evt_code, hci_evt_len);
+      return;
+    case HciEventDispatcher::kUnhandled:
 #ifdef VLOC_FEATURE
-        default:
-          LOG_DEBUG(LOG_TAG, "%s process vendor HCI events.", __func__);
-          btu_vendor_hcif_process_event(controller_id, p_msg);
-#endif
+      if (hci_evt_code == HCI_BLE_EVENT) {
+        LOG_DEBUG(LOG_TAG, "%s process vendor HCI events.", __func__);
+        btu_vendor_hcif_process_event(controller_id, p_msg);
       }
+#endif
       break;
-    }
-
-    case HCI_VENDOR_SPECIFIC_EVT:
-      btm_vendor_specific_evt(p, hci_evt_len);
-      break;
-
-    case HCI_CSB_TIMEOUT_EVT:
-      btm_hci_csb_timeout_evt(p);
-      break;
-
   }
 #if HCI_RAW_CMD_INCLUDED == TRUE
   btm_hci_event (p, hci_evt_code , hci_evt_len);
@@ -573,8 +523,10 @@ static void btu_hcif_command_complete_evt_with_cb_on_task(BT_HDR* event,
   STREAM_TO_UINT16(opcode, stream);
 
   cmd_with_cb_data* cb_wrapper = (cmd_with_cb_data*)context;
-  HCI_TRACE_DEBUG("command complete for: %s",
-                  cb_wrapper->posted_from.ToString().c_str());
+  HCI_TRACE_DEBUG("command complete for: %s@%s:%d",
+                  cb_wrapper->posted_from.function_name(),
+                  cb_wrapper->posted_from.file_name(),
+                  cb_wrapper->posted_from.line_number());
   cb_wrapper->cb.Run(stream, event->len - 5);
   cmd_with_cb_data_cleanup(cb_wrapper);
   osi_free(cb_wrapper);
@@ -598,8 +550,10 @@ static void btu_hcif_command_status_evt_with_cb_on_task(uint8_t status,
 
   // report command status
   cmd_with_cb_data* cb_wrapper = (cmd_with_cb_data*)context;
-  HCI_TRACE_DEBUG("command status for: %s",
-                  cb_wrapper->posted_from.ToString().c_str());
+  HCI_TRACE_DEBUG("command status for: %s@%s:%d",
+                  cb_wrapper->posted_from.function_name(),
+                  cb_wrapper->posted_from.file_name(),
+                  cb_wrapper->posted_from.line_number());
   cb_wrapper->cb.Run(&status, sizeof(uint16_t));
   cmd_with_cb_data_cleanup(cb_wrapper);
   osi_free(cb_wrapper);
@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+// Handlers of inbound HCI events, indexed by event code and, for the LE meta
+// event, by sub-event code, so that an event reaches its handler with one
+// lookup instead of a walk through nested switches.
+//
+// Each entry holds the minimum parameter length of its event. Shorter events
+// are dropped before the handler runs, so a handler may read that many bytes
+// without checking them again. A handler gets the parameters after the event
+// header, or after the sub-event code for LE events, and their length.
+//
+// LE events are traced before their handler runs, except for the ones
+// registered as hot: the advertising reports, which arrive by the thousand
+// while scanning.
+class HciEventDispatcher {
+ public:
+  using Handler = void (*)(uint8_t* p, uint8_t len);
+  using Tracer = void (*)(uint8_t sub_code);
+
+  static constexpr uint8_t kLeMetaEvent = 0x3E;
+
+  enum Result { kHandled, kTooShort, kUnhandled };
+
+  void Register(uint8_t event_code, uint8_t min_len, Handler handler) {
+    events_[event_code] = Entry{handler, min_len, false};
+  }
+
+  void RegisterLe(uint8_t sub_code, uint8_t min_len, Handler handler,
+                  bool hot = false) {
+    le_events_[sub_code] = Entry{handler, min_len, hot};
+  }
+
+  void SetLeTracer(Tracer tracer) { le_tracer_ = tracer; }
+
+  // Runs the handler of event |event_code|, whose |len| bytes of parameters
+  // are at |p|.
+  Result Dispatch(uint8_t event_code, uint8_t* p, uint8_t len) const {
+    const Entry* entry = &events_[event_code];
+    if (event_code == kLeMetaEvent) {
+      if (len < 1) return kTooShort;
+      uint8_t sub_code = *p++;
+      len--;
+      entry = &le_events_[sub_code];
+      if (len < entry->min_len) return kTooShort;
+      if (entry->handler == nullptr) return kUnhandled;
+      if (!entry->hot && le_tracer_ != nullptr) le_tracer_(sub_code);
+    } else {
+      if (len < entry->min_len) return kTooShort;
+      if (entry->handler == nullptr) return kUnhandled;
+    }
+    entry->handler(p, len);
+    return kHandled;
+  }
+
+  bool IsRegistered(uint8_t event_code) const {
+    return events_[event_code].handler != nullptr;
+  }
+  bool IsLeRegistered(uint8_t sub_code) const {
+    return le_events_[sub_code].handler != nullptr;
+  }
+  uint8_t MinLength(uint8_t event_code) const {
+    return events_[event_code].min_len;
+  }
+  uint8_t LeMinLength(uint8_t sub_code) const {
+    return le_events_[sub_code].min_len;
+  }
+  bool IsLeHot(uint8_t sub_code) const { return le_events_[sub_code].hot; }
+
+ private:
+  struct Entry {
+    Handler handler;
+    uint8_t min_len;
+    bool hot;  // not traced
+  };
+
+  Entry events_[256] = {};
+  Entry le_events_[256] = {};
+  Tracer le_tracer_ = nullptr;
+};
+
+// The table btu_hcif_process_event dispatches through, built at startup.
+// Exposed for btu_hcif_dispatch_test.
+HciEventDispatcher btu_hcif_build_dispatcher(void);
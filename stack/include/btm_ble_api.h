@@ -163,10 +163,17 @@ extern void BTM_BleEnableBatchScan(
 extern void BTM_BleDisableBatchScan(
     base::Callback<void(uint8_t /* status */)> cb);
 
-/* This function is called to read batch scan reports */
+/* This function is called to read batch scan reports. The reports are
+ * passed to |cb| in batches as they are read, the batch that ends the read
+ * with |last| set; reading pauses while the consumer holds two batches it has
+ * not released with BTM_BleScanReportsConsumed */
 extern void BTM_BleReadScanReports(tBLE_SCAN_MODE scan_mode,
                                    tBTM_BLE_SCAN_REP_CBACK cb);
 
+/* This function is called when the consumer is done with a batch of scan
+ * reports */
+extern void BTM_BleScanReportsConsumed(void);
+
 /* This function is called to setup the callback for tracking */
 extern void BTM_BleTrackAdvertiser(tBTM_BLE_TRACK_ADV_CBACK* p_track_cback,
                                    tBTM_BLE_REF_VALUE ref_value);
@@ -276,3 +276,47 @@ static const uint8_t hci_event_parameters_minimum_length[] = {
     0,    //  0xFE - N/A
     0,    //  0xFF - HCI_Vendor_Specific Event
 };
+
+/*
+ *  Definitions for LE Meta Event Parameter Minimum Length, after the
+ *  Subevent_Code. Events whose parameters depend on their status count the
+ *  ones sent with any status. Sub-events not listed are not length checked.
+ */
+static const uint8_t hci_le_event_parameters_minimum_length[] = {
+    0,    //  0x00 - N/A
+    11,   //  0x01 - LE Connection Complete (Status != 0)
+    1,    //  0x02 - LE Advertising Report (Num_Reports)
+    9,    //  0x03 - LE Connection Update Complete
+    3,    //  0x04 - LE Read Remote Features Complete (Status != 0)
+    12,   //  0x05 - LE Long Term Key Request
+    10,   //  0x06 - LE Remote Connection Parameter Request
+    10,   //  0x07 - LE Data Length Change
+    65,   //  0x08 - LE Read Local P-256 Public Key Complete
+    33,   //  0x09 - LE Generate DHKey Complete
+    11,   //  0x0A - LE Enhanced Connection Complete (Status != 0)
+    1,    //  0x0B - LE Directed Advertising Report (Num_Reports)
+    5,    //  0x0C - LE PHY Update Complete
+    1,    //  0x0D - LE Extended Advertising Report (Num_Reports)
+    15,   //  0x0E - LE Periodic Advertising Sync Established
+    7,    //  0x0F - LE Periodic Advertising Report (Data_Length = 0)
+    2,    //  0x10 - LE Periodic Advertising Sync Lost
+    0,    //  0x11 - LE Scan Timeout
+    5,    //  0x12 - LE Advertising Set Terminated
+    8,    //  0x13 - LE Scan Request Received
+    3,    //  0x14 - LE Channel Selection Algorithm
+    0,    //  0x15 - LE Connectionless IQ Report (not checked)
+    2,    //  0x16 - LE Connection IQ Report (Connection_Handle)
+    3,    //  0x17 - LE CTE Request Failed
+    19,   //  0x18 - LE Periodic Advertising Sync Transfer Received
+    3,    //  0x19 - LE CIS Established (Status != 0)
+    6,    //  0x1A - LE CIS Request
+    2,    //  0x1B - LE Create BIG Complete (Status != 0)
+    2,    //  0x1C - LE Terminate BIG Complete
+    0,    //  0x1D - LE BIG Sync Established (not checked)
+    2,    //  0x1E - LE BIG Sync Lost
+    4,    //  0x1F - LE Request Peer SCA Complete
+    4,    //  0x20 - LE Path Loss Threshold
+    8,    //  0x21 - LE Transmit Power Reporting
+    19,   //  0x22 - LE BIGInfo Advertising Report
+    11,   //  0x23 - LE Subrate Change
+};
@@ -348,10 +348,20 @@ typedef void(tL2CA_CONGESTION_STATUS_CB)(uint16_t, bool);
  * This callback notifies the application when Number of Completed Packets
  * event has been received.
  * This callback is originally designed for 3DG devices.
- * The parameter is:
+ * The parameters are:
  *          peer BD_ADDR
+ *          number of ACL packets completed on the link
  */
-typedef void(tL2CA_NOCP_CB)(const RawAddress&);
+typedef void(tL2CA_NOCP_CB)(const RawAddress&, uint16_t);
+
+/* Callback prototype for link traffic.
+ * This callback notifies the application of every ACL data packet sent to
+ * or received from the controller on a BR/EDR link.
+ * The parameters are:
+ *          HCI handle of the link
+ *          length of the packet
+ */
+typedef void(tL2CA_LINK_TRAFFIC_CB)(uint16_t, uint16_t);
 
 /* Transmit complete callback protype. This callback is optional. If
  * set, L2CAP will call it when packets are sent or flushed. If the
@@ -1057,6 +1067,20 @@ extern bool L2CA_SetTxPriority(uint16_t cid, tL2CAP_CHNL_PRIORITY priority);
  ******************************************************************************/
 extern bool L2CA_RegForNoCPEvt(tL2CA_NOCP_CB* p_cb, const RawAddress& p_bda);
 
+/*******************************************************************************
+ *
+ * Function         L2CA_RegisterLinkTrafficCb
+ *
+ * Description      Register callback for the ACL data packets sent and
+ *                  received on BR/EDR links, NULL to deregister.
+ *
+ * Input Param      p_cb - callback for link traffic
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void L2CA_RegisterLinkTrafficCb(tL2CA_LINK_TRAFFIC_CB* p_cb);
+
 /*******************************************************************************
  *
  * Function         L2CA_SetChnlDataRate
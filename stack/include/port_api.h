@@ -104,6 +104,18 @@ typedef int(tPORT_DATA_CALLBACK)(uint16_t port_handle, void* p_data,
 #define DATA_CO_CALLBACK_TYPE_INCOMING 1
 #define DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE 2
 #define DATA_CO_CALLBACK_TYPE_OUTGOING 3
+/* p_buf points to a tPORT_DATA_CO_BUFS to fill with outgoing data. The
+ * callout returns the bytes filled, 0 if none is pending, or -1 on error */
+#define DATA_CO_CALLBACK_TYPE_OUTGOING_BUFS 4
+
+/* Buffers to fill, in order, each with up to max_len bytes at its offset;
+ * the callout sets the len of each */
+typedef struct {
+  BT_HDR** bufs;
+  uint16_t count;
+  uint16_t max_len;
+} tPORT_DATA_CO_BUFS;
+
 typedef int(tPORT_DATA_CO_CALLBACK)(uint16_t port_handle, uint8_t* p_buf,
                                     uint16_t len, int type);
 
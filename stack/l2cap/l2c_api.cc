@@ -35,6 +35,7 @@
 #include "btm_api.h"
 #include "btu.h"
 #include "device/include/controller.h"
+#include "hci/include/btsnoop.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
@@ -1735,7 +1736,7 @@ uint16_t L2CA_LocalLoopbackReq(uint16_t psm, uint16_t handle,
   }
 
   p_lcb->link_state = LST_CONNECTED;
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   /* Allocate a channel control block */
   p_ccb = l2cu_allocate_ccb(p_lcb, 0);
@@ -2558,6 +2559,22 @@ bool L2CA_RegForNoCPEvt(tL2CA_NOCP_CB* p_cb, const RawAddress& p_bda) {
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         L2CA_RegisterLinkTrafficCb
+ *
+ * Description      Register callback for the ACL data packets sent and
+ *                  received on BR/EDR links, NULL to deregister.
+ *
+ * Input Param      p_cb - callback for link traffic
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void L2CA_RegisterLinkTrafficCb(tL2CA_LINK_TRAFFIC_CB* p_cb) {
+  l2cb.p_link_traffic_cb = p_cb;
+}
+
 /*******************************************************************************
  *
  * Function         L2CA_DataWrite
@@ -2774,6 +2791,10 @@ void L2CA_SetMediaStreamChannel(uint16_t local_media_cid, bool status)
         if(!av_media_channels[set_channel].p_ccb)
             return;
         av_media_channels[set_channel].local_cid = local_media_cid;
+        av_media_channels[set_channel].remote_cid =
+            av_media_channels[set_channel].p_ccb->remote_cid;
+        av_media_channels[set_channel].handle =
+            av_media_channels[set_channel].p_ccb->p_lcb->handle;
         L2CAP_TRACE_EVENT("%s: Set A2DP media snoop filtering for local_cid: %d, remote_cid: %d",
             __func__, local_media_cid, av_media_channels[set_channel].p_ccb->remote_cid);
     }
@@ -2799,6 +2820,8 @@ void L2CA_SetMediaStreamChannel(uint16_t local_media_cid, bool status)
     }
 
     av_media_channels[set_channel].is_active = status;
+    btsnoop_get_interface()->set_media_channel(av_media_channels[set_channel].handle,
+        local_media_cid, av_media_channels[set_channel].remote_cid, status);
 }
 
 /*******************************************************************************
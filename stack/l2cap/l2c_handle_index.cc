@@ -0,0 +1,84 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Lookup of links by HCI handle, kept apart from l2c_utils.cc so that the
+ *  index can be tested against the LCB pool on its own.
+ *
+ ******************************************************************************/
+
+#include "l2c_int.h"
+
+/*******************************************************************************
+ *
+ * Function         l2cu_find_lcb_by_handle
+ *
+ * Description      Look up the active LCB with the given HCI handle, through
+ *                  the handle index.
+ *
+ * Returns          pointer to matched LCB, or NULL if no match
+ *
+ ******************************************************************************/
+tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
+  int xx;
+  tL2C_LCB* p_lcb;
+
+  if (l2c_handle_index_covers(handle)) {
+    xx = l2c_handle_index_get(&l2cb.lcb_by_handle, handle);
+    if (xx < 0) return (NULL);
+
+    p_lcb = &l2cb.lcb_pool[xx];
+    if ((p_lcb->in_use) && (p_lcb->handle == handle)) return (p_lcb);
+    return (NULL);
+  }
+
+  /* Handles outside the index, e.g. HCI_INVALID_HANDLE */
+  p_lcb = &l2cb.lcb_pool[0];
+  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if ((p_lcb->in_use) && (p_lcb->handle == handle)) {
+      return (p_lcb);
+    }
+  }
+
+  /* If here, no match found */
+  return (NULL);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cu_set_lcb_handle
+ *
+ * Description      Sets the HCI handle of an LCB and keeps the handle index
+ *                  used by l2cu_find_lcb_by_handle in step. The handle of an
+ *                  in-use LCB must only be changed through this function.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle) {
+  uint8_t slot = (uint8_t)(p_lcb - l2cb.lcb_pool);
+
+  l2c_handle_index_clear(&l2cb.lcb_by_handle, p_lcb->handle, slot);
+  p_lcb->handle = handle;
+  l2c_handle_index_set(&l2cb.lcb_by_handle, handle, slot);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cu_clear_lcb_handle
+ *
+ * Description      Drops the handle index entry of an LCB that is being
+ *                  allocated or released. The stale handle stays in the LCB;
+ *                  an entry the handle was reassigned to is left alone.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_clear_lcb_handle(tL2C_LCB* p_lcb) {
+  l2c_handle_index_clear(&l2cb.lcb_by_handle, p_lcb->handle,
+                         (uint8_t)(p_lcb - l2cb.lcb_pool));
+}
@@ -0,0 +1,42 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+/* Direct-mapped index from 12 bit HCI connection handles to LCB pool slots,
+ * so that the link of an ACL packet is found without walking the pool.
+ * All-zero memory is an empty index, so it lives in the memset l2cb. */
+#define L2C_HANDLE_INDEX_SIZE 0x1000
+
+typedef struct {
+  uint8_t slot[L2C_HANDLE_INDEX_SIZE]; /* pool slot + 1, 0 if none */
+} tL2C_HANDLE_INDEX;
+
+/* Handles outside the index are never mapped */
+inline bool l2c_handle_index_covers(uint16_t handle) {
+  return handle < L2C_HANDLE_INDEX_SIZE;
+}
+
+inline void l2c_handle_index_set(tL2C_HANDLE_INDEX* p_index, uint16_t handle,
+                                 uint8_t slot) {
+  if (l2c_handle_index_covers(handle)) p_index->slot[handle] = slot + 1;
+}
+
+/* Unmaps handle if it still maps to slot */
+inline void l2c_handle_index_clear(tL2C_HANDLE_INDEX* p_index, uint16_t handle,
+                                   uint8_t slot) {
+  if (l2c_handle_index_covers(handle) && p_index->slot[handle] == slot + 1)
+    p_index->slot[handle] = 0;
+}
+
+/* Returns the slot of handle, or -1 */
+inline int l2c_handle_index_get(const tL2C_HANDLE_INDEX* p_index,
+                                uint16_t handle) {
+  if (!l2c_handle_index_covers(handle)) return -1;
+  return (int)p_index->slot[handle] - 1;
+}
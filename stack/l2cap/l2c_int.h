@@ -66,6 +66,7 @@
 #include "btm_api.h"
 #include "btm_ble_api.h"
 #include "l2c_api.h"
+#include "l2c_handle_index.h"
 #include "l2cdefs.h"
 #include "osi/include/alarm.h"
 #include "osi/include/fixed_queue.h"
@@ -640,6 +641,7 @@ typedef struct {
   bool is_cong_cback_context;
 
   tL2C_LCB lcb_pool[MAX_L2CAP_LINKS];    /* Link Control Block pool */
+  tL2C_HANDLE_INDEX lcb_by_handle;       /* lcb_pool slots by HCI handle */
   tL2C_CCB ccb_pool[MAX_L2CAP_CHANNELS]; /* Channel Control Block pool */
   tL2C_RCB rcb_pool[MAX_L2CAP_CLIENTS];  /* Registration info pool */
 
@@ -684,6 +686,7 @@ typedef struct {
   tL2C_RCB coc_rcb_pool[L2CAP_COC_MAX_CLIENTS]; /* Registration info pool */
 
   tL2CA_ECHO_DATA_CB* p_echo_data_cb; /* Echo data callback */
+  tL2CA_LINK_TRAFFIC_CB* p_link_traffic_cb; /* BR/EDR ACL traffic callback */
 
 #if (L2CAP_HIGH_PRI_CHAN_QUOTA_IS_CONFIGURABLE == TRUE)
   uint16_t high_pri_min_xmit_quota; /* Minimum number of ACL credit for high
@@ -714,6 +717,8 @@ typedef struct {
 typedef struct {
     bool is_active;       /* is channel active */
     uint16_t local_cid;   /* Remote CID */
+    uint16_t remote_cid;  /* Remote CID, kept for the snoop log reset */
+    uint16_t handle;      /* ACL handle, kept for the snoop log reset */
     tL2C_CCB *p_ccb;      /* CCB */
 } tL2C_AVDT_CHANNEL_INFO;
 
@@ -770,6 +775,8 @@ extern void l2cu_release_lcb(tL2C_LCB* p_lcb);
 extern tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                           tBT_TRANSPORT transport);
 extern tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle);
+extern void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle);
+extern void l2cu_clear_lcb_handle(tL2C_LCB* p_lcb);
 extern void l2cu_update_lcb_4_bonding(const RawAddress& p_bd_addr,
                                       bool is_bonding);
 
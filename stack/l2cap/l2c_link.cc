@@ -208,7 +208,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   }
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   if (ci.status == HCI_SUCCESS) {
     /* Connected OK. Change state to connected */
@@ -266,7 +266,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   else if ((ci.status == HCI_ERR_MAX_NUM_OF_CONNECTIONS) &&
            l2cu_lcb_disconnecting()) {
     p_lcb->link_state = LST_CONNECT_HOLDING;
-    p_lcb->handle = HCI_INVALID_HANDLE;
+    l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
   } else {
     /* Just in case app decides to try again in the callback context */
     p_lcb->link_state = LST_DISCONNECTING;
@@ -535,7 +535,7 @@ bool l2c_link_hci_disc_comp(uint16_t handle, uint8_t reason) {
      }
       if (l2cu_create_conn(p_lcb, transport)) {
         lcb_is_free = false; /* still using this lcb */
-        p_lcb->handle = HCI_INVALID_HANDLE;
+        l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
         p_lcb->link_role = HCI_ROLE_MASTER; /* reset to default role */
       }
     }
@@ -1215,6 +1215,9 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
   uint16_t xmit_window, acl_data_size;
   const controller_t* controller = controller_get_interface();
 
+  if (p_lcb->transport == BT_TRANSPORT_BR_EDR && l2cb.p_link_traffic_cb)
+    (*l2cb.p_link_traffic_cb)(p_lcb->handle, p_buf->len);
+
   if ((p_buf->len <= controller->get_acl_packet_size_classic() &&
        (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
       ((p_lcb->transport == BT_TRANSPORT_LE) &&
@@ -1345,7 +1348,7 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
     /* Originally designed for [3DSG]                   */
     if ((p_lcb != NULL) && (p_lcb->p_nocp_cb)) {
       L2CAP_TRACE_DEBUG("L2CAP - calling NoCP callback");
-      (*p_lcb->p_nocp_cb)(p_lcb->remote_bd_addr);
+      (*p_lcb->p_nocp_cb)(p_lcb->remote_bd_addr, num_sent);
     }
 
     if (p_lcb) {
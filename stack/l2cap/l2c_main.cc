@@ -163,6 +163,10 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
   }
   STREAM_TO_UINT16(rcv_cid, p);
 
+  if (p_lcb && p_lcb->transport == BT_TRANSPORT_BR_EDR &&
+      l2cb.p_link_traffic_cb)
+    (*l2cb.p_link_traffic_cb)(handle, hci_len);
+
   /* for BLE channel, always notify connection when ACL data received on the
    * link */
   if (p_lcb && p_lcb->transport == BT_TRANSPORT_LE &&
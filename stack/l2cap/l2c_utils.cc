@@ -78,6 +78,7 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
     if (!p_lcb->in_use) {
       alarm_free(p_lcb->l2c_lcb_timer);
       alarm_free(p_lcb->info_resp_timer);
+      l2cu_clear_lcb_handle(p_lcb);
       memset(p_lcb, 0, sizeof(tL2C_LCB));
 
       p_lcb->remote_bd_addr = p_bd_addr;
@@ -150,6 +151,7 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   tL2C_CCB* p_ccb;
 
   p_lcb->in_use = false;
+  l2cu_clear_lcb_handle(p_lcb);
   p_lcb->is_bonding = false;
 
   /* Stop the timers */
@@ -1718,13 +1720,13 @@ void l2cu_release_ccb(tL2C_CCB* p_ccb) {
     btsnoop_get_interface()->set_l2cap_channel_close(p_ccb->p_lcb->handle,
                                         p_ccb->local_cid, p_ccb->remote_cid);
   }
-#if (defined(LE_L2CAP_CFC_INCLUDED) && (LE_L2CAP_CFC_INCLUDED == TRUE))
-  if (p_rcb && p_lcb && (p_rcb->psm != p_rcb->real_psm)) {
-#else
   if (p_lcb)
     btsnoop_get_interface()->clear_l2cap_whitelist(
         p_lcb->handle, p_ccb->local_cid, p_ccb->remote_cid);
 
+#if (defined(LE_L2CAP_CFC_INCLUDED) && (LE_L2CAP_CFC_INCLUDED == TRUE))
+  if (p_rcb && p_lcb && (p_rcb->psm != p_rcb->real_psm)) {
+#else
   if (p_rcb && (p_rcb->psm != p_rcb->real_psm)) {
 #endif
     btm_sec_clr_service_by_psm(p_rcb->psm);
@@ -3324,30 +3326,6 @@ void l2cu_send_peer_ble_credit_based_disconn_req(tL2C_CCB* p_ccb) {
  * Functions used by both Full and Light Stack
  ******************************************************************************/
 
-/*******************************************************************************
- *
- * Function         l2cu_find_lcb_by_handle
- *
- * Description      Look through all active LCBs for a match based on the
- *                  HCI handle.
- *
- * Returns          pointer to matched LCB, or NULL if no match
- *
- ******************************************************************************/
-tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
-
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
-    if ((p_lcb->in_use) && (p_lcb->handle == handle)) {
-      return (p_lcb);
-    }
-  }
-
-  /* If here, no match found */
-  return (NULL);
-}
-
 /*******************************************************************************
  *
  * Function         l2cu_find_ccb_by_cid
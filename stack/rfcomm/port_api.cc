@@ -1443,9 +1443,11 @@ int PORT_Write(uint16_t handle, BT_HDR* p_buf) {
 int PORT_WriteDataCO(uint16_t handle, int* p_len) {
   tPORT* p_port;
   BT_HDR* p_buf;
+  BT_HDR* bufs[PORT_TX_BUF_HIGH_WM + 1];
   uint32_t event = 0;
   int rc = 0;
   uint16_t length;
+  bool drained = false;
 
   RFCOMM_TRACE_API("PORT_WriteDataCO() handle:%d", handle);
   *p_len = 0;
@@ -1466,113 +1468,107 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
     RFCOMM_TRACE_ERROR("PORT_WriteDataByFd() peer_mtu:%d", p_port->peer_mtu);
     return (PORT_UNKNOWN_ERROR);
   }
-  int available = 0;
-  // if(ioctl(fd, FIONREAD, &available) < 0)
-  if (p_port->p_data_co_callback(
-          handle, (uint8_t*)&available, sizeof(available),
-          DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE) == false) {
-    RFCOMM_TRACE_ERROR(
-        "p_data_co_callback DATA_CO_CALLBACK_TYPE_INCOMING_SIZE failed, "
-        "available:%d",
-        available);
-    return (PORT_UNKNOWN_ERROR);
-  }
-  if (available == 0) return PORT_SUCCESS;
-  /* Length for each buffer is the smaller of GKI buffer, peer MTU, or max_len
-   */
+
+  /* Length for each buffer is the smaller of GKI buffer or peer MTU */
   length = RFCOMM_DATA_BUF_SIZE -
            (uint16_t)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
+  if (p_port->peer_mtu < length) length = p_port->peer_mtu;
 
-  /* If there are buffers scheduled for transmission check if requested */
-  /* data fits into the end of the queue */
-  mutex_global_lock();
-
-  p_buf = (BT_HDR*)fixed_queue_try_peek_last(p_port->tx.queue);
-  if ((p_buf != NULL) &&
-      (((int)p_buf->len + available) <= (int)p_port->peer_mtu) &&
-      (((int)p_buf->len + available) <= (int)length)) {
-    // if(recv(fd, (uint8_t *)(p_buf + 1) + p_buf->offset + p_buf->len,
-    // available, 0) != available)
-    if (p_port->p_data_co_callback(
-            handle, (uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len,
-            available, DATA_CO_CALLBACK_TYPE_OUTGOING) == false)
-
-    {
-      error(
-          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, "
-          "available:%d",
-          available);
-      mutex_global_unlock();
-      return (PORT_UNKNOWN_ERROR);
-    }
-    // memcpy ((uint8_t *)(p_buf + 1) + p_buf->offset + p_buf->len, p_data,
-    // max_len);
-    p_port->tx.queue_size += (uint16_t)available;
-
-    *p_len = available;
-    p_buf->len += (uint16_t)available;
-
-    mutex_global_unlock();
-
-    return (PORT_SUCCESS);
-  }
-
-  mutex_global_unlock();
-
-  // int max_read = length < p_port->peer_mtu ? length : p_port->peer_mtu;
-
-  // max_read = available < max_read ? available : max_read;
-
-  while (available) {
+  /* Read what the app has written straight into as many buffers as the tx
+   * queue takes, with one callout per batch, until the app has no more data
+   * pending. The global lock is not held across the callout. */
+  while (!drained) {
     /* if we're over buffer high water mark, we're done */
     if ((p_port->tx.queue_size > PORT_TX_HIGH_WM) ||
         (fixed_queue_length(p_port->tx.queue) > PORT_TX_BUF_HIGH_WM)) {
       port_flow_control_user(p_port);
       event |= PORT_EV_FC;
-      RFCOMM_TRACE_EVENT(
-          "tx queue is full,tx.queue_size:%d,tx.queue.count:%d,available:%d",
-          p_port->tx.queue_size, fixed_queue_length(p_port->tx.queue),
-          available);
+      RFCOMM_TRACE_EVENT("tx queue is full,tx.queue_size:%d,tx.queue.count:%d",
+                         p_port->tx.queue_size,
+                         fixed_queue_length(p_port->tx.queue));
       break;
     }
 
-    /* continue with rfcomm data write */
-    p_buf = (BT_HDR*)osi_malloc(RFCOMM_DATA_BUF_SIZE);
-    p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
-    p_buf->layer_specific = handle;
-
-    if (p_port->peer_mtu < length) length = p_port->peer_mtu;
-    if (available < (int)length) length = (uint16_t)available;
-    p_buf->len = length;
-    p_buf->event = BT_EVT_TO_BTU_SP_DATA;
+    int count = PORT_TX_BUF_HIGH_WM + 1 - fixed_queue_length(p_port->tx.queue);
+    int bytes_room = (PORT_TX_HIGH_WM - p_port->tx.queue_size) / length + 1;
+    if (bytes_room < count) count = bytes_room;
+
+    for (int i = 0; i < count; i++) {
+      p_buf = (BT_HDR*)osi_malloc(RFCOMM_DATA_BUF_SIZE);
+      p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
+      p_buf->layer_specific = handle;
+      p_buf->event = BT_EVT_TO_BTU_SP_DATA;
+      p_buf->len = 0;
+      bufs[i] = p_buf;
+    }
 
-    // memcpy ((uint8_t *)(p_buf + 1) + p_buf->offset, p_data, length);
-    // if(recv(fd, (uint8_t *)(p_buf + 1) + p_buf->offset, (int)length, 0) !=
-    // (int)length)
-    if (p_port->p_data_co_callback(
-            handle, (uint8_t*)(p_buf + 1) + p_buf->offset, length,
-            DATA_CO_CALLBACK_TYPE_OUTGOING) == false) {
+    tPORT_DATA_CO_BUFS co_bufs = {bufs, (uint16_t)count, length};
+    int received = p_port->p_data_co_callback(
+        handle, (uint8_t*)&co_bufs, sizeof(co_bufs),
+        DATA_CO_CALLBACK_TYPE_OUTGOING_BUFS);
+    if (received < 0) {
       error(
-          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, length:%d",
-          length);
+          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING_BUFS failed, "
+          "count:%d",
+          count);
+      for (int i = 0; i < count; i++) osi_free(bufs[i]);
       return (PORT_UNKNOWN_ERROR);
     }
+    if (received == 0) {
+      for (int i = 0; i < count; i++) osi_free(bufs[i]);
+      if (*p_len == 0) return (PORT_SUCCESS);
+      drained = true;
+      break;
+    }
+    drained = received < count * length;
 
-    RFCOMM_TRACE_EVENT("PORT_WriteData %d bytes", length);
+    /* A short write that fits into the end of the last queued buffer is
+     * appended to it */
+    if (*p_len == 0 && received < length) {
+      mutex_global_lock();
+      p_buf = (BT_HDR*)fixed_queue_try_peek_last(p_port->tx.queue);
+      if ((p_buf != NULL) &&
+          (((int)p_buf->len + received) <= (int)p_port->peer_mtu) &&
+          (((int)p_buf->len + received) <= (int)length)) {
+        memcpy((uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len,
+               (uint8_t*)(bufs[0] + 1) + bufs[0]->offset, received);
+        p_buf->len += (uint16_t)received;
+        p_port->tx.queue_size += (uint16_t)received;
+        *p_len = received;
+        bufs[0]->len = 0;
+      }
+      mutex_global_unlock();
+    }
 
-    rc = port_write(p_port, p_buf);
+    for (int i = 0; i < count; i++) {
+      p_buf = bufs[i];
+      if (p_buf->len == 0) {
+        osi_free(p_buf);
+        continue;
+      }
 
-    /* If queue went below the threashold need to send flow control */
-    event |= port_flow_control_user(p_port);
+      uint16_t buf_len = p_buf->len;
+      RFCOMM_TRACE_EVENT("PORT_WriteData %d bytes", buf_len);
 
-    if (rc == PORT_SUCCESS) event |= PORT_EV_TXCHAR;
+      rc = port_write(p_port, p_buf);
 
-    if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) break;
+      /* If queue went below the threashold need to send flow control */
+      event |= port_flow_control_user(p_port);
 
-    *p_len += length;
-    available -= (int)length;
+      if (rc == PORT_SUCCESS) event |= PORT_EV_TXCHAR;
+
+      if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) {
+        while (++i < count) osi_free(bufs[i]);
+        drained = false;
+        break;
+      }
+
+      *p_len += buf_len;
+    }
+
+    if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) break;
   }
-  if (!available && (rc != PORT_CMD_PENDING) && (rc != PORT_TX_QUEUE_DISABLED))
+  if (drained && (rc != PORT_CMD_PENDING) && (rc != PORT_TX_QUEUE_DISABLED))
     event |= PORT_EV_TXEMPTY;
 
   /* Mask out all events that are not of interest to user */
@@ -0,0 +1,373 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <chrono>
+#include <list>
+#include <random>
+#include <vector>
+
+#include "advertise_data_parser.h"
+#include "btm_ble_adv_cache.h"
+
+namespace {
+
+const uint8_t kSid = 0xFF;  // legacy reports carry no ADI
+const size_t kMaxLen = 1650;
+
+RawAddress Address(uint32_t n) {
+  RawAddress addr;
+  uint8_t bytes[RawAddress::kLength] = {0xC0, 0x10,
+                                        (uint8_t)(n >> 24), (uint8_t)(n >> 16),
+                                        (uint8_t)(n >> 8), (uint8_t)n};
+  memcpy(addr.address, bytes, sizeof(bytes));
+  return addr;
+}
+
+std::vector<uint8_t> Bytes(const AdvertisingCache::Data& data) {
+  return std::vector<uint8_t>(data.data, data.data + data.len);
+}
+
+}  // namespace
+
+TEST(AdvertisingCacheTest, single_report_is_handed_out_in_place) {
+  AdvertisingCache cache(4, kMaxLen);
+  uint8_t report[] = {0x02, 0x01, 0x06};
+  AdvertisingCache::Data out;
+
+  EXPECT_EQ(AdvertisingCache::kComplete,
+            cache.Add(0, Address(1), kSid, false, false, false, report,
+                      sizeof(report), &out));
+  EXPECT_EQ(report, out.data);
+  EXPECT_EQ(sizeof(report), out.len);
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(AdvertisingCacheTest, scan_response_is_appended) {
+  AdvertisingCache cache(4, kMaxLen);
+  std::vector<uint8_t> adv = {0x02, 0x01, 0x06};
+  std::vector<uint8_t> rsp = {0x03, 0x09, 'h', 'i'};
+  AdvertisingCache::Data out;
+
+  EXPECT_EQ(AdvertisingCache::kPending,
+            cache.Add(0, Address(1), kSid, true, false, true, adv.data(),
+                      adv.size(), &out));
+  EXPECT_EQ(1u, cache.size());
+  // Another device in between does not disturb the first one
+  EXPECT_EQ(AdvertisingCache::kPending,
+            cache.Add(0, Address(2), kSid, true, false, true, rsp.data(),
+                      rsp.size(), &out));
+
+  EXPECT_EQ(AdvertisingCache::kComplete,
+            cache.Add(0, Address(1), kSid, false, false, false, rsp.data(),
+                      rsp.size(), &out));
+  std::vector<uint8_t> expected = adv;
+  expected.insert(expected.end(), rsp.begin(), rsp.end());
+  EXPECT_EQ(expected, Bytes(out));
+  EXPECT_EQ(1u, cache.size());
+}
+
+TEST(AdvertisingCacheTest, new_event_discards_stale_data) {
+  AdvertisingCache cache(4, kMaxLen);
+  std::vector<uint8_t> first = {0x02, 0x01, 0x06};
+  std::vector<uint8_t> second = {0x02, 0x01, 0x04};
+  AdvertisingCache::Data out;
+
+  cache.Add(0, Address(1), kSid, true, false, true, first.data(), first.size(),
+            &out);
+  cache.Add(0, Address(1), kSid, true, false, true, second.data(),
+            second.size(), &out);
+  EXPECT_EQ(AdvertisingCache::kComplete,
+            cache.Add(0, Address(1), kSid, false, false, false, nullptr, 0,
+                      &out));
+  EXPECT_EQ(second, Bytes(out));
+}
+
+TEST(AdvertisingCacheTest, chained_reports_keyed_by_sid) {
+  AdvertisingCache cache(4, kMaxLen);
+  std::vector<uint8_t> a(200, 0xA0), b(200, 0xB0);
+  AdvertisingCache::Data out;
+
+  // Two advertising sets of one device interleave their chains
+  EXPECT_EQ(AdvertisingCache::kPending,
+            cache.Add(1, Address(1), 1, false, true, false, a.data(), a.size(),
+                      &out));
+  EXPECT_EQ(AdvertisingCache::kPending,
+            cache.Add(1, Address(1), 2, false, true, false, b.data(), b.size(),
+                      &out));
+  EXPECT_EQ(AdvertisingCache::kComplete,
+            cache.Add(1, Address(1), 1, false, false, false, a.data(),
+                      a.size(), &out));
+  EXPECT_EQ(400u, out.len);
+  EXPECT_EQ(0xA0, out.data[399]);
+  EXPECT_EQ(AdvertisingCache::kComplete,
+            cache.Add(1, Address(1), 2, false, false, false, b.data(),
+                      b.size(), &out));
+  EXPECT_EQ(400u, out.len);
+  EXPECT_EQ(0xB0, out.data[0]);
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(AdvertisingCacheTest, oversized_data_is_dropped) {
+  AdvertisingCache cache(4, 300);
+  std::vector<uint8_t> chunk(200, 0x11);
+  AdvertisingCache::Data out;
+
+  cache.Add(1, Address(1), 0, false, true, false, chunk.data(), chunk.size(),
+            &out);
+  EXPECT_EQ(AdvertisingCache::kDropped,
+            cache.Add(1, Address(1), 0, false, true, false, chunk.data(),
+                      chunk.size(), &out));
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(1u, cache.TakeStats().dropped);
+}
+
+TEST(AdvertisingCacheTest, least_recently_updated_is_evicted) {
+  AdvertisingCache cache(3, kMaxLen);
+  uint8_t byte = 0x01;
+  AdvertisingCache::Data out;
+
+  for (uint32_t i = 1; i <= 3; i++)
+    cache.Add(0, Address(i), kSid, false, true, false, &byte, 1, &out);
+  // Touch device 1 so device 2 becomes the oldest
+  cache.Add(0, Address(1), kSid, false, true, false, &byte, 1, &out);
+  cache.Add(0, Address(4), kSid, false, true, false, &byte, 1, &out);
+  EXPECT_EQ(3u, cache.size());
+  EXPECT_EQ(1u, cache.TakeStats().evicted);
+
+  // Device 2 starts over, the others kept their data
+  cache.Add(0, Address(2), kSid, false, false, false, &byte, 1, &out);
+  EXPECT_EQ(1u, out.len);
+  cache.Add(0, Address(1), kSid, false, false, false, &byte, 1, &out);
+  EXPECT_EQ(3u, out.len);
+
+  cache.ClearAll();
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(AdvertisingCacheTest, random_churn_matches_model) {
+  const size_t kCapacity = 16;
+  AdvertisingCache cache(kCapacity, kMaxLen);
+  // Reference model: most recently updated first
+  struct Item {
+    uint32_t device;
+    std::vector<uint8_t> data;
+  };
+  std::list<Item> model;
+  std::mt19937 rng(31);
+
+  for (int i = 0; i < 50000; i++) {
+    uint32_t device = rng() % 40;
+    bool start = rng() % 4 == 0;
+    bool more = rng() % 2;
+    std::vector<uint8_t> data(rng() % 8, (uint8_t)i);
+
+    auto it = model.begin();
+    while (it != model.end() && it->device != device) it++;
+    if (start && it != model.end()) {
+      model.erase(it);
+      it = model.end();
+    }
+
+    AdvertisingCache::Data out;
+    AdvertisingCache::Result result =
+        cache.Add(0, Address(device), kSid, start, more, false, data.data(),
+                  data.size(), &out);
+
+    std::vector<uint8_t> expected;
+    if (it != model.end()) {
+      expected = it->data;
+      model.erase(it);
+    }
+    expected.insert(expected.end(), data.begin(), data.end());
+    if (more) {
+      ASSERT_EQ(AdvertisingCache::kPending, result);
+      if (model.size() == kCapacity) model.pop_back();
+      model.push_front({device, expected});
+    } else {
+      ASSERT_EQ(AdvertisingCache::kComplete, result);
+      ASSERT_EQ(expected, Bytes(out)) << "step " << i;
+    }
+    ASSERT_EQ(model.size(), cache.size());
+  }
+}
+
+namespace {
+
+// The advertising cache as it was before: a short list of vectors.
+class ListCache {
+ public:
+  const std::vector<uint8_t>& Set(const RawAddress& addr,
+                                  std::vector<uint8_t> data) {
+    auto it = Find(addr);
+    if (it != items.end()) {
+      it->second = std::move(data);
+      return it->second;
+    }
+    if (items.size() > 7) items.pop_back();
+    items.emplace_front(addr, std::move(data));
+    return items.front().second;
+  }
+
+  const std::vector<uint8_t>& Append(const RawAddress& addr,
+                                     std::vector<uint8_t> data) {
+    auto it = Find(addr);
+    if (it != items.end()) {
+      it->second.insert(it->second.end(), data.begin(), data.end());
+      return it->second;
+    }
+    if (items.size() > 7) items.pop_back();
+    items.emplace_front(addr, std::move(data));
+    return items.front().second;
+  }
+
+  void Clear(const RawAddress& addr) {
+    auto it = Find(addr);
+    if (it != items.end()) items.erase(it);
+  }
+
+ private:
+  std::list<std::pair<RawAddress, std::vector<uint8_t>>>::iterator Find(
+      const RawAddress& addr) {
+    for (auto it = items.begin(); it != items.end(); it++)
+      if (it->first == addr) return it;
+    return items.end();
+  }
+
+  std::list<std::pair<RawAddress, std::vector<uint8_t>>> items;
+};
+
+// Builds LE Advertising Report events, one report each, from |devices| tags
+// that alternate ADV_IND and SCAN_RSP the way an active scan sees them.
+std::vector<std::vector<uint8_t>> AdvertisingReportEvents(int count,
+                                                          uint32_t devices) {
+  std::vector<std::vector<uint8_t>> events;
+  std::mt19937 rng(5);
+  std::vector<uint32_t> waiting;
+  for (int i = 0; i < count; i++) {
+    uint8_t evt_type;
+    uint32_t device;
+    // Scan responses trail their ADV_IND by a few other reports
+    if (waiting.size() > 4 || (!waiting.empty() && rng() % 2)) {
+      evt_type = 0x04;  // SCAN_RSP
+      device = waiting.front();
+      waiting.erase(waiting.begin());
+    } else {
+      evt_type = 0x00;  // ADV_IND
+      device = rng() % devices;
+      waiting.push_back(device);
+    }
+
+    std::vector<uint8_t> data;
+    if (evt_type == 0x00) {
+      data = {0x02, 0x01, 0x06, 0x03, 0x03, 0x0F, 0x18, 0x0B, 0xFF, 0x4C,
+              0x00, 0x02, 0x15, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    } else {
+      data = {0x09, 0x09, 'T', 'a', 'g', '-', '0', '0', '0', '0',
+              0x02, 0x0A, 0x00};
+    }
+    data.resize(31, 0);  // zero padded as many tags do
+
+    RawAddress addr = Address(device);
+    std::vector<uint8_t> event = {1 /* num_reports */, evt_type,
+                                  0 /* public */};
+    for (int b = RawAddress::kLength - 1; b >= 0; b--)
+      event.push_back(addr.address[b]);
+    event.push_back(data.size());
+    event.insert(event.end(), data.begin(), data.end());
+    event.push_back((uint8_t)-60);  // rssi
+    events.push_back(event);
+  }
+  return events;
+}
+
+struct Report {
+  uint8_t evt_type;
+  RawAddress addr;
+  uint8_t* data;
+  uint8_t data_len;
+};
+
+bool ParseReport(uint8_t* p, Report* report) {
+  p++;  // num_reports
+  report->evt_type = *p++;
+  p++;  // address type
+  for (int b = RawAddress::kLength - 1; b >= 0; b--)
+    report->addr.address[b] = *p++;
+  report->data_len = *p++;
+  report->data = p;
+  return true;
+}
+
+// Work done on complete data in both pipelines
+int Consume(const uint8_t* data, size_t len) {
+  if (!AdvertiseDataParser::IsValid(data, len)) return 0;
+  uint8_t flag_len;
+  return AdvertiseDataParser::GetFieldByType(data, len, 0x01, &flag_len) !=
+         nullptr;
+}
+
+}  // namespace
+
+// Feeds synthetic LE Advertising Report events from a few hundred tags
+// through the report path: parse, trim, reassemble ADV_IND with SCAN_RSP and
+// inspect the complete data. Compares with the list cache and vector copies
+// it replaces.
+TEST(AdvertisingCacheTest, advertising_report_benchmark) {
+  const int kEvents = 200000;
+  auto events = AdvertisingReportEvents(kEvents, 400);
+
+  AdvertisingCache cache(64, kMaxLen);
+  int complete = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& event : events) {
+    Report r;
+    ParseReport(event.data(), &r);
+    bool is_start = r.evt_type == 0x00;
+    size_t len = AdvertiseDataParser::RemoveTrailingZeros(r.data, r.data_len);
+    AdvertisingCache::Data out;
+    if (cache.Add(0, r.addr, kSid, is_start, false, is_start, r.data, len,
+                  &out) == AdvertisingCache::kComplete)
+      complete += Consume(out.data, out.len);
+  }
+  auto cache_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+  ListCache list;
+  int list_complete = 0;
+  start = std::chrono::steady_clock::now();
+  for (auto& event : events) {
+    Report r;
+    ParseReport(event.data(), &r);
+    bool is_start = r.evt_type == 0x00;
+    std::vector<uint8_t> tmp(r.data, r.data + r.data_len);
+    AdvertiseDataParser::RemoveTrailingZeros(tmp);
+    std::vector<uint8_t> adv_data = is_start
+                                        ? list.Set(r.addr, std::move(tmp))
+                                        : list.Append(r.addr, std::move(tmp));
+    if (is_start) continue;
+    list_complete += Consume(adv_data.data(), adv_data.size());
+    list.Clear(r.addr);
+  }
+  auto list_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  AdvertisingCache::Stats stats = cache.TakeStats();
+  EXPECT_EQ(0u, stats.evicted);
+  EXPECT_GE(complete, list_complete);
+  // Several thousand reports per second leave plenty of headroom
+  EXPECT_LT(cache_ns / kEvents, 100000);
+  printf("advertising reports: cache %.0f ns/report (%d complete), "
+         "list %.0f ns/report (%d complete)\n",
+         (double)cache_ns / kEvents, complete, (double)list_ns / kEvents,
+         list_complete);
+}
@@ -0,0 +1,496 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "btm_ble_batchscan_reader.h"
+
+namespace {
+
+const uint8_t kTruncated = BatchScanReader::kFormatTruncated;
+const uint8_t kFull = BatchScanReader::kFormatFull;
+
+std::vector<uint8_t> TruncatedRecord(uint32_t n) {
+  std::vector<uint8_t> record(BatchScanReader::kTruncatedRecordLen);
+  for (size_t i = 0; i < record.size(); i++) record[i] = (uint8_t)(n + i);
+  return record;
+}
+
+std::vector<uint8_t> FullRecord(uint32_t n, uint8_t adv_len,
+                                uint8_t scan_rsp_len) {
+  std::vector<uint8_t> record = TruncatedRecord(n);
+  record.push_back(adv_len);
+  for (uint8_t i = 0; i < adv_len; i++) record.push_back((uint8_t)(n * 3 + i));
+  record.push_back(scan_rsp_len);
+  for (uint8_t i = 0; i < scan_rsp_len; i++)
+    record.push_back((uint8_t)(n * 5 + i));
+  return record;
+}
+
+// What the controller stores: records, handed out as many at a time as fit
+// in one Read Results response.
+class FakeController {
+ public:
+  FakeController(uint8_t report_format,
+                 const std::vector<std::vector<uint8_t>>& records)
+      : report_format_(report_format), records_(records) {}
+
+  // The next response: the count of records and their bytes
+  uint8_t NextChunk(std::vector<uint8_t>* chunk) {
+    chunk->clear();
+    uint8_t count = 0;
+    while (next_ < records_.size() &&
+           chunk->size() + records_[next_].size() <=
+               BatchScanReader::kMaxChunkBytes) {
+      chunk->insert(chunk->end(), records_[next_].begin(),
+                    records_[next_].end());
+      next_++;
+      count++;
+    }
+    return count;
+  }
+
+  uint8_t report_format() const { return report_format_; }
+
+ private:
+  uint8_t report_format_;
+  std::vector<std::vector<uint8_t>> records_;
+  size_t next_ = 0;
+};
+
+struct Batch {
+  uint8_t status;
+  uint8_t report_format;
+  uint8_t num_records;
+  std::vector<uint8_t> data;
+  bool last;
+};
+
+// Runs a reader against |controller|: reads are answered one at a time by
+// Step(), and batches stay with the consumer until Consume().
+class Harness {
+ public:
+  explicit Harness(FakeController* controller)
+      : controller_(controller),
+        reader_([this](uint8_t scan_mode) { reads_.push_back(scan_mode); }) {
+    batches_.reserve(1024);
+  }
+
+  void Read(uint8_t scan_mode) {
+    reader_.Read(scan_mode, [this](uint8_t status, uint8_t report_format,
+                                   uint8_t num_records,
+                                   std::vector<uint8_t> data, bool last) {
+      held_bytes_ += data.size();
+      peak_held_bytes_ = std::max(peak_held_bytes_, held_bytes_);
+      batches_.push_back(
+          Batch{status, report_format, num_records, std::move(data), last});
+      unconsumed_++;
+    });
+  }
+
+  // Answers the pending Read Results command, if any
+  bool Step() {
+    if (reads_.empty()) return false;
+    reads_.pop_front();
+    std::vector<uint8_t> chunk;
+    uint8_t count = controller_->NextChunk(&chunk);
+    reader_.OnChunk(0, controller_->report_format(), count, chunk.data(),
+                    (uint16_t)chunk.size());
+    return true;
+  }
+
+  // The consumer is done with its oldest batch
+  bool Consume() {
+    if (unconsumed_ == 0) return false;
+    held_bytes_ -= batches_[batches_.size() - unconsumed_].data.size();
+    unconsumed_--;
+    reader_.Consumed();
+    return true;
+  }
+
+  void RunToCompletion() {
+    while (Step() || Consume()) {
+    }
+  }
+
+  std::vector<uint8_t> AllData() const {
+    std::vector<uint8_t> all;
+    for (const Batch& batch : batches_)
+      all.insert(all.end(), batch.data.begin(), batch.data.end());
+    return all;
+  }
+
+  size_t AllRecords() const {
+    size_t records = 0;
+    for (const Batch& batch : batches_) records += batch.num_records;
+    return records;
+  }
+
+  BatchScanReader& reader() { return reader_; }
+  std::deque<uint8_t>& reads() { return reads_; }
+  const std::vector<Batch>& batches() const { return batches_; }
+  size_t peak_held_bytes() const { return peak_held_bytes_; }
+
+ private:
+  FakeController* controller_;
+  std::deque<uint8_t> reads_;
+  BatchScanReader reader_;
+  std::vector<Batch> batches_;
+  size_t unconsumed_ = 0;
+  size_t held_bytes_ = 0;
+  size_t peak_held_bytes_ = 0;
+};
+
+std::vector<uint8_t> Concat(const std::vector<std::vector<uint8_t>>& records) {
+  std::vector<uint8_t> all;
+  for (const std::vector<uint8_t>& record : records)
+    all.insert(all.end(), record.begin(), record.end());
+  return all;
+}
+
+// Splits |data| into full records, as the scanner does
+size_t CountFullRecords(const std::vector<uint8_t>& data) {
+  size_t records = 0;
+  size_t pos = 0;
+  while (pos < data.size()) {
+    pos += BatchScanReader::kTruncatedRecordLen;
+    pos += 1 + data[pos];
+    pos += 1 + data[pos];
+    records++;
+  }
+  return pos == data.size() ? records : 0;
+}
+
+}  // namespace
+
+TEST(BatchScanReaderTest, truncated_reports_are_delivered_in_bounded_batches) {
+  std::vector<std::vector<uint8_t>> records;
+  for (uint32_t n = 0; n < 500; n++) records.push_back(TruncatedRecord(n));
+  FakeController controller(kTruncated, records);
+  Harness harness(&controller);
+
+  harness.Read(kTruncated);
+  harness.RunToCompletion();
+
+  EXPECT_FALSE(harness.reader().IsReading());
+  EXPECT_GT(harness.batches().size(), 1u);
+  for (const Batch& batch : harness.batches()) {
+    EXPECT_EQ(0, batch.status);
+    EXPECT_EQ(kTruncated, batch.report_format);
+    EXPECT_LE(batch.data.size(), BatchScanReader::kBatchBytes);
+    EXPECT_EQ(batch.num_records * BatchScanReader::kTruncatedRecordLen,
+              batch.data.size());
+  }
+  EXPECT_EQ(500u, harness.AllRecords());
+  EXPECT_EQ(Concat(records), harness.AllData());
+  EXPECT_TRUE(harness.batches().back().last);
+}
+
+TEST(BatchScanReaderTest, full_reports_are_never_split) {
+  std::mt19937 rng(7);
+  std::vector<std::vector<uint8_t>> records;
+  for (uint32_t n = 0; n < 300; n++)
+    records.push_back(FullRecord(n, rng() % 32, rng() % 32));
+  FakeController controller(kFull, records);
+  Harness harness(&controller);
+
+  harness.Read(kFull);
+  harness.RunToCompletion();
+
+  size_t total = 0;
+  for (const Batch& batch : harness.batches()) {
+    EXPECT_EQ(kFull, batch.report_format);
+    EXPECT_LE(batch.data.size(), BatchScanReader::kBatchBytes);
+    EXPECT_EQ(batch.num_records, CountFullRecords(batch.data));
+    total += batch.num_records;
+  }
+  EXPECT_EQ(300u, total);
+  EXPECT_EQ(Concat(records), harness.AllData());
+  EXPECT_EQ(0u, harness.reader().stats().malformed_bytes);
+}
+
+TEST(BatchScanReaderTest, no_reports_deliver_one_empty_report) {
+  FakeController controller(kTruncated, {});
+  Harness harness(&controller);
+
+  harness.Read(kTruncated);
+  harness.RunToCompletion();
+
+  ASSERT_EQ(1u, harness.batches().size());
+  EXPECT_EQ(0, harness.batches()[0].status);
+  EXPECT_EQ(0, harness.batches()[0].num_records);
+  EXPECT_TRUE(harness.batches()[0].data.empty());
+  EXPECT_TRUE(harness.batches()[0].last);
+  EXPECT_FALSE(harness.reader().IsReading());
+}
+
+TEST(BatchScanReaderTest, failed_read_reports_its_status) {
+  FakeController controller(kTruncated, {});
+  Harness harness(&controller);
+
+  harness.Read(kTruncated);
+  ASSERT_EQ(1u, harness.reads().size());
+  harness.reads().pop_front();
+  harness.reader().OnReadFailed(0x0C);
+
+  ASSERT_EQ(1u, harness.batches().size());
+  EXPECT_EQ(0x0C, harness.batches()[0].status);
+  EXPECT_EQ(0, harness.batches()[0].num_records);
+  EXPECT_TRUE(harness.batches()[0].last);
+}
+
+// The scanner reports each read once, when its last batch arrives. Whatever
+// the number of records, and whether or not the ring drained before the
+// controller ran out, exactly one batch per read is the last. Full records of
+// 128 bytes come one per response and fill batches exactly, so every eighth
+// count drains the ring before the controller reports it has no more.
+TEST(BatchScanReaderTest, every_read_ends_with_one_last_batch) {
+  size_t drained = 0;
+  for (uint8_t report_format : {kTruncated, kFull}) {
+    for (uint32_t count = 0; count <= 400; count++) {
+      std::vector<std::vector<uint8_t>> records;
+      for (uint32_t n = 0; n < count; n++)
+        records.push_back(report_format == kTruncated ? TruncatedRecord(n)
+                                                      : FullRecord(n, 57, 58));
+      FakeController controller(report_format, records);
+      Harness harness(&controller);
+
+      harness.Read(report_format);
+      harness.RunToCompletion();
+
+      ASSERT_FALSE(harness.batches().empty());
+      size_t last = 0;
+      for (const Batch& batch : harness.batches()) last += batch.last;
+      EXPECT_EQ(1u, last) << count << " records";
+      EXPECT_TRUE(harness.batches().back().last) << count << " records";
+      EXPECT_EQ(count, harness.AllRecords());
+      EXPECT_EQ(Concat(records), harness.AllData());
+      if (count > 0 && harness.batches().back().num_records == 0) drained++;
+    }
+  }
+  EXPECT_GT(drained, 0u);
+}
+
+TEST(BatchScanReaderTest, reading_waits_for_the_consumer) {
+  std::vector<std::vector<uint8_t>> records;
+  for (uint32_t n = 0; n < 2000; n++) records.push_back(TruncatedRecord(n));
+  FakeController controller(kTruncated, records);
+  Harness harness(&controller);
+
+  // Nothing is consumed: the ring fills up and reading stops
+  harness.Read(kTruncated);
+  while (harness.Step()) {
+  }
+  EXPECT_TRUE(harness.reader().IsReading());
+  EXPECT_EQ(BatchScanReader::kMaxBatchesInFlight,
+            harness.reader().BatchesInFlight());
+  EXPECT_EQ((size_t)BatchScanReader::kMaxBatchesInFlight,
+            harness.batches().size());
+  EXPECT_GT(harness.reader().RingBytes() + BatchScanReader::kMaxChunkBytes,
+            BatchScanReader::kRingBytes);
+  EXPECT_LE(harness.reader().RingBytes(), BatchScanReader::kRingBytes);
+  EXPECT_EQ(1u, harness.reader().stats().pauses);
+
+  // Each consumed batch makes room for more
+  EXPECT_TRUE(harness.Consume());
+  EXPECT_EQ(1u, harness.reads().size());
+
+  harness.RunToCompletion();
+  EXPECT_FALSE(harness.reader().IsReading());
+  EXPECT_EQ(2000u, harness.AllRecords());
+  EXPECT_EQ(Concat(records), harness.AllData());
+}
+
+TEST(BatchScanReaderTest, malformed_records_are_dropped) {
+  std::vector<uint8_t> first = FullRecord(1, 10, 4);
+  std::vector<uint8_t> chunk = first;
+  // Announces 20 bytes of advertising data but carries only 5
+  std::vector<uint8_t> broken = FullRecord(2, 5, 0);
+  broken[BatchScanReader::kTruncatedRecordLen] = 20;
+  chunk.insert(chunk.end(), broken.begin(), broken.end());
+
+  FakeController controller(kFull, {});
+  Harness harness(&controller);
+  harness.Read(kFull);
+  harness.reads().pop_front();
+  harness.reader().OnChunk(0, kFull, 2, chunk.data(), (uint16_t)chunk.size());
+  EXPECT_EQ(broken.size(), harness.reader().stats().malformed_bytes);
+  harness.RunToCompletion();
+
+  ASSERT_EQ(1u, harness.batches().size());
+  EXPECT_EQ(1, harness.batches()[0].num_records);
+  EXPECT_EQ(first, harness.batches()[0].data);
+}
+
+TEST(BatchScanReaderTest, records_announced_but_not_sent_end_the_read) {
+  FakeController controller(kTruncated, {});
+  Harness harness(&controller);
+  harness.Read(kTruncated);
+  harness.reads().pop_front();
+  harness.reader().OnChunk(0, kTruncated, 5, nullptr, 0);
+
+  EXPECT_TRUE(harness.reads().empty());
+  EXPECT_FALSE(harness.reader().IsReading());
+  ASSERT_EQ(1u, harness.batches().size());
+  EXPECT_EQ(0, harness.batches()[0].num_records);
+}
+
+TEST(BatchScanReaderTest, reads_run_one_after_another) {
+  std::vector<std::vector<uint8_t>> records;
+  for (uint32_t n = 0; n < 40; n++) records.push_back(TruncatedRecord(n));
+  FakeController controller(kTruncated, records);
+  Harness harness(&controller);
+
+  harness.Read(kTruncated);
+  harness.Read(kFull);
+  EXPECT_EQ(1u, harness.reads().size());
+  EXPECT_EQ(kTruncated, harness.reads().front());
+
+  // The second read starts once the first one is done
+  harness.RunToCompletion();
+  ASSERT_EQ(2u, harness.batches().size());
+  EXPECT_EQ(40, harness.batches()[0].num_records);
+  EXPECT_TRUE(harness.batches()[0].last);
+  EXPECT_EQ(0, harness.batches()[1].num_records);
+  EXPECT_TRUE(harness.batches()[1].last);
+  EXPECT_FALSE(harness.reader().IsReading());
+}
+
+TEST(BatchScanReaderTest, reset_drops_reads_and_records) {
+  std::vector<std::vector<uint8_t>> records;
+  for (uint32_t n = 0; n < 40; n++) records.push_back(TruncatedRecord(n));
+  FakeController controller(kTruncated, records);
+  Harness harness(&controller);
+
+  harness.Read(kTruncated);
+  harness.Step();
+  EXPECT_GT(harness.reader().RingRecords(), 0u);
+  harness.reader().Reset();
+  EXPECT_FALSE(harness.reader().IsReading());
+  EXPECT_EQ(0u, harness.reader().RingBytes());
+
+  // A late response to the dropped read is ignored
+  harness.Step();
+  EXPECT_TRUE(harness.batches().empty());
+}
+
+// Reads a large store of full reports. The consumer hands a batch over after
+// a delay of several responses, as a busy JNI thread would. The previous read
+// loop appended every response to one growing buffer and copied it into the
+// callback at the end.
+TEST(BatchScanReaderTest, large_result_set_memory_and_latency) {
+  const uint32_t kRecords = 20000;
+  const int kConsumerDelay = 8;
+  using Clock = std::chrono::steady_clock;
+
+  std::mt19937 rng(42);
+  std::vector<std::vector<uint8_t>> records;
+  for (uint32_t n = 0; n < kRecords; n++)
+    records.push_back(FullRecord(n, rng() % 32, rng() % 32));
+  const std::vector<uint8_t> expected = Concat(records);
+
+  // Previous read loop
+  FakeController legacy_controller(kFull, records);
+  std::vector<uint8_t> data_all;
+  size_t legacy_peak = 0;
+  size_t legacy_chunks = 0;
+  Clock::duration legacy_max{};
+  Clock::duration legacy_total{};
+  std::vector<uint8_t> legacy_delivered;
+  for (;;) {
+    std::vector<uint8_t> chunk;
+    uint8_t count = legacy_controller.NextChunk(&chunk);
+    Clock::time_point start = Clock::now();
+    if (count == 0) {
+      std::vector<uint8_t> copy(data_all);
+      legacy_peak = std::max(legacy_peak, data_all.capacity() + copy.size());
+      legacy_delivered = std::move(copy);
+    } else {
+      data_all.insert(data_all.end(), chunk.begin(), chunk.end());
+      legacy_peak = std::max(legacy_peak, data_all.capacity());
+    }
+    Clock::duration elapsed = Clock::now() - start;
+    legacy_total += elapsed;
+    legacy_max = std::max(legacy_max, elapsed);
+    legacy_chunks++;
+    if (count == 0) break;
+  }
+  ASSERT_EQ(expected, legacy_delivered);
+
+  // Streaming reader
+  FakeController controller(kFull, records);
+  Harness harness(&controller);
+  harness.Read(kFull);
+  size_t chunks = 0;
+  Clock::duration max{};
+  Clock::duration total{};
+  int delay = 0;
+  while (!harness.reads().empty() || harness.Consume()) {
+    if (harness.reads().empty()) continue;
+    Clock::time_point start = Clock::now();
+    harness.Step();
+    Clock::duration elapsed = Clock::now() - start;
+    total += elapsed;
+    max = std::max(max, elapsed);
+    chunks++;
+    if (++delay == kConsumerDelay) {
+      delay = 0;
+      harness.Consume();
+    }
+  }
+  ASSERT_FALSE(harness.reader().IsReading());
+  ASSERT_EQ(expected, harness.AllData());
+  ASSERT_EQ(kRecords, harness.AllRecords());
+  size_t peak = sizeof(BatchScanReader) + harness.peak_held_bytes();
+
+  // btif_ble_scanner keeps the batches of a read and joins them once, when
+  // the last one arrives, so the HAL still gets the whole read in one buffer
+  size_t gathered = harness.batches().size() * sizeof(std::vector<uint8_t>);
+  for (const Batch& batch : harness.batches())
+    gathered += batch.data.capacity();
+  std::vector<uint8_t> joined;
+  joined.reserve(expected.size());
+  for (const Batch& batch : harness.batches())
+    joined.insert(joined.end(), batch.data.begin(), batch.data.end());
+  ASSERT_EQ(expected, joined);
+  size_t end_to_end_peak = peak + gathered + joined.capacity();
+
+  auto ns = [](Clock::duration d) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d)
+        .count();
+  };
+  printf("%u full records, %zu bytes\n", kRecords, expected.size());
+  printf("  legacy:    peak %8zu bytes, %5zu chunks, %8.0f ns avg, %9.0f ns "
+         "max per chunk\n",
+         legacy_peak, legacy_chunks, ns(legacy_total) / legacy_chunks,
+         ns(legacy_max));
+  printf("  streaming: peak %8zu bytes, %5zu chunks, %8.0f ns avg, %9.0f ns "
+         "max per chunk, %zu batches, %llu pauses\n",
+         peak, chunks, ns(total) / chunks, ns(max),
+         harness.batches().size(),
+         (unsigned long long)harness.reader().stats().pauses);
+  printf("  end to end (stack, gathered batches and joined read): peak %zu "
+         "bytes\n",
+         end_to_end_peak);
+
+  EXPECT_GE(legacy_peak, 2 * expected.size());
+  EXPECT_LE(harness.peak_held_bytes(),
+            BatchScanReader::kMaxBatchesInFlight * BatchScanReader::kBatchBytes);
+  EXPECT_LT(peak * 20, legacy_peak);
+  EXPECT_EQ(expected.size(), joined.capacity());
+  EXPECT_LE(end_to_end_peak, legacy_peak);
+  EXPECT_GT(harness.reader().stats().pauses, 0u);
+}
@@ -0,0 +1,368 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "btm_ble_wl_sync.h"
+
+namespace {
+
+const uint8_t kPublic = 0;
+const uint8_t kRandom = 1;
+
+RawAddress Address(uint32_t n) {
+  RawAddress addr;
+  uint8_t bytes[RawAddress::kLength] = {0x00, 0x11, (uint8_t)(n >> 24),
+                                        (uint8_t)(n >> 16), (uint8_t)(n >> 8),
+                                        (uint8_t)n};
+  memcpy(addr.address, bytes, sizeof(bytes));
+  return addr;
+}
+
+bool NeverSkip(const RawAddress&) { return false; }
+
+std::set<RawAddress> Addresses(const std::vector<WhiteListSync::Entry>& v) {
+  std::set<RawAddress> addresses;
+  for (const WhiteListSync::Entry& entry : v) addresses.insert(entry.address);
+  return addresses;
+}
+
+}  // namespace
+
+TEST(WhiteListSyncTest, sends_only_the_changes) {
+  WhiteListSync sync;
+  sync.Add(kPublic, Address(1));
+  sync.Add(kPublic, Address(2));
+
+  WhiteListSync::Plan plan = sync.Reconcile(NeverSkip);
+  EXPECT_FALSE(plan.clear);
+  EXPECT_TRUE(plan.remove.empty());
+  EXPECT_EQ(std::set<RawAddress>({Address(1), Address(2)}),
+            Addresses(plan.add));
+  EXPECT_FALSE(sync.IsInController(Address(1)));
+  sync.Apply(plan);
+  EXPECT_TRUE(sync.IsInController(Address(1)));
+  EXPECT_TRUE(sync.Reconcile(NeverSkip).Empty());
+
+  sync.Remove(Address(1));
+  sync.Add(kPublic, Address(3));
+  plan = sync.Reconcile(NeverSkip);
+  EXPECT_FALSE(plan.clear);
+  EXPECT_EQ(std::set<RawAddress>({Address(1)}), Addresses(plan.remove));
+  EXPECT_EQ(std::set<RawAddress>({Address(3)}), Addresses(plan.add));
+  sync.Apply(plan);
+  EXPECT_TRUE(sync.Reconcile(NeverSkip).Empty());
+}
+
+TEST(WhiteListSyncTest, changes_cancelling_out_send_nothing) {
+  WhiteListSync sync;
+  sync.Add(kPublic, Address(1));
+  sync.Apply(sync.Reconcile(NeverSkip));
+
+  sync.Remove(Address(1));
+  sync.Add(kPublic, Address(2));
+  sync.Add(kPublic, Address(1));
+  sync.Remove(Address(2));
+  EXPECT_TRUE(sync.Reconcile(NeverSkip).Empty());
+}
+
+TEST(WhiteListSyncTest, address_type_change_replaces_the_entry) {
+  WhiteListSync sync;
+  sync.Add(kPublic, Address(1));
+  sync.Apply(sync.Reconcile(NeverSkip));
+
+  sync.Add(kRandom, Address(1));
+  EXPECT_FALSE(sync.IsInController(Address(1)));
+  WhiteListSync::Plan plan = sync.Reconcile(NeverSkip);
+  ASSERT_EQ(1u, plan.remove.size());
+  EXPECT_EQ(kPublic, plan.remove[0].addr_type);
+  ASSERT_EQ(1u, plan.add.size());
+  EXPECT_EQ(kRandom, plan.add[0].addr_type);
+  sync.Apply(plan);
+  EXPECT_TRUE(sync.IsInController(Address(1)));
+}
+
+TEST(WhiteListSyncTest, skipped_devices_are_removed) {
+  WhiteListSync sync;
+  sync.Add(kPublic, Address(1));
+  sync.Add(kPublic, Address(2));
+  sync.Apply(sync.Reconcile(NeverSkip));
+
+  WhiteListSync::Plan plan = sync.Reconcile(
+      [](const RawAddress& address) { return address == Address(2); });
+  EXPECT_EQ(std::set<RawAddress>({Address(2)}), Addresses(plan.remove));
+  EXPECT_TRUE(plan.add.empty());
+  sync.Apply(plan);
+
+  // Still wanted, so added back once no longer skipped
+  EXPECT_TRUE(sync.IsWanted(Address(2)));
+  EXPECT_FALSE(sync.IsInController(Address(2)));
+  plan = sync.Reconcile(NeverSkip);
+  EXPECT_EQ(std::set<RawAddress>({Address(2)}), Addresses(plan.add));
+}
+
+TEST(WhiteListSyncTest, reloads_when_cheaper) {
+  WhiteListSync sync;
+  for (uint32_t i = 0; i < 10; i++) sync.Add(kPublic, Address(i));
+  sync.Apply(sync.Reconcile(NeverSkip));
+
+  // Replacing 8 of 10 devices: 16 commands as a diff, 11 as a reload
+  for (uint32_t i = 0; i < 8; i++) {
+    sync.Remove(Address(i));
+    sync.Add(kPublic, Address(100 + i));
+  }
+  WhiteListSync::Plan plan = sync.Reconcile(NeverSkip);
+  EXPECT_TRUE(plan.clear);
+  EXPECT_TRUE(plan.remove.empty());
+  EXPECT_EQ(10u, plan.add.size());
+  EXPECT_EQ(11u, plan.Commands());
+  sync.Apply(plan);
+  EXPECT_TRUE(sync.Reconcile(NeverSkip).Empty());
+  for (uint32_t i = 0; i < 8; i++)
+    EXPECT_TRUE(sync.IsInController(Address(100 + i)));
+
+  // Replacing 2 of 10: 4 commands as a diff
+  sync.Remove(Address(8));
+  sync.Add(kPublic, Address(200));
+  sync.Remove(Address(9));
+  sync.Add(kPublic, Address(201));
+  plan = sync.Reconcile(NeverSkip);
+  EXPECT_FALSE(plan.clear);
+  EXPECT_EQ(4u, plan.Commands());
+
+  // Removing everything is a single clear
+  sync.Apply(plan);
+  for (const auto& wanted : std::map<RawAddress, uint8_t>(
+           sync.Wanted().begin(), sync.Wanted().end()))
+    sync.Remove(wanted.first);
+  plan = sync.Reconcile(NeverSkip);
+  EXPECT_TRUE(plan.clear);
+  EXPECT_EQ(1u, plan.Commands());
+}
+
+TEST(WhiteListSyncTest, controller_cleared) {
+  WhiteListSync sync;
+  sync.Add(kPublic, Address(1));
+  sync.Apply(sync.Reconcile(NeverSkip));
+
+  sync.ControllerCleared();
+  EXPECT_FALSE(sync.IsInController(Address(1)));
+  EXPECT_EQ(std::set<RawAddress>({Address(1)}),
+            Addresses(sync.Reconcile(NeverSkip).add));
+}
+
+namespace {
+
+// Time for the controller to answer one command
+const uint64_t kCommandUs = 1000;
+// BTM_BLE_WL_SYNC_DELAY_MS
+const uint64_t kSyncDelayUs = 20000;
+const size_t kWhiteListSize = 64;
+
+struct Request {
+  uint64_t time_us;
+  bool add;
+  uint8_t addr_type;
+  RawAddress address;
+};
+
+// Controller white list, and whether a background connection is being
+// initiated. Rejects white list changes while initiating, as the
+// specification requires, and additions to a full list.
+struct FakeController {
+  std::map<RawAddress, uint8_t> white_list;
+  bool initiating = false;
+  size_t commands = 0;
+  size_t failed = 0;
+
+  void Send(const WhiteListSync::Plan& plan) {
+    if (plan.clear && Command(true)) white_list.clear();
+    for (const WhiteListSync::Entry& entry : plan.remove) {
+      if (!Command(true)) continue;
+      auto it = white_list.find(entry.address);
+      if (it == white_list.end() || it->second != entry.addr_type)
+        failed++;
+      else
+        white_list.erase(it);
+    }
+    for (const WhiteListSync::Entry& entry : plan.add) {
+      if (!Command(true)) continue;
+      if (white_list.size() == kWhiteListSize)
+        failed++;
+      else
+        white_list[entry.address] = entry.addr_type;
+    }
+  }
+
+  // Returns false if the command was rejected
+  bool Command(bool changes_white_list) {
+    commands++;
+    if (changes_white_list && initiating) {
+      failed++;
+      return false;
+    }
+    return true;
+  }
+};
+
+struct SimResult {
+  size_t commands;
+  size_t failed;
+  size_t suspends;
+  uint64_t pause_us;  // time not initiating while devices are wanted
+};
+
+// Runs |requests| through the host white list logic of btm_ble_bgconn:
+// every sync cancels the background connection, sends the pending changes
+// and initiates again. Without |debounce| every request is synced on its
+// own, as before; with it the requests made within kSyncDelayUs of the
+// first unsynced one are synced together.
+SimResult Simulate(const std::vector<Request>& requests,
+                   const std::set<RawAddress>& connected, bool debounce) {
+  WhiteListSync sync;
+  FakeController controller;
+  SimResult result = {};
+  uint64_t free_us = 0;  // when the controller has answered everything sent
+  auto skip = [&connected](const RawAddress& address) {
+    return connected.count(address) != 0;
+  };
+
+  auto run_sync = [&](uint64_t now) {
+    uint64_t start = std::max(now, free_us);
+    uint64_t t = start;
+    WhiteListSync::Plan plan = sync.Reconcile(skip);
+    if (plan.Empty() && controller.initiating) return;
+
+    if (controller.initiating) {
+      controller.Command(false);
+      controller.initiating = false;
+      t += kCommandUs;
+      result.suspends++;
+    }
+    controller.Send(plan);
+    t += plan.Commands() * kCommandUs;
+    sync.Apply(plan);
+
+    bool pending = false;
+    for (const auto& wanted : sync.Wanted()) pending |= !skip(wanted.first);
+    if (pending) {
+      controller.Command(false);
+      controller.initiating = true;
+      t += kCommandUs;
+      result.pause_us += t - start;
+    }
+    free_us = t;
+  };
+
+  bool timer_set = false;
+  uint64_t timer_us = 0;
+  for (const Request& request : requests) {
+    if (timer_set && request.time_us >= timer_us) {
+      run_sync(timer_us);
+      timer_set = false;
+    }
+
+    if (!request.add) {
+      sync.Remove(request.address);
+    } else if (sync.WantedCount() < kWhiteListSize) {
+      // BTM_WhiteListAdd refuses devices beyond the white list size
+      sync.Add(request.addr_type, request.address);
+    } else {
+      continue;
+    }
+
+    if (!debounce) {
+      run_sync(request.time_us);
+    } else if (!timer_set) {
+      timer_set = true;
+      timer_us = request.time_us + kSyncDelayUs;
+    }
+  }
+  if (timer_set) run_sync(timer_us);
+
+  // The controller holds exactly the wanted devices not connected
+  std::map<RawAddress, uint8_t> expected;
+  for (const auto& wanted : sync.Wanted())
+    if (!skip(wanted.first)) expected.insert(wanted);
+  EXPECT_EQ(expected, controller.white_list);
+
+  result.commands = controller.commands;
+  result.failed = controller.failed;
+  return result;
+}
+
+// A hub managing a fleet of LE peripherals:
+// - at start it adds 48 devices back to back;
+// - then apps add and remove single devices at random, some of them
+//   changing address type, while others reconnect after a disconnection;
+// - twice, a whole group of 32 devices is swapped for another one.
+std::vector<Request> HubTraffic(std::mt19937& rng) {
+  std::vector<Request> requests;
+  uint64_t t = 0;
+  for (uint32_t i = 0; i < 48; i++) {
+    requests.push_back(Request{t, true, kPublic, Address(i)});
+    t += 500;
+  }
+
+  std::uniform_int_distribution<uint32_t> device(0, 95);
+  std::exponential_distribution<double> gap(1.0 / 15000);
+  std::uniform_int_distribution<int> percent(0, 99);
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 150; i++) {
+      t += 1 + (uint64_t)gap(rng);
+      int p = percent(rng);
+      uint8_t type = p < 10 ? kRandom : kPublic;
+      requests.push_back(Request{t, p < 60, type, Address(device(rng))});
+    }
+
+    if (round == 2) break;
+    t += 100000;
+    uint32_t from = round == 0 ? 0 : 100;
+    uint32_t to = round == 0 ? 100 : 0;
+    for (uint32_t i = 0; i < 32; i++) {
+      requests.push_back(Request{t, false, kPublic, Address(from + i)});
+      t += 200;
+    }
+    for (uint32_t i = 0; i < 32; i++) {
+      requests.push_back(Request{t, true, kPublic, Address(to + i)});
+      t += 200;
+    }
+  }
+  return requests;
+}
+
+}  // namespace
+
+TEST(WhiteListSyncTest, debounced_sync_pauses_less) {
+  std::mt19937 rng(17);
+  std::vector<Request> requests = HubTraffic(rng);
+  std::set<RawAddress> connected;
+  for (uint32_t i = 0; i < 96; i += 7) connected.insert(Address(i));
+
+  SimResult each = Simulate(requests, connected, false);
+  SimResult debounced = Simulate(requests, connected, true);
+
+  printf("%zu requests\n", requests.size());
+  printf("  per request: %5zu commands, %4zu suspends, paused %6.1f ms\n",
+         each.commands, each.suspends, each.pause_us / 1000.0);
+  printf("  debounced:   %5zu commands, %4zu suspends, paused %6.1f ms\n",
+         debounced.commands, debounced.suspends, debounced.pause_us / 1000.0);
+
+  EXPECT_EQ(0u, each.failed);
+  EXPECT_EQ(0u, debounced.failed);
+  EXPECT_LT(debounced.commands * 3, each.commands * 2);
+  EXPECT_LT(debounced.suspends * 2, each.suspends);
+  EXPECT_LT(debounced.pause_us * 3, each.pause_us * 2);
+}
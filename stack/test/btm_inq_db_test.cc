@@ -0,0 +1,305 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <list>
+#include <random>
+#include <vector>
+
+#include "btm_inq_db.h"
+
+namespace {
+
+const uint16_t kNone = InquiryDbIndex::kNone;
+
+RawAddress Address(uint32_t n) {
+  RawAddress addr;
+  uint8_t bytes[RawAddress::kLength] = {0x00, 0x11, (uint8_t)(n >> 24),
+                                        (uint8_t)(n >> 16), (uint8_t)(n >> 8),
+                                        (uint8_t)n};
+  memcpy(addr.address, bytes, sizeof(bytes));
+  return addr;
+}
+
+std::vector<uint16_t> Walk(const InquiryDbIndex& index) {
+  std::vector<uint16_t> slots;
+  for (uint16_t slot = index.First(); slot != kNone; slot = index.Next(slot))
+    slots.push_back(slot);
+  return slots;
+}
+
+}  // namespace
+
+TEST(InquiryDbIndexTest, find_and_insert) {
+  InquiryDbIndex index(8, 4);
+
+  EXPECT_EQ(kNone, index.Find(Address(1)));
+  uint16_t slot = index.Insert(Address(1), false);
+  ASSERT_NE(kNone, slot);
+  EXPECT_EQ(slot, index.Find(Address(1)));
+  EXPECT_TRUE(index.InUse(slot));
+  EXPECT_EQ(1u, index.size());
+
+  index.Remove(slot);
+  EXPECT_EQ(kNone, index.Find(Address(1)));
+  EXPECT_FALSE(index.InUse(slot));
+  EXPECT_EQ(0u, index.size());
+}
+
+TEST(InquiryDbIndexTest, iteration_follows_insertion_order) {
+  InquiryDbIndex index(8, 4);
+  std::vector<uint16_t> slots;
+  for (uint32_t i = 0; i < 6; i++)
+    slots.push_back(index.Insert(Address(i), false));
+
+  // Recency does not change iteration order
+  index.Touch(slots[0]);
+  EXPECT_EQ(slots, Walk(index));
+
+  index.Remove(slots[2]);
+  slots.erase(slots.begin() + 2);
+  slots.push_back(index.Insert(Address(10), false));
+  EXPECT_EQ(slots, Walk(index));
+}
+
+TEST(InquiryDbIndexTest, walk_survives_removal_of_current) {
+  InquiryDbIndex index(8, 4);
+  std::vector<uint16_t> slots;
+  for (uint32_t i = 0; i < 5; i++)
+    slots.push_back(index.Insert(Address(i), false));
+
+  // The caller holds slots[1] while it and the one after it go away
+  index.Remove(slots[1]);
+  index.Remove(slots[2]);
+  EXPECT_EQ(slots[3], index.Next(slots[1]));
+
+  index.Remove(slots[4]);
+  index.Remove(slots[3]);
+  EXPECT_EQ(kNone, index.Next(slots[1]));
+}
+
+TEST(InquiryDbIndexTest, least_recently_seen_is_evicted) {
+  InquiryDbIndex index(4, 4);
+  std::vector<uint16_t> slots;
+  for (uint32_t i = 0; i < 4; i++)
+    slots.push_back(index.Insert(Address(i), false));
+
+  index.Touch(slots[0]);
+  uint16_t slot = index.Insert(Address(4), false);
+  EXPECT_EQ(slots[1], slot);
+  EXPECT_EQ(kNone, index.Find(Address(1)));
+  EXPECT_EQ(slots[0], index.Find(Address(0)));
+  EXPECT_EQ(4u, index.size());
+
+  // The newcomer is last in iteration order
+  EXPECT_EQ(slot, Walk(index).back());
+}
+
+TEST(InquiryDbIndexTest, kept_devices_are_spared) {
+  InquiryDbIndex index(4, 2);
+  uint16_t hid0 = index.Insert(Address(0), true);
+  uint16_t hid1 = index.Insert(Address(1), true);
+  uint16_t hid2 = index.Insert(Address(2), true);
+  EXPECT_TRUE(index.IsKept(hid0));
+  EXPECT_TRUE(index.IsKept(hid1));
+  EXPECT_FALSE(index.IsKept(hid2));  // over the limit
+  index.Insert(Address(3), false);
+
+  index.Insert(Address(4), false);
+  EXPECT_EQ(kNone, index.Find(Address(2)));
+  index.Insert(Address(5), false);
+  EXPECT_EQ(kNone, index.Find(Address(3)));
+  EXPECT_EQ(hid0, index.Find(Address(0)));
+  EXPECT_EQ(hid1, index.Find(Address(1)));
+
+  // Removing a kept device frees its keep
+  index.Remove(hid0);
+  EXPECT_TRUE(index.IsKept(index.Insert(Address(6), true)));
+}
+
+TEST(InquiryDbIndexTest, sort_is_stable) {
+  InquiryDbIndex index(8, 4);
+  int8_t rssi[8] = {};
+  const int8_t values[] = {-70, -40, -70, -55, -40};
+  std::vector<uint16_t> slots;
+  for (uint32_t i = 0; i < 5; i++) {
+    slots.push_back(index.Insert(Address(i), false));
+    rssi[slots.back()] = values[i];
+  }
+
+  index.Sort([&rssi](uint16_t a, uint16_t b) { return rssi[a] > rssi[b]; });
+  std::vector<uint16_t> expected = {slots[1], slots[4], slots[3], slots[0],
+                                    slots[2]};
+  EXPECT_EQ(expected, Walk(index));
+}
+
+TEST(InquiryDbIndexTest, resize_keeps_slots) {
+  InquiryDbIndex index(4, 4);
+  std::vector<uint16_t> slots;
+  for (uint32_t i = 0; i < 4; i++)
+    slots.push_back(index.Insert(Address(i), false));
+
+  index.Resize(64);
+  EXPECT_EQ(64u, index.capacity());
+  for (uint32_t i = 0; i < 4; i++) EXPECT_EQ(slots[i], index.Find(Address(i)));
+  for (uint32_t i = 4; i < 64; i++) index.Insert(Address(i), false);
+  EXPECT_EQ(64u, index.size());
+
+  index.Resize(16);
+  EXPECT_EQ(16u, index.size());
+  for (uint32_t i = 0; i < 16; i++) EXPECT_EQ(i, index.Find(Address(i)));
+  EXPECT_EQ(kNone, index.Find(Address(20)));
+
+  index.Clear();
+  EXPECT_EQ(0u, index.size());
+  EXPECT_EQ(kNone, index.First());
+}
+
+TEST(InquiryDbIndexTest, random_churn_matches_model) {
+  const size_t kCapacity = 32;
+  InquiryDbIndex index(kCapacity, 0);
+  std::list<uint32_t> recency;  // most recently seen first
+  std::list<uint32_t> order;    // insertion order
+  std::mt19937 rng(33);
+
+  for (int i = 0; i < 100000; i++) {
+    uint32_t device = rng() % 100;
+    uint16_t slot = index.Find(Address(device));
+    bool present = false;
+    for (uint32_t d : recency) present |= d == device;
+    ASSERT_EQ(present, slot != kNone) << "step " << i;
+
+    if (rng() % 10 == 0 && present) {
+      index.Remove(slot);
+      recency.remove(device);
+      order.remove(device);
+    } else if (present) {
+      index.Touch(slot);
+      recency.remove(device);
+      recency.push_front(device);
+    } else {
+      if (recency.size() == kCapacity) {
+        order.remove(recency.back());
+        recency.pop_back();
+      }
+      index.Insert(Address(device), false);
+      recency.push_front(device);
+      order.push_back(device);
+    }
+
+    ASSERT_EQ(order.size(), index.size());
+    if (i % 100 == 0) {
+      std::vector<uint16_t> expected;
+      for (uint32_t d : order) expected.push_back(index.Find(Address(d)));
+      ASSERT_EQ(expected, Walk(index)) << "step " << i;
+    }
+  }
+}
+
+namespace {
+
+// The inquiry database as it was before: a linear array, the oldest response
+// overwritten when full.
+struct LegacyEntry {
+  RawAddress addr;
+  uint32_t time_of_resp;
+  bool in_use;
+};
+
+class LegacyInqDb {
+ public:
+  explicit LegacyInqDb(size_t size) : entries_(size) {}
+
+  LegacyEntry* Find(const RawAddress& addr) {
+    for (auto& entry : entries_)
+      if (entry.in_use && entry.addr == addr) return &entry;
+    return nullptr;
+  }
+
+  LegacyEntry* New(const RawAddress& addr) {
+    LegacyEntry* old = &entries_[0];
+    uint32_t ot = 0xFFFFFFFF;
+    for (auto& entry : entries_) {
+      if (!entry.in_use) {
+        old = &entry;
+        break;
+      }
+      if (entry.time_of_resp < ot) {
+        old = &entry;
+        ot = entry.time_of_resp;
+      }
+    }
+    *old = {};
+    old->addr = addr;
+    old->in_use = true;
+    return old;
+  }
+
+ private:
+  std::vector<LegacyEntry> entries_;
+};
+
+// Inquiry results from |devices| devices, seen again and again, with a few
+// newcomers replacing the least active ones as in a busy environment.
+std::vector<RawAddress> InquiryResults(int count, uint32_t devices) {
+  std::vector<RawAddress> results;
+  std::mt19937 rng(devices);
+  uint32_t next_new = devices;
+  std::vector<uint32_t> active(devices);
+  for (uint32_t i = 0; i < devices; i++) active[i] = i;
+  for (int i = 0; i < count; i++) {
+    if (rng() % 20 == 0) active[rng() % devices] = next_new++;
+    results.push_back(Address(active[rng() % devices]));
+  }
+  return results;
+}
+
+}  // namespace
+
+// Per-result cost of looking up, adding or refreshing the entry of a device
+// for databases sized to hold 40, 256 and 1024 devices.
+TEST(InquiryDbIndexTest, inquiry_result_benchmark) {
+  const int kResults = 200000;
+  for (uint32_t devices : {40u, 256u, 1024u}) {
+    auto results = InquiryResults(kResults, devices);
+
+    InquiryDbIndex index(devices, 4);
+    uint32_t now = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const RawAddress& addr : results) {
+      uint16_t slot = index.Find(addr);
+      if (slot == kNone) slot = index.Insert(addr, false);
+      index.Touch(slot);
+      now++;
+    }
+    auto index_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    LegacyInqDb legacy(devices);
+    now = 0;
+    start = std::chrono::steady_clock::now();
+    for (const RawAddress& addr : results) {
+      LegacyEntry* entry = legacy.Find(addr);
+      if (!entry) entry = legacy.New(addr);
+      entry->time_of_resp = ++now;
+    }
+    auto legacy_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    EXPECT_EQ(devices, index.size());
+    printf("inquiry db %4u devices: indexed %6.1f ns/result, linear %7.1f "
+           "ns/result\n",
+           devices, (double)index_ns / kResults, (double)legacy_ns / kResults);
+  }
+}
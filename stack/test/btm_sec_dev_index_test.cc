@@ -0,0 +1,289 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "btm_sec_dev_index.h"
+
+namespace {
+
+const uint16_t kNoHandle = SecDevIndex::kNoHandle;
+
+RawAddress Address(uint32_t n) {
+  RawAddress addr;
+  uint8_t bytes[RawAddress::kLength] = {0x00, 0x11, (uint8_t)(n >> 24),
+                                        (uint8_t)(n >> 16), (uint8_t)(n >> 8),
+                                        (uint8_t)n};
+  memcpy(addr.address, bytes, sizeof(bytes));
+  return addr;
+}
+
+// The indexed fields of a tBTM_SEC_DEV_REC
+struct DevRec {
+  RawAddress bd_addr;
+  RawAddress pseudo_addr;
+  RawAddress identity_addr;
+  uint16_t hci_handle;
+  uint16_t ble_hci_handle;
+};
+
+SecDevIndex::Keys KeysOf(const DevRec& rec) {
+  SecDevIndex::Keys keys;
+  keys.bd_addr = rec.bd_addr;
+  keys.pseudo_addr = rec.pseudo_addr;
+  keys.identity_addr = rec.identity_addr;
+  keys.hci_handle = rec.hci_handle;
+  keys.ble_hci_handle = rec.ble_hci_handle;
+  return keys;
+}
+
+// The device database with the list walks of btm_find_dev (less IRK
+// resolution), btm_find_dev_by_handle and btm_find_dev_by_identity_addr.
+class DevDb {
+ public:
+  DevRec* Alloc() {
+    records_.emplace_back(new DevRec());
+    DevRec* rec = records_.back().get();
+    *rec = {};
+    index_.Update(rec, KeysOf(*rec));
+    return rec;
+  }
+
+  void Free(DevRec* rec) {
+    index_.Remove(rec);
+    records_.remove_if(
+        [rec](const std::unique_ptr<DevRec>& r) { return r.get() == rec; });
+  }
+
+  void Changed(DevRec* rec) { index_.Update(rec, KeysOf(*rec)); }
+
+  DevRec* ScanAddress(const RawAddress& addr) const {
+    if (addr.IsEmpty()) return nullptr;
+    for (const auto& rec : records_)
+      if (rec->bd_addr == addr || rec->pseudo_addr == addr) return rec.get();
+    return nullptr;
+  }
+
+  DevRec* ScanHandle(uint16_t handle) const {
+    for (const auto& rec : records_)
+      if (rec->hci_handle == handle || rec->ble_hci_handle == handle)
+        return rec.get();
+    return nullptr;
+  }
+
+  DevRec* ScanIdentity(const RawAddress& addr) const {
+    for (const auto& rec : records_)
+      if (rec->identity_addr == addr) return rec.get();
+    return nullptr;
+  }
+
+  DevRec* FindAddress(const RawAddress& addr) const {
+    return static_cast<DevRec*>(index_.FindByAddress(addr));
+  }
+  DevRec* FindHandle(uint16_t handle) const {
+    return static_cast<DevRec*>(index_.FindByHandle(handle));
+  }
+  DevRec* FindIdentity(const RawAddress& addr) const {
+    return static_cast<DevRec*>(index_.FindByIdentityAddress(addr));
+  }
+
+  DevRec* At(size_t i) {
+    auto it = records_.begin();
+    std::advance(it, i);
+    return it->get();
+  }
+  size_t size() const { return records_.size(); }
+  const SecDevIndex& index() const { return index_; }
+
+ private:
+  std::list<std::unique_ptr<DevRec>> records_;
+  SecDevIndex index_;
+};
+
+}  // namespace
+
+TEST(SecDevIndexTest, find_by_each_key) {
+  DevDb db;
+  DevRec* rec = db.Alloc();
+  rec->bd_addr = Address(1);
+  rec->pseudo_addr = Address(2);
+  rec->identity_addr = Address(3);
+  rec->hci_handle = 0x0010;
+  rec->ble_hci_handle = 0x0020;
+  db.Changed(rec);
+
+  EXPECT_EQ(rec, db.FindAddress(Address(1)));
+  EXPECT_EQ(rec, db.FindAddress(Address(2)));
+  EXPECT_EQ(nullptr, db.FindAddress(Address(3)));
+  EXPECT_EQ(rec, db.FindIdentity(Address(3)));
+  EXPECT_EQ(nullptr, db.FindIdentity(Address(1)));
+  EXPECT_EQ(rec, db.FindHandle(0x0010));
+  EXPECT_EQ(rec, db.FindHandle(0x0020));
+  EXPECT_EQ(nullptr, db.FindHandle(0x0030));
+
+  db.Free(rec);
+  EXPECT_EQ(nullptr, db.FindAddress(Address(1)));
+  EXPECT_EQ(nullptr, db.FindHandle(0x0010));
+  EXPECT_EQ(0u, db.index().size());
+}
+
+TEST(SecDevIndexTest, changed_keys_follow_record) {
+  DevDb db;
+  DevRec* rec = db.Alloc();
+  rec->bd_addr = Address(1);
+  rec->hci_handle = 0x0001;
+  db.Changed(rec);
+
+  // Identity address learned during pairing replaces the BD address
+  rec->bd_addr = Address(9);
+  rec->hci_handle = kNoHandle;
+  db.Changed(rec);
+  EXPECT_EQ(nullptr, db.FindAddress(Address(1)));
+  EXPECT_EQ(rec, db.FindAddress(Address(9)));
+  EXPECT_EQ(nullptr, db.FindHandle(0x0001));
+}
+
+TEST(SecDevIndexTest, first_added_record_wins) {
+  DevDb db;
+  DevRec* first = db.Alloc();
+  DevRec* second = db.Alloc();
+
+  // Same peer seen as a BR/EDR record and as an LE record with its pseudo
+  // address, before the two are consolidated
+  second->bd_addr = Address(5);
+  db.Changed(second);
+  first->pseudo_addr = Address(5);
+  db.Changed(first);
+  EXPECT_EQ(first, db.FindAddress(Address(5)));
+
+  db.Free(first);
+  EXPECT_EQ(second, db.FindAddress(Address(5)));
+}
+
+TEST(SecDevIndexTest, empty_address_and_no_handle_are_not_indexed) {
+  DevDb db;
+  DevRec* rec = db.Alloc();
+  rec->hci_handle = kNoHandle;
+  rec->ble_hci_handle = kNoHandle;
+  db.Changed(rec);
+
+  EXPECT_EQ(nullptr, db.FindAddress(RawAddress::kEmpty));
+  EXPECT_EQ(nullptr, db.FindIdentity(RawAddress::kEmpty));
+  EXPECT_EQ(nullptr, db.FindHandle(kNoHandle));
+}
+
+// Random allocation, release and key changes over small key spaces, so that
+// records often share addresses and handles. Every lookup must agree with the
+// list walk.
+TEST(SecDevIndexTest, random_cross_check_with_list_scan) {
+  DevDb db;
+  std::mt19937 rng(35);
+  auto random_address = [&rng]() {
+    return (rng() % 8 == 0) ? RawAddress::kEmpty : Address(rng() % 40);
+  };
+  auto random_handle = [&rng]() -> uint16_t {
+    return (rng() % 4 == 0) ? kNoHandle : rng() % 24;
+  };
+
+  for (int step = 0; step < 200000; step++) {
+    uint32_t op = rng() % 100;
+    if (op < 10 || db.size() == 0) {
+      db.Alloc();
+    } else if (op < 18) {
+      db.Free(db.At(rng() % db.size()));
+    } else if (op < 50) {
+      DevRec* rec = db.At(rng() % db.size());
+      switch (rng() % 5) {
+        case 0:
+          rec->bd_addr = random_address();
+          break;
+        case 1:
+          rec->pseudo_addr = random_address();
+          break;
+        case 2:
+          rec->identity_addr = random_address();
+          break;
+        case 3:
+          rec->hci_handle = random_handle();
+          break;
+        case 4:
+          rec->ble_hci_handle = random_handle();
+          break;
+      }
+      db.Changed(rec);
+    }
+
+    RawAddress addr = Address(rng() % 40);
+    uint16_t handle = rng() % 24;
+    ASSERT_EQ(db.ScanAddress(addr), db.FindAddress(addr)) << "step " << step;
+    ASSERT_EQ(db.ScanIdentity(addr), db.FindIdentity(addr))
+        << "step " << step;
+    ASSERT_EQ(db.ScanHandle(handle), db.FindHandle(handle)) << "step " << step;
+    ASSERT_EQ(db.size(), db.index().size());
+  }
+}
+
+// Per-lookup cost of resolving an address and a connection handle, as on the
+// connection, encryption change and ACL paths, for databases of 16 to 1024
+// records.
+TEST(SecDevIndexTest, lookup_benchmark) {
+  const int kLookups = 200000;
+  for (uint32_t records : {16u, 128u, 512u, 1024u}) {
+    DevDb db;
+    for (uint32_t i = 0; i < records; i++) {
+      DevRec* rec = db.Alloc();
+      rec->bd_addr = Address(i);
+      rec->hci_handle = (i < 32) ? i : kNoHandle;
+      rec->ble_hci_handle = kNoHandle;
+      db.Changed(rec);
+    }
+
+    std::mt19937 rng(records);
+    std::vector<RawAddress> addrs;
+    std::vector<uint16_t> handles;
+    for (int i = 0; i < kLookups; i++) {
+      addrs.push_back(Address(rng() % records));
+      handles.push_back(rng() % std::min(records, 32u));
+    }
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; i++) {
+      found += db.FindAddress(addrs[i]) != nullptr;
+      found += db.FindHandle(handles[i]) != nullptr;
+    }
+    auto index_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    size_t scanned = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; i++) {
+      scanned += db.ScanAddress(addrs[i]) != nullptr;
+      scanned += db.ScanHandle(handles[i]) != nullptr;
+    }
+    auto scan_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    EXPECT_EQ(2u * kLookups, found);
+    EXPECT_EQ(found, scanned);
+    printf("%4u records: indexed %6.1f ns/lookup, list scan %7.1f "
+           "ns/lookup\n",
+           records, (double)index_ns / (2 * kLookups),
+           (double)scan_ns / (2 * kLookups));
+  }
+}
@@ -0,0 +1,722 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "bt_target.h"
+#include "bt_trace.h"
+#include "btm_csb.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "btu_hcif_dispatch.h"
+#include "device/include/controller.h"
+#include "device/include/device_iot_config.h"
+#include "hci_evt_length.h"
+#include "hci_layer.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+#include "l2c_int.h"
+#include "stack_config.h"
+#ifdef DIR_FINDING_FEATURE
+#include "btm_ble_direction_finder_api.h"
+#endif
+
+/* Below are the parts of the stack btu_hcif.cc calls into, implemented here so
+ * that the test does not need to compile the whole stack. The ones the event
+ * handlers end in record the length they were given; the rest do nothing. */
+namespace {
+
+struct HandlerCall {
+  const char* name;
+  int len;
+};
+
+HandlerCall handler_call;
+
+void Record(const char* name, int len) { handler_call = {name, len}; }
+
+// For handlers that do not pass a length on
+const int kNoLength = INT_MIN;
+
+bool supported(void) { return true; }
+
+}  // namespace
+
+uint8_t btu_trace_level = BT_TRACE_LEVEL_NONE;
+void LogMsg(uint32_t, const char*, ...) {}
+void vnd_LogMsg(uint32_t, const char*, ...) {}
+
+base::MessageLoop* get_message_loop() { return nullptr; }
+const hci_t* hci_layer_get_interface() { return nullptr; }
+const stack_config_t* stack_config_get_interface(void) { return nullptr; }
+const controller_t* controller_get_interface() {
+  static controller_t controller = [] {
+    controller_t c = {};
+    c.supports_ble_iso_broadcaster = supported;
+    c.supports_set_min_encryption_key_size = supported;
+    c.supports_ble_packet_extension = supported;
+    return c;
+  }();
+  return &controller;
+}
+bool device_iot_config_addr_int_add_one(const RawAddress&, const char*) {
+  return true;
+}
+
+// Reached through the dispatch table
+void btm_process_inq_results(uint8_t*, uint8_t hci_evt_len, uint8_t) {
+  Record(__func__, hci_evt_len);
+}
+void btm_process_remote_name(const RawAddress*, BD_NAME, uint16_t evt_len,
+                             uint8_t) {
+  Record(__func__, evt_len);
+}
+void btm_read_remote_ext_features_complete(uint8_t*, uint8_t evt_len) {
+  Record(__func__, evt_len);
+}
+void l2c_link_process_num_completed_pkts(uint8_t*, uint8_t evt_len) {
+  Record(__func__, evt_len);
+}
+void btm_pm_proc_ssr_evt(uint8_t*, uint16_t evt_len) {
+  Record(__func__, evt_len);
+}
+void btm_vendor_specific_evt(uint8_t*, uint8_t evt_len) {
+  Record(__func__, evt_len);
+}
+void btm_ble_process_adv_pkt(uint8_t len, uint8_t*) { Record(__func__, len); }
+void btm_ble_process_ext_adv_pkt(uint8_t len, uint8_t*) {
+  Record(__func__, len);
+}
+void btm_ble_conn_complete(uint8_t*, uint16_t evt_len, bool enhanced) {
+  Record(enhanced ? "btm_ble_conn_complete(enhanced)" : __func__, evt_len);
+}
+void btm_ble_read_remote_features_complete(uint8_t*, uint8_t length) {
+  Record(__func__, length);
+}
+void btm_ble_ltk_request(uint16_t, uint8_t[8], uint16_t) {
+  Record(__func__, kNoLength);
+}
+void l2cble_process_conn_update_evt(uint16_t, uint8_t, uint16_t, uint16_t,
+                                    uint16_t) {
+  Record(__func__, kNoLength);
+}
+void l2cble_process_rc_param_request_evt(uint16_t, uint16_t, uint16_t,
+                                         uint16_t, uint16_t) {
+  Record(__func__, kNoLength);
+}
+void l2cble_process_data_length_change_event(uint16_t, uint16_t, uint16_t) {
+  Record(__func__, kNoLength);
+}
+void l2cble_process_subrate_change_evt(uint16_t, uint8_t, uint16_t, uint16_t,
+                                       uint16_t, uint16_t) {
+  Record(__func__, kNoLength);
+}
+void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t*) {
+  Record(__func__, len);
+}
+void btm_ble_periodic_adv_sync_established(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_periodic_adv_report(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_periodic_adv_sync_lost(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_le_on_advertising_set_terminated(uint8_t*, uint16_t length) {
+  Record(__func__, length);
+}
+void btm_ble_cis_established_evt(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_cis_request_evt(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_peer_sca_cmpl_evt(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_path_loss_threshold_evt(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_transmit_power_reporting_event(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_periodic_adv_sync_tx_rcvd(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_ble_biginfo_adv_report_rcvd(uint8_t*, uint16_t param_len) {
+  Record(__func__, param_len);
+}
+void btm_le_create_big_complete(uint8_t*, uint16_t length) {
+  Record(__func__, length);
+}
+void btm_le_terminate_big_complete(uint8_t*, uint16_t length) {
+  Record(__func__, length);
+}
+#ifdef DIR_FINDING_FEATURE
+void btm_ble_aoa_conn_iq_rpt_evt(uint16_t, uint8_t*, uint16_t evt_len) {
+  Record(__func__, evt_len);
+}
+#endif
+
+// Not reached through the dispatch table, or not observed
+bool BTM_IsBleConnection(uint16_t) { return false; }
+bool BTM_IsDeviceUp(void) { return true; }
+bool btm_ble_is_cis_handle(uint16_t) { return false; }
+bool btm_is_sco_active(uint16_t) { return false; }
+bool l2c_link_hci_conn_comp(uint8_t, uint16_t, const RawAddress&) {
+  return true;
+}
+bool l2c_link_hci_disc_comp(uint16_t, uint8_t) { return true; }
+bool l2c_link_hci_qos_violation(uint16_t) { return true; }
+void BTM_HCI_Reset(void) {}
+void btm_acl_encrypt_change(uint16_t, uint8_t, uint8_t) {}
+void btm_acl_role_changed(uint8_t, const RawAddress*, uint8_t) {}
+void btm_blacklist_role_change_device(const RawAddress&, uint8_t) {}
+void btm_ble_add_resolving_list_entry_complete(uint8_t*, uint16_t) {}
+void btm_ble_cis_disconnected(uint8_t, uint16_t, uint8_t) {}
+void btm_ble_clear_resolving_list_complete(uint8_t*, uint16_t) {}
+void btm_ble_create_conn_cancel_complete(uint8_t*) {}
+void btm_ble_create_ll_conn_complete(uint8_t) {}
+void btm_ble_rand_enc_complete(uint8_t*, uint16_t, uint16_t,
+                               tBTM_RAND_ENC_CB*) {}
+void btm_ble_read_resolving_list_entry_complete(uint8_t*, uint16_t) {}
+void btm_ble_remove_resolving_list_entry_complete(uint8_t*, uint16_t) {}
+void btm_ble_test_command_complete(uint8_t*) {}
+void btm_ble_write_adv_enable_complete(uint8_t*, uint16_t) {}
+void btm_create_conn_cancel_complete(uint8_t*, uint16_t) {}
+void btm_delete_stored_link_key_complete(uint8_t*) {}
+void btm_esco_proc_conn_chg(uint8_t, uint16_t, uint8_t, uint8_t, uint16_t,
+                            uint16_t) {}
+void btm_event_filter_complete(uint8_t*) {}
+void btm_flow_spec_complete(uint8_t, uint16_t, tBT_FLOW_SPEC*) {}
+void btm_hci_csb_timeout_evt(uint8_t*) {}
+void btm_hci_delete_reserved_lt_addr_complete(uint8_t*) {}
+void btm_hci_event(uint8_t*, uint8_t, uint8_t) {}
+void btm_hci_set_csb_complete(uint8_t*) {}
+void btm_hci_set_reserved_lt_addr_complete(uint8_t*) {}
+void btm_hci_start_sync_train_complete(uint8_t*) {}
+void btm_hci_write_sync_train_param_complete(uint8_t*) {}
+void btm_io_capabilities_req(const RawAddress&) {}
+void btm_io_capabilities_rsp(uint8_t*) {}
+void btm_keypress_notif_evt(uint8_t*) {}
+void btm_notify_ssr_trigger(void) {}
+void btm_pm_proc_cmd_status(uint8_t) {}
+void btm_pm_proc_mode_change(uint8_t, uint16_t, uint8_t, uint16_t) {}
+void btm_proc_sp_req_evt(tBTM_SP_EVT, uint8_t*) {}
+void btm_process_cancel_complete(uint8_t, uint8_t) {}
+void btm_process_clk_off_comp_evt(uint16_t, uint16_t) {}
+void btm_process_inq_complete(uint8_t, uint8_t) {}
+void btm_process_pkt_type_change_evt(uint16_t, uint16_t) {}
+void btm_qos_setup_complete(uint8_t, uint16_t, FLOW_SPEC*) {}
+void btm_read_automatic_flush_timeout_complete(uint8_t*) {}
+void btm_read_failed_contact_counter_complete(uint8_t*) {}
+void btm_read_inq_tx_power_complete(uint8_t*) {}
+void btm_read_link_quality_complete(uint8_t*, uint16_t) {}
+void btm_read_local_name_complete(uint8_t*, uint16_t) {}
+void btm_read_local_oob_complete(uint8_t*, uint16_t) {}
+void btm_read_remote_ext_features_failed(uint8_t, uint16_t) {}
+void btm_read_remote_features_complete(uint8_t*) {}
+void btm_read_remote_version_complete(uint8_t*) {}
+void btm_read_rssi_complete(uint8_t*, uint16_t) {}
+void btm_read_tx_power_complete(uint8_t*, uint16_t, bool) {}
+void btm_rem_oob_req(uint8_t*) {}
+void btm_report_device_status(tBTM_DEV_STATUS) {}
+void btm_sco_chk_pend_unpark(uint8_t, uint16_t) {}
+void btm_sco_conn_req(const RawAddress&, DEV_CLASS, uint8_t) {}
+void btm_sco_connected(uint8_t, const RawAddress*, uint16_t,
+                       tBTM_ESCO_DATA*) {}
+void btm_sco_removed(uint16_t, uint8_t) {}
+void btm_sec_auth_complete(uint16_t, uint8_t) {}
+void btm_sec_conn_req(const RawAddress&, uint8_t*) {}
+void btm_sec_connected(const RawAddress&, uint16_t, uint8_t, uint8_t) {}
+void btm_sec_disconnected(uint16_t, uint8_t) {}
+void btm_sec_encrypt_change(uint16_t, uint8_t, uint8_t) {}
+void btm_sec_link_key_notification(const RawAddress&, const Octet16&,
+                                   uint8_t) {}
+void btm_sec_link_key_request(const RawAddress&) {}
+void btm_sec_pin_code_request(const RawAddress&) {}
+void btm_sec_rmt_host_support_feat_evt(uint8_t*) {}
+void btm_sec_rmt_name_request_complete(const RawAddress*, uint8_t*,
+                                       uint8_t) {}
+void btm_sec_update_clock_offset(uint16_t, uint16_t) {}
+void btm_simple_pair_complete(uint8_t*) {}
+void btm_vsc_complete(uint8_t*, uint16_t, uint16_t, tBTM_VSC_CMPL_CB*) {}
+void btsnd_hcic_disconnect(uint16_t, uint8_t) {}
+void btsnd_hcic_read_encryption_key_size(uint16_t, ReadEncKeySizeCb) {}
+void gatt_notify_conn_update(uint16_t, uint16_t, uint16_t, uint16_t,
+                             uint8_t) {}
+void gatt_notify_subrate_change(uint16_t, uint16_t, uint16_t, uint16_t,
+                                uint16_t, uint8_t) {}
+void l2c_link_role_changed(const RawAddress*, uint8_t, uint8_t) {}
+void l2c_pin_code_request(const RawAddress&) {}
+void smp_cancel_start_encryption_attempt() {}
+
+namespace {
+
+struct Counts {
+  uint64_t events[256];
+  uint64_t le_events[256];
+  uint64_t bytes;
+  uint64_t traces;
+};
+
+Counts counts;
+uint8_t last_len;
+uint8_t last_first_byte;
+
+// Stands in for the stack trace macros. The messages are counted, not
+// formatted, so that the benchmark times the dispatch itself.
+void Trace(const char*, ...) { counts.traces++; }
+
+template <uint8_t kCode>
+void OnEvent(uint8_t* p, uint8_t len) {
+  counts.events[kCode]++;
+  counts.bytes += len;
+  last_len = len;
+  last_first_byte = len > 0 ? p[0] : 0;
+}
+
+template <uint8_t kSubCode>
+void OnLeEvent(uint8_t* p, uint8_t len) {
+  counts.le_events[kSubCode]++;
+  counts.bytes += len;
+  last_len = len;
+  last_first_byte = len > 0 ? p[0] : 0;
+}
+
+void TraceLe(uint8_t sub_code) { Trace("BLE HCI event = 0x%02x", sub_code); }
+
+HciEventDispatcher BuildDispatcher() {
+  HciEventDispatcher d;
+  d.Register(HCI_DISCONNECTION_COMP_EVT,
+             hci_event_parameters_minimum_length[HCI_DISCONNECTION_COMP_EVT],
+             OnEvent<HCI_DISCONNECTION_COMP_EVT>);
+  d.Register(HCI_NUM_COMPL_DATA_PKTS_EVT,
+             hci_event_parameters_minimum_length[HCI_NUM_COMPL_DATA_PKTS_EVT],
+             OnEvent<HCI_NUM_COMPL_DATA_PKTS_EVT>);
+  d.Register(HCI_MODE_CHANGE_EVT,
+             hci_event_parameters_minimum_length[HCI_MODE_CHANGE_EVT],
+             OnEvent<HCI_MODE_CHANGE_EVT>);
+  d.RegisterLe(HCI_BLE_ADV_PKT_RPT_EVT,
+               hci_le_event_parameters_minimum_length[HCI_BLE_ADV_PKT_RPT_EVT],
+               OnLeEvent<HCI_BLE_ADV_PKT_RPT_EVT>, true);
+  d.RegisterLe(HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT,
+               hci_le_event_parameters_minimum_length
+                   [HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT],
+               OnLeEvent<HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT>, true);
+  d.RegisterLe(HCI_BLE_LL_CONN_PARAM_UPD_EVT,
+               hci_le_event_parameters_minimum_length
+                   [HCI_BLE_LL_CONN_PARAM_UPD_EVT],
+               OnLeEvent<HCI_BLE_LL_CONN_PARAM_UPD_EVT>);
+  d.RegisterLe(HCI_BLE_LTK_REQ_EVT,
+               hci_le_event_parameters_minimum_length[HCI_BLE_LTK_REQ_EVT],
+               OnLeEvent<HCI_BLE_LTK_REQ_EVT>);
+  d.SetLeTracer(TraceLe);
+  return d;
+}
+
+// The event dispatch as it was before the table, with the same handlers
+void LegacyProcessEvent(uint8_t* p) {
+  uint8_t hci_evt_code = *p++;
+  uint8_t hci_evt_len = *p++;
+
+  if (hci_evt_len < hci_event_parameters_minimum_length[hci_evt_code]) {
+    Trace("%s: evt:0x%2X, malformed event of size %hhd", __func__,
+          hci_evt_code, hci_evt_len);
+    return;
+  }
+
+  switch (hci_evt_code) {
+    case HCI_DISCONNECTION_COMP_EVT:
+      OnEvent<HCI_DISCONNECTION_COMP_EVT>(p, hci_evt_len);
+      break;
+    case HCI_NUM_COMPL_DATA_PKTS_EVT:
+      OnEvent<HCI_NUM_COMPL_DATA_PKTS_EVT>(p, hci_evt_len);
+      break;
+    case HCI_MODE_CHANGE_EVT:
+      OnEvent<HCI_MODE_CHANGE_EVT>(p, hci_evt_len);
+      break;
+    case HCI_BLE_EVENT: {
+      uint8_t ble_sub_code = *p++;
+      Trace("BLE HCI(id=%d) event = 0x%02x)", hci_evt_code, ble_sub_code);
+      uint8_t ble_evt_len = hci_evt_len - 1;
+      switch (ble_sub_code) {
+        case HCI_BLE_ADV_PKT_RPT_EVT:
+          Trace("HCI_BLE_ADV_PKT_RPT_EVT");
+          OnLeEvent<HCI_BLE_ADV_PKT_RPT_EVT>(p, ble_evt_len);
+          break;
+        case HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT:
+          OnLeEvent<HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT>(p, ble_evt_len);
+          break;
+        case HCI_BLE_LL_CONN_PARAM_UPD_EVT:
+          OnLeEvent<HCI_BLE_LL_CONN_PARAM_UPD_EVT>(p, ble_evt_len);
+          break;
+        case HCI_BLE_LTK_REQ_EVT:
+          OnLeEvent<HCI_BLE_LTK_REQ_EVT>(p, ble_evt_len);
+          break;
+      }
+      break;
+    }
+  }
+}
+
+std::vector<uint8_t> Event(uint8_t code, std::vector<uint8_t> params) {
+  std::vector<uint8_t> event = {code, (uint8_t)params.size()};
+  event.insert(event.end(), params.begin(), params.end());
+  return event;
+}
+
+std::vector<uint8_t> LeEvent(uint8_t sub_code, size_t len) {
+  std::vector<uint8_t> params(len + 1, 0x5A);
+  params[0] = sub_code;
+  return Event(HCI_BLE_EVENT, params);
+}
+
+// The events of a connected scanner, in the proportions an HCI log shows:
+// mostly advertising reports and completed packets, now and then a link event.
+std::vector<std::vector<uint8_t>> ScanningStream(size_t n) {
+  std::mt19937 rng(50);
+  std::vector<std::vector<uint8_t>> stream;
+  for (size_t i = 0; i < n; i++) {
+    uint32_t kind = rng() % 100;
+    if (kind < 60) {
+      // One report of 0 to 31 bytes of advertising data
+      stream.push_back(LeEvent(HCI_BLE_ADV_PKT_RPT_EVT, 11 + rng() % 32));
+    } else if (kind < 75) {
+      stream.push_back(LeEvent(HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT,
+                               25 + rng() % 200));
+    } else if (kind < 95) {
+      stream.push_back(
+          Event(HCI_NUM_COMPL_DATA_PKTS_EVT, {1, 0x01, 0x00, 0x01, 0x00}));
+    } else if (kind < 97) {
+      stream.push_back(
+          Event(HCI_MODE_CHANGE_EVT, {0x00, 0x01, 0x00, 0x02, 0x20, 0x00}));
+    } else if (kind < 99) {
+      stream.push_back(LeEvent(HCI_BLE_LL_CONN_PARAM_UPD_EVT, 9));
+    } else {
+      stream.push_back(Event(HCI_DISCONNECTION_COMP_EVT, {0, 1, 0, 0x13}));
+    }
+  }
+  return stream;
+}
+
+class HciEventDispatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override { counts = {}; }
+
+  HciEventDispatcher::Result Dispatch(std::vector<uint8_t> event) {
+    return dispatcher_.Dispatch(event[0], event.data() + 2, event[1]);
+  }
+
+  HciEventDispatcher dispatcher_ = BuildDispatcher();
+};
+
+}  // namespace
+
+TEST_F(HciEventDispatcherTest, event_reaches_its_handler) {
+  EXPECT_EQ(HciEventDispatcher::kHandled,
+            Dispatch(Event(HCI_DISCONNECTION_COMP_EVT, {7, 1, 0, 0x13})));
+  EXPECT_EQ(1u, counts.events[HCI_DISCONNECTION_COMP_EVT]);
+  EXPECT_EQ(4, last_len);
+  EXPECT_EQ(7, last_first_byte);
+  EXPECT_TRUE(dispatcher_.IsRegistered(HCI_DISCONNECTION_COMP_EVT));
+  EXPECT_FALSE(dispatcher_.IsRegistered(HCI_INQUIRY_COMP_EVT));
+}
+
+TEST_F(HciEventDispatcherTest, le_event_reaches_its_handler_without_sub_code) {
+  std::vector<uint8_t> event = LeEvent(HCI_BLE_LTK_REQ_EVT, 12);
+  event[3] = 0x42;
+  EXPECT_EQ(HciEventDispatcher::kHandled, Dispatch(event));
+  EXPECT_EQ(1u, counts.le_events[HCI_BLE_LTK_REQ_EVT]);
+  EXPECT_EQ(12, last_len);
+  EXPECT_EQ(0x42, last_first_byte);
+  EXPECT_EQ(1u, counts.traces);
+}
+
+TEST_F(HciEventDispatcherTest, short_events_are_dropped) {
+  EXPECT_EQ(HciEventDispatcher::kTooShort,
+            Dispatch(Event(HCI_DISCONNECTION_COMP_EVT, {7, 1, 0})));
+  EXPECT_EQ(HciEventDispatcher::kTooShort,
+            Dispatch(LeEvent(HCI_BLE_LTK_REQ_EVT, 11)));
+  EXPECT_EQ(HciEventDispatcher::kTooShort, Dispatch(Event(HCI_BLE_EVENT, {})));
+  EXPECT_EQ(0u, counts.events[HCI_DISCONNECTION_COMP_EVT]);
+  EXPECT_EQ(0u, counts.le_events[HCI_BLE_LTK_REQ_EVT]);
+  EXPECT_EQ(0u, counts.traces);
+}
+
+TEST_F(HciEventDispatcherTest, unknown_events_are_unhandled) {
+  EXPECT_EQ(HciEventDispatcher::kUnhandled,
+            Dispatch(Event(HCI_INQUIRY_COMP_EVT, {0})));
+  EXPECT_EQ(HciEventDispatcher::kUnhandled, Dispatch(LeEvent(0x80, 4)));
+  EXPECT_FALSE(dispatcher_.IsLeRegistered(0x80));
+  EXPECT_EQ(0u, counts.bytes);
+}
+
+TEST_F(HciEventDispatcherTest, hot_events_are_not_traced) {
+  Dispatch(LeEvent(HCI_BLE_ADV_PKT_RPT_EVT, 20));
+  Dispatch(LeEvent(HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT, 40));
+  EXPECT_EQ(0u, counts.traces);
+  Dispatch(LeEvent(HCI_BLE_LL_CONN_PARAM_UPD_EVT, 9));
+  EXPECT_EQ(1u, counts.traces);
+}
+
+TEST_F(HciEventDispatcherTest, le_minimum_lengths_cover_every_sub_event) {
+  // Lengths are counted after the sub-event code; the LE Meta event header
+  // check itself only needs the code.
+  EXPECT_EQ(1, hci_event_parameters_minimum_length[HCI_BLE_EVENT]);
+  EXPECT_EQ(0x24u, sizeof(hci_le_event_parameters_minimum_length));
+  EXPECT_EQ(12, hci_le_event_parameters_minimum_length[HCI_BLE_LTK_REQ_EVT]);
+}
+
+TEST_F(HciEventDispatcherTest, replayed_stream_per_event_cost) {
+  const size_t kEvents = 200000;
+  using Clock = std::chrono::steady_clock;
+  std::vector<std::vector<uint8_t>> stream = ScanningStream(kEvents);
+
+  Clock::time_point start = Clock::now();
+  for (std::vector<uint8_t>& event : stream) LegacyProcessEvent(event.data());
+  Clock::duration legacy_time = Clock::now() - start;
+  Counts legacy = counts;
+
+  counts = {};
+  start = Clock::now();
+  for (std::vector<uint8_t>& event : stream) {
+    ASSERT_EQ(HciEventDispatcher::kHandled,
+              dispatcher_.Dispatch(event[0], event.data() + 2, event[1]));
+  }
+  Clock::duration table_time = Clock::now() - start;
+
+  auto ns = [&](Clock::duration d) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d)
+               .count() /
+           kEvents;
+  };
+  printf("%zu events, per event:\n", kEvents);
+  printf("  legacy: %.2f traces, %6.1f ns\n", (double)legacy.traces / kEvents,
+         ns(legacy_time));
+  printf("  table:  %.2f traces, %6.1f ns\n", (double)counts.traces / kEvents,
+         ns(table_time));
+
+  for (int i = 0; i < 256; i++) {
+    EXPECT_EQ(legacy.events[i], counts.events[i]);
+    EXPECT_EQ(legacy.le_events[i], counts.le_events[i]);
+  }
+  EXPECT_EQ(legacy.bytes, counts.bytes);
+  EXPECT_LT(counts.traces, legacy.traces);
+}
+
+namespace {
+
+// An event of the switch btu_hcif_process_event used to run, the handler it
+// ended in and the length that handler was given, as an offset from the
+// length in the event header.
+struct SwitchCase {
+  uint8_t code;
+  const char* handler;
+  int len_offset;
+};
+
+// No handler records a length for these
+#define NOT_OBSERVED nullptr, 0
+
+const SwitchCase kSwitchEvents[] = {
+    {HCI_INQUIRY_COMP_EVT, NOT_OBSERVED},
+    {HCI_INQUIRY_RESULT_EVT, "btm_process_inq_results", 0},
+    {HCI_INQUIRY_RSSI_RESULT_EVT, "btm_process_inq_results", 0},
+    {HCI_EXTENDED_INQUIRY_RESULT_EVT, "btm_process_inq_results", 0},
+    {HCI_CONNECTION_COMP_EVT, NOT_OBSERVED},
+    {HCI_CONNECTION_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_DISCONNECTION_COMP_EVT, NOT_OBSERVED},
+    {HCI_AUTHENTICATION_COMP_EVT, NOT_OBSERVED},
+    {HCI_RMT_NAME_REQUEST_COMP_EVT, "btm_process_remote_name",
+     -(1 + BD_ADDR_LEN)},
+    {HCI_ENCRYPTION_CHANGE_EVT, NOT_OBSERVED},
+    {HCI_ENCRYPTION_KEY_REFRESH_COMP_EVT, NOT_OBSERVED},
+    {HCI_READ_RMT_FEATURES_COMP_EVT, NOT_OBSERVED},
+    {HCI_READ_RMT_EXT_FEATURES_COMP_EVT,
+     "btm_read_remote_ext_features_complete", 0},
+    {HCI_READ_RMT_VERSION_COMP_EVT, NOT_OBSERVED},
+    {HCI_QOS_SETUP_COMP_EVT, NOT_OBSERVED},
+    {HCI_FLOW_SPECIFICATION_COMP_EVT, NOT_OBSERVED},
+    {HCI_COMMAND_COMPLETE_EVT, NOT_OBSERVED},
+    {HCI_COMMAND_STATUS_EVT, NOT_OBSERVED},
+    {HCI_HARDWARE_ERROR_EVT, NOT_OBSERVED},
+    {HCI_FLUSH_OCCURED_EVT, NOT_OBSERVED},
+    {HCI_ROLE_CHANGE_EVT, NOT_OBSERVED},
+    {HCI_NUM_COMPL_DATA_PKTS_EVT, "l2c_link_process_num_completed_pkts", 0},
+    {HCI_MODE_CHANGE_EVT, NOT_OBSERVED},
+    {HCI_PIN_CODE_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_LINK_KEY_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_LINK_KEY_NOTIFICATION_EVT, NOT_OBSERVED},
+    {HCI_LOOPBACK_COMMAND_EVT, NOT_OBSERVED},
+    {HCI_DATA_BUF_OVERFLOW_EVT, NOT_OBSERVED},
+    {HCI_MAX_SLOTS_CHANGED_EVT, NOT_OBSERVED},
+    {HCI_READ_CLOCK_OFF_COMP_EVT, NOT_OBSERVED},
+    {HCI_CONN_PKT_TYPE_CHANGE_EVT, NOT_OBSERVED},
+    {HCI_QOS_VIOLATION_EVT, NOT_OBSERVED},
+    {HCI_PAGE_SCAN_MODE_CHANGE_EVT, NOT_OBSERVED},
+    {HCI_PAGE_SCAN_REP_MODE_CHNG_EVT, NOT_OBSERVED},
+    {HCI_ESCO_CONNECTION_COMP_EVT, NOT_OBSERVED},
+    {HCI_ESCO_CONNECTION_CHANGED_EVT, NOT_OBSERVED},
+#if (BTM_SSR_INCLUDED == TRUE)
+    {HCI_SNIFF_SUB_RATE_EVT, "btm_pm_proc_ssr_evt", 0},
+#endif
+    {HCI_RMT_HOST_SUP_FEAT_NOTIFY_EVT, NOT_OBSERVED},
+    {HCI_IO_CAPABILITY_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_IO_CAPABILITY_RESPONSE_EVT, NOT_OBSERVED},
+    {HCI_USER_CONFIRMATION_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_USER_PASSKEY_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_REMOTE_OOB_DATA_REQUEST_EVT, NOT_OBSERVED},
+    {HCI_SIMPLE_PAIRING_COMPLETE_EVT, NOT_OBSERVED},
+    {HCI_USER_PASSKEY_NOTIFY_EVT, NOT_OBSERVED},
+    {HCI_KEYPRESS_NOTIFY_EVT, NOT_OBSERVED},
+#if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
+    {HCI_ENHANCED_FLUSH_COMPLETE_EVT, NOT_OBSERVED},
+#endif
+    {HCI_VENDOR_SPECIFIC_EVT, "btm_vendor_specific_evt", 0},
+    {HCI_CSB_TIMEOUT_EVT, NOT_OBSERVED},
+};
+
+// The LE meta event length counts the sub-event code. Some handlers were
+// given that length, the others the length after the code.
+const int kWhole = 0;
+const int kAfterSubCode = -1;
+
+const SwitchCase kSwitchLeEvents[] = {
+    {HCI_BLE_ADV_PKT_RPT_EVT, "btm_ble_process_adv_pkt", kAfterSubCode},
+    {HCI_BLE_CONN_COMPLETE_EVT, "btm_ble_conn_complete", kWhole},
+    {HCI_BLE_LL_CONN_PARAM_UPD_EVT, "l2cble_process_conn_update_evt", 0},
+    {HCI_BLE_READ_REMOTE_FEAT_CMPL_EVT,
+     "btm_ble_read_remote_features_complete", kAfterSubCode},
+    {HCI_BLE_LTK_REQ_EVT, "btm_ble_ltk_request", 0},
+#if (BLE_PRIVACY_SPT == TRUE)
+    {HCI_BLE_ENHANCED_CONN_COMPLETE_EVT, "btm_ble_conn_complete(enhanced)",
+     kWhole},
+#endif
+#if (BLE_LLT_INCLUDED == TRUE)
+    {HCI_BLE_RC_PARAM_REQ_EVT, "l2cble_process_rc_param_request_evt", 0},
+#endif
+    {HCI_BLE_DATA_LENGTH_CHANGE_EVT,
+     "l2cble_process_data_length_change_event", 0},
+    {HCI_BLE_PHY_UPDATE_COMPLETE_EVT, "btm_ble_process_phy_update_pkt",
+     kAfterSubCode},
+    {HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT, "btm_ble_process_ext_adv_pkt",
+     kWhole},
+    {HCI_LE_PERIODIC_ADV_SYNC_ESTABLISHED_EVT,
+     "btm_ble_periodic_adv_sync_established", kWhole},
+    {HCI_LE_PERIODIC_ADVERTISING_REPORT_EVT, "btm_ble_periodic_adv_report",
+     kWhole},
+    {HCI_LE_PERIODIC_ADV_SYNC_LOST_EVT, "btm_ble_periodic_adv_sync_lost",
+     kWhole},
+    {HCI_LE_ADVERTISING_SET_TERMINATED_EVT,
+     "btm_le_on_advertising_set_terminated", kWhole},
+    {HCI_LE_CIS_ESTABLISHED, "btm_ble_cis_established_evt", kWhole},
+    {HCI_LE_CIS_REQUEST, "btm_ble_cis_request_evt", kWhole},
+    {HCI_LE_REQUEST_PEER_SCA_COMPLETE, "btm_ble_peer_sca_cmpl_evt", kWhole},
+    {HCI_LE_PATH_LOSS_THRESHOLD, "btm_ble_path_loss_threshold_evt", kWhole},
+    {HCI_LE_TRANSMIT_POWER_REPORTING, "btm_ble_transmit_power_reporting_event",
+     kWhole},
+    {HCI_LE_PERIODIC_ADV_SYNC_TRANSFERE_RECEIVED_EVT,
+     "btm_ble_periodic_adv_sync_tx_rcvd", kWhole},
+    {HCI_LE_BIGINFO_ADVERTISING_REPORT_EVT, "btm_ble_biginfo_adv_report_rcvd",
+     kWhole},
+    {HCI_LE_CREATE_BIG_COMPLETE_EVT, "btm_le_create_big_complete", kWhole},
+    {HCI_LE_TERMINATE_BIG_COMPLETE_EVT, "btm_le_terminate_big_complete",
+     kWhole},
+    {HCI_LE_SUBRATE_CHANGE_EVT, "l2cble_process_subrate_change_evt", 0},
+#ifdef DIR_FINDING_FEATURE
+    {HCI_LE_CONN_IQ_REPORT_EVT, NOT_OBSERVED},
+    {HCI_LE_CTE_REQ_FAILED_EVT, NOT_OBSERVED},
+#endif
+};
+
+#undef NOT_OBSERVED
+
+// Parameters a few bytes longer than the minimum, all zero. Events of any
+// length have a minimum of 255.
+uint8_t PaddedLength(int min_len) { return std::min(min_len + 3, 255); }
+
+class BtuHcifDispatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override { handler_call = {}; }
+
+  // Dispatches event |code| with |len| bytes of zeroed parameters, the first
+  // of which is the sub-event code of |expected| for LE events, and checks
+  // that the handler the switch ran for it gets the same length.
+  void ExpectHandled(uint8_t code, uint8_t len, const SwitchCase& expected) {
+    std::vector<uint8_t> params(len, 0);
+    if (code == HCI_BLE_EVENT) params[0] = expected.code;
+    ASSERT_EQ(HciEventDispatcher::kHandled,
+              dispatcher_.Dispatch(code, params.data(), len));
+    if (expected.handler == nullptr) return;
+    EXPECT_STREQ(expected.handler, handler_call.name);
+    if (handler_call.len != kNoLength)
+      EXPECT_EQ(len + expected.len_offset, handler_call.len);
+  }
+
+  const HciEventDispatcher dispatcher_ = btu_hcif_build_dispatcher();
+};
+
+}  // namespace
+
+TEST_F(BtuHcifDispatcherTest, registers_every_event_of_the_switch) {
+  std::vector<bool> expected(256, false);
+  for (const SwitchCase& c : kSwitchEvents) {
+    SCOPED_TRACE((int)c.code);
+    expected[c.code] = true;
+    EXPECT_TRUE(dispatcher_.IsRegistered(c.code));
+    EXPECT_EQ(hci_event_parameters_minimum_length[c.code],
+              dispatcher_.MinLength(c.code));
+  }
+  for (int code = 0; code < 256; code++) {
+    if (code == HCI_BLE_EVENT) continue;
+    EXPECT_EQ(expected[code], dispatcher_.IsRegistered(code)) << code;
+  }
+}
+
+TEST_F(BtuHcifDispatcherTest, registers_every_le_event_of_the_switch) {
+  std::vector<bool> expected(256, false);
+  for (const SwitchCase& c : kSwitchLeEvents) {
+    SCOPED_TRACE((int)c.code);
+    ASSERT_LT(c.code, sizeof(hci_le_event_parameters_minimum_length));
+    expected[c.code] = true;
+    EXPECT_TRUE(dispatcher_.IsLeRegistered(c.code));
+    EXPECT_EQ(hci_le_event_parameters_minimum_length[c.code],
+              dispatcher_.LeMinLength(c.code));
+  }
+  for (int sub_code = 0; sub_code < 256; sub_code++) {
+    EXPECT_EQ(expected[sub_code], dispatcher_.IsLeRegistered(sub_code))
+        << sub_code;
+    EXPECT_EQ(sub_code == HCI_BLE_ADV_PKT_RPT_EVT ||
+                  sub_code == HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT,
+              dispatcher_.IsLeHot(sub_code))
+        << sub_code;
+  }
+}
+
+TEST_F(BtuHcifDispatcherTest, handlers_get_the_length_the_switch_passed) {
+  for (const SwitchCase& c : kSwitchEvents) {
+    SCOPED_TRACE((int)c.code);
+    uint8_t min_len = hci_event_parameters_minimum_length[c.code];
+    ExpectHandled(c.code, PaddedLength(min_len), c);
+  }
+  for (const SwitchCase& c : kSwitchLeEvents) {
+    SCOPED_TRACE((int)c.code);
+    uint8_t min_len = hci_le_event_parameters_minimum_length[c.code];
+    ExpectHandled(HCI_BLE_EVENT, PaddedLength(1 + min_len), c);
+  }
+}
@@ -0,0 +1,299 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "hcimsgs.h"
+#include "l2c_int.h"
+
+tL2C_CB l2cb;
+
+TEST(L2cHandleIndexTest, zeroed_index_is_empty) {
+  tL2C_HANDLE_INDEX index;
+  memset(&index, 0, sizeof(index));
+  for (uint16_t handle = 0; handle < L2C_HANDLE_INDEX_SIZE; handle++)
+    ASSERT_EQ(-1, l2c_handle_index_get(&index, handle));
+}
+
+TEST(L2cHandleIndexTest, set_get_clear) {
+  tL2C_HANDLE_INDEX index = {};
+
+  l2c_handle_index_set(&index, 0x0001, 0);
+  l2c_handle_index_set(&index, 0x0EFF, 6);
+  EXPECT_EQ(0, l2c_handle_index_get(&index, 0x0001));
+  EXPECT_EQ(6, l2c_handle_index_get(&index, 0x0EFF));
+
+  l2c_handle_index_clear(&index, 0x0001, 0);
+  EXPECT_EQ(-1, l2c_handle_index_get(&index, 0x0001));
+  EXPECT_EQ(6, l2c_handle_index_get(&index, 0x0EFF));
+}
+
+TEST(L2cHandleIndexTest, clear_only_own_mapping) {
+  tL2C_HANDLE_INDEX index = {};
+
+  // A released LCB keeps its stale handle, which a new link then reuses
+  l2c_handle_index_set(&index, 0x0042, 1);
+  l2c_handle_index_set(&index, 0x0042, 3);
+  l2c_handle_index_clear(&index, 0x0042, 1);
+  EXPECT_EQ(3, l2c_handle_index_get(&index, 0x0042));
+}
+
+TEST(L2cHandleIndexTest, handles_outside_are_ignored) {
+  tL2C_HANDLE_INDEX index = {};
+
+  EXPECT_FALSE(l2c_handle_index_covers(0xFFFF));
+  l2c_handle_index_set(&index, 0xFFFF, 2);
+  EXPECT_EQ(-1, l2c_handle_index_get(&index, 0xFFFF));
+  l2c_handle_index_clear(&index, 0xFFFF, 2);
+}
+
+namespace {
+
+// Linear walk of the pool, as l2cu_find_lcb_by_handle did before the index
+tL2C_LCB* FindLcbLinear(uint16_t handle) {
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+    tL2C_LCB* p_lcb = &l2cb.lcb_pool[xx];
+    if (p_lcb->in_use && p_lcb->handle == handle) return p_lcb;
+  }
+  return nullptr;
+}
+
+// The link l2c_rcv_acl_data resolves for an ACL packet of |handle|
+tL2C_LCB* FindLcbForAcl(uint16_t handle) {
+  uint16_t hdr = handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT);
+  return l2cu_find_lcb_by_handle(HCID_GET_HANDLE(hdr));
+}
+
+}  // namespace
+
+// Drives the LCB pool through the same handle transitions as the link
+// manager and checks every lookup against the linear walk.
+class L2cLcbHandleTest : public ::testing::Test {
+ protected:
+  void SetUp() override { memset((void*)&l2cb, 0, sizeof(l2cb)); }
+
+  // l2cu_allocate_lcb followed by l2c_link_hci_conn_comp
+  tL2C_LCB* Connect(uint16_t handle) {
+    for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+      tL2C_LCB* p_lcb = &l2cb.lcb_pool[xx];
+      if (p_lcb->in_use) continue;
+      l2cu_clear_lcb_handle(p_lcb);
+      memset(p_lcb, 0, sizeof(tL2C_LCB));
+      p_lcb->in_use = true;
+      p_lcb->handle = HCI_INVALID_HANDLE;
+      l2cu_set_lcb_handle(p_lcb, handle);
+      return p_lcb;
+    }
+    return nullptr;
+  }
+
+  // l2cu_release_lcb
+  void Release(tL2C_LCB* p_lcb) {
+    p_lcb->in_use = false;
+    l2cu_clear_lcb_handle(p_lcb);
+  }
+
+  void ExpectMatchesPool() {
+    for (uint16_t handle = 0; handle < L2C_HANDLE_INDEX_SIZE; handle++) {
+      ASSERT_EQ(FindLcbLinear(handle), l2cu_find_lcb_by_handle(handle))
+          << "handle " << handle;
+      ASSERT_EQ(FindLcbLinear(handle), FindLcbForAcl(handle))
+          << "handle " << handle;
+    }
+    ASSERT_EQ(FindLcbLinear(HCI_INVALID_HANDLE),
+              l2cu_find_lcb_by_handle(HCI_INVALID_HANDLE));
+  }
+};
+
+TEST_F(L2cLcbHandleTest, connect_reassign_release) {
+  tL2C_LCB* p_lcb1 = Connect(0x0001);
+  tL2C_LCB* p_lcb2 = Connect(0x0002);
+  ASSERT_NE(nullptr, p_lcb1);
+  ASSERT_NE(nullptr, p_lcb2);
+  EXPECT_EQ(p_lcb1, l2cu_find_lcb_by_handle(0x0001));
+  EXPECT_EQ(p_lcb2, FindLcbForAcl(0x0002));
+  ExpectMatchesPool();
+
+  // Connection failed with too many links: held without a handle
+  l2cu_set_lcb_handle(p_lcb2, HCI_INVALID_HANDLE);
+  EXPECT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0002));
+  EXPECT_EQ(p_lcb2, l2cu_find_lcb_by_handle(HCI_INVALID_HANDLE));
+  ExpectMatchesPool();
+
+  // Retried and completed on a new handle
+  l2cu_set_lcb_handle(p_lcb2, 0x0003);
+  EXPECT_EQ(p_lcb2, l2cu_find_lcb_by_handle(0x0003));
+  ExpectMatchesPool();
+
+  // Released links keep their stale handle, which must not resolve
+  Release(p_lcb1);
+  EXPECT_EQ(0x0001, p_lcb1->handle);
+  EXPECT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0001));
+  ExpectMatchesPool();
+
+  // The controller reuses the handle of the released link for a new one
+  tL2C_LCB* p_lcb3 = Connect(0x0001);
+  EXPECT_EQ(p_lcb1, p_lcb3);
+  EXPECT_EQ(p_lcb3, l2cu_find_lcb_by_handle(0x0001));
+  ExpectMatchesPool();
+}
+
+TEST_F(L2cLcbHandleTest, stale_handle_reused_by_other_slot) {
+  tL2C_LCB* p_lcb1 = Connect(0x0010);
+  tL2C_LCB* p_lcb2 = Connect(0x0020);
+  Release(p_lcb1);
+
+  // Another slot gets the stale handle of the released LCB; reallocating the
+  // released LCB must not drop that mapping
+  l2cu_set_lcb_handle(p_lcb2, 0x0010);
+  tL2C_LCB* p_lcb3 = Connect(0x0030);
+  EXPECT_EQ(p_lcb1, p_lcb3);
+  EXPECT_EQ(p_lcb2, l2cu_find_lcb_by_handle(0x0010));
+  EXPECT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0020));
+  ExpectMatchesPool();
+}
+
+TEST_F(L2cLcbHandleTest, random_link_churn) {
+  std::mt19937 rng(34);
+  std::vector<tL2C_LCB*> links;
+
+  for (int step = 0; step < 2000; step++) {
+    uint32_t op = rng() % 3;
+    if (op == 0 || links.empty()) {
+      uint16_t handle = rng() % 0x0EFF;
+      if (FindLcbLinear(handle) != nullptr) continue;
+      tL2C_LCB* p_lcb = Connect(handle);
+      if (p_lcb != nullptr) links.push_back(p_lcb);
+    } else if (op == 1) {
+      tL2C_LCB* p_lcb = links[rng() % links.size()];
+      uint16_t handle =
+          (rng() % 4 == 0) ? HCI_INVALID_HANDLE : (uint16_t)(rng() % 0x0EFF);
+      if (handle != HCI_INVALID_HANDLE && FindLcbLinear(handle) != nullptr)
+        continue;
+      l2cu_set_lcb_handle(p_lcb, handle);
+    } else {
+      size_t i = rng() % links.size();
+      Release(links[i]);
+      links.erase(links.begin() + i);
+    }
+    if (step % 50 == 0) ExpectMatchesPool();
+  }
+  ExpectMatchesPool();
+}
+
+namespace {
+
+struct Link {
+  bool in_use;
+  uint16_t handle;
+};
+
+struct Channel {
+  bool in_use;
+  Link* p_link;
+};
+
+const uint16_t kBaseCid = 0x0040;
+
+// Pools laid out as in l2cb, with the handle index maintained as
+// l2cu_set_lcb_handle does.
+struct Pools {
+  Pools(size_t links, size_t channels_per_link)
+      : links(links), channels(links * channels_per_link) {
+    std::mt19937 rng(links);
+    for (size_t i = 0; i < links; i++) {
+      uint16_t handle;
+      do {
+        handle = rng() % 0x0EFF;
+      } while (l2c_handle_index_get(&index, handle) >= 0);
+      this->links[i] = {true, handle};
+      l2c_handle_index_set(&index, handle, i);
+    }
+    for (size_t i = 0; i < channels.size(); i++)
+      channels[i] = {true, &this->links[i % links]};
+  }
+
+  Link* FindLinkLinear(uint16_t handle) {
+    for (auto& link : links)
+      if (link.in_use && link.handle == handle) return &link;
+    return nullptr;
+  }
+
+  Link* FindLinkIndexed(uint16_t handle) {
+    int slot = l2c_handle_index_get(&index, handle);
+    if (slot < 0) return nullptr;
+    Link* p_link = &links[slot];
+    return (p_link->in_use && p_link->handle == handle) ? p_link : nullptr;
+  }
+
+  Channel* FindChannel(Link* p_link, uint16_t cid) {
+    uint16_t i = cid - kBaseCid;
+    if (i >= channels.size()) return nullptr;
+    Channel* p_channel = &channels[i];
+    return (p_channel->in_use && p_channel->p_link == p_link) ? p_channel
+                                                                : nullptr;
+  }
+
+  std::vector<Link> links;
+  std::vector<Channel> channels;
+  tL2C_HANDLE_INDEX index = {};
+};
+
+}  // namespace
+
+// Resolves the link and channel of ACL packets spread over many links with
+// many channels each, as l2c_rcv_acl_data does, with the linear pool walk and
+// with the handle index.
+TEST(L2cHandleIndexTest, acl_packet_lookup_benchmark) {
+  const int kPackets = 2000000;
+  const size_t kChannelsPerLink = 8;
+
+  for (size_t num_links : {2, 7, 16, 32}) {
+    Pools pools(num_links, kChannelsPerLink);
+    std::mt19937 rng(34);
+    std::vector<std::pair<uint16_t, uint16_t>> packets;
+    for (int i = 0; i < kPackets; i++) {
+      size_t channel = rng() % pools.channels.size();
+      packets.emplace_back(pools.channels[channel].p_link->handle,
+                           kBaseCid + channel);
+    }
+
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& packet : packets) {
+      Link* p_link = pools.FindLinkLinear(packet.first);
+      found += pools.FindChannel(p_link, packet.second) != nullptr;
+    }
+    auto linear_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    int found_indexed = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto& packet : packets) {
+      Link* p_link = pools.FindLinkIndexed(packet.first);
+      found_indexed += pools.FindChannel(p_link, packet.second) != nullptr;
+    }
+    auto indexed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+    EXPECT_EQ(kPackets, found);
+    EXPECT_EQ(kPackets, found_indexed);
+    printf("%2zu links x %zu channels: indexed %.2f ns/packet, linear %.2f "
+           "ns/packet\n",
+           num_links, kChannelsPerLink, (double)indexed_ns / kPackets,
+           (double)linear_ns / kPackets);
+  }
+}
@@ -100,6 +100,19 @@ void UIPC_Close(tUIPC_CH_ID ch_id);
 bool UIPC_Send(tUIPC_CH_ID ch_id, uint16_t msg_evt, const uint8_t* p_buf,
                uint16_t msglen);
 
+/*******************************************************************************
+ *
+ * Function         UIPC_SendFds
+ *
+ * Description      Called to transmit a message over UIPC along with file
+ *                  descriptors, which are duplicated into the peer process.
+ *
+ * Returns          true in case of success, false in case of failure.
+ *
+ ******************************************************************************/
+bool UIPC_SendFds(tUIPC_CH_ID ch_id, const uint8_t* p_buf, uint16_t msglen,
+                  const int* p_fds, uint8_t num_fds);
+
 /*******************************************************************************
  *
  * Function         UIPC_Read
@@ -0,0 +1,305 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bt_trace.h"
+#include "osi/include/properties.h"
+#include "osi/include/socket_utils/sockets.h"
+#include "uipc.h"
+#include "utils/include/bt_utils.h"
+
+uint8_t btif_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+void vnd_LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+void raise_priority_a2dp(tHIGH_PRIORITY_TASK high_task) {}
+
+namespace {
+
+constexpr char kSharedThreadProperty[] =
+    "persist.vendor.btstack.uipc.shared_thread";
+
+/* Audio frames every 2 ms for one second, like a short A2DP packet interval */
+constexpr int kAudioFrames = 500;
+constexpr uint64_t kAudioIntervalUs = 2000;
+/* A control command every 3 ms whose handling takes 2 ms, e.g. a busy btif
+ * thread answering A2DP_CTRL_CMD_CHECK_READY */
+constexpr uint64_t kCtrlIntervalUs = 3000;
+constexpr uint64_t kCtrlWorkUs = 2000;
+
+uint64_t now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void sleep_until_us(uint64_t deadline_us) {
+  uint64_t now = now_us();
+  if (deadline_us > now) usleep(deadline_us - now);
+}
+
+std::string socket_path(const char* name) {
+  return ::testing::TempDir() + "uipc_test_" + std::to_string(getpid()) + "_" +
+         name;
+}
+
+/* Connects the way the audio HAL does */
+int connect_client(const std::string& path) {
+  int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+  if (osi_socket_local_client_connect(fd, path.c_str(),
+                                      ANDROID_SOCKET_NAMESPACE_ABSTRACT,
+                                      SOCK_STREAM) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/* Callback state shared with the UIPC threads */
+std::mutex events_mutex;
+std::condition_variable events_cv;
+int open_events[UIPC_CH_NUM];
+int close_events[UIPC_CH_NUM];
+std::vector<uint64_t> audio_latencies_us;
+std::atomic<int> ctrl_commands;
+
+void reset_events() {
+  std::lock_guard<std::mutex> lock(events_mutex);
+  for (int i = 0; i < UIPC_CH_NUM; i++) {
+    open_events[i] = 0;
+    close_events[i] = 0;
+  }
+  audio_latencies_us.clear();
+  ctrl_commands = 0;
+}
+
+bool wait_for(int* counter, int value) {
+  std::unique_lock<std::mutex> lock(events_mutex);
+  return events_cv.wait_for(lock, std::chrono::seconds(2),
+                            [&] { return *counter >= value; });
+}
+
+void count_event(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  std::lock_guard<std::mutex> lock(events_mutex);
+  if (event == UIPC_OPEN_EVT) open_events[ch_id]++;
+  if (event == UIPC_CLOSE_EVT) close_events[ch_id]++;
+  events_cv.notify_all();
+}
+
+void ctrl_cback(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event != UIPC_RX_DATA_READY_EVT) {
+    count_event(ch_id, event);
+    return;
+  }
+
+  uint8_t cmd;
+  if (UIPC_Read(ch_id, NULL, &cmd, 1) != 1) return;
+  uint64_t end_us = now_us() + kCtrlWorkUs;
+  while (now_us() < end_us) {
+  }
+  UIPC_Send(ch_id, 0, &cmd, 1);
+  ctrl_commands++;
+}
+
+void audio_cback(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event != UIPC_RX_DATA_READY_EVT) {
+    count_event(ch_id, event);
+    return;
+  }
+
+  uint64_t sent_us;
+  if (UIPC_Read(ch_id, NULL, (uint8_t*)&sent_us, sizeof(sent_us)) !=
+      sizeof(sent_us))
+    return;
+  uint64_t latency_us = now_us() - sent_us;
+  std::lock_guard<std::mutex> lock(events_mutex);
+  audio_latencies_us.push_back(latency_us);
+  events_cv.notify_all();
+}
+
+struct LatencyResult {
+  uint64_t p50_us;
+  uint64_t p99_us;
+  uint64_t max_us;
+  int ctrl_commands;
+};
+
+/* Streams timestamped audio frames while control commands keep the control
+ * channel busy, and returns how late the audio frames were delivered. */
+LatencyResult stream_with_ctrl_traffic(bool shared_thread) {
+  osi_property_set(kSharedThreadProperty, shared_thread ? "true" : "false");
+  reset_events();
+  UIPC_Init(NULL);
+
+  std::string ctrl_path = socket_path("ctrl");
+  std::string audio_path = socket_path("audio");
+  EXPECT_TRUE(UIPC_Open(UIPC_CH_ID_AV_CTRL, ctrl_cback, ctrl_path.c_str()));
+  EXPECT_TRUE(UIPC_Open(UIPC_CH_ID_AV_AUDIO, audio_cback, audio_path.c_str()));
+
+  int ctrl_fd = connect_client(ctrl_path);
+  int audio_fd = connect_client(audio_path);
+  EXPECT_GE(ctrl_fd, 0);
+  EXPECT_GE(audio_fd, 0);
+  EXPECT_TRUE(wait_for(&open_events[UIPC_CH_ID_AV_CTRL], 1));
+  EXPECT_TRUE(wait_for(&open_events[UIPC_CH_ID_AV_AUDIO], 1));
+
+  std::atomic<bool> streaming(true);
+  std::thread ctrl_client([&] {
+    uint64_t next_us = now_us();
+    while (streaming) {
+      uint8_t cmd = 1;
+      if (write(ctrl_fd, &cmd, 1) != 1) break;
+      if (read(ctrl_fd, &cmd, 1) != 1) break;
+      next_us += kCtrlIntervalUs;
+      sleep_until_us(next_us);
+    }
+  });
+
+  uint64_t next_us = now_us();
+  for (int i = 0; i < kAudioFrames; i++) {
+    uint64_t sent_us = now_us();
+    EXPECT_EQ((ssize_t)sizeof(sent_us), write(audio_fd, &sent_us, sizeof(sent_us)));
+    next_us += kAudioIntervalUs;
+    sleep_until_us(next_us);
+  }
+  {
+    std::unique_lock<std::mutex> lock(events_mutex);
+    events_cv.wait_for(lock, std::chrono::seconds(2), [] {
+      return audio_latencies_us.size() >= (size_t)kAudioFrames;
+    });
+  }
+  streaming = false;
+  ctrl_client.join();
+
+  UIPC_Close(UIPC_CH_ID_ALL);
+  close(ctrl_fd);
+  close(audio_fd);
+
+  LatencyResult result = {};
+  std::vector<uint64_t> latencies = audio_latencies_us;
+  EXPECT_EQ((size_t)kAudioFrames, latencies.size());
+  if (latencies.empty()) return result;
+  std::sort(latencies.begin(), latencies.end());
+  result.p50_us = latencies[latencies.size() / 2];
+  result.p99_us = latencies[latencies.size() * 99 / 100];
+  result.max_us = latencies.back();
+  result.ctrl_commands = ctrl_commands;
+  return result;
+}
+
+}  // namespace
+
+class UipcTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    osi_property_set(kSharedThreadProperty, "false");
+    reset_events();
+  }
+
+  void TearDown() override { UIPC_Close(UIPC_CH_ID_ALL); }
+};
+
+TEST_F(UipcTest, test_open_requires_init) {
+  std::string path = socket_path("ctrl");
+  EXPECT_FALSE(UIPC_Open(UIPC_CH_ID_AV_CTRL, ctrl_cback, path.c_str()));
+}
+
+TEST_F(UipcTest, test_remote_detach_and_reopen) {
+  UIPC_Init(NULL);
+  std::string path = socket_path("ctrl");
+  ASSERT_TRUE(UIPC_Open(UIPC_CH_ID_AV_CTRL, ctrl_cback, path.c_str()));
+
+  int fd = connect_client(path);
+  ASSERT_GE(fd, 0);
+  ASSERT_TRUE(wait_for(&open_events[UIPC_CH_ID_AV_CTRL], 1));
+
+  uint8_t cmd = 7;
+  ASSERT_EQ(1, write(fd, &cmd, 1));
+  cmd = 0;
+  ASSERT_EQ(1, read(fd, &cmd, 1));
+  EXPECT_EQ(7, cmd);
+
+  /* The read callback sees the hang up and schedules the close */
+  close(fd);
+  ASSERT_TRUE(wait_for(&close_events[UIPC_CH_ID_AV_CTRL], 1));
+  EXPECT_EQ(-1, connect_client(path));
+
+  ASSERT_TRUE(UIPC_Open(UIPC_CH_ID_AV_CTRL, ctrl_cback, path.c_str()));
+  fd = connect_client(path);
+  ASSERT_GE(fd, 0);
+  EXPECT_TRUE(wait_for(&open_events[UIPC_CH_ID_AV_CTRL], 2));
+  close(fd);
+}
+
+TEST_F(UipcTest, test_close_is_coalesced) {
+  UIPC_Init(NULL);
+  std::string path = socket_path("audio");
+  ASSERT_TRUE(UIPC_Open(UIPC_CH_ID_AV_AUDIO, audio_cback, path.c_str()));
+
+  UIPC_Close(UIPC_CH_ID_AV_AUDIO);
+  UIPC_Close(UIPC_CH_ID_AV_AUDIO);
+  ASSERT_TRUE(wait_for(&close_events[UIPC_CH_ID_AV_AUDIO], 1));
+  UIPC_Close(UIPC_CH_ID_AV_AUDIO);
+  usleep(20000);
+
+  std::lock_guard<std::mutex> lock(events_mutex);
+  EXPECT_EQ(1, close_events[UIPC_CH_ID_AV_AUDIO]);
+}
+
+TEST_F(UipcTest, test_shutdown_closes_all_channels) {
+  UIPC_Init(NULL);
+  std::string ctrl_path = socket_path("ctrl");
+  std::string audio_path = socket_path("audio");
+  ASSERT_TRUE(UIPC_Open(UIPC_CH_ID_AV_CTRL, ctrl_cback, ctrl_path.c_str()));
+  ASSERT_TRUE(
+      UIPC_Open(UIPC_CH_ID_AV_AUDIO, audio_cback, audio_path.c_str()));
+
+  UIPC_Close(UIPC_CH_ID_ALL);
+  EXPECT_EQ(1, close_events[UIPC_CH_ID_AV_CTRL]);
+  EXPECT_EQ(1, close_events[UIPC_CH_ID_AV_AUDIO]);
+  EXPECT_FALSE(UIPC_Open(UIPC_CH_ID_AV_CTRL, ctrl_cback, ctrl_path.c_str()));
+}
+
+TEST_F(UipcTest, test_audio_latency_with_ctrl_traffic) {
+  LatencyResult shared = stream_with_ctrl_traffic(true);
+  LatencyResult dedicated = stream_with_ctrl_traffic(false);
+
+  printf(
+      "shared thread:    audio latency p50 %llu us p99 %llu us max %llu us, "
+      "%d ctrl commands\n",
+      (unsigned long long)shared.p50_us, (unsigned long long)shared.p99_us,
+      (unsigned long long)shared.max_us, shared.ctrl_commands);
+  printf(
+      "dedicated thread: audio latency p50 %llu us p99 %llu us max %llu us, "
+      "%d ctrl commands\n",
+      (unsigned long long)dedicated.p50_us,
+      (unsigned long long)dedicated.p99_us,
+      (unsigned long long)dedicated.max_us, dedicated.ctrl_commands);
+
+  EXPECT_GT(shared.ctrl_commands, 0);
+  EXPECT_GT(dedicated.ctrl_commands, 0);
+  /* Audio no longer waits behind control command handling */
+  EXPECT_LT(dedicated.p99_us, shared.p99_us);
+  EXPECT_LT(dedicated.p99_us, kCtrlWorkUs);
+}
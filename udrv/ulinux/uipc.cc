@@ -32,8 +32,6 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/poll.h>
-#include <sys/prctl.h>
-#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/un.h>
@@ -53,7 +51,10 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/reactor.h"
 #include "osi/include/socket_utils/sockets.h"
+#include "osi/include/thread.h"
 #include "uipc.h"
 
 /*****************************************************************************
@@ -62,47 +63,56 @@
 
 #define PCM_FILENAME "/data/test.pcm"
 
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-
 #define CASE_RETURN_STR(const) \
   case const:                  \
     return #const;
 
 #define UIPC_DISCONNECTED (-1)
 
-#define SAFE_FD_ISSET(fd, set) (((fd) == -1) ? false : FD_ISSET((fd), (set)))
-
 #define UIPC_FLUSH_BUFFER_SIZE 1024
 
+/* Max number of file descriptors passed along with one message */
+#define UIPC_MAX_SEND_FDS 4
+
 #define CHAN_CREATE_WAIT_TIME_MS 30
 #define CHAN_CREATE_RETRY_COUNT 10
 
+
+/* Share one reactor thread between all channels instead of giving audio data
+ * a thread of its own */
+#define UIPC_SHARED_THREAD_PROPERTY "persist.vendor.btstack.uipc.shared_thread"
+
 /*****************************************************************************
  *  Local type definitions
  *****************************************************************************/
 
+/* Reactor threads serving the channels. Audio data has a thread of its own so
+ * that slow control command handling can not delay it. */
 typedef enum {
-  UIPC_TASK_FLAG_DISCONNECT_CHAN = 0x1,
-} tUIPC_TASK_FLAGS;
-
+  UIPC_THREAD_CTRL,
+  UIPC_THREAD_AUDIO,
+  UIPC_THREAD_NUM,
+} tUIPC_THREAD_ID;
+
+/* Sockets and reactor registrations of a channel are only released on the
+ * channel thread; other threads schedule a close there. The mutex is never
+ * held while calling |cback|. */
 typedef struct {
+  std::recursive_mutex mutex;
   int srvfd;
   int fd;
   int read_poll_tmo_ms;
-  int task_evt_flags; /* event flags pending to be processed in read task */
+  bool close_pending; /* close scheduled on the channel thread */
+  reactor_object_t* srv_object;
+  reactor_object_t* fd_object;
   tUIPC_RCV_CBACK* cback;
+  thread_t* thread;
 } tUIPC_CHAN;
 
 typedef struct {
-  pthread_t tid; /* main thread id */
-  int running;
-  std::recursive_mutex mutex;
-
-  fd_set active_set;
-  fd_set read_set;
-  int max_fd;
-  int signal_fds[2];
-
+  std::mutex lock; /* serializes start, shutdown and channel setup */
+  bool running;
+  thread_t* thread[UIPC_THREAD_NUM];
   tUIPC_CHAN ch[UIPC_CH_NUM];
 } tUIPC_MAIN;
 
@@ -112,11 +122,21 @@ typedef struct {
 
 static tUIPC_MAIN uipc_main;
 
+static const tUIPC_THREAD_ID uipc_ch_thread[UIPC_CH_NUM] = {
+    UIPC_THREAD_CTRL,  /* UIPC_CH_ID_AV_CTRL */
+    UIPC_THREAD_AUDIO, /* UIPC_CH_ID_AV_AUDIO */
+};
+
+static const char* const uipc_thread_name[UIPC_THREAD_NUM] = {"uipc_ctrl",
+                                                              "uipc_audio"};
+
 /*****************************************************************************
  *  Static functions
  *****************************************************************************/
 
-static int uipc_close_ch_locked(tUIPC_CH_ID ch_id);
+static void uipc_close_ch(void* context);
+static void uipc_accept_ready(void* context);
+static void uipc_read_ready(void* context);
 
 /*****************************************************************************
  *  Externs
@@ -220,139 +240,97 @@ static int accept_server_socket(int sfd) {
  *
  ****************************************************************************/
 
-static int uipc_main_init(void) {
-  int i;
+static void uipc_raise_priority(UNUSED_ATTR void* context) {
+  raise_priority_a2dp(TASK_UIPC_READ);
+}
 
+static void uipc_main_init(void) {
   BTIF_TRACE_EVENT("### uipc_main_init ###");
 
-  uipc_main.tid = 0;
-  uipc_main.running = 0;
-  memset(&uipc_main.active_set, 0, sizeof(uipc_main.active_set));
-  memset(&uipc_main.read_set, 0, sizeof(uipc_main.read_set));
-  uipc_main.max_fd = 0;
-  memset(&uipc_main.signal_fds, 0, sizeof(uipc_main.signal_fds));
-  memset(&uipc_main.ch, 0, sizeof(uipc_main.ch));
-
-  /* setup interrupt socket pair */
-  if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc_main.signal_fds) < 0) {
-    return -1;
-  }
-
-  FD_SET(uipc_main.signal_fds[0], &uipc_main.active_set);
-  uipc_main.max_fd = MAX(uipc_main.max_fd, uipc_main.signal_fds[0]);
-
-  for (i = 0; i < UIPC_CH_NUM; i++) {
+  for (int i = 0; i < UIPC_CH_NUM; i++) {
     tUIPC_CHAN* p = &uipc_main.ch[i];
+    std::lock_guard<std::recursive_mutex> lock(p->mutex);
     p->srvfd = UIPC_DISCONNECTED;
     p->fd = UIPC_DISCONNECTED;
-    p->task_evt_flags = 0;
+    p->read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
+    p->close_pending = false;
+    p->srv_object = NULL;
+    p->fd_object = NULL;
     p->cback = NULL;
+    p->thread = NULL;
   }
-
-  return 0;
 }
 
-void uipc_main_cleanup(void) {
-  int i;
-
-  BTIF_TRACE_EVENT("uipc_main_cleanup");
-
-  OSI_NO_INTR(close(uipc_main.signal_fds[0]));
-  OSI_NO_INTR(close(uipc_main.signal_fds[1]));
-
-  /* close any open channels */
-  for (i = 0; i < UIPC_CH_NUM; i++) uipc_close_ch_locked(i);
-}
-
-/* check pending events in read task */
-static void uipc_check_task_flags_locked(void) {
-  int i;
-
-  for (i = 0; i < UIPC_CH_NUM; i++) {
-    if (uipc_main.ch[i].task_evt_flags & UIPC_TASK_FLAG_DISCONNECT_CHAN) {
-      uipc_main.ch[i].task_evt_flags &= ~UIPC_TASK_FLAG_DISCONNECT_CHAN;
-      uipc_close_ch_locked(i);
-    }
-
-    /* add here */
+/* closes the connection, must run on the channel thread */
+static void uipc_release_fd_locked(tUIPC_CHAN* p) {
+  if (p->fd_object != NULL) {
+    reactor_unregister(p->fd_object);
+    p->fd_object = NULL;
+  }
+  if (p->fd != UIPC_DISCONNECTED) {
+    BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", p->fd);
+    OSI_NO_INTR(close(p->fd));
+    p->fd = UIPC_DISCONNECTED;
   }
 }
 
-static int uipc_check_fd_locked(tUIPC_CH_ID ch_id) {
-  if (ch_id >= UIPC_CH_NUM) return -1;
+static void uipc_accept_ready(void* context) {
+  tUIPC_CH_ID ch_id = PTR_TO_UINT(context);
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
 
-  // BTIF_TRACE_EVENT("CHECK SRVFD %d (ch %d)", uipc_main.ch[ch_id].srvfd,
-  // ch_id);
+  std::unique_lock<std::recursive_mutex> lock(p->mutex);
+  if (p->srvfd == UIPC_DISCONNECTED || p->close_pending) return;
 
-  if (SAFE_FD_ISSET(uipc_main.ch[ch_id].srvfd, &uipc_main.read_set)) {
-    BTIF_TRACE_EVENT("INCOMING CONNECTION ON CH %d", ch_id);
+  BTIF_TRACE_EVENT("INCOMING CONNECTION ON CH %d", ch_id);
 
-    // Close the previous connection
-    if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED) {
-      BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc_main.ch[ch_id].fd);
-      OSI_NO_INTR(close(uipc_main.ch[ch_id].fd));
-      FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-      uipc_main.ch[ch_id].fd = UIPC_DISCONNECTED;
-    }
-
-    uipc_main.ch[ch_id].fd = accept_server_socket(uipc_main.ch[ch_id].srvfd);
+  // Close the previous connection
+  uipc_release_fd_locked(p);
 
-    BTIF_TRACE_EVENT("NEW FD %d", uipc_main.ch[ch_id].fd);
+  p->fd = accept_server_socket(p->srvfd);
 
-    if ((uipc_main.ch[ch_id].fd >= 0) && uipc_main.ch[ch_id].cback) {
-      /*  if we have a callback we should add this fd to the active set
-          and notify user with callback event */
-      BTIF_TRACE_EVENT("ADD FD %d TO ACTIVE SET", uipc_main.ch[ch_id].fd);
-      FD_SET(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-      uipc_main.max_fd = MAX(uipc_main.max_fd, uipc_main.ch[ch_id].fd);
-    }
+  BTIF_TRACE_EVENT("NEW FD %d", p->fd);
 
-    if (uipc_main.ch[ch_id].fd < 0) {
-      BTIF_TRACE_ERROR("FAILED TO ACCEPT CH %d", ch_id);
-      return -1;
-    }
-
-    if (uipc_main.ch[ch_id].cback)
-      uipc_main.ch[ch_id].cback(ch_id, UIPC_OPEN_EVT);
+  if (p->fd < 0) {
+    BTIF_TRACE_ERROR("FAILED TO ACCEPT CH %d", ch_id);
+    p->fd = UIPC_DISCONNECTED;
+    return;
   }
 
-  // BTIF_TRACE_EVENT("CHECK FD %d (ch %d)", uipc_main.ch[ch_id].fd, ch_id);
-
-  if (SAFE_FD_ISSET(uipc_main.ch[ch_id].fd, &uipc_main.read_set)) {
-    // BTIF_TRACE_EVENT("INCOMING DATA ON CH %d", ch_id);
-
-    if (uipc_main.ch[ch_id].cback)
-      uipc_main.ch[ch_id].cback(ch_id, UIPC_RX_DATA_READY_EVT);
+  tUIPC_RCV_CBACK* cback = p->cback;
+  if (cback) {
+    /*  if we have a callback we should watch this fd and notify user with
+        callback event */
+    BTIF_TRACE_EVENT("WATCH FD %d", p->fd);
+    p->fd_object = reactor_register(thread_get_reactor(p->thread), p->fd,
+                                    context, uipc_read_ready, NULL);
   }
-  return 0;
-}
+  lock.unlock();
 
-static void uipc_check_interrupt_locked(void) {
-  if (SAFE_FD_ISSET(uipc_main.signal_fds[0], &uipc_main.read_set)) {
-    char sig_recv = 0;
-    OSI_NO_INTR(recv(uipc_main.signal_fds[0], &sig_recv, sizeof(sig_recv),
-                     MSG_WAITALL));
-  }
+  if (cback) cback(ch_id, UIPC_OPEN_EVT);
 }
 
-static inline void uipc_wakeup_locked(void) {
-  char sig_on = 1;
-  BTIF_TRACE_EVENT("UIPC SEND WAKE UP");
+static void uipc_read_ready(void* context) {
+  tUIPC_CH_ID ch_id = PTR_TO_UINT(context);
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
+  tUIPC_RCV_CBACK* cback;
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(p->mutex);
+    if (p->fd == UIPC_DISCONNECTED || p->close_pending) return;
+    cback = p->cback;
+  }
 
-  OSI_NO_INTR(send(uipc_main.signal_fds[1], &sig_on, sizeof(sig_on), 0));
+  if (cback) cback(ch_id, UIPC_RX_DATA_READY_EVT);
 }
 
 static int uipc_setup_server_locked(tUIPC_CH_ID ch_id, const char* name,
                                     tUIPC_RCV_CBACK* cback) {
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
   int fd;
   int i;
 
   BTIF_TRACE_EVENT("SETUP CHANNEL SERVER %d", ch_id);
 
-  if (ch_id >= UIPC_CH_NUM) return -1;
-
-  std::lock_guard<std::recursive_mutex> guard(uipc_main.mutex);
-
   for (i = 0; i < CHAN_CREATE_RETRY_COUNT; i++)
   {
     fd = create_server_socket(name);
@@ -371,16 +349,12 @@ static int uipc_setup_server_locked(tUIPC_CH_ID ch_id, const char* name,
     return -1;
   }
 
-  BTIF_TRACE_EVENT("ADD SERVER FD TO ACTIVE SET %d", fd);
-  FD_SET(fd, &uipc_main.active_set);
-  uipc_main.max_fd = MAX(uipc_main.max_fd, fd);
-
-  uipc_main.ch[ch_id].srvfd = fd;
-  uipc_main.ch[ch_id].cback = cback;
-  uipc_main.ch[ch_id].read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
-
-  /* trigger main thread to update read set */
-  uipc_wakeup_locked();
+  BTIF_TRACE_EVENT("WATCH SERVER FD %d", fd);
+  p->srvfd = fd;
+  p->cback = cback;
+  p->read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
+  p->srv_object = reactor_register(thread_get_reactor(p->thread), fd,
+                                   UINT_TO_PTR(ch_id), uipc_accept_ready, NULL);
 
   return 0;
 }
@@ -438,131 +412,132 @@ static void uipc_flush_locked(tUIPC_CH_ID ch_id) {
   }
 }
 
-static int uipc_close_ch_locked(tUIPC_CH_ID ch_id) {
-  int wakeup = 0;
+/* runs on the channel thread */
+static void uipc_close_ch(void* context) {
+  tUIPC_CH_ID ch_id = PTR_TO_UINT(context);
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
+  reactor_object_t* objects[2];
+  int fds[2];
+  tUIPC_RCV_CBACK* cback;
 
   BTIF_TRACE_EVENT("CLOSE CHANNEL %d", ch_id);
 
-  if (ch_id >= UIPC_CH_NUM) return -1;
-
-  if (uipc_main.ch[ch_id].srvfd != UIPC_DISCONNECTED) {
-    BTIF_TRACE_EVENT("CLOSE SERVER (FD %d)", uipc_main.ch[ch_id].srvfd);
-    OSI_NO_INTR(close(uipc_main.ch[ch_id].srvfd));
-    FD_CLR(uipc_main.ch[ch_id].srvfd, &uipc_main.active_set);
-    uipc_main.ch[ch_id].srvfd = UIPC_DISCONNECTED;
-    wakeup = 1;
+  {
+    std::lock_guard<std::recursive_mutex> lock(p->mutex);
+    p->close_pending = false;
+
+    objects[0] = p->srv_object;
+    objects[1] = p->fd_object;
+    fds[0] = p->srvfd;
+    fds[1] = p->fd;
+    p->srv_object = NULL;
+    p->fd_object = NULL;
+    p->srvfd = UIPC_DISCONNECTED;
+    p->fd = UIPC_DISCONNECTED;
+    cback = p->cback;
   }
 
-  if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED) {
-    BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc_main.ch[ch_id].fd);
-    OSI_NO_INTR(close(uipc_main.ch[ch_id].fd));
-    FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-    uipc_main.ch[ch_id].fd = UIPC_DISCONNECTED;
-    wakeup = 1;
+  /* the reactor objects are released without the channel lock held, as
+     during shutdown this runs after the reactor stopped */
+  for (int i = 0; i < 2; i++) {
+    if (objects[i] != NULL) reactor_unregister(objects[i]);
+    if (fds[i] != UIPC_DISCONNECTED) {
+      BTIF_TRACE_EVENT("CLOSE %s (FD %d)", i == 0 ? "SERVER" : "CONNECTION",
+                       fds[i]);
+      OSI_NO_INTR(close(fds[i]));
+    }
   }
 
   /* notify this connection is closed */
-  if (uipc_main.ch[ch_id].cback)
-    uipc_main.ch[ch_id].cback(ch_id, UIPC_CLOSE_EVT);
-
-  /* trigger main thread update if something was updated */
-  if (wakeup) uipc_wakeup_locked();
-
-  return 0;
+  if (cback) cback(ch_id, UIPC_CLOSE_EVT);
 }
 
 void uipc_close_locked(tUIPC_CH_ID ch_id) {
-  if (uipc_main.ch[ch_id].srvfd == UIPC_DISCONNECTED) {
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
+
+  if (p->srvfd == UIPC_DISCONNECTED) {
     BTIF_TRACE_EVENT("CHANNEL %d ALREADY CLOSED", ch_id);
     return;
   }
+  if (p->close_pending) return;
 
   /* schedule close on this channel */
-  uipc_main.ch[ch_id].task_evt_flags |= UIPC_TASK_FLAG_DISCONNECT_CHAN;
-  uipc_wakeup_locked();
+  p->close_pending = true;
+  thread_post(p->thread, uipc_close_ch, UINT_TO_PTR(ch_id));
 }
 
-static void* uipc_read_task(UNUSED_ATTR void* arg) {
-  int ch_id;
-  int result;
-
-  prctl(PR_SET_NAME, (unsigned long)"uipc-main", 0, 0, 0);
-
-  raise_priority_a2dp(TASK_UIPC_READ);
+int uipc_start_main_server_thread(void) {
+  std::lock_guard<std::mutex> lock(uipc_main.lock);
 
-  while (uipc_main.running) {
-    uipc_main.read_set = uipc_main.active_set;
+  if (uipc_main.running) {
+    BTIF_TRACE_WARNING("%s: already running", __func__);
+    return 0;
+  }
 
-    result =
-        select(uipc_main.max_fd + 1, &uipc_main.read_set, NULL, NULL, NULL);
+  uipc_main_init();
 
-    if (result == 0) {
-      BTIF_TRACE_EVENT("select timeout");
+  bool shared_thread = osi_property_get_bool(UIPC_SHARED_THREAD_PROPERTY, false);
+  for (int i = 0; i < UIPC_THREAD_NUM; i++) {
+    if (shared_thread && i > 0) {
+      uipc_main.thread[i] = uipc_main.thread[0];
       continue;
     }
-    if (result < 0) {
-      if (errno != EINTR) {
-        BTIF_TRACE_EVENT("select failed %s", strerror(errno));
-      }
-      continue;
-    }
-
-    {
-      std::lock_guard<std::recursive_mutex> guard(uipc_main.mutex);
-
-      /* clear any wakeup interrupt */
-      uipc_check_interrupt_locked();
-
-      /* check pending task events */
-      uipc_check_task_flags_locked();
-
-      /* make sure we service audio channel first */
-      uipc_check_fd_locked(UIPC_CH_ID_AV_AUDIO);
-
-      /* check for other connections */
-      for (ch_id = 0; ch_id < UIPC_CH_NUM; ch_id++) {
-        if (ch_id != UIPC_CH_ID_AV_AUDIO) uipc_check_fd_locked(ch_id);
+    uipc_main.thread[i] = thread_new(uipc_thread_name[i]);
+    if (uipc_main.thread[i] == NULL) {
+      BTIF_TRACE_ERROR("%s: unable to create thread %s", __func__,
+                       uipc_thread_name[i]);
+      for (int j = 0; j < i; j++) {
+        if (j == 0 || uipc_main.thread[j] != uipc_main.thread[0])
+          thread_free(uipc_main.thread[j]);
+        uipc_main.thread[j] = NULL;
       }
+      return -1;
     }
+    thread_post(uipc_main.thread[i], uipc_raise_priority, NULL);
   }
 
-  BTIF_TRACE_EVENT("UIPC READ THREAD EXITING");
-
-  uipc_main_cleanup();
-
-  uipc_main.tid = 0;
-
-  BTIF_TRACE_EVENT("UIPC READ THREAD DONE");
-
-  return nullptr;
-}
-
-int uipc_start_main_server_thread(void) {
-  uipc_main.running = 1;
-
-  if (pthread_create(&uipc_main.tid, (const pthread_attr_t*)NULL,
-                     uipc_read_task, nullptr) < 0) {
-    BTIF_TRACE_ERROR("uipc_thread_create pthread_create failed:%d", errno);
-    return -1;
-  }
+  for (int i = 0; i < UIPC_CH_NUM; i++)
+    uipc_main.ch[i].thread = uipc_main.thread[uipc_ch_thread[i]];
 
+  uipc_main.running = true;
   return 0;
 }
 
 /* blocking call */
 void uipc_stop_main_server_thread(void) {
-  /* request shutdown of read thread */
+  thread_t* threads[UIPC_THREAD_NUM];
+
   {
-    std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
-    uipc_main.running = 0;
-    uipc_wakeup_locked();
+    std::lock_guard<std::mutex> lock(uipc_main.lock);
+    if (!uipc_main.running) return;
+    uipc_main.running = false;
+    for (int i = 0; i < UIPC_THREAD_NUM; i++) threads[i] = uipc_main.thread[i];
   }
 
-  /* wait until read thread is fully terminated */
-  /* tid might hold pointer value where it's value
-     is negative vaule with singed bit is set, so
-     corrected the logic to check zero or non zero */
-  if (uipc_main.tid) pthread_join(uipc_main.tid, NULL);
+  /* close any open channels, no new close can be scheduled after this */
+  for (int i = 0; i < UIPC_CH_NUM; i++) {
+    tUIPC_CHAN* p = &uipc_main.ch[i];
+    {
+      std::lock_guard<std::recursive_mutex> lock(p->mutex);
+      p->close_pending = true;
+    }
+    thread_post(p->thread, uipc_close_ch, UINT_TO_PTR(i));
+  }
+
+  /* wait until the threads ran the close and are fully terminated */
+  for (int i = 0; i < UIPC_THREAD_NUM; i++) {
+    bool freed = false;
+    for (int j = 0; j < i; j++) freed |= (threads[j] == threads[i]);
+    if (!freed) thread_free(threads[i]);
+  }
+
+  std::lock_guard<std::mutex> lock(uipc_main.lock);
+  for (int i = 0; i < UIPC_THREAD_NUM; i++) uipc_main.thread[i] = NULL;
+  for (int i = 0; i < UIPC_CH_NUM; i++) {
+    std::lock_guard<std::recursive_mutex> ch_lock(uipc_main.ch[i].mutex);
+    uipc_main.ch[i].close_pending = false;
+    uipc_main.ch[i].thread = NULL;
+  }
 }
 
 /*******************************************************************************
@@ -578,7 +553,6 @@ void uipc_stop_main_server_thread(void) {
 void UIPC_Init(UNUSED_ATTR void* p_data) {
   BTIF_TRACE_DEBUG("UIPC_Init");
 
-  uipc_main_init();
   uipc_start_main_server_thread();
 }
 
@@ -595,12 +569,17 @@ bool UIPC_Open(tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK* p_cback,
                const char* socket_path) {
   BTIF_TRACE_DEBUG("UIPC_Open : ch_id %d, p_cback %x", ch_id, p_cback);
 
-  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
-
   if (ch_id >= UIPC_CH_NUM) {
     return false;
   }
 
+  std::lock_guard<std::mutex> main_lock(uipc_main.lock);
+  if (!uipc_main.running) {
+    BTIF_TRACE_ERROR("UIPC_Open : not running");
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.ch[ch_id].mutex);
   if (uipc_main.ch[ch_id].srvfd != UIPC_DISCONNECTED) {
     BTIF_TRACE_EVENT("CHANNEL %d ALREADY OPEN", ch_id);
     return 0;
@@ -625,7 +604,8 @@ void UIPC_Close(tUIPC_CH_ID ch_id) {
 
   /* special case handling uipc shutdown */
   if (ch_id != UIPC_CH_ID_ALL) {
-    std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+    if (ch_id >= UIPC_CH_NUM) return;
+    std::lock_guard<std::recursive_mutex> lock(uipc_main.ch[ch_id].mutex);
     uipc_close_locked(ch_id);
     return;
   }
@@ -647,12 +627,12 @@ bool UIPC_Send(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t msg_evt,
                const uint8_t* p_buf, uint16_t msglen) {
   BTIF_TRACE_DEBUG("UIPC_Send : ch_id:%d %d bytes", ch_id, msglen);
 
-  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
-
   if (ch_id >= UIPC_CH_NUM) {
     BTIF_TRACE_WARNING("UIPC_Send : ch_id: %d out of index ", ch_id);
     return false;
   }
+
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.ch[ch_id].mutex);
   ssize_t ret;
   OSI_NO_INTR(ret = write(uipc_main.ch[ch_id].fd, p_buf, msglen));
   if (ret < 0) {
@@ -662,6 +642,61 @@ bool UIPC_Send(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t msg_evt,
   return false;
 }
 
+/*******************************************************************************
+ **
+ ** Function         UIPC_SendFds
+ **
+ ** Description      Called to transmit a message over UIPC along with file
+ **                  descriptors, which are duplicated into the peer process.
+ **
+ ** Returns          true in case of success, false in case of failure.
+ **
+ ******************************************************************************/
+bool UIPC_SendFds(tUIPC_CH_ID ch_id, const uint8_t* p_buf, uint16_t msglen,
+                  const int* p_fds, uint8_t num_fds) {
+  BTIF_TRACE_DEBUG("UIPC_SendFds : ch_id:%d %d bytes %d fds", ch_id, msglen,
+                   num_fds);
+
+  if (ch_id >= UIPC_CH_NUM || msglen == 0 || num_fds == 0 ||
+      num_fds > UIPC_MAX_SEND_FDS) {
+    BTIF_TRACE_WARNING("UIPC_SendFds : invalid request ch_id %d", ch_id);
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.ch[ch_id].mutex);
+
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t*>(p_buf);
+  iov.iov_len = msglen;
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * UIPC_MAX_SEND_FDS)];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * num_fds);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
+  memcpy(CMSG_DATA(cmsg), p_fds, sizeof(int) * num_fds);
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = sendmsg(uipc_main.ch[ch_id].fd, &msg, MSG_NOSIGNAL));
+  if (ret != msglen) {
+    BTIF_TRACE_ERROR("UIPC_SendFds : failed to send (%s)", strerror(errno));
+    return false;
+  }
+  return true;
+}
+
 /*******************************************************************************
  **
  ** Function         UIPC_Read
@@ -714,7 +749,7 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
 
     if (pfd.revents & (POLLHUP | POLLNVAL)) {
       BTIF_TRACE_WARNING("poll : channel detached remotely");
-      std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+      std::lock_guard<std::recursive_mutex> lock(uipc_main.ch[ch_id].mutex);
       uipc_close_locked(ch_id);
       return 0;
     }
@@ -726,7 +761,7 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
 
     if (n == 0) {
       BTIF_TRACE_WARNING("UIPC_Read : channel detached remotely");
-      std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+      std::lock_guard<std::recursive_mutex> lock(uipc_main.ch[ch_id].mutex);
       uipc_close_locked(ch_id);
       return 0;
     }
@@ -755,34 +790,43 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
 extern bool UIPC_Ioctl(tUIPC_CH_ID ch_id, uint32_t request, void* param) {
   BTIF_TRACE_DEBUG("#### UIPC_Ioctl : ch_id %d, request %d ####", ch_id,
                    request);
-  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+  if (ch_id >= UIPC_CH_NUM) return false;
+
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
 
   switch (request) {
-    case UIPC_REQ_RX_FLUSH:
+    case UIPC_REQ_RX_FLUSH: {
+      std::lock_guard<std::recursive_mutex> lock(p->mutex);
       uipc_flush_locked(ch_id);
       break;
+    }
 
-    case UIPC_REG_CBACK:
+    case UIPC_REG_CBACK: {
       // BTIF_TRACE_EVENT("register callback ch %d srvfd %d, fd %d", ch_id,
-      // uipc_main.ch[ch_id].srvfd, uipc_main.ch[ch_id].fd);
-      uipc_main.ch[ch_id].cback = (tUIPC_RCV_CBACK*)param;
+      // p->srvfd, p->fd);
+      std::lock_guard<std::recursive_mutex> lock(p->mutex);
+      p->cback = (tUIPC_RCV_CBACK*)param;
       break;
+    }
 
-    case UIPC_REG_REMOVE_ACTIVE_READSET:
-      /* user will read data directly and not use select loop */
-      if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED) {
-        /* remove this channel from active set */
-        FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-
-        /* refresh active set */
-        uipc_wakeup_locked();
+    case UIPC_REG_REMOVE_ACTIVE_READSET: {
+      /* user will read data directly and not use the reactor */
+      reactor_object_t* object;
+      {
+        std::lock_guard<std::recursive_mutex> lock(p->mutex);
+        object = p->fd_object;
+        p->fd_object = NULL;
       }
+      /* waits for a running callback unless called from the channel thread,
+         so the mutex must not be held */
+      if (object != NULL) reactor_unregister(object);
       break;
+    }
 
     case UIPC_SET_READ_POLL_TMO:
-      uipc_main.ch[ch_id].read_poll_tmo_ms = (intptr_t)param;
+      p->read_poll_tmo_ms = (intptr_t)param;
       BTIF_TRACE_EVENT("UIPC_SET_READ_POLL_TMO : CH %d, TMO %d ms", ch_id,
-                       uipc_main.ch[ch_id].read_poll_tmo_ms);
+                       p->read_poll_tmo_ms);
       break;
 
     default:
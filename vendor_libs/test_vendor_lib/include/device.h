@@ -125,14 +125,14 @@ class Device {
   // 0x03 Random (static) Identity Address
   // 0x04 – 0xFF Reserved for future use
   // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.8.12
-  uint8_t address_type_;
+  uint8_t address_type_ = kBtAddressTypePublic;
 
   std::chrono::steady_clock::time_point time_stamp_;
 
   // Return the device class.
   // The device class is a 3-byte value.  Look for DEV_CLASS in
   // stack/include/bt_types.h
-  uint32_t device_class_;
+  uint32_t device_class_ = 0;
 
   // Return the page scan repetition mode.
   // Bluetooth Core Specification Version 4.2, Volume 2, Part B, Section 8.3.1
@@ -140,7 +140,7 @@ class Device {
   // 0 - R0 T_page_scan <= 1.28s and T_page_scan == T_window and
   // 1 - R1 T_page_scan <= 1.28s
   // 2 - R2 T_page_scan <= 2.56s
-  uint8_t page_scan_repetition_mode_;
+  uint8_t page_scan_repetition_mode_ = 0;
 
   // The time between page scans.
   std::chrono::milliseconds page_scan_delay_ms_;
@@ -158,7 +158,7 @@ class Device {
 
   // Classic Bluetooth CLKN_slave[16..2] - CLKN_master[16..2]
   // Bluetooth Core Specification Version 4.2, Volume 2, Part C, Section 4.3.2
-  uint16_t clock_offset_;
+  uint16_t clock_offset_ = 0;
 
   // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.8.5
   uint8_t advertising_type_;
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -33,6 +34,7 @@
 #include "event_packet.h"
 #include "sco_packet.h"
 #include "test_channel_transport.h"
+#include "traffic_generator.h"
 
 namespace test_vendor_lib {
 
@@ -475,12 +477,21 @@ class DualModeController {
   // List the devices that the controller knows about
   void TestChannelList(const std::vector<std::string>& args) const;
 
+  // Start synthetic traffic from "key=value" arguments (see
+  // TrafficGenerator::ParseConfig), replacing any running, or "stop" it
+  void TestChannelTraffic(const std::vector<std::string>& args);
+
   void Connections();
 
   void LeScan();
 
   void PageScan();
 
+  // Send the host what the traffic generator has due
+  void GenerateTraffic();
+  // Must be called with traffic_mutex_ held
+  void StopTraffic(bool disconnect);
+
   void HandleTimerTick();
   void SetTimerPeriod(std::chrono::milliseconds new_period);
   void StartTimer();
@@ -588,6 +599,14 @@ class DualModeController {
   std::vector<std::shared_ptr<Connection>> connections_;
 
   AsyncTaskId timer_tick_task_;
+
+  // The generator is ticked on the task thread while test channel commands,
+  // resets and host ACL arrive on the fd watcher thread; holding the mutex
+  // for a whole tick makes StopTraffic wait for one in flight.
+  std::mutex traffic_mutex_;
+  std::unique_ptr<TrafficGenerator> traffic_;
+  std::vector<TrafficGenerator::Emission> traffic_due_;
+  AsyncTaskId traffic_task_ = kInvalidTaskId;
   std::chrono::milliseconds timer_period_ = std::chrono::milliseconds(100);
 
   DualModeController(const DualModeController& cmdPckt) = delete;
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bt_address.h"
+
+namespace test_vendor_lib {
+
+// Synthetic load for the host: advertisers, ACL links and inquiry
+// responders, each emitting at its own rate with uniform jitter.
+struct TrafficConfig {
+  size_t advertisers = 0;
+  double adv_rate_hz = 10;  // Per advertiser
+  size_t adv_size = 31;
+
+  size_t links = 0;
+  double acl_rate_hz = 100;  // Per link
+  size_t acl_size = 27;
+
+  size_t inquiry_responders = 0;
+  double inquiry_rate_hz = 1;  // Per responder
+
+  std::chrono::milliseconds jitter = std::chrono::milliseconds(0);
+  std::chrono::milliseconds tick = std::chrono::milliseconds(10);
+  uint32_t seed = 1;
+};
+
+class TrafficGenerator {
+ public:
+  enum class Source { kAdvertiser, kLink, kInquiryResponder };
+
+  struct Emission {
+    Source source;
+    size_t index;
+    std::chrono::steady_clock::time_point due;
+  };
+
+  struct Stats {
+    uint64_t advertisements = 0;
+    uint64_t acl_packets = 0;
+    uint64_t inquiry_results = 0;
+    // Emissions dropped because they were due too long ago to catch up
+    uint64_t missed = 0;
+    // Longest time between an emission being due and it being polled
+    std::chrono::microseconds max_lateness = std::chrono::microseconds(0);
+  };
+
+  // Smallest sizes that still hold the embedded timestamp.
+  static const size_t kMinAdvSize = 12;
+  static const size_t kMaxAdvSize = 31;
+  static const size_t kMinAclSize = 12;
+
+  // Links use handles from kFirstLinkHandle up.
+  static const uint16_t kFirstLinkHandle = 0x0e00;
+
+  // Parses "key=value" arguments into |config|, starting from its current
+  // values. Keys: advertisers, adv_rate, adv_size, links, acl_rate, acl_size,
+  // inquiry, inquiry_rate, jitter (ms), tick (ms) and seed. Returns false on
+  // an unknown key or out of range value.
+  static bool ParseConfig(const std::vector<std::string>& args,
+                          TrafficConfig* config);
+
+  // Returns the steady clock time of |now| in nanoseconds, as embedded in
+  // generated payloads.
+  static uint64_t TimestampOf(std::chrono::steady_clock::time_point now);
+
+  // Finds the timestamp embedded in advertising data |ad|.
+  static bool ReadAdvertisementTimestamp(const std::vector<uint8_t>& ad,
+                                         uint64_t* timestamp);
+
+  // Reads the timestamp embedded in an ACL payload (from its L2CAP header).
+  static bool ReadAclTimestamp(const uint8_t* payload, size_t length,
+                               uint64_t* timestamp);
+
+  // First emissions of each source are spread over its first period after
+  // |start|.
+  TrafficGenerator(const TrafficConfig& config,
+                   std::chrono::steady_clock::time_point start);
+
+  // Appends to |due| every emission scheduled at or before |now|, in time
+  // order, and schedules each source's next one.
+  void Poll(std::chrono::steady_clock::time_point now,
+            std::vector<Emission>* due);
+
+  const TrafficConfig& GetConfig() const { return config_; }
+  const Stats& GetStats() const { return stats_; }
+
+  BtAddress GetAddress(Source source, size_t index) const;
+
+  uint16_t GetLinkHandle(size_t link) const {
+    return kFirstLinkHandle + link;
+  }
+
+  // Returns true if |handle| is one of the generated links.
+  bool OwnsHandle(uint16_t handle) const {
+    return handle >= kFirstLinkHandle &&
+           handle < kFirstLinkHandle + config_.links;
+  }
+
+  // Advertising data of |adv_size| bytes carrying |now|.
+  std::vector<uint8_t> GetAdvertisement(
+      size_t advertiser, std::chrono::steady_clock::time_point now) const;
+
+  // An L2CAP basic frame of |acl_size| bytes carrying |now| and the link's
+  // sequence number.
+  std::vector<uint8_t> GetAclPayload(size_t link,
+                                     std::chrono::steady_clock::time_point now);
+
+ private:
+  struct Scheduled {
+    std::chrono::steady_clock::time_point due;
+    Source source;
+    size_t index;
+
+    bool operator>(const Scheduled& other) const { return due > other.due; }
+  };
+
+  std::chrono::microseconds PeriodOf(Source source) const;
+  void Schedule(Source source, size_t index,
+                std::chrono::steady_clock::time_point after,
+                std::chrono::microseconds delay);
+
+  TrafficConfig config_;
+  Stats stats_;
+  std::mt19937 rng_;
+  std::priority_queue<Scheduled, std::vector<Scheduled>,
+                      std::greater<Scheduled>>
+      schedule_;
+  std::vector<uint32_t> acl_sequence_;
+};
+
+}  // namespace test_vendor_lib
@@ -203,6 +203,15 @@ class TestChannelShell(cmd.Cmd):
     """
     self._test_channel.send_command('list', args.split())
 
+  def do_traffic(self, args):
+    """
+    Arguments: [key=value ...] | stop
+    Start synthetic traffic, replacing any running, or stop it. Keys:
+    advertisers, adv_rate, adv_size, links, acl_rate, acl_size, inquiry,
+    inquiry_rate, jitter (ms), tick (ms) and seed.
+    """
+    self._test_channel.send_command('traffic', args.split())
+
   def do_quit(self, args):
     """
     Arguments: None.
@@ -452,7 +452,10 @@ class AsyncManager::AsyncTaskManager {
         // wait on condition variable with timeout just in time for next task if
         // any
         if (task_queue_.size() > 0) {
-          internal_cond_var_.wait_until(guard, (*task_queue_.begin())->time);
+          // Copied, as the task may be cancelled and freed while waiting
+          std::chrono::steady_clock::time_point next_time =
+              (*task_queue_.begin())->time;
+          internal_cond_var_.wait_until(guard, next_time);
         } else {
           internal_cond_var_.wait(guard);
         }
@@ -187,6 +187,7 @@ DualModeController::DualModeController()
   SET_TEST_HANDLER("add", TestChannelAdd);
   SET_TEST_HANDLER("del", TestChannelDel);
   SET_TEST_HANDLER("list", TestChannelList);
+  SET_TEST_HANDLER("traffic", TestChannelTraffic);
 #undef SET_TEST_HANDLER
 }
 
@@ -221,6 +222,14 @@ void DualModeController::HandleAcl(std::unique_ptr<AclPacket> acl_packet) {
     send_event_(EventPacket::CreateNumberOfCompletedPacketsEvent(channel, 1));
     return;
   }
+
+  // Generated links sink host data, returning its credits at once
+  std::lock_guard<std::mutex> lock(traffic_mutex_);
+  if (traffic_ && traffic_->OwnsHandle(acl_packet->GetChannel())) {
+    send_event_(EventPacket::CreateNumberOfCompletedPacketsEvent(
+        acl_packet->GetChannel(), 1));
+    return;
+  }
 }
 
 void DualModeController::HandleSco(std::unique_ptr<ScoPacket> sco_packet) {
@@ -424,6 +433,103 @@ void DualModeController::PageScan() {
   }
 }
 
+void DualModeController::GenerateTraffic() {
+  // Inquiry result sent by generated responders: a headset, on R1
+  static const uint32_t kResponderClass = 0x240404;
+  static const uint8_t kResponderPageScanRepetitionMode = 1;
+
+  std::lock_guard<std::mutex> lock(traffic_mutex_);
+  // A tick already taken off the queue when the traffic was stopped
+  if (!traffic_) return;
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  traffic_due_.clear();
+  traffic_->Poll(now, &traffic_due_);
+
+  std::unique_ptr<EventPacket> le_adverts =
+      EventPacket::CreateLeAdvertisingReportEvent();
+  size_t le_advert_count = 0;
+  std::unique_ptr<EventPacket> inquiry_result =
+      EventPacket::CreateInquiryResultEvent();
+  size_t inquiry_result_count = 0;
+
+  for (const TrafficGenerator::Emission& emission : traffic_due_) {
+    const BtAddress addr =
+        traffic_->GetAddress(emission.source, emission.index);
+    switch (emission.source) {
+      case TrafficGenerator::Source::kAdvertiser: {
+        if (!le_scan_enable_) break;
+        vector<uint8_t> ad = traffic_->GetAdvertisement(emission.index, now);
+        if (!le_adverts->AddLeAdvertisingReport(
+                BTM_BLE_NON_CONNECT_EVT, Device::kBtAddressTypePublic, addr,
+                ad, GetRssi(emission.index))) {
+          send_event_(std::move(le_adverts));
+          le_adverts = EventPacket::CreateLeAdvertisingReportEvent();
+          CHECK(le_adverts->AddLeAdvertisingReport(
+              BTM_BLE_NON_CONNECT_EVT, Device::kBtAddressTypePublic, addr, ad,
+              GetRssi(emission.index)));
+        }
+        le_advert_count++;
+      } break;
+
+      case TrafficGenerator::Source::kLink: {
+        vector<uint8_t> payload = traffic_->GetAclPayload(emission.index, now);
+        std::unique_ptr<AclPacket> acl(
+            new AclPacket(traffic_->GetLinkHandle(emission.index),
+                          AclPacket::FirstAutomaticallyFlushable,
+                          AclPacket::PointToPoint));
+        acl->AddPayloadOctets(payload.size(), payload);
+        send_acl_(std::move(acl));
+      } break;
+
+      case TrafficGenerator::Source::kInquiryResponder: {
+        if (state_ != kInquiry) break;
+        if (inquiry_mode_ != 0) {
+          send_event_(EventPacket::CreateExtendedInquiryResultEvent(
+              addr, kResponderPageScanRepetitionMode, kResponderClass, 0,
+              GetRssi(emission.index), {}));
+          break;
+        }
+        if (!inquiry_result->AddInquiryResult(
+                addr, kResponderPageScanRepetitionMode, kResponderClass, 0)) {
+          send_event_(std::move(inquiry_result));
+          inquiry_result = EventPacket::CreateInquiryResultEvent();
+          CHECK(inquiry_result->AddInquiryResult(
+              addr, kResponderPageScanRepetitionMode, kResponderClass, 0));
+        }
+        inquiry_result_count++;
+      } break;
+    }
+  }
+
+  if (le_advert_count > 0) send_event_(std::move(le_adverts));
+  if (inquiry_result_count > 0) send_event_(std::move(inquiry_result));
+}
+
+void DualModeController::StopTraffic(bool disconnect) {
+  if (!traffic_) return;
+
+  cancel_task_(traffic_task_);
+  traffic_task_ = kInvalidTaskId;
+
+  const TrafficGenerator::Stats& stats = traffic_->GetStats();
+  LOG_INFO(LOG_TAG,
+           "Traffic stopped: %llu advertisements, %llu ACL packets, %llu "
+           "inquiry results, %llu missed, max lateness %lld us",
+           (unsigned long long)stats.advertisements,
+           (unsigned long long)stats.acl_packets,
+           (unsigned long long)stats.inquiry_results,
+           (unsigned long long)stats.missed,
+           (long long)stats.max_lateness.count());
+
+  for (size_t link = 0; disconnect && link < traffic_->GetConfig().links;
+       link++) {
+    send_event_(EventPacket::CreateDisconnectionCompleteEvent(
+        kSuccessStatus, traffic_->GetLinkHandle(link), HCI_ERR_PEER_USER));
+  }
+  traffic_.reset();
+}
+
 void DualModeController::StartTimer() {
   LOG_ERROR(LOG_TAG, "StartTimer");
   timer_tick_task_ = schedule_periodic_task_(
@@ -477,10 +583,40 @@ void DualModeController::TestChannelList(
   }
 }
 
+void DualModeController::TestChannelTraffic(const vector<std::string>& args) {
+  LogCommand("TestChannel 'traffic'");
+
+  std::lock_guard<std::mutex> lock(traffic_mutex_);
+  StopTraffic(true);
+  if (!args.empty() && args[0] == "stop") return;
+
+  TrafficConfig config;
+  if (!TrafficGenerator::ParseConfig(args, &config)) {
+    LOG_ERROR(LOG_TAG, "TestChannel 'traffic': invalid arguments");
+    return;
+  }
+
+  traffic_.reset(
+      new TrafficGenerator(config, std::chrono::steady_clock::now()));
+  for (size_t link = 0; link < config.links; link++) {
+    send_event_(EventPacket::CreateConnectionCompleteEvent(
+        kSuccessStatus, traffic_->GetLinkHandle(link),
+        traffic_->GetAddress(TrafficGenerator::Source::kLink, link),
+        HCI_LINK_TYPE_ACL, false));
+  }
+  traffic_task_ = schedule_periodic_task_(config.tick, config.tick,
+                                          [this]() { GenerateTraffic(); });
+}
+
 void DualModeController::HciReset(const vector<uint8_t>& args) {
   LogCommand("Reset");
   CHECK(args[0] == 0);  // No arguments
   state_ = kStandby;
+  // The generated links do not survive a reset
+  {
+    std::lock_guard<std::mutex> lock(traffic_mutex_);
+    StopTraffic(false);
+  }
   if (timer_tick_task_ != kInvalidTaskId) {
     LOG_INFO(LOG_TAG, "The timer was already running!");
     StopTimer();
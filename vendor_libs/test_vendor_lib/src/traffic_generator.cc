@@ -0,0 +1,240 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#define LOG_TAG "traffic_generator"
+
+#include "traffic_generator.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using std::vector;
+
+namespace {
+
+// Emissions due longer ago than this are dropped rather than sent in a burst
+const std::chrono::microseconds kMaxCatchUp = std::chrono::seconds(1);
+
+// Manufacturer specific data, with the company ID reserved for testing
+const uint8_t kManufacturerDataType = 0xff;
+const uint16_t kTestCompanyId = 0xffff;
+
+// First dynamically allocated L2CAP channel
+const uint16_t kAclCid = 0x0040;
+
+const size_t kMaxSources = 65536;
+const size_t kMaxLinks = 256;
+const size_t kMaxAclSize = 1024;
+const double kMaxRateHz = 100000;
+
+bool ParseSize(const std::string& value, size_t min, size_t max,
+               size_t* result) {
+  char* end = nullptr;
+  unsigned long parsed = strtoul(value.c_str(), &end, 0);
+  if (value.empty() || *end != '\0' || parsed < min || parsed > max)
+    return false;
+  *result = parsed;
+  return true;
+}
+
+bool ParseRate(const std::string& value, double* result) {
+  char* end = nullptr;
+  double parsed = strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0' || !(parsed > 0) || parsed > kMaxRateHz)
+    return false;
+  *result = parsed;
+  return true;
+}
+
+void AppendLittleEndian(vector<uint8_t>& data, uint64_t value, size_t octets) {
+  for (size_t i = 0; i < octets; i++) data.push_back(value >> (8 * i));
+}
+
+uint64_t ReadLittleEndian(const uint8_t* data, size_t octets) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < octets; i++) value |= (uint64_t)data[i] << (8 * i);
+  return value;
+}
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+bool TrafficGenerator::ParseConfig(const vector<std::string>& args,
+                                   TrafficConfig* config) {
+  for (const std::string& arg : args) {
+    size_t equals = arg.find('=');
+    if (equals == std::string::npos) return false;
+    std::string key = arg.substr(0, equals);
+    std::string value = arg.substr(equals + 1);
+    size_t number = 0;
+
+    bool valid = false;
+    if (key == "advertisers") {
+      valid = ParseSize(value, 0, kMaxSources, &config->advertisers);
+    } else if (key == "adv_rate") {
+      valid = ParseRate(value, &config->adv_rate_hz);
+    } else if (key == "adv_size") {
+      valid = ParseSize(value, kMinAdvSize, kMaxAdvSize, &config->adv_size);
+    } else if (key == "links") {
+      valid = ParseSize(value, 0, kMaxLinks, &config->links);
+    } else if (key == "acl_rate") {
+      valid = ParseRate(value, &config->acl_rate_hz);
+    } else if (key == "acl_size") {
+      valid = ParseSize(value, kMinAclSize, kMaxAclSize, &config->acl_size);
+    } else if (key == "inquiry") {
+      valid = ParseSize(value, 0, kMaxSources, &config->inquiry_responders);
+    } else if (key == "inquiry_rate") {
+      valid = ParseRate(value, &config->inquiry_rate_hz);
+    } else if (key == "jitter") {
+      valid = ParseSize(value, 0, 60000, &number);
+      config->jitter = std::chrono::milliseconds(number);
+    } else if (key == "tick") {
+      valid = ParseSize(value, 1, 1000, &number);
+      config->tick = std::chrono::milliseconds(number);
+    } else if (key == "seed") {
+      valid = ParseSize(value, 0, UINT32_MAX, &number);
+      config->seed = number;
+    }
+    if (!valid) return false;
+  }
+  return true;
+}
+
+uint64_t TrafficGenerator::TimestampOf(
+    std::chrono::steady_clock::time_point now) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             now.time_since_epoch())
+      .count();
+}
+
+bool TrafficGenerator::ReadAdvertisementTimestamp(const vector<uint8_t>& ad,
+                                                  uint64_t* timestamp) {
+  size_t offset = 0;
+  while (offset < ad.size() && ad[offset] != 0) {
+    size_t length = ad[offset];
+    if (offset + 1 + length > ad.size()) return false;
+    const uint8_t* field = &ad[offset + 1];
+    if (field[0] == kManufacturerDataType && length >= 11 &&
+        ReadLittleEndian(field + 1, 2) == kTestCompanyId) {
+      *timestamp = ReadLittleEndian(field + 3, 8);
+      return true;
+    }
+    offset += 1 + length;
+  }
+  return false;
+}
+
+bool TrafficGenerator::ReadAclTimestamp(const uint8_t* payload, size_t length,
+                                        uint64_t* timestamp) {
+  if (length < kMinAclSize || ReadLittleEndian(payload + 2, 2) != kAclCid)
+    return false;
+  *timestamp = ReadLittleEndian(payload + 4, 8);
+  return true;
+}
+
+TrafficGenerator::TrafficGenerator(const TrafficConfig& config,
+                                   std::chrono::steady_clock::time_point start)
+    : config_(config), rng_(config.seed), acl_sequence_(config.links) {
+  auto spread = [this, start](Source source, size_t count) {
+    std::uniform_int_distribution<int64_t> phase(0,
+                                                 PeriodOf(source).count() - 1);
+    for (size_t i = 0; i < count; i++)
+      Schedule(source, i, start, std::chrono::microseconds(phase(rng_)));
+  };
+  spread(Source::kAdvertiser, config_.advertisers);
+  spread(Source::kLink, config_.links);
+  spread(Source::kInquiryResponder, config_.inquiry_responders);
+}
+
+std::chrono::microseconds TrafficGenerator::PeriodOf(Source source) const {
+  double rate_hz = config_.adv_rate_hz;
+  if (source == Source::kLink) rate_hz = config_.acl_rate_hz;
+  if (source == Source::kInquiryResponder) rate_hz = config_.inquiry_rate_hz;
+  int64_t period_us = llround(1e6 / rate_hz);
+  return std::chrono::microseconds(period_us > 0 ? period_us : 1);
+}
+
+void TrafficGenerator::Schedule(Source source, size_t index,
+                                std::chrono::steady_clock::time_point after,
+                                std::chrono::microseconds delay) {
+  schedule_.push({after + delay, source, index});
+}
+
+void TrafficGenerator::Poll(std::chrono::steady_clock::time_point now,
+                            vector<Emission>* due) {
+  int64_t jitter_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(config_.jitter)
+          .count();
+  std::uniform_int_distribution<int64_t> jitter(-jitter_us, jitter_us);
+
+  while (!schedule_.empty() && schedule_.top().due <= now) {
+    Scheduled next = schedule_.top();
+    schedule_.pop();
+
+    std::chrono::microseconds period = PeriodOf(next.source);
+    auto lateness =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - next.due);
+    if (lateness > kMaxCatchUp) {
+      // Skip what the host could never have seen, and restart from now
+      stats_.missed += lateness / period + 1;
+      next.due = now;
+    } else {
+      due->push_back({next.source, next.index, next.due});
+      if (next.source == Source::kAdvertiser) stats_.advertisements++;
+      if (next.source == Source::kLink) stats_.acl_packets++;
+      if (next.source == Source::kInquiryResponder) stats_.inquiry_results++;
+      if (lateness > stats_.max_lateness) stats_.max_lateness = lateness;
+    }
+
+    std::chrono::microseconds delay =
+        period + std::chrono::microseconds(jitter_us ? jitter(rng_) : 0);
+    if (delay < std::chrono::microseconds(1))
+      delay = std::chrono::microseconds(1);
+    Schedule(next.source, next.index, next.due, delay);
+  }
+}
+
+BtAddress TrafficGenerator::GetAddress(Source source, size_t index) const {
+  uint8_t tag = 0xa0;
+  if (source == Source::kLink) tag = 0xc0;
+  if (source == Source::kInquiryResponder) tag = 0x1c;
+
+  // 7e:57:<tag>:00:<index>
+  BtAddress address;
+  address.FromVector({static_cast<uint8_t>(index & 0xff),
+                      static_cast<uint8_t>(index >> 8), 0x00, tag, 0x57,
+                      0x7e});
+  return address;
+}
+
+vector<uint8_t> TrafficGenerator::GetAdvertisement(
+    size_t advertiser, std::chrono::steady_clock::time_point now) const {
+  vector<uint8_t> ad;
+  ad.reserve(config_.adv_size);
+  ad.push_back(config_.adv_size - 1);  // Length
+  ad.push_back(kManufacturerDataType);
+  AppendLittleEndian(ad, kTestCompanyId, 2);
+  AppendLittleEndian(ad, TimestampOf(now), 8);
+  while (ad.size() < config_.adv_size) ad.push_back(advertiser + ad.size());
+  return ad;
+}
+
+vector<uint8_t> TrafficGenerator::GetAclPayload(
+    size_t link, std::chrono::steady_clock::time_point now) {
+  vector<uint8_t> payload;
+  payload.reserve(config_.acl_size);
+  AppendLittleEndian(payload, config_.acl_size - 4, 2);  // L2CAP length
+  AppendLittleEndian(payload, kAclCid, 2);
+  AppendLittleEndian(payload, TimestampOf(now), 8);
+  uint32_t sequence = acl_sequence_[link]++;
+  for (size_t i = 0; i < 4 && payload.size() < config_.acl_size; i++)
+    payload.push_back(sequence >> (8 * i));
+  while (payload.size() < config_.acl_size) payload.push_back(payload.size());
+  return payload;
+}
+
+}  // namespace test_vendor_lib
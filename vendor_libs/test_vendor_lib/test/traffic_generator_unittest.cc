@@ -0,0 +1,233 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "traffic_generator.h"
+
+using std::vector;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using test_vendor_lib::TrafficConfig;
+using test_vendor_lib::TrafficGenerator;
+using Source = TrafficGenerator::Source;
+
+// Polls |generator| every |step| for |duration| of simulated time
+vector<TrafficGenerator::Emission> PollFor(TrafficGenerator& generator,
+                                           Clock::time_point start,
+                                           std::chrono::milliseconds duration,
+                                           std::chrono::milliseconds step) {
+  vector<TrafficGenerator::Emission> emissions;
+  for (auto now = start; now <= start + duration; now += step) {
+    size_t first = emissions.size();
+    generator.Poll(now, &emissions);
+    for (size_t i = first; i < emissions.size(); i++) {
+      EXPECT_LE(emissions[i].due, now);
+      if (i > 0) {
+        EXPECT_LE(emissions[i - 1].due, emissions[i].due);
+      }
+    }
+  }
+  return emissions;
+}
+
+}  // namespace
+
+TEST(TrafficGeneratorTest, ParseConfig) {
+  TrafficConfig config;
+  EXPECT_TRUE(TrafficGenerator::ParseConfig(
+      {"advertisers=200", "adv_rate=2.5", "adv_size=20", "links=4",
+       "acl_rate=800", "acl_size=251", "inquiry=30", "inquiry_rate=0.5",
+       "jitter=15", "tick=5", "seed=7"},
+      &config));
+  EXPECT_EQ(200u, config.advertisers);
+  EXPECT_DOUBLE_EQ(2.5, config.adv_rate_hz);
+  EXPECT_EQ(20u, config.adv_size);
+  EXPECT_EQ(4u, config.links);
+  EXPECT_DOUBLE_EQ(800, config.acl_rate_hz);
+  EXPECT_EQ(251u, config.acl_size);
+  EXPECT_EQ(30u, config.inquiry_responders);
+  EXPECT_DOUBLE_EQ(0.5, config.inquiry_rate_hz);
+  EXPECT_EQ(std::chrono::milliseconds(15), config.jitter);
+  EXPECT_EQ(std::chrono::milliseconds(5), config.tick);
+  EXPECT_EQ(7u, config.seed);
+
+  for (const char* bad :
+       {"advertisers", "colour=red", "links=-1", "links=257", "adv_size=11",
+        "adv_size=32", "acl_size=8", "adv_rate=0", "acl_rate=fast",
+        "tick=0", "jitter=1s"}) {
+    TrafficConfig unchanged;
+    EXPECT_FALSE(TrafficGenerator::ParseConfig({bad}, &unchanged)) << bad;
+  }
+}
+
+TEST(TrafficGeneratorTest, EmitsAtConfiguredRates) {
+  TrafficConfig config;
+  config.advertisers = 10;
+  config.adv_rate_hz = 20;
+  config.links = 2;
+  config.acl_rate_hz = 500;
+  config.inquiry_responders = 3;
+  config.inquiry_rate_hz = 2;
+  Clock::time_point start = Clock::now();
+  TrafficGenerator generator(config, start);
+
+  auto emissions = PollFor(generator, start, std::chrono::seconds(10),
+                           std::chrono::milliseconds(10));
+  std::map<Source, std::map<size_t, size_t>> counts;
+  for (const auto& emission : emissions)
+    counts[emission.source][emission.index]++;
+
+  // Each source emits once per period, give or take the first period
+  ASSERT_EQ(10u, counts[Source::kAdvertiser].size());
+  for (const auto& it : counts[Source::kAdvertiser])
+    EXPECT_NEAR(200, it.second, 1) << "advertiser " << it.first;
+  ASSERT_EQ(2u, counts[Source::kLink].size());
+  for (const auto& it : counts[Source::kLink])
+    EXPECT_NEAR(5000, it.second, 1) << "link " << it.first;
+  ASSERT_EQ(3u, counts[Source::kInquiryResponder].size());
+  for (const auto& it : counts[Source::kInquiryResponder])
+    EXPECT_NEAR(20, it.second, 1) << "responder " << it.first;
+
+  const TrafficGenerator::Stats& stats = generator.GetStats();
+  EXPECT_EQ(emissions.size(), stats.advertisements + stats.acl_packets +
+                                  stats.inquiry_results);
+  EXPECT_EQ(0u, stats.missed);
+  EXPECT_LT(stats.max_lateness, std::chrono::milliseconds(10));
+}
+
+TEST(TrafficGeneratorTest, JitterStaysWithinBounds) {
+  TrafficConfig config;
+  config.advertisers = 5;
+  config.adv_rate_hz = 10;
+  config.jitter = std::chrono::milliseconds(20);
+  Clock::time_point start = Clock::now();
+  TrafficGenerator generator(config, start);
+
+  auto emissions = PollFor(generator, start, std::chrono::seconds(60),
+                           std::chrono::milliseconds(1));
+  std::map<size_t, Clock::time_point> last;
+  std::set<int64_t> intervals;
+  double total_ms = 0;
+  size_t count = 0;
+  for (const auto& emission : emissions) {
+    auto it = last.find(emission.index);
+    if (it != last.end()) {
+      int64_t interval_us = std::chrono::duration_cast<
+                                std::chrono::microseconds>(emission.due -
+                                                           it->second)
+                                .count();
+      EXPECT_GE(interval_us, 80000);
+      EXPECT_LE(interval_us, 120000);
+      intervals.insert(interval_us);
+      total_ms += interval_us / 1000.0;
+      count++;
+    }
+    last[emission.index] = emission.due;
+  }
+  ASSERT_GT(count, 2900u);
+  EXPECT_NEAR(100, total_ms / count, 1);
+  EXPECT_GT(intervals.size(), 100u);
+}
+
+TEST(TrafficGeneratorTest, SameSeedSameSchedule) {
+  TrafficConfig config;
+  config.advertisers = 20;
+  config.links = 3;
+  config.jitter = std::chrono::milliseconds(7);
+  Clock::time_point start = Clock::now();
+
+  auto schedule = [&config, start](uint32_t seed) {
+    config.seed = seed;
+    TrafficGenerator generator(config, start);
+    vector<std::pair<size_t, int64_t>> schedule;
+    for (const auto& emission :
+         PollFor(generator, start, std::chrono::seconds(2),
+                 std::chrono::milliseconds(10))) {
+      schedule.emplace_back(emission.index, (emission.due - start).count());
+    }
+    return schedule;
+  };
+  EXPECT_EQ(schedule(1), schedule(1));
+  EXPECT_NE(schedule(1), schedule(2));
+}
+
+TEST(TrafficGeneratorTest, DropsWhatIsDueLongAgo) {
+  TrafficConfig config;
+  config.advertisers = 1;
+  config.adv_rate_hz = 10;
+  Clock::time_point start = Clock::now();
+  TrafficGenerator generator(config, start);
+
+  vector<TrafficGenerator::Emission> emissions;
+  generator.Poll(start + std::chrono::seconds(5), &emissions);
+  EXPECT_GE(generator.GetStats().missed, 30u);
+  EXPECT_LE(emissions.size(), 11u);
+
+  // Back on schedule afterwards
+  emissions.clear();
+  generator.Poll(start + std::chrono::seconds(6), &emissions);
+  EXPECT_NEAR(10, emissions.size(), 1);
+}
+
+TEST(TrafficGeneratorTest, PayloadsCarryTimestamps) {
+  TrafficConfig config;
+  config.advertisers = 300;
+  config.adv_size = 25;
+  config.links = 4;
+  config.acl_size = 100;
+  Clock::time_point now = Clock::now();
+  TrafficGenerator generator(config, now);
+
+  vector<uint8_t> ad = generator.GetAdvertisement(3, now);
+  ASSERT_EQ(25u, ad.size());
+  EXPECT_EQ(24, ad[0]);
+  uint64_t timestamp = 0;
+  ASSERT_TRUE(TrafficGenerator::ReadAdvertisementTimestamp(ad, &timestamp));
+  EXPECT_EQ(TrafficGenerator::TimestampOf(now), timestamp);
+
+  // Found after other AD structures too, and not in foreign data
+  vector<uint8_t> flagged = {0x02, 0x01, 0x06};
+  flagged.insert(flagged.end(), ad.begin(), ad.end());
+  EXPECT_TRUE(TrafficGenerator::ReadAdvertisementTimestamp(flagged,
+                                                           &timestamp));
+  EXPECT_FALSE(TrafficGenerator::ReadAdvertisementTimestamp(
+      {0x02, 0x01, 0x06, 0x03, 0xff, 0x4c, 0x00}, &timestamp));
+  EXPECT_FALSE(TrafficGenerator::ReadAdvertisementTimestamp(
+      {0x1e, 0xff, 0xff, 0xff}, &timestamp));
+
+  for (uint32_t sequence = 0; sequence < 3; sequence++) {
+    vector<uint8_t> payload = generator.GetAclPayload(1, now);
+    ASSERT_EQ(100u, payload.size());
+    EXPECT_EQ(96, payload[0] | (payload[1] << 8));  // L2CAP length
+    ASSERT_TRUE(TrafficGenerator::ReadAclTimestamp(payload.data(),
+                                                   payload.size(), &timestamp));
+    EXPECT_EQ(TrafficGenerator::TimestampOf(now), timestamp);
+    EXPECT_EQ(sequence, payload[12] | (payload[13] << 8));
+  }
+  EXPECT_EQ(0, generator.GetAclPayload(2, now)[12]);
+
+  std::set<std::string> addresses;
+  for (size_t i = 0; i < config.advertisers; i++)
+    addresses.insert(generator.GetAddress(Source::kAdvertiser, i).ToString());
+  for (size_t i = 0; i < config.links; i++)
+    addresses.insert(generator.GetAddress(Source::kLink, i).ToString());
+  EXPECT_EQ(config.advertisers + config.links, addresses.size());
+  EXPECT_EQ("7e:57:a0:00:01:02",
+            generator.GetAddress(Source::kAdvertiser, 0x102).ToString());
+
+  EXPECT_TRUE(generator.OwnsHandle(TrafficGenerator::kFirstLinkHandle));
+  EXPECT_TRUE(generator.OwnsHandle(TrafficGenerator::kFirstLinkHandle + 3));
+  EXPECT_FALSE(generator.OwnsHandle(TrafficGenerator::kFirstLinkHandle + 4));
+  EXPECT_FALSE(generator.OwnsHandle(0x0001));
+}
@@ -0,0 +1,320 @@
+/******************************************************************************
+ * Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ *
+ *******************************************************************************/
+
+// Headless load run against the controller. The harness plays the host over
+// the controller's HCI channels, as the rootcanal HAL does for the stack: it
+// resets the controller, enables scanning (and inquiry), starts synthetic
+// traffic, and reports what reached the host, the depth of its receive queue
+// and the latency from generation to processing.
+//
+//   test-vendor_traffic_harness_qti [duration=<s>] [host_cost=<us>]
+//       [restart=<ms>]
+//       <traffic arguments, e.g. advertisers=200 links=4 acl_rate=500>
+//
+// host_cost is busy time spent per packet, standing in for the stack's own
+// processing. Commands, test channel commands and host ACL are issued from
+// the main thread, which plays the fd watcher while the generator ticks on
+// the AsyncManager thread; restart stops and restarts the traffic at that
+// period to exercise stopping it under load. On a device the same load is started against the real stack
+// with the test channel's "traffic" command.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_manager.h"
+#include "dual_mode_controller.h"
+#include "stack/include/hcidefs.h"
+#include "traffic_generator.h"
+
+using test_vendor_lib::AclPacket;
+using test_vendor_lib::AsyncManager;
+using test_vendor_lib::AsyncTaskId;
+using test_vendor_lib::CommandPacket;
+using test_vendor_lib::DualModeController;
+using test_vendor_lib::EventPacket;
+using test_vendor_lib::ScoPacket;
+using test_vendor_lib::TaskCallback;
+using test_vendor_lib::TrafficGenerator;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct HostPacket {
+  bool is_acl;
+  std::vector<uint8_t> bytes;
+};
+
+// Packets from the controller, waiting for the host thread
+class HostQueue {
+ public:
+  void Push(HostPacket packet) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    packets_.push_back(std::move(packet));
+    depth_sum_ += packets_.size();
+    pushes_++;
+    max_depth_ = std::max(max_depth_, packets_.size());
+    ready_.notify_one();
+  }
+
+  // Returns false once closed and drained
+  bool Pop(HostPacket* packet) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this]() { return closed_ || !packets_.empty(); });
+    if (packets_.empty()) return false;
+    *packet = std::move(packets_.front());
+    packets_.pop_front();
+    return true;
+  }
+
+  void Close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    ready_.notify_all();
+  }
+
+  // Mean depth seen by arriving packets
+  double MeanDepth() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return pushes_ ? (double)depth_sum_ / pushes_ : 0;
+  }
+
+  size_t MaxDepth() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return max_depth_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<HostPacket> packets_;
+  bool closed_ = false;
+  uint64_t depth_sum_ = 0;
+  uint64_t pushes_ = 0;
+  size_t max_depth_ = 0;
+};
+
+struct HostCounters {
+  // Last generated link seen, for the host's own ACL
+  std::atomic<uint16_t> acl_handle{0};
+  uint64_t events = 0;
+  uint64_t acl_packets = 0;
+  uint64_t acl_bytes = 0;
+  uint64_t advertisements = 0;
+  uint64_t inquiry_results = 0;
+  std::vector<uint64_t> adv_latency_us;
+  std::vector<uint64_t> acl_latency_us;
+};
+
+void RecordLatency(uint64_t timestamp, std::vector<uint64_t>* latencies) {
+  uint64_t now = TrafficGenerator::TimestampOf(Clock::now());
+  latencies->push_back(now > timestamp ? (now - timestamp) / 1000 : 0);
+}
+
+void HandleEvent(const std::vector<uint8_t>& event, HostCounters* counters) {
+  counters->events++;
+  if (event.size() < 3) return;
+  const uint8_t* params = &event[2];
+  size_t length = event.size() - 2;
+
+  if (event[0] == HCI_INQUIRY_RESULT_EVT) {
+    counters->inquiry_results += params[0];
+  } else if (event[0] == HCI_EXTENDED_INQUIRY_RESULT_EVT) {
+    counters->inquiry_results++;
+  } else if (event[0] == HCI_BLE_EVENT &&
+             params[0] == HCI_BLE_ADV_PKT_RPT_EVT && length >= 2) {
+    // Reports in order: type, address type, address, data length, data, RSSI
+    size_t offset = 2;
+    for (uint8_t i = 0; i < params[1] && offset + 9 <= length; i++) {
+      size_t data_length = params[offset + 8];
+      if (offset + 9 + data_length + 1 > length) break;
+      std::vector<uint8_t> ad(params + offset + 9,
+                              params + offset + 9 + data_length);
+      counters->advertisements++;
+      uint64_t timestamp;
+      if (TrafficGenerator::ReadAdvertisementTimestamp(ad, &timestamp))
+        RecordLatency(timestamp, &counters->adv_latency_us);
+      offset += 9 + data_length + 1;
+    }
+  }
+}
+
+void HandleAcl(const std::vector<uint8_t>& acl, HostCounters* counters) {
+  counters->acl_packets++;
+  if (acl.size() < 4) return;
+  counters->acl_handle = (acl[0] | (acl[1] << 8)) & 0xfff;
+  counters->acl_bytes += acl.size() - 4;
+  uint64_t timestamp;
+  if (TrafficGenerator::ReadAclTimestamp(&acl[4], acl.size() - 4, &timestamp))
+    RecordLatency(timestamp, &counters->acl_latency_us);
+}
+
+void PrintLatency(const char* name, std::vector<uint64_t>* latencies) {
+  if (latencies->empty()) return;
+  std::sort(latencies->begin(), latencies->end());
+  auto percentile = [latencies](double p) {
+    return (*latencies)[(size_t)(p * (latencies->size() - 1))];
+  };
+  printf("%s latency (us): p50 %llu, p90 %llu, p99 %llu, max %llu\n", name,
+         (unsigned long long)percentile(0.5),
+         (unsigned long long)percentile(0.9),
+         (unsigned long long)percentile(0.99),
+         (unsigned long long)latencies->back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double duration_s = 10;
+  int64_t host_cost_us = 0;
+  int64_t restart_ms = 0;
+  std::vector<std::string> traffic_args;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 9, "duration=") == 0) {
+      duration_s = atof(arg.c_str() + 9);
+    } else if (arg.compare(0, 10, "host_cost=") == 0) {
+      host_cost_us = atoll(arg.c_str() + 10);
+    } else if (arg.compare(0, 8, "restart=") == 0) {
+      restart_ms = atoll(arg.c_str() + 8);
+    } else {
+      traffic_args.push_back(arg);
+    }
+  }
+
+  test_vendor_lib::TrafficConfig config;
+  if (duration_s <= 0 ||
+      !TrafficGenerator::ParseConfig(traffic_args, &config)) {
+    fprintf(stderr,
+            "usage: %s [duration=<s>] [host_cost=<us>] [restart=<ms>] "
+            "[advertisers=N] "
+            "[adv_rate=Hz] [adv_size=N] [links=N] [acl_rate=Hz] "
+            "[acl_size=N] [inquiry=N] [inquiry_rate=Hz] [jitter=ms] "
+            "[tick=ms] [seed=N]\n",
+            argv[0]);
+    return 1;
+  }
+
+  HostQueue queue;
+  DualModeController controller;
+  AsyncManager async_manager;
+
+  controller.RegisterEventChannel([&queue](std::unique_ptr<EventPacket> event) {
+    HostPacket packet = {false, event->GetHeader()};
+    packet.bytes.insert(packet.bytes.end(), event->GetPayload().begin(),
+                        event->GetPayload().end());
+    queue.Push(std::move(packet));
+  });
+  controller.RegisterAclChannel([&queue](std::unique_ptr<AclPacket> acl) {
+    queue.Push({true, acl->GetPacket()});
+  });
+  controller.RegisterScoChannel([](std::unique_ptr<ScoPacket>) {});
+  controller.RegisterTaskScheduler(
+      [&async_manager](std::chrono::milliseconds delay,
+                       const TaskCallback& task) {
+        return async_manager.ExecAsync(delay, task);
+      });
+  controller.RegisterPeriodicTaskScheduler(
+      [&async_manager](std::chrono::milliseconds delay,
+                       std::chrono::milliseconds period,
+                       const TaskCallback& task) {
+        return async_manager.ExecAsyncPeriodically(delay, period, task);
+      });
+  controller.RegisterTaskCancel([&async_manager](AsyncTaskId task) {
+    async_manager.CancelAsyncTask(task);
+  });
+
+  HostCounters counters;
+  std::thread host([&queue, &counters, host_cost_us]() {
+    HostPacket packet;
+    while (queue.Pop(&packet)) {
+      Clock::time_point busy_until =
+          Clock::now() + std::chrono::microseconds(host_cost_us);
+      if (packet.is_acl) {
+        HandleAcl(packet.bytes, &counters);
+      } else {
+        HandleEvent(packet.bytes, &counters);
+      }
+      while (Clock::now() < busy_until) {
+      }
+    }
+  });
+
+  auto send_command = [&controller](uint16_t opcode,
+                                    std::vector<uint8_t> params) {
+    std::unique_ptr<CommandPacket> command(new CommandPacket(opcode));
+    for (uint8_t param : params) command->AddPayloadOctets1(param);
+    controller.HandleCommand(std::move(command));
+  };
+  send_command(HCI_RESET, {});
+  // Passive scan, 10 ms interval and window
+  send_command(HCI_BLE_WRITE_SCAN_PARAMS, {0, 0x10, 0, 0x10, 0, 0, 0});
+  send_command(HCI_BLE_WRITE_SCAN_ENABLE, {1, 0});
+  if (config.inquiry_responders > 0) {
+    send_command(HCI_WRITE_INQUIRY_MODE, {0});
+    // General inquiry for the longest length, 61.44 s
+    send_command(HCI_INQUIRY, {0x33, 0x8b, 0x9e, 0x30, 0});
+  }
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point end =
+      start + std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(duration_s));
+  Clock::time_point next_restart = start + std::chrono::milliseconds(restart_ms);
+  uint64_t host_acl_packets = 0;
+  uint64_t restarts = 0;
+  controller.HandleTestChannelCommand("traffic", traffic_args);
+  while (Clock::now() < end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    uint16_t handle = counters.acl_handle;
+    if (handle != 0) {
+      std::unique_ptr<AclPacket> acl(
+          new AclPacket(handle, AclPacket::FirstAutomaticallyFlushable,
+                        AclPacket::PointToPoint));
+      acl->AddPayloadOctets4(0);
+      controller.HandleAcl(std::move(acl));
+      host_acl_packets++;
+    }
+    if (restart_ms > 0 && Clock::now() >= next_restart) {
+      controller.HandleTestChannelCommand("traffic", {"stop"});
+      controller.HandleTestChannelCommand("traffic", traffic_args);
+      next_restart += std::chrono::milliseconds(restart_ms);
+      restarts++;
+    }
+  }
+  double elapsed_s =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  controller.HandleTestChannelCommand("traffic", {"stop"});
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  queue.Close();
+  host.join();
+
+  printf("%.1f s, host cost %lld us/packet\n", elapsed_s,
+         (long long)host_cost_us);
+  printf("events: %.0f/s, advertising reports %.0f/s, inquiry results %.0f/s\n",
+         counters.events / elapsed_s, counters.advertisements / elapsed_s,
+         counters.inquiry_results / elapsed_s);
+  printf("ACL: %.0f packets/s, %.0f bytes/s\n",
+         counters.acl_packets / elapsed_s, counters.acl_bytes / elapsed_s);
+  printf("host ACL: %llu packets, %llu traffic restarts\n",
+         (unsigned long long)host_acl_packets, (unsigned long long)restarts);
+  printf("host queue depth: mean %.1f, max %zu\n", queue.MeanDepth(),
+         queue.MaxDepth());
+  PrintLatency("advertising", &counters.adv_latency_us);
+  PrintLatency("ACL", &counters.acl_latency_us);
+  return 0;
+}